@@ -8,7 +8,9 @@ load("@com_google_googleapis//:repository_rules.bzl", "switched_rules_by_languag
 PPC_SKIP_TARGETS = ["envoy.filters.http.lua"]
 
 WINDOWS_SKIP_TARGETS = [
+    "envoy.cache.file_system_http_cache",
     "envoy.filters.http.sxg",
+    "envoy.io_socket.io_uring",
     "envoy.tracers.dynamic_ot",
     "envoy.tracers.lightstep",
     "envoy.tracers.datadog",
@@ -181,6 +183,7 @@ def envoy_dependencies(skip_targets = []):
     _com_github_datadog_dd_opentracing_cpp()
     _com_github_mirror_tclap()
     _com_github_envoyproxy_sqlparser()
+    _com_github_facebook_zstd()
     _com_github_fmtlib_fmt()
     _com_github_gabime_spdlog()
     _com_github_google_benchmark()
@@ -300,6 +303,16 @@ def _com_github_c_ares_c_ares():
         actual = "@envoy//bazel/foreign_cc:ares",
     )
 
+def _com_github_facebook_zstd():
+    external_http_archive(
+        name = "com_github_facebook_zstd",
+        build_file = "@envoy//bazel/external:zstd.BUILD",
+    )
+    native.bind(
+        name = "zstd",
+        actual = "@com_github_facebook_zstd//:zstd",
+    )
+
 def _com_github_cyan4973_xxhash():
     external_http_archive(
         name = "com_github_cyan4973_xxhash",
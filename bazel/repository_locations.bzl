@@ -451,6 +451,22 @@ REPOSITORY_LOCATIONS_SPEC = dict(
         release_date = "2020-09-08",
         cpe = "cpe:2.3:a:google:brotli:*",
     ),
+    com_github_facebook_zstd = dict(
+        project_name = "zstd",
+        project_desc = "zstd compression library",
+        project_url = "https://facebook.github.io/zstd",
+        version = "1.5.0",
+        sha256 = "0d9ade222c64e912d6957b11c923e214e2e010a18f39bec102f572e693ba2867",
+        strip_prefix = "zstd-{version}",
+        urls = ["https://github.com/facebook/zstd/archive/v{version}.tar.gz"],
+        use_category = ["dataplane_ext"],
+        extensions = [
+            "envoy.compression.zstd.compressor",
+            "envoy.compression.zstd.decompressor",
+        ],
+        release_date = "2021-05-14",
+        cpe = "cpe:2.3:a:facebook:zstandard:*",
+    ),
     com_github_zlib_ng_zlib_ng = dict(
         project_name = "zlib-ng",
         project_desc = "zlib fork (higher performance)",
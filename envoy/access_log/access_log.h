@@ -51,6 +51,18 @@ public:
    */
   virtual AccessLogFileSharedPtr
   createAccessLog(const Envoy::Filesystem::FilePathAndType& file_info) PURE;
+
+  /**
+   * Create a new access log file managed by the access log manager, which is rotated once it
+   * reaches max_size_bytes: the file is renamed to <path>.1, replacing the previously rotated file,
+   * and a new file is opened. If the file was already created, the existing file is returned.
+   * @param file_info specifies the file to create/open.
+   * @param max_size_bytes the size to rotate the file at, or 0 to never rotate it.
+   * @return the opened file.
+   */
+  virtual AccessLogFileSharedPtr
+  createAccessLog(const Envoy::Filesystem::FilePathAndType& file_info,
+                  uint64_t max_size_bytes) PURE;
 };
 
 using AccessLogManagerPtr = std::unique_ptr<AccessLogManager>;
@@ -125,6 +125,14 @@ public:
    */
   virtual ssize_t fileSize(const std::string& path) PURE;
 
+  /**
+   * Moves a file, replacing the file at the destination if there is one.
+   * @param from_path the path of the file to move.
+   * @param to_path the path to move it to.
+   * @return bool whether the file was moved.
+   */
+  virtual bool moveFile(const std::string& from_path, const std::string& to_path) PURE;
+
   /**
    * @return full file content as a string.
    * @throw EnvoyException if the file cannot be read.
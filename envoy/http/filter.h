@@ -1091,6 +1091,12 @@ public:
   virtual bool createUpgradeFilterChain(absl::string_view upgrade,
                                         const UpgradeMap* per_route_upgrade_map,
                                         FilterChainFactoryCallbacks& callbacks) PURE;
+
+  /**
+   * @return the number of filters createFilterChain() adds, or 0 if unknown. Only used to size the
+   *         per stream storage of the filter chain.
+   */
+  virtual uint32_t filterChainLengthHint() const { return 0; }
 };
 
 } // namespace Http
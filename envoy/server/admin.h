@@ -55,6 +55,13 @@ public:
    * absl::nullopt.
    */
   virtual Http::Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() PURE;
+
+  /**
+   * @return bool whether the handler may continue the response after it returned, by calling
+   * setEndStreamOnComplete(false) and encoding the rest of the response through
+   * getDecoderFilterCallbacks(). This is not the case for requests made through Admin::request().
+   */
+  virtual bool canStreamResponse() const PURE;
 };
 
 /**
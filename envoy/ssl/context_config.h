@@ -89,6 +89,12 @@ public:
    * @return a callback for configuring an SSL_CTX before use.
    */
   virtual SslCtxCb sslctxCb() const PURE;
+
+  /**
+   * @return true if record encryption of sent application data should be offloaded to the
+   * kernel once the handshake has completed, where the negotiated parameters allow it.
+   */
+  virtual bool kernelTlsOffload() const PURE;
 };
 
 class ClientContextConfig : public virtual ContextConfig {
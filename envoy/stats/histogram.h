@@ -24,6 +24,12 @@ public:
    * @return The buckets for the histogram. Each value is an upper bound of a bucket.
    */
   virtual ConstSupportedBuckets& buckets(absl::string_view stat_name) const PURE;
+
+  /**
+   * @return whether histograms only count their values in their buckets, instead of recording
+   *         them in log-linear histograms. Quantiles are then interpolated within the buckets.
+   */
+  virtual bool fixedBuckets() const PURE;
 };
 
 using HistogramSettingsConstPtr = std::unique_ptr<const HistogramSettings>;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <string>
@@ -15,6 +16,7 @@
 #include "envoy/upstream/outlier_detection.h"
 
 #include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -57,6 +59,60 @@ struct HostStats {
 
 class ClusterInfo;
 
+/**
+ * Estimate of the round trip latency of requests to a host. The estimate is shared by all workers,
+ * so implementations must be thread safe.
+ */
+class LatencyEstimator {
+public:
+  virtual ~LatencyEstimator() = default;
+
+  /**
+   * Record the round trip latency of a request to the host.
+   * @param rtt supplies the time between sending the request and receiving the response.
+   */
+  virtual void putRoundTripTime(std::chrono::microseconds rtt) PURE;
+
+  /**
+   * @return the current round trip latency estimate in microseconds, or absl::nullopt if no request
+   *         to the host has completed yet.
+   */
+  virtual absl::optional<double> roundTripTimeEstimate() const PURE;
+};
+
+/**
+ * Count of the requests active on a host, updated by the connection pools of all workers and read
+ * by load balancers. Implementations must be thread safe.
+ */
+class ActiveRequestCounter {
+public:
+  virtual ~ActiveRequestCounter() = default;
+
+  /**
+   * Record the start of a request to the host.
+   */
+  virtual void inc() PURE;
+
+  /**
+   * Record the completion of a request to the host.
+   */
+  virtual void dec() PURE;
+
+  /**
+   * @return the number of requests active on the host. Depending on the implementation, this may
+   *         be an estimate combining the requests started by the calling worker with a periodically
+   *         merged count of the requests started by the other workers.
+   */
+  virtual uint64_t estimate() PURE;
+
+  /**
+   * Sums the counts of all workers and refreshes the rq_active statistic of the host. Costlier than
+   * estimate(), for the readers off the request path, e.g. load reports and the admin interface.
+   * @return the number of requests active on the host.
+   */
+  virtual uint64_t total() PURE;
+};
+
 /**
  * A description of an upstream host.
  */
@@ -94,6 +150,18 @@ public:
    */
   virtual Outlier::DetectorHostMonitor& outlierDetector() const PURE;
 
+  /**
+   * @return the host's latency estimator. The estimate is only maintained for clusters using a
+   *         latency aware load balancing policy, otherwise this is a no-op implementation.
+   */
+  virtual LatencyEstimator& latencyEstimator() const PURE;
+
+  /**
+   * @return the host's active request counter. Unless the cluster keeps per worker counts, this
+   *         updates and reads the rq_active gauge of stats().
+   */
+  virtual ActiveRequestCounter& activeRequests() const PURE;
+
   /**
    * @return the host's health checker monitor.
    */
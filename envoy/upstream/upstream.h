@@ -853,6 +853,12 @@ public:
   virtual const absl::optional<envoy::config::cluster::v3::Cluster::LeastRequestLbConfig>&
   lbLeastRequestConfig() const PURE;
 
+  /**
+   * @return configuration for peak EWMA load balancing, only used if LB type is peak EWMA.
+   */
+  virtual const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const PURE;
+
   /**
    * @return configuration for ring hash load balancing, only used if type is set to ring_hash_lb.
    */
@@ -995,6 +1001,12 @@ public:
    */
   virtual bool connectionPoolPerDownstreamConnection() const PURE;
 
+  /**
+   * @return the number of workers owning the HTTP/2 and HTTP/3 connections to each host, which
+   *         are shared with the other workers, or 0 if every worker owns its connections.
+   */
+  virtual uint32_t sharedConnPoolOwnerWorkers() const PURE;
+
   /**
    * @return true if this cluster is configured to ignore hosts for the purpose of load balancing
    * computations until they have been health checked for the first time.
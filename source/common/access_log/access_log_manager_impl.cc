@@ -1,5 +1,6 @@
 #include "source/common/access_log/access_log_manager_impl.h"
 
+#include <algorithm>
 #include <string>
 
 #include "envoy/common/exception.h"
@@ -8,11 +9,92 @@
 #include "source/common/common/fmt.h"
 #include "source/common/common/lock_guard.h"
 
-#include "absl/container/fixed_array.h"
+#include "absl/strings/str_cat.h"
 
 namespace Envoy {
 namespace AccessLog {
 
+AccessLogFlusher::AccessLogFlusher(Thread::ThreadFactory& thread_factory)
+    : flush_thread_(thread_factory.createThread([this]() -> void { flushThreadFunc(); },
+                                                Thread::Options{"AccessLogFlush"})) {}
+
+AccessLogFlusher::~AccessLogFlusher() {
+  {
+    Thread::LockGuard wake_lock(wake_lock_);
+    exit_ = true;
+    wake_event_.notifyOne();
+  }
+  flush_thread_->join();
+  ASSERT(files_.empty());
+}
+
+void AccessLogFlusher::addFile(AccessLogFileImpl& file) {
+  Thread::LockGuard files_lock(files_lock_);
+  files_.insert(&file);
+}
+
+void AccessLogFlusher::removeFile(AccessLogFileImpl& file) {
+  Thread::LockGuard files_lock(files_lock_);
+  files_.erase(&file);
+  while (flushing_ == &file) {
+    // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+    flush_done_.wait(files_lock_);
+  }
+}
+
+void AccessLogFlusher::wakeUp() {
+  Thread::LockGuard wake_lock(wake_lock_);
+  wake_requested_ = true;
+  wake_event_.notifyOne();
+}
+
+void AccessLogFlusher::flushThreadFunc() {
+  bool more = false;
+  while (true) {
+    {
+      Thread::LockGuard wake_lock(wake_lock_);
+
+      // wake_event_ can be woken up either by a file with enough pending data, or by the timer.
+      // Files which still have enough pending data after the last round are flushed again right
+      // away.
+      while (!wake_requested_ && !more && !exit_) {
+        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
+        wake_event_.wait(wake_lock_);
+      }
+
+      if (exit_) {
+        return;
+      }
+      wake_requested_ = false;
+    }
+
+    // Files are flushed without holding files_lock_, so that adding and removing files doesn't
+    // wait for the disk.
+    std::vector<AccessLogFileImpl*> files;
+    {
+      Thread::LockGuard files_lock(files_lock_);
+      files.assign(files_.begin(), files_.end());
+    }
+    more = false;
+    for (AccessLogFileImpl* file : files) {
+      {
+        Thread::LockGuard files_lock(files_lock_);
+        if (!files_.contains(file)) {
+          // Removed since the snapshot.
+          continue;
+        }
+        flushing_ = file;
+      }
+      more |= file->flushPending();
+      {
+        Thread::LockGuard files_lock(files_lock_);
+        flushing_ = nullptr;
+        flush_done_.notifyAll();
+      }
+    }
+  }
+}
+
 AccessLogManagerImpl::~AccessLogManagerImpl() {
   for (auto& [log_key, log_file_ptr] : access_logs_) {
     ENVOY_LOG(debug, "destroying access logger {}", log_key);
@@ -29,34 +111,50 @@ void AccessLogManagerImpl::reopen() {
 
 AccessLogFileSharedPtr
 AccessLogManagerImpl::createAccessLog(const Filesystem::FilePathAndType& file_info) {
+  return createAccessLog(file_info, 0);
+}
+
+AccessLogFileSharedPtr
+AccessLogManagerImpl::createAccessLog(const Filesystem::FilePathAndType& file_info,
+                                      uint64_t max_size_bytes) {
   auto file = api_.fileSystem().createFile(file_info);
   std::string file_name = file->path();
   if (access_logs_.count(file_name)) {
     return access_logs_[file_name];
   }
-  access_logs_[file_name] =
-      std::make_shared<AccessLogFileImpl>(std::move(file), dispatcher_, lock_, file_stats_,
-                                          file_flush_interval_msec_, api_.threadFactory());
+  if (flusher_ == nullptr) {
+    flusher_ = std::make_shared<AccessLogFlusher>(api_.threadFactory());
+    flush_timer_ = dispatcher_.createTimer([this]() -> void {
+      file_stats_.flushed_by_timer_.inc();
+      flusher_->wakeUp();
+      flush_timer_->enableTimer(file_flush_interval_msec_);
+    });
+    flush_timer_->enableTimer(file_flush_interval_msec_);
+  }
+  access_logs_[file_name] = std::make_shared<AccessLogFileImpl>(
+      std::move(file), api_.fileSystem(), flusher_, lock_, file_stats_, max_size_bytes);
   return access_logs_[file_name];
 }
 
-AccessLogFileImpl::AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
+AccessLogFileImpl::AccessLogFileImpl(Filesystem::FilePtr&& file, Filesystem::Instance& file_system,
+                                     AccessLogFlusherSharedPtr flusher,
                                      Thread::BasicLockable& lock, AccessLogFileStats& stats,
-                                     std::chrono::milliseconds flush_interval_msec,
-                                     Thread::ThreadFactory& thread_factory)
-    : file_(std::move(file)), file_lock_(lock),
-      flush_timer_(dispatcher.createTimer([this]() -> void {
-        stats_.flushed_by_timer_.inc();
-        flush_event_.notifyOne();
-        flush_timer_->enableTimer(flush_interval_msec_);
-      })),
-      thread_factory_(thread_factory), flush_interval_msec_(flush_interval_msec), stats_(stats) {
-  flush_timer_->enableTimer(flush_interval_msec_);
+                                     uint64_t max_size_bytes)
+    : file_(std::move(file)), file_system_(file_system), flusher_(std::move(flusher)),
+      file_lock_(lock),
+      max_size_bytes_(file_->destinationType() == Filesystem::DestinationType::File
+                          ? max_size_bytes
+                          : 0),
+      stats_(stats) {
   auto open_result = open();
   if (!open_result.return_value_) {
     throw EnvoyException(fmt::format("unable to open file '{}': {}", file_->path(),
                                      open_result.err_->getErrorDetails()));
   }
+  if (max_size_bytes_ > 0) {
+    size_bytes_ = std::max<ssize_t>(file_system_.fileSize(file_->path()), 0);
+  }
+  flusher_->addFile(*this);
 }
 
 Filesystem::FlagSet AccessLogFileImpl::defaultFlags() {
@@ -75,30 +173,18 @@ Api::IoCallBoolResult AccessLogFileImpl::open() {
 void AccessLogFileImpl::reopen() { reopen_file_ = true; }
 
 AccessLogFileImpl::~AccessLogFileImpl() {
-  {
-    Thread::LockGuard lock(write_lock_);
-    flush_thread_exit_ = true;
-    flush_event_.notifyOne();
-  }
-
-  if (flush_thread_ != nullptr) {
-    flush_thread_->join();
-  }
+  flusher_->removeFile(*this);
 
-  // Flush any remaining data. If file was not opened for some reason, skip flushing part.
+  // Flush any remaining data. If file was not opened for some reason, the data is dropped.
+  flushPending();
   if (file_->isOpen()) {
-    if (flush_buffer_.length() > 0) {
-      doWrite(flush_buffer_);
-    }
     const Api::IoCallBoolResult result = file_->close();
     ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
                                              result.err_->getErrorDetails()));
   }
 }
 
-void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
-  Buffer::RawSliceVector slices = buffer.getRawSlices();
-
+void AccessLogFileImpl::doWrite(absl::string_view data) {
   // We must do the actual writes to disk under lock, so that we don't intermix chunks from
   // different AccessLogFileImpl pointing to the same underlying file. This can happen either via
   // hot restart or if calling code opens the same underlying file into a different
@@ -109,106 +195,122 @@ void AccessLogFileImpl::doWrite(Buffer::Instance& buffer) {
   //            process lock or had multiple locks.
   {
     Thread::LockGuard lock(file_lock_);
-    for (const Buffer::RawSlice& slice : slices) {
-      absl::string_view data(static_cast<char*>(slice.mem_), slice.len_);
-      const Api::IoCallSizeResult result = file_->write(data);
-      if (result.ok() && result.return_value_ == static_cast<ssize_t>(slice.len_)) {
-        stats_.write_completed_.inc();
-      } else {
-        // Probably disk full.
-        stats_.write_failed_.inc();
-      }
+    const Api::IoCallSizeResult result = file_->write(data);
+    if (result.ok() && result.return_value_ == static_cast<ssize_t>(data.size())) {
+      stats_.write_completed_.inc();
+    } else {
+      // Probably disk full.
+      stats_.write_failed_.inc();
     }
   }
 
-  stats_.write_total_buffered_.sub(buffer.length());
-  buffer.drain(buffer.length());
+  stats_.write_total_buffered_.sub(data.size());
+  size_bytes_ += data.size();
+  if (max_size_bytes_ > 0 && size_bytes_ >= max_size_bytes_) {
+    rotate();
+  }
 }
 
-void AccessLogFileImpl::flushThreadFunc() {
-
-  while (true) {
-    std::unique_lock<Thread::BasicLockable> flush_lock;
-
-    {
-      Thread::LockGuard write_lock(write_lock_);
-
-      // flush_event_ can be woken up either by large enough flush_buffer or by timer.
-      // In case it was timer, flush_buffer_ can be empty.
-      while (flush_buffer_.length() == 0 && !flush_thread_exit_ && !reopen_file_) {
-        // CondVar::wait() does not throw, so it's safe to pass the mutex rather than the guard.
-        flush_event_.wait(write_lock_);
-      }
+void AccessLogFileImpl::rotate() {
+  const Api::IoCallBoolResult result = file_->close();
+  ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
+                                           result.err_->getErrorDetails()));
+  const std::string path = file_->path();
+  if (file_system_.moveFile(path, absl::StrCat(path, ".1"))) {
+    stats_.rotated_.inc();
+  }
+  // Start over even if the rename failed, rather than trying again on every write.
+  size_bytes_ = 0;
+  if (!open().return_value_) {
+    stats_.reopen_failed_.inc();
+  }
+}
 
-      if (flush_thread_exit_) {
-        return;
-      }
+bool AccessLogFileImpl::flushPending() {
+  Thread::LockGuard flush_lock(flush_lock_);
 
-      flush_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-      about_to_write_buffer_.move(flush_buffer_);
-      ASSERT(flush_buffer_.length() == 0);
+  if (reopen_file_.exchange(false)) {
+    if (file_->isOpen()) {
+      const Api::IoCallBoolResult result = file_->close();
+      ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
+                                               result.err_->getErrorDetails()));
+    }
+    const Api::IoCallBoolResult open_result = open();
+    if (!open_result.return_value_) {
+      stats_.reopen_failed_.inc();
+    } else if (max_size_bytes_ > 0) {
+      // The file may have been replaced, e.g. by logrotate, count from its actual size.
+      size_bytes_ = std::max<ssize_t>(file_system_.fileSize(file_->path()), 0);
     }
+  }
 
-    // if we failed to open file before, then simply ignore
-    if (file_->isOpen()) {
-      if (reopen_file_) {
-        reopen_file_ = false;
-        const Api::IoCallBoolResult result = file_->close();
-        ASSERT(result.return_value_, fmt::format("unable to close file '{}': {}", file_->path(),
-                                                 result.err_->getErrorDetails()));
-        const Api::IoCallBoolResult open_result = open();
-        if (!open_result.return_value_) {
-          stats_.reopen_failed_.inc();
-          return;
-        }
+  // Each write buffer is taken over once, so only what was buffered when the flush started is
+  // written out, and other files are flushed as well when this one is written to faster than it
+  // can be flushed.
+  for (WriteBuffer& buffer : write_buffers_) {
+    {
+      Thread::LockGuard buffer_lock(buffer.lock_);
+      if (buffer.data_.empty()) {
+        continue;
       }
-      doWrite(about_to_write_buffer_);
+      std::swap(buffer.data_, spare_buffer_);
+    }
+    pending_bytes_ -= spare_buffer_.size();
+    if (write_buffer_.empty()) {
+      std::swap(write_buffer_, spare_buffer_);
+    } else {
+      write_buffer_.append(spare_buffer_);
+      spare_buffer_.clear();
     }
+    if (write_buffer_.size() >= MIN_FLUSH_SIZE) {
+      writeBuffer();
+    }
+  }
+  if (!write_buffer_.empty()) {
+    writeBuffer();
   }
+  return pending_bytes_.load() >= MIN_FLUSH_SIZE;
 }
 
-void AccessLogFileImpl::flush() {
-  std::unique_lock<Thread::BasicLockable> flush_buffer_lock;
-
-  {
-    Thread::LockGuard write_lock(write_lock_);
-
-    // flush_lock_ must be held while checking this or else it is
-    // possible that flushThreadFunc() has already moved data from
-    // flush_buffer_ to about_to_write_buffer_, has unlocked write_lock_,
-    // but has not yet completed doWrite(). This would allow flush() to
-    // return before the pending data has actually been written to disk.
-    flush_buffer_lock = std::unique_lock<Thread::BasicLockable>(flush_lock_);
-
-    if (flush_buffer_.length() == 0) {
-      return;
-    }
-
-    about_to_write_buffer_.move(flush_buffer_);
-    ASSERT(flush_buffer_.length() == 0);
+void AccessLogFileImpl::writeBuffer() {
+  if (file_->isOpen()) {
+    doWrite(write_buffer_);
+  } else {
+    // The file failed to reopen, drop the data until it is reopened again.
+    stats_.write_failed_.inc();
+    stats_.write_total_buffered_.sub(write_buffer_.size());
   }
-
-  doWrite(about_to_write_buffer_);
+  write_buffer_.clear();
 }
 
-void AccessLogFileImpl::write(absl::string_view data) {
-  Thread::LockGuard lock(write_lock_);
+void AccessLogFileImpl::flush() { flushPending(); }
 
-  if (flush_thread_ == nullptr) {
-    createFlushStructures();
-  }
+uint32_t AccessLogFileImpl::writeBufferIndex() {
+  // Threads are assigned buffers in the order they first write, so the workers, which are started
+  // together, each get their own buffer. The lock of a buffer is then only contended when a flush
+  // takes it over.
+  static std::atomic<uint32_t> next_index{0};
+  static thread_local const uint32_t index = next_index++ % WRITE_BUFFER_COUNT;
+  return index;
+}
 
+void AccessLogFileImpl::write(absl::string_view data) {
   stats_.write_buffered_.inc();
   stats_.write_total_buffered_.add(data.length());
-  flush_buffer_.add(data.data(), data.size());
-  if (flush_buffer_.length() > MIN_FLUSH_SIZE) {
-    flush_event_.notifyOne();
+  // Accounted before the data is buffered, so that a flush never takes more than was accounted.
+  const uint64_t pending_bytes = (pending_bytes_ += data.length());
+  {
+    WriteBuffer& buffer = write_buffers_[writeBufferIndex()];
+    Thread::LockGuard buffer_lock(buffer.lock_);
+    buffer.data_.append(data.data(), data.size());
   }
-}
 
-void AccessLogFileImpl::createFlushStructures() {
-  flush_thread_ = thread_factory_.createThread([this]() -> void { flushThreadFunc(); },
-                                               Thread::Options{"AccessLogFlush"});
+  // The first write is flushed right away. Later writes are flushed once MIN_FLUSH_SIZE is pending,
+  // or when the flush timer fires.
+  if ((pending_bytes > MIN_FLUSH_SIZE && pending_bytes - data.length() <= MIN_FLUSH_SIZE) ||
+      (!written_.load(std::memory_order_relaxed) && !written_.exchange(true))) {
+    flusher_->wakeUp();
+  }
 }
 
 } // namespace AccessLog
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <memory>
 #include <string>
 
 #include "envoy/access_log/access_log.h"
@@ -13,6 +16,7 @@
 #include "source/common/common/logger.h"
 #include "source/common/common/thread.h"
 
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/node_hash_map.h"
 
 namespace Envoy {
@@ -20,6 +24,7 @@ namespace Envoy {
 #define ACCESS_LOG_FILE_STATS(COUNTER, GAUGE)                                                      \
   COUNTER(flushed_by_timer)                                                                        \
   COUNTER(reopen_failed)                                                                           \
+  COUNTER(rotated)                                                                                 \
   COUNTER(write_buffered)                                                                          \
   COUNTER(write_completed)                                                                         \
   COUNTER(write_failed)                                                                            \
@@ -31,6 +36,49 @@ struct AccessLogFileStats {
 
 namespace AccessLog {
 
+class AccessLogFileImpl;
+
+/**
+ * Flushes the data written to all access log files of a manager on a single thread, so that the
+ * number of flush threads doesn't grow with the number of files.
+ */
+class AccessLogFlusher {
+public:
+  explicit AccessLogFlusher(Thread::ThreadFactory& thread_factory);
+  ~AccessLogFlusher();
+
+  void addFile(AccessLogFileImpl& file);
+
+  /**
+   * Removes a file, waiting for a flush of this file in progress to complete. Flushes of other
+   * files don't delay the removal.
+   */
+  void removeFile(AccessLogFileImpl& file);
+
+  /**
+   * Wakes up the flush thread to flush all files. May be called from any thread.
+   */
+  void wakeUp();
+
+private:
+  void flushThreadFunc();
+
+  // files_lock_ and wake_lock_ are never held together with another lock, and in particular not
+  // while writing to disk.
+  Thread::MutexBasicLockable files_lock_;
+  absl::flat_hash_set<AccessLogFileImpl*> files_ ABSL_GUARDED_BY(files_lock_);
+  // The file being flushed by the flush thread, which removeFile() waits for.
+  AccessLogFileImpl* flushing_ ABSL_GUARDED_BY(files_lock_){};
+  Thread::CondVar flush_done_;
+  Thread::MutexBasicLockable wake_lock_;
+  Thread::CondVar wake_event_;
+  bool wake_requested_ ABSL_GUARDED_BY(wake_lock_){};
+  bool exit_ ABSL_GUARDED_BY(wake_lock_){};
+  Thread::ThreadPtr flush_thread_;
+};
+
+using AccessLogFlusherSharedPtr = std::shared_ptr<AccessLogFlusher>;
+
 class AccessLogManagerImpl : public AccessLogManager, Logger::Loggable<Logger::Id::main> {
 public:
   AccessLogManagerImpl(std::chrono::milliseconds file_flush_interval_msec, Api::Api& api,
@@ -45,6 +93,8 @@ public:
   // AccessLog::AccessLogManager
   void reopen() override;
   AccessLogFileSharedPtr createAccessLog(const Filesystem::FilePathAndType& file_info) override;
+  AccessLogFileSharedPtr createAccessLog(const Filesystem::FilePathAndType& file_info,
+                                         uint64_t max_size_bytes) override;
 
 private:
   const std::chrono::milliseconds file_flush_interval_msec_;
@@ -52,22 +102,29 @@ private:
   Event::Dispatcher& dispatcher_;
   Thread::BasicLockable& lock_;
   AccessLogFileStats file_stats_;
+  // Created with the first file.
+  AccessLogFlusherSharedPtr flusher_;
+  Event::TimerPtr flush_timer_;
   absl::node_hash_map<std::string, AccessLogFileSharedPtr> access_logs_;
 };
 
 /**
  * This is a file implementation geared for writing out access logs. It turn out that in certain
  * cases even if a standard file is opened with O_NONBLOCK, the kernel can still block when writing.
- * This implementation uses a flush thread per file, with the idea there aren't that many
- * files. If this turns out to be a good implementation we can potentially have a single flush
- * thread that flushes all files, but we will start with this.
+ * Each thread appends its writes to its own buffer, and the AccessLogFlusher thread shared by all
+ * files of the manager takes the buffers over whole and writes them out to disk, batching the
+ * writes of all threads into large writes.
  */
 class AccessLogFileImpl : public AccessLogFile {
 public:
-  AccessLogFileImpl(Filesystem::FilePtr&& file, Event::Dispatcher& dispatcher,
-                    Thread::BasicLockable& lock, AccessLogFileStats& stats,
-                    std::chrono::milliseconds flush_interval_msec,
-                    Thread::ThreadFactory& thread_factory);
+  /**
+   * @param max_size_bytes if not 0, the file is rotated once it reaches this size: it is moved
+   *        to <path>.1 through file_system, replacing the previously rotated file, and a new file
+   *        is opened.
+   */
+  AccessLogFileImpl(Filesystem::FilePtr&& file, Filesystem::Instance& file_system,
+                    AccessLogFlusherSharedPtr flusher, Thread::BasicLockable& lock,
+                    AccessLogFileStats& stats, uint64_t max_size_bytes);
   ~AccessLogFileImpl() override;
 
   // AccessLog::AccessLogFile
@@ -82,57 +139,59 @@ public:
   void flush() override;
 
 private:
-  void doWrite(Buffer::Instance& buffer);
-  void flushThreadFunc();
+  friend class AccessLogFlusher;
+
+  // Appended to by the threads mapped to it, and swapped out whole by flushes, so that appending
+  // neither allocates per write nor contends with other threads.
+  struct WriteBuffer {
+    Thread::MutexBasicLockable lock_;
+    std::string data_ ABSL_GUARDED_BY(lock_);
+  };
+
+  /**
+   * Writes out the data buffered when the call started.
+   * @return bool whether at least MIN_FLUSH_SIZE is still buffered.
+   */
+  bool flushPending();
+  void doWrite(absl::string_view data);
+  void writeBuffer();
+  void rotate();
   Api::IoCallBoolResult open();
-  void createFlushStructures();
 
   // return default flags set which used by open
   static Filesystem::FlagSet defaultFlags();
 
+  // Returns the index of the write buffer of the calling thread.
+  static uint32_t writeBufferIndex();
+
   // Minimum size before the flush thread will be told to flush.
   static const uint64_t MIN_FLUSH_SIZE = 1024 * 64;
+  // Threads beyond this number share write buffers.
+  static constexpr uint32_t WRITE_BUFFER_COUNT = 16;
 
   Filesystem::FilePtr file_;
+  Filesystem::Instance& file_system_;
+  const AccessLogFlusherSharedPtr flusher_;
 
   // These locks are always acquired in the following order if multiple locks are held:
-  //    1) write_lock_
-  //    2) flush_lock_
-  //    3) file_lock_
-  Thread::BasicLockable& file_lock_;      // This lock is used only by the flush thread when writing
-                                          // to disk. This is used to make sure that file blocks do
-                                          // not get interleaved by multiple processes writing to
-                                          // the same file during hot-restart.
+  //    1) flush_lock_
+  //    2) file_lock_ or the lock of a write buffer
+  Thread::BasicLockable& file_lock_;      // This lock is used only when writing to disk. This is
+                                          // used to make sure that file blocks do not get
+                                          // interleaved by multiple processes writing to the same
+                                          // file during hot-restart.
   Thread::MutexBasicLockable flush_lock_; // This lock is used to prevent simultaneous flushes from
                                           // the flush thread and a synchronous flush. This protects
-                                          // concurrent access to the about_to_write_buffer_, fd_,
-                                          // and all other data used during flushing and file
-                                          // re-opening.
-  Thread::MutexBasicLockable
-      write_lock_; // The lock is used when filling the flush buffer. It allows
-                   // multiple threads to write to the same file at relatively
-                   // high performance. It is always local to the process.
-  Thread::ThreadPtr flush_thread_;
-  Thread::CondVar flush_event_;
-  std::atomic<bool> flush_thread_exit_{};
+                                          // write_buffer_, spare_buffer_, file_ and all other data
+                                          // used during flushing and file re-opening.
+  std::array<WriteBuffer, WRITE_BUFFER_COUNT> write_buffers_;
+  std::atomic<uint64_t> pending_bytes_{};
+  std::atomic<bool> written_{};
   std::atomic<bool> reopen_file_{};
-  Buffer::OwnedImpl
-      flush_buffer_ ABSL_GUARDED_BY(write_lock_); // This buffer is used by multiple threads. It
-                                                  // gets filled and then flushed either when max
-                                                  // size is reached or when a timer fires.
-  // TODO(jmarantz): this should be ABSL_GUARDED_BY(flush_lock_) but the analysis cannot poke
-  // through the std::make_unique assignment. I do not believe it's possible to annotate this
-  // properly now due to limitations in the clang thread annotation analysis.
-  Buffer::OwnedImpl about_to_write_buffer_; // This buffer is used only by the flush thread. Data
-                                            // is moved from flush_buffer_ under lock, and then
-                                            // the lock is released so that flush_buffer_ can
-                                            // continue to fill. This buffer is then used for the
-                                            // final write to disk.
-  Event::TimerPtr flush_timer_;
-  Thread::ThreadFactory& thread_factory_;
-  const std::chrono::milliseconds flush_interval_msec_; // Time interval buffer gets flushed no
-                                                        // matter if it reached the MIN_FLUSH_SIZE
-                                                        // or not.
+  std::string write_buffer_; // Collects the write buffers into large writes to disk.
+  std::string spare_buffer_; // Swapped in for a write buffer taken over by a flush.
+  const uint64_t max_size_bytes_;
+  uint64_t size_bytes_{};
   AccessLogFileStats& stats_;
 };
 
@@ -9,6 +9,7 @@
 #include "envoy/buffer/buffer.h"
 #include "envoy/http/stream_reset_handler.h"
 
+#include "source/common/buffer/slice_allocator.h"
 #include "source/common/common/assert.h"
 #include "source/common/common/non_copyable.h"
 #include "source/common/common/utility.h"
@@ -35,7 +36,20 @@ namespace Buffer {
 class Slice {
 public:
   using Reservation = RawSlice;
-  using StoragePtr = std::unique_ptr<uint8_t[]>;
+
+  /**
+   * Frees storage allocated by either SliceAllocator or the heap.
+   */
+  struct StorageDeleter {
+    void operator()(uint8_t* storage) const {
+      if (SliceAllocator::owns(storage)) {
+        SliceAllocator::deallocate(storage);
+      } else {
+        delete[] storage;
+      }
+    }
+  };
+  using StoragePtr = std::unique_ptr<uint8_t[], StorageDeleter>;
 
   static constexpr uint32_t free_list_max_ = Buffer::Reservation::MAX_SLICES_;
   using FreeListType = absl::InlinedVector<StoragePtr, free_list_max_>;
@@ -337,6 +351,8 @@ public:
   }
 
   static constexpr uint32_t default_slice_size_ = 16384;
+  static_assert(default_slice_size_ == SliceAllocator::BlockSize,
+                "SliceAllocator only allocates the storage of slices of the default size");
 
   static FreeListReference freeList() { return FreeListReference(free_list_); }
 
@@ -371,6 +387,13 @@ protected:
       }
     }
 
+    if (capacity == default_slice_size_) {
+      storage.reset(SliceAllocator::allocate());
+      if (storage != nullptr) {
+        return storage;
+      }
+    }
+
     storage.reset(new uint8_t[capacity]);
     return storage;
   }
@@ -0,0 +1,439 @@
+#include "source/common/buffer/slice_allocator.h"
+
+#if !defined(WIN32)
+#include <sys/mman.h>
+#endif
+
+#include <algorithm>
+#include <iterator>
+#include <list>
+#include <vector>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Buffer {
+
+std::atomic<bool> SliceAllocator::enabled_{false};
+std::atomic<uint8_t*> SliceAllocator::region_begin_{nullptr};
+std::atomic<uint8_t*> SliceAllocator::region_end_{nullptr};
+
+namespace {
+
+uint8_t* reserveRegion(uint64_t size, bool use_hugepages) {
+#if defined(WIN32)
+  UNREFERENCED_PARAMETER(size);
+  UNREFERENCED_PARAMETER(use_hugepages);
+  return nullptr;
+#else
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_NORESERVE)
+  // Pages are only backed once touched, the address range is merely reserved.
+  flags |= MAP_NORESERVE;
+#endif
+  // Map an extra slab to be able to align the region on the slab size, which lets the kernel back
+  // each slab with a single hugepage.
+  void* mapped = ::mmap(nullptr, size + SliceAllocator::SlabSize, PROT_READ | PROT_WRITE, flags,
+                        -1, 0);
+  if (mapped == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t start = reinterpret_cast<uintptr_t>(mapped);
+  const uintptr_t aligned =
+      (start + SliceAllocator::SlabSize - 1) & ~(SliceAllocator::SlabSize - 1);
+  if (aligned > start) {
+    ::munmap(mapped, aligned - start);
+  }
+  const uintptr_t tail = SliceAllocator::SlabSize - (aligned - start);
+  if (tail > 0) {
+    ::munmap(reinterpret_cast<void*>(aligned + size), tail);
+  }
+#if defined(MADV_HUGEPAGE)
+  if (use_hugepages) {
+    // Without transparent hugepages, the slabs are backed by regular pages.
+    ::madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+  }
+#else
+  UNREFERENCED_PARAMETER(use_hugepages);
+#endif
+  return reinterpret_cast<uint8_t*>(aligned);
+#endif
+}
+
+uint64_t slabsFor(uint64_t bytes) {
+  return std::max<uint64_t>((bytes + SliceAllocator::SlabSize - 1) / SliceAllocator::SlabSize, 1);
+}
+
+void decommitSlab(uint8_t* slab) {
+#if !defined(WIN32)
+  // The pages are backed again, zeroed, once touched.
+  ::madvise(slab, SliceAllocator::SlabSize, MADV_DONTNEED);
+#else
+  UNREFERENCED_PARAMETER(slab);
+#endif
+}
+
+class ThreadCache;
+
+// The slabs, shared by all the threads.
+class Central {
+public:
+  void init(uint8_t* region, uint32_t num_slabs) {
+    absl::MutexLock lock(&mutex_);
+    region_ = region;
+    slabs_.resize(num_slabs);
+  }
+
+  void configure(const SliceAllocator::Config& config) {
+    absl::MutexLock lock(&mutex_);
+    max_slabs_ = std::min<uint64_t>(slabsFor(config.max_bytes_), slabs_.size());
+    max_free_slabs_ = config.max_free_slabs_;
+    thread_cache_blocks_.store(std::max<uint32_t>(config.thread_cache_blocks_, 1),
+                               std::memory_order_relaxed);
+    releaseFreeSlabs(max_free_slabs_);
+    // The maximum may have grown.
+    exhausted_.store(false, std::memory_order_relaxed);
+  }
+
+  uint32_t threadCacheBlocks() const {
+    return thread_cache_blocks_.load(std::memory_order_relaxed);
+  }
+  uint64_t releaseEpoch() const { return release_epoch_.load(std::memory_order_relaxed); }
+
+  // Takes up to count blocks out of the slabs.
+  // @return the number of blocks taken, 0 if the slabs are exhausted.
+  uint32_t takeBlocks(uint8_t** blocks, uint32_t count) {
+    // Once exhausted, allocations go to the heap without contending on the mutex until blocks are
+    // returned.
+    if (exhausted_.load(std::memory_order_relaxed)) {
+      return 0;
+    }
+    absl::MutexLock lock(&mutex_);
+    uint32_t taken = 0;
+    while (taken < count) {
+      if (available_.empty() && !commitSlab()) {
+        break;
+      }
+      Slab& slab = slabs_[available_.back()];
+      if (!slab.committed_ || slab.freeBlocks() == 0) {
+        // Slabs are only removed from the available ones once looked at.
+        slab.available_ = false;
+        available_.pop_back();
+        continue;
+      }
+      if (slab.freeBlocks() == SliceAllocator::BlocksPerSlab) {
+        free_slabs_--;
+      }
+      uint8_t* base = region_ + available_.back() * SliceAllocator::SlabSize;
+      while (taken < count && slab.freeBlocks() > 0) {
+        if (!slab.free_blocks_.empty()) {
+          blocks[taken++] = slab.free_blocks_.back();
+          slab.free_blocks_.pop_back();
+        } else {
+          // Blocks are carved in order, so that the pages of a slab are only touched once needed.
+          blocks[taken++] = base + slab.carved_++ * SliceAllocator::BlockSize;
+        }
+      }
+    }
+    blocks_out_ += taken;
+    if (taken == 0) {
+      exhausted_.store(true, std::memory_order_relaxed);
+    }
+    return taken;
+  }
+
+  void onHeapFallback() { heap_fallbacks_.fetch_add(1, std::memory_order_relaxed); }
+
+  // Returns blocks to their slabs, and returns the slabs without any block in use to the OS past
+  // the bound of free slabs, or all of them if release_all is set.
+  void returnBlocks(uint8_t* const* blocks, uint32_t count, bool release_all) {
+    absl::MutexLock lock(&mutex_);
+    const uint32_t max_free_slabs = release_all ? 0 : max_free_slabs_;
+    for (uint32_t i = 0; i < count; i++) {
+      const uint32_t index = (blocks[i] - region_) / SliceAllocator::SlabSize;
+      Slab& slab = slabs_[index];
+      ASSERT(slab.committed_);
+      slab.free_blocks_.push_back(blocks[i]);
+      if (!slab.available_) {
+        slab.available_ = true;
+        available_.push_back(index);
+      }
+      if (slab.freeBlocks() == SliceAllocator::BlocksPerSlab) {
+        free_slabs_++;
+        if (free_slabs_ > max_free_slabs) {
+          releaseSlab(index);
+        }
+      }
+    }
+    blocks_out_ -= count;
+    if (count > 0) {
+      exhausted_.store(false, std::memory_order_relaxed);
+    }
+    if (release_all) {
+      releaseFreeSlabs(0);
+    }
+  }
+
+  void releaseFreeMemory() {
+    release_epoch_.fetch_add(1, std::memory_order_relaxed);
+    absl::MutexLock lock(&mutex_);
+    releaseFreeSlabs(0);
+  }
+
+  void addThreadCache(ThreadCache& cache) {
+    absl::MutexLock lock(&mutex_);
+    thread_caches_.push_back(&cache);
+  }
+
+  void removeThreadCache(ThreadCache& cache) {
+    absl::MutexLock lock(&mutex_);
+    thread_caches_.remove(&cache);
+  }
+
+  SliceAllocator::Stats stats();
+
+private:
+  struct Slab {
+    uint32_t freeBlocks() const {
+      return SliceAllocator::BlocksPerSlab - carved_ + free_blocks_.size();
+    }
+
+    // Blocks carved out of the slab before, and freed since.
+    std::vector<uint8_t*> free_blocks_;
+    // Number of blocks carved out of the slab since it was committed.
+    uint32_t carved_{};
+    bool committed_{};
+    // Whether the slab is in available_.
+    bool available_{};
+  };
+
+  bool commitSlab() ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    uint32_t index = max_slabs_;
+    for (auto it = released_.rbegin(); it != released_.rend(); it++) {
+      // Slabs beyond the configured maximum, after a reconfiguration, are kept for later ones.
+      if (*it < max_slabs_) {
+        index = *it;
+        released_.erase(std::next(it).base());
+        break;
+      }
+    }
+    if (index == max_slabs_) {
+      if (next_slab_ >= max_slabs_) {
+        return false;
+      }
+      index = next_slab_++;
+    }
+    Slab& slab = slabs_[index];
+    ASSERT(!slab.committed_ && slab.carved_ == 0 && slab.free_blocks_.empty());
+    slab.committed_ = true;
+    committed_slabs_++;
+    free_slabs_++;
+    if (!slab.available_) {
+      slab.available_ = true;
+      available_.push_back(index);
+    }
+    return true;
+  }
+
+  void releaseSlab(uint32_t index) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    Slab& slab = slabs_[index];
+    ASSERT(slab.committed_ && slab.freeBlocks() == SliceAllocator::BlocksPerSlab);
+    slab.free_blocks_.clear();
+    slab.carved_ = 0;
+    slab.committed_ = false;
+    committed_slabs_--;
+    free_slabs_--;
+    slabs_released_++;
+    released_.push_back(index);
+    decommitSlab(region_ + index * SliceAllocator::SlabSize);
+  }
+
+  void releaseFreeSlabs(uint32_t max_free_slabs) ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    for (uint32_t index = 0; index < next_slab_ && free_slabs_ > max_free_slabs; index++) {
+      const Slab& slab = slabs_[index];
+      if (slab.committed_ && slab.freeBlocks() == SliceAllocator::BlocksPerSlab) {
+        releaseSlab(index);
+      }
+    }
+  }
+
+  absl::Mutex mutex_;
+  uint8_t* region_ ABSL_GUARDED_BY(mutex_){};
+  std::vector<Slab> slabs_ ABSL_GUARDED_BY(mutex_);
+  // Slabs which may have free blocks, the last one being used first.
+  std::vector<uint32_t> available_ ABSL_GUARDED_BY(mutex_);
+  // Slabs returned to the OS, below next_slab_.
+  std::vector<uint32_t> released_ ABSL_GUARDED_BY(mutex_);
+  uint32_t next_slab_ ABSL_GUARDED_BY(mutex_){};
+  uint32_t max_slabs_ ABSL_GUARDED_BY(mutex_){};
+  uint32_t max_free_slabs_ ABSL_GUARDED_BY(mutex_){};
+  uint32_t committed_slabs_ ABSL_GUARDED_BY(mutex_){};
+  // Committed slabs without any block in use.
+  uint32_t free_slabs_ ABSL_GUARDED_BY(mutex_){};
+  // Blocks held by slices or thread caches.
+  uint64_t blocks_out_ ABSL_GUARDED_BY(mutex_){};
+  uint64_t slabs_released_ ABSL_GUARDED_BY(mutex_){};
+  std::list<ThreadCache*> thread_caches_ ABSL_GUARDED_BY(mutex_);
+  // Set when the slabs had no block left to take, cleared when blocks are returned or the
+  // maximum is reconfigured. Only written with the mutex held.
+  std::atomic<bool> exhausted_{};
+  std::atomic<uint64_t> heap_fallbacks_{};
+  std::atomic<uint32_t> thread_cache_blocks_{1};
+  // Bumped to have the thread caches return their blocks.
+  std::atomic<uint64_t> release_epoch_{};
+};
+
+Central& central() { MUTABLE_CONSTRUCT_ON_FIRST_USE(Central); }
+
+thread_local bool thread_cache_destroyed = false;
+
+// The blocks cached by a thread, only touched by that thread but for their count.
+class ThreadCache {
+public:
+  ThreadCache() : release_epoch_(central().releaseEpoch()) { central().addThreadCache(*this); }
+
+  ~ThreadCache() {
+    returnBlocks(blocks_.size(), false);
+    central().removeThreadCache(*this);
+    // Slices freed later on, by the destructors of other thread locals, go to the slabs directly.
+    thread_cache_destroyed = true;
+  }
+
+  uint8_t* allocate() {
+    maybeRelease();
+    if (blocks_.empty()) {
+      const uint32_t batch = std::max<uint32_t>(central().threadCacheBlocks() / 2, 1);
+      blocks_.resize(batch);
+      blocks_.resize(central().takeBlocks(blocks_.data(), batch));
+      if (blocks_.empty()) {
+        return nullptr;
+      }
+    }
+    uint8_t* block = blocks_.back();
+    blocks_.pop_back();
+    size_.store(blocks_.size(), std::memory_order_relaxed);
+    return block;
+  }
+
+  void deallocate(uint8_t* block) {
+    maybeRelease();
+    blocks_.push_back(block);
+    const uint32_t max_blocks = central().threadCacheBlocks();
+    if (blocks_.size() > max_blocks) {
+      // The blocks freed last are the most likely to still be in the CPU caches, keep them.
+      returnBlocks(blocks_.size() - max_blocks / 2, false);
+    }
+    size_.store(blocks_.size(), std::memory_order_relaxed);
+  }
+
+  uint32_t size() const { return size_.load(std::memory_order_relaxed); }
+
+  // Returns all the blocks to the slabs if releaseFreeMemory() was called since the last check.
+  void maybeRelease() {
+    const uint64_t release_epoch = central().releaseEpoch();
+    if (release_epoch != release_epoch_) {
+      release_epoch_ = release_epoch;
+      returnBlocks(blocks_.size(), true);
+    }
+  }
+
+private:
+  // Returns the count oldest blocks to the slabs.
+  void returnBlocks(uint32_t count, bool release_all) {
+    if (count == 0) {
+      return;
+    }
+    central().returnBlocks(blocks_.data(), count, release_all);
+    blocks_.erase(blocks_.begin(), blocks_.begin() + count);
+    size_.store(blocks_.size(), std::memory_order_relaxed);
+  }
+
+  std::vector<uint8_t*> blocks_;
+  std::atomic<uint32_t> size_{};
+  uint64_t release_epoch_;
+};
+
+ThreadCache* threadCache() {
+  if (thread_cache_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadCache cache;
+  return &cache;
+}
+
+SliceAllocator::Stats Central::stats() {
+  absl::MutexLock lock(&mutex_);
+  uint64_t thread_cached_blocks = 0;
+  for (const ThreadCache* cache : thread_caches_) {
+    thread_cached_blocks += cache->size();
+  }
+  // The counts of the thread caches are loosely synchronized with blocks_out_.
+  thread_cached_blocks = std::min(thread_cached_blocks, blocks_out_);
+  return {(blocks_out_ - thread_cached_blocks) * SliceAllocator::BlockSize,
+          thread_cached_blocks * SliceAllocator::BlockSize,
+          committed_slabs_ * SliceAllocator::SlabSize,
+          heap_fallbacks_.load(std::memory_order_relaxed), slabs_released_};
+}
+
+} // namespace
+
+bool SliceAllocator::configure(const Config& config) {
+  if (region_begin_.load(std::memory_order_acquire) == nullptr) {
+    const uint64_t size = slabsFor(config.max_bytes_) * SlabSize;
+    uint8_t* region = reserveRegion(size, config.use_hugepages_);
+    if (region == nullptr) {
+      return false;
+    }
+    central().init(region, size / SlabSize);
+    region_end_.store(region + size, std::memory_order_relaxed);
+    region_begin_.store(region, std::memory_order_release);
+  }
+  central().configure(config);
+  enabled_.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+uint8_t* SliceAllocator::allocateBlock() {
+  ThreadCache* cache = threadCache();
+  uint8_t* block = nullptr;
+  if (cache == nullptr) {
+    central().takeBlocks(&block, 1);
+  } else {
+    block = cache->allocate();
+  }
+  if (block == nullptr) {
+    central().onHeapFallback();
+  }
+  return block;
+}
+
+void SliceAllocator::deallocate(uint8_t* storage) {
+  ASSERT(owns(storage));
+  ThreadCache* cache = threadCache();
+  if (cache == nullptr) {
+    central().returnBlocks(&storage, 1, false);
+    return;
+  }
+  cache->deallocate(storage);
+}
+
+void SliceAllocator::releaseFreeMemory() {
+  if (region_begin_.load(std::memory_order_acquire) == nullptr) {
+    return;
+  }
+  central().releaseFreeMemory();
+  // Return the blocks of this thread right away, releasing their slabs if they become free.
+  ThreadCache* cache = threadCache();
+  if (cache != nullptr) {
+    cache->maybeRelease();
+  }
+}
+
+SliceAllocator::Stats SliceAllocator::stats() { return central().stats(); }
+
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+namespace Envoy {
+namespace Buffer {
+
+/**
+ * Process wide allocator for the storage of the slices of the default size, carving it out of 2MiB
+ * slabs of a single address range reserved up front, which can be backed by transparent hugepages.
+ *
+ * Each thread caches the storage it frees for its next allocations, up to a bound, past which half
+ * of its cache goes back to the slabs. Slabs with none of their storage in use are returned to the
+ * OS, past a bound of free slabs kept for reuse, or all of them once releaseFreeMemory() is called,
+ * e.g. when the shrink heap overload action is triggered.
+ *
+ * The allocator is disabled by default, in which case allocate() returns nullptr and the slices
+ * use the heap. Storage may be freed on any thread, and after the allocator was disabled.
+ */
+class SliceAllocator {
+public:
+  static constexpr uint64_t BlockSize = 16384;
+  static constexpr uint64_t SlabSize = 2 * 1024 * 1024;
+  static constexpr uint32_t BlocksPerSlab = SlabSize / BlockSize;
+
+  struct Config {
+    // Upper bound of the memory carved into slabs. The first call to configure() reserves this
+    // much address space, which later calls can't grow.
+    uint64_t max_bytes_;
+    // Whether to advise the kernel to back the slabs with transparent hugepages.
+    bool use_hugepages_;
+    // Number of blocks each thread caches for its next allocations.
+    uint32_t thread_cache_blocks_;
+    // Number of slabs without any block in use kept for reuse rather than returned to the OS.
+    uint32_t max_free_slabs_;
+  };
+
+  struct Stats {
+    // Bytes of the blocks held by slices.
+    uint64_t bytes_in_use_;
+    // Bytes of the blocks cached by threads for their next allocations.
+    uint64_t bytes_thread_cached_;
+    // Bytes of the slabs that were not returned to the OS.
+    uint64_t bytes_committed_;
+    // Number of allocations which used the heap as the slabs were exhausted.
+    uint64_t heap_fallbacks_;
+    // Number of slabs returned to the OS.
+    uint64_t slabs_released_;
+  };
+
+  /**
+   * Enables the allocator. Must be called before threads allocate slices, except for reconfiguring
+   * an enabled allocator.
+   * @param config supplies the configuration of the allocator.
+   * @return false if the address range couldn't be reserved, in which case the allocator is left
+   *         disabled.
+   */
+  static bool configure(const Config& config);
+
+  /**
+   * Disables the allocator. Storage allocated from slabs is still returned to them when freed.
+   */
+  static void disable() { enabled_.store(false, std::memory_order_relaxed); }
+
+  /**
+   * @return a block of BlockSize bytes, or nullptr if the allocator is disabled or its slabs are
+   *         exhausted, in which case the caller should use the heap.
+   */
+  static uint8_t* allocate() {
+    if (!enabled_.load(std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return allocateBlock();
+  }
+
+  /**
+   * @return whether the storage was allocated by allocate().
+   */
+  static bool owns(const uint8_t* storage) {
+    const uint8_t* begin = region_begin_.load(std::memory_order_acquire);
+    return begin != nullptr && storage >= begin &&
+           storage < region_end_.load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Returns a block obtained from allocate(). May be called on any thread.
+   */
+  static void deallocate(uint8_t* storage);
+
+  /**
+   * Returns the blocks cached by the calling thread, and the slabs without any block in use, to the
+   * OS. The other threads return their cache on their next allocation or deallocation.
+   */
+  static void releaseFreeMemory();
+
+  /**
+   * @return a snapshot of the stats of the allocator.
+   */
+  static Stats stats();
+
+private:
+  static uint8_t* allocateBlock();
+
+  static std::atomic<bool> enabled_;
+  static std::atomic<uint8_t*> region_begin_;
+  static std::atomic<uint8_t*> region_end_;
+};
+
+} // namespace Buffer
+} // namespace Envoy
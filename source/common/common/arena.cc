@@ -0,0 +1,37 @@
+#include "source/common/common/arena.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+
+Arena::~Arena() {
+  while (destructors_ != nullptr) {
+    DestructorNodeBase* node = destructors_;
+    destructors_ = node->next_;
+    node->~DestructorNodeBase();
+  }
+}
+
+void* Arena::allocateFromNewBlock(size_t size, size_t alignment) {
+  ASSERT((alignment & (alignment - 1)) == 0);
+  // Allocations larger than the next block get a block of their own, so that a large allocation
+  // does not waste the rest of the current block.
+  const size_t block_size = std::max<size_t>(next_block_size_, size + alignment);
+  blocks_.push_back(std::unique_ptr<char[]>(new char[block_size]));
+  bytes_reserved_ += block_size;
+  next_block_size_ = std::min<uint32_t>(next_block_size_ * 2, MaxBlockSize);
+
+  char* block = blocks_.back().get();
+  const uintptr_t begin = alignUp(reinterpret_cast<uintptr_t>(block), alignment);
+  if (block_size - size - alignment >= static_cast<size_t>(end_ - cursor_)) {
+    // The new block has more room left than the current one, allocate from it from now on.
+    cursor_ = reinterpret_cast<char*>(begin + size);
+    end_ = block + block_size;
+  }
+  ++allocations_;
+  return reinterpret_cast<void*>(begin);
+}
+
+} // namespace Envoy
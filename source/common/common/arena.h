@@ -0,0 +1,138 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Bump allocator whose memory is released all at once, when the arena is destroyed. Allocations
+ * are carved in order from blocks obtained from the heap, which double in size up to
+ * MaxBlockSize, so that a series of small allocations with the same lifetime costs a handful of
+ * heap allocations. No block is allocated until the first allocation.
+ *
+ * The arena is not thread safe.
+ */
+class Arena : NonCopyable {
+public:
+  static constexpr uint32_t DefaultInitialBlockSize = 4096;
+  static constexpr uint32_t MaxBlockSize = 64 * 1024;
+
+  explicit Arena(uint32_t initial_block_size = DefaultInitialBlockSize)
+      : next_block_size_(initial_block_size) {}
+  ~Arena();
+
+  /**
+   * @param size supplies the number of bytes to allocate.
+   * @param alignment supplies the alignment of the allocation, which must be a power of 2.
+   * @return memory which remains valid until the arena is destroyed.
+   */
+  void* allocate(size_t size, size_t alignment = alignof(std::max_align_t)) {
+    const uintptr_t begin = alignUp(reinterpret_cast<uintptr_t>(cursor_), alignment);
+    if (cursor_ == nullptr || begin + size > reinterpret_cast<uintptr_t>(end_)) {
+      return allocateFromNewBlock(size, alignment);
+    }
+    cursor_ = reinterpret_cast<char*>(begin + size);
+    ++allocations_;
+    return reinterpret_cast<void*>(begin);
+  }
+
+  /**
+   * Constructs an object in the arena. Its destructor, if not trivial, runs when the arena is
+   * destroyed, in the reverse order of construction.
+   * @return the object, which remains valid until the arena is destroyed.
+   */
+  template <class T, class... Args> T* create(Args&&... args) {
+    if constexpr (std::is_trivially_destructible_v<T>) {
+      return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    } else {
+      auto* node = new (allocate(sizeof(DestructorNode<T>), alignof(DestructorNode<T>)))
+          DestructorNode<T>(std::forward<Args>(args)...);
+      node->next_ = destructors_;
+      destructors_ = node;
+      return &node->object_;
+    }
+  }
+
+  /**
+   * @return the number of allocations served by the arena.
+   */
+  uint64_t allocations() const { return allocations_; }
+
+  /**
+   * @return the number of blocks the arena obtained from the heap.
+   */
+  uint64_t blocks() const { return blocks_.size(); }
+
+  /**
+   * @return the total size of the blocks the arena obtained from the heap.
+   */
+  uint64_t bytesReserved() const { return bytes_reserved_; }
+
+private:
+  struct DestructorNodeBase {
+    virtual ~DestructorNodeBase() = default;
+    DestructorNodeBase* next_{};
+  };
+  template <class T> struct DestructorNode : public DestructorNodeBase {
+    template <class... Args>
+    explicit DestructorNode(Args&&... args) : object_(std::forward<Args>(args)...) {}
+    T object_;
+  };
+
+  static uintptr_t alignUp(uintptr_t address, size_t alignment) {
+    return (address + alignment - 1) & ~(alignment - 1);
+  }
+  void* allocateFromNewBlock(size_t size, size_t alignment);
+
+  std::vector<std::unique_ptr<char[]>> blocks_;
+  char* cursor_{};
+  char* end_{};
+  uint32_t next_block_size_;
+  uint64_t allocations_{};
+  uint64_t bytes_reserved_{};
+  DestructorNodeBase* destructors_{};
+};
+
+/**
+ * Deleter of the objects allocated by newInArena(), either from the heap or from an Arena, which
+ * lets a std::unique_ptr own them in both cases. Deleting an object allocated from an arena runs
+ * its destructor and leaves its memory to the arena, which must outlive the object. T tells where
+ * it was allocated with bool allocatedFromArena() const, so that the objects allocated from the
+ * heap cost no more than with plain new.
+ */
+template <class T> struct ArenaDeleter {
+  ArenaDeleter() = default;
+  template <class U, class = std::enable_if_t<std::is_convertible_v<U*, T*>>>
+  ArenaDeleter(const ArenaDeleter<U>&) {}
+
+  void operator()(T* object) const {
+    if (object->allocatedFromArena()) {
+      object->~T();
+    } else {
+      delete object;
+    }
+  }
+};
+
+template <class T> using ArenaPtr = std::unique_ptr<T, ArenaDeleter<T>>;
+
+/**
+ * @param arena supplies the arena to allocate from, or nullptr to allocate from the heap.
+ * @return the object, to be owned by an ArenaPtr.
+ */
+template <class T, class... Args> T* newInArena(Arena* arena, Args&&... args) {
+  if (arena == nullptr) {
+    return new T(std::forward<Args>(args)...);
+  }
+  return new (arena->allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+}
+
+} // namespace Envoy
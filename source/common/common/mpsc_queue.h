@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+
+/**
+ * Base class of the elements of an MpscQueue. The queue links its elements through this base, so
+ * that pushing an element doesn't allocate.
+ */
+class MpscQueueNode {
+private:
+  template <class T> friend class MpscQueue;
+
+  std::atomic<MpscQueueNode*> next_{nullptr};
+};
+
+/**
+ * Unbounded, intrusive, lock-free multiple producer single consumer queue, after Dmitry Vyukov's
+ * "Intrusive MPSC node-based queue". Any number of threads may push() concurrently, while only a
+ * single thread at a time may pop(). Elements are popped in the order their push() calls
+ * linearized at, so in particular the elements pushed by one thread are popped in order.
+ *
+ * push() is wait-free. pop() is lock-free, but may return nullptr while a push() running
+ * concurrently on another thread has not finished linking its element yet, even though elements
+ * pushed later on other threads are already queued. Callers need to retry later in that case.
+ */
+template <class T> class MpscQueue : NonCopyable {
+public:
+  MpscQueue() : head_(&stub_), tail_(&stub_) {}
+
+  ~MpscQueue() {
+    // Pushes can't race with the destruction, so all elements are fully linked.
+    while (pop() != nullptr) {
+    }
+  }
+
+  /**
+   * Appends an element to the queue. May be called from any thread.
+   */
+  void push(std::unique_ptr<T> element) { pushNode(element.release()); }
+
+  /**
+   * Removes the oldest element from the queue. May only be called from one thread at a time.
+   * @return the oldest element, or nullptr if the queue is empty or its oldest element is still
+   *         being pushed.
+   */
+  std::unique_ptr<T> pop() {
+    MpscQueueNode* tail = tail_;
+    MpscQueueNode* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        return nullptr;
+      }
+      // Skip the stub.
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return std::unique_ptr<T>(static_cast<T*>(tail));
+    }
+    if (tail != head_.load(std::memory_order_acquire)) {
+      // A producer swapped the head, but hasn't linked its element to tail yet.
+      return nullptr;
+    }
+    // tail is the last element. It can only be unlinked once it has a successor, which is what the
+    // stub is for.
+    pushNode(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return std::unique_ptr<T>(static_cast<T*>(tail));
+    }
+    return nullptr;
+  }
+
+private:
+  void pushNode(MpscQueueNode* node) {
+    node->next_.store(nullptr, std::memory_order_relaxed);
+    MpscQueueNode* prev = head_.exchange(node, std::memory_order_acq_rel);
+    // Between the exchange and this store the queue is disconnected, see pop().
+    prev->next_.store(node, std::memory_order_release);
+  }
+
+  // The producers and the consumer each work on their own end of the queue, which live on
+  // separate cache lines to avoid false sharing.
+  alignas(64) std::atomic<MpscQueueNode*> head_;
+  alignas(64) MpscQueueNode* tail_;
+  MpscQueueNode stub_;
+};
+
+} // namespace Envoy
@@ -196,7 +196,7 @@ void ConnPoolImplBase::attachStreamToClient(Envoy::ConnectionPool::ActiveClient&
   state_.incrActiveStreams(1);
   num_active_streams_++;
   host_->stats().rq_total_.inc();
-  host_->stats().rq_active_.inc();
+  host_->activeRequests().inc();
   host_->cluster().stats().upstream_rq_total_.inc();
   host_->cluster().stats().upstream_rq_active_.inc();
   host_->cluster().resourceManager(priority_).requests().inc();
@@ -212,7 +212,7 @@ void ConnPoolImplBase::onStreamClosed(Envoy::ConnectionPool::ActiveClient& clien
   bool had_negative_capacity = client.hadNegativeDeltaOnStreamClosed();
   state_.decrActiveStreams(1);
   num_active_streams_--;
-  host_->stats().rq_active_.dec();
+  host_->activeRequests().dec();
   host_->cluster().stats().upstream_rq_active_.dec();
   host_->cluster().resourceManager(priority_).requests().dec();
   // If the effective client capacity was limited by concurrency, increase connecting capacity.
@@ -238,12 +238,10 @@ SignalEventPtr DispatcherImpl::listenForSignal(signal_t signal_num, SignalCb cb)
 }
 
 void DispatcherImpl::post(std::function<void()> callback) {
-  bool do_post;
-  {
-    Thread::LockGuard lock(post_lock_);
-    do_post = post_callbacks_.empty();
-    post_callbacks_.push_back(callback);
-  }
+  // Count the callback before queueing it, so that runPostCallbacks() never misses a queued
+  // callback when it decides whether to run again.
+  const bool do_post = post_callbacks_pending_.fetch_add(1, std::memory_order_acq_rel) == 0;
+  post_callbacks_.push(std::make_unique<PostCallback>(std::move(callback)));
 
   if (do_post) {
     post_cb_->scheduleCallbackCurrentIteration();
@@ -285,11 +283,7 @@ void DispatcherImpl::shutdown() {
   // callbacks and dispatcher thread deletable objects.
   ASSERT(isThreadSafe());
   auto deferred_deletables_size = current_to_delete_->size();
-  std::list<std::function<void()>>::size_type post_callbacks_size;
-  {
-    Thread::LockGuard lock(post_lock_);
-    post_callbacks_size = post_callbacks_.size();
-  }
+  const uint64_t post_callbacks_size = post_callbacks_pending_.load(std::memory_order_acquire);
 
   std::list<DispatcherThreadDeletableConstPtr> local_deletables;
   {
@@ -335,27 +329,37 @@ void DispatcherImpl::runPostCallbacks() {
   // objects that is being deferred deleted.
   clearDeferredDeleteList();
 
-  std::list<std::function<void()>> callbacks;
-  {
-    // Take ownership of the callbacks under the post_lock_. The lock must be released before
-    // callbacks execute. Callbacks added after this transfer will re-arm post_cb_ and will execute
-    // later in the event loop.
-    Thread::LockGuard lock(post_lock_);
-    callbacks = std::move(post_callbacks_);
-    // post_callbacks_ should be empty after the move.
-    ASSERT(post_callbacks_.empty());
-  }
-  // It is important that the execution and deletion of the callback happen while post_lock_ is not
-  // held. Either the invocation or destructor of the callback can call post() on this dispatcher.
-  while (!callbacks.empty()) {
+  // Run the callbacks posted so far as one batch. Callbacks posted while the batch runs, e.g. by
+  // the callbacks themselves, run in the next batch later in the event loop.
+  const uint64_t batch_size = post_callbacks_pending_.load(std::memory_order_acquire);
+  uint64_t callbacks_run = 0;
+  bool incomplete = false;
+  while (callbacks_run < batch_size) {
+    std::unique_ptr<PostCallback> callback = post_callbacks_.pop();
+    if (callback == nullptr) {
+      // A post() on another thread has not finished queueing its callback yet.
+      incomplete = true;
+      break;
+    }
     // Touch the watchdog before executing the callback to avoid spurious watchdog miss events when
     // executing a long list of callbacks.
     touchWatchdog();
     // Run the callback.
-    callbacks.front()();
-    // Pop the front so that the destructor of the callback that just executed runs before the next
-    // callback executes.
-    callbacks.pop_front();
+    callback->callback_();
+    // Destroy the callback that just executed before the next callback executes.
+    callback.reset();
+    ++callbacks_run;
+  }
+
+  if (post_callbacks_pending_.fetch_sub(callbacks_run, std::memory_order_acq_rel) !=
+      callbacks_run) {
+    // Callbacks posted since the batch started did not schedule post_cb_, as the count was not
+    // zero. If a callback is still being queued, give its producer time to finish.
+    if (incomplete) {
+      post_cb_->scheduleCallbackNextIteration();
+    } else {
+      post_cb_->scheduleCallbackCurrentIteration();
+    }
   }
 }
 
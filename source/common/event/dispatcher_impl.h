@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -15,6 +16,7 @@
 #include "envoy/stats/scope.h"
 
 #include "source/common/common/logger.h"
+#include "source/common/common/mpsc_queue.h"
 #include "source/common/common/thread.h"
 #include "source/common/event/libevent.h"
 #include "source/common/event/libevent_scheduler.h"
@@ -125,6 +127,14 @@ private:
   };
   using WatchdogRegistrationPtr = std::unique_ptr<WatchdogRegistration>;
 
+  // A callback queued by post(). The callback is moved into the queue element, so that posting
+  // allocates once, and small callbacks are stored inline by std::function.
+  struct PostCallback : public MpscQueueNode {
+    explicit PostCallback(PostCb&& callback) : callback_(std::move(callback)) {}
+
+    PostCb callback_;
+  };
+
   TimerPtr createTimerInternal(TimerCb cb);
   void updateApproximateMonotonicTimeInternal();
   void runPostCallbacks();
@@ -159,8 +169,10 @@ private:
   SchedulableCallbackPtr deferred_delete_cb_;
 
   SchedulableCallbackPtr post_cb_;
-  Thread::MutexBasicLockable post_lock_;
-  std::list<std::function<void()>> post_callbacks_ ABSL_GUARDED_BY(post_lock_);
+  MpscQueue<PostCallback> post_callbacks_;
+  // The number of callbacks posted but not run yet. The thread incrementing it from zero schedules
+  // post_cb_.
+  std::atomic<uint64_t> post_callbacks_pending_{0};
 
   std::vector<DeferredDeletablePtr> to_delete_1_;
   std::vector<DeferredDeletablePtr> to_delete_2_;
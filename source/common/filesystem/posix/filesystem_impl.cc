@@ -111,6 +111,10 @@ ssize_t InstanceImplPosix::fileSize(const std::string& path) {
   return info.st_size;
 }
 
+bool InstanceImplPosix::moveFile(const std::string& from_path, const std::string& to_path) {
+  return ::rename(from_path.c_str(), to_path.c_str()) == 0;
+}
+
 std::string InstanceImplPosix::fileReadToEnd(const std::string& path) {
   if (illegalPath(path)) {
     throw EnvoyException(absl::StrCat("Invalid path: ", path));
@@ -37,6 +37,7 @@ public:
   bool fileExists(const std::string& path) override;
   bool directoryExists(const std::string& path) override;
   ssize_t fileSize(const std::string& path) override;
+  bool moveFile(const std::string& from_path, const std::string& to_path) override;
   std::string fileReadToEnd(const std::string& path) override;
   PathSplitResult splitPathFromFilename(absl::string_view path) override;
   bool illegalPath(const std::string& path) override;
@@ -128,6 +128,11 @@ ssize_t InstanceImplWin32::fileSize(const std::string& path) {
   return result;
 }
 
+bool InstanceImplWin32::moveFile(const std::string& from_path, const std::string& to_path) {
+  // ::rename doesn't replace an existing file on Windows.
+  return ::MoveFileEx(from_path.c_str(), to_path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
 std::string InstanceImplWin32::fileReadToEnd(const std::string& path) {
   if (illegalPath(path)) {
     throw EnvoyException(absl::StrCat("Invalid path: ", path));
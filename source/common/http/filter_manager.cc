@@ -50,6 +50,8 @@ void recordLatestDataFilter(const typename FilterList<T>::iterator current_filte
 
 } // namespace
 
+bool ActiveStreamFilterBase::allocatedFromArena() const { return parent_.use_arena_; }
+
 void ActiveStreamFilterBase::commonContinue() {
   // TODO(mattklein123): Raise an error if this is called during a callback.
   if (!canContinue()) {
@@ -452,8 +454,8 @@ void ActiveStreamDecoderFilter::requestDataTooLarge() {
 void FilterManager::addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr filter,
                                                  FilterMatchStateSharedPtr match_state,
                                                  bool dual_filter) {
-  ActiveStreamDecoderFilterPtr wrapper(
-      new ActiveStreamDecoderFilter(*this, filter, match_state, dual_filter));
+  ActiveStreamDecoderFilterPtr wrapper(newInArena<ActiveStreamDecoderFilter>(
+      wrapperArena(), *this, filter, match_state, dual_filter));
 
   // If we're a dual handling filter, have the encoding wrapper be the only thing registering itself
   // as the handling filter.
@@ -476,8 +478,8 @@ void FilterManager::addStreamDecoderFilterWorker(StreamDecoderFilterSharedPtr fi
 void FilterManager::addStreamEncoderFilterWorker(StreamEncoderFilterSharedPtr filter,
                                                  FilterMatchStateSharedPtr match_state,
                                                  bool dual_filter) {
-  ActiveStreamEncoderFilterPtr wrapper(
-      new ActiveStreamEncoderFilter(*this, filter, match_state, dual_filter));
+  ActiveStreamEncoderFilterPtr wrapper(newInArena<ActiveStreamEncoderFilter>(
+      wrapperArena(), *this, filter, match_state, dual_filter));
 
   if (match_state) {
     match_state->filter_ = filter.get();
@@ -16,6 +16,7 @@
 #include "envoy/type/matcher/v3/http_inputs.pb.validate.h"
 
 #include "source/common/buffer/watermark_buffer.h"
+#include "source/common/common/arena.h"
 #include "source/common/common/dump_state_utils.h"
 #include "source/common/common/linked_object.h"
 #include "source/common/common/logger.h"
@@ -26,6 +27,7 @@
 #include "source/common/local_reply/local_reply.h"
 #include "source/common/matcher/matcher.h"
 #include "source/common/protobuf/utility.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/stream_info/stream_info_impl.h"
 
 namespace Envoy {
@@ -130,6 +132,9 @@ struct ActiveStreamFilterBase : public virtual StreamFilterCallbacks,
 
   virtual void onMatchCallback(const Matcher::Action& action) PURE;
 
+  // Whether the wrapper was allocated from the arena of the stream. @see ArenaDeleter.
+  bool allocatedFromArena() const;
+
   // Http::StreamFilterCallbacks
   const Network::Connection* connection() override;
   Event::Dispatcher& dispatcher() override;
@@ -302,7 +307,7 @@ struct ActiveStreamDecoderFilter : public ActiveStreamFilterBase,
   bool is_grpc_request_{};
 };
 
-using ActiveStreamDecoderFilterPtr = std::unique_ptr<ActiveStreamDecoderFilter>;
+using ActiveStreamDecoderFilterPtr = ArenaPtr<ActiveStreamDecoderFilter>;
 
 /**
  * Wrapper for a stream encoder filter.
@@ -359,7 +364,7 @@ struct ActiveStreamEncoderFilter : public ActiveStreamFilterBase,
   StreamEncoderFilterSharedPtr handle_;
 };
 
-using ActiveStreamEncoderFilterPtr = std::unique_ptr<ActiveStreamEncoderFilter>;
+using ActiveStreamEncoderFilterPtr = ArenaPtr<ActiveStreamEncoderFilter>;
 
 /**
  * Callbacks invoked by the FilterManager to pass filter data/events back to the caller.
@@ -665,7 +670,9 @@ public:
                 StreamInfo::FilterState::LifeSpan filter_state_life_span)
       : filter_manager_callbacks_(filter_manager_callbacks), dispatcher_(dispatcher),
         connection_(connection), stream_id_(stream_id), account_(std::move(account)),
-        proxy_100_continue_(proxy_100_continue), buffer_limit_(buffer_limit),
+        proxy_100_continue_(proxy_100_continue),
+        use_arena_(Runtime::runtimeFeatureEnabled("envoy.reloadable_features.http_stream_arena")),
+        arena_(arenaBlockSize(filter_chain_factory)), buffer_limit_(buffer_limit),
         filter_chain_factory_(filter_chain_factory), local_reply_(local_reply),
         stream_info_(protocol, time_source, connection.connectionInfoProviderSharedPtr(),
                      parent_filter_state, filter_state_life_span) {}
@@ -921,6 +928,7 @@ public:
   // TODO(snowp): This should probably return a StreamInfo instead of the impl.
   StreamInfo::StreamInfoImpl& streamInfo() { return stream_info_; }
   const StreamInfo::StreamInfoImpl& streamInfo() const { return stream_info_; }
+  const Arena& arena() const { return arena_; }
   void setDownstreamRemoteAddress(
       const Network::Address::InstanceConstSharedPtr& downstream_remote_address) {
     stream_info_.setDownstreamRemoteAddress(downstream_remote_address);
@@ -995,6 +1003,23 @@ private:
   bool handleDataIfStopAll(ActiveStreamFilterBase& filter, Buffer::Instance& data,
                            bool& filter_streaming);
 
+  // @return the arena to allocate the filter wrappers from, or nullptr to use the heap.
+  Arena* wrapperArena() { return use_arena_ ? &arena_ : nullptr; }
+
+  // @return the size of the first block of the arena, fitting the wrappers of the filter chain
+  // when its length is known, so that a stream allocates a single block of the size it needs.
+  static uint32_t arenaBlockSize(const FilterChainFactory& filter_chain_factory) {
+    const uint32_t filters = filter_chain_factory.filterChainLengthHint();
+    if (filters == 0) {
+      return Arena::DefaultInitialBlockSize;
+    }
+    // Each filter may be both a decoder and an encoder filter.
+    return std::min<uint64_t>(filters * (sizeof(ActiveStreamDecoderFilter) +
+                                         sizeof(ActiveStreamEncoderFilter) +
+                                         2 * alignof(std::max_align_t)),
+                              Arena::MaxBlockSize);
+  }
+
   MetadataMapVector* getRequestMetadataMapVector() {
     if (request_metadata_map_vector_ == nullptr) {
       request_metadata_map_vector_ = std::make_unique<MetadataMapVector>();
@@ -1009,6 +1034,10 @@ private:
   Buffer::BufferMemoryAccountSharedPtr account_;
   const bool proxy_100_continue_;
 
+  // When envoy.reloadable_features.http_stream_arena is enabled, the filter wrappers are allocated
+  // from the arena, which must be declared before the filter lists so that it outlives them.
+  const bool use_arena_;
+  Arena arena_;
   std::list<ActiveStreamDecoderFilterPtr> decoder_filters_;
   std::list<ActiveStreamEncoderFilterPtr> encoder_filters_;
   std::list<StreamFilterBase*> filters_;
@@ -197,14 +197,14 @@ template <> bool HeaderMapImpl::HeaderList::isPseudoHeader(const LowerCaseString
 
 bool HeaderMapImpl::HeaderList::maybeMakeMap() {
   if (lazy_map_.empty()) {
-    if (headers_.size() < lazy_map_min_size_) {
+    if (size() < lazy_map_min_size_) {
       return false;
     }
     // Add all entries from the list into the map.
-    for (auto node = headers_.begin(); node != headers_.end(); ++node) {
-      HeaderNodeVector& v = lazy_map_[node->key().getStringView()];
-      v.push_back(node);
-    }
+    forEach([this](HeaderEntryImpl& entry) {
+      lazy_map_[entry.key().getStringView()].push_back(&entry);
+      return true;
+    });
   }
   return true;
 }
@@ -220,23 +220,101 @@ size_t HeaderMapImpl::HeaderList::remove(absl::string_view key) {
       for (const HeaderNode& node : header_nodes) {
         ASSERT(node->key() == key);
         removed_bytes += node->key().size() + node->value().size();
-        erase(node, false /* remove_from_map */);
+        erase(*node, false /* remove_from_map */);
       }
     }
   } else {
     // Erase all same key entries from the list.
-    for (auto i = headers_.begin(); i != headers_.end();) {
-      if (i->key() == key) {
-        removed_bytes += i->key().size() + i->value().size();
-        i = erase(i, false /* remove_from_map */);
-      } else {
-        ++i;
+    removeIf([key, &removed_bytes](const HeaderEntryImpl& entry) {
+      if (entry.key() == key) {
+        removed_bytes += entry.key().size() + entry.value().size();
+        return true;
       }
-    }
+      return false;
+    });
   }
   return removed_bytes;
 }
 
+void HeaderMapImpl::HeaderList::eraseEntry(HeaderEntryImpl& entry) {
+  if (layout_ == Layout::List) {
+    if (pseudo_headers_end_ == entry.entry_) {
+      pseudo_headers_end_++;
+    }
+    headers_.erase(entry.entry_);
+    return;
+  }
+  std::vector<HeaderEntryImpl*>& order = isPseudoHeader(entry.key()) ? pseudo_entries_ : entries_;
+  ASSERT(order[entry.slot_] == &entry);
+  order[entry.slot_] = nullptr;
+  ++tombstones_;
+  --contiguous_size_;
+  arena_.release(entry);
+}
+
+void HeaderMapImpl::HeaderList::maybeCompact() {
+  if (tombstones_ < MinTombstonesToCompact || tombstones_ < contiguous_size_) {
+    return;
+  }
+  for (std::vector<HeaderEntryImpl*>* order : {&pseudo_entries_, &entries_}) {
+    uint32_t live = 0;
+    for (HeaderEntryImpl* entry : *order) {
+      if (entry != nullptr) {
+        entry->slot_ = live;
+        (*order)[live++] = entry;
+      }
+    }
+    order->resize(live);
+  }
+  tombstones_ = 0;
+}
+
+void HeaderMapImpl::HeaderList::destroyContiguousEntries() {
+  if (layout_ != Layout::Contiguous) {
+    return;
+  }
+  forEach([](HeaderEntryImpl& entry) {
+    entry.~HeaderEntryImpl();
+    return true;
+  });
+  arena_.reset();
+  pseudo_entries_.clear();
+  entries_.clear();
+  contiguous_size_ = 0;
+  tombstones_ = 0;
+}
+
+HeaderMapImpl::HeaderArena::Slot* HeaderMapImpl::HeaderArena::nextSlot() {
+  if (free_list_ != nullptr) {
+    Slot* slot = free_list_;
+    free_list_ = slot->next_free_;
+    return slot;
+  }
+  if (!blocks_.empty() && current_block_used_ == blocks_[current_block_].capacity_) {
+    ++current_block_;
+    current_block_used_ = 0;
+  }
+  if (current_block_ == blocks_.size()) {
+    const uint32_t capacity = blocks_.empty() ? InitialBlockCapacity : blocks_.back().capacity_ * 2;
+    // The slots are left uninitialized, the entries are constructed in place.
+    blocks_.push_back({std::unique_ptr<Slot[]>(new Slot[capacity]), capacity});
+  }
+  return &blocks_[current_block_].slots_[current_block_used_++];
+}
+
+void HeaderMapImpl::HeaderArena::release(HeaderEntryImpl& entry) {
+  entry.~HeaderEntryImpl();
+  Slot* slot = reinterpret_cast<Slot*>(&entry);
+  slot->next_free_ = free_list_;
+  free_list_ = slot;
+}
+
+void HeaderMapImpl::HeaderArena::reset() {
+  current_block_ = 0;
+  current_block_used_ = 0;
+  free_list_ = nullptr;
+}
+
 HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key) : key_(key) {}
 
 HeaderMapImpl::HeaderEntryImpl::HeaderEntryImpl(const LowerCaseString& key, HeaderString&& value)
@@ -358,15 +436,15 @@ bool HeaderMapImpl::operator==(const HeaderMap& rhs) const {
   rhs_headers.reserve(rhs.size());
   rhs.iterate(collectAllHeaders(&rhs_headers));
 
-  auto i = headers_.begin();
+  bool equal = true;
   auto j = rhs_headers.begin();
-  for (; i != headers_.end(); ++i, ++j) {
-    if (i->key() != j->first || i->value() != j->second) {
-      return false;
-    }
-  }
+  headers_.forEach([&equal, &j](const HeaderEntryImpl& header) {
+    equal = header.key() == j->first && header.value() == j->second;
+    ++j;
+    return equal;
+  });
 
-  return true;
+  return equal;
 }
 
 bool HeaderMapImpl::operator!=(const HeaderMap& rhs) const { return !operator==(rhs); }
@@ -387,8 +465,7 @@ void HeaderMapImpl::insertByKey(HeaderString&& key, HeaderString&& value) {
     }
   } else {
     addSize(key.size() + value.size());
-    HeaderNode i = headers_.insert(std::move(key), std::move(value));
-    i->entry_ = i;
+    headers_.insert(std::move(key), std::move(value));
   }
 }
 
@@ -474,10 +551,11 @@ uint64_t HeaderMapImpl::byteSize() const { return cached_byte_size_; }
 void HeaderMapImpl::verifyByteSizeInternalForTest() const {
   // Computes the total byte size by summing the byte size of the keys and values.
   uint64_t byte_size = 0;
-  for (const HeaderEntryImpl& header : headers_) {
+  headers_.forEach([&byte_size](const HeaderEntryImpl& header) {
     byte_size += header.key().size();
     byte_size += header.value().size();
-  }
+    return true;
+  });
   ASSERT(cached_byte_size_ == byte_size);
 }
 
@@ -506,9 +584,8 @@ HeaderMap::NonConstGetResult HeaderMapImpl::getExisting(absl::string_view key) {
     if (iter != headers_.mapEnd()) {
       const HeaderList::HeaderNodeVector& v = iter->second;
       ASSERT(!v.empty()); // It's impossible to have a map entry with an empty vector as its value.
-      for (const auto& values_it : v) {
-        // Convert the iterated value to a HeaderEntry*.
-        ret.push_back(&(*values_it));
+      for (HeaderNode node : v) {
+        ret.push_back(node);
       }
     }
     return ret;
@@ -517,29 +594,26 @@ HeaderMap::NonConstGetResult HeaderMapImpl::getExisting(absl::string_view key) {
   // If the requested header is not an O(1) header and the lazy map is not in use, we do a full
   // scan. Doing the trie lookup is wasteful in the miss case, but is present for code consistency
   // with other functions that do similar things.
-  for (HeaderEntryImpl& header : headers_) {
+  headers_.forEach([&ret, key](HeaderEntryImpl& header) {
     if (header.key() == key) {
       ret.push_back(&header);
     }
-  }
+    return true;
+  });
 
   return ret;
 }
 
 void HeaderMapImpl::iterate(HeaderMap::ConstIterateCb cb) const {
-  for (const HeaderEntryImpl& header : headers_) {
-    if (cb(header) == HeaderMap::Iterate::Break) {
-      break;
-    }
-  }
+  headers_.forEach([&cb](const HeaderEntryImpl& header) {
+    return cb(header) == HeaderMap::Iterate::Continue;
+  });
 }
 
 void HeaderMapImpl::iterateReverse(HeaderMap::ConstIterateCb cb) const {
-  for (auto it = headers_.rbegin(); it != headers_.rend(); it++) {
-    if (cb(*it) == HeaderMap::Iterate::Break) {
-      break;
-    }
-  }
+  headers_.forEachReverse([&cb](const HeaderEntryImpl& header) {
+    return cb(header) == HeaderMap::Iterate::Continue;
+  });
 }
 
 void HeaderMapImpl::clear() {
@@ -596,9 +670,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
   }
 
   addSize(key.get().size());
-  HeaderNode i = headers_.insert(key);
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.insert(key);
   return **entry;
 }
 
@@ -611,9 +683,7 @@ HeaderMapImpl::HeaderEntryImpl& HeaderMapImpl::maybeCreateInline(HeaderEntryImpl
   }
 
   addSize(key.get().size() + value.size());
-  HeaderNode i = headers_.insert(key, std::move(value));
-  i->entry_ = i;
-  *entry = &(*i);
+  *entry = &headers_.insert(key, std::move(value));
   return **entry;
 }
 
@@ -634,10 +704,10 @@ size_t HeaderMapImpl::removeInline(HeaderEntryImpl** ptr_to_entry) {
   }
 
   HeaderEntryImpl* entry = *ptr_to_entry;
-  const uint64_t size_to_subtract = entry->entry_->key().size() + entry->entry_->value().size();
+  const uint64_t size_to_subtract = entry->key().size() + entry->value().size();
   subtractSize(size_to_subtract);
   *ptr_to_entry = nullptr;
-  headers_.erase(entry->entry_, true);
+  headers_.erase(*entry, true);
   return 1;
 }
 
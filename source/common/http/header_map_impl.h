@@ -4,8 +4,10 @@
 #include <cstdint>
 #include <list>
 #include <memory>
+#include <new>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 #include "envoy/common/optref.h"
 #include "envoy/http/header_map.h"
@@ -122,9 +124,12 @@ protected:
 
     HeaderString key_;
     HeaderString value_;
+    // The position of the entry in the list, with HeaderList::Layout::List.
     std::list<HeaderEntryImpl>::iterator entry_;
+    // The position of the entry in its order vector, with HeaderList::Layout::Contiguous.
+    uint32_t slot_{};
   };
-  using HeaderNode = std::list<HeaderEntryImpl>::iterator;
+  using HeaderNode = HeaderEntryImpl*;
 
   /**
    * This is the static lookup table that is used to determine whether a header is one of the O(1)
@@ -178,6 +183,49 @@ protected:
     size_t size_;
   };
 
+  /**
+   * Storage for the HeaderEntryImpl of a HeaderList using the contiguous layout. Entries are
+   * constructed in place in blocks of doubling capacity. Blocks are never moved or freed before the
+   * arena is destroyed, so an entry keeps its address until it is released. The slots of the
+   * released entries are reused by the following allocations.
+   */
+  class HeaderArena : NonCopyable {
+  public:
+    template <class... Args> HeaderEntryImpl& allocate(Args&&... args) {
+      return *new (nextSlot()) HeaderEntryImpl(std::forward<Args>(args)...);
+    }
+
+    /**
+     * Destroys an entry and makes its slot available for reuse.
+     */
+    void release(HeaderEntryImpl& entry);
+
+    /**
+     * Makes all the slots available for reuse. The entries must have been destroyed already.
+     */
+    void reset();
+
+  private:
+    static constexpr uint32_t InitialBlockCapacity = 4;
+
+    union Slot {
+      Slot* next_free_;
+      alignas(HeaderEntryImpl) char storage_[sizeof(HeaderEntryImpl)];
+    };
+    struct Block {
+      std::unique_ptr<Slot[]> slots_;
+      uint32_t capacity_;
+    };
+
+    Slot* nextSlot();
+
+    std::vector<Block> blocks_;
+    // The block slots are bumped from and the number of its slots in use.
+    uint32_t current_block_{};
+    uint32_t current_block_used_{};
+    Slot* free_list_{};
+  };
+
   /**
    * List of HeaderEntryImpl that keeps the pseudo headers (key starting with ':') in the front
    * of the list (as required by nghttp2) and otherwise maintains insertion order.
@@ -186,6 +234,16 @@ protected:
    * fast access given a header key. Once the map is initialized, it will be used even if the number
    * of headers decreases below the threshold.
    *
+   * The entries are stored according to one of two layouts, chosen when the list is created:
+   * - List: each entry is a node of a std::list, which is a heap allocation per header.
+   * - Contiguous: when envoy.reloadable_features.header_map_contiguous_storage is enabled, the
+   *   entries are allocated from a HeaderArena owned by the list, and their order is kept in two
+   *   vectors of pointers, one for the pseudo headers and one for the other headers. Removing an
+   *   entry leaves a tombstone (nullptr) in its order vector, which is skipped when iterating and
+   *   reclaimed by compacting the vectors once tombstones outnumber the entries.
+   * In both layouts, a HeaderEntryImpl keeps its address until it is removed, so the inline header
+   * pointers and the lazy map can refer to entries directly.
+   *
    * Note: the internal iterators held in fields make this unsafe to copy and move, since the
    * reference to end() is not preserved across a move (see Notes in
    * https://en.cppreference.com/w/cpp/container/list/list). The NonCopyable will suppress both copy
@@ -195,39 +253,55 @@ protected:
    */
   class HeaderList : NonCopyable {
   public:
+    enum class Layout { List, Contiguous };
+
     using HeaderNodeVector = absl::InlinedVector<HeaderNode, 1>;
     using HeaderLazyMap = absl::flat_hash_map<absl::string_view, HeaderNodeVector>;
 
     HeaderList()
-        : pseudo_headers_end_(headers_.end()),
+        : layout_(Runtime::runtimeFeatureEnabled(
+                      "envoy.reloadable_features.header_map_contiguous_storage")
+                      ? Layout::Contiguous
+                      : Layout::List),
+          pseudo_headers_end_(headers_.end()),
           lazy_map_min_size_(static_cast<uint32_t>(
               Runtime::getInteger("envoy.http.headermap.lazy_map_min_size", 3))) {}
+    ~HeaderList() { destroyContiguousEntries(); }
 
     template <class Key> bool isPseudoHeader(const Key& key) {
       return !key.getStringView().empty() && key.getStringView()[0] == ':';
     }
 
-    template <class Key, class... Value> HeaderNode insert(Key&& key, Value&&... value) {
+    template <class Key, class... Value> HeaderEntryImpl& insert(Key&& key, Value&&... value) {
       const bool is_pseudo_header = isPseudoHeader(key);
-      HeaderNode i = headers_.emplace(is_pseudo_header ? pseudo_headers_end_ : headers_.end(),
-                                      std::forward<Key>(key), std::forward<Value>(value)...);
-      if (!lazy_map_.empty()) {
-        lazy_map_[i->key().getStringView()].push_back(i);
+      HeaderEntryImpl* entry;
+      if (layout_ == Layout::List) {
+        auto i = headers_.emplace(is_pseudo_header ? pseudo_headers_end_ : headers_.end(),
+                                  std::forward<Key>(key), std::forward<Value>(value)...);
+        i->entry_ = i;
+        if (!is_pseudo_header && pseudo_headers_end_ == headers_.end()) {
+          pseudo_headers_end_ = i;
+        }
+        entry = &(*i);
+      } else {
+        maybeCompact();
+        entry = &arena_.allocate(std::forward<Key>(key), std::forward<Value>(value)...);
+        std::vector<HeaderEntryImpl*>& order = is_pseudo_header ? pseudo_entries_ : entries_;
+        entry->slot_ = static_cast<uint32_t>(order.size());
+        order.push_back(entry);
+        ++contiguous_size_;
       }
-      if (!is_pseudo_header && pseudo_headers_end_ == headers_.end()) {
-        pseudo_headers_end_ = i;
+      if (!lazy_map_.empty()) {
+        lazy_map_[entry->key().getStringView()].push_back(entry);
       }
-      return i;
+      return *entry;
     }
 
-    HeaderNode erase(HeaderNode i, bool remove_from_map) {
-      if (pseudo_headers_end_ == i) {
-        pseudo_headers_end_++;
-      }
+    void erase(HeaderEntryImpl& entry, bool remove_from_map) {
       if (remove_from_map) {
-        lazy_map_.erase(i->key().getStringView());
+        lazy_map_.erase(entry.key().getStringView());
       }
-      return headers_.erase(i);
+      eraseEntry(entry);
     }
 
     template <class UnaryPredicate> void removeIf(UnaryPredicate p) {
@@ -242,13 +316,10 @@ protected:
           // The call to erase that follows erases the unneeded cells (from remove_pos to the
           // end) and modifies the vector's size.
           const auto remove_pos =
-              std::remove_if(values_vec.begin(), values_vec.end(), [&](HeaderNode it) {
-                if (p(*(it->entry_))) {
+              std::remove_if(values_vec.begin(), values_vec.end(), [&](HeaderNode entry) {
+                if (p(*entry)) {
                   // Remove the element from the list.
-                  if (pseudo_headers_end_ == it->entry_) {
-                    pseudo_headers_end_++;
-                  }
-                  headers_.erase(it);
+                  eraseEntry(*entry);
                   return true;
                 }
                 return false;
@@ -262,7 +333,7 @@ protected:
             map_it++;
           }
         }
-      } else {
+      } else if (layout_ == Layout::List) {
         // The lazy map isn't used, iterate over the list elements and remove elements that satisfy
         // the predicate.
         headers_.remove_if([&](const HeaderEntryImpl& entry) {
@@ -274,6 +345,16 @@ protected:
           }
           return to_remove;
         });
+      } else {
+        // The lazy map isn't used, iterate over the order vectors and replace the elements that
+        // satisfy the predicate with tombstones.
+        for (std::vector<HeaderEntryImpl*>* order : {&pseudo_entries_, &entries_}) {
+          for (HeaderEntryImpl* entry : *order) {
+            if (entry != nullptr && p(*entry)) {
+              eraseEntry(*entry);
+            }
+          }
+        }
       }
     }
 
@@ -292,25 +373,82 @@ protected:
      */
     size_t remove(absl::string_view key);
 
-    std::list<HeaderEntryImpl>::iterator begin() { return headers_.begin(); }
-    std::list<HeaderEntryImpl>::iterator end() { return headers_.end(); }
-    std::list<HeaderEntryImpl>::const_iterator begin() const { return headers_.begin(); }
-    std::list<HeaderEntryImpl>::const_iterator end() const { return headers_.end(); }
-    std::list<HeaderEntryImpl>::const_reverse_iterator rbegin() const { return headers_.rbegin(); }
-    std::list<HeaderEntryImpl>::const_reverse_iterator rend() const { return headers_.rend(); }
+    /**
+     * Calls cb with each entry, in order, until it returns false.
+     */
+    template <class Callback> void forEach(Callback cb) {
+      if (layout_ == Layout::List) {
+        for (HeaderEntryImpl& entry : headers_) {
+          if (!cb(entry)) {
+            return;
+          }
+        }
+        return;
+      }
+      for (const std::vector<HeaderEntryImpl*>* order : {&pseudo_entries_, &entries_}) {
+        for (HeaderEntryImpl* entry : *order) {
+          if (entry != nullptr && !cb(*entry)) {
+            return;
+          }
+        }
+      }
+    }
+    template <class Callback> void forEach(Callback cb) const {
+      const_cast<HeaderList*>(this)->forEach(
+          [&cb](HeaderEntryImpl& entry) { return cb(static_cast<const HeaderEntryImpl&>(entry)); });
+    }
+
+    /**
+     * Calls cb with each entry, in reverse order, until it returns false.
+     */
+    template <class Callback> void forEachReverse(Callback cb) const {
+      if (layout_ == Layout::List) {
+        for (auto it = headers_.rbegin(); it != headers_.rend(); ++it) {
+          if (!cb(*it)) {
+            return;
+          }
+        }
+        return;
+      }
+      for (const std::vector<HeaderEntryImpl*>* order : {&entries_, &pseudo_entries_}) {
+        for (auto it = order->rbegin(); it != order->rend(); ++it) {
+          if (*it != nullptr && !cb(static_cast<const HeaderEntryImpl&>(**it))) {
+            return;
+          }
+        }
+      }
+    }
+
     HeaderLazyMap::iterator mapFind(absl::string_view key) { return lazy_map_.find(key); }
     HeaderLazyMap::iterator mapEnd() { return lazy_map_.end(); }
-    size_t size() const { return headers_.size(); }
-    bool empty() const { return headers_.empty(); }
+    size_t size() const { return layout_ == Layout::List ? headers_.size() : contiguous_size_; }
+    bool empty() const { return size() == 0; }
     void clear() {
       headers_.clear();
       pseudo_headers_end_ = headers_.end();
+      destroyContiguousEntries();
       lazy_map_.clear();
     }
 
   private:
+    // The number of tombstones the order vectors are allowed to hold before being compacted, when
+    // they outnumber the entries.
+    static constexpr uint32_t MinTombstonesToCompact = 8;
+
+    void eraseEntry(HeaderEntryImpl& entry);
+    void maybeCompact();
+    void destroyContiguousEntries();
+
+    const Layout layout_;
+    // Layout::List storage.
     std::list<HeaderEntryImpl> headers_;
-    HeaderNode pseudo_headers_end_;
+    std::list<HeaderEntryImpl>::iterator pseudo_headers_end_;
+    // Layout::Contiguous storage.
+    HeaderArena arena_;
+    std::vector<HeaderEntryImpl*> pseudo_entries_;
+    std::vector<HeaderEntryImpl*> entries_;
+    uint32_t contiguous_size_{};
+    uint32_t tombstones_{};
     // The number of headers threshold for lazy map usage.
     const uint32_t lazy_map_min_size_;
     HeaderLazyMap lazy_map_;
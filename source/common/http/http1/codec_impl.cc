@@ -21,6 +21,7 @@
 #include "source/common/http/headers.h"
 #include "source/common/http/http1/header_formatter.h"
 #include "source/common/http/http1/legacy_parser_impl.h"
+#include "source/common/http/http1/vectorized_parser_impl.h"
 #include "source/common/http/utility.h"
 #include "source/common/runtime/runtime_features.h"
 
@@ -503,7 +504,11 @@ ConnectionImpl::ConnectionImpl(Network::Connection& connection, CodecStats& stat
           []() -> void { /* TODO(adisuissa): Handle overflow watermark */ })),
       max_headers_kb_(max_headers_kb), max_headers_count_(max_headers_count) {
   output_buffer_->setWatermarks(connection.bufferLimit());
-  parser_ = std::make_unique<LegacyHttpParserImpl>(type, this);
+  if (Runtime::runtimeFeatureEnabled("envoy.reloadable_features.http1_use_vectorized_parser")) {
+    parser_ = std::make_unique<VectorizedHttpParserImpl>(type, this);
+  } else {
+    parser_ = std::make_unique<LegacyHttpParserImpl>(type, this);
+  }
 }
 
 Status ConnectionImpl::completeLastHeader() {
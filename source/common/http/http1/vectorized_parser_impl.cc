@@ -0,0 +1,1625 @@
+#include "source/common/http/http1/vectorized_parser_impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "source/common/common/assert.h"
+#include "source/common/common/macros.h"
+
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
+
+#if defined(__x86_64__) && defined(__SSE2__)
+#include <emmintrin.h>
+#define ENVOY_HTTP1_SCAN_SSE2
+#if defined(__AVX2__) || ((defined(__GNUC__) || defined(__clang__)) && !defined(WIN32))
+#include <immintrin.h>
+#define ENVOY_HTTP1_SCAN_AVX2
+#endif
+#endif
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// The error codes and their names are the ones of http_parser, so that the codec reports the same
+// protocol errors with either parser.
+enum Errno : int {
+  Ok = 0,
+  CbMessageBegin = 1,
+  CbUrl = 2,
+  CbHeaderField = 3,
+  CbHeaderValue = 4,
+  CbHeadersComplete = 5,
+  CbBody = 6,
+  CbMessageComplete = 7,
+  CbStatus = 8,
+  CbChunkHeader = 9,
+  CbChunkComplete = 10,
+  InvalidEofState = 11,
+  HeaderOverflow = 12,
+  ClosedConnection = 13,
+  InvalidVersion = 14,
+  InvalidStatus = 15,
+  InvalidMethod = 16,
+  InvalidUrl = 17,
+  InvalidHost = 18,
+  InvalidPort = 19,
+  InvalidPath = 20,
+  InvalidQueryString = 21,
+  InvalidFragment = 22,
+  LfExpected = 23,
+  InvalidHeaderToken = 24,
+  InvalidContentLength = 25,
+  UnexpectedContentLength = 26,
+  InvalidChunkSize = 27,
+  InvalidConstant = 28,
+  InvalidInternalState = 29,
+  Strict = 30,
+  Paused = 31,
+  Unknown = 32,
+  InvalidTransferEncoding = 33,
+};
+
+constexpr absl::string_view ErrnoNames[] = {
+    "HPE_OK",
+    "HPE_CB_message_begin",
+    "HPE_CB_url",
+    "HPE_CB_header_field",
+    "HPE_CB_header_value",
+    "HPE_CB_headers_complete",
+    "HPE_CB_body",
+    "HPE_CB_message_complete",
+    "HPE_CB_status",
+    "HPE_CB_chunk_header",
+    "HPE_CB_chunk_complete",
+    "HPE_INVALID_EOF_STATE",
+    "HPE_HEADER_OVERFLOW",
+    "HPE_CLOSED_CONNECTION",
+    "HPE_INVALID_VERSION",
+    "HPE_INVALID_STATUS",
+    "HPE_INVALID_METHOD",
+    "HPE_INVALID_URL",
+    "HPE_INVALID_HOST",
+    "HPE_INVALID_PORT",
+    "HPE_INVALID_PATH",
+    "HPE_INVALID_QUERY_STRING",
+    "HPE_INVALID_FRAGMENT",
+    "HPE_LF_EXPECTED",
+    "HPE_INVALID_HEADER_TOKEN",
+    "HPE_INVALID_CONTENT_LENGTH",
+    "HPE_UNEXPECTED_CONTENT_LENGTH",
+    "HPE_INVALID_CHUNK_SIZE",
+    "HPE_INVALID_CONSTANT",
+    "HPE_INVALID_INTERNAL_STATE",
+    "HPE_STRICT",
+    "HPE_PAUSED",
+    "HPE_UNKNOWN",
+    "HPE_INVALID_TRANSFER_ENCODING",
+};
+
+// In the order of the methods of http_parser.
+constexpr absl::string_view Methods[] = {
+    "DELETE",   "GET",       "HEAD",        "POST",       "PUT",       "CONNECT",  "OPTIONS",
+    "TRACE",    "COPY",      "LOCK",        "MKCOL",      "MOVE",      "PROPFIND", "PROPPATCH",
+    "SEARCH",   "UNLOCK",    "BIND",        "REBIND",     "UNBIND",    "ACL",      "REPORT",
+    "MKACTIVITY", "CHECKOUT", "MERGE",      "M-SEARCH",   "NOTIFY",    "SUBSCRIBE", "UNSUBSCRIBE",
+    "PATCH",    "PURGE",     "MKCALENDAR",  "LINK",       "UNLINK",    "SOURCE",
+};
+constexpr uint8_t MethodConnect = 5;
+constexpr uint8_t MethodSource = 33;
+
+constexpr uint8_t FlagChunked = 1 << 0;
+constexpr uint8_t FlagConnectionKeepAlive = 1 << 1;
+constexpr uint8_t FlagConnectionClose = 1 << 2;
+constexpr uint8_t FlagConnectionUpgrade = 1 << 3;
+constexpr uint8_t FlagTrailing = 1 << 4;
+constexpr uint8_t FlagUpgrade = 1 << 5;
+constexpr uint8_t FlagSkipBody = 1 << 6;
+constexpr uint8_t FlagContentLength = 1 << 7;
+
+constexpr uint64_t NoContentLength = std::numeric_limits<uint64_t>::max();
+// The limit http_parser is built with, which effectively disables it as the codec enforces its own
+// limits on the size of the headers.
+constexpr uint64_t MaxHeaderSize = 0x2000000;
+
+constexpr char CR = '\r';
+constexpr char LF = '\n';
+
+constexpr absl::string_view KeepAlive = "keep-alive";
+constexpr absl::string_view Close = "close";
+constexpr absl::string_view Upgrade = "upgrade";
+constexpr absl::string_view Chunked = "chunked";
+
+using CharTable = std::array<bool, 256>;
+
+template <class Predicate> constexpr CharTable makeCharTable(Predicate predicate) {
+  CharTable table{};
+  for (uint32_t c = 0; c < table.size(); c++) {
+    table[c] = predicate(static_cast<uint8_t>(c));
+  }
+  return table;
+}
+
+constexpr bool isAlpha(uint8_t c) { return (c | 0x20) >= 'a' && (c | 0x20) <= 'z'; }
+constexpr bool isDigit(uint8_t c) { return c >= '0' && c <= '9'; }
+constexpr bool isAlphaNum(uint8_t c) { return isAlpha(c) || isDigit(c); }
+
+// The token characters of RFC 7230.
+constexpr CharTable TokenChars = makeCharTable([](uint8_t c) {
+  return isAlphaNum(c) || c == '!' || c == '#' || c == '$' || c == '%' || c == '&' || c == '\'' ||
+         c == '*' || c == '+' || c == '-' || c == '.' || c == '^' || c == '_' || c == '`' ||
+         c == '|' || c == '~';
+});
+
+// The characters of the paths, query strings and fragments of URLs, other than the '?' and '#'
+// delimiters.
+constexpr CharTable UrlChars =
+    makeCharTable([](uint8_t c) { return c > ' ' && c < 0x7f && c != '#' && c != '?'; });
+
+constexpr CharTable UserinfoChars = makeCharTable([](uint8_t c) {
+  return isAlphaNum(c) || c == '-' || c == '_' || c == '.' || c == '!' || c == '~' || c == '*' ||
+         c == '\'' || c == '(' || c == ')' || c == '%' || c == ';' || c == ':' || c == '&' ||
+         c == '=' || c == '+' || c == '$' || c == ',';
+});
+
+// The characters of header values, other than the CR and LF delimiters.
+constexpr CharTable HeaderValueChars =
+    makeCharTable([](uint8_t c) { return c == '\t' || (c >= ' ' && c != 0x7f); });
+
+// The characters of the reason phrases of status lines.
+constexpr CharTable LineChars = makeCharTable([](uint8_t c) { return c != CR && c != LF; });
+
+constexpr std::array<int8_t, 256> makeUnhexTable() {
+  std::array<int8_t, 256> table{};
+  for (uint32_t c = 0; c < table.size(); c++) {
+    table[c] = isDigit(c)                   ? c - '0'
+               : (c >= 'a' && c <= 'f')     ? c - 'a' + 10
+               : (c >= 'A' && c <= 'F')     ? c - 'A' + 10
+                                            : -1;
+  }
+  return table;
+}
+constexpr std::array<int8_t, 256> Unhex = makeUnhexTable();
+
+bool isChar(const CharTable& table, char ch) { return table[static_cast<uint8_t>(ch)]; }
+
+template <const CharTable& Table> const char* scanScalar(const char* p, const char* end) {
+  while (p != end && isChar(Table, *p)) {
+    ++p;
+  }
+  return p;
+}
+
+#ifdef ENVOY_HTTP1_SCAN_SSE2
+// The kernels compute a mask of the bytes ending the scan, with signed comparisons which also
+// account for the bytes above 0x7f, and then scan the rest of the input with the scalar kernel.
+
+inline __m128i tokenStopSse2(__m128i v) {
+  const auto eq = [v](char c) { return _mm_cmpeq_epi8(v, _mm_set1_epi8(c)); };
+  const auto between = [v](char low, char high) {
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(low - 1)),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(high + 1)));
+  };
+  // Control characters, space and the bytes above 0x7f, then the separators.
+  __m128i stop = _mm_cmplt_epi8(v, _mm_set1_epi8('!'));
+  stop = _mm_or_si128(stop, _mm_or_si128(eq('"'), between('(', ')')));
+  stop = _mm_or_si128(stop, _mm_or_si128(eq(','), eq('/')));
+  stop = _mm_or_si128(stop, _mm_or_si128(between(':', '@'), between('[', ']')));
+  return _mm_or_si128(stop, _mm_or_si128(_mm_or_si128(eq('{'), eq('}')), eq(0x7f)));
+}
+
+inline __m128i urlStopSse2(__m128i v) {
+  __m128i stop = _mm_cmplt_epi8(v, _mm_set1_epi8('!'));
+  stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+  stop = _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('#')));
+  return _mm_or_si128(stop, _mm_cmpeq_epi8(v, _mm_set1_epi8('?')));
+}
+
+inline __m128i headerValueStopSse2(__m128i v) {
+  // Control characters other than horizontal tab, which include CR and LF, and DEL.
+  const __m128i control = _mm_andnot_si128(
+      _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')),
+      _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(-1)), _mm_cmplt_epi8(v, _mm_set1_epi8(' '))));
+  return _mm_or_si128(control, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7f)));
+}
+
+inline __m128i lineStopSse2(__m128i v) {
+  return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(CR)), _mm_cmpeq_epi8(v, _mm_set1_epi8(LF)));
+}
+
+template <__m128i (*Stop)(__m128i), const CharTable& Table>
+const char* scanSse2(const char* p, const char* end) {
+  while (end - p >= 16) {
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const uint32_t stop = _mm_movemask_epi8(Stop(v));
+    if (stop != 0) {
+      return p + __builtin_ctz(stop);
+    }
+    p += 16;
+  }
+  return scanScalar<Table>(p, end);
+}
+#endif
+
+#ifdef ENVOY_HTTP1_SCAN_AVX2
+// AVX2 is used when the CPU supports it, without the rest of Envoy being built for it, so the
+// kernels are compiled for the instruction set one by one.
+#define ENVOY_HTTP1_AVX2 __attribute__((target("avx2")))
+
+ENVOY_HTTP1_AVX2 inline __m256i eqAvx2(__m256i v, char c) {
+  return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+ENVOY_HTTP1_AVX2 inline __m256i ltAvx2(__m256i v, char c) {
+  return _mm256_cmpgt_epi8(_mm256_set1_epi8(c), v);
+}
+
+ENVOY_HTTP1_AVX2 inline __m256i betweenAvx2(__m256i v, char low, char high) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(low - 1)),
+                          ltAvx2(v, high + 1));
+}
+
+ENVOY_HTTP1_AVX2 const char* scanTokenAvx2(const char* p, const char* end) {
+  while (end - p >= 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    __m256i stop = ltAvx2(v, '!');
+    stop = _mm256_or_si256(stop, _mm256_or_si256(eqAvx2(v, '"'), betweenAvx2(v, '(', ')')));
+    stop = _mm256_or_si256(stop, _mm256_or_si256(eqAvx2(v, ','), eqAvx2(v, '/')));
+    stop = _mm256_or_si256(stop,
+                           _mm256_or_si256(betweenAvx2(v, ':', '@'), betweenAvx2(v, '[', ']')));
+    stop = _mm256_or_si256(
+        stop, _mm256_or_si256(_mm256_or_si256(eqAvx2(v, '{'), eqAvx2(v, '}')), eqAvx2(v, 0x7f)));
+    const uint32_t mask = _mm256_movemask_epi8(stop);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scanSse2<tokenStopSse2, TokenChars>(p, end);
+}
+
+ENVOY_HTTP1_AVX2 const char* scanUrlAvx2(const char* p, const char* end) {
+  while (end - p >= 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i stop = _mm256_or_si256(_mm256_or_si256(ltAvx2(v, '!'), eqAvx2(v, 0x7f)),
+                                         _mm256_or_si256(eqAvx2(v, '#'), eqAvx2(v, '?')));
+    const uint32_t mask = _mm256_movemask_epi8(stop);
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scanSse2<urlStopSse2, UrlChars>(p, end);
+}
+
+ENVOY_HTTP1_AVX2 const char* scanHeaderValueAvx2(const char* p, const char* end) {
+  while (end - p >= 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i control = _mm256_andnot_si256(
+        eqAvx2(v, '\t'),
+        _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(-1)), ltAvx2(v, ' ')));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(control, eqAvx2(v, 0x7f)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scanSse2<headerValueStopSse2, HeaderValueChars>(p, end);
+}
+
+ENVOY_HTTP1_AVX2 const char* scanLineAvx2(const char* p, const char* end) {
+  while (end - p >= 32) {
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const uint32_t mask = _mm256_movemask_epi8(_mm256_or_si256(eqAvx2(v, CR), eqAvx2(v, LF)));
+    if (mask != 0) {
+      return p + __builtin_ctz(mask);
+    }
+    p += 32;
+  }
+  return scanSse2<lineStopSse2, LineChars>(p, end);
+}
+
+bool cpuSupportsAvx2() {
+#if defined(__AVX2__)
+  return true;
+#else
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+} // namespace
+
+// Each scan returns the first byte of [p, end) which is not of the scanned class, or end.
+struct VectorizedHttpParserImpl::Scanner {
+  using Scan = const char* (*)(const char* p, const char* end);
+
+  Scan token_;
+  Scan url_;
+  Scan header_value_;
+  Scan line_;
+};
+
+namespace {
+
+constexpr VectorizedHttpParserImpl::Scanner ScalarScanner{
+    scanScalar<TokenChars>, scanScalar<UrlChars>, scanScalar<HeaderValueChars>,
+    scanScalar<LineChars>};
+
+#ifdef ENVOY_HTTP1_SCAN_SSE2
+constexpr VectorizedHttpParserImpl::Scanner Sse2Scanner{
+    scanSse2<tokenStopSse2, TokenChars>, scanSse2<urlStopSse2, UrlChars>,
+    scanSse2<headerValueStopSse2, HeaderValueChars>, scanSse2<lineStopSse2, LineChars>};
+#endif
+
+#ifdef ENVOY_HTTP1_SCAN_AVX2
+constexpr VectorizedHttpParserImpl::Scanner Avx2Scanner{scanTokenAvx2, scanUrlAvx2,
+                                                        scanHeaderValueAvx2, scanLineAvx2};
+#endif
+
+std::atomic<VectorizedHttpParserImpl::ScanKernel>& activeScanKernel() {
+  MUTABLE_CONSTRUCT_ON_FIRST_USE(std::atomic<VectorizedHttpParserImpl::ScanKernel>,
+                                 VectorizedHttpParserImpl::supportedScanKernels().back());
+}
+
+const VectorizedHttpParserImpl::Scanner& activeScanner() {
+  switch (activeScanKernel().load(std::memory_order_relaxed)) {
+#ifdef ENVOY_HTTP1_SCAN_AVX2
+  case VectorizedHttpParserImpl::ScanKernel::Avx2:
+    return Avx2Scanner;
+#endif
+#ifdef ENVOY_HTTP1_SCAN_SSE2
+  case VectorizedHttpParserImpl::ScanKernel::Sse2:
+    return Sse2Scanner;
+#endif
+  default:
+    return ScalarScanner;
+  }
+}
+
+} // namespace
+
+VectorizedHttpParserImpl::VectorizedHttpParserImpl(MessageType type, ParserCallbacks* callbacks)
+    : callbacks_(callbacks), scanner_(activeScanner()), type_(type),
+      state_(type == MessageType::Request ? State::StartReq : State::StartRes),
+      content_length_(NoContentLength) {}
+
+std::vector<VectorizedHttpParserImpl::ScanKernel> VectorizedHttpParserImpl::supportedScanKernels() {
+  std::vector<ScanKernel> kernels{ScanKernel::Scalar};
+#ifdef ENVOY_HTTP1_SCAN_SSE2
+  kernels.push_back(ScanKernel::Sse2);
+#endif
+#ifdef ENVOY_HTTP1_SCAN_AVX2
+  if (cpuSupportsAvx2()) {
+    kernels.push_back(ScanKernel::Avx2);
+  }
+#endif
+  return kernels;
+}
+
+void VectorizedHttpParserImpl::setScanKernelForTest(ScanKernel kernel) {
+  activeScanKernel().store(kernel, std::memory_order_relaxed);
+}
+
+void VectorizedHttpParserImpl::resume() {
+  if (errno_ == Paused) {
+    errno_ = Ok;
+  }
+}
+
+ParserStatus VectorizedHttpParserImpl::pause() {
+  if (errno_ == Ok) {
+    errno_ = Paused;
+  }
+  // As with http_parser, the parser is paused above rather than by the status of the callback.
+  return ParserStatus::Success;
+}
+
+ParserStatus VectorizedHttpParserImpl::getStatus() {
+  switch (errno_) {
+  case Ok:
+    return ParserStatus::Success;
+  case Paused:
+    return ParserStatus::Paused;
+  default:
+    return ParserStatus::Unknown;
+  }
+}
+
+absl::optional<uint64_t> VectorizedHttpParserImpl::contentLength() const {
+  if (content_length_ == NoContentLength) {
+    return absl::nullopt;
+  }
+  return content_length_;
+}
+
+bool VectorizedHttpParserImpl::isChunked() const { return flags_ & FlagChunked; }
+
+absl::string_view VectorizedHttpParserImpl::methodName() const { return Methods[method_]; }
+
+absl::string_view VectorizedHttpParserImpl::errnoName(int rc) const {
+  if (rc < 0 || rc >= static_cast<int>(ABSL_ARRAYSIZE(ErrnoNames))) {
+    return "<unknown>";
+  }
+  return ErrnoNames[rc];
+}
+
+int VectorizedHttpParserImpl::statusToInt(const ParserStatus code) const {
+  // The same values as http_parser, which the callbacks return.
+  switch (code) {
+  case ParserStatus::Error:
+    return -1;
+  case ParserStatus::Success:
+    return 0;
+  case ParserStatus::NoBody:
+    return 1;
+  case ParserStatus::NoBodyData:
+    return 2;
+  case ParserStatus::Paused:
+    return Paused;
+  default:
+    NOT_REACHED_GCOVR_EXCL_LINE;
+  }
+}
+
+bool VectorizedHttpParserImpl::onSpan(Span span, const char* begin, const char* end) {
+  const size_t length = end - begin;
+  switch (span) {
+  case Span::Url:
+    if (callbacks_->setAndCheckCallbackStatus(callbacks_->onUrl(begin, length)) != 0) {
+      errno_ = CbUrl;
+    }
+    break;
+  case Span::HeaderField:
+    if (callbacks_->setAndCheckCallbackStatus(callbacks_->onHeaderField(begin, length)) != 0) {
+      errno_ = CbHeaderField;
+    }
+    break;
+  case Span::HeaderValue:
+    if (callbacks_->setAndCheckCallbackStatus(callbacks_->onHeaderValue(begin, length)) != 0) {
+      errno_ = CbHeaderValue;
+    }
+    break;
+  case Span::Body:
+    callbacks_->bufferBody(begin, length);
+    break;
+  case Span::None:
+    break;
+  }
+  return errno_ == Ok;
+}
+
+bool VectorizedHttpParserImpl::onMessageBegin() {
+  if (callbacks_->setAndCheckCallbackStatus(callbacks_->onMessageBegin()) != 0) {
+    errno_ = CbMessageBegin;
+  }
+  return errno_ == Ok;
+}
+
+bool VectorizedHttpParserImpl::onMessageComplete() {
+  if (callbacks_->setAndCheckCallbackStatusOr(callbacks_->onMessageComplete()) != 0) {
+    errno_ = CbMessageComplete;
+  }
+  return errno_ == Ok;
+}
+
+bool VectorizedHttpParserImpl::addHeaderBytes(uint64_t length) {
+  header_bytes_ += length;
+  if (header_bytes_ > MaxHeaderSize) {
+    errno_ = HeaderOverflow;
+    return false;
+  }
+  return true;
+}
+
+bool VectorizedHttpParserImpl::shouldKeepAlive() const {
+  if (http_major_ > 0 && http_minor_ > 0) {
+    if (flags_ & FlagConnectionClose) {
+      return false;
+    }
+  } else if (!(flags_ & FlagConnectionKeepAlive)) {
+    return false;
+  }
+  return !messageNeedsEof();
+}
+
+bool VectorizedHttpParserImpl::messageNeedsEof() const {
+  if (type_ == MessageType::Request) {
+    return false;
+  }
+  if (status_code_ / 100 == 1 || status_code_ == 204 || status_code_ == 304 ||
+      (flags_ & FlagSkipBody)) {
+    return false;
+  }
+  if (uses_transfer_encoding_ && !(flags_ & FlagChunked)) {
+    return true;
+  }
+  return !(flags_ & FlagChunked) && content_length_ == NoContentLength;
+}
+
+VectorizedHttpParserImpl::State VectorizedHttpParserImpl::newMessageState() const {
+  if (!shouldKeepAlive()) {
+    return State::Dead;
+  }
+  return type_ == MessageType::Request ? State::StartReq : State::StartRes;
+}
+
+int VectorizedHttpParserImpl::findMethod() const {
+  const absl::string_view name(method_name_.data(), method_name_length_);
+  for (uint32_t i = 0; i < ABSL_ARRAYSIZE(Methods); i++) {
+    if (Methods[i] == name) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+bool VectorizedHttpParserImpl::isMethodPrefix() const {
+  const absl::string_view prefix(method_name_.data(), method_name_length_);
+  return std::any_of(std::begin(Methods), std::end(Methods), [prefix](absl::string_view method) {
+    return method.substr(0, prefix.size()) == prefix;
+  });
+}
+
+VectorizedHttpParserImpl::HeaderState VectorizedHttpParserImpl::interpretHeaderName() {
+  if (!header_name_interpreted_) {
+    return HeaderState::General;
+  }
+  const absl::string_view name(header_name_.data(), header_name_length_);
+  if (name == "connection" || name == "proxy-connection") {
+    return HeaderState::Connection;
+  }
+  if (name == "content-length") {
+    return HeaderState::ContentLength;
+  }
+  if (name == "transfer-encoding") {
+    uses_transfer_encoding_ = true;
+    return HeaderState::TransferEncoding;
+  }
+  if (name == "upgrade") {
+    return HeaderState::Upgrade;
+  }
+  return HeaderState::General;
+}
+
+VectorizedHttpParserImpl::State VectorizedHttpParserImpl::parseUrlChar(State state, char ch) {
+  if (ch == ' ' || ch == CR || ch == LF || ch == '\t' || ch == '\f') {
+    return State::Dead;
+  }
+  switch (state) {
+  case State::ReqSpacesBeforeUrl:
+    // Proxied requests are followed by the scheme of an absolute URI, all other methods but
+    // CONNECT by '/' or '*'.
+    if (ch == '/' || ch == '*') {
+      return State::ReqPath;
+    }
+    if (isAlpha(ch)) {
+      return State::ReqSchema;
+    }
+    break;
+  case State::ReqSchema:
+    if (isAlpha(ch)) {
+      return state;
+    }
+    if (ch == ':') {
+      return State::ReqSchemaSlash;
+    }
+    break;
+  case State::ReqSchemaSlash:
+    if (ch == '/') {
+      return State::ReqSchemaSlashSlash;
+    }
+    break;
+  case State::ReqSchemaSlashSlash:
+    if (ch == '/') {
+      return State::ReqServerStart;
+    }
+    break;
+  case State::ReqServerWithAt:
+    if (ch == '@') {
+      return State::Dead;
+    }
+    FALLTHRU;
+  case State::ReqServerStart:
+  case State::ReqServer:
+    if (ch == '/') {
+      return State::ReqPath;
+    }
+    if (ch == '?') {
+      return State::ReqQueryStringStart;
+    }
+    if (ch == '@') {
+      return State::ReqServerWithAt;
+    }
+    if (isChar(UserinfoChars, ch) || ch == '[' || ch == ']') {
+      return State::ReqServer;
+    }
+    break;
+  case State::ReqPath:
+    if (isChar(UrlChars, ch)) {
+      return state;
+    }
+    if (ch == '?') {
+      return State::ReqQueryStringStart;
+    }
+    if (ch == '#') {
+      return State::ReqFragmentStart;
+    }
+    break;
+  case State::ReqQueryStringStart:
+  case State::ReqQueryString:
+    if (isChar(UrlChars, ch) || ch == '?') {
+      return State::ReqQueryString;
+    }
+    if (ch == '#') {
+      return State::ReqFragmentStart;
+    }
+    break;
+  case State::ReqFragmentStart:
+    if (isChar(UrlChars, ch) || ch == '?') {
+      return State::ReqFragment;
+    }
+    if (ch == '#') {
+      return state;
+    }
+    break;
+  case State::ReqFragment:
+    if (isChar(UrlChars, ch) || ch == '?' || ch == '#') {
+      return state;
+    }
+    break;
+  default:
+    break;
+  }
+  return State::Dead;
+}
+
+bool VectorizedHttpParserImpl::stepHeaderValue(HeaderState& header_state, char ch) {
+  const char c = ch | 0x20;
+  switch (header_state) {
+  case HeaderState::ContentLength:
+    if (ch == ' ') {
+      break;
+    }
+    header_state = HeaderState::ContentLengthNum;
+    FALLTHRU;
+  case HeaderState::ContentLengthNum: {
+    if (ch == ' ') {
+      header_state = HeaderState::ContentLengthWs;
+      break;
+    }
+    // Test against a conservative limit for simplicity, as http_parser does.
+    if (!isDigit(ch) || (NoContentLength - 10) / 10 < content_length_) {
+      errno_ = InvalidContentLength;
+      return false;
+    }
+    content_length_ = content_length_ * 10 + (ch - '0');
+    break;
+  }
+  case HeaderState::ContentLengthWs:
+    if (ch != ' ') {
+      errno_ = InvalidContentLength;
+      return false;
+    }
+    break;
+  case HeaderState::MatchingTransferEncodingTokenStart:
+    if (c == 'c') {
+      header_state = HeaderState::MatchingTransferEncodingChunked;
+    } else if (c != ' ' && isChar(TokenChars, c)) {
+      header_state = HeaderState::MatchingTransferEncodingToken;
+    } else if (c != ' ') {
+      // A horizontal tab is not skipped, as with http_parser, which compares it lower cased.
+      header_state = HeaderState::General;
+    }
+    break;
+  case HeaderState::MatchingTransferEncodingChunked:
+    index_++;
+    if (index_ >= Chunked.size() || c != Chunked[index_]) {
+      header_state = HeaderState::MatchingTransferEncodingToken;
+    } else if (index_ == Chunked.size() - 1) {
+      header_state = HeaderState::TransferEncodingChunked;
+    }
+    break;
+  case HeaderState::MatchingTransferEncodingToken:
+    if (ch == ',') {
+      header_state = HeaderState::MatchingTransferEncodingTokenStart;
+      index_ = 0;
+    }
+    break;
+  case HeaderState::MatchingConnectionTokenStart:
+    if (c == 'k') {
+      header_state = HeaderState::MatchingConnectionKeepAlive;
+    } else if (c == 'c') {
+      header_state = HeaderState::MatchingConnectionClose;
+    } else if (c == 'u') {
+      header_state = HeaderState::MatchingConnectionUpgrade;
+    } else if (c != ' ' && isChar(TokenChars, c)) {
+      header_state = HeaderState::MatchingConnectionToken;
+    } else if (c != ' ') {
+      header_state = HeaderState::General;
+    }
+    break;
+  case HeaderState::MatchingConnectionKeepAlive:
+    index_++;
+    if (index_ >= KeepAlive.size() || c != KeepAlive[index_]) {
+      header_state = HeaderState::MatchingConnectionToken;
+    } else if (index_ == KeepAlive.size() - 1) {
+      header_state = HeaderState::ConnectionKeepAlive;
+    }
+    break;
+  case HeaderState::MatchingConnectionClose:
+    index_++;
+    if (index_ >= Close.size() || c != Close[index_]) {
+      header_state = HeaderState::MatchingConnectionToken;
+    } else if (index_ == Close.size() - 1) {
+      header_state = HeaderState::ConnectionClose;
+    }
+    break;
+  case HeaderState::MatchingConnectionUpgrade:
+    index_++;
+    if (index_ >= Upgrade.size() || c != Upgrade[index_]) {
+      header_state = HeaderState::MatchingConnectionToken;
+    } else if (index_ == Upgrade.size() - 1) {
+      header_state = HeaderState::ConnectionUpgrade;
+    }
+    break;
+  case HeaderState::MatchingConnectionToken:
+    if (ch == ',') {
+      header_state = HeaderState::MatchingConnectionTokenStart;
+      index_ = 0;
+    }
+    break;
+  case HeaderState::TransferEncodingChunked:
+    if (ch != ' ') {
+      header_state = HeaderState::MatchingTransferEncodingToken;
+    }
+    break;
+  case HeaderState::ConnectionKeepAlive:
+  case HeaderState::ConnectionClose:
+  case HeaderState::ConnectionUpgrade:
+    if (ch == ',') {
+      finishHeaderValue();
+      header_state = HeaderState::MatchingConnectionTokenStart;
+      index_ = 0;
+    } else if (ch != ' ') {
+      header_state = HeaderState::MatchingConnectionToken;
+    }
+    break;
+  default:
+    header_state = HeaderState::General;
+    break;
+  }
+  return true;
+}
+
+void VectorizedHttpParserImpl::finishHeaderValue() {
+  switch (header_state_) {
+  case HeaderState::ConnectionKeepAlive:
+    flags_ |= FlagConnectionKeepAlive;
+    break;
+  case HeaderState::ConnectionClose:
+    flags_ |= FlagConnectionClose;
+    break;
+  case HeaderState::ConnectionUpgrade:
+    flags_ |= FlagConnectionUpgrade;
+    break;
+  case HeaderState::TransferEncodingChunked:
+    flags_ |= FlagChunked;
+    break;
+  default:
+    break;
+  }
+}
+
+Parser::RcVal VectorizedHttpParserImpl::execute(const char* data, int len) {
+  if (errno_ != Ok) {
+    return {0, errno_};
+  }
+
+  if (len == 0) {
+    switch (state_) {
+    case State::BodyIdentityEof:
+      onMessageComplete();
+      return {0, errno_};
+    case State::Dead:
+    case State::StartReq:
+    case State::StartRes:
+      return {0, errno_};
+    default:
+      errno_ = InvalidEofState;
+      return {1, errno_};
+    }
+  }
+
+  const char* p = data;
+  const char* const end = data + len;
+  const auto consumed = [data](const char* position) -> size_t { return position - data; };
+
+  // The start of the bytes of the URL, header or body being parsed not passed to the callbacks yet.
+  const char* mark = nullptr;
+  Span span = Span::None;
+  if (parsingUrl(state_)) {
+    mark = data;
+    span = Span::Url;
+  } else if (state_ == State::HeaderField) {
+    mark = data;
+    span = Span::HeaderField;
+  } else if (state_ == State::HeaderValue) {
+    mark = data;
+    span = Span::HeaderValue;
+  }
+  // The start of the bytes of the message head not added to header_bytes_ yet.
+  const char* head = parsingHeader(state_) ? data : nullptr;
+
+  // Each state either consumes the byte at p and breaks, or leaves it to the next state and
+  // continues. The states of the URLs, headers and bodies consume as many bytes as they can at once.
+  while (p != end) {
+    char ch = *p;
+    switch (state_) {
+    case State::Dead:
+      // After a message closing the connection, only CR and LF are allowed.
+      if (ch != CR && ch != LF) {
+        errno_ = ClosedConnection;
+        return {consumed(p), errno_};
+      }
+      break;
+
+    case State::StartReq: {
+      if (ch == CR || ch == LF) {
+        break;
+      }
+      flags_ = 0;
+      uses_transfer_encoding_ = false;
+      content_length_ = NoContentLength;
+      method_name_[0] = ch;
+      method_name_length_ = 1;
+      if (!isAlpha(ch) || !isMethodPrefix()) {
+        errno_ = InvalidMethod;
+        return {consumed(p), errno_};
+      }
+      state_ = State::ReqMethod;
+      if (!onMessageBegin()) {
+        return {consumed(p + 1), errno_};
+      }
+      break;
+    }
+
+    case State::ReqMethod: {
+      if (ch == ' ') {
+        const int method = findMethod();
+        if (method < 0) {
+          errno_ = InvalidMethod;
+          return {consumed(p), errno_};
+        }
+        method_ = method;
+        state_ = State::ReqSpacesBeforeUrl;
+        break;
+      }
+      if (!((ch >= 'A' && ch <= 'Z') || ch == '-') || method_name_length_ == MaxMethodLength) {
+        errno_ = InvalidMethod;
+        return {consumed(p), errno_};
+      }
+      method_name_[method_name_length_++] = ch;
+      if (!isMethodPrefix()) {
+        errno_ = InvalidMethod;
+        return {consumed(p), errno_};
+      }
+      break;
+    }
+
+    case State::ReqSpacesBeforeUrl: {
+      if (ch == ' ') {
+        break;
+      }
+      mark = p;
+      span = Span::Url;
+      if (method_ == MethodConnect) {
+        state_ = State::ReqServerStart;
+      }
+      state_ = parseUrlChar(state_, ch);
+      if (state_ == State::Dead) {
+        errno_ = InvalidUrl;
+        return {consumed(p), errno_};
+      }
+      break;
+    }
+
+    case State::ReqSchema:
+    case State::ReqSchemaSlash:
+    case State::ReqSchemaSlashSlash:
+    case State::ReqServerStart: {
+      // No whitespace is allowed before the path.
+      state_ = parseUrlChar(state_, ch);
+      if (state_ == State::Dead) {
+        errno_ = InvalidUrl;
+        return {consumed(p), errno_};
+      }
+      break;
+    }
+
+    case State::ReqPath:
+    case State::ReqQueryString:
+    case State::ReqFragment:
+      // The bulk of the URL, up to a delimiter, its end, or an invalid character.
+      p = scanner_.url_(p, end);
+      if (p == end) {
+        continue;
+      }
+      ch = *p;
+      FALLTHRU;
+
+    case State::ReqServer:
+    case State::ReqServerWithAt:
+    case State::ReqQueryStringStart:
+    case State::ReqFragmentStart: {
+      if (ch == ' ') {
+        state_ = State::ReqHttpStart;
+        if (!onSpan(span, mark, p)) {
+          return {consumed(p + 1), errno_};
+        }
+        mark = nullptr;
+        break;
+      }
+      if (ch == CR || ch == LF) {
+        // A HTTP/0.9 request line, without version.
+        http_major_ = 0;
+        http_minor_ = 9;
+        state_ = ch == CR ? State::ReqLineAlmostDone : State::HeaderFieldStart;
+        if (!onSpan(span, mark, p)) {
+          return {consumed(p + 1), errno_};
+        }
+        mark = nullptr;
+        break;
+      }
+      state_ = parseUrlChar(state_, ch);
+      if (state_ == State::Dead) {
+        errno_ = InvalidUrl;
+        return {consumed(p), errno_};
+      }
+      break;
+    }
+
+    case State::ReqHttpStart:
+      if (ch == ' ') {
+        break;
+      }
+      if (ch == 'H') {
+        state_ = State::ReqHttpH;
+      } else if (ch == 'I' && method_ == MethodSource) {
+        state_ = State::ReqHttpI;
+      } else {
+        errno_ = InvalidConstant;
+        return {consumed(p), errno_};
+      }
+      break;
+
+    case State::ReqHttpH:
+    case State::ReqHttpHT:
+    case State::ReqHttpHTT:
+    case State::ReqHttpHTTP:
+    case State::ReqHttpI:
+    case State::ReqHttpIC:
+    case State::ResH:
+    case State::ResHT:
+    case State::ResHTT:
+    case State::ResHTTP: {
+      // "HTTP/", or "ICE/" for SOURCE requests.
+      static constexpr char Expected[] = {'T', 'T', 'P', '/', 'C', 'E', 'T', 'T', 'P', '/'};
+      static constexpr State Next[] = {State::ReqHttpHT,    State::ReqHttpHTT, State::ReqHttpHTTP,
+                                       State::ReqHttpMajor, State::ReqHttpIC,  State::ReqHttpHTTP,
+                                       State::ResHT,        State::ResHTT,     State::ResHTTP,
+                                       State::ResHttpMajor};
+      const uint32_t i = state_ <= State::ReqHttpIC
+                             ? static_cast<uint32_t>(state_) -
+                                   static_cast<uint32_t>(State::ReqHttpH)
+                             : static_cast<uint32_t>(state_) - static_cast<uint32_t>(State::ResH) +
+                                   6;
+      if (ch != Expected[i]) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      state_ = Next[i];
+      break;
+    }
+
+    case State::ReqHttpMajor:
+    case State::ResHttpMajor:
+      if (!isDigit(ch)) {
+        errno_ = InvalidVersion;
+        return {consumed(p), errno_};
+      }
+      http_major_ = ch - '0';
+      state_ = state_ == State::ReqHttpMajor ? State::ReqHttpDot : State::ResHttpDot;
+      break;
+
+    case State::ReqHttpDot:
+    case State::ResHttpDot:
+      if (ch != '.') {
+        errno_ = InvalidVersion;
+        return {consumed(p), errno_};
+      }
+      state_ = state_ == State::ReqHttpDot ? State::ReqHttpMinor : State::ResHttpMinor;
+      break;
+
+    case State::ReqHttpMinor:
+    case State::ResHttpMinor:
+      if (!isDigit(ch)) {
+        errno_ = InvalidVersion;
+        return {consumed(p), errno_};
+      }
+      http_minor_ = ch - '0';
+      state_ = state_ == State::ReqHttpMinor ? State::ReqHttpEnd : State::ResHttpEnd;
+      break;
+
+    case State::ReqHttpEnd:
+      if (ch == CR) {
+        state_ = State::ReqLineAlmostDone;
+      } else if (ch == LF) {
+        state_ = State::HeaderFieldStart;
+      } else {
+        errno_ = InvalidVersion;
+        return {consumed(p), errno_};
+      }
+      break;
+
+    case State::ReqLineAlmostDone:
+      if (ch != LF) {
+        errno_ = LfExpected;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeaderFieldStart;
+      break;
+
+    case State::StartRes: {
+      if (ch == CR || ch == LF) {
+        break;
+      }
+      flags_ = 0;
+      uses_transfer_encoding_ = false;
+      content_length_ = NoContentLength;
+      if (ch != 'H') {
+        errno_ = InvalidConstant;
+        return {consumed(p), errno_};
+      }
+      state_ = State::ResH;
+      if (!onMessageBegin()) {
+        return {consumed(p + 1), errno_};
+      }
+      break;
+    }
+
+    case State::ResHttpEnd:
+      if (ch != ' ') {
+        errno_ = InvalidVersion;
+        return {consumed(p), errno_};
+      }
+      state_ = State::ResFirstStatusCode;
+      break;
+
+    case State::ResFirstStatusCode:
+      if (!isDigit(ch)) {
+        if (ch == ' ') {
+          break;
+        }
+        errno_ = InvalidStatus;
+        return {consumed(p), errno_};
+      }
+      status_code_ = ch - '0';
+      state_ = State::ResStatusCode;
+      break;
+
+    case State::ResStatusCode:
+      if (!isDigit(ch)) {
+        if (ch == ' ') {
+          state_ = State::ResStatusStart;
+          break;
+        }
+        if (ch == CR || ch == LF) {
+          state_ = State::ResStatusStart;
+          continue;
+        }
+        errno_ = InvalidStatus;
+        return {consumed(p), errno_};
+      }
+      status_code_ = status_code_ * 10 + (ch - '0');
+      if (status_code_ > 999) {
+        errno_ = InvalidStatus;
+        return {consumed(p), errno_};
+      }
+      break;
+
+    case State::ResStatusStart:
+      state_ = State::ResStatus;
+      if (ch == CR || ch == LF) {
+        continue;
+      }
+      break;
+
+    case State::ResStatus:
+      // The reason phrase is not passed to the callbacks.
+      p = scanner_.line_(p, end);
+      if (p == end) {
+        continue;
+      }
+      state_ = *p == CR ? State::ResLineAlmostDone : State::HeaderFieldStart;
+      break;
+
+    case State::ResLineAlmostDone:
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeaderFieldStart;
+      break;
+
+    case State::HeaderFieldStart: {
+      if (ch == CR) {
+        state_ = State::HeadersAlmostDone;
+        break;
+      }
+      if (ch == LF) {
+        // The headers may end with LF rather than CRLF.
+        state_ = State::HeadersAlmostDone;
+        continue;
+      }
+      if (!isChar(TokenChars, ch)) {
+        errno_ = InvalidHeaderToken;
+        return {consumed(p), errno_};
+      }
+      mark = p;
+      span = Span::HeaderField;
+      state_ = State::HeaderField;
+      const char c = ch | 0x20;
+      header_name_interpreted_ = c == 'c' || c == 'p' || c == 't' || c == 'u';
+      header_name_length_ = 0;
+      continue;
+    }
+
+    case State::HeaderField: {
+      const char* name_end = scanner_.token_(p, end);
+      if (header_name_interpreted_) {
+        const size_t length = std::min<size_t>(
+            name_end - p, MaxInterpretedHeaderNameLength - header_name_length_);
+        for (size_t i = 0; i < length; i++) {
+          header_name_[header_name_length_++] = absl::ascii_tolower(p[i]);
+        }
+        if (length < static_cast<size_t>(name_end - p)) {
+          // As with http_parser, any header which name starts with transfer-encoding counts as
+          // one, even though its value isn't interpreted.
+          if (absl::string_view(header_name_.data(), header_name_length_) == "transfer-encoding") {
+            uses_transfer_encoding_ = true;
+          }
+          header_name_interpreted_ = false;
+        }
+      }
+      p = name_end;
+      if (p == end) {
+        continue;
+      }
+      if (*p != ':') {
+        errno_ = InvalidHeaderToken;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeaderValueDiscardWs;
+      header_state_ = interpretHeaderName();
+      if (!onSpan(span, mark, p)) {
+        return {consumed(p + 1), errno_};
+      }
+      mark = nullptr;
+      break;
+    }
+
+    case State::HeaderValueDiscardWs:
+      if (ch == ' ' || ch == '\t') {
+        break;
+      }
+      if (ch == CR) {
+        state_ = State::HeaderValueDiscardWsAlmostDone;
+        break;
+      }
+      if (ch == LF) {
+        state_ = State::HeaderValueDiscardLws;
+        break;
+      }
+      state_ = State::HeaderValueStart;
+      continue;
+
+    case State::HeaderValueDiscardWsAlmostDone:
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeaderValueDiscardLws;
+      break;
+
+    case State::HeaderValueDiscardLws:
+      if (ch == ' ' || ch == '\t') {
+        state_ = State::HeaderValueDiscardWs;
+        break;
+      }
+      if (header_state_ == HeaderState::ContentLength) {
+        // An empty content length is not allowed.
+        errno_ = InvalidContentLength;
+        return {consumed(p), errno_};
+      }
+      finishHeaderValue();
+      // The header value is empty.
+      state_ = State::HeaderFieldStart;
+      if (!onSpan(Span::HeaderValue, p, p)) {
+        return {consumed(p), errno_};
+      }
+      continue;
+
+    case State::HeaderValueStart: {
+      mark = p;
+      span = Span::HeaderValue;
+      state_ = State::HeaderValue;
+      index_ = 0;
+      // The first byte of the value is interpreted, but not validated, as with http_parser.
+      const char c = ch | 0x20;
+      switch (header_state_) {
+      case HeaderState::Upgrade:
+        flags_ |= FlagUpgrade;
+        header_state_ = HeaderState::General;
+        break;
+      case HeaderState::TransferEncoding:
+        header_state_ = c == 'c' ? HeaderState::MatchingTransferEncodingChunked
+                                 : HeaderState::MatchingTransferEncodingToken;
+        break;
+      case HeaderState::ContentLength:
+        if (!isDigit(ch)) {
+          errno_ = InvalidContentLength;
+          return {consumed(p), errno_};
+        }
+        if (flags_ & FlagContentLength) {
+          errno_ = UnexpectedContentLength;
+          return {consumed(p), errno_};
+        }
+        flags_ |= FlagContentLength;
+        content_length_ = ch - '0';
+        header_state_ = HeaderState::ContentLengthNum;
+        break;
+      case HeaderState::Connection:
+        header_state_ = c == 'k'   ? HeaderState::MatchingConnectionKeepAlive
+                        : c == 'c' ? HeaderState::MatchingConnectionClose
+                        : c == 'u' ? HeaderState::MatchingConnectionUpgrade
+                                   : HeaderState::MatchingConnectionToken;
+        break;
+      case HeaderState::MatchingTransferEncodingTokenStart:
+      case HeaderState::MatchingConnectionTokenStart:
+      case HeaderState::ContentLengthWs:
+        // The value of a multi-valued header or of a content length continues on this line.
+        break;
+      default:
+        header_state_ = HeaderState::General;
+        break;
+      }
+      break;
+    }
+
+    case State::HeaderValue: {
+      HeaderState header_state = header_state_;
+      while (p != end) {
+        if (header_state == HeaderState::General) {
+          p = scanner_.header_value_(p, end);
+          if (p == end) {
+            break;
+          }
+        }
+        if (*p == CR || *p == LF) {
+          break;
+        }
+        if (!isChar(HeaderValueChars, *p)) {
+          header_state_ = header_state;
+          errno_ = InvalidHeaderToken;
+          return {consumed(p), errno_};
+        }
+        if (header_state != HeaderState::General && !stepHeaderValue(header_state, *p)) {
+          header_state_ = header_state;
+          return {consumed(p), errno_};
+        }
+        ++p;
+      }
+      header_state_ = header_state;
+      if (p == end) {
+        continue;
+      }
+      state_ = State::HeaderAlmostDone;
+      if (*p == CR) {
+        if (!onSpan(span, mark, p)) {
+          return {consumed(p + 1), errno_};
+        }
+        mark = nullptr;
+        break;
+      }
+      if (!onSpan(span, mark, p)) {
+        return {consumed(p), errno_};
+      }
+      mark = nullptr;
+      // The header may end with LF rather than CRLF.
+      continue;
+    }
+
+    case State::HeaderAlmostDone:
+      if (ch != LF) {
+        errno_ = LfExpected;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeaderValueLws;
+      break;
+
+    case State::HeaderValueLws:
+      if (ch == ' ' || ch == '\t') {
+        // The value continues on this line, which is treated as a space separated continuation.
+        if (header_state_ == HeaderState::ContentLengthNum) {
+          header_state_ = HeaderState::ContentLengthWs;
+        }
+        state_ = State::HeaderValueStart;
+        continue;
+      }
+      finishHeaderValue();
+      state_ = State::HeaderFieldStart;
+      continue;
+
+    case State::HeadersAlmostDone: {
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      if (flags_ & FlagTrailing) {
+        // The end of the trailers of a chunked message.
+        if (!addHeaderBytes(p - head)) {
+          return {consumed(p), errno_};
+        }
+        head = nullptr;
+        state_ = State::MessageDone;
+        continue;
+      }
+      // Both transfer encoding and content length are only allowed for chunked messages.
+      if (uses_transfer_encoding_ && (flags_ & FlagContentLength) && !(flags_ & FlagChunked)) {
+        errno_ = UnexpectedContentLength;
+        return {consumed(p), errno_};
+      }
+      state_ = State::HeadersDone;
+      if ((flags_ & FlagUpgrade) && (flags_ & FlagConnectionUpgrade)) {
+        // Upgrade and Connection: upgrade only mandate an upgrade for requests and 101 responses.
+        upgrade_ = type_ == MessageType::Request || status_code_ == 101;
+      } else {
+        upgrade_ = method_ == MethodConnect;
+      }
+      // The callback may return that the message has no body, e.g. for responses to HEAD
+      // requests, or that the rest of the connection is of another protocol.
+      switch (callbacks_->setAndCheckCallbackStatusOr(callbacks_->onHeadersComplete())) {
+      case 0:
+        break;
+      case 2:
+        upgrade_ = true;
+        FALLTHRU;
+      case 1:
+        flags_ |= FlagSkipBody;
+        break;
+      default:
+        errno_ = CbHeadersComplete;
+        return {consumed(p), errno_};
+      }
+      if (errno_ != Ok) {
+        return {consumed(p), errno_};
+      }
+      continue;
+    }
+
+    case State::HeadersDone: {
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      if (!addHeaderBytes(p + 1 - head)) {
+        return {consumed(p), errno_};
+      }
+      header_bytes_ = 0;
+      head = nullptr;
+
+      const bool has_body = (flags_ & FlagChunked) ||
+                            (content_length_ > 0 && content_length_ != NoContentLength);
+      if (upgrade_ && (method_ == MethodConnect || (flags_ & FlagSkipBody) || !has_body)) {
+        // The rest of the connection is of another protocol.
+        state_ = newMessageState();
+        onMessageComplete();
+        return {consumed(p + 1), errno_};
+      }
+      if (flags_ & FlagSkipBody) {
+        state_ = newMessageState();
+        head = p + 1;
+        if (!onMessageComplete()) {
+          return {consumed(p + 1), errno_};
+        }
+      } else if (flags_ & FlagChunked) {
+        // Chunked messages ignore the content length.
+        state_ = State::ChunkSizeStart;
+      } else if (uses_transfer_encoding_) {
+        if (type_ == MessageType::Request) {
+          // The length of a request which transfer encoding is not chunked can't be determined.
+          errno_ = InvalidTransferEncoding;
+          return {consumed(p), errno_};
+        }
+        // Responses then last until the connection is closed.
+        state_ = State::BodyIdentityEof;
+      } else if (content_length_ == 0) {
+        state_ = newMessageState();
+        head = p + 1;
+        if (!onMessageComplete()) {
+          return {consumed(p + 1), errno_};
+        }
+      } else if (content_length_ != NoContentLength) {
+        state_ = State::BodyIdentity;
+      } else if (!messageNeedsEof()) {
+        state_ = newMessageState();
+        head = p + 1;
+        if (!onMessageComplete()) {
+          return {consumed(p + 1), errno_};
+        }
+      } else {
+        state_ = State::BodyIdentityEof;
+      }
+      break;
+    }
+
+    case State::ChunkSizeStart: {
+      const int8_t value = Unhex[static_cast<uint8_t>(ch)];
+      if (value < 0) {
+        errno_ = InvalidChunkSize;
+        return {consumed(p), errno_};
+      }
+      content_length_ = value;
+      state_ = State::ChunkSize;
+      break;
+    }
+
+    case State::ChunkSize: {
+      if (ch == CR) {
+        state_ = State::ChunkSizeAlmostDone;
+        break;
+      }
+      const int8_t value = Unhex[static_cast<uint8_t>(ch)];
+      if (value < 0) {
+        if (ch == ';' || ch == ' ') {
+          state_ = State::ChunkParameters;
+          break;
+        }
+        errno_ = InvalidChunkSize;
+        return {consumed(p), errno_};
+      }
+      if ((NoContentLength - 16) / 16 < content_length_) {
+        errno_ = InvalidContentLength;
+        return {consumed(p), errno_};
+      }
+      content_length_ = content_length_ * 16 + value;
+      break;
+    }
+
+    case State::ChunkParameters: {
+      // Chunk extensions are ignored.
+      const char* cr = static_cast<const char*>(memchr(p, CR, end - p));
+      if (cr == nullptr) {
+        p = end;
+        continue;
+      }
+      p = cr;
+      state_ = State::ChunkSizeAlmostDone;
+      break;
+    }
+
+    case State::ChunkSizeAlmostDone: {
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      const bool is_final_chunk = content_length_ == 0;
+      if (is_final_chunk) {
+        flags_ |= FlagTrailing;
+        state_ = State::HeaderFieldStart;
+        header_bytes_ = 0;
+        head = p + 1;
+      } else {
+        state_ = State::ChunkData;
+      }
+      callbacks_->onChunkHeader(is_final_chunk);
+      if (errno_ != Ok) {
+        return {consumed(p + 1), errno_};
+      }
+      break;
+    }
+
+    case State::ChunkData: {
+      const uint64_t to_read = std::min<uint64_t>(content_length_, end - p);
+      mark = p;
+      span = Span::Body;
+      content_length_ -= to_read;
+      p += to_read;
+      if (content_length_ == 0) {
+        state_ = State::ChunkDataAlmostDone;
+      }
+      continue;
+    }
+
+    case State::ChunkDataAlmostDone:
+      if (ch != CR) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      state_ = State::ChunkDataDone;
+      if (mark != nullptr) {
+        if (!onSpan(span, mark, p)) {
+          return {consumed(p + 1), errno_};
+        }
+        mark = nullptr;
+      }
+      break;
+
+    case State::ChunkDataDone:
+      if (ch != LF) {
+        errno_ = Strict;
+        return {consumed(p), errno_};
+      }
+      state_ = State::ChunkSizeStart;
+      break;
+
+    case State::BodyIdentity: {
+      const uint64_t to_read = std::min<uint64_t>(content_length_, end - p);
+      content_length_ -= to_read;
+      if (content_length_ == 0) {
+        // The message completes with its last byte, without waiting for the next one.
+        state_ = State::MessageDone;
+        if (!onSpan(Span::Body, p, p + to_read)) {
+          return {consumed(p + to_read), errno_};
+        }
+        p += to_read - 1;
+        continue;
+      }
+      mark = p;
+      span = Span::Body;
+      p += to_read;
+      continue;
+    }
+
+    case State::BodyIdentityEof:
+      // The body lasts until the connection is closed.
+      mark = p;
+      span = Span::Body;
+      p = end;
+      continue;
+
+    case State::MessageDone:
+      state_ = newMessageState();
+      head = p + 1;
+      if (!onMessageComplete()) {
+        return {consumed(p + 1), errno_};
+      }
+      if (upgrade_) {
+        // The rest of the connection is of another protocol.
+        return {consumed(p + 1), errno_};
+      }
+      break;
+    }
+    ++p;
+  }
+
+  // Pass the bytes of the URL, header or body being parsed to the callbacks.
+  if (mark != nullptr && !onSpan(span, mark, end)) {
+    return {consumed(end), errno_};
+  }
+  if (head != nullptr && !addHeaderBytes(end - head)) {
+    return {consumed(end), errno_};
+  }
+  return {consumed(end), errno_};
+}
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "source/common/http/http1/parser.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+
+/**
+ * HTTP/1 parser with the semantics of the legacy http_parser based implementation, as built by
+ * Envoy, which scans the URLs, header names, header values and status lines with SIMD kernels
+ * rather than a byte at a time. Bodies are skipped over in bulk.
+ *
+ * The kernel is selected at startup from the best instruction set supported by the CPU: AVX2 where
+ * available on x86-64, SSE2 otherwise, and a table driven scalar kernel on other architectures.
+ */
+class VectorizedHttpParserImpl : public Parser {
+public:
+  enum class ScanKernel { Scalar, Sse2, Avx2 };
+
+  VectorizedHttpParserImpl(MessageType type, ParserCallbacks* callbacks);
+
+  // Http1::Parser
+  RcVal execute(const char* data, int len) override;
+  void resume() override;
+  ParserStatus pause() override;
+  ParserStatus getStatus() override;
+  uint16_t statusCode() const override { return status_code_; }
+  int httpMajor() const override { return http_major_; }
+  int httpMinor() const override { return http_minor_; }
+  absl::optional<uint64_t> contentLength() const override;
+  bool isChunked() const override;
+  absl::string_view methodName() const override;
+  absl::string_view errnoName(int rc) const override;
+  int hasTransferEncoding() const override { return uses_transfer_encoding_; }
+  int statusToInt(const ParserStatus code) const override;
+
+  /**
+   * @return the kernels supported by the CPU, from the slowest to the fastest.
+   */
+  static std::vector<ScanKernel> supportedScanKernels();
+
+  /**
+   * Sets the kernel used by the parsers created afterwards. The kernel must be supported by the
+   * CPU.
+   */
+  static void setScanKernelForTest(ScanKernel kernel);
+
+  struct Scanner;
+
+private:
+  enum class State : uint8_t {
+    Dead,
+    StartReq,
+    ReqMethod,
+    ReqSpacesBeforeUrl,
+    ReqSchema,
+    ReqSchemaSlash,
+    ReqSchemaSlashSlash,
+    ReqServerStart,
+    ReqServer,
+    ReqServerWithAt,
+    ReqPath,
+    ReqQueryStringStart,
+    ReqQueryString,
+    ReqFragmentStart,
+    ReqFragment,
+    ReqHttpStart,
+    ReqHttpH,
+    ReqHttpHT,
+    ReqHttpHTT,
+    ReqHttpHTTP,
+    ReqHttpI,
+    ReqHttpIC,
+    ReqHttpMajor,
+    ReqHttpDot,
+    ReqHttpMinor,
+    ReqHttpEnd,
+    ReqLineAlmostDone,
+    StartRes,
+    ResH,
+    ResHT,
+    ResHTT,
+    ResHTTP,
+    ResHttpMajor,
+    ResHttpDot,
+    ResHttpMinor,
+    ResHttpEnd,
+    ResFirstStatusCode,
+    ResStatusCode,
+    ResStatusStart,
+    ResStatus,
+    ResLineAlmostDone,
+    HeaderFieldStart,
+    HeaderField,
+    HeaderValueDiscardWs,
+    HeaderValueDiscardWsAlmostDone,
+    HeaderValueDiscardLws,
+    HeaderValueStart,
+    HeaderValue,
+    HeaderValueLws,
+    HeaderAlmostDone,
+    HeadersAlmostDone,
+    // The states above are the ones of the message head, which count towards the header size limit.
+    HeadersDone,
+    ChunkSizeStart,
+    ChunkSize,
+    ChunkParameters,
+    ChunkSizeAlmostDone,
+    ChunkData,
+    ChunkDataAlmostDone,
+    ChunkDataDone,
+    BodyIdentity,
+    BodyIdentityEof,
+    MessageDone,
+  };
+
+  // The interpretation of the value of the header being parsed.
+  enum class HeaderState : uint8_t {
+    General,
+    Connection,
+    ContentLength,
+    TransferEncoding,
+    Upgrade,
+    MatchingTransferEncodingToken,
+    MatchingTransferEncodingTokenStart,
+    MatchingTransferEncodingChunked,
+    TransferEncodingChunked,
+    MatchingConnectionTokenStart,
+    MatchingConnectionKeepAlive,
+    MatchingConnectionClose,
+    MatchingConnectionUpgrade,
+    MatchingConnectionToken,
+    ConnectionKeepAlive,
+    ConnectionClose,
+    ConnectionUpgrade,
+    ContentLengthNum,
+    ContentLengthWs,
+  };
+
+  // The kind of the bytes passed to the callbacks for a span of the input.
+  enum class Span : uint8_t { None, Url, HeaderField, HeaderValue, Body };
+
+  // The longest method and header name the parser interprets.
+  static constexpr uint32_t MaxMethodLength = 11;
+  static constexpr uint32_t MaxInterpretedHeaderNameLength = 17;
+
+  static bool parsingHeader(State state) { return state <= State::HeadersDone; }
+  static bool parsingUrl(State state) {
+    return state >= State::ReqSchema && state <= State::ReqFragment;
+  }
+  static State parseUrlChar(State state, char ch);
+
+  // The callbacks return false if they failed, in which case errno_ holds the error.
+  bool onSpan(Span span, const char* begin, const char* end);
+  bool onMessageBegin();
+  bool onMessageComplete();
+  bool addHeaderBytes(uint64_t length);
+  bool stepHeaderValue(HeaderState& header_state, char ch);
+  void finishHeaderValue();
+  HeaderState interpretHeaderName();
+  bool shouldKeepAlive() const;
+  bool messageNeedsEof() const;
+  State newMessageState() const;
+  int findMethod() const;
+  bool isMethodPrefix() const;
+
+  ParserCallbacks* const callbacks_;
+  const Scanner& scanner_;
+  const MessageType type_;
+  State state_;
+  HeaderState header_state_{HeaderState::General};
+  int errno_{};
+  uint8_t flags_{};
+  uint8_t index_{};
+  uint8_t http_major_{};
+  uint8_t http_minor_{};
+  uint8_t method_{};
+  bool uses_transfer_encoding_{};
+  bool upgrade_{};
+  uint16_t status_code_{};
+  uint64_t content_length_;
+  uint64_t header_bytes_{};
+  std::array<char, MaxMethodLength> method_name_;
+  uint8_t method_name_length_{};
+  // The lower cased name of the header being parsed, as long as it may be one of the headers which
+  // are interpreted.
+  std::array<char, MaxInterpretedHeaderNameLength> header_name_;
+  uint8_t header_name_length_{};
+  bool header_name_interpreted_{};
+};
+
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
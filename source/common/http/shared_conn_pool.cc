@@ -0,0 +1,446 @@
+#include "source/common/http/shared_conn_pool.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/dump_state_utils.h"
+#include "source/common/event/deferred_task.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/header_utility.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+
+namespace Envoy {
+namespace Http {
+
+SharedConnPool::SharedConnPool(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                               Upstream::HostConstSharedPtr host, OwnerPoolCb owner_pool)
+    : dispatcher_(dispatcher), owner_dispatcher_(owner_dispatcher), host_(std::move(host)),
+      owner_pool_(std::make_shared<const OwnerPoolCb>(std::move(owner_pool))) {}
+
+SharedConnPool::~SharedConnPool() {
+  // Streams still referenced by events in flight outlive the pool, detached from it.
+  while (!streams_.empty()) {
+    SharedStreamSharedPtr stream = streams_.front();
+    streams_.pop_front();
+    stream->onPoolDestroyed();
+  }
+}
+
+void SharedConnPool::drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) {
+  // The connections belong to the owner, which drains them on its own. This pool only has to
+  // report when its last stream is done, so that it can be deleted.
+  if (drain_behavior == Envoy::ConnectionPool::DrainBehavior::DrainAndDelete) {
+    if (streams_.empty()) {
+      for (const IdleCb& cb : idle_callbacks_) {
+        cb();
+      }
+    }
+  }
+}
+
+ConnectionPool::Cancellable* SharedConnPool::newStream(ResponseDecoder& response_decoder,
+                                                       ConnectionPool::Callbacks& callbacks) {
+  auto stream = std::make_shared<SharedStream>(*this, response_decoder, callbacks);
+  stream->entry_ = streams_.insert(streams_.end(), stream);
+  ENVOY_LOG(trace, "handing off stream to the owner of the connections to host '{}'",
+            host_->hostname());
+  // The owner pool is looked up for each stream, on the owner worker.
+  owner_dispatcher_.post(
+      [stream, owner_pool = owner_pool_]() -> void { stream->newOwnerStream(*owner_pool); });
+  return stream.get();
+}
+
+void SharedConnPool::onStreamDone(SharedStream& stream) {
+  SharedStreamSharedPtr removed = std::move(*stream.entry_);
+  streams_.erase(stream.entry_);
+  // The caller may still be on the stack of the stream.
+  Event::DeferredTaskUtil::deferredRun(dispatcher_, [removed]() -> void {});
+  if (streams_.empty()) {
+    for (const IdleCb& cb : idle_callbacks_) {
+      cb();
+    }
+  }
+}
+
+SharedConnPool::SharedStream::SharedStream(SharedConnPool& parent,
+                                           ResponseDecoder& response_decoder,
+                                           ConnectionPool::Callbacks& callbacks)
+    : dispatcher_(parent.dispatcher_), owner_dispatcher_(parent.owner_dispatcher_),
+      host_(parent.host_), parent_(&parent), response_decoder_(response_decoder),
+      callbacks_(&callbacks), bytes_meter_(std::make_shared<StreamInfo::BytesMeter>()) {}
+
+Status SharedConnPool::SharedStream::encodeHeaders(const RequestHeaderMap& headers,
+                                                   bool end_stream) {
+  // The owner's codec can't report errors synchronously, so do its validation here.
+  RETURN_IF_ERROR(HeaderUtility::checkRequiredRequestHeaders(headers));
+  local_end_stream_ = end_stream;
+  std::shared_ptr<RequestHeaderMap> copy = createHeaderMap<RequestHeaderMapImpl>(headers);
+  postToOwner([copy, end_stream](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ == nullptr) {
+      return;
+    }
+    stream.owner_request_headers_ = copy;
+    const Status status =
+        stream.owner_encoder_->encodeHeaders(*stream.owner_request_headers_, end_stream);
+    if (!status.ok()) {
+      stream.resetOwnerStream(StreamResetReason::LocalReset);
+      return;
+    }
+    stream.owner_request_complete_ = end_stream;
+    if (stream.owner_request_complete_ && stream.owner_response_complete_) {
+      stream.onOwnerDone();
+    }
+  });
+  if (localComplete()) {
+    onLocalDone();
+  }
+  return okStatus();
+}
+
+void SharedConnPool::SharedStream::encodeData(Buffer::Instance& data, bool end_stream) {
+  local_end_stream_ = end_stream;
+  auto buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToOwner([buffer, end_stream](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ == nullptr) {
+      return;
+    }
+    stream.owner_encoder_->encodeData(*buffer, end_stream);
+    stream.owner_request_complete_ = end_stream;
+    if (stream.owner_request_complete_ && stream.owner_response_complete_) {
+      stream.onOwnerDone();
+    }
+  });
+  if (localComplete()) {
+    onLocalDone();
+  }
+}
+
+void SharedConnPool::SharedStream::encodeTrailers(const RequestTrailerMap& trailers) {
+  local_end_stream_ = true;
+  std::shared_ptr<RequestTrailerMap> copy = createHeaderMap<RequestTrailerMapImpl>(trailers);
+  postToOwner([copy](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ == nullptr) {
+      return;
+    }
+    stream.owner_request_trailers_ = copy;
+    stream.owner_encoder_->encodeTrailers(*stream.owner_request_trailers_);
+    stream.owner_request_complete_ = true;
+    if (stream.owner_response_complete_) {
+      stream.onOwnerDone();
+    }
+  });
+  if (localComplete()) {
+    onLocalDone();
+  }
+}
+
+void SharedConnPool::SharedStream::encodeMetadata(const MetadataMapVector& metadata_map_vector) {
+  auto copy = std::make_shared<MetadataMapVector>();
+  for (const MetadataMapPtr& metadata_map : metadata_map_vector) {
+    copy->push_back(std::make_unique<MetadataMap>(*metadata_map));
+  }
+  postToOwner([copy](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->encodeMetadata(*copy);
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::enableTcpTunneling() {
+  postToOwner([](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->enableTcpTunneling();
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::resetStream(StreamResetReason reason) {
+  if (local_done_) {
+    return;
+  }
+  postToOwner([reason](SharedStream& stream) -> void { stream.resetOwnerStream(reason); });
+  runResetCallbacks(reason);
+  onLocalDone();
+}
+
+void SharedConnPool::SharedStream::readDisable(bool disable) {
+  postToOwner([disable](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->getStream().readDisable(disable);
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::setFlushTimeout(std::chrono::milliseconds timeout) {
+  postToOwner([timeout](SharedStream& stream) -> void {
+    if (stream.owner_encoder_ != nullptr) {
+      stream.owner_encoder_->getStream().setFlushTimeout(timeout);
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) {
+  ASSERT(callbacks_ != nullptr);
+  postToOwner([cancel_policy](SharedStream& stream) -> void {
+    if (stream.owner_handle_ != nullptr) {
+      stream.owner_handle_->cancel(cancel_policy);
+      stream.owner_handle_ = nullptr;
+      stream.onOwnerDone();
+    } else {
+      // The owner's stream may have been ready before the cancellation got to it.
+      stream.resetOwnerStream(StreamResetReason::LocalReset);
+    }
+  });
+  onLocalDone();
+}
+
+void SharedConnPool::SharedStream::onOwnerPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                      const std::string& transport_failure_reason) {
+  if (local_done_) {
+    return;
+  }
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  onLocalDone();
+  callbacks->onPoolFailure(reason, transport_failure_reason, host_);
+}
+
+void SharedConnPool::SharedStream::onOwnerPoolReady(const ConnectionInfo& connection_info,
+                                                    absl::optional<Http::Protocol> protocol) {
+  if (local_done_) {
+    return;
+  }
+  auto connection_info_provider = std::make_shared<Network::ConnectionInfoSetterImpl>(
+      connection_info.local_address_, connection_info.remote_address_);
+  if (connection_info.connection_id_.has_value()) {
+    connection_info_provider->setConnectionID(connection_info.connection_id_.value());
+  }
+  stream_info_ = std::make_unique<StreamInfo::StreamInfoImpl>(dispatcher_.timeSource(),
+                                                              connection_info_provider);
+  connection_local_address_ = connection_info.local_address_;
+  buffer_limit_ = connection_info.buffer_limit_;
+  ConnectionPool::Callbacks* callbacks = callbacks_;
+  callbacks_ = nullptr;
+  callbacks->onPoolReady(*this, host_, *stream_info_, protocol);
+}
+
+void SharedConnPool::SharedStream::onOwnerResetStream(StreamResetReason reason,
+                                                      const std::string& details) {
+  if (local_done_) {
+    return;
+  }
+  response_details_ = details;
+  runResetCallbacks(reason);
+  onLocalDone();
+}
+
+void SharedConnPool::SharedStream::onLocalDone() {
+  if (local_done_) {
+    return;
+  }
+  local_done_ = true;
+  callbacks_ = nullptr;
+  if (parent_ != nullptr) {
+    parent_->onStreamDone(*this);
+  }
+}
+
+void SharedConnPool::SharedStream::onPoolDestroyed() {
+  parent_ = nullptr;
+  if (local_done_) {
+    return;
+  }
+  postToOwner([](SharedStream& stream) -> void {
+    stream.resetOwnerStream(StreamResetReason::ConnectionTermination);
+  });
+  if (callbacks_ == nullptr) {
+    runResetCallbacks(StreamResetReason::ConnectionTermination);
+  }
+  local_done_ = true;
+  callbacks_ = nullptr;
+}
+
+void SharedConnPool::SharedStream::postToOwner(std::function<void(SharedStream&)> cb) {
+  owner_dispatcher_.post([self = shared_from_this(), cb = std::move(cb)]() -> void { cb(*self); });
+}
+
+void SharedConnPool::SharedStream::newOwnerStream(const OwnerPoolCb& owner_pool) {
+  owner_self_ = shared_from_this();
+  ConnectionPool::Instance* pool = owner_pool();
+  if (pool == nullptr) {
+    postToLocal([](SharedStream& stream) -> void {
+      stream.onOwnerPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                                "shared connection pool owner unavailable");
+    });
+    onOwnerDone();
+    return;
+  }
+  // The pool callbacks may run inline and complete the stream creation.
+  ConnectionPool::Cancellable* handle = pool->newStream(*this, *this);
+  if (handle != nullptr) {
+    owner_handle_ = handle;
+  }
+}
+
+void SharedConnPool::SharedStream::resetOwnerStream(StreamResetReason reason) {
+  if (owner_handle_ != nullptr) {
+    owner_handle_->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+    owner_handle_ = nullptr;
+    onOwnerDone();
+  } else if (owner_encoder_ != nullptr) {
+    Stream& owner_stream = owner_encoder_->getStream();
+    owner_stream.removeCallbacks(*this);
+    owner_encoder_ = nullptr;
+    owner_stream.resetStream(reason);
+    onOwnerDone();
+  }
+}
+
+void SharedConnPool::SharedStream::onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                                                 absl::string_view transport_failure_reason,
+                                                 Upstream::HostDescriptionConstSharedPtr) {
+  owner_handle_ = nullptr;
+  postToLocal([reason, details = std::string(transport_failure_reason)](
+                  SharedStream& stream) -> void { stream.onOwnerPoolFailure(reason, details); });
+  onOwnerDone();
+}
+
+void SharedConnPool::SharedStream::onPoolReady(RequestEncoder& encoder,
+                                               Upstream::HostDescriptionConstSharedPtr,
+                                               const StreamInfo::StreamInfo& info,
+                                               absl::optional<Http::Protocol> protocol) {
+  owner_handle_ = nullptr;
+  owner_encoder_ = &encoder;
+  encoder.getStream().addCallbacks(*this);
+  ConnectionInfo connection_info{encoder.getStream().connectionLocalAddress(),
+                                 info.downstreamAddressProvider().remoteAddress(),
+                                 info.downstreamAddressProvider().connectionID(),
+                                 encoder.getStream().bufferLimit()};
+  postToLocal([connection_info, protocol](SharedStream& stream) -> void {
+    stream.onOwnerPoolReady(connection_info, protocol);
+  });
+}
+
+void SharedConnPool::SharedStream::decode100ContinueHeaders(ResponseHeaderMapPtr&& headers) {
+  // Posted callbacks must be copyable, so the headers are moved through a shared holder.
+  auto moved = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  postToLocal([moved](SharedStream& stream) -> void {
+    if (!stream.local_done_) {
+      stream.response_decoder_.decode100ContinueHeaders(std::move(*moved));
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) {
+  auto moved = std::make_shared<ResponseHeaderMapPtr>(std::move(headers));
+  postToLocal([moved, end_stream](SharedStream& stream) -> void {
+    if (stream.local_done_) {
+      return;
+    }
+    stream.response_complete_ = end_stream;
+    stream.response_decoder_.decodeHeaders(std::move(*moved), end_stream);
+    if (stream.localComplete()) {
+      stream.onLocalDone();
+    }
+  });
+  owner_response_complete_ = end_stream;
+  if (owner_request_complete_ && owner_response_complete_) {
+    onOwnerDone();
+  }
+}
+
+void SharedConnPool::SharedStream::decodeData(Buffer::Instance& data, bool end_stream) {
+  auto buffer = std::make_shared<Buffer::OwnedImpl>();
+  buffer->move(data);
+  postToLocal([buffer, end_stream](SharedStream& stream) -> void {
+    if (stream.local_done_) {
+      return;
+    }
+    stream.response_complete_ = end_stream;
+    stream.response_decoder_.decodeData(*buffer, end_stream);
+    if (stream.localComplete()) {
+      stream.onLocalDone();
+    }
+  });
+  owner_response_complete_ = end_stream;
+  if (owner_request_complete_ && owner_response_complete_) {
+    onOwnerDone();
+  }
+}
+
+void SharedConnPool::SharedStream::decodeTrailers(ResponseTrailerMapPtr&& trailers) {
+  auto moved = std::make_shared<ResponseTrailerMapPtr>(std::move(trailers));
+  postToLocal([moved](SharedStream& stream) -> void {
+    if (stream.local_done_) {
+      return;
+    }
+    stream.response_complete_ = true;
+    stream.response_decoder_.decodeTrailers(std::move(*moved));
+    if (stream.localComplete()) {
+      stream.onLocalDone();
+    }
+  });
+  owner_response_complete_ = true;
+  if (owner_request_complete_) {
+    onOwnerDone();
+  }
+}
+
+void SharedConnPool::SharedStream::decodeMetadata(MetadataMapPtr&& metadata_map) {
+  auto moved = std::make_shared<MetadataMapPtr>(std::move(metadata_map));
+  postToLocal([moved](SharedStream& stream) -> void {
+    if (!stream.local_done_) {
+      stream.response_decoder_.decodeMetadata(std::move(*moved));
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::dumpState(std::ostream& os, int indent_level) const {
+  const char* spaces = spacesForLevel(indent_level);
+  os << spaces << "SharedConnPool::SharedStream " << this << DUMP_MEMBER(owner_request_complete_)
+     << DUMP_MEMBER(owner_response_complete_) << "\n";
+}
+
+void SharedConnPool::SharedStream::onResetStream(StreamResetReason reason,
+                                                 absl::string_view transport_failure_reason) {
+  // The owner's stream is gone, so callbacks must not be removed from it.
+  owner_encoder_ = nullptr;
+  postToLocal([reason, details = std::string(transport_failure_reason)](
+                  SharedStream& stream) -> void { stream.onOwnerResetStream(reason, details); });
+  onOwnerDone();
+}
+
+void SharedConnPool::SharedStream::onAboveWriteBufferHighWatermark() {
+  postToLocal([](SharedStream& stream) -> void {
+    if (!stream.local_done_) {
+      stream.runHighWatermarkCallbacks();
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::onBelowWriteBufferLowWatermark() {
+  postToLocal([](SharedStream& stream) -> void {
+    if (!stream.local_done_) {
+      stream.runLowWatermarkCallbacks();
+    }
+  });
+}
+
+void SharedConnPool::SharedStream::onOwnerDone() {
+  if (owner_self_ == nullptr) {
+    return;
+  }
+  if (owner_encoder_ != nullptr) {
+    owner_encoder_->getStream().removeCallbacks(*this);
+    owner_encoder_ = nullptr;
+  }
+  // The owner's codec may still be on the stack, referencing the request headers and trailers.
+  Event::DeferredTaskUtil::deferredRun(owner_dispatcher_,
+                                       [self = std::move(owner_self_)]() -> void {});
+}
+
+void SharedConnPool::SharedStream::postToLocal(std::function<void(SharedStream&)> cb) {
+  dispatcher_.post([self = shared_from_this(), cb = std::move(cb)]() -> void { cb(*self); });
+}
+
+} // namespace Http
+} // namespace Envoy
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/http/codec.h"
+#include "envoy/http/conn_pool.h"
+#include "envoy/stream_info/stream_info.h"
+#include "envoy/upstream/upstream.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/http/codec_helper.h"
+
+namespace Envoy {
+namespace Http {
+
+/**
+ * A connection pool handing off its streams to a connection pool owned by another worker, so that
+ * several workers share the multiplexed connections of the owner instead of each connecting to the
+ * host. The pool is used on the worker creating the streams, which interacts with it as with any
+ * other pool. Stream creation, request encoding, response decoding and stream events are posted
+ * between this worker and the owner, which only ever interacts with its own pool.
+ *
+ * This is only suitable for HTTP/2 and HTTP/3 pools. Streams go through a copy of the owner's
+ * connection info, without the upstream connection filter state and TLS information, and don't
+ * charge their buffers to the account of the downstream request.
+ */
+class SharedConnPool : public ConnectionPool::Instance,
+                       protected Logger::Loggable<Logger::Id::pool> {
+public:
+  /**
+   * Returns the pool to hand off streams to. Called on the owner worker, for every stream since
+   * the owner may drain and delete its pools at any time.
+   * @return the pool, or nullptr if the owner has no pool for the host anymore, e.g. because the
+   *         cluster was removed.
+   */
+  using OwnerPoolCb = std::function<ConnectionPool::Instance*()>;
+
+  SharedConnPool(Event::Dispatcher& dispatcher, Event::Dispatcher& owner_dispatcher,
+                 Upstream::HostConstSharedPtr host, OwnerPoolCb owner_pool);
+  ~SharedConnPool() override;
+
+  // ConnectionPool::Instance
+  void addIdleCallback(IdleCb cb) override { idle_callbacks_.push_back(cb); }
+  bool isIdle() const override { return streams_.empty(); }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior drain_behavior) override;
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override {
+    // Connections are only established by the owner.
+    return false;
+  }
+  bool hasActiveConnections() const override { return !streams_.empty(); }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override;
+  absl::string_view protocolDescription() const override { return "shared"; }
+
+private:
+  class SharedStream;
+  using SharedStreamSharedPtr = std::shared_ptr<SharedStream>;
+
+  /**
+   * A stream handed off to the owner. Its methods are called on one of the two workers, as noted
+   * for each group, and only touch the members of that worker. Each posted event holds a reference
+   * to the stream, so that it outlives the events of both workers.
+   */
+  class SharedStream : public RequestEncoder,
+                       public Stream,
+                       public StreamCallbackHelper,
+                       public ConnectionPool::Cancellable,
+                       public ResponseDecoder,
+                       public StreamCallbacks,
+                       public ConnectionPool::Callbacks,
+                       public std::enable_shared_from_this<SharedStream> {
+  public:
+    SharedStream(SharedConnPool& parent, ResponseDecoder& response_decoder,
+                 ConnectionPool::Callbacks& callbacks);
+
+    // Called on the worker of the pool.
+
+    // Http::RequestEncoder
+    Status encodeHeaders(const RequestHeaderMap& headers, bool end_stream) override;
+    void encodeTrailers(const RequestTrailerMap& trailers) override;
+    void enableTcpTunneling() override;
+
+    // Http::StreamEncoder
+    void encodeData(Buffer::Instance& data, bool end_stream) override;
+    Stream& getStream() override { return *this; }
+    void encodeMetadata(const MetadataMapVector& metadata_map_vector) override;
+    Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+    void resetStream(StreamResetReason reason) override;
+    void readDisable(bool disable) override;
+    uint32_t bufferLimit() override { return buffer_limit_; }
+    absl::string_view responseDetails() override { return response_details_; }
+    const Network::Address::InstanceConstSharedPtr& connectionLocalAddress() override {
+      return connection_local_address_;
+    }
+    void setFlushTimeout(std::chrono::milliseconds timeout) override;
+    void setAccount(Buffer::BufferMemoryAccountSharedPtr) override {
+      // Buffers are moved to the owner, which can't charge the account of this worker.
+    }
+    const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+    // ConnectionPool::Cancellable
+    void cancel(Envoy::ConnectionPool::CancelPolicy cancel_policy) override;
+
+    // Called on the owner worker.
+
+    // Http::ResponseDecoder
+    void decode100ContinueHeaders(ResponseHeaderMapPtr&& headers) override;
+    void decodeHeaders(ResponseHeaderMapPtr&& headers, bool end_stream) override;
+    void decodeData(Buffer::Instance& data, bool end_stream) override;
+    void decodeTrailers(ResponseTrailerMapPtr&& trailers) override;
+    void decodeMetadata(MetadataMapPtr&& metadata_map) override;
+    void dumpState(std::ostream& os, int indent_level) const override;
+
+    // Http::StreamCallbacks
+    void onResetStream(StreamResetReason reason,
+                       absl::string_view transport_failure_reason) override;
+    void onAboveWriteBufferHighWatermark() override;
+    void onBelowWriteBufferLowWatermark() override;
+
+    // ConnectionPool::Callbacks
+    void onPoolFailure(ConnectionPool::PoolFailureReason reason,
+                       absl::string_view transport_failure_reason,
+                       Upstream::HostDescriptionConstSharedPtr host) override;
+    void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr host,
+                     const StreamInfo::StreamInfo& info,
+                     absl::optional<Http::Protocol> protocol) override;
+
+    // Creates the stream on the pool of the owner.
+    void newOwnerStream(const OwnerPoolCb& owner_pool);
+
+    // Resets the stream as requested by the worker of the pool, on the pool or on the connection.
+    void resetOwnerStream(StreamResetReason reason);
+
+    // Called on the worker of the pool when the pool is destroyed with the stream in flight.
+    void onPoolDestroyed();
+
+    std::list<SharedStreamSharedPtr>::iterator entry_;
+
+  private:
+    // The connection info of the owner's connection, copied for the worker of the pool.
+    struct ConnectionInfo {
+      Network::Address::InstanceConstSharedPtr local_address_;
+      Network::Address::InstanceConstSharedPtr remote_address_;
+      absl::optional<uint64_t> connection_id_;
+      uint32_t buffer_limit_;
+    };
+
+    // Called on the worker of the pool.
+    void onOwnerPoolFailure(ConnectionPool::PoolFailureReason reason,
+                            const std::string& transport_failure_reason);
+    void onOwnerPoolReady(const ConnectionInfo& connection_info,
+                          absl::optional<Http::Protocol> protocol);
+    void onOwnerResetStream(StreamResetReason reason, const std::string& details);
+    // Removes the stream from the pool once the router stopped expecting events from it.
+    void onLocalDone();
+    bool localComplete() const { return local_end_stream_ && response_complete_; }
+    void postToOwner(std::function<void(SharedStream&)> cb);
+
+    // Called on the owner worker.
+    // Detaches from the owner's stream once it is complete or reset, and drops the reference that
+    // kept the stream alive for the owner.
+    void onOwnerDone();
+    void postToLocal(std::function<void(SharedStream&)> cb);
+
+    Event::Dispatcher& dispatcher_;
+    Event::Dispatcher& owner_dispatcher_;
+    const Upstream::HostConstSharedPtr host_;
+
+    // Members of the worker of the pool.
+    SharedConnPool* parent_;
+    ResponseDecoder& response_decoder_;
+    // Reset to nullptr once a pool callback was invoked or the stream was cancelled.
+    ConnectionPool::Callbacks* callbacks_;
+    bool local_done_{};
+    bool response_complete_{};
+    uint32_t buffer_limit_{};
+    std::string response_details_;
+    Network::Address::InstanceConstSharedPtr connection_local_address_;
+    std::unique_ptr<StreamInfo::StreamInfo> stream_info_;
+    const StreamInfo::BytesMeterSharedPtr bytes_meter_;
+
+    // Members of the owner worker.
+    ConnectionPool::Cancellable* owner_handle_{};
+    RequestEncoder* owner_encoder_{};
+    // Kept alive until the owner's stream is complete, as the codec may reference them.
+    std::shared_ptr<RequestHeaderMap> owner_request_headers_;
+    std::shared_ptr<RequestTrailerMap> owner_request_trailers_;
+    SharedStreamSharedPtr owner_self_;
+    bool owner_request_complete_{};
+    bool owner_response_complete_{};
+  };
+
+  void onStreamDone(SharedStream& stream);
+
+  Event::Dispatcher& dispatcher_;
+  Event::Dispatcher& owner_dispatcher_;
+  const Upstream::HostConstSharedPtr host_;
+  // Shared with the events creating streams on the owner, which may outlive the pool.
+  const std::shared_ptr<const OwnerPoolCb> owner_pool_;
+  std::list<SharedStreamSharedPtr> streams_;
+  std::list<IdleCb> idle_callbacks_;
+};
+
+} // namespace Http
+} // namespace Envoy
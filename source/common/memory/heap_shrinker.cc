@@ -1,5 +1,6 @@
 #include "source/common/memory/heap_shrinker.h"
 
+#include "source/common/buffer/slice_allocator.h"
 #include "source/common/memory/utils.h"
 #include "source/common/stats/symbol_table_impl.h"
 
@@ -31,6 +32,7 @@ HeapShrinker::HeapShrinker(Event::Dispatcher& dispatcher, Server::OverloadManage
 
 void HeapShrinker::shrinkHeap() {
   if (active_) {
+    Buffer::SliceAllocator::releaseFreeMemory();
     Utils::releaseFreeMemory();
     shrink_counter_->inc();
   }
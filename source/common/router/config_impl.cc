@@ -1410,6 +1410,16 @@ VirtualHostImpl::VirtualHostImpl(
       routes_.emplace_back(createAndValidateRoute(route, *this, optional_http_filters,
                                                   factory_context, validator, validation_clusters));
     }
+
+    if (!routes_.empty() &&
+        Runtime::runtimeFeatureEnabled("envoy.reloadable_features.compiled_route_matching")) {
+      auto route_match_index = std::make_unique<RouteMatchIndex>();
+      for (const auto& route : routes_) {
+        route_match_index->addRoute(route->matchType(), route->matcher(), route->caseSensitive());
+      }
+      route_match_index->compile();
+      route_match_index_ = std::move(route_match_index);
+    }
   }
 
   for (const auto& virtual_cluster : virtual_host.virtual_clusters()) {
@@ -1557,6 +1567,21 @@ RouteConstSharedPtr VirtualHostImpl::getRouteFromEntries(const RouteCallback& cb
 
     return nullptr;
   } else {
+    // The index does not track the remaining routes for route callbacks, and pathless requests
+    // can only match CONNECT routes, so both use the linear walk below.
+    if (route_match_index_ != nullptr && cb == nullptr && headers.Path() != nullptr) {
+      RouteMatchIndex::Candidates candidates;
+      route_match_index_->candidates(headers.getPathValue(), candidates);
+      for (const uint32_t index : candidates) {
+        RouteConstSharedPtr route_entry =
+            routes_[index]->matches(headers, stream_info, random_value);
+        if (route_entry != nullptr) {
+          return route_entry;
+        }
+      }
+      return nullptr;
+    }
+
     // Check for a route that matches the request.
     for (auto route = routes_.begin(); route != routes_.end(); ++route) {
       if (!headers.Path() && !(*route)->supportsPathlessHeaders()) {
@@ -29,6 +29,7 @@
 #include "source/common/router/header_formatter.h"
 #include "source/common/router/header_parser.h"
 #include "source/common/router/metadatamatchcriteria_impl.h"
+#include "source/common/router/route_match_index.h"
 #include "source/common/router/router_ratelimit.h"
 #include "source/common/router/tls_context_match_criteria_impl.h"
 #include "source/common/stats/symbol_table_impl.h"
@@ -284,6 +285,8 @@ private:
   absl::optional<envoy::config::route::v3::HedgePolicy> hedge_policy_;
   const CatchAllVirtualCluster virtual_cluster_catch_all_;
   Matcher::MatchTreeSharedPtr<Http::HttpMatchingData> matcher_;
+  // Only set when compiled route matching is enabled. See RouteMatchIndex.
+  RouteMatchIndexConstPtr route_match_index_;
 };
 
 using VirtualHostSharedPtr = std::shared_ptr<VirtualHostImpl>;
@@ -513,6 +516,8 @@ public:
            !prefix_rewrite_redirect_.empty() || regex_rewrite_redirect_ != nullptr;
   }
 
+  bool caseSensitive() const { return case_sensitive_; }
+
   bool matchRoute(const Http::RequestHeaderMap& headers, const StreamInfo::StreamInfo& stream_info,
                   uint64_t random_value) const;
   void validateClusters(const Upstream::ClusterManager::ClusterInfoMaps& cluster_info_maps) const;
@@ -0,0 +1,153 @@
+#include "source/common/router/route_match_index.h"
+
+#include <algorithm>
+
+#include "source/common/common/assert.h"
+#include "source/common/http/path_utility.h"
+
+#include "absl/strings/ascii.h"
+
+namespace Envoy {
+namespace Router {
+
+RouteMatchIndex::RouteMatchIndex()
+    : regex_set_(std::make_unique<re2::RE2::Set>(re2::RE2::Options(re2::RE2::Quiet),
+                                                 re2::RE2::ANCHOR_BOTH)) {}
+
+void RouteMatchIndex::addRoute(PathMatchType type, const std::string& matcher,
+                               bool case_sensitive) {
+  ASSERT(!compiled_);
+  const uint32_t route_index = num_routes_++;
+
+  switch (type) {
+  case PathMatchType::Prefix:
+    if (case_sensitive) {
+      prefixes_.add(matcher, route_index);
+    } else {
+      prefixes_ignore_case_.add(absl::AsciiStrToLower(matcher), route_index);
+    }
+    return;
+  case PathMatchType::Exact:
+    if (case_sensitive) {
+      exact_paths_[matcher].push_back(route_index);
+    } else {
+      exact_paths_ignore_case_[absl::AsciiStrToLower(matcher)].push_back(route_index);
+    }
+    return;
+  case PathMatchType::Regex:
+    // The route has already compiled this regex with the same engine, so this should only fail
+    // in exceptional circumstances. Fall back to always evaluating the route if it does.
+    if (regex_set_->Add(matcher, nullptr) >= 0) {
+      regex_routes_.push_back(route_index);
+      return;
+    }
+    break;
+  case PathMatchType::None:
+    break;
+  }
+
+  unindexed_routes_.push_back(route_index);
+}
+
+void RouteMatchIndex::compile() {
+  ASSERT(!compiled_);
+  compiled_ = true;
+
+  if (regex_routes_.empty()) {
+    regex_set_.reset();
+    return;
+  }
+
+  if (!regex_set_->Compile()) {
+    // Out of memory while compiling the combined automaton. Evaluate regex routes linearly.
+    unindexed_routes_.insert(unindexed_routes_.end(), regex_routes_.begin(), regex_routes_.end());
+    std::sort(unindexed_routes_.begin(), unindexed_routes_.end());
+    regex_routes_.clear();
+    regex_set_.reset();
+  }
+}
+
+void RouteMatchIndex::candidates(absl::string_view path, Candidates& candidates) const {
+  ASSERT(compiled_);
+  candidates.clear();
+  candidates.insert(candidates.end(), unindexed_routes_.begin(), unindexed_routes_.end());
+
+  path = Http::PathUtil::removeQueryAndFragment(path);
+  prefixes_.find(path, candidates);
+  findExact(exact_paths_, path, candidates);
+
+  if (!prefixes_ignore_case_.empty() || !exact_paths_ignore_case_.empty()) {
+    const std::string lower_path = absl::AsciiStrToLower(path);
+    prefixes_ignore_case_.find(lower_path, candidates);
+    findExact(exact_paths_ignore_case_, lower_path, candidates);
+  }
+
+  if (regex_set_ != nullptr) {
+    std::vector<int> matches;
+    re2::RE2::Set::ErrorInfo error_info;
+    if (regex_set_->Match(re2::StringPiece(path.data(), path.size()), &matches, &error_info)) {
+      for (const int match : matches) {
+        candidates.push_back(regex_routes_[match]);
+      }
+    } else if (error_info.kind != re2::RE2::Set::kNoError) {
+      // The DFA ran out of memory. Treat every regex route as a candidate so that the result is
+      // still correct, just slower.
+      candidates.insert(candidates.end(), regex_routes_.begin(), regex_routes_.end());
+    }
+  }
+
+  // Each route lives in exactly one of the structures above, so sorting is enough to restore
+  // route table order.
+  std::sort(candidates.begin(), candidates.end());
+}
+
+void RouteMatchIndex::findExact(const ExactMap& map, absl::string_view path,
+                                Candidates& candidates) {
+  if (map.empty()) {
+    return;
+  }
+  const auto it = map.find(path);
+  if (it != map.end()) {
+    candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+  }
+}
+
+void RouteMatchIndex::PrefixTrie::add(absl::string_view prefix, uint32_t route_index) {
+  empty_ = false;
+  uint32_t node = 0;
+  for (const char c : prefix) {
+    const auto it = nodes_[node].children_.find(c);
+    if (it != nodes_[node].children_.end()) {
+      node = it->second;
+      continue;
+    }
+    const uint32_t child = nodes_.size();
+    // Note: emplace_back may invalidate references into nodes_, so don't hold any across it.
+    nodes_.emplace_back();
+    nodes_[node].children_.emplace(c, child);
+    node = child;
+  }
+  nodes_[node].routes_.push_back(route_index);
+}
+
+void RouteMatchIndex::PrefixTrie::find(absl::string_view path, Candidates& candidates) const {
+  if (empty_) {
+    return;
+  }
+  uint32_t node = 0;
+  for (size_t i = 0;; ++i) {
+    const TrieNode& current = nodes_[node];
+    candidates.insert(candidates.end(), current.routes_.begin(), current.routes_.end());
+    if (i == path.size()) {
+      return;
+    }
+    const auto it = current.children_.find(path[i]);
+    if (it == current.children_.end()) {
+      return;
+    }
+    node = it->second;
+  }
+}
+
+} // namespace Router
+} // namespace Envoy
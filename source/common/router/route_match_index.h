@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/router/router.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/string_view.h"
+#include "re2/set.h"
+
+namespace Envoy {
+namespace Router {
+
+/**
+ * A compiled index over the path match criteria of an ordered route table. The index only narrows
+ * down which routes can possibly match a given path; callers must still evaluate the full route
+ * (headers, query parameters, runtime fractions, etc.) in ascending index order to retain the
+ * first-match-wins semantics of the linear route table.
+ *
+ * - Prefix routes are placed in a byte-wise trie so that all prefixes of a path are found in a
+ *   single walk.
+ * - Exact path routes are placed in a hash map.
+ * - Regex routes are combined into a single anchored RE2::Set.
+ * - Anything that can't be indexed (e.g. CONNECT routes) is returned as a candidate for every
+ *   path.
+ *
+ * Case insensitive prefix and exact routes are kept in a separate trie/map which is queried with
+ * the lower cased path.
+ */
+class RouteMatchIndex {
+public:
+  // Route indexes are returned sorted in ascending order. The inline capacity covers the common
+  // case of a handful of candidates without heap allocation.
+  using Candidates = absl::InlinedVector<uint32_t, 16>;
+
+  RouteMatchIndex();
+
+  /**
+   * Adds the next route in the route table. Routes must be added in table order.
+   * @param type supplies the type of path match performed by the route.
+   * @param matcher supplies the prefix, path or regex used by the route.
+   * @param case_sensitive supplies whether prefix and path matching are case sensitive.
+   */
+  void addRoute(PathMatchType type, const std::string& matcher, bool case_sensitive);
+
+  /**
+   * Compiles the index. Must be called once after all routes have been added and before
+   * candidates() is used.
+   */
+  void compile();
+
+  /**
+   * Finds all routes whose path match criterion may match the supplied path.
+   * @param path supplies the request path. The query string and fragment are ignored.
+   * @param candidates supplies the vector to fill with route indexes, in ascending order.
+   */
+  void candidates(absl::string_view path, Candidates& candidates) const;
+
+  /**
+   * @return the number of routes added to the index.
+   */
+  uint32_t size() const { return num_routes_; }
+
+private:
+  // Nodes are kept in a flat vector and children are referenced by index to keep the trie
+  // compact. Node 0 is always the root.
+  struct TrieNode {
+    absl::flat_hash_map<char, uint32_t> children_;
+    std::vector<uint32_t> routes_;
+  };
+
+  class PrefixTrie {
+  public:
+    PrefixTrie() : nodes_(1) {}
+    void add(absl::string_view prefix, uint32_t route_index);
+    void find(absl::string_view path, Candidates& candidates) const;
+    bool empty() const { return empty_; }
+
+  private:
+    std::vector<TrieNode> nodes_;
+    bool empty_{true};
+  };
+
+  using ExactMap = absl::flat_hash_map<std::string, std::vector<uint32_t>>;
+
+  static void findExact(const ExactMap& map, absl::string_view path, Candidates& candidates);
+
+  uint32_t num_routes_{};
+  bool compiled_{};
+  PrefixTrie prefixes_;
+  PrefixTrie prefixes_ignore_case_;
+  ExactMap exact_paths_;
+  ExactMap exact_paths_ignore_case_;
+  std::unique_ptr<re2::RE2::Set> regex_set_;
+  // Maps RE2::Set pattern indexes back to route indexes.
+  std::vector<uint32_t> regex_routes_;
+  std::vector<uint32_t> unindexed_routes_;
+};
+
+using RouteMatchIndexConstPtr = std::unique_ptr<const RouteMatchIndex>;
+
+} // namespace Router
+} // namespace Envoy
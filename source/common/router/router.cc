@@ -929,6 +929,7 @@ void Filter::onResponseTimeout() {
         updateOutlierDetection(Upstream::Outlier::Result::LocalOriginTimeout, *upstream_request,
                                absl::optional<uint64_t>(enumToInt(timeout_response_code_)));
       }
+      putLatencyPenalty(*upstream_request);
 
       chargeUpstreamAbort(timeout_response_code_, false, *upstream_request);
     }
@@ -997,6 +998,7 @@ void Filter::onPerTryTimeoutCommon(UpstreamRequest& upstream_request, Stats::Cou
 
   updateOutlierDetection(Upstream::Outlier::Result::LocalOriginTimeout, upstream_request,
                          absl::optional<uint64_t>(enumToInt(timeout_response_code_)));
+  putLatencyPenalty(upstream_request);
 
   if (maybeRetryReset(Http::StreamResetReason::LocalReset, upstream_request)) {
     return;
@@ -1135,6 +1137,10 @@ void Filter::onUpstreamReset(Http::StreamResetReason reset_reason,
   // config param set to true.
   updateOutlierDetection(Upstream::Outlier::Result::LocalOriginConnectFailed, upstream_request,
                          absl::nullopt);
+  // An overflow is local to this Envoy, the host was not tried.
+  if (reset_reason != Http::StreamResetReason::Overflow) {
+    putLatencyPenalty(upstream_request);
+  }
 
   if (maybeRetryReset(reset_reason, upstream_request)) {
     return;
@@ -1174,6 +1180,20 @@ void Filter::onUpstreamReset(Http::StreamResetReason reset_reason,
   onUpstreamAbort(error_code, response_flags, body, dropped, details);
 }
 
+void Filter::putLatencyPenalty(UpstreamRequest& upstream_request) {
+  // Without a sample, a host timing out or resetting its streams would keep the latency estimate
+  // of its last successes, and keep attracting requests from latency aware load balancers.
+  const std::chrono::milliseconds penalty = timeout_.per_try_timeout_.count() > 0
+                                                ? timeout_.per_try_timeout_
+                                                : timeout_.global_timeout_;
+  if (upstream_request.upstreamHost() == nullptr || penalty.count() == 0 ||
+      upstream_request.upstreamTiming().first_upstream_rx_byte_received_.has_value()) {
+    return;
+  }
+  upstream_request.upstreamHost()->latencyEstimator().putRoundTripTime(
+      std::chrono::duration_cast<std::chrono::microseconds>(penalty));
+}
+
 void Filter::onUpstreamHostSelected(Upstream::HostDescriptionConstSharedPtr host) {
   if (retry_state_ && host) {
     retry_state_->onHostAttempted(host);
@@ -1482,6 +1502,17 @@ void Filter::onUpstreamComplete(UpstreamRequest& upstream_request) {
         FilterUtility::percentageOfTimeout(response_time, timeout_.global_timeout_));
   }
 
+  // Feed the latency estimate used by latency aware load balancers. The time to the first response
+  // byte is used so that large response bodies don't make a host look slow.
+  const StreamInfo::UpstreamTiming& upstream_timing = upstream_request.upstreamTiming();
+  if (upstream_timing.first_upstream_tx_byte_sent_.has_value() &&
+      upstream_timing.first_upstream_rx_byte_received_.has_value()) {
+    upstream_request.upstreamHost()->latencyEstimator().putRoundTripTime(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            upstream_timing.first_upstream_rx_byte_received_.value() -
+            upstream_timing.first_upstream_tx_byte_sent_.value()));
+  }
+
   if (config_.emit_dynamic_stats_ && !callbacks_->streamInfo().healthCheck() &&
       DateUtil::timePointValid(downstream_request_complete_time_)) {
     upstream_request.upstreamHost()->outlierDetector().putResponseTime(response_time);
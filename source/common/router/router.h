@@ -481,6 +481,9 @@ private:
   void chargeUpstreamCode(Http::Code code, Upstream::HostDescriptionConstSharedPtr upstream_host,
                           bool dropped);
   void chargeUpstreamAbort(Http::Code code, bool dropped, UpstreamRequest& upstream_request);
+  // Feeds the latency estimate of the upstream host with the timeout of the request, when the
+  // request failed before the first response byte.
+  void putLatencyPenalty(UpstreamRequest& upstream_request);
   void cleanup();
   virtual RetryStatePtr createRetryState(const RetryPolicy& policy,
                                          Http::RequestHeaderMap& request_headers,
@@ -107,8 +107,23 @@ constexpr const char* runtime_features[] = {
 constexpr const char* disabled_runtime_features[] = {
     // TODO(alyssawilk, junr03) flip (and add release notes + docs) these after Lyft tests
     "envoy.reloadable_features.allow_multiple_dns_addresses",
+    // Compiles each virtual host's route table into a prefix trie, exact path map and RE2::Set
+    // index at config load.
+    "envoy.reloadable_features.compiled_route_matching",
+    // Reuses the hosts of unchanged EDS endpoints and keeps the per-locality grouping of priorities
+    // whose membership did not change.
+    "envoy.reloadable_features.eds_incremental_host_updates",
+    // Stores the entries of header maps in a per map arena rather than one std::list node each.
+    "envoy.reloadable_features.header_map_contiguous_storage",
+    // Parses HTTP/1 with the vectorized parser rather than http_parser.
+    "envoy.reloadable_features.http1_use_vectorized_parser",
+    // Allocates the per filter objects of HTTP streams from a per stream arena.
+    "envoy.reloadable_features.http_stream_arena",
     // TODO(asraa) flip to true in a separate PR to enable the new JSON by default.
     "envoy.reloadable_features.remove_legacy_json",
+    // Evaluates load balancer subset membership using an index of the host metadata values of the
+    // subset selector keys.
+    "envoy.reloadable_features.subset_lb_compiled_index",
     // Sentinel and test flag.
     "envoy.reloadable_features.test_feature_false",
     // When the runtime is flipped to true, use shared cache in getOrCreateRawAsyncClient method if
@@ -26,6 +26,13 @@ HistogramStatisticsImpl::HistogramStatisticsImpl(const histogram_t* histogram_pt
   refresh(histogram_ptr);
 }
 
+HistogramStatisticsImpl::HistogramStatisticsImpl(Histogram::Unit unit,
+                                                 ConstSupportedBuckets& supported_buckets)
+    : supported_buckets_(supported_buckets),
+      computed_quantiles_(HistogramStatisticsImpl::supportedQuantiles().size(), 0.0),
+      computed_buckets_(supported_buckets.size(), 0), sample_count_(0), sample_sum_(0),
+      unit_(unit) {}
+
 const std::vector<double>& HistogramStatisticsImpl::supportedQuantiles() const {
   CONSTRUCT_ON_FIRST_USE(std::vector<double>,
                          {0, 0.25, 0.5, 0.75, 0.90, 0.95, 0.99, 0.995, 0.999, 1});
@@ -87,6 +94,52 @@ void HistogramStatisticsImpl::refresh(const histogram_t* new_histogram_ptr) {
   }
 }
 
+void HistogramStatisticsImpl::refresh(const std::vector<uint64_t>& bucket_counts,
+                                      uint64_t sample_sum) {
+  ConstSupportedBuckets& supported_buckets = supportedBuckets();
+  ASSERT(bucket_counts.size() == supported_buckets.size() + 1);
+
+  // The bucket counts are in the unit's scale already, see ThreadLocalHistogramImpl::recordValue.
+  computed_buckets_.resize(supported_buckets.size());
+  uint64_t cumulative_count = 0;
+  for (size_t i = 0; i < supported_buckets.size(); ++i) {
+    cumulative_count += bucket_counts[i];
+    computed_buckets_[i] = cumulative_count;
+  }
+  sample_count_ = cumulative_count + bucket_counts.back();
+  sample_sum_ = sample_sum;
+  if (unit_ == Histogram::Unit::Percent) {
+    sample_sum_ /= Histogram::PercentScale;
+  }
+
+  // Interpolates each quantile linearly within the bucket it falls into. The lowest bucket starts
+  // at zero, and values above the last bucket are only known to be larger than its bound.
+  const std::vector<double>& supported_quantiles = supportedQuantiles();
+  size_t bucket = 0;
+  uint64_t count_below = 0;
+  for (size_t i = 0; i < supported_quantiles.size(); ++i) {
+    if (sample_count_ == 0) {
+      computed_quantiles_[i] = 0.0;
+      continue;
+    }
+    const double rank = supported_quantiles[i] * sample_count_;
+    // Quantiles are increasing, so the search continues from the previous quantile's bucket.
+    while (bucket < supported_buckets.size() &&
+           (bucket_counts[bucket] == 0 || count_below + bucket_counts[bucket] < rank)) {
+      count_below += bucket_counts[bucket];
+      ++bucket;
+    }
+    if (bucket == supported_buckets.size()) {
+      computed_quantiles_[i] = supported_buckets.empty() ? 0.0 : supported_buckets.back();
+      continue;
+    }
+    const double lower_bound = bucket == 0 ? 0.0 : supported_buckets[bucket - 1];
+    const double fraction = (rank - count_below) / bucket_counts[bucket];
+    computed_quantiles_[i] =
+        lower_bound + (supported_buckets[bucket] - lower_bound) * std::max(fraction, 0.0);
+  }
+}
+
 HistogramSettingsImpl::HistogramSettingsImpl(const envoy::config::metrics::v3::StatsConfig& config)
     : configs_([&config]() {
         std::vector<Config> configs;
@@ -97,7 +150,9 @@ HistogramSettingsImpl::HistogramSettingsImpl(const envoy::config::metrics::v3::S
         }
 
         return configs;
-      }()) {}
+      }()),
+      fixed_buckets_(config.histogram_mode() ==
+                     envoy::config::metrics::v3::StatsConfig::FIXED_BUCKETS) {}
 
 const ConstSupportedBuckets& HistogramSettingsImpl::buckets(absl::string_view stat_name) const {
   for (const auto& config : configs_) {
@@ -24,6 +24,7 @@ public:
 
   // HistogramSettings
   const ConstSupportedBuckets& buckets(absl::string_view stat_name) const override;
+  bool fixedBuckets() const override { return fixed_buckets_; }
 
   static ConstSupportedBuckets& defaultBuckets();
 
@@ -31,6 +32,7 @@ private:
   using Config = std::pair<Matchers::StringMatcherImpl<envoy::type::matcher::v3::StringMatcher>,
                            ConstSupportedBuckets>;
   const std::vector<Config> configs_{};
+  const bool fixed_buckets_{};
 };
 
 /**
@@ -49,10 +51,25 @@ public:
       const histogram_t* histogram_ptr, Histogram::Unit unit = Histogram::Unit::Unspecified,
       ConstSupportedBuckets& supported_buckets = HistogramSettingsImpl::defaultBuckets());
 
+  /**
+   * HistogramStatisticsImpl object for a histogram that only counts its values in the supported
+   * buckets. All statistics are zero until refreshed with the bucket counts.
+   */
+  HistogramStatisticsImpl(Histogram::Unit unit, ConstSupportedBuckets& supported_buckets);
+
   static ConstSupportedBuckets& defaultSupportedBuckets();
 
   void refresh(const histogram_t* new_histogram_ptr);
 
+  /**
+   * Refreshes the statistics from the counts of a histogram that only counts its values in the
+   * supported buckets.
+   * @param bucket_counts the number of values that fell into each of the supported buckets,
+   *        followed by the number of values above the last bucket.
+   * @param sample_sum the sum of the recorded values.
+   */
+  void refresh(const std::vector<uint64_t>& bucket_counts, uint64_t sample_sum);
+
   // HistogramStatistics
   std::string quantileSummary() const override;
   std::string bucketSummary() const override;
@@ -3,12 +3,14 @@
 #include <algorithm>
 #include <iostream>
 #include <memory>
+#include <tuple>
 #include <vector>
 
 #include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
 #include "source/common/common/utility.h"
 
+#include "absl/numeric/bits.h"
 #include "absl/strings/str_cat.h"
 
 namespace Envoy {
@@ -194,11 +196,9 @@ bool StatName::startsWith(StatName symbolic_prefix) const {
 std::vector<absl::string_view> SymbolTableImpl::decodeStrings(const SymbolTable::Storage array,
                                                               size_t size) const {
   std::vector<absl::string_view> strings;
-  Thread::LockGuard lock(lock_);
+  // The symbols are referenced by the caller, so their strings stay valid without a lock.
   Encoding::decodeTokens(
-      array, size,
-      [this, &strings](Symbol symbol)
-          ABSL_NO_THREAD_SAFETY_ANALYSIS { strings.push_back(fromSymbol(symbol)); },
+      array, size, [this, &strings](Symbol symbol) { strings.push_back(fromSymbol(symbol)); },
       [&strings](absl::string_view str) { strings.push_back(str); });
   return strings;
 }
@@ -221,7 +221,7 @@ void SymbolTableImpl::Encoding::appendToMemBlock(StatName stat_name,
 
 SymbolTableImpl::SymbolTableImpl()
     // Have to be explicitly initialized, if we want to use the ABSL_GUARDED_BY macro.
-    : next_symbol_(FirstValidSymbol), monotonic_counter_(FirstValidSymbol) {}
+    : monotonic_counter_(FirstValidSymbol) {}
 
 SymbolTableImpl::~SymbolTableImpl() {
   // To avoid leaks into the symbol table, we expect all StatNames to be freed.
@@ -229,6 +229,9 @@ SymbolTableImpl::~SymbolTableImpl() {
   // is needed in production. But it would be good to ensure clean up during
   // tests.
   ASSERT(numSymbols() == 0);
+  for (std::atomic<DecodeSlot*>& segment : segments_) {
+    delete[] segment.load();
+  }
 }
 
 // TODO(ambuc): There is a possible performance optimization here for avoiding
@@ -239,24 +242,25 @@ void SymbolTableImpl::addTokensToEncoding(const absl::string_view name, Encoding
     return;
   }
 
-  // We want to hold the lock for the minimum amount of time, so we do the
-  // string-splitting and prepare a temp vector of Symbol first.
   const std::vector<absl::string_view> tokens = absl::StrSplit(name, '.');
   std::vector<Symbol> symbols;
   symbols.reserve(tokens.size());
 
-  // Now take the lock and populate the Symbol objects, which involves bumping
-  // ref-counts in this.
-  {
+  if (recent_lookups_enabled_.load(std::memory_order_relaxed)) {
     Thread::LockGuard lock(lock_);
     recent_lookups_.lookup(name);
-    for (auto& token : tokens) {
-      // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
-      // length below some threshold, say 4 bytes. It might be preferable not to
-      // reserve Symbols for every 3 digit number found (for example) in ipv4
-      // addresses.
-      symbols.push_back(toSymbol(token));
-    }
+  } else {
+    lookup_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  // Populate the Symbol objects, which involves bumping ref-counts in this. Each token only takes
+  // the lock of its shard.
+  for (auto& token : tokens) {
+    // TODO(jmarantz): consider using StatNameDynamicStorage for tokens with
+    // length below some threshold, say 4 bytes. It might be preferable not to
+    // reserve Symbols for every 3 digit number found (for example) in ipv4
+    // addresses.
+    symbols.push_back(toSymbol(token));
   }
 
   // Now efficiently encode the array of 32-bit symbols into a uint8_t array.
@@ -264,9 +268,12 @@ void SymbolTableImpl::addTokensToEncoding(const absl::string_view name, Encoding
 }
 
 uint64_t SymbolTableImpl::numSymbols() const {
-  Thread::LockGuard lock(lock_);
-  ASSERT(encode_map_.size() == decode_map_.size());
-  return encode_map_.size();
+  uint64_t num_symbols = 0;
+  for (const Shard& shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex_);
+    num_symbols += shard.encode_map_.size();
+  }
+  return num_symbols;
 }
 
 std::string SymbolTableImpl::toString(const StatName& stat_name) const {
@@ -277,21 +284,9 @@ void SymbolTableImpl::incRefCount(const StatName& stat_name) {
   // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
   const SymbolVec symbols = Encoding::decodeSymbols(stat_name.data(), stat_name.dataSize());
 
-  Thread::LockGuard lock(lock_);
+  // The caller holds a reference to the symbols, so they can't be removed concurrently.
   for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-
-    ASSERT(decode_search != decode_map_.end(),
-           "Please see "
-           "https://github.com/envoyproxy/envoy/blob/main/source/docs/stats.md#"
-           "debugging-symbol-table-assertions");
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end(),
-           "Please see "
-           "https://github.com/envoyproxy/envoy/blob/main/source/docs/stats.md#"
-           "debugging-symbol-table-assertions");
-
-    ++encode_search->second.ref_count_;
+    sharedSymbol(symbol).ref_count_.fetch_add(1, std::memory_order_relaxed);
   }
 }
 
@@ -299,26 +294,38 @@ void SymbolTableImpl::free(const StatName& stat_name) {
   // Before taking the lock, decode the array of symbols from the SymbolTable::Storage.
   const SymbolVec symbols = Encoding::decodeSymbols(stat_name.data(), stat_name.dataSize());
 
-  Thread::LockGuard lock(lock_);
   for (Symbol symbol : symbols) {
-    auto decode_search = decode_map_.find(symbol);
-    ASSERT(decode_search != decode_map_.end());
-
-    auto encode_search = encode_map_.find(decode_search->second->toStringView());
-    ASSERT(encode_search != encode_map_.end());
-
-    // If that was the last remaining client usage of the symbol, erase the
-    // current mappings and add the now-unused symbol to the reuse pool.
-    //
-    // The "if (--EXPR.ref_count_)" pattern speeds up BM_CreateRace by 20% in
-    // symbol_table_speed_test.cc, relative to breaking out the decrement into a
-    // separate step, likely due to the non-trivial dereferences in EXPR.
-    if (--encode_search->second.ref_count_ == 0) {
-      decode_map_.erase(decode_search);
-      encode_map_.erase(encode_search);
-      pool_.push(symbol);
+    releaseSymbol(symbol);
+  }
+}
+
+void SymbolTableImpl::releaseSymbol(Symbol symbol) {
+  SharedSymbol& shared_symbol = sharedSymbol(symbol);
+
+  // Unless this is the last reference, the count is decremented without taking the shard lock.
+  uint32_t ref_count = shared_symbol.ref_count_.load(std::memory_order_relaxed);
+  while (ref_count > 1) {
+    if (shared_symbol.ref_count_.compare_exchange_weak(ref_count, ref_count - 1,
+                                                       std::memory_order_acq_rel)) {
+      return;
     }
   }
+
+  // The symbol may be encoded again on another thread until the shard lock is taken exclusively.
+  Shard& shard = shardFor(shared_symbol.str_->toStringView());
+  absl::MutexLock shard_lock(&shard.mutex_);
+  if (shared_symbol.ref_count_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+
+  // That was the last remaining client usage of the symbol, so erase the
+  // current mappings and add the now-unused symbol to the reuse pool.
+  decodeSlot(symbol)->store(nullptr, std::memory_order_relaxed);
+  auto encode_search = shard.encode_map_.find(shared_symbol.str_->toStringView());
+  ASSERT(encode_search != shard.encode_map_.end());
+  shard.encode_map_.erase(encode_search);
+  Thread::LockGuard lock(lock_);
+  pool_.push(symbol);
 }
 
 uint64_t SymbolTableImpl::getRecentLookups(const RecentLookupsFn& iter) const {
@@ -334,6 +341,7 @@ uint64_t SymbolTableImpl::getRecentLookups(const RecentLookupsFn& iter) const {
             ABSL_NO_THREAD_SAFETY_ANALYSIS { name_count_map[std::string(str)] += count; });
     total += recent_lookups_.total();
   }
+  total += lookup_count_.load(std::memory_order_relaxed);
 
   // Now we have the collated name-count map data: we need to vectorize and
   // sort. We define the pair with the count first as std::pair::operator<
@@ -380,11 +388,13 @@ DynamicSpans SymbolTableImpl::getDynamicSpans(StatName stat_name) const {
 void SymbolTableImpl::setRecentLookupCapacity(uint64_t capacity) {
   Thread::LockGuard lock(lock_);
   recent_lookups_.setCapacity(capacity);
+  recent_lookups_enabled_ = capacity > 0;
 }
 
 void SymbolTableImpl::clearRecentLookups() {
   Thread::LockGuard lock(lock_);
   recent_lookups_.clear();
+  lookup_count_ = 0;
 }
 
 uint64_t SymbolTableImpl::recentLookupCapacity() const {
@@ -399,47 +409,84 @@ StatNameSetPtr SymbolTableImpl::makeSet(absl::string_view name) {
 }
 
 Symbol SymbolTableImpl::toSymbol(absl::string_view sv) {
-  Symbol result;
-  auto encode_find = encode_map_.find(sv);
-  // If the string segment doesn't already exist,
-  if (encode_find == encode_map_.end()) {
-    // We create the actual string, place it in the decode_map_, and then insert
-    // a string_view pointing to it in the encode_map_. This allows us to only
-    // store the string once. We use unique_ptr so copies are not made as
-    // flat_hash_map moves values around.
-    InlineStringPtr str = InlineString::create(sv);
-    auto encode_insert = encode_map_.insert({str->toStringView(), SharedSymbol(next_symbol_)});
-    ASSERT(encode_insert.second);
-    auto decode_insert = decode_map_.insert({next_symbol_, std::move(str)});
-    ASSERT(decode_insert.second);
-
-    result = next_symbol_;
-    newSymbol();
-  } else {
-    // If the insertion didn't take place, return the actual value at that location and up the
-    // refcount at that location
-    result = encode_find->second.symbol_;
-    ++(encode_find->second.ref_count_);
+  Shard& shard = shardFor(sv);
+
+  // Existing symbols are only looked up, so encoding them on different threads doesn't serialize.
+  {
+    absl::ReaderMutexLock lock(&shard.mutex_);
+    auto encode_find = shard.encode_map_.find(sv);
+    if (encode_find != shard.encode_map_.end()) {
+      encode_find->second->ref_count_.fetch_add(1, std::memory_order_relaxed);
+      return encode_find->second->symbol_;
+    }
+  }
+
+  absl::MutexLock lock(&shard.mutex_);
+  // Another thread may have added the string segment meanwhile.
+  auto encode_find = shard.encode_map_.find(sv);
+  if (encode_find != shard.encode_map_.end()) {
+    encode_find->second->ref_count_.fetch_add(1, std::memory_order_relaxed);
+    return encode_find->second->symbol_;
   }
-  return result;
+
+  // We create the actual string, owned by the SharedSymbol, and then insert a string_view
+  // pointing to it in the encode map. This allows us to only store the string once.
+  Symbol symbol;
+  {
+    Thread::LockGuard symbol_lock(lock_);
+    symbol = allocateSymbol();
+  }
+  auto shared_symbol = std::make_unique<SharedSymbol>(InlineString::create(sv), symbol);
+  decodeSlot(symbol)->store(shared_symbol.get(), std::memory_order_release);
+  const absl::string_view str = shared_symbol->str_->toStringView();
+  auto encode_insert = shard.encode_map_.emplace(str, std::move(shared_symbol));
+  ASSERT(encode_insert.second);
+  return symbol;
 }
 
-absl::string_view SymbolTableImpl::fromSymbol(const Symbol symbol) const
-    ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
-  auto search = decode_map_.find(symbol);
-  RELEASE_ASSERT(search != decode_map_.end(), "no such symbol");
-  return search->second->toStringView();
+absl::string_view SymbolTableImpl::fromSymbol(const Symbol symbol) const {
+  return sharedSymbol(symbol).str_->toStringView();
 }
 
-void SymbolTableImpl::newSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
-  if (pool_.empty()) {
-    next_symbol_ = ++monotonic_counter_;
-  } else {
-    next_symbol_ = pool_.top();
+SymbolTableImpl::SharedSymbol& SymbolTableImpl::sharedSymbol(Symbol symbol) const {
+  DecodeSlot* slot = decodeSlot(symbol);
+  SharedSymbol* shared_symbol =
+      slot == nullptr ? nullptr : slot->load(std::memory_order_acquire);
+  RELEASE_ASSERT(shared_symbol != nullptr, "no such symbol");
+  return *shared_symbol;
+}
+
+SymbolTableImpl::DecodeSlot* SymbolTableImpl::decodeSlot(Symbol symbol) const {
+  const uint64_t index = symbol / FirstSegmentSize + 1;
+  const uint32_t segment = absl::bit_width(index) - 1;
+  if (segment >= NumSegments) {
+    return nullptr;
+  }
+  DecodeSlot* slots = segments_[segment].load(std::memory_order_acquire);
+  if (slots == nullptr) {
+    return nullptr;
+  }
+  return &slots[symbol - FirstSegmentSize * ((uint64_t(1) << segment) - 1)];
+}
+
+Symbol SymbolTableImpl::allocateSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_) {
+  if (!pool_.empty()) {
+    const Symbol symbol = pool_.top();
     pool_.pop();
+    return symbol;
   }
+  const Symbol symbol = monotonic_counter_++;
   // This should catch integer overflow for the new symbol.
   ASSERT(monotonic_counter_ != 0);
+
+  // Symbols are handed out in order, so the segment is added when its first symbol is.
+  if (decodeSlot(symbol) == nullptr) {
+    const uint32_t segment = absl::bit_width(uint64_t(symbol) / FirstSegmentSize + 1) - 1;
+    RELEASE_ASSERT(segment < NumSegments, "symbol table is full");
+    segments_[segment].store(new DecodeSlot[uint64_t(FirstSegmentSize) << segment]{},
+                             std::memory_order_release);
+  }
+  return symbol;
 }
 
 bool SymbolTableImpl::lessThan(const StatName& a, const StatName& b) const {
@@ -461,16 +508,16 @@ bool SymbolTableImpl::lessThan(const StatName& a, const StatName& b) const {
 
 #ifndef ENVOY_CONFIG_COVERAGE
 void SymbolTableImpl::debugPrint() const {
-  Thread::LockGuard lock(lock_);
-  std::vector<Symbol> symbols;
-  for (const auto& p : decode_map_) {
-    symbols.push_back(p.first);
+  std::vector<std::tuple<Symbol, std::string, uint32_t>> symbols;
+  for (const Shard& shard : shards_) {
+    absl::ReaderMutexLock lock(&shard.mutex_);
+    for (const auto& p : shard.encode_map_) {
+      symbols.emplace_back(p.second->symbol_, std::string(p.first), p.second->ref_count_.load());
+    }
   }
   std::sort(symbols.begin(), symbols.end());
-  for (Symbol symbol : symbols) {
-    const InlineString& token = *decode_map_.find(symbol)->second;
-    const SharedSymbol& shared_symbol = encode_map_.find(token.toStringView())->second;
-    ENVOY_LOG_MISC(info, "{}: '{}' ({})", symbol, token.toStringView(), shared_symbol.ref_count_);
+  for (const auto& [symbol, token, ref_count] : symbols) {
+    ENVOY_LOG_MISC(info, "{}: '{}' ({})", symbol, token, ref_count);
   }
 }
 #endif
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <stack>
@@ -23,6 +25,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
+#include "absl/synchronization/mutex.h"
 
 namespace Envoy {
 namespace Stats {
@@ -62,6 +65,10 @@ using SymbolVec = std::vector<Symbol>;
  * that if a string is encoded, the resulting stat is destroyed, and then that
  * same string is re-encoded, it may or may not encode to the same underlying
  * symbol.
+ *
+ * Encoding, decoding and freeing names whose symbols already exist doesn't take
+ * a table-wide lock: symbols are decoded without locks, and are looked up by
+ * string in shards which are only locked exclusively to add or remove symbols.
  */
 class SymbolTableImpl : public SymbolTable {
 public:
@@ -204,13 +211,38 @@ private:
   friend class StatNameDeathTest;
 
   struct SharedSymbol {
-    SharedSymbol(Symbol symbol) : symbol_(symbol), ref_count_(1) {}
-
-    Symbol symbol_;
-    uint32_t ref_count_;
+    SharedSymbol(InlineStringPtr&& str, Symbol symbol)
+        : str_(std::move(str)), symbol_(symbol), ref_count_(1) {}
+
+    const InlineStringPtr str_;
+    const Symbol symbol_;
+    // Only drops to 0 with the shard lock held exclusively, and the symbol is then removed from the
+    // shard in the same critical section. Holders of a shared shard lock thus always see a
+    // positive count, and can bump it without taking the shard lock exclusively.
+    std::atomic<uint32_t> ref_count_;
   };
+  using SharedSymbolPtr = std::unique_ptr<SharedSymbol>;
+
+  // The symbols are spread over shards by the hash of their string, so that encoding names on
+  // different threads rarely contends on the same lock, and encoding existing symbols only takes
+  // the lock of their shard shared.
+  static constexpr uint32_t NumShards = 16;
+  struct alignas(64) Shard {
+    // Using absl::string_view lets us only store the complete string once, in the SharedSymbol.
+    using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbolPtr>;
+
+    mutable absl::Mutex mutex_;
+    EncodeMap encode_map_ ABSL_GUARDED_BY(mutex_);
+  };
+
+  // Maps symbols to their SharedSymbol without taking locks. The slots live in segments of doubling
+  // sizes which are never moved, so a slot can be read while more segments are being added.
+  // Segment k holds the symbols [FirstSegmentSize * (2^k - 1), FirstSegmentSize * (2^(k+1) - 1)).
+  static constexpr uint32_t FirstSegmentSize = 256;
+  static constexpr uint32_t NumSegments = 24;
+  using DecodeSlot = std::atomic<SharedSymbol*>;
 
-  // This must be held during both encode() and free().
+  // This must be held while allocating and releasing symbols, and while recording recent lookups.
   mutable Thread::MutexBasicLockable lock_;
 
   /**
@@ -234,20 +266,39 @@ private:
    * @param sv the individual string to be encoded as a symbol.
    * @return Symbol the encoded string.
    */
-  Symbol toSymbol(absl::string_view sv) ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  Symbol toSymbol(absl::string_view sv);
 
   /**
-   * Convenience function for decode(), decoding one symbol at a time.
+   * Convenience function for decode(), decoding one symbol at a time. The symbol must be referenced
+   * by the caller.
    *
    * @param symbol the individual symbol to be decoded.
    * @return absl::string_view the decoded string.
    */
-  absl::string_view fromSymbol(Symbol symbol) const ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  absl::string_view fromSymbol(Symbol symbol) const;
 
   /**
-   * Stages a new symbol for use. To be called after a successful insertion.
+   * @return the SharedSymbol of a symbol referenced by the caller.
    */
-  void newSymbol();
+  SharedSymbol& sharedSymbol(Symbol symbol) const;
+
+  /**
+   * @return the decode slot of a symbol, or nullptr if no symbol this large was allocated.
+   */
+  DecodeSlot* decodeSlot(Symbol symbol) const;
+
+  /**
+   * Takes a symbol from the free pool, or a new one if the pool is empty, and allocates its decode
+   * slot.
+   */
+  Symbol allocateSymbol() ABSL_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  /**
+   * Drops a reference to a symbol, removing it once it is no longer referenced.
+   */
+  void releaseSymbol(Symbol symbol);
+
+  Shard& shardFor(absl::string_view sv) { return shards_[HashUtil::xxHash64(sv) % NumShards]; }
 
   /**
    * Tokenizes name, finds or allocates symbols for each token, and adds them
@@ -263,26 +314,22 @@ private:
     return monotonic_counter_;
   }
 
-  // Stores the symbol to be used at next insertion. This should exist ahead of insertion time so
-  // that if insertion succeeds, the value written is the correct one.
-  Symbol next_symbol_ ABSL_GUARDED_BY(lock_);
-
   // If the free pool is exhausted, we monotonically increase this counter.
-  Symbol monotonic_counter_;
+  Symbol monotonic_counter_ ABSL_GUARDED_BY(lock_);
 
-  // Bitmap implementation.
-  // The encode map stores both the symbol and the ref count of that symbol.
-  // Using absl::string_view lets us only store the complete string once, in the decode map.
-  using EncodeMap = absl::flat_hash_map<absl::string_view, SharedSymbol>;
-  using DecodeMap = absl::flat_hash_map<Symbol, InlineStringPtr>;
-  EncodeMap encode_map_ ABSL_GUARDED_BY(lock_);
-  DecodeMap decode_map_ ABSL_GUARDED_BY(lock_);
+  std::array<Shard, NumShards> shards_;
+  // Written with lock_ held.
+  std::array<std::atomic<DecodeSlot*>, NumSegments> segments_{};
 
   // Free pool of symbols for re-use.
   // TODO(ambuc): There might be an optimization here relating to storing ranges of freed symbols
   // using an Envoy::IntervalSet.
   std::stack<Symbol> pool_ ABSL_GUARDED_BY(lock_);
   RecentLookups recent_lookups_ ABSL_GUARDED_BY(lock_);
+  // Whether recent_lookups_ has a capacity. While it doesn't, lookups are only counted, in
+  // lookup_count_, so that encoding doesn't take lock_.
+  std::atomic<bool> recent_lookups_enabled_{};
+  std::atomic<uint64_t> lookup_count_{};
 };
 
 // Base class for holding the backing-storing for a StatName. The two derived
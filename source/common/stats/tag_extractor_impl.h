@@ -89,7 +89,6 @@ public:
    */
   bool substrMismatch(absl::string_view stat_name) const;
 
-protected:
   /**
    * Examines a regex string, looking for the pattern: ^alphanumerics_with_underscores\.
    * Returns "alphanumerics_with_underscores" if that pattern is found, empty-string otherwise.
@@ -98,6 +97,7 @@ protected:
    */
   static std::string extractRegexPrefix(absl::string_view regex);
 
+protected:
   /**
    * Adds a new tag for the current name, returning a reference to the tag value.
    *
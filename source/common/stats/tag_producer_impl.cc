@@ -16,6 +16,10 @@ TagProducerImpl::TagProducerImpl(const envoy::config::metrics::v3::StatsConfig&
 
 TagProducerImpl::TagProducerImpl(const envoy::config::metrics::v3::StatsConfig& config,
                                  const Stats::TagVector& cli_tags) {
+  if (config.compiled_tag_extraction()) {
+    regex_set_ = std::make_unique<re2::RE2::Set>(re2::RE2::Options(re2::RE2::Quiet),
+                                                 re2::RE2::UNANCHORED);
+  }
   // To check name conflict.
   reserveResources(config);
   absl::node_hash_set<std::string> names = addDefaultExtractors(config);
@@ -45,21 +49,21 @@ TagProducerImpl::TagProducerImpl(const envoy::config::metrics::v3::StatsConfig&
               "No regex specified for tag specifier and no default regex for name: '{}'", name));
         }
       } else {
-        addExtractor(TagExtractorImplBase::createTagExtractor(name, tag_specifier.regex()));
+        addRegexExtractor(name, tag_specifier.regex(), "", Regex::Type::StdRegex);
       }
     } else if (tag_specifier.tag_value_case() ==
                envoy::config::metrics::v3::TagSpecifier::TagValueCase::kFixedValue) {
       default_tags_.emplace_back(Tag{name, tag_specifier.fixed_value()});
     }
   }
+  compileRegexSet();
 }
 
 int TagProducerImpl::addExtractorsMatching(absl::string_view name) {
   int num_found = 0;
   for (const auto& desc : Config::TagNames::get().descriptorVec()) {
     if (desc.name_ == name) {
-      addExtractor(TagExtractorImplBase::createTagExtractor(desc.name_, desc.regex_, desc.substr_,
-                                                            desc.re_type_));
+      addRegexExtractor(desc.name_, desc.regex_, desc.substr_, desc.re_type_);
       ++num_found;
     }
   }
@@ -72,29 +76,59 @@ int TagProducerImpl::addExtractorsMatching(absl::string_view name) {
   return num_found;
 }
 
-void TagProducerImpl::addExtractor(TagExtractorPtr extractor) {
+void TagProducerImpl::addExtractor(TagExtractorPtr extractor, int regex_set_index) {
   const absl::string_view prefix = extractor->prefixToken();
   if (prefix.empty()) {
-    tag_extractors_without_prefix_.emplace_back(std::move(extractor));
+    tag_extractors_without_prefix_.push_back({std::move(extractor), regex_set_index});
   } else {
-    tag_extractor_prefix_map_[prefix].emplace_back(std::move(extractor));
+    tag_extractor_prefix_map_[prefix].push_back({std::move(extractor), regex_set_index});
   }
 }
 
-void TagProducerImpl::forEachExtractorMatching(
-    absl::string_view stat_name, std::function<void(const TagExtractorPtr&)> f) const {
-  IntervalSetImpl<size_t> remove_characters;
-  for (const TagExtractorPtr& tag_extractor : tag_extractors_without_prefix_) {
-    f(tag_extractor);
+void TagProducerImpl::addRegexExtractor(absl::string_view name, absl::string_view regex,
+                                        absl::string_view substr, Regex::Type re_type) {
+  int regex_set_index = -1;
+  // Extractors with a prefix token or a required substring are only evaluated against the
+  // stat-names passing those checks, which is cheaper than matching every stat-name against the
+  // set. Empty names and regexes are rejected by createTagExtractor.
+  if (regex_set_ != nullptr && substr.empty() && !name.empty() && !regex.empty() &&
+      TagExtractorImplBase::extractRegexPrefix(regex).empty()) {
+    regex_set_index = regex_set_->Add(re2::StringPiece(regex.data(), regex.size()), nullptr);
+    if (regex_set_index >= 0) {
+      re_type = Regex::Type::Re2;
+      ++regex_set_size_;
+    }
   }
+  addExtractor(TagExtractorImplBase::createTagExtractor(name, regex, substr, re_type),
+               regex_set_index);
+}
+
+void TagProducerImpl::compileRegexSet() {
+  if (regex_set_ != nullptr && (regex_set_size_ == 0 || !regex_set_->Compile())) {
+    // Without regexes, or if the combined automaton ran out of memory, every extractor is
+    // evaluated.
+    regex_set_.reset();
+  }
+}
+
+void TagProducerImpl::forEachExtractorMatching(
+    absl::string_view stat_name, const RegexSetMatches* regex_set_matches,
+    std::function<void(const TagExtractorPtr&)> f) const {
+  const auto visit = [regex_set_matches, &f](const std::vector<Extractor>& extractors) {
+    for (const Extractor& extractor : extractors) {
+      if (regex_set_matches == nullptr || extractor.regex_set_index_ < 0 ||
+          (*regex_set_matches)[extractor.regex_set_index_]) {
+        f(extractor.extractor_);
+      }
+    }
+  };
+  visit(tag_extractors_without_prefix_);
   const absl::string_view::size_type dot = stat_name.find('.');
   if (dot != std::string::npos) {
     const absl::string_view token = absl::string_view(stat_name.data(), dot);
     const auto iter = tag_extractor_prefix_map_.find(token);
     if (iter != tag_extractor_prefix_map_.end()) {
-      for (const TagExtractorPtr& tag_extractor : iter->second) {
-        f(tag_extractor);
-      }
+      visit(iter->second);
     }
   }
 }
@@ -102,13 +136,32 @@ void TagProducerImpl::forEachExtractorMatching(
 std::string TagProducerImpl::produceTags(absl::string_view metric_name, TagVector& tags) const {
   // TODO(jmarantz): Skip the creation of string-based tags, creating a StatNameTagVector instead.
   tags.insert(tags.end(), default_tags_.begin(), default_tags_.end());
+
+  RegexSetMatches regex_set_matches;
+  bool use_regex_set_matches = false;
+  if (regex_set_ != nullptr) {
+    std::vector<int> matches;
+    re2::RE2::Set::ErrorInfo error_info;
+    if (regex_set_->Match(re2::StringPiece(metric_name.data(), metric_name.size()), &matches,
+                          &error_info) ||
+        error_info.kind == re2::RE2::Set::kNoError) {
+      regex_set_matches.resize(regex_set_size_);
+      for (const int match : matches) {
+        regex_set_matches[match] = true;
+      }
+      use_regex_set_matches = true;
+    }
+    // Otherwise the DFA ran out of memory, and all extractors are evaluated.
+  }
+
   IntervalSetImpl<size_t> remove_characters;
   TagExtractionContext tag_extraction_context(metric_name);
-  std::vector<absl::string_view> tokens;
-  forEachExtractorMatching(metric_name, [&remove_characters, &tags, &tag_extraction_context](
-                                            const TagExtractorPtr& tag_extractor) {
-    tag_extractor->extractTag(tag_extraction_context, tags, remove_characters);
-  });
+  forEachExtractorMatching(metric_name, use_regex_set_matches ? &regex_set_matches : nullptr,
+                           [&remove_characters, &tags, &tag_extraction_context](
+                               const TagExtractorPtr& tag_extractor) {
+                             tag_extractor->extractTag(tag_extraction_context, tags,
+                                                       remove_characters);
+                           });
   return StringUtil::removeCharacters(metric_name, remove_characters);
 }
 
@@ -122,8 +175,7 @@ TagProducerImpl::addDefaultExtractors(const envoy::config::metrics::v3::StatsCon
   if (!config.has_use_all_default_tags() || config.use_all_default_tags().value()) {
     for (const auto& desc : Config::TagNames::get().descriptorVec()) {
       names.emplace(desc.name_);
-      addExtractor(TagExtractorImplBase::createTagExtractor(desc.name_, desc.regex_, desc.substr_,
-                                                            desc.re_type_));
+      addRegexExtractor(desc.name_, desc.regex_, desc.substr_, desc.re_type_);
     }
     for (const auto& desc : Config::TagNames::get().tokenizedDescriptorVec()) {
       names.emplace(desc.name_);
@@ -16,8 +16,10 @@
 #include "source/common/protobuf/protobuf.h"
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_set.h"
 #include "absl/strings/string_view.h"
+#include "re2/set.h"
 
 namespace Envoy {
 namespace Stats {
@@ -25,6 +27,11 @@ namespace Stats {
 /**
  * Organizes a collection of TagExtractors so that stat-names can be processed without
  * iterating through all extractors.
+ *
+ * With compiled tag extraction, the regexes of the extractors that would be evaluated against
+ * every stat-name, as they have neither a prefix token nor a required substring, are combined
+ * into an RE2::Set. A single pass over a stat-name finds which of them match, and only those are
+ * evaluated to capture their tag values.
  */
 class TagProducerImpl : public TagProducer {
 public:
@@ -46,12 +53,41 @@ public:
 private:
   friend class DefaultTagRegexTester;
 
+  // Matches of a stat-name against regex_set_, indexed by the regex's index in the set.
+  using RegexSetMatches = absl::InlinedVector<bool, 32>;
+
+  struct Extractor {
+    TagExtractorPtr extractor_;
+    // The index of the extractor's regex in regex_set_, or -1 if it is evaluated against every
+    // stat-name it might match.
+    int regex_set_index_;
+  };
+
   /**
    * Adds a TagExtractor to the collection of tags, tracking prefixes to help make
    * produceTags run efficiently by trying only extractors that have a chance to match.
    * @param extractor TagExtractorPtr the extractor to add.
+   * @param regex_set_index int the index of the extractor's regex in regex_set_, or -1.
+   */
+  void addExtractor(TagExtractorPtr extractor, int regex_set_index = -1);
+
+  /**
+   * Creates a TagExtractor from a regex and adds it. With compiled tag extraction, regexes that
+   * would be evaluated against every stat-name and that RE2 supports are added to regex_set_ and
+   * evaluated with RE2.
+   * @param name absl::string_view the tag name.
+   * @param regex absl::string_view the regex.
+   * @param substr absl::string_view the substring required for a match, see
+   *        TagExtractorImplBase::createTagExtractor.
+   * @param re_type Regex::Type the regex syntax used without compiled tag extraction.
+   */
+  void addRegexExtractor(absl::string_view name, absl::string_view regex,
+                         absl::string_view substr, Regex::Type re_type);
+
+  /**
+   * Compiles regex_set_ once all extractors were added.
    */
-  void addExtractor(TagExtractorPtr extractor);
+  void compileRegexSet();
 
   /**
    * Adds all default extractors matching the specified tag name. In this model,
@@ -94,15 +130,29 @@ private:
    * @param f std::function<void(const TagExtractorPtr&)> function to call for each extractor.
    */
   void forEachExtractorMatching(absl::string_view stat_name,
+                                std::function<void(const TagExtractorPtr&)> f) const {
+    forEachExtractorMatching(stat_name, nullptr, f);
+  }
+
+  /**
+   * As above, but also skips the extractors whose regex is in regex_set_ and doesn't match.
+   * @param regex_set_matches const RegexSetMatches* the matches of stat_name against
+   *        regex_set_, or nullptr to not skip any extractor.
+   */
+  void forEachExtractorMatching(absl::string_view stat_name,
+                                const RegexSetMatches* regex_set_matches,
                                 std::function<void(const TagExtractorPtr&)> f) const;
 
-  std::vector<TagExtractorPtr> tag_extractors_without_prefix_;
+  std::vector<Extractor> tag_extractors_without_prefix_;
 
   // Maps a prefix word extracted out of a regex to a vector of TagExtractors. Note that
   // the storage for the prefix string is owned by the TagExtractor, which, depending on
   // implementation, may need make a copy of the prefix.
-  absl::flat_hash_map<absl::string_view, std::vector<TagExtractorPtr>> tag_extractor_prefix_map_;
+  absl::flat_hash_map<absl::string_view, std::vector<Extractor>> tag_extractor_prefix_map_;
   TagVector default_tags_;
+  // Only set with compiled tag extraction, and if at least one regex was added.
+  std::unique_ptr<re2::RE2::Set> regex_set_;
+  int regex_set_size_{};
 };
 
 } // namespace Stats
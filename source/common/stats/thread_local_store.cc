@@ -1,5 +1,6 @@
 #include "source/common/stats/thread_local_store.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
 #include <list>
@@ -675,7 +676,8 @@ Histogram& ThreadLocalStoreImpl::ScopeImpl::histogramFromStatNameWithTags(
       } else {
         stat = new ParentHistogramImpl(final_stat_name, unit, parent_,
                                        tag_helper.tagExtractedName(), tag_helper.statNameTags(),
-                                       *buckets, parent_.next_histogram_id_++);
+                                       *buckets, parent_.histogram_settings_->fixedBuckets(),
+                                       parent_.next_histogram_id_++);
         if (!parent_.shutting_down_) {
           parent_.histogram_set_.insert(stat.get());
         }
@@ -768,7 +770,8 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 
   TlsHistogramSharedPtr hist_tls_ptr(
       new ThreadLocalHistogramImpl(parent.statName(), parent.unit(), tag_helper.tagExtractedName(),
-                                   tag_helper.statNameTags(), symbolTable()));
+                                   tag_helper.statNameTags(), symbolTable(),
+                                   parent.fixedBuckets()));
 
   parent.addTlsHistogram(hist_tls_ptr);
 
@@ -782,26 +785,73 @@ Histogram& ThreadLocalStoreImpl::tlsHistogram(ParentHistogramImpl& parent, uint6
 ThreadLocalHistogramImpl::ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit,
                                                    StatName tag_extracted_name,
                                                    const StatNameTagVector& stat_name_tags,
-                                                   SymbolTable& symbol_table)
+                                                   SymbolTable& symbol_table,
+                                                   ConstSupportedBuckets* fixed_buckets)
     : HistogramImplHelper(name, tag_extracted_name, stat_name_tags, symbol_table), unit_(unit),
       current_active_(0), used_(false), created_thread_id_(std::this_thread::get_id()),
-      symbol_table_(symbol_table) {
-  histograms_[0] = hist_alloc();
-  histograms_[1] = hist_alloc();
+      symbol_table_(symbol_table), fixed_buckets_(fixed_buckets) {
+  if (fixed_buckets_ != nullptr) {
+    histograms_[0] = nullptr;
+    histograms_[1] = nullptr;
+    // The bucket counts, the count above the last bucket and the sum.
+    const size_t num_counts = fixed_buckets_->size() + 2;
+    counts_lines_ = std::vector<CountsLine>((num_counts + CountsPerLine - 1) / CountsPerLine);
+    merged_counts_.resize(num_counts);
+  } else {
+    histograms_[0] = hist_alloc();
+    histograms_[1] = hist_alloc();
+  }
 }
 
 ThreadLocalHistogramImpl::~ThreadLocalHistogramImpl() {
   MetricImpl::clear(symbol_table_);
-  hist_free(histograms_[0]);
-  hist_free(histograms_[1]);
+  if (fixed_buckets_ == nullptr) {
+    hist_free(histograms_[0]);
+    hist_free(histograms_[1]);
+  }
 }
 
 void ThreadLocalHistogramImpl::recordValue(uint64_t value) {
   ASSERT(std::this_thread::get_id() == created_thread_id_);
+  if (fixed_buckets_ != nullptr) {
+    // The buckets are in the unit's scale, see HistogramStatisticsImpl::refresh().
+    const double scaled_value =
+        unit_ == Histogram::Unit::Percent
+            ? static_cast<double>(value) / Histogram::PercentScale
+            : static_cast<double>(value);
+    const size_t bucket =
+        std::lower_bound(fixed_buckets_->begin(), fixed_buckets_->end(), scaled_value) -
+        fixed_buckets_->begin();
+    addToCount(bucket, 1);
+    addToCount(fixed_buckets_->size() + 1, value);
+    // Avoid dirtying the cache line on every value.
+    if (!used_.load(std::memory_order_relaxed)) {
+      used_ = true;
+    }
+    return;
+  }
   hist_insert_intscale(histograms_[current_active_], value, 0, 1);
   used_ = true;
 }
 
+void ThreadLocalHistogramImpl::mergeBuckets(std::vector<uint64_t>& bucket_counts,
+                                            uint64_t& sample_sum) {
+  ASSERT(fixed_buckets_ != nullptr);
+  ASSERT(bucket_counts.size() + 1 == merged_counts_.size());
+  // The owning thread keeps recording meanwhile, anything it records after a count is read is
+  // merged the next time.
+  for (size_t i = 0; i < merged_counts_.size(); ++i) {
+    const uint64_t current = count(i).load(std::memory_order_relaxed);
+    const uint64_t delta = current - merged_counts_[i];
+    merged_counts_[i] = current;
+    if (i < bucket_counts.size()) {
+      bucket_counts[i] += delta;
+    } else {
+      sample_sum += delta;
+    }
+  }
+}
+
 void ThreadLocalHistogramImpl::merge(histogram_t* target) {
   histogram_t** other_histogram = &histograms_[otherHistogramIndex()];
   hist_accumulate(target, other_histogram, 1);
@@ -812,20 +862,32 @@ ParentHistogramImpl::ParentHistogramImpl(StatName name, Histogram::Unit unit,
                                          ThreadLocalStoreImpl& thread_local_store,
                                          StatName tag_extracted_name,
                                          const StatNameTagVector& stat_name_tags,
-                                         ConstSupportedBuckets& supported_buckets, uint64_t id)
+                                         ConstSupportedBuckets& supported_buckets,
+                                         bool fixed_buckets, uint64_t id)
     : MetricImpl(name, tag_extracted_name, stat_name_tags, thread_local_store.symbolTable()),
-      unit_(unit), thread_local_store_(thread_local_store), interval_histogram_(hist_alloc()),
-      cumulative_histogram_(hist_alloc()),
-      interval_statistics_(interval_histogram_, unit, supported_buckets),
-      cumulative_statistics_(cumulative_histogram_, unit, supported_buckets), merged_(false),
-      id_(id) {}
+      unit_(unit), thread_local_store_(thread_local_store),
+      fixed_buckets_(fixed_buckets ? &supported_buckets : nullptr),
+      interval_histogram_(fixed_buckets ? nullptr : hist_alloc()),
+      cumulative_histogram_(fixed_buckets ? nullptr : hist_alloc()),
+      interval_statistics_(unit, supported_buckets),
+      cumulative_statistics_(unit, supported_buckets), merged_(false), id_(id) {
+  if (fixed_buckets_ != nullptr) {
+    interval_counts_.resize(supported_buckets.size() + 1);
+    cumulative_counts_.resize(supported_buckets.size() + 1);
+  } else {
+    interval_statistics_.refresh(interval_histogram_);
+    cumulative_statistics_.refresh(cumulative_histogram_);
+  }
+}
 
 ParentHistogramImpl::~ParentHistogramImpl() {
   thread_local_store_.releaseHistogramCrossThread(id_);
   ASSERT(ref_count_ == 0);
   MetricImpl::clear(thread_local_store_.symbolTable());
-  hist_free(interval_histogram_);
-  hist_free(cumulative_histogram_);
+  if (fixed_buckets_ == nullptr) {
+    hist_free(interval_histogram_);
+    hist_free(cumulative_histogram_);
+  }
 }
 
 void ParentHistogramImpl::incRefCount() { ++ref_count_; }
@@ -889,6 +951,10 @@ bool ParentHistogramImpl::used() const {
 }
 
 void ParentHistogramImpl::merge() {
+  if (fixed_buckets_ != nullptr) {
+    mergeFixedBuckets();
+    return;
+  }
   Thread::ReleasableLockGuard lock(merge_lock_);
   if (merged_ || usedLockHeld()) {
     hist_clear(interval_histogram_);
@@ -908,6 +974,30 @@ void ParentHistogramImpl::merge() {
   }
 }
 
+void ParentHistogramImpl::mergeFixedBuckets() {
+  // The counts of every worker are added up on each merge, even when nothing was recorded since the
+  // previous one: the workers never reset their counters, so a value recorded concurrently with the
+  // merge is either seen now or credited to the next interval, never dropped.
+  {
+    Thread::LockGuard lock(merge_lock_);
+    if (!merged_ && !usedLockHeld()) {
+      return;
+    }
+    std::fill(interval_counts_.begin(), interval_counts_.end(), 0);
+    interval_sum_ = 0;
+    for (const TlsHistogramSharedPtr& tls_histogram : tls_histograms_) {
+      tls_histogram->mergeBuckets(interval_counts_, interval_sum_);
+    }
+  }
+  for (size_t i = 0; i < cumulative_counts_.size(); ++i) {
+    cumulative_counts_[i] += interval_counts_[i];
+  }
+  cumulative_sum_ += interval_sum_;
+  cumulative_statistics_.refresh(cumulative_counts_, cumulative_sum_);
+  interval_statistics_.refresh(interval_counts_, interval_sum_);
+  merged_ = true;
+}
+
 const std::string ParentHistogramImpl::quantileSummary() const {
   if (used()) {
     std::vector<std::string> summary;
@@ -6,6 +6,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "envoy/stats/tag.h"
 #include "envoy/thread_local/thread_local.h"
@@ -31,15 +32,28 @@ namespace Stats {
  * A histogram that is stored in TLS and used to record values per thread. This holds two
  * histograms, one to collect the values and other as backup that is used for merge process. The
  * swap happens during the merge process.
+ *
+ * Histograms with fixed buckets (see HistogramSettings::fixedBuckets()) instead only count their
+ * values per bucket, in counters that the owning thread keeps incrementing while they are merged.
  */
 class ThreadLocalHistogramImpl : public HistogramImplHelper {
 public:
   ThreadLocalHistogramImpl(StatName name, Histogram::Unit unit, StatName tag_extracted_name,
-                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table);
+                           const StatNameTagVector& stat_name_tags, SymbolTable& symbol_table,
+                           ConstSupportedBuckets* fixed_buckets = nullptr);
   ~ThreadLocalHistogramImpl() override;
 
   void merge(histogram_t* target);
 
+  /**
+   * Adds the values recorded since the previous call to the bucket counts of a histogram with
+   * fixed buckets. Must only be called from the main thread.
+   * @param bucket_counts supplies the count of each bucket, followed by the count of the values
+   *        above the last bucket.
+   * @param sample_sum supplies the sum of the values.
+   */
+  void mergeBuckets(std::vector<uint64_t>& bucket_counts, uint64_t& sample_sum);
+
   /**
    * Called in the beginning of merge process. Swaps the histogram used for collection so that we do
    * not have to lock the histogram in high throughput TLS writes.
@@ -63,6 +77,22 @@ public:
   bool used() const override { return used_; }
 
 private:
+  // The counts are grouped in whole cache lines, so that they don't share a cache line with data
+  // written by other threads.
+  static constexpr size_t CountsPerLine = 8;
+  struct alignas(64) CountsLine {
+    std::atomic<uint64_t> counts_[CountsPerLine]{};
+  };
+
+  std::atomic<uint64_t>& count(size_t index) {
+    return counts_lines_[index / CountsPerLine].counts_[index % CountsPerLine];
+  }
+  void addToCount(size_t index, uint64_t amount) {
+    // Only the owning thread writes the counts, so they don't need an atomic read-modify-write.
+    std::atomic<uint64_t>& counter = count(index);
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+  }
+
   Histogram::Unit unit_;
   uint64_t otherHistogramIndex() const { return 1 - current_active_; }
   uint64_t current_active_;
@@ -70,6 +100,13 @@ private:
   std::atomic<bool> used_;
   std::thread::id created_thread_id_;
   SymbolTable& symbol_table_;
+  // Only set for histograms with fixed buckets, in which case histograms_ are not allocated.
+  ConstSupportedBuckets* const fixed_buckets_;
+  // The count of each bucket, followed by the count of the values above the last bucket and the
+  // sum of the values. The counts are never cleared, merging takes the difference to the counts at
+  // the previous merge, which only the main thread accesses.
+  std::vector<CountsLine> counts_lines_;
+  std::vector<uint64_t> merged_counts_;
 };
 
 using TlsHistogramSharedPtr = RefcountPtr<ThreadLocalHistogramImpl>;
@@ -83,11 +120,17 @@ class ParentHistogramImpl : public MetricImpl<ParentHistogram> {
 public:
   ParentHistogramImpl(StatName name, Histogram::Unit unit, ThreadLocalStoreImpl& parent,
                       StatName tag_extracted_name, const StatNameTagVector& stat_name_tags,
-                      ConstSupportedBuckets& supported_buckets, uint64_t id);
+                      ConstSupportedBuckets& supported_buckets, bool fixed_buckets, uint64_t id);
   ~ParentHistogramImpl() override;
 
   void addTlsHistogram(const TlsHistogramSharedPtr& hist_ptr);
 
+  /**
+   * @return the buckets the values are counted in if the histogram has fixed buckets, or nullptr
+   *         if it records the values in log-linear histograms.
+   */
+  ConstSupportedBuckets* fixedBuckets() const { return fixed_buckets_; }
+
   // Stats::Histogram
   Histogram::Unit unit() const override;
   void recordValue(uint64_t value) override;
@@ -122,9 +165,11 @@ public:
 
 private:
   bool usedLockHeld() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(merge_lock_);
+  void mergeFixedBuckets();
 
   Histogram::Unit unit_;
   ThreadLocalStoreImpl& thread_local_store_;
+  ConstSupportedBuckets* const fixed_buckets_;
   histogram_t* interval_histogram_;
   histogram_t* cumulative_histogram_;
   HistogramStatisticsImpl interval_statistics_;
@@ -132,6 +177,12 @@ private:
   mutable Thread::MutexBasicLockable merge_lock_;
   std::list<TlsHistogramSharedPtr> tls_histograms_ ABSL_GUARDED_BY(merge_lock_);
   bool merged_;
+  // Bucket counts and sums of histograms with fixed buckets, in the layout used by
+  // ThreadLocalHistogramImpl::mergeBuckets().
+  std::vector<uint64_t> interval_counts_;
+  std::vector<uint64_t> cumulative_counts_;
+  uint64_t interval_sum_{};
+  uint64_t cumulative_sum_{};
   std::atomic<bool> shutting_down_{false};
   std::atomic<uint32_t> ref_count_{0};
   const uint64_t id_; // Index into TlsCache::histogram_cache_.
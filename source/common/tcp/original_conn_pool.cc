@@ -334,7 +334,7 @@ OriginalConnPoolImpl::ConnectionWrapper::ConnectionWrapper(ActiveConn& parent) :
   parent_.parent_.host_->cluster().stats().upstream_rq_total_.inc();
   parent_.parent_.host_->cluster().stats().upstream_rq_active_.inc();
   parent_.parent_.host_->stats().rq_total_.inc();
-  parent_.parent_.host_->stats().rq_active_.inc();
+  parent_.parent_.host_->activeRequests().inc();
 }
 
 Network::ClientConnection& OriginalConnPoolImpl::ConnectionWrapper::connection() {
@@ -359,7 +359,7 @@ void OriginalConnPoolImpl::ConnectionWrapper::release(bool closed) {
     }
 
     parent_.parent_.host_->cluster().stats().upstream_rq_active_.dec();
-    parent_.parent_.host_->stats().rq_active_.dec();
+    parent_.parent_.host_->activeRequests().dec();
   }
 }
 
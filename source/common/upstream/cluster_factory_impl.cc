@@ -125,16 +125,23 @@ ClusterFactoryImplBase::create(const envoy::config::cluster::v3::Cluster& cluste
     if (cluster.health_checks().size() != 1) {
       throw EnvoyException("Multiple health checks not supported");
     } else {
+      const auto& health_check = cluster.health_checks()[0];
       new_cluster_pair.first->setHealthChecker(HealthCheckerFactory::create(
-          cluster.health_checks()[0], *new_cluster_pair.first, context.runtime(),
+          health_check, *new_cluster_pair.first, context.runtime(),
           context.mainThreadDispatcher(), context.logManager(), context.messageValidationVisitor(),
-          context.api()));
+          context.api(),
+          health_check.share_sessions()
+              ? SharedHealthCheckSessions::get(context.singletonManager())
+              : nullptr));
     }
   }
 
   new_cluster_pair.first->setOutlierDetector(Outlier::DetectorImplFactory::createForCluster(
       *new_cluster_pair.first, cluster, context.mainThreadDispatcher(), context.runtime(),
-      context.outlierEventLogger()));
+      context.outlierEventLogger(),
+      cluster.outlier_detection().sweep_in_background()
+          ? Outlier::SweepThread::get(context.singletonManager(), context.api().threadFactory())
+          : nullptr));
 
   new_cluster_pair.first->setTransportFactoryContext(std::move(transport_factory_context));
   return new_cluster_pair;
@@ -20,6 +20,8 @@
 #include "source/common/common/assert.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/fmt.h"
+#include "source/common/common/hash.h"
+#include "source/common/common/scalar_to_byte_vector.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/new_grpc_mux_impl.h"
 #include "source/common/config/utility.h"
@@ -30,6 +32,7 @@
 #include "source/common/http/http1/conn_pool.h"
 #include "source/common/http/http2/conn_pool.h"
 #include "source/common/http/mixed_conn_pool.h"
+#include "source/common/http/shared_conn_pool.h"
 #include "source/common/network/resolver_impl.h"
 #include "source/common/network/utility.h"
 #include "source/common/protobuf/utility.h"
@@ -268,7 +271,7 @@ ClusterManagerImpl::ClusterManagerImpl(
     ProtobufMessage::ValidationContext& validation_context, Api::Api& api,
     Http::Context& http_context, Grpc::Context& grpc_context, Router::Context& router_context)
     : factory_(factory), runtime_(runtime), stats_(stats), tls_(tls),
-      random_(api.randomGenerator()),
+      random_(api.randomGenerator()), thread_factory_(api.threadFactory()),
       bind_config_(bootstrap.cluster_manager().upstream_bind_config()), local_info_(local_info),
       cm_stats_(generateStats(stats)),
       init_helper_(*this, [this](ClusterManagerCluster& cluster) { onClusterInit(cluster); }),
@@ -837,19 +840,29 @@ ClusterManagerImpl::loadCluster(const envoy::config::cluster::v3::Cluster& clust
   // If an LB is thread aware, create it here. The LB is not initialized until cluster pre-init
   // finishes. For RingHash/Maglev don't create the LB here if subset balancing is enabled,
   // because the thread_aware_lb_ field takes precedence over the subset lb).
+  const bool build_in_background =
+      cluster_reference.info()->lbConfig().consistent_hashing_lb_config().build_in_background();
   if (cluster_reference.info()->lbType() == LoadBalancerType::RingHash) {
     if (!cluster_reference.info()->lbSubsetInfo().isEnabled()) {
-      cluster_entry_it->second->thread_aware_lb_ = std::make_unique<RingHashLoadBalancer>(
+      auto lb = std::make_unique<RingHashLoadBalancer>(
           cluster_reference.prioritySet(), cluster_reference.info()->stats(),
           cluster_reference.info()->statsScope(), runtime_, random_,
           cluster_reference.info()->lbRingHashConfig(), cluster_reference.info()->lbConfig());
+      if (build_in_background) {
+        lb->buildInBackground(thread_factory_);
+      }
+      cluster_entry_it->second->thread_aware_lb_ = std::move(lb);
     }
   } else if (cluster_reference.info()->lbType() == LoadBalancerType::Maglev) {
     if (!cluster_reference.info()->lbSubsetInfo().isEnabled()) {
-      cluster_entry_it->second->thread_aware_lb_ = std::make_unique<MaglevLoadBalancer>(
+      auto lb = std::make_unique<MaglevLoadBalancer>(
           cluster_reference.prioritySet(), cluster_reference.info()->stats(),
           cluster_reference.info()->statsScope(), runtime_, random_,
           cluster_reference.info()->lbMaglevConfig(), cluster_reference.info()->lbConfig());
+      if (build_in_background) {
+        lb->buildInBackground(thread_factory_);
+      }
+      cluster_entry_it->second->thread_aware_lb_ = std::move(lb);
     }
   } else if (cluster_reference.info()->lbType() == LoadBalancerType::ClusterProvided) {
     cluster_entry_it->second->thread_aware_lb_ = std::move(new_cluster_pair.second);
@@ -937,6 +950,25 @@ void ClusterManagerImpl::maybePreconnect(
   }
 }
 
+uint32_t ClusterManagerImpl::registerSharedConnPoolWorker(Event::Dispatcher& dispatcher) {
+  absl::MutexLock lock(&shared_conn_pool_workers_mutex_);
+  auto workers = shared_conn_pool_workers_ != nullptr
+                     ? std::make_shared<std::vector<Event::Dispatcher*>>(*shared_conn_pool_workers_)
+                     : std::make_shared<std::vector<Event::Dispatcher*>>();
+  workers->push_back(&dispatcher);
+  shared_conn_pool_workers_ = std::move(workers);
+  shared_conn_pool_workers_version_++;
+  return shared_conn_pool_workers_->size() - 1;
+}
+
+void ClusterManagerImpl::unregisterSharedConnPoolWorker(uint32_t worker_index) {
+  absl::MutexLock lock(&shared_conn_pool_workers_mutex_);
+  auto workers = std::make_shared<std::vector<Event::Dispatcher*>>(*shared_conn_pool_workers_);
+  (*workers)[worker_index] = nullptr;
+  shared_conn_pool_workers_ = std::move(workers);
+  shared_conn_pool_workers_version_++;
+}
+
 absl::optional<HttpPoolData>
 ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPool(
     ResourcePriority priority, absl::optional<Http::Protocol> protocol,
@@ -1177,6 +1209,10 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ThreadLocalClusterManagerImpl
     ClusterManagerImpl& parent, Event::Dispatcher& dispatcher,
     const absl::optional<LocalClusterParams>& local_cluster_params)
     : parent_(parent), thread_local_dispatcher_(dispatcher) {
+  if (&dispatcher != &parent_.dispatcher_) {
+    worker_index_ = parent_.registerSharedConnPoolWorker(dispatcher);
+  }
+
   // If local cluster is defined then we need to initialize it first.
   if (local_cluster_params.has_value()) {
     const auto& local_cluster_name = local_cluster_params->info_->name();
@@ -1194,6 +1230,9 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::~ThreadLocalClusterManagerImp
   // member update callback registered with the local cluster.
   ENVOY_LOG(debug, "shutting down thread local cluster manager");
   destroying_ = true;
+  if (worker_index_.has_value()) {
+    parent_.unregisterSharedConnPoolWorker(worker_index_.value());
+  }
   host_http_conn_pool_map_.clear();
   host_tcp_conn_pool_map_.clear();
   ASSERT(host_tcp_conn_map_.empty());
@@ -1381,6 +1420,13 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::ClusterEntry(
           parent.thread_local_dispatcher_.timeSource());
       break;
     }
+    case LoadBalancerType::PeakEwma: {
+      ASSERT(lb_factory_ == nullptr);
+      lb_ = std::make_unique<PeakEwmaLoadBalancer>(
+          priority_set_, parent_.local_priority_set_, cluster->stats(), parent.parent_.runtime_,
+          parent.parent_.random_, cluster->lbConfig(), cluster->lbPeakEwmaConfig());
+      break;
+    }
     case LoadBalancerType::Random: {
       ASSERT(lb_factory_ == nullptr);
       lb_ = std::make_unique<RandomLoadBalancer>(priority_set_, parent_.local_priority_set_,
@@ -1491,6 +1537,14 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
     return nullptr;
   }
 
+  return httpConnPoolForHost(host, priority, downstream_protocol, context, true);
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolForHost(
+    const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol, LoadBalancerContext* context,
+    bool allow_handoff) {
   // Right now, HTTP, HTTP/2 and ALPN pools are considered separate.
   // We could do better here, and always use the ALPN pool and simply make sure
   // we end up on a connection of the correct protocol, but for simplicity we're
@@ -1532,17 +1586,43 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
     context->downstreamConnection()->hashKey(hash_key);
   }
 
+  // Streams which need connections of their own are never handed off.
+  Event::Dispatcher* owner_dispatcher = nullptr;
+  const uint32_t shared_conn_pool_owner_workers = cluster_info_->sharedConnPoolOwnerWorkers();
+  if (allow_handoff && shared_conn_pool_owner_workers > 0 && upstream_options->empty() &&
+      !have_transport_socket_options && !cluster_info_->connectionPoolPerDownstreamConnection()) {
+    owner_dispatcher = parent_.sharedConnPoolOwner(*host, shared_conn_pool_owner_workers,
+                                                   upstream_protocols, hash_key);
+  }
+
   ConnPoolsContainer& container = *parent_.getHttpConnPoolsContainer(host, true);
 
   // Note: to simplify this, we assume that the factory is only called in the scope of this
   // function. Otherwise, we'd need to capture a few of these variables by value.
   ConnPoolsContainer::ConnPools::PoolOptRef pool =
       container.pools_->getPool(priority, hash_key, [&]() {
-        auto pool = parent_.parent_.factory_.allocateConnPool(
-            parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
-            alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
-            have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
-            parent_.parent_.time_source_, parent_.cluster_manager_state_);
+        Http::ConnectionPool::InstancePtr pool;
+        if (owner_dispatcher != nullptr) {
+          pool = std::make_unique<Http::SharedConnPool>(
+              parent_.thread_local_dispatcher_, *owner_dispatcher, host,
+              [&cm = parent_.parent_, cluster_name = cluster_info_->name(), host, priority,
+               downstream_protocol]() -> Http::ConnectionPool::Instance* {
+                // Runs on the owner, which may not have its thread local cluster manager anymore
+                // while shutting down.
+                OptRef<ThreadLocalClusterManagerImpl> owner = cm.tls_.get();
+                if (!owner.has_value()) {
+                  return nullptr;
+                }
+                return owner->sharedConnPoolForHost(cluster_name, host, priority,
+                                                    downstream_protocol);
+              });
+        } else {
+          pool = parent_.parent_.factory_.allocateConnPool(
+              parent_.thread_local_dispatcher_, host, priority, upstream_protocols,
+              alternate_protocol_options, !upstream_options->empty() ? upstream_options : nullptr,
+              have_transport_socket_options ? context->upstreamTransportSocketOptions() : nullptr,
+              parent_.parent_.time_source_, parent_.cluster_manager_state_);
+        }
 
         pool->addIdleCallback([&parent = parent_, host, priority, hash_key]() {
           parent.httpConnPoolIsIdle(host, priority, hash_key);
@@ -1558,6 +1638,74 @@ ClusterManagerImpl::ThreadLocalClusterManagerImpl::ClusterEntry::httpConnPoolImp
   }
 }
 
+Event::Dispatcher* ClusterManagerImpl::ThreadLocalClusterManagerImpl::sharedConnPoolOwner(
+    const Host& host, uint32_t owner_workers, const std::vector<Http::Protocol>& upstream_protocols,
+    std::vector<uint8_t>& hash_key) {
+  if (!worker_index_.has_value()) {
+    return nullptr;
+  }
+  // Only multiplexed connections can be shared.
+  for (const Http::Protocol protocol : upstream_protocols) {
+    if (protocol != Http::Protocol::Http2 && protocol != Http::Protocol::Http3) {
+      return nullptr;
+    }
+  }
+
+  if (shared_conn_pool_workers_version_ !=
+      parent_.shared_conn_pool_workers_version_.load(std::memory_order_acquire)) {
+    absl::MutexLock lock(&parent_.shared_conn_pool_workers_mutex_);
+    shared_conn_pool_workers_ = parent_.shared_conn_pool_workers_;
+    shared_conn_pool_workers_version_ = parent_.shared_conn_pool_workers_version_.load();
+  }
+  const std::vector<Event::Dispatcher*>& workers = *shared_conn_pool_workers_;
+  const uint32_t num_workers = workers.size();
+  if (num_workers <= owner_workers) {
+    return nullptr;
+  }
+
+  // The owners of the connections to a host are consecutive workers, starting from one chosen by
+  // hashing the address of the host. Other workers are spread evenly across the owners.
+  const uint32_t first_owner = HashUtil::xxHash64(host.address()->asStringView()) % num_workers;
+  const uint32_t worker_index = worker_index_.value();
+  if ((worker_index + num_workers - first_owner) % num_workers < owner_workers) {
+    return nullptr;
+  }
+  const uint32_t owner_index = (first_owner + worker_index % owner_workers) % num_workers;
+  Event::Dispatcher* owner_dispatcher = workers[owner_index];
+  if (owner_dispatcher == nullptr) {
+    return nullptr;
+  }
+
+  // Protocols are hashed as single bytes below 255, so the pools handing off streams to an owner
+  // never collide with regular pools.
+  hash_key.push_back(255);
+  pushScalarToByteVector(owner_index, hash_key);
+  return owner_dispatcher;
+}
+
+Http::ConnectionPool::Instance*
+ClusterManagerImpl::ThreadLocalClusterManagerImpl::sharedConnPoolForHost(
+    const std::string& cluster_name, const HostConstSharedPtr& host, ResourcePriority priority,
+    absl::optional<Http::Protocol> downstream_protocol) {
+  if (destroying_) {
+    return nullptr;
+  }
+  auto entry = thread_local_clusters_.find(cluster_name);
+  if (entry == thread_local_clusters_.end()) {
+    return nullptr;
+  }
+  // The host may have been removed since the stream was handed off, and its pools drained.
+  const HostMapConstSharedPtr host_map = entry->second->prioritySet().crossPriorityHostMap();
+  if (host_map == nullptr) {
+    return nullptr;
+  }
+  const auto host_it = host_map->find(host->address()->asString());
+  if (host_it == host_map->end() || host_it->second != host) {
+    return nullptr;
+  }
+  return entry->second->httpConnPoolForHost(host, priority, downstream_protocol, nullptr, false);
+}
+
 void ClusterManagerImpl::ThreadLocalClusterManagerImpl::httpConnPoolIsIdle(
     HostConstSharedPtr host, ResourcePriority priority, const std::vector<uint8_t>& hash_key) {
   if (destroying_) {
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -38,6 +39,8 @@
 #include "source/common/upstream/upstream_impl.h"
 #include "source/server/factory_context_base_impl.h"
 
+#include "absl/synchronization/mutex.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -437,6 +440,13 @@ private:
       // Drain all clients in connection pools for all hosts.
       void drainAllConnPools();
 
+      // Returns the pool for the host, which hands off its streams to the pool of the worker
+      // owning the connections to the host if the cluster shares them and allow_handoff is true.
+      Http::ConnectionPool::Instance*
+      httpConnPoolForHost(const HostConstSharedPtr& host, ResourcePriority priority,
+                          absl::optional<Http::Protocol> downstream_protocol,
+                          LoadBalancerContext* context, bool allow_handoff);
+
     private:
       Http::ConnectionPool::Instance*
       httpConnPoolImpl(ResourcePriority priority,
@@ -493,8 +503,24 @@ private:
     ConnPoolsContainer* getHttpConnPoolsContainer(const HostConstSharedPtr& host,
                                                   bool allocate = false);
 
+    // Returns the dispatcher of the worker owning the connections to the host if this worker
+    // doesn't, appending the owner to the hash key of the pool handing off streams to it.
+    Event::Dispatcher* sharedConnPoolOwner(const Host& host, uint32_t owner_workers,
+                                           const std::vector<Http::Protocol>& upstream_protocols,
+                                           std::vector<uint8_t>& hash_key);
+    // Returns the pool for the host on this worker, for streams handed off by other workers.
+    Http::ConnectionPool::Instance*
+    sharedConnPoolForHost(const std::string& cluster_name, const HostConstSharedPtr& host,
+                          ResourcePriority priority,
+                          absl::optional<Http::Protocol> downstream_protocol);
+
     ClusterManagerImpl& parent_;
     Event::Dispatcher& thread_local_dispatcher_;
+    // The index of this worker in the workers sharing their connections, unset on the main thread.
+    absl::optional<uint32_t> worker_index_;
+    // A copy of the workers sharing their connections, refreshed when they change.
+    std::shared_ptr<const std::vector<Event::Dispatcher*>> shared_conn_pool_workers_;
+    uint64_t shared_conn_pool_workers_version_{};
     absl::flat_hash_map<std::string, ClusterEntryPtr> thread_local_clusters_;
 
     ClusterConnectivityState cluster_manager_state_;
@@ -616,12 +642,15 @@ private:
   static void maybePreconnect(ThreadLocalClusterManagerImpl::ClusterEntry& cluster_entry,
                               const ClusterConnectivityState& cluster_manager_state,
                               std::function<ConnectionPool::Instance*()> preconnect_pool);
+  uint32_t registerSharedConnPoolWorker(Event::Dispatcher& dispatcher);
+  void unregisterSharedConnPoolWorker(uint32_t worker_index);
 
   ClusterManagerFactory& factory_;
   Runtime::Loader& runtime_;
   Stats::Store& stats_;
   ThreadLocal::TypedSlot<ThreadLocalClusterManagerImpl> tls_;
   Random::RandomGenerator& random_;
+  Thread::ThreadFactory& thread_factory_;
 
 protected:
   ClusterMap active_clusters_;
@@ -655,6 +684,15 @@ private:
 
   Config::SubscriptionFactoryImpl subscription_factory_;
   ClusterSet primary_clusters_;
+
+  // The dispatchers of the workers, which may own connections shared with the other workers, in
+  // the order their thread local cluster managers were created. The entry of a worker is reset
+  // when it shuts down. The vector is replaced rather than modified, so that workers can keep a
+  // copy, which they refresh when the version changes.
+  absl::Mutex shared_conn_pool_workers_mutex_;
+  std::shared_ptr<const std::vector<Event::Dispatcher*>>
+      shared_conn_pool_workers_ ABSL_GUARDED_BY(shared_conn_pool_workers_mutex_);
+  std::atomic<uint64_t> shared_conn_pool_workers_version_{};
 };
 
 } // namespace Upstream
@@ -6,13 +6,31 @@
 #include "envoy/service/discovery/v3/discovery.pb.h"
 
 #include "source/common/common/assert.h"
+#include "source/common/common/hash.h"
 #include "source/common/common/utility.h"
 #include "source/common/config/api_version.h"
 #include "source/common/config/decoded_resource_impl.h"
+#include "source/common/runtime/runtime_features.h"
 
 namespace Envoy {
 namespace Upstream {
 
+namespace {
+
+// Deterministic serialization keeps the hash of endpoints with metadata maps stable across updates.
+uint64_t hashMessage(const Protobuf::Message& message, uint64_t seed) {
+  std::string serialized;
+  {
+    Protobuf::io::StringOutputStream stream(&serialized);
+    Protobuf::io::CodedOutputStream coded_stream(&stream);
+    coded_stream.SetSerializationDeterministic(true);
+    message.SerializeToCodedStream(&coded_stream);
+  }
+  return HashUtil::xxHash64(serialized, seed);
+}
+
+} // namespace
+
 EdsClusterImpl::EdsClusterImpl(
     const envoy::config::cluster::v3::Cluster& cluster, Runtime::Loader& runtime,
     Server::Configuration::TransportSocketFactoryContextImpl& factory_context,
@@ -24,7 +42,9 @@ EdsClusterImpl::EdsClusterImpl(
       factory_context_(factory_context), local_info_(factory_context.localInfo()),
       cluster_name_(cluster.eds_cluster_config().service_name().empty()
                         ? cluster.name()
-                        : cluster.eds_cluster_config().service_name()) {
+                        : cluster.eds_cluster_config().service_name()),
+      incremental_host_updates_(Runtime::runtimeFeatureEnabled(
+          "envoy.reloadable_features.eds_incremental_host_updates")) {
   Event::Dispatcher& dispatcher = factory_context.mainThreadDispatcher();
   assignment_timeout_ = dispatcher.createTimer([this]() -> void { onAssignmentTimeout(); });
   const auto& eds_config = cluster.eds_cluster_config().eds_config();
@@ -46,11 +66,23 @@ void EdsClusterImpl::startPreInit() { subscription_->start({cluster_name_}); }
 void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& host_update_cb) {
   absl::flat_hash_set<std::string> all_new_hosts;
   PriorityStateManager priority_state_manager(parent_, parent_.local_info_, &host_update_cb);
+
+  // Get the map of all the latest existing hosts, which is used to filter out the existing
+  // hosts in the process of updating cluster memberships.
+  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
+  ASSERT(all_hosts != nullptr);
+
   for (const auto& locality_lb_endpoint : cluster_load_assignment_.endpoints()) {
     parent_.validateEndpointsForZoneAwareRouting(locality_lb_endpoint);
 
     priority_state_manager.initializePriorityFor(locality_lb_endpoint);
 
+    // Hosts are created from the locality and priority as well as from the endpoint.
+    const uint64_t locality_hash =
+        parent_.incremental_host_updates_
+            ? hashMessage(locality_lb_endpoint.locality(), locality_lb_endpoint.priority())
+            : 0;
+
     if (locality_lb_endpoint.has_leds_cluster_locality_config()) {
       // The locality uses LEDS, fetch its dynamic data, which must be ready, or otherwise
       // the batchUpdate method should not have been called.
@@ -62,13 +94,13 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
              parent_.leds_localities_[leds_config]->isUpdated());
       for (const auto& [_, lb_endpoint] :
            parent_.leds_localities_[leds_config]->getEndpointsMap()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_hash,
+                                priority_state_manager, *all_hosts, all_new_hosts);
       }
     } else {
       for (const auto& lb_endpoint : locality_lb_endpoint.lb_endpoints()) {
-        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, priority_state_manager,
-                                all_new_hosts);
+        updateLocalityEndpoints(lb_endpoint, locality_lb_endpoint, locality_hash,
+                                priority_state_manager, *all_hosts, all_new_hosts);
       }
     }
   }
@@ -76,11 +108,6 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
   // Track whether we rebuilt any LB structures.
   bool cluster_rebuilt = false;
 
-  // Get the map of all the latest existing hosts, which is used to filter out the existing
-  // hosts in the process of updating cluster memberships.
-  HostMapConstSharedPtr all_hosts = parent_.prioritySet().crossPriorityHostMap();
-  ASSERT(all_hosts != nullptr);
-
   const uint32_t overprovisioning_factor = PROTOBUF_GET_WRAPPED_OR_DEFAULT(
       cluster_load_assignment_.policy(), overprovisioning_factor, kDefaultOverProvisioningFactor);
 
@@ -121,6 +148,9 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
     parent_.info_->stats().update_no_rebuild_.inc();
   }
 
+  // All the hosts now reflect the endpoints of this update.
+  parent_.endpoint_hashes_ = std::move(endpoint_hashes_);
+
   // If we didn't setup to initialize when our first round of health checking is complete, just
   // do it now.
   parent_.onPreInitComplete();
@@ -129,7 +159,8 @@ void EdsClusterImpl::BatchUpdateHelper::batchUpdate(PrioritySet::HostUpdateCb& h
 void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
     const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
     const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
-    PriorityStateManager& priority_state_manager, absl::flat_hash_set<std::string>& all_new_hosts) {
+    uint64_t locality_hash, PriorityStateManager& priority_state_manager, const HostMap& all_hosts,
+    absl::flat_hash_set<std::string>& all_new_hosts) {
   const auto address = parent_.resolveProtoAddress(lb_endpoint.endpoint().address());
   // When the configuration contains duplicate hosts, only the first one will be retained.
   const auto address_as_string = address->asString();
@@ -137,6 +168,25 @@ void EdsClusterImpl::BatchUpdateHelper::updateLocalityEndpoints(
     return;
   }
 
+  if (parent_.incremental_host_updates_) {
+    const uint64_t endpoint_hash = hashMessage(lb_endpoint, locality_hash);
+    endpoint_hashes_.emplace(address_as_string, endpoint_hash);
+
+    // If the endpoint didn't change since the existing host was last updated from it, register
+    // the existing host rather than creating a new one which would only be reconciled with it.
+    const auto previous_hash = parent_.endpoint_hashes_.find(address_as_string);
+    if (previous_hash != parent_.endpoint_hashes_.end() && previous_hash->second == endpoint_hash) {
+      const auto existing_host = all_hosts.find(address_as_string);
+      if (existing_host != all_hosts.end() &&
+          existing_host->second->priority() == locality_lb_endpoint.priority()) {
+        priority_state_manager.registerHostForPriority(existing_host->second,
+                                                       locality_lb_endpoint);
+        all_new_hosts.emplace(address_as_string);
+        return;
+      }
+    }
+  }
+
   priority_state_manager.registerHostForPriority(lb_endpoint.endpoint().hostname(), address,
                                                  locality_lb_endpoint, lb_endpoint,
                                                  parent_.time_source_);
@@ -350,8 +400,9 @@ bool EdsClusterImpl::updateHostsPerLocality(
   // about this. In the future we may need to do better here.
   const bool hosts_updated = updateDynamicHostList(new_hosts, *current_hosts_copy, hosts_added,
                                                    hosts_removed, all_hosts, all_new_hosts);
+  const bool locality_weights_updated = locality_weights_map != new_locality_weights_map;
   if (hosts_updated || host_set.overprovisioningFactor() != overprovisioning_factor ||
-      locality_weights_map != new_locality_weights_map) {
+      locality_weights_updated) {
     ASSERT(std::all_of(current_hosts_copy->begin(), current_hosts_copy->end(),
                        [&](const auto& host) { return host->priority() == priority; }));
     locality_weights_map = new_locality_weights_map;
@@ -359,9 +410,15 @@ bool EdsClusterImpl::updateHostsPerLocality(
               "EDS hosts or locality weights changed for cluster: {} current hosts {} priority {}",
               info_->name(), host_set.hosts().size(), host_set.priority());
 
-    priority_state_manager.updateClusterPrioritySet(priority, std::move(current_hosts_copy),
-                                                    hosts_added, hosts_removed, absl::nullopt,
-                                                    overprovisioning_factor);
+    if (incremental_host_updates_ && hosts_added.empty() && hosts_removed.empty() &&
+        !locality_weights_updated && *current_hosts_copy == host_set.hosts()) {
+      // Only the health, weight or metadata of existing hosts changed.
+      priority_state_manager.refreshClusterPrioritySet(priority, overprovisioning_factor);
+    } else {
+      priority_state_manager.updateClusterPrioritySet(priority, std::move(current_hosts_copy),
+                                                      hosts_added, hosts_removed, absl::nullopt,
+                                                      overprovisioning_factor);
+    }
     return true;
   }
   return false;
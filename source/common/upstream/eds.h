@@ -64,6 +64,9 @@ private:
   // Returns true iff all the LEDS based localities were updated.
   bool validateAllLedsUpdated() const;
 
+  // Maps the address of each host to the hash of the endpoint config it was last updated from.
+  using EndpointHashes = absl::flat_hash_map<std::string, uint64_t>;
+
   class BatchUpdateHelper : public PrioritySet::BatchUpdateCb {
   public:
     BatchUpdateHelper(
@@ -78,11 +81,12 @@ private:
     void updateLocalityEndpoints(
         const envoy::config::endpoint::v3::LbEndpoint& lb_endpoint,
         const envoy::config::endpoint::v3::LocalityLbEndpoints& locality_lb_endpoint,
-        PriorityStateManager& priority_state_manager,
-        absl::flat_hash_set<std::string>& all_new_hosts);
+        uint64_t locality_hash, PriorityStateManager& priority_state_manager,
+        const HostMap& all_hosts, absl::flat_hash_set<std::string>& all_new_hosts);
 
     EdsClusterImpl& parent_;
     const envoy::config::endpoint::v3::ClusterLoadAssignment& cluster_load_assignment_;
+    EndpointHashes endpoint_hashes_;
   };
 
   Config::SubscriptionPtr subscription_;
@@ -90,6 +94,10 @@ private:
   const LocalInfo::LocalInfo& local_info_;
   const std::string cluster_name_;
   std::vector<LocalityWeightsMap> locality_weights_map_;
+  // When set, hosts whose endpoint config didn't change are reused as is, and priorities whose
+  // membership didn't change keep their per-locality host grouping.
+  const bool incremental_host_updates_;
+  EndpointHashes endpoint_hashes_;
   Event::TimerPtr assignment_timeout_;
   InitializePhase initialize_phase_;
   using LedsConfigSet = absl::flat_hash_set<envoy::config::endpoint::v3::LedsClusterLocalityConfig,
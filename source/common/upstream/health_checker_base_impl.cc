@@ -11,6 +11,96 @@
 namespace Envoy {
 namespace Upstream {
 
+SINGLETON_MANAGER_REGISTRATION(shared_health_check_sessions);
+
+bool SharedHealthCheckSessions::Group::anyClusterHasTraffic() const {
+  if (leader_ != nullptr && leader_->clusterHasTraffic()) {
+    return true;
+  }
+  for (const Member* follower : followers_) {
+    if (follower->clusterHasTraffic()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void SharedHealthCheckSessions::Group::onSuccess(bool degraded) {
+  last_result_ = Result{true, degraded, envoy::data::core::v3::ACTIVE, false};
+  fanOut();
+}
+
+void SharedHealthCheckSessions::Group::onFailure(
+    envoy::data::core::v3::HealthCheckFailureType type, bool retriable) {
+  last_result_ = Result{false, false, type, retriable};
+  fanOut();
+}
+
+void SharedHealthCheckSessions::Group::replayResult(Member& member) const {
+  ASSERT(last_result_.has_value());
+  if (last_result_->success_) {
+    member.onSharedSuccess(last_result_->degraded_);
+  } else {
+    member.onSharedFailure(last_result_->failure_type_, last_result_->retriable_);
+  }
+}
+
+void SharedHealthCheckSessions::Group::fanOut() const {
+  // Applying a result may cause other members to leave the group inline, e.g. when a cluster
+  // removes a host in response to a health transition. Iterate over a copy and skip the members
+  // which have left in the meantime.
+  const std::vector<Member*> followers(followers_.begin(), followers_.end());
+  for (Member* follower : followers) {
+    if (followers_.contains(follower)) {
+      replayResult(*follower);
+    }
+  }
+}
+
+SharedHealthCheckSessions::GroupSharedPtr
+SharedHealthCheckSessions::join(const envoy::config::core::v3::HealthCheck& config,
+                                uint64_t config_hash, const std::string& address, Member& member) {
+  GroupSharedPtr& group = groups_[std::make_pair(config_hash, address)];
+  if (group == nullptr) {
+    group = std::make_shared<Group>(config, config_hash, address);
+  } else if (!HealthCheckerEqualTo()(group->config_, config)) {
+    // Hash collision between different configs. The session can't be shared.
+    return nullptr;
+  }
+
+  if (group->leader_ == nullptr) {
+    group->leader_ = &member;
+  } else {
+    group->followers_.insert(&member);
+  }
+  return group;
+}
+
+void SharedHealthCheckSessions::leave(Group& group, Member& member) {
+  if (group.leader_ == &member) {
+    group.leader_ = nullptr;
+    if (!group.followers_.empty()) {
+      Member* next = *group.followers_.begin();
+      group.followers_.erase(group.followers_.begin());
+      group.leader_ = next;
+      next->onPromoted();
+    }
+  } else {
+    group.followers_.erase(&member);
+  }
+
+  if (group.leader_ == nullptr) {
+    ASSERT(group.followers_.empty());
+    groups_.erase(group.key_);
+  }
+}
+
+SharedHealthCheckSessionsSharedPtr SharedHealthCheckSessions::get(Singleton::Manager& manager) {
+  return manager.getTyped<SharedHealthCheckSessions>(
+      SINGLETON_MANAGER_REGISTERED_NAME(shared_health_check_sessions),
+      [] { return std::make_shared<SharedHealthCheckSessions>(); });
+}
+
 HealthCheckerImplBase::HealthCheckerImplBase(const Cluster& cluster,
                                              const envoy::config::core::v3::HealthCheck& config,
                                              Event::Dispatcher& dispatcher,
@@ -76,6 +166,13 @@ HealthCheckerImplBase::~HealthCheckerImplBase() {
   // ActiveHealthCheckSession::onDeferredDeleteBase(). This prevents invoking a callback on a
   // deleted parent object (e.g. Cluster).
   callbacks_.clear();
+  // Followers leave their groups first so that the sessions of this health checker which lead a
+  // group only hand over to sessions of other health checkers.
+  for (auto& session : active_sessions_) {
+    if (session.second->isSharedFollower()) {
+      session.second->leaveSharedGroup();
+    }
+  }
   // ASSERTs inside the session destructor check to make sure we have been previously deferred
   // deleted. Unify that logic here before actual destruction happens.
   for (auto& session : active_sessions_) {
@@ -83,6 +180,18 @@ HealthCheckerImplBase::~HealthCheckerImplBase() {
   }
 }
 
+void HealthCheckerImplBase::setSharedSessions(SharedHealthCheckSessionsSharedPtr shared_sessions,
+                                              const envoy::config::core::v3::HealthCheck& config) {
+  ASSERT(active_sessions_.empty());
+  shared_sessions_ = std::move(shared_sessions);
+  shared_sessions_config_ = config;
+  shared_sessions_config_hash_ = MessageUtil::hash(config);
+}
+
+bool HealthCheckerImplBase::clusterHasTraffic() const {
+  return cluster_.info()->stats().upstream_cx_total_.used();
+}
+
 void HealthCheckerImplBase::decHealthy() { stats_.healthy_.sub(1); }
 
 void HealthCheckerImplBase::decDegraded() { stats_.degraded_.sub(1); }
@@ -98,14 +207,15 @@ void HealthCheckerImplBase::incHealthy() { stats_.healthy_.add(1); }
 void HealthCheckerImplBase::incDegraded() { stats_.degraded_.add(1); }
 
 std::chrono::milliseconds HealthCheckerImplBase::interval(HealthState state,
-                                                          HealthTransition changed_state) const {
+                                                          HealthTransition changed_state,
+                                                          bool has_traffic) const {
   // See if the cluster has ever made a connection. If not, we use a much slower interval to keep
   // the host info relatively up to date in case we suddenly start sending traffic to this cluster.
   // In general host updates are rare and this should greatly smooth out needless health checking.
   // If a connection has been established, we choose an interval based on the host's health. Please
   // refer to the HealthCheck API documentation for more details.
   uint64_t base_time_ms;
-  if (cluster_.info()->stats().upstream_cx_total_.used()) {
+  if (has_traffic) {
     // When healthy/unhealthy threshold is configured the health transition of a host will be
     // delayed. In this situation Envoy should use the edge interval settings between health checks.
     //
@@ -250,11 +360,44 @@ HealthCheckerImplBase::ActiveHealthCheckSession::~ActiveHealthCheckSession() {
   ASSERT(interval_timer_ == nullptr && timeout_timer_ == nullptr);
 }
 
+void HealthCheckerImplBase::ActiveHealthCheckSession::start() {
+  if (parent_.shared_sessions_ != nullptr) {
+    shared_group_ = parent_.shared_sessions_->join(parent_.shared_sessions_config_,
+                                                   parent_.shared_sessions_config_hash_,
+                                                   host_->healthCheckAddress()->asString(), *this);
+    if (isSharedFollower()) {
+      // The leader of the group probes on our behalf. If it already completed a check, pick up its
+      // result on the next loop iteration. This is not done inline as the cluster may not have
+      // registered its host check callbacks yet.
+      if (shared_group_->hasResult()) {
+        interval_timer_->enableTimer(std::chrono::milliseconds(0));
+      }
+      return;
+    }
+  }
+
+  onInitialInterval();
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onPromoted() {
+  // Drop a pending replay of the previous leader's result, we now probe ourselves.
+  interval_timer_->disableTimer();
+  onInitialInterval();
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::leaveSharedGroup() {
+  if (shared_group_ != nullptr) {
+    parent_.shared_sessions_->leave(*shared_group_, *this);
+    shared_group_.reset();
+  }
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
   // The session is about to be deferred deleted. Make sure all timers are gone and any
   // implementation specific state is destroyed.
   interval_timer_.reset();
   timeout_timer_.reset();
+  leaveSharedGroup();
   if (!host_->healthFlagGet(Host::HealthFlag::FAILED_ACTIVE_HC)) {
     parent_.decHealthy();
   }
@@ -270,6 +413,33 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::onDeferredDeleteBase() {
 }
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degraded) {
+  // Hold a reference to the group in case applying the result removes this session from it.
+  const SharedHealthCheckSessions::GroupSharedPtr shared_group = shared_group_;
+  const HealthTransition changed_state = applySuccess(degraded);
+  if (shared_group != nullptr) {
+    shared_group->onSuccess(degraded);
+  }
+
+  // It's possible that applying the result caused this session to be deferred deleted.
+  if (timeout_timer_ != nullptr) {
+    timeout_timer_->disableTimer();
+  }
+
+  if (interval_timer_ != nullptr) {
+    interval_timer_->enableTimer(interval(HealthState::Healthy, changed_state));
+  }
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onSharedSuccess(bool degraded) {
+  applySuccess(degraded);
+}
+
+void HealthCheckerImplBase::ActiveHealthCheckSession::onSharedFailure(
+    envoy::data::core::v3::HealthCheckFailureType type, bool retriable) {
+  setUnhealthy(type, retriable);
+}
+
+HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::applySuccess(bool degraded) {
   // If we are healthy, reset the # of unhealthy to zero.
   num_unhealthy_ = 0;
 
@@ -324,9 +494,7 @@ void HealthCheckerImplBase::ActiveHealthCheckSession::handleSuccess(bool degrade
   parent_.stats_.success_.inc();
   first_check_ = false;
   parent_.runCallbacks(host_, changed_state);
-
-  timeout_timer_->disableTimer();
-  interval_timer_->enableTimer(parent_.interval(HealthState::Healthy, changed_state));
+  return changed_state;
 }
 
 namespace {
@@ -387,14 +555,20 @@ HealthTransition HealthCheckerImplBase::ActiveHealthCheckSession::setUnhealthy(
 
 void HealthCheckerImplBase::ActiveHealthCheckSession::handleFailure(
     envoy::data::core::v3::HealthCheckFailureType type, bool retriable) {
+  // Hold a reference to the group in case applying the result removes this session from it.
+  const SharedHealthCheckSessions::GroupSharedPtr shared_group = shared_group_;
   HealthTransition changed_state = setUnhealthy(type, retriable);
+  if (shared_group != nullptr) {
+    shared_group->onFailure(type, retriable);
+  }
+
   // It's possible that the previous call caused this session to be deferred deleted.
   if (timeout_timer_ != nullptr) {
     timeout_timer_->disableTimer();
   }
 
   if (interval_timer_ != nullptr) {
-    interval_timer_->enableTimer(parent_.interval(HealthState::Unhealthy, changed_state));
+    interval_timer_->enableTimer(interval(HealthState::Unhealthy, changed_state));
   }
 }
 
@@ -410,7 +584,23 @@ HealthCheckerImplBase::ActiveHealthCheckSession::clearPendingFlag(HealthTransiti
   return changed_state;
 }
 
+std::chrono::milliseconds
+HealthCheckerImplBase::ActiveHealthCheckSession::interval(HealthState state,
+                                                          HealthTransition changed_state) const {
+  // A shared session probes on behalf of every cluster in its group, so it uses the faster
+  // intervals as soon as any of them has seen traffic.
+  const bool has_traffic = shared_group_ != nullptr ? shared_group_->anyClusterHasTraffic()
+                                                    : parent_.clusterHasTraffic();
+  return parent_.interval(state, changed_state, has_traffic);
+}
+
 void HealthCheckerImplBase::ActiveHealthCheckSession::onIntervalBase() {
+  if (isSharedFollower()) {
+    // Only armed by start() to replay the result of a check the leader completed before we joined.
+    shared_group_->replayResult(*this);
+    return;
+  }
+
   onInterval();
   timeout_timer_->enableTimer(parent_.timeout_);
   parent_.stats_.attempt_.inc();
@@ -7,6 +7,7 @@
 #include "envoy/data/core/v3/health_check_event.pb.h"
 #include "envoy/event/timer.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/singleton/manager.h"
 #include "envoy/stats/scope.h"
 #include "envoy/type/matcher/string.pb.h"
 #include "envoy/upstream/health_checker.h"
@@ -15,6 +16,10 @@
 #include "source/common/common/matchers.h"
 #include "source/common/network/transport_socket_options_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -55,6 +60,117 @@ struct HealthCheckerEqualTo {
   }
 };
 
+/**
+ * Registry of health check sessions which probe the same address with an identical health check
+ * config, used when HealthCheck.share_sessions is set. Sessions are grouped across health checkers
+ * (and therefore across clusters). Within a group only the leader actively probes; the result of
+ * each of its checks is fanned out to the other members (the followers). This is a process wide
+ * singleton which is only accessed from the main thread.
+ */
+class SharedHealthCheckSessions : public Singleton::Instance {
+public:
+  /**
+   * A session which is a member of a group.
+   */
+  class Member {
+  public:
+    virtual ~Member() = default;
+
+    /**
+     * Called on a follower when the leader of its group completed a successful check.
+     * @param degraded supplies whether the host reported itself as degraded.
+     */
+    virtual void onSharedSuccess(bool degraded) PURE;
+
+    /**
+     * Called on a follower when the leader of its group completed a failed check.
+     * @param type supplies the failure type.
+     * @param retriable supplies whether the failure is retriable.
+     */
+    virtual void onSharedFailure(envoy::data::core::v3::HealthCheckFailureType type,
+                                 bool retriable) PURE;
+
+    /**
+     * Called on a follower when it becomes the leader of its group and must start probing.
+     */
+    virtual void onPromoted() PURE;
+
+    /**
+     * @return whether the cluster of the member has ever made an upstream connection. This is used
+     *         by the leader to pick the check interval on behalf of the whole group.
+     */
+    virtual bool clusterHasTraffic() const PURE;
+  };
+
+  class Group {
+  public:
+    Group(const envoy::config::core::v3::HealthCheck& config, uint64_t config_hash,
+          const std::string& address)
+        : config_(config), key_(config_hash, address) {}
+
+    bool isLeader(const Member& member) const { return leader_ == &member; }
+    bool anyClusterHasTraffic() const;
+    bool hasResult() const { return last_result_.has_value(); }
+
+    /**
+     * Record the result of a check performed by the leader and fan it out to the followers.
+     */
+    void onSuccess(bool degraded);
+    void onFailure(envoy::data::core::v3::HealthCheckFailureType type, bool retriable);
+
+    /**
+     * Apply the last recorded result to a member, e.g. to a follower which joined the group after
+     * the leader completed its check.
+     */
+    void replayResult(Member& member) const;
+
+  private:
+    friend class SharedHealthCheckSessions;
+
+    struct Result {
+      bool success_;
+      bool degraded_;
+      envoy::data::core::v3::HealthCheckFailureType failure_type_;
+      bool retriable_;
+    };
+
+    void fanOut() const;
+
+    const envoy::config::core::v3::HealthCheck config_;
+    const std::pair<uint64_t, std::string> key_;
+    Member* leader_{};
+    absl::flat_hash_set<Member*> followers_;
+    absl::optional<Result> last_result_;
+  };
+
+  using GroupSharedPtr = std::shared_ptr<Group>;
+
+  /**
+   * Add a session to the group for its config and address, creating the group if needed. The first
+   * member of a group becomes its leader.
+   * @param config supplies the health check config of the session.
+   * @param config_hash supplies the hash of the config.
+   * @param address supplies the health check address of the session's host.
+   * @param member supplies the session.
+   * @return the group, or nullptr if the session can't be shared and must probe on its own.
+   */
+  GroupSharedPtr join(const envoy::config::core::v3::HealthCheck& config, uint64_t config_hash,
+                      const std::string& address, Member& member);
+
+  /**
+   * Remove a session from its group. If the session was the leader, one of the followers is
+   * promoted. The group is dropped from the registry once it becomes empty.
+   */
+  void leave(Group& group, Member& member);
+
+  static std::shared_ptr<SharedHealthCheckSessions> get(Singleton::Manager& manager);
+
+private:
+  absl::flat_hash_map<std::pair<uint64_t, std::string>, GroupSharedPtr> groups_;
+};
+
+using SharedHealthCheckSessionsSharedPtr = std::shared_ptr<SharedHealthCheckSessions>;
+
 /**
  * Base implementation for all health checkers.
  */
@@ -72,14 +188,35 @@ public:
     return transport_socket_match_metadata_;
   }
 
+  /**
+   * Share the sessions of this health checker with those of other health checkers with an
+   * identical config. Must be called before start().
+   * @param shared_sessions supplies the registry of shared sessions.
+   * @param config supplies the health check config this health checker was created with.
+   */
+  void setSharedSessions(SharedHealthCheckSessionsSharedPtr shared_sessions,
+                         const envoy::config::core::v3::HealthCheck& config);
+
 protected:
-  class ActiveHealthCheckSession : public Event::DeferredDeletable {
+  class ActiveHealthCheckSession : public Event::DeferredDeletable,
+                                   public SharedHealthCheckSessions::Member {
   public:
     ~ActiveHealthCheckSession() override;
     HealthTransition setUnhealthy(envoy::data::core::v3::HealthCheckFailureType type,
                                   bool retriable);
     void onDeferredDeleteBase();
-    void start() { onInitialInterval(); }
+    void start();
+    void leaveSharedGroup();
+    bool isSharedFollower() const {
+      return shared_group_ != nullptr && !shared_group_->isLeader(*this);
+    }
+
+    // SharedHealthCheckSessions::Member
+    void onSharedSuccess(bool degraded) override;
+    void onSharedFailure(envoy::data::core::v3::HealthCheckFailureType type,
+                         bool retriable) override;
+    void onPromoted() override;
+    bool clusterHasTraffic() const override { return parent_.clusterHasTraffic(); }
 
   protected:
     ActiveHealthCheckSession(HealthCheckerImplBase& parent, HostSharedPtr host);
@@ -95,6 +232,9 @@ protected:
     // been health checked.
     // Returns the changed state to use following the flag update.
     HealthTransition clearPendingFlag(HealthTransition changed_state);
+    // Applies the result of a successful check to the host without touching the timers.
+    HealthTransition applySuccess(bool degraded);
+    std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state) const;
     virtual void onInterval() PURE;
     void onIntervalBase();
     virtual void onTimeout() PURE;
@@ -103,6 +243,8 @@ protected:
     void onInitialInterval();
 
     HealthCheckerImplBase& parent_;
+    // Set if the session is a member of a group of shared sessions.
+    SharedHealthCheckSessions::GroupSharedPtr shared_group_;
     Event::TimerPtr interval_timer_;
     Event::TimerPtr timeout_timer_;
     uint32_t num_unhealthy_{};
@@ -146,12 +288,14 @@ private:
   };
 
   void addHosts(const HostVector& hosts);
+  bool clusterHasTraffic() const;
   void decHealthy();
   void decDegraded();
   HealthCheckerStats generateStats(Stats::Scope& scope);
   void incHealthy();
   void incDegraded();
-  std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state) const;
+  std::chrono::milliseconds interval(HealthState state, HealthTransition changed_state,
+                                     bool has_traffic) const;
   std::chrono::milliseconds intervalWithJitter(uint64_t base_time_ms,
                                                std::chrono::milliseconds interval_jitter) const;
   void onClusterMemberUpdate(const HostVector& hosts_added, const HostVector& hosts_removed);
@@ -178,6 +322,9 @@ private:
   absl::node_hash_map<HostSharedPtr, ActiveHealthCheckSessionPtr> active_sessions_;
   const std::shared_ptr<const Network::TransportSocketOptionsImpl> transport_socket_options_;
   const MetadataConstSharedPtr transport_socket_match_metadata_;
+  SharedHealthCheckSessionsSharedPtr shared_sessions_;
+  envoy::config::core::v3::HealthCheck shared_sessions_config_;
+  uint64_t shared_sessions_config_hash_{};
   const Common::CallbackHandlePtr member_update_cb_;
 };
 
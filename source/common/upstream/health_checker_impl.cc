@@ -89,28 +89,34 @@ HealthCheckerSharedPtr HealthCheckerFactory::create(
     const envoy::config::core::v3::HealthCheck& health_check_config, Upstream::Cluster& cluster,
     Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
     AccessLog::AccessLogManager& log_manager,
-    ProtobufMessage::ValidationVisitor& validation_visitor, Api::Api& api) {
+    ProtobufMessage::ValidationVisitor& validation_visitor, Api::Api& api,
+    const SharedHealthCheckSessionsSharedPtr& shared_sessions) {
   HealthCheckEventLoggerPtr event_logger;
   if (!health_check_config.event_log_path().empty()) {
     event_logger = std::make_unique<HealthCheckEventLoggerImpl>(
         log_manager, dispatcher.timeSource(), health_check_config.event_log_path());
   }
+  std::shared_ptr<HealthCheckerImplBase> health_checker;
   switch (health_check_config.health_checker_case()) {
   case envoy::config::core::v3::HealthCheck::HealthCheckerCase::kHttpHealthCheck:
-    return std::make_shared<ProdHttpHealthCheckerImpl>(cluster, health_check_config, dispatcher,
-                                                       runtime, api.randomGenerator(),
-                                                       std::move(event_logger));
+    health_checker = std::make_shared<ProdHttpHealthCheckerImpl>(
+        cluster, health_check_config, dispatcher, runtime, api.randomGenerator(),
+        std::move(event_logger));
+    break;
   case envoy::config::core::v3::HealthCheck::HealthCheckerCase::kTcpHealthCheck:
-    return std::make_shared<TcpHealthCheckerImpl>(cluster, health_check_config, dispatcher, runtime,
-                                                  api.randomGenerator(), std::move(event_logger));
+    health_checker =
+        std::make_shared<TcpHealthCheckerImpl>(cluster, health_check_config, dispatcher, runtime,
+                                               api.randomGenerator(), std::move(event_logger));
+    break;
   case envoy::config::core::v3::HealthCheck::HealthCheckerCase::kGrpcHealthCheck:
     if (!(cluster.info()->features() & Upstream::ClusterInfo::Features::HTTP2)) {
       throw EnvoyException(fmt::format("{} cluster must support HTTP/2 for gRPC healthchecking",
                                        cluster.info()->name()));
     }
-    return std::make_shared<ProdGrpcHealthCheckerImpl>(cluster, health_check_config, dispatcher,
-                                                       runtime, api.randomGenerator(),
-                                                       std::move(event_logger));
+    health_checker = std::make_shared<ProdGrpcHealthCheckerImpl>(
+        cluster, health_check_config, dispatcher, runtime, api.randomGenerator(),
+        std::move(event_logger));
+    break;
   case envoy::config::core::v3::HealthCheck::HealthCheckerCase::kCustomHealthCheck: {
     auto& factory =
         Config::Utility::getAndCheckFactory<Server::Configuration::CustomHealthCheckerFactory>(
@@ -118,12 +124,18 @@ HealthCheckerSharedPtr HealthCheckerFactory::create(
     std::unique_ptr<Server::Configuration::HealthCheckerFactoryContext> context(
         new HealthCheckerFactoryContextImpl(cluster, runtime, dispatcher, std::move(event_logger),
                                             validation_visitor, api));
+    // Sessions of custom health checkers are never shared.
     return factory.createCustomHealthChecker(health_check_config, *context);
   }
   default:
     // Checked by schema.
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
+
+  if (shared_sessions != nullptr && health_check_config.share_sessions()) {
+    health_checker->setSharedSessions(shared_sessions, health_check_config);
+  }
+  return health_checker;
 }
 
 HttpHealthCheckerImpl::HttpHealthCheckerImpl(const Cluster& cluster,
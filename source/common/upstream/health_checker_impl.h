@@ -43,7 +43,24 @@ public:
   create(const envoy::config::core::v3::HealthCheck& health_check_config,
          Upstream::Cluster& cluster, Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
          AccessLog::AccessLogManager& log_manager,
-         ProtobufMessage::ValidationVisitor& validation_visitor, Api::Api& api);
+         ProtobufMessage::ValidationVisitor& validation_visitor, Api::Api& api) {
+    return create(health_check_config, cluster, runtime, dispatcher, log_manager,
+                  validation_visitor, api, nullptr);
+  }
+
+  /**
+   * Create a health checker which shares its sessions with those of other health checkers with an
+   * identical config if the config enables session sharing.
+   * @param shared_sessions supplies the registry of shared sessions. If nullptr, sessions are not
+   *        shared.
+   * @return a health checker.
+   */
+  static HealthCheckerSharedPtr
+  create(const envoy::config::core::v3::HealthCheck& health_check_config,
+         Upstream::Cluster& cluster, Runtime::Loader& runtime, Event::Dispatcher& dispatcher,
+         AccessLog::AccessLogManager& log_manager,
+         ProtobufMessage::ValidationVisitor& validation_visitor, Api::Api& api,
+         const SharedHealthCheckSessionsSharedPtr& shared_sessions);
 };
 
 /**
@@ -996,8 +996,8 @@ HostConstSharedPtr LeastRequestLoadBalancer::unweightedHostPick(const HostVector
       continue;
     }
 
-    const auto candidate_active_rq = candidate_host->stats().rq_active_.value();
-    const auto sampled_active_rq = sampled_host->stats().rq_active_.value();
+    const auto candidate_active_rq = candidate_host->activeRequests().estimate();
+    const auto sampled_active_rq = sampled_host->activeRequests().estimate();
     if (sampled_active_rq < candidate_active_rq) {
       candidate_host = sampled_host;
     }
@@ -1032,6 +1032,55 @@ HostConstSharedPtr RandomLoadBalancer::peekOrChoose(LoadBalancerContext* context
   return hosts_to_use[random_hash % hosts_to_use.size()];
 }
 
+PeakEwmaLoadBalancer::PeakEwmaLoadBalancer(
+    const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+    Runtime::Loader& runtime, Random::RandomGenerator& random,
+    const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config,
+    const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>& peak_ewma_config)
+    : ZoneAwareLoadBalancerBase(priority_set, local_priority_set, stats, runtime, random,
+                                common_config),
+      choice_count_(peak_ewma_config.has_value()
+                        ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(peak_ewma_config.value(), choice_count, 2)
+                        : 2),
+      default_rtt_us_(1000.0 * (peak_ewma_config.has_value()
+                                    ? PROTOBUF_GET_MS_OR_DEFAULT(peak_ewma_config.value(),
+                                                                 default_rtt, 30)
+                                    : 30)) {}
+
+double PeakEwmaLoadBalancer::cost(const Host& host) const {
+  const double rtt_us = host.latencyEstimator().roundTripTimeEstimate().value_or(default_rtt_us_);
+  return rtt_us * (host.activeRequests().estimate() + 1) / host.weight();
+}
+
+HostConstSharedPtr PeakEwmaLoadBalancer::chooseHostOnce(LoadBalancerContext* context) {
+  const absl::optional<HostsSource> hosts_source = hostSourceToUse(context, random(false));
+  if (!hosts_source) {
+    return nullptr;
+  }
+
+  const HostVector& hosts_to_use = hostSourceToHosts(*hosts_source);
+  if (hosts_to_use.empty()) {
+    return nullptr;
+  }
+
+  const HostSharedPtr* candidate_host = &hosts_to_use[random_.random() % hosts_to_use.size()];
+  if (hosts_to_use.size() == 1) {
+    return *candidate_host;
+  }
+
+  double candidate_cost = cost(**candidate_host);
+  for (uint32_t choice_idx = 1; choice_idx < choice_count_; ++choice_idx) {
+    const HostSharedPtr& sampled_host = hosts_to_use[random_.random() % hosts_to_use.size()];
+    const double sampled_cost = cost(*sampled_host);
+    if (sampled_cost < candidate_cost) {
+      candidate_host = &sampled_host;
+      candidate_cost = sampled_cost;
+    }
+  }
+
+  return *candidate_host;
+}
+
 SubsetSelectorImpl::SubsetSelectorImpl(
     const Protobuf::RepeatedPtrField<std::string>& selector_keys,
     envoy::config::cluster::v3::Cluster::LbSubsetConfig::LbSubsetSelector::
@@ -614,10 +614,10 @@ private:
     double host_weight = static_cast<double>(host.weight());
 
     if (active_request_bias_ == 1.0) {
-      host_weight = static_cast<double>(host.weight()) / (host.stats().rq_active_.value() + 1);
+      host_weight = static_cast<double>(host.weight()) / (host.activeRequests().estimate() + 1);
     } else if (active_request_bias_ != 0.0) {
       host_weight = static_cast<double>(host.weight()) /
-                    std::pow(host.stats().rq_active_.value() + 1, active_request_bias_);
+                    std::pow(host.activeRequests().estimate() + 1, active_request_bias_);
     }
 
     if (!noHostsAreInSlowStart()) {
@@ -661,6 +661,39 @@ protected:
   HostConstSharedPtr peekOrChoose(LoadBalancerContext* context, bool peek);
 };
 
+/**
+ * Latency aware load balancer which samples choice_count random hosts and picks the one with the
+ * lowest cost, where
+ *
+ * `cost = latency_estimate * (active_requests + 1) / load_balancing_weight`
+ *
+ * The latency estimate is the peak EWMA maintained by the host's LatencyEstimator.
+ */
+class PeakEwmaLoadBalancer : public ZoneAwareLoadBalancerBase {
+public:
+  PeakEwmaLoadBalancer(
+      const PrioritySet& priority_set, const PrioritySet* local_priority_set, ClusterStats& stats,
+      Runtime::Loader& runtime, Random::RandomGenerator& random,
+      const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config,
+      const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>&
+          peak_ewma_config);
+
+  // Upstream::ZoneAwareLoadBalancerBase
+  HostConstSharedPtr chooseHostOnce(LoadBalancerContext* context) override;
+  HostConstSharedPtr peekAnotherHost(LoadBalancerContext*) override {
+    // Like LeastRequestLoadBalancer, the pick depends on state changed by other threads between
+    // preconnecting and picking, so deterministic preconnecting is not supported.
+    return nullptr;
+  }
+
+private:
+  double cost(const Host& host) const;
+
+  const uint32_t choice_count_;
+  // Round trip latency in microseconds assumed for hosts without an estimate.
+  const double default_rtt_us_;
+};
+
 /**
  * Implementation of SubsetSelector
  */
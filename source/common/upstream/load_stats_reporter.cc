@@ -83,7 +83,7 @@ void LoadStatsReporter::sendLoadStatsRequest() {
         for (const auto& host : hosts) {
           rq_success += host->stats().rq_success_.latch();
           rq_error += host->stats().rq_error_.latch();
-          rq_active += host->stats().rq_active_.value();
+          rq_active += host->activeRequests().total();
           rq_issued += host->stats().rq_total_.latch();
         }
         if (rq_success + rq_error + rq_active != 0) {
@@ -98,6 +98,8 @@ public:
   Outlier::DetectorHostMonitor& outlierDetector() const override {
     return logical_host_->outlierDetector();
   }
+  LatencyEstimator& latencyEstimator() const override { return logical_host_->latencyEstimator(); }
+  ActiveRequestCounter& activeRequests() const override { return logical_host_->activeRequests(); }
   HostStats& stats() const override { return logical_host_->stats(); }
   const std::string& hostnameForHealthChecks() const override {
     return logical_host_->hostnameForHealthChecks();
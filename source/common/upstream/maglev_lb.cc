@@ -1,13 +1,18 @@
 #include "source/common/upstream/maglev_lb.h"
 
+#include <algorithm>
+
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
+#include "absl/container/flat_hash_map.h"
+
 namespace Envoy {
 namespace Upstream {
 
 MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
                          double max_normalized_weight, uint64_t table_size,
-                         bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats)
+                         bool use_hostname_for_hashing, MaglevLoadBalancerStats& stats,
+                         const MaglevTable* previous)
     : table_size_(table_size), stats_(stats) {
   // We can't do anything sensible with no hosts.
   if (normalized_host_weights.empty()) {
@@ -29,10 +34,36 @@ MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weigh
 
   table_.resize(table_size_);
 
+  if (previous != nullptr && previous->table_.size() == table_size_) {
+    populateIncrementally(table_build_entries, *previous);
+  } else {
+    populate(table_build_entries, max_normalized_weight);
+  }
+
+  uint64_t min_entries_per_host = table_size_;
+  uint64_t max_entries_per_host = 0;
+  for (const auto& entry : table_build_entries) {
+    min_entries_per_host = std::min(entry.count_, min_entries_per_host);
+    max_entries_per_host = std::max(entry.count_, max_entries_per_host);
+  }
+  stats_.min_entries_per_host_.set(min_entries_per_host);
+  stats_.max_entries_per_host_.set(max_entries_per_host);
+
+  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
+    for (uint64_t i = 0; i < table_.size(); i++) {
+      const absl::string_view key_to_hash = hashKey(table_[i], use_hostname_for_hashing);
+      ENVOY_LOG(trace, "maglev: i={} address={} host={}", i, table_[i]->address()->asString(),
+                key_to_hash);
+    }
+  }
+}
+
+void MaglevTable::populate(std::vector<TableBuildEntry>& table_build_entries,
+                           double max_normalized_weight) {
   // Iterate through the table build entries as many times as it takes to fill up the table.
   uint64_t table_index = 0;
   for (uint32_t iteration = 1; table_index < table_size_; ++iteration) {
-    for (uint64_t i = 0; i < table_build_entries.size() && table_index < table_size; i++) {
+    for (uint64_t i = 0; i < table_build_entries.size() && table_index < table_size_; i++) {
       TableBuildEntry& entry = table_build_entries[i];
       // To understand how target_weight_ and weight_ are used below, consider a host with weight
       // equal to max_normalized_weight. This would be picked on every single iteration. If it had
@@ -54,21 +85,75 @@ MaglevTable::MaglevTable(const NormalizedHostWeightVector& normalized_host_weigh
       table_index++;
     }
   }
+}
 
-  uint64_t min_entries_per_host = table_size_;
-  uint64_t max_entries_per_host = 0;
+void MaglevTable::populateIncrementally(std::vector<TableBuildEntry>& table_build_entries,
+                                        const MaglevTable& previous) {
+  // Each host gets a share of the table proportional to its weight. The entries left over by
+  // rounding down go to the hosts with the largest remainders.
+  double weight_sum = 0;
   for (const auto& entry : table_build_entries) {
-    min_entries_per_host = std::min(entry.count_, min_entries_per_host);
-    max_entries_per_host = std::max(entry.count_, max_entries_per_host);
+    weight_sum += entry.weight_;
+  }
+  uint64_t assigned = 0;
+  std::vector<std::pair<double, uint32_t>> remainders;
+  remainders.reserve(table_build_entries.size());
+  for (uint32_t i = 0; i < table_build_entries.size(); i++) {
+    TableBuildEntry& entry = table_build_entries[i];
+    const double share = entry.weight_ / weight_sum * table_size_;
+    entry.quota_ = std::min(static_cast<uint64_t>(share), table_size_ - assigned);
+    assigned += entry.quota_;
+    remainders.emplace_back(share - entry.quota_, i);
+  }
+  std::sort(remainders.begin(), remainders.end(),
+            [](const auto& a, const auto& b) { return a.first > b.first; });
+  for (uint64_t i = 0; assigned < table_size_; i = (i + 1) % remainders.size()) {
+    table_build_entries[remainders[i].second].quota_++;
+    assigned++;
   }
-  stats_.min_entries_per_host_.set(min_entries_per_host);
-  stats_.max_entries_per_host_.set(max_entries_per_host);
 
-  if (ENVOY_LOG_CHECK_LEVEL(trace)) {
-    for (uint64_t i = 0; i < table_.size(); i++) {
-      const absl::string_view key_to_hash = hashKey(table_[i], use_hostname_for_hashing);
-      ENVOY_LOG(trace, "maglev: i={} address={} host={}", i, table_[i]->address()->asString(),
-                key_to_hash);
+  // Keep the entries of the previous table whose host is still present and within its share.
+  absl::flat_hash_map<const Host*, uint32_t> entry_index;
+  entry_index.reserve(table_build_entries.size());
+  for (uint32_t i = 0; i < table_build_entries.size(); i++) {
+    entry_index.emplace(table_build_entries[i].host_.get(), i);
+  }
+  uint64_t table_index = 0;
+  const Host* last_host = nullptr;
+  TableBuildEntry* last_entry = nullptr;
+  for (uint64_t c = 0; c < table_size_; c++) {
+    const Host* host = previous.table_[c].get();
+    // Consecutive entries frequently belong to the same host when few hosts changed.
+    if (host != last_host) {
+      const auto it = entry_index.find(host);
+      last_host = host;
+      last_entry = it != entry_index.end() ? &table_build_entries[it->second] : nullptr;
+    }
+    if (last_entry != nullptr && last_entry->count_ < last_entry->quota_) {
+      table_[c] = last_entry->host_;
+      last_entry->count_++;
+      table_index++;
+    }
+  }
+  ENVOY_LOG(debug, "maglev: incremental update kept {} of {} entries", table_index, table_size_);
+
+  // Hand out the free entries round robin to the hosts below their share, each following its own
+  // permutation, as in the full build.
+  while (table_index < table_size_) {
+    for (auto& entry : table_build_entries) {
+      if (entry.count_ == entry.quota_) {
+        continue;
+      }
+      uint64_t c = permutation(entry);
+      while (table_[c] != nullptr) {
+        entry.next_++;
+        c = permutation(entry);
+      }
+
+      table_[c] = entry.host_;
+      entry.next_++;
+      entry.count_++;
+      table_index++;
     }
   }
 }
@@ -98,7 +183,19 @@ MaglevLoadBalancer::MaglevLoadBalancer(
     const absl::optional<envoy::config::cluster::v3::Cluster::MaglevLbConfig>& config,
     const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
     : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
-      scope_(scope.createScope("maglev_lb.")), stats_(generateStats(*scope_)),
+      builder_(std::make_shared<TableBuilder>(scope, config, common_config)) {
+  ENVOY_LOG(debug, "maglev table size: {}", builder_->table_size_);
+  // The table size must be prime number.
+  if (!Primes::isPrime(builder_->table_size_)) {
+    throw EnvoyException("The table size of maglev must be prime number");
+  }
+}
+
+MaglevLoadBalancer::TableBuilder::TableBuilder(
+    Stats::Scope& scope,
+    const absl::optional<envoy::config::cluster::v3::Cluster::MaglevLbConfig>& config,
+    const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
+    : scope_(scope.createScope("maglev_lb.")), stats_(generateStats(*scope_)),
       table_size_(config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), table_size,
                                                            MaglevTable::DefaultTableSize)
                          : MaglevTable::DefaultTableSize),
@@ -107,12 +204,33 @@ MaglevLoadBalancer::MaglevLoadBalancer(
               ? common_config.consistent_hashing_lb_config().use_hostname_for_hashing()
               : false),
       hash_balance_factor_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
-          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)) {
-  ENVOY_LOG(debug, "maglev table size: {}", table_size_);
-  // The table size must be prime number.
-  if (!Primes::isPrime(table_size_)) {
-    throw EnvoyException("The table size of maglev must be prime number");
+          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)),
+      incremental_table_updates_(config ? config.value().incremental_table_updates() : false) {}
+
+ThreadAwareLoadBalancerBase::HashingLoadBalancerSharedPtr
+MaglevLoadBalancer::TableBuilder::createLoadBalancer(
+    uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
+    double /* min_normalized_weight */, double max_normalized_weight) {
+  const MaglevTable* previous = nullptr;
+  if (incremental_table_updates_ && priority < previous_tables_.size()) {
+    previous = previous_tables_[priority].get();
+  }
+  auto maglev_lb =
+      std::make_shared<MaglevTable>(normalized_host_weights, max_normalized_weight, table_size_,
+                                    use_hostname_for_hashing_, stats_, previous);
+  if (incremental_table_updates_) {
+    if (priority >= previous_tables_.size()) {
+      previous_tables_.resize(priority + 1);
+    }
+    previous_tables_[priority] = maglev_lb;
+  }
+
+  if (hash_balance_factor_ == 0) {
+    return maglev_lb;
   }
+
+  return std::make_shared<BoundedLoadHashingLoadBalancer>(maglev_lb, normalized_host_weights,
+                                                          hash_balance_factor_);
 }
 
 MaglevLoadBalancerStats MaglevLoadBalancer::generateStats(Stats::Scope& scope) {
@@ -34,9 +34,14 @@ struct MaglevLoadBalancerStats {
 class MaglevTable : public ThreadAwareLoadBalancerBase::HashingLoadBalancer,
                     Logger::Loggable<Logger::Id::upstream> {
 public:
+  /**
+   * @param previous if not nullptr, the table is derived incrementally from this table: entries of
+   *        hosts still present are kept unless the host exceeds its share of the new table, and
+   *        only the remaining entries are populated, following each host's permutation.
+   */
   MaglevTable(const NormalizedHostWeightVector& normalized_host_weights,
               double max_normalized_weight, uint64_t table_size, bool use_hostname_for_hashing,
-              MaglevLoadBalancerStats& stats);
+              MaglevLoadBalancerStats& stats, const MaglevTable* previous);
 
   // ThreadAwareLoadBalancerBase::HashingLoadBalancer
   HostConstSharedPtr chooseHost(uint64_t hash, uint32_t attempt) const override;
@@ -56,9 +61,14 @@ private:
     double target_weight_{};
     uint64_t next_{};
     uint64_t count_{};
+    // Only used by incremental builds.
+    uint64_t quota_{};
   };
 
   uint64_t permutation(const TableBuildEntry& entry);
+  void populate(std::vector<TableBuildEntry>& table_build_entries, double max_normalized_weight);
+  void populateIncrementally(std::vector<TableBuildEntry>& table_build_entries,
+                             const MaglevTable& previous);
 
   const uint64_t table_size_;
   std::vector<HostConstSharedPtr> table_;
@@ -77,33 +87,37 @@ public:
       const absl::optional<envoy::config::cluster::v3::Cluster::MaglevLbConfig>& config,
       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config);
 
-  const MaglevLoadBalancerStats& stats() const { return stats_; }
-  uint64_t tableSize() const { return table_size_; }
+  const MaglevLoadBalancerStats& stats() const { return builder_->stats_; }
+  uint64_t tableSize() const { return builder_->table_size_; }
 
 private:
-  // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
-                     double /* min_normalized_weight */, double max_normalized_weight) override {
-    HashingLoadBalancerSharedPtr maglev_lb =
-        std::make_shared<MaglevTable>(normalized_host_weights, max_normalized_weight, table_size_,
-                                      use_hostname_for_hashing_, stats_);
-
-    if (hash_balance_factor_ == 0) {
-      return maglev_lb;
-    }
+  struct TableBuilder : public HashingLoadBalancerBuilder {
+    TableBuilder(
+        Stats::Scope& scope,
+        const absl::optional<envoy::config::cluster::v3::Cluster::MaglevLbConfig>& config,
+        const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config);
+
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancerBuilder
+    HashingLoadBalancerSharedPtr
+    createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
+                       double /* min_normalized_weight */, double max_normalized_weight) override;
+
+    Stats::ScopePtr scope_;
+    MaglevLoadBalancerStats stats_;
+    const uint64_t table_size_;
+    const bool use_hostname_for_hashing_;
+    const uint32_t hash_balance_factor_;
+    const bool incremental_table_updates_;
+    // The most recent table of each priority, only kept for incremental table updates.
+    std::vector<std::shared_ptr<const MaglevTable>> previous_tables_;
+  };
 
-    return std::make_shared<BoundedLoadHashingLoadBalancer>(
-        maglev_lb, std::move(normalized_host_weights), hash_balance_factor_);
-  }
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerBuilderSharedPtr builder() override { return builder_; }
 
   static MaglevLoadBalancerStats generateStats(Stats::Scope& scope);
 
-  Stats::ScopePtr scope_;
-  MaglevLoadBalancerStats stats_;
-  const uint64_t table_size_;
-  const bool use_hostname_for_hashing_;
-  const uint32_t hash_balance_factor_;
+  const std::shared_ptr<TableBuilder> builder_;
 };
 
 } // namespace Upstream
@@ -23,13 +23,57 @@ namespace Envoy {
 namespace Upstream {
 namespace Outlier {
 
+SINGLETON_MANAGER_REGISTRATION(outlier_detection_sweep_thread);
+
+SweepThread::SweepThread(Thread::ThreadFactory& thread_factory)
+    : thread_(thread_factory.createThread([this]() -> void { threadRoutine(); },
+                                          Thread::Options{"OutlierSweep"})) {}
+
+SweepThread::~SweepThread() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopped_ = true;
+  }
+  thread_->join();
+}
+
+void SweepThread::post(std::function<void()> sweep) {
+  absl::MutexLock lock(&mutex_);
+  pending_sweeps_.push_back(std::move(sweep));
+}
+
+void SweepThread::threadRoutine() {
+  while (true) {
+    std::function<void()> sweep;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &SweepThread::sweepPendingOrStopped));
+      if (stopped_) {
+        return;
+      }
+      sweep = std::move(pending_sweeps_.front());
+      pending_sweeps_.pop_front();
+    }
+    sweep();
+  }
+}
+
+SweepThreadSharedPtr SweepThread::get(Singleton::Manager& manager,
+                                      Thread::ThreadFactory& thread_factory) {
+  return manager.getTyped<SweepThread>(
+      SINGLETON_MANAGER_REGISTERED_NAME(outlier_detection_sweep_thread),
+      [&thread_factory] { return std::make_shared<SweepThread>(thread_factory); });
+}
+
 DetectorSharedPtr DetectorImplFactory::createForCluster(
     Cluster& cluster, const envoy::config::cluster::v3::Cluster& cluster_config,
-    Event::Dispatcher& dispatcher, Runtime::Loader& runtime, EventLoggerSharedPtr event_logger) {
+    Event::Dispatcher& dispatcher, Runtime::Loader& runtime, EventLoggerSharedPtr event_logger,
+    SweepThreadSharedPtr sweep_thread) {
   if (cluster_config.has_outlier_detection()) {
 
     return DetectorImpl::create(cluster, cluster_config.outlier_detection(), dispatcher, runtime,
-                                dispatcher.timeSource(), std::move(event_logger));
+                                dispatcher.timeSource(), std::move(event_logger),
+                                std::move(sweep_thread));
   } else {
     return nullptr;
   }
@@ -259,11 +303,12 @@ DetectorConfig::DetectorConfig(const envoy::config::cluster::v3::OutlierDetectio
 DetectorImpl::DetectorImpl(const Cluster& cluster,
                            const envoy::config::cluster::v3::OutlierDetection& config,
                            Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
-                           TimeSource& time_source, EventLoggerSharedPtr event_logger)
+                           TimeSource& time_source, EventLoggerSharedPtr event_logger,
+                           SweepThreadSharedPtr sweep_thread)
     : config_(config), dispatcher_(dispatcher), runtime_(runtime), time_source_(time_source),
       stats_(generateStats(cluster.info()->statsScope())),
       interval_timer_(dispatcher.createTimer([this]() -> void { onIntervalTimer(); })),
-      event_logger_(event_logger) {
+      event_logger_(event_logger), sweep_thread_(std::move(sweep_thread)) {
   // Insert success rate initial numbers for each type of SR detector
   external_origin_sr_num_ = {-1, -1};
   local_origin_sr_num_ = {-1, -1};
@@ -282,9 +327,10 @@ std::shared_ptr<DetectorImpl>
 DetectorImpl::create(const Cluster& cluster,
                      const envoy::config::cluster::v3::OutlierDetection& config,
                      Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
-                     TimeSource& time_source, EventLoggerSharedPtr event_logger) {
-  std::shared_ptr<DetectorImpl> detector(
-      new DetectorImpl(cluster, config, dispatcher, runtime, time_source, event_logger));
+                     TimeSource& time_source, EventLoggerSharedPtr event_logger,
+                     SweepThreadSharedPtr sweep_thread) {
+  std::shared_ptr<DetectorImpl> detector(new DetectorImpl(
+      cluster, config, dispatcher, runtime, time_source, event_logger, std::move(sweep_thread)));
 
   if (detector->config().maxEjectionTimeMs() < detector->config().baseEjectionTimeMs()) {
     throw EnvoyException(
@@ -316,6 +362,10 @@ void DetectorImpl::initialize(const Cluster& cluster) {
           }
 
           host_monitors_.erase(host);
+          backed_off_hosts_.erase(host);
+        }
+        if (!hosts_added.empty() || !hosts_removed.empty()) {
+          sweep_hosts_.reset();
         }
       });
 
@@ -327,6 +377,7 @@ void DetectorImpl::addHostMonitor(HostSharedPtr host) {
   DetectorHostMonitorImpl* monitor = new DetectorHostMonitorImpl(shared_from_this(), host);
   host_monitors_[host] = monitor;
   host->setOutlierDetector(DetectorHostMonitorPtr{monitor});
+  sweep_hosts_.reset();
 }
 
 void DetectorImpl::armIntervalTimer() {
@@ -366,6 +417,18 @@ void DetectorImpl::checkHostForUneject(HostSharedPtr host, DetectorHostMonitorIm
   }
 }
 
+void DetectorImpl::checkHostsForUneject(MonotonicTime now) {
+  // Callbacks may run while checking, so iterate over a copy.
+  const std::vector<std::pair<HostSharedPtr, DetectorHostMonitorImpl*>> backed_off_hosts(
+      backed_off_hosts_.begin(), backed_off_hosts_.end());
+  for (const auto& host : backed_off_hosts) {
+    checkHostForUneject(host.first, host.second, now);
+    if (host.second->ejectTimeBackoff() == 0) {
+      backed_off_hosts_.erase(host.first);
+    }
+  }
+}
+
 bool DetectorImpl::enforceEjection(envoy::data::cluster::v3::OutlierEjectionType type) {
   switch (type) {
   case envoy::data::cluster::v3::CONSECUTIVE_5XX:
@@ -469,7 +532,9 @@ void DetectorImpl::ejectHost(HostSharedPtr host,
       // Deprecated counter, preserving old behaviour until it's removed.
       stats_.ejections_total_.inc();
     }
-    if (enforceEjection(type)) {
+    // A host may be both a success rate and a failure percentage outlier, or be ejected for
+    // consecutive errors while a background sweep runs. It is only ejected once.
+    if (enforceEjection(type) && !host->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
       ejections_active_helper_.inc();
       updateEnforcedEjectionStats(type);
       host_monitors_[host]->eject(time_source_.monotonicTime());
@@ -481,6 +546,7 @@ void DetectorImpl::ejectHost(HostSharedPtr host,
           (max_eject_time + base_eject_time)) {
         host_monitors_[host]->ejectTimeBackoff()++;
       }
+      backed_off_hosts_.emplace(host, host_monitors_[host]);
 
       runCallbacks(host);
       if (event_logger_) {
@@ -600,35 +666,62 @@ DetectorImpl::EjectionPair DetectorImpl::successRateEjectionThreshold(
   return {mean, (mean - (success_rate_stdev_factor * stdev))};
 }
 
-void DetectorImpl::processSuccessRateEjections(
-    DetectorHostMonitor::SuccessRateMonitorType monitor_type) {
-  uint64_t success_rate_minimum_hosts = runtime_.snapshot().getInteger(
-      SuccessRateMinimumHostsRuntime, config_.successRateMinimumHosts());
-  uint64_t success_rate_request_volume = runtime_.snapshot().getInteger(
-      SuccessRateRequestVolumeRuntime, config_.successRateRequestVolume());
-  uint64_t failure_percentage_minimum_hosts = runtime_.snapshot().getInteger(
-      FailurePercentageMinimumHostsRuntime, config_.failurePercentageMinimumHosts());
-  uint64_t failure_percentage_request_volume = runtime_.snapshot().getInteger(
-      FailurePercentageRequestVolumeRuntime, config_.failurePercentageRequestVolume());
-
-  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
-  std::vector<HostSuccessRatePair> valid_failure_percentage_hosts;
-  double success_rate_sum = 0;
+const DetectorImpl::SweepHostsConstSharedPtr& DetectorImpl::sweepHosts() {
+  if (sweep_hosts_ == nullptr) {
+    sweep_hosts_ = std::make_shared<const SweepHosts>(host_monitors_.begin(), host_monitors_.end());
+  }
+  return sweep_hosts_;
+}
+
+DetectorImpl::SweepParams DetectorImpl::sweepParams() {
+  return {runtime_.snapshot().getInteger(SuccessRateMinimumHostsRuntime,
+                                         config_.successRateMinimumHosts()),
+          runtime_.snapshot().getInteger(SuccessRateRequestVolumeRuntime,
+                                         config_.successRateRequestVolume()),
+          runtime_.snapshot().getInteger(FailurePercentageMinimumHostsRuntime,
+                                         config_.failurePercentageMinimumHosts()),
+          runtime_.snapshot().getInteger(FailurePercentageRequestVolumeRuntime,
+                                         config_.failurePercentageRequestVolume()),
+          runtime_.snapshot().getInteger(SuccessRateStdevFactorRuntime,
+                                         config_.successRateStdevFactor()) /
+              1000.0,
+          static_cast<double>(runtime_.snapshot().getInteger(
+              FailurePercentageThresholdRuntime, config_.failurePercentageThreshold()))};
+}
+
+void DetectorImpl::resetSuccessRates(const SweepHosts& hosts) {
+  for (const auto& host : hosts) {
+    // Need to update the writer bucket to keep the data valid.
+    host.second->updateCurrentSuccessRateBucket();
+    // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
+    // will get updated in computeSuccessRateEjections().
+    host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin, -1);
+    host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin, -1);
+  }
+}
 
-  // Reset the Detector's success rate mean and stdev.
-  getSRNums(monitor_type) = {-1, -1};
+DetectorImpl::SweepResult DetectorImpl::computeSuccessRateEjections(
+    const SweepHosts& hosts, DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+    const SweepParams& params) {
+  // This may run on the sweep thread, so it must only touch the hosts, their success rate
+  // monitors and the result.
+  SweepResult result;
 
   // Exit early if there are not enough hosts.
-  if (host_monitors_.size() < success_rate_minimum_hosts &&
-      host_monitors_.size() < failure_percentage_minimum_hosts) {
-    return;
+  if (hosts.size() < params.success_rate_minimum_hosts_ &&
+      hosts.size() < params.failure_percentage_minimum_hosts_) {
+    return result;
   }
 
+  std::vector<HostSuccessRatePair> valid_success_rate_hosts;
+  std::vector<HostSuccessRatePair> valid_failure_percentage_hosts;
+  double success_rate_sum = 0;
+
   // reserve upper bound of vector size to avoid reallocation.
-  valid_success_rate_hosts.reserve(host_monitors_.size());
-  valid_failure_percentage_hosts.reserve(host_monitors_.size());
+  valid_success_rate_hosts.reserve(hosts.size());
+  valid_failure_percentage_hosts.reserve(hosts.size());
 
-  for (const auto& host : host_monitors_) {
+  for (const auto& host : hosts) {
     // Don't do work if the host is already ejected.
     if (!host.first->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK)) {
       absl::optional<std::pair<double, uint64_t>> host_success_rate_and_volume =
@@ -642,79 +735,127 @@ void DetectorImpl::processSuccessRateEjections(
       double success_rate = host_success_rate_and_volume.value().first;
       double request_volume = host_success_rate_and_volume.value().second;
 
-      if (request_volume >=
-          std::min(success_rate_request_volume, failure_percentage_request_volume)) {
+      if (request_volume >= std::min(params.success_rate_request_volume_,
+                                     params.failure_percentage_request_volume_)) {
         host.second->successRate(monitor_type, success_rate);
       }
 
-      if (request_volume >= success_rate_request_volume) {
+      if (request_volume >= params.success_rate_request_volume_) {
         valid_success_rate_hosts.emplace_back(HostSuccessRatePair(host.first, success_rate));
         success_rate_sum += success_rate;
       }
-      if (request_volume >= failure_percentage_request_volume) {
+      if (request_volume >= params.failure_percentage_request_volume_) {
         valid_failure_percentage_hosts.emplace_back(HostSuccessRatePair(host.first, success_rate));
       }
     }
   }
 
   if (!valid_success_rate_hosts.empty() &&
-      valid_success_rate_hosts.size() >= success_rate_minimum_hosts) {
-    const double success_rate_stdev_factor =
-        runtime_.snapshot().getInteger(SuccessRateStdevFactorRuntime,
-                                       config_.successRateStdevFactor()) /
-        1000.0;
-    getSRNums(monitor_type) = successRateEjectionThreshold(
-        success_rate_sum, valid_success_rate_hosts, success_rate_stdev_factor);
-    const double success_rate_ejection_threshold = getSRNums(monitor_type).ejection_threshold_;
+      valid_success_rate_hosts.size() >= params.success_rate_minimum_hosts_) {
+    result.success_rate_nums_ = successRateEjectionThreshold(
+        success_rate_sum, valid_success_rate_hosts, params.success_rate_stdev_factor_);
+    const double success_rate_ejection_threshold = result.success_rate_nums_.ejection_threshold_;
     for (const auto& host_success_rate_pair : valid_success_rate_hosts) {
       if (host_success_rate_pair.success_rate_ < success_rate_ejection_threshold) {
-        stats_.ejections_success_rate_.inc(); // Deprecated.
         const envoy::data::cluster::v3::OutlierEjectionType type =
-            host_monitors_[host_success_rate_pair.host_]
-                ->getSRMonitor(monitor_type)
-                .getEjectionType();
-        updateDetectedEjectionStats(type);
-        ejectHost(host_success_rate_pair.host_, type);
+            (monitor_type == DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin)
+                ? envoy::data::cluster::v3::SUCCESS_RATE
+                : envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN;
+        result.ejections_.emplace_back(host_success_rate_pair.host_, type);
       }
     }
   }
 
   if (!valid_failure_percentage_hosts.empty() &&
-      valid_failure_percentage_hosts.size() >= failure_percentage_minimum_hosts) {
-    const double failure_percentage_threshold = runtime_.snapshot().getInteger(
-        FailurePercentageThresholdRuntime, config_.failurePercentageThreshold());
-
+      valid_failure_percentage_hosts.size() >= params.failure_percentage_minimum_hosts_) {
     for (const auto& host_success_rate_pair : valid_failure_percentage_hosts) {
-      if ((100.0 - host_success_rate_pair.success_rate_) >= failure_percentage_threshold) {
+      if ((100.0 - host_success_rate_pair.success_rate_) >=
+          params.failure_percentage_threshold_) {
         // We should eject.
-
-        // The ejection type returned by the SuccessRateMonitor's getEjectionType() will be a
-        // SUCCESS_RATE type, so we need to figure it out for ourselves.
         const envoy::data::cluster::v3::OutlierEjectionType type =
             (monitor_type == DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin)
                 ? envoy::data::cluster::v3::FAILURE_PERCENTAGE
                 : envoy::data::cluster::v3::FAILURE_PERCENTAGE_LOCAL_ORIGIN;
-        updateDetectedEjectionStats(type);
-        ejectHost(host_success_rate_pair.host_, type);
+        result.ejections_.emplace_back(host_success_rate_pair.host_, type);
       }
     }
   }
+
+  return result;
 }
 
-void DetectorImpl::onIntervalTimer() {
-  MonotonicTime now = time_source_.monotonicTime();
+void DetectorImpl::applySuccessRateEjections(
+    DetectorHostMonitor::SuccessRateMonitorType monitor_type, const SweepResult& result) {
+  getSRNums(monitor_type) = result.success_rate_nums_;
 
-  for (auto host : host_monitors_) {
-    checkHostForUneject(host.first, host.second, now);
+  for (const auto& ejection : result.ejections_) {
+    const HostSharedPtr& host = ejection.first;
+    // When sweeping in the background, the host may have been removed since the sweep started.
+    if (host_monitors_.count(host) == 0) {
+      continue;
+    }
+    if (ejection.second == envoy::data::cluster::v3::SUCCESS_RATE ||
+        ejection.second == envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN) {
+      stats_.ejections_success_rate_.inc(); // Deprecated.
+    }
+    updateDetectedEjectionStats(ejection.second);
+    ejectHost(host, ejection.second);
+  }
+}
 
-    // Need to update the writer bucket to keep the data valid.
-    host.second->updateCurrentSuccessRateBucket();
-    // Refresh host success rate stat for the /clusters endpoint. If there is a new valid value, it
-    // will get updated in processSuccessRateEjections().
-    host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin, -1);
-    host.second->successRate(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin, -1);
+void DetectorImpl::processSuccessRateEjections(
+    DetectorHostMonitor::SuccessRateMonitorType monitor_type) {
+  applySuccessRateEjections(
+      monitor_type, computeSuccessRateEjections(*sweepHosts(), monitor_type, sweepParams()));
+}
+
+void DetectorImpl::postSweep(DetectorHostMonitor::SuccessRateMonitorType monitor_type) {
+  // The sweep thread only touches the hosts and their success rate monitors, which are kept alive
+  // by the snapshot. The result is posted back with a weak pointer, as the detector may be destroyed
+  // in the meantime. See notifyMainThreadConsecutiveError() for the same pattern.
+  std::weak_ptr<DetectorImpl> weak_this = shared_from_this();
+  sweep_thread_->post([weak_this, monitor_type, hosts = sweepHosts(), params = sweepParams(),
+                       &dispatcher = dispatcher_]() -> void {
+    if (monitor_type == DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin) {
+      resetSuccessRates(*hosts);
+    }
+    SweepResultSharedPtr result =
+        std::make_shared<SweepResult>(computeSuccessRateEjections(*hosts, monitor_type, params));
+    dispatcher.post([weak_this, monitor_type, result]() -> void {
+      std::shared_ptr<DetectorImpl> shared_this = weak_this.lock();
+      if (shared_this) {
+        shared_this->onSweepComplete(monitor_type, *result);
+      }
+    });
+  });
+}
+
+void DetectorImpl::onSweepComplete(DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+                                   const SweepResult& result) {
+  applySuccessRateEjections(monitor_type, result);
+
+  // Local origin success rates are only tracked when external and local origin errors are split.
+  // Their sweep runs once the external origin ejections have been applied, so that it skips the
+  // hosts which have just been ejected, as a foreground sweep would.
+  if (monitor_type == DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin &&
+      config_.splitExternalLocalOriginErrors()) {
+    postSweep(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin);
+    return;
+  }
+
+  // The next interval starts once the sweep is complete, so sweeps of a detector never overlap.
+  armIntervalTimer();
+}
+
+void DetectorImpl::onIntervalTimer() {
+  checkHostsForUneject(time_source_.monotonicTime());
+
+  if (sweep_thread_ != nullptr) {
+    postSweep(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin);
+    return;
   }
 
+  resetSuccessRates(*sweepHosts());
   processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin);
   processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin);
 
@@ -3,6 +3,7 @@
 #include <atomic>
 #include <chrono>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <memory>
 #include <string>
@@ -17,12 +18,17 @@
 #include "envoy/event/timer.h"
 #include "envoy/http/codes.h"
 #include "envoy/runtime/runtime.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
 #include "envoy/stats/scope.h"
 #include "envoy/stats/stats.h"
+#include "envoy/thread/thread.h"
 #include "envoy/upstream/outlier_detection.h"
 #include "envoy/upstream/upstream.h"
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/node_hash_map.h"
+#include "absl/synchronization/mutex.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -46,6 +52,41 @@ private:
   const absl::optional<MonotonicTime> time_{};
 };
 
+/**
+ * Dedicated thread running the interval sweeps of all detectors configured with
+ * sweep_in_background. Sweeps are run one at a time, in the order they were posted.
+ */
+class SweepThread : public Singleton::Instance {
+public:
+  explicit SweepThread(Thread::ThreadFactory& thread_factory);
+  ~SweepThread() override;
+
+  /**
+   * Queue a sweep to run on the sweep thread. Sweeps still queued when the thread is destroyed
+   * are dropped.
+   */
+  void post(std::function<void()> sweep);
+
+  /**
+   * @return the sweep thread shared by all clusters, creating it if needed.
+   */
+  static std::shared_ptr<SweepThread> get(Singleton::Manager& manager,
+                                          Thread::ThreadFactory& thread_factory);
+
+private:
+  void threadRoutine();
+  bool sweepPendingOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    return !pending_sweeps_.empty() || stopped_;
+  }
+
+  absl::Mutex mutex_;
+  std::list<std::function<void()>> pending_sweeps_ ABSL_GUARDED_BY(mutex_);
+  bool stopped_ ABSL_GUARDED_BY(mutex_){};
+  Thread::ThreadPtr thread_;
+};
+
+using SweepThreadSharedPtr = std::shared_ptr<SweepThread>;
+
 /**
  * Factory for creating a detector from a proto configuration.
  */
@@ -54,7 +95,7 @@ public:
   static DetectorSharedPtr
   createForCluster(Cluster& cluster, const envoy::config::cluster::v3::Cluster& cluster_config,
                    Event::Dispatcher& dispatcher, Runtime::Loader& runtime,
-                   EventLoggerSharedPtr event_logger);
+                   EventLoggerSharedPtr event_logger, SweepThreadSharedPtr sweep_thread);
 };
 
 /**
@@ -111,7 +152,7 @@ public:
     // Point the success_rate_accumulator_bucket_ pointer to a bucket.
     updateCurrentSuccessRateBucket();
   }
-  double getSuccessRate() const { return success_rate_; }
+  double getSuccessRate() const { return success_rate_.load(); }
   SuccessRateAccumulator& successRateAccumulator() { return success_rate_accumulator_; }
   void setSuccessRate(double new_success_rate) { success_rate_ = new_success_rate; }
   void updateCurrentSuccessRateBucket() {
@@ -128,7 +169,8 @@ private:
   SuccessRateAccumulator success_rate_accumulator_;
   std::atomic<SuccessRateAccumulatorBucket*> success_rate_accumulator_bucket_;
   envoy::data::cluster::v3::OutlierEjectionType ejection_type_;
-  double success_rate_;
+  // Written by the sweep thread when sweeping in the background.
+  std::atomic<double> success_rate_;
 };
 
 class DetectorImpl;
@@ -374,7 +416,7 @@ public:
   static std::shared_ptr<DetectorImpl>
   create(const Cluster& cluster, const envoy::config::cluster::v3::OutlierDetection& config,
          Event::Dispatcher& dispatcher, Runtime::Loader& runtime, TimeSource& time_source,
-         EventLoggerSharedPtr event_logger);
+         EventLoggerSharedPtr event_logger, SweepThreadSharedPtr sweep_thread = nullptr);
   ~DetectorImpl() override;
 
   void onConsecutive5xx(HostSharedPtr host);
@@ -415,11 +457,36 @@ public:
 private:
   DetectorImpl(const Cluster& cluster, const envoy::config::cluster::v3::OutlierDetection& config,
                Event::Dispatcher& dispatcher, Runtime::Loader& runtime, TimeSource& time_source,
-               EventLoggerSharedPtr event_logger);
+               EventLoggerSharedPtr event_logger, SweepThreadSharedPtr sweep_thread);
+
+  // Hosts swept each interval. Shared with the sweep thread, so it is replaced rather than
+  // modified when the cluster membership changes.
+  using SweepHosts = std::vector<std::pair<HostSharedPtr, DetectorHostMonitorImpl*>>;
+  using SweepHostsConstSharedPtr = std::shared_ptr<const SweepHosts>;
+
+  // Runtime values used by a success rate sweep. They are read on the main thread, since the
+  // runtime snapshot is thread local.
+  struct SweepParams {
+    uint64_t success_rate_minimum_hosts_;
+    uint64_t success_rate_request_volume_;
+    uint64_t failure_percentage_minimum_hosts_;
+    uint64_t failure_percentage_request_volume_;
+    double success_rate_stdev_factor_;
+    double failure_percentage_threshold_;
+  };
+
+  // Outcome of a success rate sweep, applied on the main thread.
+  struct SweepResult {
+    EjectionPair success_rate_nums_{-1, -1};
+    std::vector<std::pair<HostSharedPtr, envoy::data::cluster::v3::OutlierEjectionType>>
+        ejections_;
+  };
+  using SweepResultSharedPtr = std::shared_ptr<SweepResult>;
 
   void addHostMonitor(HostSharedPtr host);
   void armIntervalTimer();
   void checkHostForUneject(HostSharedPtr host, DetectorHostMonitorImpl* monitor, MonotonicTime now);
+  void checkHostsForUneject(MonotonicTime now);
   void ejectHost(HostSharedPtr host, envoy::data::cluster::v3::OutlierEjectionType type);
   static DetectionStats generateStats(Stats::Scope& scope);
   void initialize(const Cluster& cluster);
@@ -433,6 +500,18 @@ private:
   void updateEnforcedEjectionStats(envoy::data::cluster::v3::OutlierEjectionType type);
   void updateDetectedEjectionStats(envoy::data::cluster::v3::OutlierEjectionType type);
   void processSuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType monitor_type);
+  const SweepHostsConstSharedPtr& sweepHosts();
+  SweepParams sweepParams();
+  static void resetSuccessRates(const SweepHosts& hosts);
+  static SweepResult
+  computeSuccessRateEjections(const SweepHosts& hosts,
+                              DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+                              const SweepParams& params);
+  void applySuccessRateEjections(DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+                                 const SweepResult& result);
+  void postSweep(DetectorHostMonitor::SuccessRateMonitorType monitor_type);
+  void onSweepComplete(DetectorHostMonitor::SuccessRateMonitorType monitor_type,
+                       const SweepResult& result);
 
   // The helper to double write value and gauge. The gauge could be null value since because any
   // stat might be deactivated.
@@ -460,8 +539,15 @@ private:
   Event::TimerPtr interval_timer_;
   std::list<ChangeStateCb> callbacks_;
   absl::node_hash_map<HostSharedPtr, DetectorHostMonitorImpl*> host_monitors_;
+  // Hosts with a non zero ejection time backoff. Ejected hosts are always part of it, so these are
+  // the only hosts which need to be checked for unejection each interval.
+  absl::flat_hash_map<HostSharedPtr, DetectorHostMonitorImpl*> backed_off_hosts_;
+  // Lazily rebuilt from host_monitors_ after a membership change.
+  SweepHostsConstSharedPtr sweep_hosts_;
   EventLoggerSharedPtr event_logger_;
   Common::CallbackHandlePtr member_update_cb_;
+  // Set if the success rate computations run on the sweep thread.
+  const SweepThreadSharedPtr sweep_thread_;
 
   // EjectionPair for external and local origin events.
   // When external/local origin events are not split, external_origin_sr_num_ are used for
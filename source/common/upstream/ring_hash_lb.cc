@@ -22,7 +22,20 @@ RingHashLoadBalancer::RingHashLoadBalancer(
     const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>& config,
     const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
     : ThreadAwareLoadBalancerBase(priority_set, stats, runtime, random, common_config),
-      scope_(scope.createScope("ring_hash_lb.")), stats_(generateStats(*scope_)),
+      builder_(std::make_shared<RingBuilder>(scope, config, common_config)) {
+  // It's important to do any config validation here, rather than deferring to Ring's ctor,
+  // because any exceptions thrown here will be caught and handled properly.
+  if (builder_->min_ring_size_ > builder_->max_ring_size_) {
+    throw EnvoyException(fmt::format("ring hash: minimum_ring_size ({}) > maximum_ring_size ({})",
+                                     builder_->min_ring_size_, builder_->max_ring_size_));
+  }
+}
+
+RingHashLoadBalancer::RingBuilder::RingBuilder(
+    Stats::Scope& scope,
+    const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>& config,
+    const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
+    : scope_(scope.createScope("ring_hash_lb.")), stats_(generateStats(*scope_)),
       min_ring_size_(config ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.value(), minimum_ring_size,
                                                               DefaultMinRingSize)
                             : DefaultMinRingSize),
@@ -36,14 +49,7 @@ RingHashLoadBalancer::RingHashLoadBalancer(
               ? common_config.consistent_hashing_lb_config().use_hostname_for_hashing()
               : false),
       hash_balance_factor_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(
-          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)) {
-  // It's important to do any config validation here, rather than deferring to Ring's ctor,
-  // because any exceptions thrown here will be caught and handled properly.
-  if (min_ring_size_ > max_ring_size_) {
-    throw EnvoyException(fmt::format("ring hash: minimum_ring_size ({}) > maximum_ring_size ({})",
-                                     min_ring_size_, max_ring_size_));
-  }
-}
+          common_config.consistent_hashing_lb_config(), hash_balance_factor, 0)) {}
 
 RingHashLoadBalancerStats RingHashLoadBalancer::generateStats(Stats::Scope& scope) {
   return {ALL_RING_HASH_LOAD_BALANCER_STATS(POOL_GAUGE(scope))};
@@ -46,7 +46,7 @@ public:
       const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>& config,
       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config);
 
-  const RingHashLoadBalancerStats& stats() const { return stats_; }
+  const RingHashLoadBalancerStats& stats() const { return builder_->stats_; }
 
 private:
   using HashFunction = envoy::config::cluster::v3::Cluster::RingHashLbConfig::HashFunction;
@@ -70,33 +70,45 @@ private:
   };
   using RingConstSharedPtr = std::shared_ptr<const Ring>;
 
-  // ThreadAwareLoadBalancerBase
-  HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
-                     double min_normalized_weight, double /* max_normalized_weight */) override {
-    HashingLoadBalancerSharedPtr ring_hash_lb =
-        std::make_shared<Ring>(normalized_host_weights, min_normalized_weight, min_ring_size_,
-                               max_ring_size_, hash_function_, use_hostname_for_hashing_, stats_);
-    if (hash_balance_factor_ == 0) {
-      return ring_hash_lb;
+  struct RingBuilder : public HashingLoadBalancerBuilder {
+    RingBuilder(
+        Stats::Scope& scope,
+        const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>& config,
+        const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config);
+
+    // ThreadAwareLoadBalancerBase::HashingLoadBalancerBuilder
+    HashingLoadBalancerSharedPtr
+    createLoadBalancer(uint32_t /* priority */,
+                       const NormalizedHostWeightVector& normalized_host_weights,
+                       double min_normalized_weight, double /* max_normalized_weight */) override {
+      HashingLoadBalancerSharedPtr ring_hash_lb =
+          std::make_shared<Ring>(normalized_host_weights, min_normalized_weight, min_ring_size_,
+                                 max_ring_size_, hash_function_, use_hostname_for_hashing_, stats_);
+      if (hash_balance_factor_ == 0) {
+        return ring_hash_lb;
+      }
+
+      return std::make_shared<BoundedLoadHashingLoadBalancer>(
+          ring_hash_lb, normalized_host_weights, hash_balance_factor_);
     }
 
-    return std::make_shared<BoundedLoadHashingLoadBalancer>(
-        ring_hash_lb, std::move(normalized_host_weights), hash_balance_factor_);
-  }
+    Stats::ScopePtr scope_;
+    RingHashLoadBalancerStats stats_;
+    const uint64_t min_ring_size_;
+    const uint64_t max_ring_size_;
+    const HashFunction hash_function_;
+    const bool use_hostname_for_hashing_;
+    const uint32_t hash_balance_factor_;
+  };
 
-  static RingHashLoadBalancerStats generateStats(Stats::Scope& scope);
+  // ThreadAwareLoadBalancerBase
+  HashingLoadBalancerBuilderSharedPtr builder() override { return builder_; }
 
-  Stats::ScopePtr scope_;
-  RingHashLoadBalancerStats stats_;
+  static RingHashLoadBalancerStats generateStats(Stats::Scope& scope);
 
   static const uint64_t DefaultMinRingSize = 1024;
   static const uint64_t DefaultMaxRingSize = 1024 * 1024 * 8;
-  const uint64_t min_ring_size_;
-  const uint64_t max_ring_size_;
-  const HashFunction hash_function_;
-  const bool use_hostname_for_hashing_;
-  const uint32_t hash_balance_factor_;
+  const std::shared_ptr<RingBuilder> builder_;
 };
 
 } // namespace Upstream
@@ -1,5 +1,6 @@
 #include "source/common/upstream/subset_lb.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
@@ -10,6 +11,7 @@
 #include "source/common/config/metadata.h"
 #include "source/common/config/well_known_names.h"
 #include "source/common/protobuf/utility.h"
+#include "source/common/runtime/runtime_features.h"
 #include "source/common/upstream/load_balancer_impl.h"
 #include "source/common/upstream/maglev_lb.h"
 #include "source/common/upstream/ring_hash_lb.h"
@@ -70,6 +72,11 @@ SubsetLoadBalancer::SubsetLoadBalancer(
 
   initSubsetSelectorMap();
 
+  if (single_key_.empty() &&
+      Runtime::runtimeFeatureEnabled("envoy.reloadable_features.subset_lb_compiled_index")) {
+    index_ = std::make_unique<SubsetIndex>(subset_selectors_, list_as_any_);
+  }
+
   // Create filtered default subset (if necessary) and other subsets based on current hosts.
   refreshSubsets();
 
@@ -507,9 +514,17 @@ void SubsetLoadBalancer::processSubsets(
             if (entry->initialized()) {
               update_cb(entry);
             } else {
-              HostPredicate predicate = [this, kvs](const Host& host) -> bool {
-                return hostMatches(kvs, host);
-              };
+              HostPredicate predicate;
+              if (index_ != nullptr) {
+                auto indexed_predicate = std::make_shared<IndexedHostPredicate>(*index_, kvs);
+                predicate = [indexed_predicate](const Host& host) -> bool {
+                  return indexed_predicate->matches(host);
+                };
+              } else {
+                predicate = [this, kvs](const Host& host) -> bool {
+                  return hostMatches(kvs, host);
+                };
+              }
               if (adding_hosts) {
                 new_cb(entry, predicate, kvs);
               }
@@ -538,8 +553,16 @@ void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added
                                 const HostVector& hosts_removed) {
   updateFallbackSubset(priority, hosts_added, hosts_removed);
 
+  // With the index, only the hosts that are new or whose metadata changed can belong to subsets
+  // that don't exist yet, so the metadata of the other hosts isn't extracted again.
+  HostVector indexed_hosts;
+  if (index_ != nullptr) {
+    indexed_hosts = index_->update(
+        priority, original_priority_set_.hostSetsPerPriority()[priority]->hosts(), hosts_removed);
+  }
+
   processSubsets(
-      hosts_added, hosts_removed,
+      index_ != nullptr ? indexed_hosts : hosts_added, hosts_removed,
       [&](LbSubsetEntryPtr entry) {
         entry->priority_subset_->update(priority, hosts_added, hosts_removed);
       },
@@ -554,6 +577,10 @@ void SubsetLoadBalancer::update(uint32_t priority, const HostVector& hosts_added
         stats_.lb_subsets_active_.inc();
         stats_.lb_subsets_created_.inc();
       });
+
+  if (index_ != nullptr) {
+    index_->releaseRemovedHosts();
+  }
 }
 
 bool SubsetLoadBalancer::hostMatches(const SubsetMetadata& kvs, const Host& host) {
@@ -797,6 +824,7 @@ SubsetLoadBalancer::PrioritySubsetImpl::PrioritySubsetImpl(const SubsetLoadBalan
   case LoadBalancerType::OriginalDst:
   case LoadBalancerType::ClusterProvided:
   case LoadBalancerType::LoadBalancingPolicyConfig:
+  case LoadBalancerType::PeakEwma:
     // These load balancer types can only be created when there is no subset configuration.
     NOT_REACHED_GCOVR_EXCL_LINE;
   }
@@ -968,6 +996,224 @@ void SubsetLoadBalancer::PrioritySubsetImpl::update(uint32_t priority,
   }
 }
 
+SubsetLoadBalancer::SubsetIndex::SubsetIndex(
+    const std::vector<SubsetSelectorPtr>& subset_selectors, bool list_as_any)
+    : list_as_any_(list_as_any) {
+  for (const auto& subset_selector : subset_selectors) {
+    for (const auto& key : subset_selector->selectorKeys()) {
+      if (key_ids_.try_emplace(key, keys_.size()).second) {
+        keys_.push_back(key);
+      }
+    }
+  }
+  value_ids_per_key_.resize(keys_.size());
+}
+
+HostVector SubsetLoadBalancer::SubsetIndex::update(uint32_t priority, const HostVector& hosts,
+                                                   const HostVector& hosts_removed) {
+  HostVector indexed_hosts;
+  for (const auto& host : hosts) {
+    auto [it, inserted] = slots_by_host_.try_emplace(host.get(), 0);
+    if (inserted) {
+      if (free_slots_.empty()) {
+        it->second = slots_.size();
+        slots_.emplace_back();
+      } else {
+        it->second = free_slots_.back();
+        free_slots_.pop_back();
+      }
+      slots_[it->second].host_ = host;
+    }
+    HostSlot& slot = slots_[it->second];
+    if (std::find(slot.priorities_.begin(), slot.priorities_.end(), priority) ==
+        slot.priorities_.end()) {
+      slot.priorities_.push_back(priority);
+    }
+
+    // Metadata is replaced rather than modified in place, so a different pointer means that it
+    // may have changed.
+    MetadataConstSharedPtr metadata = host->metadata();
+    if (inserted || metadata != slot.metadata_) {
+      if (!inserted) {
+        unindexHost(it->second);
+      }
+      slot.metadata_ = std::move(metadata);
+      indexHost(it->second);
+      indexed_hosts.push_back(host);
+    }
+  }
+
+  for (const auto& host : hosts_removed) {
+    const auto it = slots_by_host_.find(host.get());
+    if (it == slots_by_host_.end()) {
+      continue;
+    }
+    HostSlot& slot = slots_[it->second];
+    const auto priority_it = std::find(slot.priorities_.begin(), slot.priorities_.end(), priority);
+    if (priority_it != slot.priorities_.end()) {
+      slot.priorities_.erase(priority_it);
+      if (slot.priorities_.empty()) {
+        removed_slots_.push_back(it->second);
+      }
+    }
+  }
+
+  generation_++;
+  return indexed_hosts;
+}
+
+void SubsetLoadBalancer::SubsetIndex::releaseRemovedHosts() {
+  if (removed_slots_.empty()) {
+    return;
+  }
+  for (const uint32_t index : removed_slots_) {
+    HostSlot& slot = slots_[index];
+    // The host may have been added back to a priority since it was removed.
+    if (slot.host_ == nullptr || !slot.priorities_.empty()) {
+      continue;
+    }
+    unindexHost(index);
+    slots_by_host_.erase(slot.host_.get());
+    slot = HostSlot();
+    free_slots_.push_back(index);
+  }
+  removed_slots_.clear();
+  generation_++;
+}
+
+void SubsetLoadBalancer::SubsetIndex::indexHost(uint32_t index) {
+  HostSlot& slot = slots_[index];
+  ASSERT(slot.value_ids_.empty());
+  if (slot.metadata_ == nullptr) {
+    return;
+  }
+  const auto& filter_metadata = slot.metadata_->filter_metadata();
+  const auto filter_it = filter_metadata.find(Config::MetadataFilters::get().ENVOY_LB);
+  if (filter_it == filter_metadata.end()) {
+    return;
+  }
+
+  const auto& fields = filter_it->second.fields();
+  for (uint32_t key_id = 0; key_id < keys_.size(); key_id++) {
+    const auto it = fields.find(keys_[key_id]);
+    if (it == fields.end()) {
+      continue;
+    }
+    // This mirrors Config::Metadata::metadataLabelMatch(): with list_as_any, a host with a list
+    // value matches each of the values in the list.
+    if (list_as_any_ && it->second.kind_case() == ProtobufWkt::Value::kListValue) {
+      for (const auto& value : it->second.list_value().values()) {
+        slot.value_ids_.push_back(acquireValue(key_id, value));
+      }
+    } else {
+      slot.value_ids_.push_back(acquireValue(key_id, it->second));
+    }
+  }
+
+  const uint32_t word = index / 64;
+  for (const uint32_t value_id : slot.value_ids_) {
+    std::vector<uint64_t>& hosts = values_[value_id]->hosts_;
+    if (hosts.size() <= word) {
+      hosts.resize(word + 1);
+    }
+    hosts[word] |= 1ULL << (index % 64);
+  }
+}
+
+void SubsetLoadBalancer::SubsetIndex::unindexHost(uint32_t index) {
+  HostSlot& slot = slots_[index];
+  for (const uint32_t value_id : slot.value_ids_) {
+    values_[value_id]->hosts_[index / 64] &= ~(1ULL << (index % 64));
+    releaseValue(value_id);
+  }
+  slot.value_ids_.clear();
+}
+
+uint32_t SubsetLoadBalancer::SubsetIndex::acquireValue(uint32_t key_id,
+                                                       const ProtobufWkt::Value& value) {
+  const HashedValue hashed_value(value);
+  auto [it, inserted] = value_ids_per_key_[key_id].try_emplace(hashed_value, 0);
+  if (inserted) {
+    if (free_value_ids_.empty()) {
+      it->second = values_.size();
+      values_.emplace_back();
+    } else {
+      it->second = free_value_ids_.back();
+      free_value_ids_.pop_back();
+    }
+    values_[it->second] = std::make_unique<Value>(key_id, hashed_value);
+  }
+  values_[it->second]->references_++;
+  return it->second;
+}
+
+void SubsetLoadBalancer::SubsetIndex::releaseValue(uint32_t value_id) {
+  Value& value = *values_[value_id];
+  ASSERT(value.references_ > 0);
+  if (--value.references_ > 0) {
+    return;
+  }
+  value_ids_per_key_[value.key_id_].erase(value.value_);
+  values_[value_id].reset();
+  free_value_ids_.push_back(value_id);
+}
+
+SubsetLoadBalancer::SubsetIndex::ValueIds
+SubsetLoadBalancer::SubsetIndex::acquire(const SubsetMetadata& kvs) {
+  ValueIds value_ids;
+  value_ids.reserve(kvs.size());
+  for (const auto& [key, value] : kvs) {
+    // Subsets are only created for the keys of subset selectors.
+    const auto it = key_ids_.find(key);
+    ASSERT(it != key_ids_.end());
+    value_ids.push_back(acquireValue(it->second, value));
+  }
+  return value_ids;
+}
+
+void SubsetLoadBalancer::SubsetIndex::release(const ValueIds& value_ids) {
+  for (const uint32_t value_id : value_ids) {
+    releaseValue(value_id);
+  }
+}
+
+void SubsetLoadBalancer::SubsetIndex::intersect(const ValueIds& value_ids,
+                                                std::vector<uint64_t>& hosts) const {
+  hosts.clear();
+  if (value_ids.empty()) {
+    return;
+  }
+  hosts = values_[value_ids[0]]->hosts_;
+  for (uint32_t i = 1; i < value_ids.size(); i++) {
+    const std::vector<uint64_t>& value_hosts = values_[value_ids[i]]->hosts_;
+    hosts.resize(std::min(hosts.size(), value_hosts.size()));
+    for (uint32_t word = 0; word < hosts.size(); word++) {
+      hosts[word] &= value_hosts[word];
+    }
+  }
+}
+
+absl::optional<uint32_t> SubsetLoadBalancer::SubsetIndex::slot(const Host& host) const {
+  const auto it = slots_by_host_.find(&host);
+  if (it == slots_by_host_.end()) {
+    return absl::nullopt;
+  }
+  return it->second;
+}
+
+bool SubsetLoadBalancer::IndexedHostPredicate::matches(const Host& host) {
+  if (generation_ != index_.generation()) {
+    index_.intersect(value_ids_, hosts_);
+    generation_ = index_.generation();
+  }
+  const absl::optional<uint32_t> slot = index_.slot(host);
+  if (!slot.has_value()) {
+    return false;
+  }
+  const uint32_t word = slot.value() / 64;
+  return word < hosts_.size() && (hosts_[word] & (1ULL << (slot.value() % 64))) != 0;
+}
+
 SubsetLoadBalancer::LoadBalancerContextWrapper::LoadBalancerContextWrapper(
     LoadBalancerContext* wrapped,
     const std::set<std::string>& filtered_metadata_match_criteria_names)
@@ -15,6 +15,8 @@
 #include "source/common/protobuf/utility.h"
 #include "source/common/upstream/upstream_impl.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/container/node_hash_map.h"
 #include "absl/types/optional.h"
 
@@ -141,6 +143,103 @@ private:
   using LbSubsetMap = absl::node_hash_map<std::string, ValueSubsetMap>;
   using SubsetSelectorFallbackParamsRef = std::reference_wrapper<SubsetSelectorFallbackParams>;
 
+  // Compiled index of the host metadata values of all subset selector keys. Values are interned,
+  // and each interned key/value has a bitset of the hosts having it, so that subset membership is
+  // evaluated by bitset intersection rather than by comparing metadata. Hosts are only re-indexed
+  // when they are added or their metadata changes.
+  class SubsetIndex {
+  public:
+    using ValueIds = std::vector<uint32_t>;
+
+    SubsetIndex(const std::vector<SubsetSelectorPtr>& subset_selectors, bool list_as_any);
+
+    /**
+     * Updates the index with the current hosts of a priority. Removed hosts stay indexed until
+     * releaseRemovedHosts(), so that they can still be matched while subsets are updated.
+     * @return the hosts that are new to the index or whose metadata changed.
+     */
+    HostVector update(uint32_t priority, const HostVector& hosts, const HostVector& hosts_removed);
+
+    /**
+     * Drops the hosts removed by update() calls that are no longer part of any priority.
+     */
+    void releaseRemovedHosts();
+
+    /**
+     * Interns the values of a subset. The values stay interned until release() is called.
+     */
+    ValueIds acquire(const SubsetMetadata& kvs);
+    void release(const ValueIds& value_ids);
+
+    /**
+     * Computes the bitset of the hosts having all the values.
+     */
+    void intersect(const ValueIds& value_ids, std::vector<uint64_t>& hosts) const;
+
+    /**
+     * @return the bit of the host in bitsets, if the host is indexed.
+     */
+    absl::optional<uint32_t> slot(const Host& host) const;
+
+    /**
+     * @return a number incremented every time the bitsets change.
+     */
+    uint64_t generation() const { return generation_; }
+
+  private:
+    struct HostSlot {
+      HostConstSharedPtr host_;
+      MetadataConstSharedPtr metadata_;
+      ValueIds value_ids_;
+      absl::InlinedVector<uint32_t, 1> priorities_;
+    };
+    struct Value {
+      Value(uint32_t key_id, const HashedValue& value) : key_id_(key_id), value_(value) {}
+
+      const uint32_t key_id_;
+      const HashedValue value_;
+      // The number of hosts and subsets referencing the value.
+      uint32_t references_{};
+      std::vector<uint64_t> hosts_;
+    };
+
+    void indexHost(uint32_t slot);
+    void unindexHost(uint32_t slot);
+    uint32_t acquireValue(uint32_t key_id, const ProtobufWkt::Value& value);
+    void releaseValue(uint32_t value_id);
+
+    const bool list_as_any_;
+    // The union of the keys of all subset selectors.
+    std::vector<std::string> keys_;
+    absl::flat_hash_map<std::string, uint32_t> key_ids_;
+    std::vector<absl::flat_hash_map<HashedValue, uint32_t>> value_ids_per_key_;
+    std::vector<std::unique_ptr<Value>> values_;
+    std::vector<uint32_t> free_value_ids_;
+    absl::flat_hash_map<const Host*, uint32_t> slots_by_host_;
+    std::vector<HostSlot> slots_;
+    std::vector<uint32_t> free_slots_;
+    std::vector<uint32_t> removed_slots_;
+    uint64_t generation_{};
+  };
+  using SubsetIndexPtr = std::unique_ptr<SubsetIndex>;
+
+  // Matches the hosts of a subset using the index. The intersection of the bitsets of the subset
+  // values is cached until the index changes.
+  class IndexedHostPredicate {
+  public:
+    IndexedHostPredicate(SubsetIndex& index, const SubsetMetadata& kvs)
+        : index_(index), value_ids_(index.acquire(kvs)) {}
+    ~IndexedHostPredicate() { index_.release(value_ids_); }
+
+    bool matches(const Host& host);
+
+  private:
+    SubsetIndex& index_;
+    const SubsetIndex::ValueIds value_ids_;
+    absl::optional<uint64_t> generation_;
+    std::vector<uint64_t> hosts_;
+  };
+
   class LoadBalancerContextWrapper : public LoadBalancerContext {
   public:
     LoadBalancerContextWrapper(LoadBalancerContext* wrapped,
@@ -271,6 +370,10 @@ private:
   const PrioritySet* original_local_priority_set_;
   Common::CallbackHandlePtr original_priority_set_callback_handle_;
 
+  // Only set if the compiled subset index is enabled. Must outlive the subsets, whose predicates
+  // reference it.
+  SubsetIndexPtr index_;
+
   LbSubsetEntryPtr subset_any_;
   LbSubsetEntryPtr fallback_subset_;
   LbSubsetEntryPtr panic_mode_subset_;
@@ -3,6 +3,8 @@
 #include <memory>
 #include <random>
 
+#include "source/common/common/macros.h"
+
 namespace Envoy {
 namespace Upstream {
 
@@ -87,56 +89,184 @@ void normalizeWeights(const HostSet& host_set, bool in_panic,
 
 } // namespace
 
+ThreadAwareLoadBalancerBase::BuildWorker::BuildWorker(Thread::ThreadFactory& thread_factory)
+    : thread_(thread_factory.createThread([this]() -> void { run(); },
+                                          Thread::Options{"LbTableBuild"})) {}
+
+ThreadAwareLoadBalancerBase::BuildWorker::~BuildWorker() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stop_ = true;
+  }
+  thread_->join();
+}
+
+ThreadAwareLoadBalancerBase::BuildWorkerSharedPtr
+ThreadAwareLoadBalancerBase::BuildWorker::get(Thread::ThreadFactory& thread_factory) {
+  struct SharedBuildWorker {
+    absl::Mutex mutex_;
+    std::weak_ptr<BuildWorker> worker_ ABSL_GUARDED_BY(mutex_);
+  };
+  SharedBuildWorker& shared = MUTABLE_CONSTRUCT_ON_FIRST_USE(SharedBuildWorker);
+
+  absl::MutexLock lock(&shared.mutex_);
+  BuildWorkerSharedPtr worker = shared.worker_.lock();
+  if (worker == nullptr) {
+    worker = std::make_shared<BuildWorker>(thread_factory);
+    shared.worker_ = worker;
+  }
+  return worker;
+}
+
+void ThreadAwareLoadBalancerBase::BuildWorker::post(const BackgroundBuildSharedPtr& build,
+                                                    BuildInputPtr input) {
+  absl::MutexLock lock(&mutex_);
+  build->pending_ = std::move(input);
+  if (!build->queued_) {
+    build->queued_ = true;
+    queue_.push_back(build);
+  }
+}
+
+void ThreadAwareLoadBalancerBase::BuildWorker::cancel(BackgroundBuild& build) {
+  absl::MutexLock lock(&mutex_);
+  build.pending_.reset();
+}
+
+bool ThreadAwareLoadBalancerBase::BuildWorker::waitForIdle(BackgroundBuild& build,
+                                                           std::chrono::milliseconds timeout) {
+  absl::MutexLock lock(&mutex_);
+  return mutex_.AwaitWithTimeout(absl::Condition(&build, &BackgroundBuild::idle),
+                                 absl::FromChrono(timeout));
+}
+
+void ThreadAwareLoadBalancerBase::BuildWorker::run() {
+  while (true) {
+    BackgroundBuildSharedPtr build;
+    BuildInputPtr input;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(this, &BuildWorker::hasWorkOrStopped));
+      if (stop_) {
+        return;
+      }
+      build = std::move(queue_.front());
+      queue_.pop_front();
+      build->queued_ = false;
+      if (build->pending_ == nullptr) {
+        // Cancelled.
+        continue;
+      }
+      input = std::move(build->pending_);
+      build->running_ = true;
+    }
+    ThreadAwareLoadBalancerBase::build(*build->builder_, *build->factory_, *input);
+    absl::MutexLock lock(&mutex_);
+    build->running_ = false;
+  }
+}
+
+ThreadAwareLoadBalancerBase::~ThreadAwareLoadBalancerBase() {
+  // A build in progress only uses state it shares ownership of, so it doesn't need to be waited
+  // for. The build worker is joined here if this was the last load balancer using it.
+  if (background_build_ != nullptr) {
+    build_worker_->cancel(*background_build_);
+  }
+}
+
 void ThreadAwareLoadBalancerBase::initialize() {
-  // TODO(mattklein123): In the future, once initialized and the initial LB is built, it would be
-  // better to use a background thread for computing LB updates. This has the substantial benefit
-  // that if the LB computation thread falls behind, host set updates can be trivially collapsed.
-  // I will look into doing this in a follow up. Doing everything using a background thread heavily
-  // complicated initialization as the load balancer would need its own initialized callback. I
-  // think the synchronous/asynchronous split is probably the best option.
+  // The initial build is always done synchronously, so that the load balancer is usable as soon
+  // as it is initialized. Only subsequent builds are moved to the build worker if
+  // buildInBackground() was called. If the build worker falls behind, host set updates are
+  // collapsed into a single build.
   priority_update_cb_ = priority_set_.addPriorityUpdateCb(
       [this](uint32_t, const HostVector&, const HostVector&) -> void { refresh(); });
 
-  refresh();
+  builder_ = builder();
+  build(*builder_, *factory_, *captureBuildInput());
+  if (build_worker_ != nullptr) {
+    background_build_ = std::make_shared<BackgroundBuild>(builder_, factory_);
+  }
+}
+
+void ThreadAwareLoadBalancerBase::buildInBackground(Thread::ThreadFactory& thread_factory) {
+  ASSERT(priority_update_cb_ == nullptr);
+  build_worker_ = BuildWorker::get(thread_factory);
+}
+
+bool ThreadAwareLoadBalancerBase::waitForBackgroundBuilds(std::chrono::milliseconds timeout) {
+  if (background_build_ == nullptr) {
+    return true;
+  }
+  return build_worker_->waitForIdle(*background_build_, timeout);
 }
 
 void ThreadAwareLoadBalancerBase::refresh() {
-  auto per_priority_state_vector = std::make_shared<std::vector<PerPriorityStatePtr>>(
-      priority_set_.hostSetsPerPriority().size());
-  auto healthy_per_priority_load =
+  // Weights are normalized here, since this reads the host sets and may throw on invalid weights.
+  BuildInputPtr input = captureBuildInput();
+  if (background_build_ == nullptr) {
+    build(*builder_, *factory_, *input);
+    return;
+  }
+  build_worker_->post(background_build_, std::move(input));
+}
+
+ThreadAwareLoadBalancerBase::BuildInputPtr ThreadAwareLoadBalancerBase::captureBuildInput() {
+  auto input = std::make_unique<BuildInput>();
+  input->per_priority_.resize(priority_set_.hostSetsPerPriority().size());
+  input->healthy_per_priority_load_ =
       std::make_shared<HealthyLoad>(per_priority_load_.healthy_priority_load_);
-  auto degraded_per_priority_load =
+  input->degraded_per_priority_load_ =
       std::make_shared<DegradedLoad>(per_priority_load_.degraded_priority_load_);
+  input->cross_priority_host_map_ = priority_set_.crossPriorityHostMap();
 
   for (const auto& host_set : priority_set_.hostSetsPerPriority()) {
     const uint32_t priority = host_set->priority();
-    (*per_priority_state_vector)[priority] = std::make_unique<PerPriorityState>();
-    const auto& per_priority_state = (*per_priority_state_vector)[priority];
+    PerPriorityBuildInput& per_priority = input->per_priority_[priority];
     // Copy panic flag from LoadBalancerBase. It is calculated when there is a change
     // in hosts set or hosts' health.
-    per_priority_state->global_panic_ = per_priority_panic_[priority];
+    per_priority.global_panic_ = per_priority_panic_[priority];
 
     // Normalize host and locality weights such that the sum of all normalized weights is 1.
-    NormalizedHostWeightVector normalized_host_weights;
-    double min_normalized_weight = 1.0;
-    double max_normalized_weight = 0.0;
-    normalizeWeights(*host_set, per_priority_state->global_panic_, normalized_host_weights,
-                     min_normalized_weight, max_normalized_weight);
-    per_priority_state->current_lb_ = createLoadBalancer(
-        std::move(normalized_host_weights), min_normalized_weight, max_normalized_weight);
+    normalizeWeights(*host_set, per_priority.global_panic_, per_priority.normalized_host_weights_,
+                     per_priority.min_normalized_weight_, per_priority.max_normalized_weight_);
+  }
+  return input;
+}
+
+void ThreadAwareLoadBalancerBase::build(HashingLoadBalancerBuilder& builder,
+                                        LoadBalancerFactoryImpl& factory,
+                                        const BuildInput& input) {
+  auto per_priority_state_vector =
+      std::make_shared<std::vector<PerPriorityStatePtr>>(input.per_priority_.size());
+
+  for (uint32_t priority = 0; priority < input.per_priority_.size(); ++priority) {
+    const PerPriorityBuildInput& per_priority = input.per_priority_[priority];
+    (*per_priority_state_vector)[priority] = std::make_unique<PerPriorityState>();
+    const auto& per_priority_state = (*per_priority_state_vector)[priority];
+    per_priority_state->global_panic_ = per_priority.global_panic_;
+    per_priority_state->current_lb_ = builder.createLoadBalancer(
+        priority, per_priority.normalized_host_weights_, per_priority.min_normalized_weight_,
+        per_priority.max_normalized_weight_);
   }
 
   {
-    absl::WriterMutexLock lock(&factory_->mutex_);
-    factory_->healthy_per_priority_load_ = healthy_per_priority_load;
-    factory_->degraded_per_priority_load_ = degraded_per_priority_load;
-    factory_->per_priority_state_ = per_priority_state_vector;
-    factory_->cross_priority_host_map_ = priority_set_.crossPriorityHostMap();
+    absl::WriterMutexLock lock(&factory.mutex_);
+    factory.healthy_per_priority_load_ = input.healthy_per_priority_load_;
+    factory.degraded_per_priority_load_ = input.degraded_per_priority_load_;
+    factory.per_priority_state_ = per_priority_state_vector;
+    factory.cross_priority_host_map_ = input.cross_priority_host_map_;
+    factory.generation_.fetch_add(1, std::memory_order_release);
   }
 }
 
 HostConstSharedPtr
 ThreadAwareLoadBalancerBase::LoadBalancerImpl::chooseHost(LoadBalancerContext* context) {
+  // Pick up load balancers built in the background since this load balancer was created.
+  if (factory_->generation_.load(std::memory_order_acquire) != generation_) {
+    refresh();
+  }
+
   // Make sure we correctly return nullptr for any early chooseHost() calls.
   if (per_priority_state_ == nullptr) {
     return nullptr;
@@ -178,17 +308,20 @@ ThreadAwareLoadBalancerBase::LoadBalancerImpl::chooseHost(LoadBalancerContext* c
   return host;
 }
 
-LoadBalancerPtr ThreadAwareLoadBalancerBase::LoadBalancerFactoryImpl::create() {
-  auto lb = std::make_unique<LoadBalancerImpl>(stats_, random_);
-
+void ThreadAwareLoadBalancerBase::LoadBalancerImpl::refresh() {
   // We must protect current_lb_ via a RW lock since it is accessed and written to by multiple
   // threads. All complex processing has already been precalculated however.
-  absl::ReaderMutexLock lock(&mutex_);
-  lb->healthy_per_priority_load_ = healthy_per_priority_load_;
-  lb->degraded_per_priority_load_ = degraded_per_priority_load_;
-  lb->per_priority_state_ = per_priority_state_;
-  lb->cross_priority_host_map_ = cross_priority_host_map_;
+  absl::ReaderMutexLock lock(&factory_->mutex_);
+  generation_ = factory_->generation_.load(std::memory_order_relaxed);
+  healthy_per_priority_load_ = factory_->healthy_per_priority_load_;
+  degraded_per_priority_load_ = factory_->degraded_per_priority_load_;
+  per_priority_state_ = factory_->per_priority_state_;
+  cross_priority_host_map_ = factory_->cross_priority_host_map_;
+}
 
+LoadBalancerPtr ThreadAwareLoadBalancerBase::LoadBalancerFactoryImpl::create() {
+  auto lb = std::make_unique<LoadBalancerImpl>(stats_, random_, shared_from_this());
+  lb->refresh();
   return lb;
 }
 
@@ -198,20 +331,20 @@ double ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::hostOverload
   // and alert the user if that's the case.
 
   const uint32_t overall_active = host.cluster().stats().upstream_rq_active_.value();
-  const uint32_t host_active = host.stats().rq_active_.value();
+  const uint32_t host_active = host.activeRequests().estimate();
 
   const uint32_t total_slots = ((overall_active + 1) * hash_balance_factor_ + 99) / 100;
   const uint32_t slots =
       std::max(static_cast<uint32_t>(std::ceil(total_slots * weight)), static_cast<uint32_t>(1));
 
-  if (host.stats().rq_active_.value() > slots) {
+  if (host_active > slots) {
     ENVOY_LOG_MISC(
         debug,
         "ThreadAwareLoadBalancerBase::BoundedLoadHashingLoadBalancer::chooseHost: "
         "host {} overloaded; overall_active {}, host_weight {}, host_active {} > slots {}",
         host.address()->asString(), overall_active, weight, host_active, slots);
   }
-  return static_cast<double>(host.stats().rq_active_.value()) / slots;
+  return static_cast<double>(host_active) / slots;
 }
 
 HostConstSharedPtr
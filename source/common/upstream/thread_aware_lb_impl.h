@@ -1,7 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+
 #include "envoy/common/callback.h"
 #include "envoy/config/cluster/v3/cluster.pb.h"
+#include "envoy/thread/thread.h"
 
 #include "source/common/common/logger.h"
 #include "source/common/config/metadata.h"
@@ -83,10 +88,50 @@ public:
     const NormalizedHostWeightVector normalized_host_weights_;
     const uint32_t hash_balance_factor_;
   };
+
+  /**
+   * Creates the hashing load balancers of a thread aware load balancer. Background builds share
+   * ownership of it, so that a build in progress can complete after the load balancer has been
+   * destroyed.
+   */
+  class HashingLoadBalancerBuilder {
+  public:
+    virtual ~HashingLoadBalancerBuilder() = default;
+
+    /**
+     * Creates the hashing load balancer of a priority. Called on the thread delivering host set
+     * updates, or on the background build thread if buildInBackground() was called, but never
+     * concurrently.
+     */
+    virtual HashingLoadBalancerSharedPtr
+    createLoadBalancer(uint32_t priority, const NormalizedHostWeightVector& normalized_host_weights,
+                       double min_normalized_weight, double max_normalized_weight) PURE;
+  };
+  using HashingLoadBalancerBuilderSharedPtr = std::shared_ptr<HashingLoadBalancerBuilder>;
+
   // Upstream::ThreadAwareLoadBalancer
   LoadBalancerFactorySharedPtr factory() override { return factory_; }
   void initialize() override;
 
+  /**
+   * Build the hashing load balancers for host set updates that arrive after initialize() on a
+   * build thread shared by all load balancers building in the background, instead of the thread
+   * delivering the update. The new load balancers are swapped in when complete and picked up by
+   * the worker load balancers on their next host selection. Updates arriving before the build
+   * thread gets to a load balancer are collapsed into a single build. The build thread is joined
+   * once the last load balancer using it is destroyed. Must be called before initialize().
+   * @param thread_factory supplies the factory used to create the build thread, if it doesn't
+   *        exist yet.
+   */
+  void buildInBackground(Thread::ThreadFactory& thread_factory);
+
+  /**
+   * Waits for the background builds of the host set updates delivered so far to be swapped in.
+   * @param timeout supplies the maximum time to wait.
+   * @return bool whether the builds were swapped in before the timeout.
+   */
+  bool waitForBackgroundBuilds(std::chrono::milliseconds timeout);
+
   // Upstream::LoadBalancer
   HostConstSharedPtr chooseHost(LoadBalancerContext*) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
   // Preconnect not implemented for hash based load balancing
@@ -109,7 +154,8 @@ protected:
       Random::RandomGenerator& random,
       const envoy::config::cluster::v3::Cluster::CommonLbConfig& common_config)
       : LoadBalancerBase(priority_set, stats, runtime, random, common_config),
-        factory_(new LoadBalancerFactoryImpl(stats, random)) {}
+        factory_(std::make_shared<LoadBalancerFactoryImpl>(stats, random)) {}
+  ~ThreadAwareLoadBalancerBase() override;
 
 private:
   struct PerPriorityState {
@@ -118,9 +164,27 @@ private:
   };
   using PerPriorityStatePtr = std::unique_ptr<PerPriorityState>;
 
+  // The input to a build, captured from the priority set on the thread delivering the update.
+  struct PerPriorityBuildInput {
+    NormalizedHostWeightVector normalized_host_weights_;
+    double min_normalized_weight_{1.0};
+    double max_normalized_weight_{0.0};
+    bool global_panic_{};
+  };
+  struct BuildInput {
+    std::vector<PerPriorityBuildInput> per_priority_;
+    std::shared_ptr<HealthyLoad> healthy_per_priority_load_;
+    std::shared_ptr<DegradedLoad> degraded_per_priority_load_;
+    HostMapConstSharedPtr cross_priority_host_map_;
+  };
+  using BuildInputPtr = std::unique_ptr<BuildInput>;
+
+  struct LoadBalancerFactoryImpl;
+
   struct LoadBalancerImpl : public LoadBalancer {
-    LoadBalancerImpl(ClusterStats& stats, Random::RandomGenerator& random)
-        : stats_(stats), random_(random) {}
+    LoadBalancerImpl(ClusterStats& stats, Random::RandomGenerator& random,
+                     std::shared_ptr<LoadBalancerFactoryImpl> factory)
+        : stats_(stats), random_(random), factory_(std::move(factory)) {}
 
     // Upstream::LoadBalancer
     HostConstSharedPtr chooseHost(LoadBalancerContext* context) override;
@@ -136,8 +200,14 @@ private:
       return {};
     }
 
+    // Copies the current state from the factory.
+    void refresh();
+
     ClusterStats& stats_;
     Random::RandomGenerator& random_;
+    const std::shared_ptr<LoadBalancerFactoryImpl> factory_;
+    // The factory generation the state below was copied at.
+    uint64_t generation_{};
     std::shared_ptr<std::vector<PerPriorityStatePtr>> per_priority_state_;
     std::shared_ptr<HealthyLoad> healthy_per_priority_load_;
     std::shared_ptr<DegradedLoad> degraded_per_priority_load_;
@@ -146,7 +216,8 @@ private:
     HostMapConstSharedPtr cross_priority_host_map_;
   };
 
-  struct LoadBalancerFactoryImpl : public LoadBalancerFactory {
+  struct LoadBalancerFactoryImpl : public LoadBalancerFactory,
+                                   public std::enable_shared_from_this<LoadBalancerFactoryImpl> {
     LoadBalancerFactoryImpl(ClusterStats& stats, Random::RandomGenerator& random)
         : stats_(stats), random_(random) {}
 
@@ -155,6 +226,10 @@ private:
 
     ClusterStats& stats_;
     Random::RandomGenerator& random_;
+    // Incremented, with the mutex held, every time the state below is replaced. Worker load
+    // balancers compare it against the generation they copied on every host selection, so that
+    // state built in the background is picked up without waiting for another host set update.
+    std::atomic<uint64_t> generation_{};
     absl::Mutex mutex_;
     std::shared_ptr<std::vector<PerPriorityStatePtr>> per_priority_state_ ABSL_GUARDED_BY(mutex_);
     // This is split out of PerPriorityState so LoadBalancerBase::ChoosePriority can be reused.
@@ -172,13 +247,70 @@ private:
     HostMapConstSharedPtr cross_priority_host_map_ ABSL_GUARDED_BY(mutex_);
   };
 
-  virtual HashingLoadBalancerSharedPtr
-  createLoadBalancer(const NormalizedHostWeightVector& normalized_host_weights,
-                     double min_normalized_weight, double max_normalized_weight) PURE;
+  // The background build state of one load balancer. The build worker shares ownership of it, so
+  // that a build in progress can outlive the load balancer.
+  struct BackgroundBuild {
+    BackgroundBuild(HashingLoadBalancerBuilderSharedPtr builder,
+                    std::shared_ptr<LoadBalancerFactoryImpl> factory)
+        : builder_(std::move(builder)), factory_(std::move(factory)) {}
+
+    bool idle() const { return pending_ == nullptr && !running_; }
+
+    const HashingLoadBalancerBuilderSharedPtr builder_;
+    const std::shared_ptr<LoadBalancerFactoryImpl> factory_;
+    // The following are guarded by the mutex of the build worker.
+    // The input of the most recent update not yet picked up by the build worker.
+    BuildInputPtr pending_;
+    bool queued_{};
+    bool running_{};
+  };
+  using BackgroundBuildSharedPtr = std::shared_ptr<BackgroundBuild>;
+
+  // The thread building the hashing load balancers of all load balancers building in the
+  // background, in the order their updates arrived.
+  class BuildWorker {
+  public:
+    explicit BuildWorker(Thread::ThreadFactory& thread_factory);
+    ~BuildWorker();
+
+    // Returns the build worker shared by all load balancers, creating it if it doesn't exist.
+    static std::shared_ptr<BuildWorker> get(Thread::ThreadFactory& thread_factory);
+
+    // Replaces the pending input of build, queueing the build if it isn't already.
+    void post(const BackgroundBuildSharedPtr& build, BuildInputPtr input);
+    // Drops the pending input of build. A build in progress still completes.
+    void cancel(BackgroundBuild& build);
+    bool waitForIdle(BackgroundBuild& build, std::chrono::milliseconds timeout);
+
+  private:
+    void run();
+    bool hasWorkOrStopped() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return !queue_.empty() || stop_;
+    }
+
+    absl::Mutex mutex_;
+    std::deque<BackgroundBuildSharedPtr> queue_ ABSL_GUARDED_BY(mutex_);
+    bool stop_ ABSL_GUARDED_BY(mutex_){};
+    Thread::ThreadPtr thread_;
+  };
+  using BuildWorkerSharedPtr = std::shared_ptr<BuildWorker>;
+
+  /**
+   * @return the builder of the hashing load balancers. Called once, by initialize().
+   */
+  virtual HashingLoadBalancerBuilderSharedPtr builder() PURE;
   void refresh();
+  BuildInputPtr captureBuildInput();
+  static void build(HashingLoadBalancerBuilder& builder, LoadBalancerFactoryImpl& factory,
+                    const BuildInput& input);
 
   std::shared_ptr<LoadBalancerFactoryImpl> factory_;
+  HashingLoadBalancerBuilderSharedPtr builder_;
   Common::CallbackHandlePtr priority_update_cb_;
+
+  // Only set if buildInBackground() was called.
+  BuildWorkerSharedPtr build_worker_;
+  BackgroundBuildSharedPtr background_build_;
 };
 
 } // namespace Upstream
@@ -1,11 +1,14 @@
 #include "source/common/upstream/upstream_impl.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <limits>
 #include <list>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "envoy/config/cluster/v3/circuit_breaker.pb.h"
@@ -216,8 +219,142 @@ HostVector filterHosts(const absl::node_hash_set<HostSharedPtr>& hosts,
   return net_hosts;
 }
 
+std::unique_ptr<LatencyEstimator> createLatencyEstimator(const ClusterInfo& cluster,
+                                                         TimeSource& time_source) {
+  // Only latency aware load balancers read the estimate, don't pay for maintaining it otherwise.
+  if (cluster.lbType() != LoadBalancerType::PeakEwma) {
+    return nullptr;
+  }
+
+  const auto& config = cluster.lbPeakEwmaConfig();
+  return std::make_unique<PeakEwmaLatencyEstimator>(
+      time_source, std::chrono::milliseconds(
+                       config.has_value() ? PROTOBUF_GET_MS_OR_DEFAULT(config.value(), decay_time,
+                                                                       10000)
+                                          : 10000));
+}
+
+std::unique_ptr<ActiveRequestCounter> createActiveRequestCounter(const ClusterInfo& cluster,
+                                                                 HostStats& stats,
+                                                                 TimeSource& time_source) {
+  // Only the least request load balancer benefits from per worker counts, as it reads the count of
+  // several hosts on every pick.
+  if (cluster.lbType() != LoadBalancerType::LeastRequest) {
+    return nullptr;
+  }
+
+  const auto& config = cluster.lbLeastRequestConfig();
+  if (!config.has_value() || !config.value().per_worker_active_requests()) {
+    return nullptr;
+  }
+
+  return std::make_unique<PerWorkerActiveRequestCounter>(
+      stats.rq_active_, time_source,
+      std::chrono::milliseconds(
+          PROTOBUF_GET_MS_OR_DEFAULT(config.value(), active_requests_merge_interval, 10)));
+}
+
+uint32_t perWorkerShardIndex() {
+  static std::atomic<uint32_t> next_index{0};
+  thread_local const uint32_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+  return index;
+}
+
 } // namespace
 
+PerWorkerActiveRequestCounter::PerWorkerActiveRequestCounter(
+    Stats::PrimitiveGauge& rq_active, TimeSource& time_source,
+    std::chrono::milliseconds merge_interval)
+    : rq_active_(rq_active), time_source_(time_source),
+      merge_interval_ns_(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(merge_interval).count()),
+      num_shards_(std::max(1U, std::min(std::thread::hardware_concurrency(), MaxShards))),
+      shards_(new Shard[num_shards_]), merged_at_ns_(nowNs()) {}
+
+PerWorkerActiveRequestCounter::Shard& PerWorkerActiveRequestCounter::shard() {
+  return shards_[perWorkerShardIndex() % num_shards_];
+}
+
+int64_t PerWorkerActiveRequestCounter::nowNs() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time_source_.monotonicTime().time_since_epoch())
+      .count();
+}
+
+uint64_t PerWorkerActiveRequestCounter::estimate() {
+  const int64_t now_ns = nowNs();
+  int64_t merged_at_ns = merged_at_ns_.load(std::memory_order_relaxed);
+  // Only one of the workers finding the merge stale performs it, the others use the previous one.
+  if (now_ns - merged_at_ns >= merge_interval_ns_ &&
+      merged_at_ns_.compare_exchange_strong(merged_at_ns, now_ns, std::memory_order_relaxed)) {
+    merge();
+  }
+
+  const Shard& local = shard();
+  const int64_t estimate = merged_total_.load(std::memory_order_relaxed) +
+                           local.active_.load(std::memory_order_relaxed) -
+                           local.active_at_merge_.load(std::memory_order_relaxed);
+  return std::max<int64_t>(estimate, 0);
+}
+
+uint64_t PerWorkerActiveRequestCounter::total() {
+  int64_t total = 0;
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    total += shards_[i].active_.load(std::memory_order_relaxed);
+  }
+  rq_active_.set(std::max<int64_t>(total, 0));
+  return std::max<int64_t>(total, 0);
+}
+
+void PerWorkerActiveRequestCounter::merge() {
+  int64_t total = 0;
+  for (uint32_t i = 0; i < num_shards_; i++) {
+    const int64_t active = shards_[i].active_.load(std::memory_order_relaxed);
+    shards_[i].active_at_merge_.store(active, std::memory_order_relaxed);
+    total += active;
+  }
+  merged_total_.store(total, std::memory_order_relaxed);
+  rq_active_.set(std::max<int64_t>(total, 0));
+}
+
+PeakEwmaLatencyEstimator::PeakEwmaLatencyEstimator(TimeSource& time_source,
+                                                   std::chrono::milliseconds decay_time)
+    : time_source_(time_source),
+      decay_time_ns_(std::chrono::duration<double, std::nano>(decay_time).count()) {}
+
+int64_t PeakEwmaLatencyEstimator::nowNs() const {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             time_source_.monotonicTime().time_since_epoch())
+      .count();
+}
+
+double PeakEwmaLatencyEstimator::decayFactor(int64_t elapsed_ns) const {
+  return elapsed_ns <= 0 ? 1.0 : std::exp(-static_cast<double>(elapsed_ns) / decay_time_ns_);
+}
+
+void PeakEwmaLatencyEstimator::putRoundTripTime(std::chrono::microseconds rtt) {
+  const int64_t now_ns = nowNs();
+  const int64_t sampled_at_ns = sampled_at_ns_.exchange(now_ns, std::memory_order_relaxed);
+  const double sample_us = rtt.count();
+  double estimate_us = estimate_us_.load(std::memory_order_relaxed);
+  if (sampled_at_ns == NoSample || sample_us > estimate_us) {
+    // Jump to the peak so that a host turning slow is avoided right away.
+    estimate_us = sample_us;
+  } else {
+    const double decay = decayFactor(now_ns - sampled_at_ns);
+    estimate_us = estimate_us * decay + sample_us * (1.0 - decay);
+  }
+  estimate_us_.store(estimate_us, std::memory_order_relaxed);
+}
+
+absl::optional<double> PeakEwmaLatencyEstimator::roundTripTimeEstimate() const {
+  const int64_t sampled_at_ns = sampled_at_ns_.load(std::memory_order_relaxed);
+  if (sampled_at_ns == NoSample) {
+    return absl::nullopt;
+  }
+  return estimate_us_.load(std::memory_order_relaxed) * decayFactor(nowNs() - sampled_at_ns);
+}
+
 HostDescriptionImpl::HostDescriptionImpl(
     ClusterInfoConstSharedPtr cluster, const std::string& hostname,
     Network::Address::InstanceConstSharedPtr dest_address, MetadataConstSharedPtr metadata,
@@ -232,6 +369,8 @@ HostDescriptionImpl::HostDescriptionImpl(
                   .bool_value()),
       metadata_(metadata), locality_(locality),
       locality_zone_stat_name_(locality.zone(), cluster->statsScope().symbolTable()),
+      latency_estimator_(createLatencyEstimator(*cluster, time_source)),
+      active_requests_(createActiveRequestCounter(*cluster, stats_, time_source)),
       priority_(priority),
       socket_factory_(resolveTransportSocketFactory(dest_address, metadata_.get())),
       creation_time_(time_source.monotonicTime()) {
@@ -806,6 +945,7 @@ ClusterInfoImpl::ClusterInfoImpl(
       maintenance_mode_runtime_key_(absl::StrCat("upstream.maintenance_mode.", name_)),
       source_address_(getSourceAddress(config, bind_config)),
       lb_least_request_config_(config.least_request_lb_config()),
+      lb_peak_ewma_config_(config.peak_ewma_lb_config()),
       lb_ring_hash_config_(config.ring_hash_lb_config()),
       lb_maglev_config_(config.maglev_lb_config()),
       lb_original_dst_config_(config.original_dst_lb_config()),
@@ -821,6 +961,10 @@ ClusterInfoImpl::ClusterInfoImpl(
       drain_connections_on_host_removal_(config.ignore_health_on_host_removal()),
       connection_pool_per_downstream_connection_(
           config.connection_pool_per_downstream_connection()),
+      shared_conn_pool_owner_workers_(
+          config.has_shared_connection_pool()
+              ? PROTOBUF_GET_WRAPPED_OR_DEFAULT(config.shared_connection_pool(), owner_workers, 1)
+              : 0),
       warm_hosts_(!config.health_checks().empty() &&
                   common_lb_config_.ignore_new_hosts_until_first_hc()),
       cluster_type_(
@@ -856,6 +1000,15 @@ ClusterInfoImpl::ClusterInfoImpl(
     case envoy::config::cluster::v3::Cluster::MAGLEV:
       lb_type_ = LoadBalancerType::Maglev;
       break;
+    case envoy::config::cluster::v3::Cluster::PEAK_EWMA:
+      if (config.has_lb_subset_config()) {
+        throw EnvoyException(
+            fmt::format("cluster: LB policy {} cannot be combined with lb_subset_config",
+                        envoy::config::cluster::v3::Cluster::LbPolicy_Name(config.lb_policy())));
+      }
+
+      lb_type_ = LoadBalancerType::PeakEwma;
+      break;
     case envoy::config::cluster::v3::Cluster::CLUSTER_PROVIDED:
       if (config.has_lb_subset_config()) {
         throw EnvoyException(
@@ -1562,6 +1715,20 @@ void PriorityStateManager::updateClusterPrioritySet(
   }
 }
 
+void PriorityStateManager::refreshClusterPrioritySet(
+    const uint32_t priority, absl::optional<uint32_t> overprovisioning_factor) {
+  const HostSet& host_set = *parent_.prioritySet().hostSetsPerPriority()[priority];
+  if (update_cb_ != nullptr) {
+    update_cb_->updateHosts(
+        priority, HostSetImpl::partitionHosts(host_set.hostsPtr(), host_set.hostsPerLocalityPtr()),
+        host_set.localityWeights(), {}, {}, overprovisioning_factor);
+  } else {
+    parent_.prioritySet().updateHosts(
+        priority, HostSetImpl::partitionHosts(host_set.hostsPtr(), host_set.hostsPerLocalityPtr()),
+        host_set.localityWeights(), {}, {}, overprovisioning_factor);
+  }
+}
+
 bool BaseDynamicClusterImpl::updateDynamicHostList(
     const HostVector& new_hosts, HostVector& current_priority_hosts,
     HostVector& hosts_added_to_current_priority, HostVector& hosts_removed_from_current_priority,
@@ -1636,13 +1803,14 @@ bool BaseDynamicClusterImpl::updateDynamicHostList(
       hosts_changed |=
           updateHealthFlag(*host, *existing_host->second, Host::HealthFlag::DEGRADED_EDS_HEALTH);
 
-      // Did metadata change?
+      // Did metadata change? Metadata is pooled per cluster, so unchanged metadata usually is
+      // the same object.
       bool metadata_changed = true;
-      if (host->metadata() && existing_host->second->metadata()) {
+      if (host->metadata() == existing_host->second->metadata()) {
+        metadata_changed = false;
+      } else if (host->metadata() && existing_host->second->metadata()) {
         metadata_changed = !Protobuf::util::MessageDifferencer::Equivalent(
             *host->metadata(), *existing_host->second->metadata());
-      } else if (!host->metadata() && !existing_host->second->metadata()) {
-        metadata_changed = false;
       }
 
       if (metadata_changed) {
@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <limits>
 #include <list>
 #include <memory>
 #include <string>
@@ -72,6 +73,112 @@ public:
   void setUnhealthy(UnhealthyType) override {}
 };
 
+/**
+ * Null implementation of LatencyEstimator.
+ */
+class LatencyEstimatorNullImpl : public LatencyEstimator {
+public:
+  // Upstream::LatencyEstimator
+  void putRoundTripTime(std::chrono::microseconds) override {}
+  absl::optional<double> roundTripTimeEstimate() const override { return absl::nullopt; }
+};
+
+/**
+ * Peak exponentially weighted moving average of the round trip latency of a host, used by
+ * PeakEwmaLoadBalancer. A sample larger than the current estimate replaces it, smaller samples are
+ * blended in with a weight depending on the time elapsed since the previous sample. The estimate
+ * decays towards zero while no samples are recorded.
+ *
+ * The state is kept in relaxed atomics so that all workers can update and read it without locking.
+ * Concurrent updates may race and drop a sample, which is fine for load balancing purposes.
+ */
+class PeakEwmaLatencyEstimator : public LatencyEstimator {
+public:
+  PeakEwmaLatencyEstimator(TimeSource& time_source, std::chrono::milliseconds decay_time);
+
+  // Upstream::LatencyEstimator
+  void putRoundTripTime(std::chrono::microseconds rtt) override;
+  absl::optional<double> roundTripTimeEstimate() const override;
+
+private:
+  static constexpr int64_t NoSample = std::numeric_limits<int64_t>::min();
+
+  int64_t nowNs() const;
+  double decayFactor(int64_t elapsed_ns) const;
+
+  TimeSource& time_source_;
+  const double decay_time_ns_;
+  std::atomic<double> estimate_us_{0};
+  // Monotonic time of the last sample in nanoseconds, or NoSample.
+  std::atomic<int64_t> sampled_at_ns_{NoSample};
+};
+
+/**
+ * ActiveRequestCounter backed by the rq_active gauge of the host, shared by all workers.
+ */
+class GaugeActiveRequestCounter : public ActiveRequestCounter {
+public:
+  GaugeActiveRequestCounter(Stats::PrimitiveGauge& rq_active) : rq_active_(rq_active) {}
+
+  // Upstream::ActiveRequestCounter
+  void inc() override { rq_active_.inc(); }
+  void dec() override { rq_active_.dec(); }
+  uint64_t estimate() override { return rq_active_.value(); }
+  uint64_t total() override { return rq_active_.value(); }
+
+private:
+  Stats::PrimitiveGauge& rq_active_;
+};
+
+/**
+ * ActiveRequestCounter keeping a separate count for each worker, so that the workers starting and
+ * completing requests to the same host don't contend on a shared cache line. The counts of all
+ * workers are summed at most once per merge interval, by the first estimate() call after the
+ * interval elapsed, which also updates the rq_active gauge of the host. An estimate is the merged
+ * sum corrected by the requests started and completed by the calling worker since the merge. The
+ * readers of the gauge off the request path call total() to refresh it first.
+ *
+ * Workers are mapped to shards by their thread, several threads may share a shard when there are
+ * more threads than shards.
+ */
+class PerWorkerActiveRequestCounter : public ActiveRequestCounter {
+public:
+  PerWorkerActiveRequestCounter(Stats::PrimitiveGauge& rq_active, TimeSource& time_source,
+                                std::chrono::milliseconds merge_interval);
+
+  // Upstream::ActiveRequestCounter
+  void inc() override { shard().active_.fetch_add(1, std::memory_order_relaxed); }
+  void dec() override { shard().active_.fetch_sub(1, std::memory_order_relaxed); }
+  uint64_t estimate() override;
+  uint64_t total() override;
+
+  // Sums the counts of all workers for the next estimates and updates the rq_active gauge.
+  void merge();
+
+  static constexpr uint32_t MaxShards = 16;
+
+private:
+  // Each shard is on its own cache line. The active count may go negative when requests complete
+  // on a different thread than the one which started them, only the sum is meaningful.
+  struct alignas(64) Shard {
+    std::atomic<int64_t> active_{0};
+    // Value of active_ at the last merge.
+    std::atomic<int64_t> active_at_merge_{0};
+  };
+
+  Shard& shard();
+  int64_t nowNs() const;
+
+  Stats::PrimitiveGauge& rq_active_;
+  TimeSource& time_source_;
+  const int64_t merge_interval_ns_;
+  const uint32_t num_shards_;
+  const std::unique_ptr<Shard[]> shards_;
+  std::atomic<int64_t> merged_total_{0};
+  // Monotonic time of the last merge in nanoseconds.
+  std::atomic<int64_t> merged_at_ns_;
+};
+
 /**
  * Implementation of Upstream::HostDescription.
  */
@@ -132,6 +239,21 @@ public:
         new Outlier::DetectorHostMonitorNullImpl();
     return *null_outlier_detector;
   }
+  LatencyEstimator& latencyEstimator() const override {
+    if (latency_estimator_) {
+      return *latency_estimator_;
+    }
+
+    static LatencyEstimatorNullImpl* null_latency_estimator = new LatencyEstimatorNullImpl();
+    return *null_latency_estimator;
+  }
+  ActiveRequestCounter& activeRequests() const override {
+    if (active_requests_) {
+      return *active_requests_;
+    }
+
+    return gauge_active_requests_;
+  }
   HostStats& stats() const override { return stats_; }
   const std::string& hostnameForHealthChecks() const override { return health_checks_hostname_; }
   const std::string& hostname() const override { return hostname_; }
@@ -187,6 +309,9 @@ private:
   mutable HostStats stats_;
   Outlier::DetectorHostMonitorPtr outlier_detector_;
   HealthCheckHostMonitorPtr health_checker_;
+  const std::unique_ptr<LatencyEstimator> latency_estimator_;
+  mutable GaugeActiveRequestCounter gauge_active_requests_{stats_.rq_active_};
+  const std::unique_ptr<ActiveRequestCounter> active_requests_;
   std::atomic<uint32_t> priority_;
   std::reference_wrapper<Network::TransportSocketFactory>
       socket_factory_ ABSL_GUARDED_BY(metadata_mutex_);
@@ -228,6 +353,8 @@ public:
 
   std::vector<std::pair<absl::string_view, Stats::PrimitiveGaugeReference>>
   gauges() const override {
+    // Refresh rq_active, which per worker counts only update periodically.
+    activeRequests().total();
     return stats().gauges();
   }
   void healthFlagClear(HealthFlag flag) override { health_flags_ &= ~enumToInt(flag); }
@@ -651,6 +778,10 @@ public:
   lbLeastRequestConfig() const override {
     return lb_least_request_config_;
   }
+  const absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig>&
+  lbPeakEwmaConfig() const override {
+    return lb_peak_ewma_config_;
+  }
   const absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig>&
   lbRingHashConfig() const override {
     return lb_ring_hash_config_;
@@ -712,6 +843,7 @@ public:
   bool connectionPoolPerDownstreamConnection() const override {
     return connection_pool_per_downstream_connection_;
   }
+  uint32_t sharedConnPoolOwnerWorkers() const override { return shared_conn_pool_owner_workers_; }
   bool warmHosts() const override { return warm_hosts_; }
   const absl::optional<envoy::config::core::v3::UpstreamHttpProtocolOptions>&
   upstreamHttpProtocolOptions() const override {
@@ -791,6 +923,7 @@ private:
   absl::optional<envoy::config::cluster::v3::Cluster::RoundRobinLbConfig> lb_round_robin_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::LeastRequestLbConfig>
       lb_least_request_config_;
+  absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig> lb_peak_ewma_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::RingHashLbConfig> lb_ring_hash_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::MaglevLbConfig> lb_maglev_config_;
   absl::optional<envoy::config::cluster::v3::Cluster::OriginalDstLbConfig> lb_original_dst_config_;
@@ -805,6 +938,7 @@ private:
   const Network::ConnectionSocket::OptionsSharedPtr cluster_socket_options_;
   const bool drain_connections_on_host_removal_;
   const bool connection_pool_per_downstream_connection_;
+  const uint32_t shared_conn_pool_owner_workers_;
   const bool warm_hosts_;
   const absl::optional<envoy::config::core::v3::UpstreamHttpProtocolOptions>
       upstream_http_protocol_options_;
@@ -987,6 +1121,12 @@ public:
                            const absl::optional<Upstream::Host::HealthFlag> health_checker_flag,
                            absl::optional<uint32_t> overprovisioning_factor = absl::nullopt);
 
+  // Updates a priority whose hosts did not change, only their health, weight or metadata. The
+  // per-locality grouping and the locality weights of the current host set are kept, only the
+  // healthy, degraded and excluded hosts are recomputed.
+  void refreshClusterPrioritySet(const uint32_t priority,
+                                 absl::optional<uint32_t> overprovisioning_factor = absl::nullopt);
+
   // Returns the saved priority state.
   PriorityState& priorityState() { return priority_state_; }
 
@@ -8,8 +8,17 @@ namespace File {
 FileAccessLog::FileAccessLog(const Filesystem::FilePathAndType& access_log_file_info,
                              AccessLog::FilterPtr&& filter, Formatter::FormatterPtr&& formatter,
                              AccessLog::AccessLogManager& log_manager)
+    : FileAccessLog(access_log_file_info, 0, std::move(filter), std::move(formatter),
+                    log_manager) {}
+
+FileAccessLog::FileAccessLog(const Filesystem::FilePathAndType& access_log_file_info,
+                             uint64_t max_file_size_bytes, AccessLog::FilterPtr&& filter,
+                             Formatter::FormatterPtr&& formatter,
+                             AccessLog::AccessLogManager& log_manager)
     : ImplBase(std::move(filter)), formatter_(std::move(formatter)) {
-  log_file_ = log_manager.createAccessLog(access_log_file_info);
+  log_file_ = max_file_size_bytes > 0
+                  ? log_manager.createAccessLog(access_log_file_info, max_file_size_bytes)
+                  : log_manager.createAccessLog(access_log_file_info);
 }
 
 void FileAccessLog::emitLog(const Http::RequestHeaderMap& request_headers,
@@ -16,6 +16,12 @@ public:
   FileAccessLog(const Filesystem::FilePathAndType& access_log_file_info,
                 AccessLog::FilterPtr&& filter, Formatter::FormatterPtr&& formatter,
                 AccessLog::AccessLogManager& log_manager);
+  /**
+   * @param max_file_size_bytes the size to rotate the file at, or 0 to never rotate it.
+   */
+  FileAccessLog(const Filesystem::FilePathAndType& access_log_file_info,
+                uint64_t max_file_size_bytes, AccessLog::FilterPtr&& filter,
+                Formatter::FormatterPtr&& formatter, AccessLog::AccessLogManager& log_manager);
 
 private:
   // Common::ImplBase
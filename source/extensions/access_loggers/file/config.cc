@@ -59,7 +59,8 @@ AccessLog::InstanceSharedPtr FileAccessLogFactory::createAccessLogInstance(
   }
 
   Filesystem::FilePathAndType file_info{Filesystem::DestinationType::File, fal_config.path()};
-  return std::make_shared<FileAccessLog>(file_info, std::move(filter), std::move(formatter),
+  return std::make_shared<FileAccessLog>(file_info, fal_config.max_file_size_bytes(),
+                                         std::move(filter), std::move(formatter),
                                          context.accessLogManager());
 }
 
@@ -52,7 +52,8 @@ BrotliCompressorImpl::EncoderMode BrotliCompressorFactory::encoderModeEnum(
 
 Envoy::Compression::Compressor::CompressorFactoryPtr
 BrotliCompressorLibraryFactory::createCompressorFactoryFromProtoTyped(
-    const envoy::extensions::compression::brotli::compressor::v3::Brotli& proto_config) {
+    const envoy::extensions::compression::brotli::compressor::v3::Brotli& proto_config,
+    Server::Configuration::FactoryContext&) {
   return std::make_unique<BrotliCompressorFactory>(proto_config);
 }
 
@@ -0,0 +1,65 @@
+#include "source/extensions/compression/zstd/compressor/config.h"
+
+#include "envoy/common/exception.h"
+
+#include "source/common/config/datasource.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+namespace {
+// Default compression level.
+const uint32_t DefaultCompressionLevel = ZSTD_CLEVEL_DEFAULT;
+
+// Default window size, 0 derives it from the compression level.
+const uint32_t DefaultWindowLog = 0;
+
+// Default zstd chunk size.
+const uint32_t DefaultChunkSize = 4096;
+} // namespace
+
+ZstdCompressorFactory::ZstdCompressorFactory(
+    const envoy::extensions::compression::zstd::compressor::v3::Zstd& zstd, Api::Api& api)
+    : compression_level_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, compression_level, DefaultCompressionLevel)),
+      window_log_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, window_log, DefaultWindowLog)),
+      enable_checksum_(zstd.enable_checksum()),
+      chunk_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, chunk_size, DefaultChunkSize)) {
+  if (zstd.has_dictionary()) {
+    // Digesting the dictionary is expensive, so it's done once here rather than per stream.
+    const std::string dictionary = Config::DataSource::read(zstd.dictionary(), false, api);
+    dictionary_ = ZstdCDictSharedPtr(
+        ZSTD_createCDict(dictionary.data(), dictionary.size(), compression_level_),
+        &ZSTD_freeCDict);
+    if (dictionary_ == nullptr) {
+      throw EnvoyException("zstd compressor: unable to load the dictionary");
+    }
+  }
+}
+
+Envoy::Compression::Compressor::CompressorPtr ZstdCompressorFactory::createCompressor() {
+  return std::make_unique<ZstdCompressorImpl>(compression_level_, window_log_, enable_checksum_,
+                                              dictionary_, chunk_size_);
+}
+
+Envoy::Compression::Compressor::CompressorFactoryPtr
+ZstdCompressorLibraryFactory::createCompressorFactoryFromProtoTyped(
+    const envoy::extensions::compression::zstd::compressor::v3::Zstd& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  return std::make_unique<ZstdCompressorFactory>(proto_config, context.api());
+}
+
+/**
+ * Static registration for the zstd compressor library. @see NamedCompressorLibraryConfigFactory.
+ */
+REGISTER_FACTORY(ZstdCompressorLibraryFactory,
+                 Envoy::Compression::Compressor::NamedCompressorLibraryConfigFactory);
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,81 @@
+#include "source/extensions/compression/zstd/compressor/zstd_compressor_impl.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+ZstdCompressorImpl::ZstdCompressorImpl(const uint32_t compression_level, const uint32_t window_log,
+                                       const bool enable_checksum, ZstdCDictSharedPtr dictionary,
+                                       const uint32_t chunk_size)
+    : chunk_size_{chunk_size}, dictionary_(std::move(dictionary)),
+      cctx_(ZSTD_createCCtx(), &ZSTD_freeCCtx) {
+  RELEASE_ASSERT(cctx_ != nullptr, "");
+  RELEASE_ASSERT(compression_level >= 1 &&
+                     compression_level <= static_cast<uint32_t>(ZSTD_maxCLevel()),
+                 "");
+  size_t result = ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_compressionLevel, compression_level);
+  RELEASE_ASSERT(!ZSTD_isError(result), "");
+
+  if (window_log != 0) {
+    RELEASE_ASSERT(window_log >= ZSTD_WINDOWLOG_MIN && window_log <= ZSTD_WINDOWLOG_MAX, "");
+    result = ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_windowLog, window_log);
+    RELEASE_ASSERT(!ZSTD_isError(result), "");
+  }
+
+  result = ZSTD_CCtx_setParameter(cctx_.get(), ZSTD_c_checksumFlag, enable_checksum ? 1 : 0);
+  RELEASE_ASSERT(!ZSTD_isError(result), "");
+
+  if (dictionary_ != nullptr) {
+    result = ZSTD_CCtx_refCDict(cctx_.get(), dictionary_.get());
+    RELEASE_ASSERT(!ZSTD_isError(result), "");
+  }
+}
+
+void ZstdCompressorImpl::compress(Buffer::Instance& buffer,
+                                  Envoy::Compression::Compressor::State state) {
+  Common::ZstdContext ctx(chunk_size_);
+
+  Buffer::OwnedImpl accumulation_buffer;
+  for (const Buffer::RawSlice& input_slice : buffer.getRawSlices()) {
+    ctx.setInput(input_slice);
+
+    while (ctx.input_.pos < ctx.input_.size) {
+      process(ctx, accumulation_buffer, ZSTD_e_continue);
+    }
+
+    buffer.drain(input_slice.len_);
+  }
+
+  ASSERT(buffer.length() == 0);
+  buffer.move(accumulation_buffer);
+
+  // The encoder can hold more data than fits into the output chunk, and in case of the `Finish`
+  // operation it also writes the frame epilogue. ZSTD_compressStream2() returns the number of
+  // bytes still to be flushed, so keep processing until nothing is left.
+  ctx.setInput({nullptr, 0});
+  const ZSTD_EndDirective mode =
+      state == Envoy::Compression::Compressor::State::Finish ? ZSTD_e_end : ZSTD_e_flush;
+  while (process(ctx, buffer, mode) > 0) {
+  }
+
+  ctx.finalizeOutput(buffer);
+}
+
+size_t ZstdCompressorImpl::process(Common::ZstdContext& ctx, Buffer::Instance& output_buffer,
+                                   const ZSTD_EndDirective mode) {
+  const size_t result = ZSTD_compressStream2(cctx_.get(), &ctx.output_, &ctx.input_, mode);
+  RELEASE_ASSERT(!ZSTD_isError(result), "unable to compress");
+  ctx.updateOutput(output_buffer);
+  return result;
+}
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
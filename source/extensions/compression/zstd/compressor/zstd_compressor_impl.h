@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+
+#include "envoy/compression/compressor/compressor.h"
+
+#include "source/common/common/non_copyable.h"
+#include "source/extensions/compression/zstd/common/base.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+
+// A digested dictionary. It's immutable once created and shared by all streams of a factory.
+using ZstdCDictSharedPtr = std::shared_ptr<const ZSTD_CDict>;
+
+/**
+ * Implementation of compressor's interface.
+ */
+class ZstdCompressorImpl : public Envoy::Compression::Compressor::Compressor, NonCopyable {
+public:
+  /**
+   * Constructor.
+   * @param compression_level sets compression level. The higher the level, the slower the
+   * compression. @see ZSTD_c_compressionLevel (zstd manual).
+   * @param window_log sets the base two logarithm of the window size, 0 derives it from the
+   * compression level. @see ZSTD_c_windowLog (zstd manual).
+   * @param enable_checksum if true, a checksum of the content is written at the end of the frame.
+   * @param dictionary optional digested dictionary to compress with.
+   * @param chunk_size amount of memory reserved for the compressor output.
+   */
+  ZstdCompressorImpl(const uint32_t compression_level, const uint32_t window_log,
+                     const bool enable_checksum, ZstdCDictSharedPtr dictionary,
+                     const uint32_t chunk_size);
+
+  // Compression::Compressor::Compressor
+  void compress(Buffer::Instance& buffer, Envoy::Compression::Compressor::State state) override;
+
+private:
+  size_t process(Common::ZstdContext& ctx, Buffer::Instance& output_buffer,
+                 const ZSTD_EndDirective mode);
+
+  const uint32_t chunk_size_;
+  // Keeps the dictionary referenced by cctx_ alive.
+  const ZstdCDictSharedPtr dictionary_;
+  std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> cctx_;
+};
+
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,61 @@
+#include "source/extensions/compression/zstd/decompressor/config.h"
+
+#include "envoy/common/exception.h"
+
+#include "source/common/config/datasource.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+namespace {
+
+// Largest window accepted by default, the same limit the zstd library applies.
+const uint32_t DefaultWindowLogMax = ZSTD_WINDOWLOG_LIMIT_DEFAULT;
+
+const uint32_t DefaultChunkSize = 4096;
+
+} // namespace
+
+ZstdDecompressorFactory::ZstdDecompressorFactory(
+    const envoy::extensions::compression::zstd::decompressor::v3::Zstd& zstd, Stats::Scope& scope,
+    Api::Api& api)
+    : scope_(scope),
+      window_log_max_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, window_log_max, DefaultWindowLogMax)),
+      chunk_size_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(zstd, chunk_size, DefaultChunkSize)) {
+  for (const auto& source : zstd.dictionaries()) {
+    const std::string dictionary = Config::DataSource::read(source, false, api);
+    ZstdDDictSharedPtr ddict(ZSTD_createDDict(dictionary.data(), dictionary.size()),
+                             &ZSTD_freeDDict);
+    if (ddict == nullptr) {
+      throw EnvoyException("zstd decompressor: unable to load a dictionary");
+    }
+    dictionaries_.push_back(std::move(ddict));
+  }
+}
+
+Envoy::Compression::Decompressor::DecompressorPtr
+ZstdDecompressorFactory::createDecompressor(const std::string& stats_prefix) {
+  return std::make_unique<ZstdDecompressorImpl>(scope_, stats_prefix, dictionaries_,
+                                                window_log_max_, chunk_size_);
+}
+
+Envoy::Compression::Decompressor::DecompressorFactoryPtr
+ZstdDecompressorLibraryFactory::createDecompressorFactoryFromProtoTyped(
+    const envoy::extensions::compression::zstd::decompressor::v3::Zstd& proto_config,
+    Server::Configuration::FactoryContext& context) {
+  return std::make_unique<ZstdDecompressorFactory>(proto_config, context.scope(), context.api());
+}
+
+/**
+ * Static registration for the zstd decompressor. @see NamedDecompressorLibraryConfigFactory.
+ */
+REGISTER_FACTORY(ZstdDecompressorLibraryFactory,
+                 Envoy::Compression::Decompressor::NamedDecompressorLibraryConfigFactory);
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,101 @@
+#include "source/extensions/compression/zstd/decompressor/zstd_decompressor_impl.h"
+
+#include "source/common/common/assert.h"
+
+#include "zstd_errors.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+ZstdDecompressorImpl::ZstdDecompressorImpl(Stats::Scope& scope, const std::string& stats_prefix,
+                                           const std::vector<ZstdDDictSharedPtr>& dictionaries,
+                                           const uint32_t window_log_max,
+                                           const uint32_t chunk_size)
+    : chunk_size_{chunk_size}, dictionaries_(dictionaries),
+      dctx_(ZSTD_createDCtx(), &ZSTD_freeDCtx), stats_(generateStats(stats_prefix, scope)) {
+  RELEASE_ASSERT(dctx_ != nullptr, "");
+  RELEASE_ASSERT(window_log_max >= ZSTD_WINDOWLOG_MIN && window_log_max <= ZSTD_WINDOWLOG_MAX,
+                 "");
+  size_t result = ZSTD_DCtx_setParameter(dctx_.get(), ZSTD_d_windowLogMax, window_log_max);
+  RELEASE_ASSERT(!ZSTD_isError(result), "");
+
+  if (dictionaries_.size() > 1) {
+    // Let the decoder pick the dictionary matching the dictionary ID of each frame.
+    result = ZSTD_DCtx_setParameter(dctx_.get(), ZSTD_d_refMultipleDDicts,
+                                    ZSTD_rmd_refMultipleDDicts);
+    RELEASE_ASSERT(!ZSTD_isError(result), "");
+  }
+  // A single dictionary is always used, which also supports raw content dictionaries that don't
+  // carry a dictionary ID.
+  for (const ZstdDDictSharedPtr& dictionary : dictionaries_) {
+    result = ZSTD_DCtx_refDDict(dctx_.get(), dictionary.get());
+    RELEASE_ASSERT(!ZSTD_isError(result), "");
+  }
+}
+
+void ZstdDecompressorImpl::decompress(const Buffer::Instance& input_buffer,
+                                      Buffer::Instance& output_buffer) {
+  Common::ZstdContext ctx(chunk_size_);
+  bool output_full = false;
+
+  for (const Buffer::RawSlice& input_slice : input_buffer.getRawSlices()) {
+    ctx.setInput(input_slice);
+
+    while (ctx.input_.pos < ctx.input_.size) {
+      if (!process(ctx, output_buffer, output_full)) {
+        ctx.finalizeOutput(output_buffer);
+        return;
+      }
+    }
+  }
+
+  // Even though the input has been fully consumed by the decoder it still can hold data back
+  // when the output chunk got filled up. Thus keep processing until the decoder stops filling
+  // the output chunk.
+  ctx.setInput({nullptr, 0});
+  while (output_full && process(ctx, output_buffer, output_full)) {
+  }
+
+  ctx.finalizeOutput(output_buffer);
+}
+
+bool ZstdDecompressorImpl::process(Common::ZstdContext& ctx, Buffer::Instance& output_buffer,
+                                   bool& output_full) {
+  const size_t result = ZSTD_decompressStream(dctx_.get(), &ctx.output_, &ctx.input_);
+  if (ZSTD_isError(result)) {
+    chargeErrorStats(result);
+    return false;
+  }
+
+  output_full = ctx.updateOutput(output_buffer);
+
+  return true;
+}
+
+void ZstdDecompressorImpl::chargeErrorStats(const size_t result) {
+  switch (ZSTD_getErrorCode(result)) {
+  case ZSTD_error_dictionary_wrong:
+  case ZSTD_error_dictionary_corrupted:
+    stats_.zstd_dictionary_error_.inc();
+    break;
+  case ZSTD_error_checksum_wrong:
+    stats_.zstd_checksum_wrong_error_.inc();
+    break;
+  case ZSTD_error_memory_allocation:
+  case ZSTD_error_frameParameter_windowTooLarge:
+    stats_.zstd_memory_error_.inc();
+    break;
+  default:
+    stats_.zstd_generic_error_.inc();
+    break;
+  }
+}
+
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
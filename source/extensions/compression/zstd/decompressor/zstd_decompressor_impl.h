@@ -0,0 +1,78 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "envoy/compression/decompressor/decompressor.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/common/non_copyable.h"
+#include "source/extensions/compression/zstd/common/base.h"
+
+#include "zstd.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+
+// A digested dictionary. It's immutable once created and shared by all streams of a factory.
+using ZstdDDictSharedPtr = std::shared_ptr<const ZSTD_DDict>;
+
+/**
+ * All zstd decompressor stats. @see stats_macros.h
+ */
+#define ALL_ZSTD_DECOMPRESSOR_STATS(COUNTER)                                                       \
+  COUNTER(zstd_generic_error)                                                                      \
+  COUNTER(zstd_dictionary_error)                                                                   \
+  COUNTER(zstd_checksum_wrong_error)                                                               \
+  COUNTER(zstd_memory_error)
+
+/**
+ * Struct definition for zstd decompressor stats. @see stats_macros.h
+ */
+struct ZstdDecompressorStats {
+  ALL_ZSTD_DECOMPRESSOR_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+/**
+ * Implementation of decompressor's interface.
+ */
+class ZstdDecompressorImpl : public Envoy::Compression::Decompressor::Decompressor, NonCopyable {
+public:
+  /**
+   * Constructor.
+   * @param dictionaries digested dictionaries a frame may have been compressed with. The
+   * dictionary is selected by the dictionary ID in the frame header.
+   * @param window_log_max base two logarithm of the largest window a frame may require.
+   * @param chunk_size amount of memory reserved for the decompressor output.
+   */
+  ZstdDecompressorImpl(Stats::Scope& scope, const std::string& stats_prefix,
+                       const std::vector<ZstdDDictSharedPtr>& dictionaries,
+                       const uint32_t window_log_max, const uint32_t chunk_size);
+
+  // Envoy::Compression::Decompressor::Decompressor
+  void decompress(const Buffer::Instance& input_buffer, Buffer::Instance& output_buffer) override;
+
+private:
+  static ZstdDecompressorStats generateStats(const std::string& prefix, Stats::Scope& scope) {
+    return ZstdDecompressorStats{ALL_ZSTD_DECOMPRESSOR_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+  }
+
+  bool process(Common::ZstdContext& ctx, Buffer::Instance& output_buffer, bool& output_full);
+  void chargeErrorStats(const size_t result);
+
+  const uint32_t chunk_size_;
+  // Keeps the dictionaries referenced by dctx_ alive.
+  const std::vector<ZstdDDictSharedPtr> dictionaries_;
+  std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx_;
+  const ZstdDecompressorStats stats_;
+};
+
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
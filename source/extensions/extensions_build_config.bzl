@@ -27,6 +27,8 @@ EXTENSIONS = {
     "envoy.compression.gzip.decompressor":              "//source/extensions/compression/gzip/decompressor:config",
     "envoy.compression.brotli.compressor":              "//source/extensions/compression/brotli/compressor:config",
     "envoy.compression.brotli.decompressor":            "//source/extensions/compression/brotli/decompressor:config",
+    "envoy.compression.zstd.compressor":                "//source/extensions/compression/zstd/compressor:config",
+    "envoy.compression.zstd.decompressor":              "//source/extensions/compression/zstd/decompressor:config",
 
     #
     # gRPC Credentials Plugins
@@ -215,6 +217,8 @@ EXTENSIONS = {
     #
     # CacheFilter plugins
     #
+    "envoy.cache.file_system_http_cache":               "//source/extensions/filters/http/cache/file_system_http_cache:config",
+    "envoy.cache.lru_http_cache":                       "//source/extensions/filters/http/cache/lru_http_cache:config",
     "envoy.cache.simple_http_cache":                    "//source/extensions/filters/http/cache/simple_http_cache:config",
 
     #
@@ -258,6 +262,7 @@ EXTENSIONS = {
     # IO socket
     #
 
+    "envoy.io_socket.io_uring":                         "//source/extensions/io_socket/io_uring:config",
     "envoy.io_socket.user_space":                       "//source/extensions/io_socket/user_space:config",
 
     #
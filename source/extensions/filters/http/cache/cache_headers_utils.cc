@@ -6,12 +6,15 @@
 
 #include "envoy/http/header_map.h"
 
+#include "source/common/common/macros.h"
 #include "source/common/http/header_map_impl.h"
 #include "source/common/http/header_utility.h"
+#include "source/common/http/headers.h"
 #include "source/extensions/filters/http/cache/cache_custom_headers.h"
 
 #include "absl/algorithm/container.h"
 #include "absl/container/btree_set.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/strings/ascii.h"
 #include "absl/strings/numbers.h"
 #include "absl/strings/str_split.h"
@@ -228,6 +231,56 @@ CacheHeadersUtils::parseCommaDelimitedHeader(const Http::HeaderMap::GetResult& e
   return values;
 }
 
+namespace {
+// A list of headers that we do not want to update upon validation
+// We skip these headers because either it's updated by other application logic
+// or they are fall into categories defined in the IETF doc below
+// https://www.ietf.org/archive/id/draft-ietf-httpbis-cache-18.html s3.2
+const absl::flat_hash_set<Http::LowerCaseString>& headersNotToUpdate() {
+  CONSTRUCT_ON_FIRST_USE(
+      absl::flat_hash_set<Http::LowerCaseString>,
+      // Content range should not be changed upon validation
+      Http::Headers::get().ContentRange,
+
+      // Headers that describe the body content should never be updated.
+      Http::Headers::get().ContentLength,
+
+      // It does not make sense for this level of the code to be updating the ETag, when
+      // presumably the cached_response_headers reflect this specific ETag.
+      Http::CustomHeaders::get().Etag,
+
+      // We don't update the cached response on a Vary; we just delete it
+      // entirely. So don't bother copying over the Vary header.
+      Http::CustomHeaders::get().Vary);
+}
+} // namespace
+
+void CacheHeadersUtils::updateStoredHeaders(const Http::ResponseHeaderMap& response_headers,
+                                            Http::ResponseHeaderMap& stored_headers) {
+  // use other header fields provided in the new response to replace all instances
+  // of the corresponding header fields in the stored response
+
+  // `updatedHeaderFields` makes sure each field is only removed when we update the header
+  // field for the first time to handle the case where incoming headers have repeated values
+  absl::flat_hash_set<Http::LowerCaseString> updatedHeaderFields;
+  response_headers.iterate(
+      [&stored_headers, &updatedHeaderFields](
+          const Http::HeaderEntry& incoming_response_header) -> Http::HeaderMap::Iterate {
+        Http::LowerCaseString lower_case_key{incoming_response_header.key().getStringView()};
+        absl::string_view incoming_value{incoming_response_header.value().getStringView()};
+        if (headersNotToUpdate().contains(lower_case_key)) {
+          return Http::HeaderMap::Iterate::Continue;
+        }
+        if (!updatedHeaderFields.contains(lower_case_key)) {
+          stored_headers.setCopy(lower_case_key, incoming_value);
+          updatedHeaderFields.insert(lower_case_key);
+        } else {
+          stored_headers.addCopy(lower_case_key, incoming_value);
+        }
+        return Http::HeaderMap::Iterate::Continue;
+      });
+}
+
 VaryAllowList::VaryAllowList(
     const Protobuf::RepeatedPtrField<envoy::type::matcher::v3::StringMatcher>& allow_list) {
 
@@ -118,6 +118,12 @@ void getAllMatchingHeaderNames(const Http::HeaderMap& headers,
 // Parses the values of a comma-delimited list as defined per
 // https://tools.ietf.org/html/rfc7230#section-7.
 std::vector<absl::string_view> parseCommaDelimitedHeader(const Http::HeaderMap::GetResult& entry);
+
+// Replaces the header fields of a stored response with those of a validation response, as
+// described in https://httpwg.org/specs/rfc7234.html#freshening.responses. Headers describing the
+// stored body (content-length, content-range, etag, vary) are left untouched.
+void updateStoredHeaders(const Http::ResponseHeaderMap& response_headers,
+                         Http::ResponseHeaderMap& stored_headers);
 } // namespace CacheHeadersUtils
 
 class VaryAllowList {
@@ -0,0 +1,58 @@
+#include "source/extensions/filters/http/cache/file_system_http_cache/file_io_thread_pool.h"
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+FileIoThreadPool::FileIoThreadPool(Thread::ThreadFactory& thread_factory, uint32_t thread_count) {
+  ASSERT(thread_count > 0);
+  threads_.reserve(thread_count);
+  for (uint32_t i = 0; i < thread_count; ++i) {
+    threads_.emplace_back(std::make_unique<IoThread>());
+    IoThread& io_thread = *threads_.back();
+    io_thread.thread_ = thread_factory.createThread([&io_thread]() { run(io_thread); },
+                                                    Thread::Options{"CacheFileIo"});
+  }
+}
+
+FileIoThreadPool::~FileIoThreadPool() {
+  for (auto& io_thread : threads_) {
+    absl::MutexLock lock(&io_thread->mutex_);
+    io_thread->shutdown_ = true;
+  }
+  for (auto& io_thread : threads_) {
+    io_thread->thread_->join();
+  }
+}
+
+void FileIoThreadPool::post(uint64_t affinity, std::function<void()> work) {
+  IoThread& io_thread = *threads_[affinity % threads_.size()];
+  absl::MutexLock lock(&io_thread.mutex_);
+  ASSERT(!io_thread.shutdown_);
+  io_thread.queue_.push_back(std::move(work));
+}
+
+void FileIoThreadPool::run(IoThread& io_thread) {
+  while (true) {
+    std::function<void()> work;
+    {
+      absl::MutexLock lock(&io_thread.mutex_);
+      io_thread.mutex_.Await(absl::Condition(&io_thread, &IoThread::hasWorkOrShutdown));
+      if (io_thread.queue_.empty()) {
+        // Only reachable once shutdown_ is set and all queued work has run.
+        return;
+      }
+      work = std::move(io_thread.queue_.front());
+      io_thread.queue_.pop_front();
+    }
+    work();
+  }
+}
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "envoy/thread/thread.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * A fixed set of threads on which FileSystemHttpCache performs blocking file operations, so that
+ * they never run on a worker thread. Each thread has its own FIFO queue and work is assigned to
+ * a thread by a caller supplied affinity, so that work posted with the same affinity runs in the
+ * order it was posted.
+ */
+class FileIoThreadPool {
+public:
+  FileIoThreadPool(Thread::ThreadFactory& thread_factory, uint32_t thread_count);
+
+  /**
+   * Runs all work that is still queued, then joins the threads.
+   */
+  ~FileIoThreadPool();
+
+  /**
+   * Queues work to run on one of the pool's threads.
+   * @param affinity selects the thread; work with equal affinity is run in order.
+   * @param work supplies the work to run.
+   */
+  void post(uint64_t affinity, std::function<void()> work);
+
+  uint32_t threadCount() const { return threads_.size(); }
+
+private:
+  struct IoThread {
+    bool hasWorkOrShutdown() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+      return shutdown_ || !queue_.empty();
+    }
+
+    absl::Mutex mutex_;
+    std::deque<std::function<void()>> queue_ ABSL_GUARDED_BY(mutex_);
+    bool shutdown_ ABSL_GUARDED_BY(mutex_){};
+    Thread::ThreadPtr thread_;
+  };
+
+  static void run(IoThread& io_thread);
+
+  std::vector<std::unique_ptr<IoThread>> threads_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
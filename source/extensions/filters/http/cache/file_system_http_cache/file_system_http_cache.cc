@@ -0,0 +1,659 @@
+#include "source/extensions/filters/http/cache/file_system_http_cache/file_system_http_cache.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+
+#include "envoy/common/exception.h"
+#include "envoy/extensions/cache/file_system_http_cache/v3/config.pb.h"
+#include "envoy/extensions/cache/file_system_http_cache/v3/config.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/protobuf/utility.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+constexpr uint32_t DefaultThreadCount = 4;
+constexpr uint32_t DefaultReadChunkSizeBytes = 64 * 1024;
+
+// Every entry file starts with a fixed size prefix: a magic number, the file format version and
+// the size of the serialized CacheFileHeader that follows it. All fields are little endian.
+constexpr uint32_t FileMagic = 0x45434846; // "ECHF"
+constexpr uint32_t FileVersion = 1;
+constexpr uint64_t FilePrefixSize = 3 * sizeof(uint32_t);
+// Guards against allocating a huge buffer for the header of a corrupt file.
+constexpr uint32_t MaxFileHeaderSize = 1024 * 1024;
+
+void putUint32(std::string& out, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+  }
+}
+
+uint32_t getUint32(const char* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+ssize_t preadRetry(int fd, void* buf, size_t length, uint64_t offset) {
+  ssize_t rc;
+  do {
+    rc = ::pread(fd, buf, length, offset);
+  } while (rc == -1 && errno == EINTR);
+  return rc;
+}
+
+bool preadAll(int fd, char* buf, size_t length, uint64_t offset) {
+  while (length > 0) {
+    const ssize_t rc = preadRetry(fd, buf, length, offset);
+    if (rc <= 0) {
+      return false;
+    }
+    buf += rc;
+    length -= rc;
+    offset += rc;
+  }
+  return true;
+}
+
+bool writeAll(int fd, absl::string_view data) {
+  while (!data.empty()) {
+    const ssize_t rc = ::write(fd, data.data(), data.size());
+    if (rc == -1 && errno == EINTR) {
+      continue;
+    }
+    if (rc <= 0) {
+      return false;
+    }
+    data.remove_prefix(rc);
+  }
+  return true;
+}
+
+// Reads the prefix and CacheFileHeader of an entry file.
+bool readFileHeader(int fd, CacheFileHeader& header, uint64_t& body_offset, uint64_t& body_size) {
+  struct stat file_stat;
+  if (::fstat(fd, &file_stat) != 0 || static_cast<uint64_t>(file_stat.st_size) < FilePrefixSize) {
+    return false;
+  }
+  char prefix[FilePrefixSize];
+  if (!preadAll(fd, prefix, FilePrefixSize, 0) || getUint32(prefix) != FileMagic ||
+      getUint32(prefix + 4) != FileVersion) {
+    return false;
+  }
+  const uint32_t header_size = getUint32(prefix + 8);
+  if (header_size > MaxFileHeaderSize ||
+      FilePrefixSize + header_size > static_cast<uint64_t>(file_stat.st_size)) {
+    return false;
+  }
+  std::string serialized_header(header_size, '\0');
+  if (!preadAll(fd, serialized_header.data(), header_size, FilePrefixSize) ||
+      !header.ParseFromString(serialized_header)) {
+    return false;
+  }
+  body_offset = FilePrefixSize + header_size;
+  body_size = file_stat.st_size - body_offset;
+  return true;
+}
+
+Http::ResponseHeaderMapPtr headersFromProto(const CacheFileHeader& header) {
+  Http::ResponseHeaderMapPtr headers = Http::ResponseHeaderMapImpl::create();
+  for (const auto& entry : header.headers()) {
+    headers->addCopy(Http::LowerCaseString(entry.key()), entry.value());
+  }
+  return headers;
+}
+
+CacheFileHeader makeFileHeader(const Key& key, const Http::ResponseHeaderMap& headers,
+                               const ResponseMetadata& metadata) {
+  CacheFileHeader header;
+  *header.mutable_key() = key;
+  headers.iterate([&header](const Http::HeaderEntry& entry) -> Http::HeaderMap::Iterate {
+    auto* proto_entry = header.add_headers();
+    proto_entry->set_key(std::string(entry.key().getStringView()));
+    proto_entry->set_value(std::string(entry.value().getStringView()));
+    return Http::HeaderMap::Iterate::Continue;
+  });
+  header.set_response_time_micros(std::chrono::duration_cast<std::chrono::microseconds>(
+                                      metadata.response_time_.time_since_epoch())
+                                      .count());
+  return header;
+}
+
+ResponseMetadata metadataFromProto(const CacheFileHeader& header) {
+  return {SystemTime(std::chrono::microseconds(header.response_time_micros()))};
+}
+
+// Returns whether the temporary file name, "cache-<hash>.<pid>.<tag>.<id>.tmp", was left behind by
+// a process other than the one writing with own_tag, which can no longer be writing to it.
+bool isStaleTempFile(absl::string_view name, uint64_t own_tag) {
+  if (!absl::StartsWith(name, "cache-")) {
+    return false;
+  }
+  const std::vector<absl::string_view> parts = absl::StrSplit(name, '.');
+  uint64_t pid;
+  uint64_t tag;
+  if (parts.size() != 5 || parts[4] != "tmp" || !absl::SimpleAtoi(parts[1], &pid) ||
+      !absl::SimpleAtoi(parts[2], &tag) || tag == own_tag) {
+    return false;
+  }
+  // A file of our own pid with another tag was written by an earlier process with the same pid,
+  // as happens when running as pid 1 in a container.
+  return pid == static_cast<uint64_t>(::getpid()) ||
+         (::kill(static_cast<pid_t>(pid), 0) == -1 && errno == ESRCH);
+}
+
+// Closes fd and moves the file at temp_path to path, or removes it if the entry is incomplete.
+bool finishEntry(int fd, bool failed, const std::string& temp_path, const std::string& path) {
+  if (fd != -1) {
+    failed |= ::close(fd) != 0;
+  }
+  if (failed || ::rename(temp_path.c_str(), path.c_str()) != 0) {
+    ::unlink(temp_path.c_str());
+    return false;
+  }
+  return true;
+}
+
+// State shared between a lookup context and the file operations it has queued, which may still
+// be running when the context is destroyed.
+struct LookupState {
+  explicit LookupState(LookupRequest&& request) : request_(std::move(request)) {}
+
+  const LookupRequest request_;
+  // Set on a file I/O thread by getHeaders, before its callback is invoked.
+  CacheEntryFilePtr entry_;
+  // Held while invoking callbacks, so that onDestroy() can wait for an in-flight callback.
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_){};
+};
+using LookupStateSharedPtr = std::shared_ptr<LookupState>;
+
+// Finds the entry for the request, following the vary marker if the response varies.
+LookupResult lookup(FileSystemHttpCache& cache, LookupState& state) {
+  const LookupRequest& request = state.request_;
+  CacheEntryFilePtr entry = cache.openEntry(request.key());
+  if (entry != nullptr) {
+    const Http::ResponseHeaderMapPtr headers = headersFromProto(entry->header());
+    if (VaryHeaderUtils::hasVary(*headers)) {
+      entry = nullptr;
+      const absl::optional<std::string> vary_identifier = VaryHeaderUtils::createVaryIdentifier(
+          request.varyAllowList(), VaryHeaderUtils::getVaryValues(*headers),
+          request.requestHeaders());
+      // If there's no identifier the vary allow list has changed and has made the vary header of
+      // this cached value not cacheable.
+      if (vary_identifier.has_value()) {
+        Key varied_key = request.key();
+        varied_key.add_custom_fields(vary_identifier.value());
+        entry = cache.openEntry(varied_key);
+      }
+    }
+  }
+
+  if (entry == nullptr) {
+    cache.stats().lookup_misses_.inc();
+    return LookupResult{};
+  }
+  cache.stats().lookup_hits_.inc();
+  const uint64_t body_size = entry->bodySize();
+  Http::ResponseHeaderMapPtr headers = headersFromProto(entry->header());
+  ResponseMetadata metadata = metadataFromProto(entry->header());
+  state.entry_ = std::move(entry);
+  return request.makeLookupResult(std::move(headers), std::move(metadata), body_size);
+}
+
+class FileSystemLookupContext : public LookupContext {
+public:
+  FileSystemLookupContext(FileSystemHttpCache& cache, LookupRequest&& request)
+      : cache_(cache), state_(std::make_shared<LookupState>(std::move(request))),
+        affinity_(cache.nextAffinity()) {}
+
+  void getHeaders(LookupHeadersCallback&& cb) override {
+    cache_.post(affinity_, [&cache = cache_, state = state_, cb = std::move(cb)]() {
+      LookupResult result = lookup(cache, *state);
+      absl::MutexLock lock(&state->mutex_);
+      if (!state->cancelled_) {
+        cb(std::move(result));
+      }
+    });
+  }
+
+  void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
+    ASSERT(state_->entry_ != nullptr);
+    ASSERT(range.end() <= state_->entry_->bodySize(), "Attempt to read past end of body.");
+    cache_.post(affinity_, [&cache = cache_, state = state_, range, cb = std::move(cb)]() {
+      const CacheEntryFile& entry = *state->entry_;
+      // Reading less than the whole range is allowed; the filter asks for the remainder.
+      const uint64_t length = std::min<uint64_t>(range.length(), cache.readChunkSizeBytes());
+      Buffer::InstancePtr body = std::make_unique<Buffer::OwnedImpl>();
+      ssize_t rc;
+      {
+        Buffer::ReservationSingleSlice reservation = body->reserveSingleSlice(length);
+        rc = preadRetry(entry.fd(), reservation.slice().mem_, length,
+                        entry.bodyOffset() + range.begin());
+        reservation.commit(rc > 0 ? rc : 0);
+      }
+      if (rc <= 0) {
+        // Passing nullptr aborts the response.
+        cache.stats().read_failures_.inc();
+        body = nullptr;
+      }
+      absl::MutexLock lock(&state->mutex_);
+      if (!state->cancelled_) {
+        cb(std::move(body));
+      }
+    });
+  }
+
+  void getTrailers(LookupTrailersCallback&&) override {
+    // TODO(toddmgreer): Support trailers.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  void onDestroy() override {
+    absl::MutexLock lock(&state_->mutex_);
+    state_->cancelled_ = true;
+  }
+
+  const LookupStateSharedPtr& state() const { return state_; }
+
+private:
+  FileSystemHttpCache& cache_;
+  const LookupStateSharedPtr state_;
+  // Lookups don't need to be ordered with other work, so each picks its own thread.
+  const uint64_t affinity_;
+};
+
+// State of an insert that is only accessed on the file I/O thread of the entry, apart from
+// cancelled_.
+struct InsertState {
+  int fd_{-1};
+  bool failed_{};
+  absl::Mutex mutex_;
+  bool cancelled_ ABSL_GUARDED_BY(mutex_){};
+};
+using InsertStateSharedPtr = std::shared_ptr<InsertState>;
+
+class FileSystemInsertContext : public InsertContext {
+public:
+  FileSystemInsertContext(FileSystemLookupContext& lookup_context, FileSystemHttpCache& cache)
+      : lookup_state_(lookup_context.state()), cache_(cache),
+        state_(std::make_shared<InsertState>()) {}
+
+  void insertHeaders(const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata, bool end_stream) override {
+    ASSERT(!started_);
+    started_ = true;
+    const LookupRequest& request = lookup_state_->request_;
+    key_ = request.key();
+
+    if (VaryHeaderUtils::hasVary(response_headers)) {
+      const absl::btree_set<absl::string_view> vary_header_values =
+          VaryHeaderUtils::getVaryValues(response_headers);
+      const absl::optional<std::string> vary_identifier = VaryHeaderUtils::createVaryIdentifier(
+          request.varyAllowList(), vary_header_values, request.requestHeaders());
+      if (!vary_identifier.has_value()) {
+        // Skip the insert if we are unable to create a vary key.
+        aborted_ = finished_ = true;
+        return;
+      }
+      // The entry for the request key only flags that the response varies, and the response is
+      // stored under the varied key.
+      Http::ResponseHeaderMapPtr vary_only_map = Http::ResponseHeaderMapImpl::create();
+      vary_only_map->setCopy(Http::CustomHeaders::get().Vary,
+                             absl::StrJoin(vary_header_values, ","));
+      vary_marker_ = makeFileHeader(key_, *vary_only_map, {});
+      vary_marker_path_ = cache_.entryPath(key_);
+      vary_marker_temp_path_ = cache_.tempPath(key_);
+      key_.add_custom_fields(vary_identifier.value());
+    }
+
+    // All work for an insert runs on the key's thread, so it runs in order and is ordered with
+    // other inserts and updates of the same key.
+    affinity_ = stableHashKey(key_);
+    temp_path_ = cache_.tempPath(key_);
+    cache_.post(affinity_, [state = state_, temp_path = temp_path_,
+                            header = makeFileHeader(key_, response_headers, metadata)]() {
+      state->fd_ = FileSystemHttpCache::createEntry(temp_path, header);
+      state->failed_ = state->fd_ == -1;
+    });
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertBody(const Buffer::Instance& chunk, InsertCallback ready_for_next_chunk,
+                  bool end_stream) override {
+    ASSERT(ready_for_next_chunk || end_stream);
+    if (aborted_) {
+      return;
+    }
+    ASSERT(started_ && !finished_);
+
+    body_size_ += chunk.length();
+    if (body_size_ > cache_.maxEntrySizeBytes()) {
+      cache_.stats().inserts_too_large_.inc();
+      abort();
+      if (!end_stream) {
+        ready_for_next_chunk(false);
+      }
+      return;
+    }
+
+    cache_.post(affinity_, [state = state_, data = chunk.toString(),
+                            ready_for_next_chunk = std::move(ready_for_next_chunk), end_stream]() {
+      if (!state->failed_ && !writeAll(state->fd_, data)) {
+        state->failed_ = true;
+      }
+      if (end_stream) {
+        return;
+      }
+      absl::MutexLock lock(&state->mutex_);
+      if (!state->cancelled_) {
+        ready_for_next_chunk(!state->failed_);
+      }
+    });
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertTrailers(const Http::ResponseTrailerMap&) override {
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE; // TODO(toddmgreer): support trailers
+  }
+
+  void onDestroy() override {
+    {
+      absl::MutexLock lock(&state_->mutex_);
+      state_->cancelled_ = true;
+    }
+    if (started_ && !finished_) {
+      // The response was not fully received, so discard the partial entry.
+      abort();
+    }
+  }
+
+private:
+  void commit() {
+    finished_ = true;
+    cache_.post(affinity_, [&cache = cache_, state = state_, temp_path = temp_path_,
+                            path = cache_.entryPath(key_), vary_marker = std::move(vary_marker_),
+                            vary_marker_path = vary_marker_path_,
+                            vary_marker_temp_path = vary_marker_temp_path_]() {
+      const bool inserted = finishEntry(state->fd_, state->failed_, temp_path, path);
+      state->fd_ = -1;
+      if (inserted && vary_marker.has_value()) {
+        // Written after the variant, so that a lookup that finds the marker can find the variant.
+        const int marker_fd = FileSystemHttpCache::createEntry(vary_marker_temp_path, *vary_marker);
+        finishEntry(marker_fd, marker_fd == -1, vary_marker_temp_path, vary_marker_path);
+      }
+      inserted ? cache.stats().inserts_.inc() : cache.stats().insert_failures_.inc();
+    });
+  }
+
+  void abort() {
+    aborted_ = finished_ = true;
+    cache_.post(affinity_, [state = state_, temp_path = temp_path_]() {
+      if (state->fd_ != -1) {
+        ::close(state->fd_);
+        state->fd_ = -1;
+      }
+      ::unlink(temp_path.c_str());
+    });
+  }
+
+  const LookupStateSharedPtr lookup_state_;
+  FileSystemHttpCache& cache_;
+  const InsertStateSharedPtr state_;
+  Key key_;
+  uint64_t affinity_{};
+  std::string temp_path_;
+  uint64_t body_size_{};
+  absl::optional<CacheFileHeader> vary_marker_;
+  std::string vary_marker_path_;
+  std::string vary_marker_temp_path_;
+  bool started_{};
+  bool finished_{};
+  bool aborted_{};
+};
+
+// Copies the entry to temp_path with a new header and renames it into place, unless the entry has
+// been replaced since it was looked up.
+bool rewriteEntry(const CacheEntryFile& entry, const CacheFileHeader& header,
+                  const std::string& temp_path, uint32_t chunk_size) {
+  struct stat current_stat;
+  struct stat entry_stat;
+  if (::stat(entry.path().c_str(), &current_stat) != 0 || ::fstat(entry.fd(), &entry_stat) != 0 ||
+      current_stat.st_dev != entry_stat.st_dev || current_stat.st_ino != entry_stat.st_ino) {
+    return false;
+  }
+  const int fd = FileSystemHttpCache::createEntry(temp_path, header);
+  bool failed = fd == -1;
+  std::string buffer(std::min<uint64_t>(chunk_size, entry.bodySize()), '\0');
+  for (uint64_t offset = 0; !failed && offset < entry.bodySize(); offset += buffer.size()) {
+    const uint64_t length = std::min<uint64_t>(buffer.size(), entry.bodySize() - offset);
+    failed = !preadAll(entry.fd(), buffer.data(), length, entry.bodyOffset() + offset) ||
+             !writeAll(fd, absl::string_view(buffer.data(), length));
+  }
+  return finishEntry(fd, failed, temp_path, entry.path());
+}
+
+FileSystemHttpCacheStats generateStats(Stats::Scope& scope) {
+  const std::string prefix = "http_cache.file_system.";
+  return {ALL_FILE_SYSTEM_HTTP_CACHE_STATS(POOL_COUNTER_PREFIX(scope, prefix))};
+}
+
+} // namespace
+
+CacheEntryFile::~CacheEntryFile() { ::close(fd_); }
+
+FileSystemHttpCache::FileSystemHttpCache(
+    const envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig& config,
+    Thread::ThreadFactory& thread_factory, Random::RandomGenerator& random, Stats::Scope& scope)
+    : config_(config), cache_path_(config.cache_path()),
+      max_entry_size_bytes_(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_entry_size_bytes, UINT64_MAX)),
+      read_chunk_size_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, read_chunk_size_bytes,
+                                                             DefaultReadChunkSizeBytes)),
+      stats_(generateStats(scope)), temp_file_tag_(random.random()),
+      thread_pool_(thread_factory,
+                   PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, thread_count, DefaultThreadCount)) {
+  post(nextAffinity(), [this]() { removeStaleTempFiles(); });
+}
+
+LookupContextPtr FileSystemHttpCache::makeLookupContext(LookupRequest&& request) {
+  return std::make_unique<FileSystemLookupContext>(*this, std::move(request));
+}
+
+InsertContextPtr FileSystemHttpCache::makeInsertContext(LookupContextPtr&& lookup_context) {
+  ASSERT(lookup_context != nullptr);
+  return std::make_unique<FileSystemInsertContext>(
+      dynamic_cast<FileSystemLookupContext&>(*lookup_context), *this);
+}
+
+void FileSystemHttpCache::updateHeaders(const LookupContext& lookup_context,
+                                        const Http::ResponseHeaderMap& response_headers,
+                                        const ResponseMetadata& metadata) {
+  LookupStateSharedPtr state = static_cast<const FileSystemLookupContext&>(lookup_context).state();
+  if (state->entry_ == nullptr) {
+    return;
+  }
+  const CacheFileHeader& stored_header = state->entry_->header();
+  Http::ResponseHeaderMapPtr stored_headers = headersFromProto(stored_header);
+
+  // TODO(tangsaidi) handle Vary header updates properly
+  if (VaryHeaderUtils::hasVary(*stored_headers)) {
+    return;
+  }
+
+  CacheHeadersUtils::updateStoredHeaders(response_headers, *stored_headers);
+  const Key& key = stored_header.key();
+  post(stableHashKey(key), [this, state, header = makeFileHeader(key, *stored_headers, metadata),
+                            temp_path = tempPath(key)]() {
+    if (rewriteEntry(*state->entry_, header, temp_path, read_chunk_size_bytes_)) {
+      stats_.header_updates_.inc();
+    }
+  });
+}
+
+constexpr absl::string_view Name = "envoy.extensions.http.cache.file_system";
+
+CacheInfo FileSystemHttpCache::cacheInfo() const {
+  CacheInfo cache_info;
+  cache_info.name_ = Name;
+  cache_info.supports_range_requests_ = true;
+  return cache_info;
+}
+
+std::string FileSystemHttpCache::entryPath(const Key& key) const {
+  return absl::StrCat(cache_path_, "/cache-", absl::Hex(stableHashKey(key), absl::kZeroPad16));
+}
+
+std::string FileSystemHttpCache::tempPath(const Key& key) {
+  // The pid keeps the paths used by the old and new process apart during a hot restart, and the
+  // tag those of processes which had the same pid.
+  return absl::StrCat(entryPath(key), ".", ::getpid(), ".", temp_file_tag_, ".", next_temp_id_++,
+                      ".tmp");
+}
+
+void FileSystemHttpCache::removeStaleTempFiles() {
+  DIR* dir = ::opendir(cache_path_.c_str());
+  if (dir == nullptr) {
+    return;
+  }
+  while (const dirent* entry = ::readdir(dir)) {
+    if (isStaleTempFile(entry->d_name, temp_file_tag_)) {
+      ::unlink(absl::StrCat(cache_path_, "/", entry->d_name).c_str());
+    }
+  }
+  ::closedir(dir);
+}
+
+CacheEntryFilePtr FileSystemHttpCache::openEntry(const Key& key) {
+  std::string path = entryPath(key);
+  const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == -1) {
+    return nullptr;
+  }
+  CacheFileHeader header;
+  uint64_t body_offset;
+  uint64_t body_size;
+  // Keys are only identified by their hash in the file name, so check for collisions.
+  if (!readFileHeader(fd, header, body_offset, body_size) || !MessageUtil()(header.key(), key)) {
+    ::close(fd);
+    return nullptr;
+  }
+  return std::make_unique<CacheEntryFile>(fd, std::move(path), std::move(header), body_offset,
+                                          body_size);
+}
+
+int FileSystemHttpCache::createEntry(const std::string& path, const CacheFileHeader& header) {
+  const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+  if (fd == -1) {
+    return -1;
+  }
+  const std::string serialized_header = header.SerializeAsString();
+  std::string prefix;
+  prefix.reserve(FilePrefixSize);
+  putUint32(prefix, FileMagic);
+  putUint32(prefix, FileVersion);
+  putUint32(prefix, serialized_header.size());
+  if (!writeAll(fd, prefix) || !writeAll(fd, serialized_header)) {
+    ::close(fd);
+    ::unlink(path.c_str());
+    return -1;
+  }
+  return fd;
+}
+
+SINGLETON_MANAGER_REGISTRATION(file_system_http_cache_singleton);
+
+// Owns the caches of all cache filter configs, so that each cache_path is served by one cache and
+// thread pool, which outlive listener updates, rather than by one per filter config. The caches
+// are destroyed, and their thread pools joined, once no filter config uses any of them.
+class FileSystemHttpCacheSingleton
+    : public Singleton::Instance,
+      public std::enable_shared_from_this<FileSystemHttpCacheSingleton> {
+public:
+  HttpCacheSharedPtr
+  get(const envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig&
+          config,
+      Server::Configuration::FactoryContext& context) {
+    auto it = caches_.find(config.cache_path());
+    if (it == caches_.end()) {
+      it = caches_
+               .emplace(config.cache_path(),
+                        std::make_unique<FileSystemHttpCache>(
+                            config, context.api().threadFactory(), context.api().randomGenerator(),
+                            context.serverScope()))
+               .first;
+    } else if (!Protobuf::util::MessageDifferencer::Equivalent(config, it->second->config())) {
+      throw EnvoyException(fmt::format(
+          "file system http cache: cache_path '{}' is configured with different settings",
+          config.cache_path()));
+    }
+    // Shares ownership of the singleton, which owns the cache.
+    return {shared_from_this(), it->second.get()};
+  }
+
+private:
+  absl::flat_hash_map<std::string, std::unique_ptr<FileSystemHttpCache>> caches_;
+};
+
+class FileSystemHttpCacheFactory : public HttpCacheFactory {
+public:
+  // From UntypedFactory
+  std::string name() const override { return std::string(Name); }
+  // From TypedFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<
+        envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig>();
+  }
+  // From HttpCacheFactory
+  HttpCacheSharedPtr
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) override {
+    envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig fs_config;
+    MessageUtil::unpackTo(config.typed_config(), fs_config);
+    MessageUtil::validate(fs_config, context.messageValidationVisitor());
+    if (!context.api().fileSystem().directoryExists(fs_config.cache_path())) {
+      throw EnvoyException(
+          fmt::format("file system http cache: cache_path '{}' is not a directory",
+                      fs_config.cache_path()));
+    }
+    return context.singletonManager()
+        .getTyped<FileSystemHttpCacheSingleton>(
+            SINGLETON_MANAGER_REGISTERED_NAME(file_system_http_cache_singleton),
+            [] { return std::make_shared<FileSystemHttpCacheSingleton>(); })
+        ->get(fs_config, context);
+  }
+};
+
+static Registry::RegisterFactory<FileSystemHttpCacheFactory, HttpCacheFactory> register_;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
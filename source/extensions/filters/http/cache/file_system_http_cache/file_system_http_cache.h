@@ -0,0 +1,148 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+
+#include "envoy/common/random_generator.h"
+#include "envoy/extensions/cache/file_system_http_cache/v3/config.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+#include "envoy/thread/thread.h"
+
+#include "source/extensions/filters/http/cache/file_system_http_cache/cache_file_header.pb.h"
+#include "source/extensions/filters/http/cache/file_system_http_cache/file_io_thread_pool.h"
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "absl/types/optional.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All stats for the file system HTTP cache. @see stats_macros.h
+ */
+#define ALL_FILE_SYSTEM_HTTP_CACHE_STATS(COUNTER)                                                  \
+  COUNTER(header_updates)                                                                          \
+  COUNTER(insert_failures)                                                                         \
+  COUNTER(inserts)                                                                                 \
+  COUNTER(inserts_too_large)                                                                       \
+  COUNTER(lookup_hits)                                                                             \
+  COUNTER(lookup_misses)                                                                           \
+  COUNTER(read_failures)
+
+/**
+ * Struct definition for all file system HTTP cache stats. @see stats_macros.h
+ */
+struct FileSystemHttpCacheStats {
+  ALL_FILE_SYSTEM_HTTP_CACHE_STATS(GENERATE_COUNTER_STRUCT)
+};
+
+// An open cache entry file, positioned by offset rather than by a file pointer so that it can be
+// read concurrently.
+class CacheEntryFile {
+public:
+  CacheEntryFile(int fd, std::string path, CacheFileHeader&& header, uint64_t body_offset,
+                 uint64_t body_size)
+      : fd_(fd), path_(std::move(path)), header_(std::move(header)), body_offset_(body_offset),
+        body_size_(body_size) {}
+  ~CacheEntryFile();
+  CacheEntryFile(const CacheEntryFile&) = delete;
+  CacheEntryFile& operator=(const CacheEntryFile&) = delete;
+
+  int fd() const { return fd_; }
+  const std::string& path() const { return path_; }
+  const CacheFileHeader& header() const { return header_; }
+  uint64_t bodyOffset() const { return body_offset_; }
+  uint64_t bodySize() const { return body_size_; }
+
+private:
+  const int fd_;
+  const std::string path_;
+  const CacheFileHeader header_;
+  const uint64_t body_offset_;
+  const uint64_t body_size_;
+};
+using CacheEntryFilePtr = std::unique_ptr<CacheEntryFile>;
+
+// Cache backend that stores each response in its own file, so that the size of the cache is
+// bounded by disk rather than by memory. All file operations run on a FileIoThreadPool, and their
+// callbacks are invoked from the pool's threads (the cache filter posts them back to its worker).
+//
+// Each entry file holds a fixed size prefix, a serialized CacheFileHeader and then the body, so
+// body ranges are read straight from their file offsets. Entries are written to a temporary file
+// and renamed into place when complete, so readers (including another Envoy process sharing the
+// directory during a hot restart) only ever see complete entries. Temporary file names carry the
+// pid and a random tag of the cache which wrote them, so that files abandoned by a process which
+// is no longer running (or by an earlier process with the same pid) are removed at startup.
+//
+// Only one cache may use a given cache_path within a process; the factory shares it between all
+// cache filters configured with that path.
+class FileSystemHttpCache : public HttpCache {
+public:
+  FileSystemHttpCache(
+      const envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig& config,
+      Thread::ThreadFactory& thread_factory, Random::RandomGenerator& random, Stats::Scope& scope);
+
+  // HttpCache
+  LookupContextPtr makeLookupContext(LookupRequest&& request) override;
+  InsertContextPtr makeInsertContext(LookupContextPtr&& lookup_context) override;
+  void updateHeaders(const LookupContext& lookup_context,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata) override;
+  CacheInfo cacheInfo() const override;
+
+  // Runs work on the file I/O thread selected by affinity.
+  void post(uint64_t affinity, std::function<void()> work) {
+    thread_pool_.post(affinity, std::move(work));
+  }
+
+  // Returns a new affinity for work that doesn't need to be ordered with other work.
+  uint64_t nextAffinity() { return next_affinity_++; }
+
+  // Returns the path of the entry file for key.
+  std::string entryPath(const Key& key) const;
+
+  // Returns a unique path to write the entry for key to before it is renamed into place.
+  std::string tempPath(const Key& key);
+
+  // The following are blocking and must only be called on a file I/O thread.
+
+  // Opens the entry file for key, returning nullptr if there is no usable entry for the key.
+  CacheEntryFilePtr openEntry(const Key& key);
+
+  // Writes the header of an entry to a new file at path, returning the open fd or -1.
+  static int createEntry(const std::string& path, const CacheFileHeader& header);
+
+  uint64_t maxEntrySizeBytes() const { return max_entry_size_bytes_; }
+  uint32_t readChunkSizeBytes() const { return read_chunk_size_bytes_; }
+  FileSystemHttpCacheStats& stats() { return stats_; }
+  const envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig&
+  config() const {
+    return config_;
+  }
+
+private:
+  // Removes the temporary files of other processes which are no longer running, and of earlier
+  // processes which had the same pid. Must only be called on a file I/O thread.
+  void removeStaleTempFiles();
+
+  const envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig config_;
+  const std::string cache_path_;
+  const uint64_t max_entry_size_bytes_;
+  const uint32_t read_chunk_size_bytes_;
+  FileSystemHttpCacheStats stats_;
+  std::atomic<uint64_t> next_affinity_{};
+  const uint64_t temp_file_tag_;
+  std::atomic<uint64_t> next_temp_id_{};
+  // Declared last so that queued work, which may reference the members above, has run before
+  // they are destroyed.
+  FileIoThreadPool thread_pool_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -9,6 +9,7 @@
 #include "envoy/config/typed_config.h"
 #include "envoy/extensions/filters/http/cache/v3/cache.pb.h"
 #include "envoy/http/header_map.h"
+#include "envoy/server/factory_context.h"
 
 #include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
@@ -359,6 +360,7 @@ public:
 
   virtual ~HttpCache() = default;
 };
+using HttpCacheSharedPtr = std::shared_ptr<HttpCache>;
 
 // Factory interface for cache implementations to implement and register.
 class HttpCacheFactory : public Config::TypedFactory {
@@ -366,10 +368,12 @@ public:
   // From UntypedFactory
   std::string category() const override { return "envoy.http.cache"; }
 
-  // Returns an HttpCache that will remain valid indefinitely (at least as long
-  // as the calling CacheFilter).
-  virtual HttpCache&
-  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& config) PURE;
+  // Returns an HttpCache for the given filter config. Called once per filter config on the main
+  // thread; the returned cache is kept alive for as long as any CacheFilter created from that
+  // config. Implementations may return the same cache for multiple configs.
+  virtual HttpCacheSharedPtr
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) PURE;
   ~HttpCacheFactory() override = default;
 
 private:
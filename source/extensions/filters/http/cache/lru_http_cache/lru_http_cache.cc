@@ -0,0 +1,445 @@
+#include "source/extensions/filters/http/cache/lru_http_cache/lru_http_cache.h"
+
+#include "envoy/extensions/cache/lru_http_cache/v3/config.pb.h"
+#include "envoy/extensions/cache/lru_http_cache/v3/config.pb.validate.h"
+#include "envoy/registry/registry.h"
+#include "envoy/singleton/instance.h"
+#include "envoy/singleton/manager.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/header_map_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+constexpr uint64_t DefaultMaxSizeBytes = 64 * 1024 * 1024;
+constexpr uint32_t DefaultShards = 16;
+
+class LruLookupContext : public LookupContext {
+public:
+  LruLookupContext(LruHttpCache& cache, LookupRequest&& request)
+      : cache_(cache), request_(std::move(request)) {}
+
+  void getHeaders(LookupHeadersCallback&& cb) override {
+    auto entry = cache_.lookup(request_);
+    body_ = std::move(entry.body_);
+    cb(entry.response_headers_ ? request_.makeLookupResult(std::move(entry.response_headers_),
+                                                           std::move(entry.metadata_),
+                                                           body_ ? body_->size() : 0)
+                               : LookupResult{});
+  }
+
+  void getBody(const AdjustedByteRange& range, LookupBodyCallback&& cb) override {
+    ASSERT(body_ != nullptr);
+    ASSERT(range.end() <= body_->length(), "Attempt to read past end of body.");
+    // Reference the cached body rather than copying it. The fragment holds a reference to the body
+    // so that it stays valid even if the entry is evicted before the data is written out.
+    auto fragment = new Buffer::BufferFragmentImpl(
+        body_->data() + range.begin(), range.length(),
+        [body = body_](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+          delete fragment;
+        });
+    auto buffer = std::make_unique<Buffer::OwnedImpl>();
+    buffer->addBufferFragment(*fragment);
+    cb(std::move(buffer));
+  }
+
+  void getTrailers(LookupTrailersCallback&&) override {
+    // TODO(toddmgreer): Support trailers.
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE;
+  }
+
+  const LookupRequest& request() const { return request_; }
+  void onDestroy() override {}
+
+private:
+  LruHttpCache& cache_;
+  const LookupRequest request_;
+  LruHttpCache::BodySharedPtr body_;
+};
+
+class LruInsertContext : public InsertContext {
+public:
+  LruInsertContext(LookupContext& lookup_context, LruHttpCache& cache)
+      : key_(dynamic_cast<LruLookupContext&>(lookup_context).request().key()),
+        request_headers_(
+            dynamic_cast<LruLookupContext&>(lookup_context).request().requestHeaders()),
+        vary_allow_list_(dynamic_cast<LruLookupContext&>(lookup_context).request().varyAllowList()),
+        cache_(cache) {}
+
+  void insertHeaders(const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata, bool end_stream) override {
+    ASSERT(!committed_);
+    response_headers_ = Http::createHeaderMap<Http::ResponseHeaderMapImpl>(response_headers);
+    metadata_ = metadata;
+    if (end_stream) {
+      commit();
+    }
+  }
+
+  void insertBody(const Buffer::Instance& chunk, InsertCallback ready_for_next_chunk,
+                  bool end_stream) override {
+    ASSERT(!committed_);
+    ASSERT(ready_for_next_chunk || end_stream);
+    if (aborted_) {
+      return;
+    }
+
+    if (body_.length() + chunk.length() > cache_.maxEntrySizeBytes()) {
+      // The response can never fit, so stop buffering it.
+      cache_.stats().inserts_too_large_.inc();
+      aborted_ = true;
+      body_.drain(body_.length());
+      if (!end_stream) {
+        ready_for_next_chunk(false);
+      }
+      return;
+    }
+
+    body_.add(chunk);
+    if (end_stream) {
+      commit();
+    } else {
+      ready_for_next_chunk(true);
+    }
+  }
+
+  void insertTrailers(const Http::ResponseTrailerMap&) override {
+    NOT_IMPLEMENTED_GCOVR_EXCL_LINE; // TODO(toddmgreer): support trailers
+  }
+
+  void onDestroy() override {}
+
+private:
+  void commit() {
+    committed_ = true;
+    auto body = std::make_shared<const std::string>(body_.toString());
+    body_.drain(body_.length());
+    if (VaryHeaderUtils::hasVary(*response_headers_)) {
+      cache_.varyInsert(key_, std::move(response_headers_), std::move(metadata_), std::move(body),
+                        request_headers_, vary_allow_list_);
+    } else {
+      cache_.insert(key_, std::move(response_headers_), std::move(metadata_), std::move(body));
+    }
+  }
+
+  Key key_;
+  const Http::RequestHeaderMap& request_headers_;
+  const VaryAllowList& vary_allow_list_;
+  Http::ResponseHeaderMapPtr response_headers_;
+  ResponseMetadata metadata_;
+  LruHttpCache& cache_;
+  Buffer::OwnedImpl body_;
+  bool committed_ = false;
+  bool aborted_ = false;
+};
+
+LruHttpCacheStats
+generateStats(const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config,
+              Stats::Scope& scope) {
+  const std::string prefix = config.stat_prefix().empty()
+                                 ? "http_cache.lru."
+                                 : absl::StrCat("http_cache.lru.", config.stat_prefix(), ".");
+  return {ALL_LRU_HTTP_CACHE_STATS(POOL_COUNTER_PREFIX(scope, prefix),
+                                   POOL_GAUGE_PREFIX(scope, prefix))};
+}
+
+} // namespace
+
+LruHttpCache::LruHttpCache(
+    const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config,
+    Stats::Scope& scope)
+    : shard_budget_bytes_(PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_size_bytes,
+                                                          DefaultMaxSizeBytes) /
+                          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, shards, DefaultShards)),
+      max_entry_size_bytes_(std::min(
+          PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_entry_size_bytes, shard_budget_bytes_),
+          shard_budget_bytes_)),
+      stats_(generateStats(config, scope)) {
+  const uint32_t shards = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, shards, DefaultShards);
+  shards_.reserve(shards);
+  for (uint32_t i = 0; i < shards; ++i) {
+    shards_.emplace_back(std::make_unique<Shard>());
+  }
+}
+
+LookupContextPtr LruHttpCache::makeLookupContext(LookupRequest&& request) {
+  return std::make_unique<LruLookupContext>(*this, std::move(request));
+}
+
+InsertContextPtr LruHttpCache::makeInsertContext(LookupContextPtr&& lookup_context) {
+  ASSERT(lookup_context != nullptr);
+  return std::make_unique<LruInsertContext>(*lookup_context, *this);
+}
+
+void LruHttpCache::updateHeaders(const LookupContext& lookup_context,
+                                 const Http::ResponseHeaderMap& response_headers,
+                                 const ResponseMetadata& metadata) {
+  const auto& lru_lookup_context = static_cast<const LruLookupContext&>(lookup_context);
+  const Key& key = lru_lookup_context.request().key();
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+
+  auto iter = shard.map_.find(&key);
+  if (iter == shard.map_.end() || !iter->second->entry_.response_headers_) {
+    return;
+  }
+  Node& node = *iter->second;
+
+  // TODO(tangsaidi) handle Vary header updates properly
+  if (VaryHeaderUtils::hasVary(*node.entry_.response_headers_)) {
+    return;
+  }
+
+  CacheHeadersUtils::updateStoredHeaders(response_headers, *node.entry_.response_headers_);
+  node.entry_.metadata_ = metadata;
+
+  // The headers may have grown, so re-account for the entry.
+  const uint64_t new_size = entrySize(node.key_, node.entry_);
+  shard.size_bytes_ = shard.size_bytes_ - node.size_bytes_ + new_size;
+  stats_.bytes_resident_.add(new_size);
+  stats_.bytes_resident_.sub(node.size_bytes_);
+  node.size_bytes_ = new_size;
+  shard.lru_.splice(shard.lru_.begin(), shard.lru_, iter->second);
+  evict(shard);
+}
+
+LruHttpCache::Entry LruHttpCache::lookup(const LookupRequest& request) {
+  Entry entry = find(request.key());
+  if (entry.response_headers_ && VaryHeaderUtils::hasVary(*entry.response_headers_)) {
+    entry = varyLookup(request, entry.response_headers_);
+  }
+  if (entry.response_headers_) {
+    stats_.lookup_hits_.inc();
+  } else {
+    stats_.lookup_misses_.inc();
+  }
+  return entry;
+}
+
+void LruHttpCache::insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
+                          ResponseMetadata&& metadata, BodySharedPtr&& body) {
+  store(key, Entry{std::move(response_headers), std::move(metadata), std::move(body)});
+}
+
+LruHttpCache::Entry LruHttpCache::varyLookup(const LookupRequest& request,
+                                             const Http::ResponseHeaderMapPtr& response_headers) {
+  absl::btree_set<absl::string_view> vary_header_values =
+      VaryHeaderUtils::getVaryValues(*response_headers);
+  ASSERT(!vary_header_values.empty());
+
+  Key varied_request_key = request.key();
+  const absl::optional<std::string> vary_identifier = VaryHeaderUtils::createVaryIdentifier(
+      request.varyAllowList(), vary_header_values, request.requestHeaders());
+  if (!vary_identifier.has_value()) {
+    // The vary allow list has changed and has made the vary header of this
+    // cached value not cacheable.
+    return Entry{};
+  }
+  varied_request_key.add_custom_fields(vary_identifier.value());
+
+  return find(varied_request_key);
+}
+
+void LruHttpCache::varyInsert(const Key& request_key, Http::ResponseHeaderMapPtr&& response_headers,
+                              ResponseMetadata&& metadata, BodySharedPtr&& body,
+                              const Http::RequestHeaderMap& request_headers,
+                              const VaryAllowList& vary_allow_list) {
+  absl::btree_set<absl::string_view> vary_header_values =
+      VaryHeaderUtils::getVaryValues(*response_headers);
+  ASSERT(!vary_header_values.empty());
+
+  // Insert the varied response.
+  Key varied_request_key = request_key;
+  const absl::optional<std::string> vary_identifier =
+      VaryHeaderUtils::createVaryIdentifier(vary_allow_list, vary_header_values, request_headers);
+  if (!vary_identifier.has_value()) {
+    // Skip the insert if we are unable to create a vary key.
+    return;
+  }
+  varied_request_key.add_custom_fields(vary_identifier.value());
+
+  // Add a special entry to flag that this request generates varied responses. This is done before
+  // storing the variant, as vary_header_values refers into response_headers. Re-inserting the
+  // marker also refreshes its recency, so it outlives the variants that depend on it.
+  Http::ResponseHeaderMapPtr vary_only_map =
+      Http::createHeaderMap<Http::ResponseHeaderMapImpl>({});
+  vary_only_map->setCopy(Http::CustomHeaders::get().Vary, absl::StrJoin(vary_header_values, ","));
+  store(request_key, Entry{std::move(vary_only_map), {}, nullptr});
+
+  store(varied_request_key,
+        Entry{std::move(response_headers), std::move(metadata), std::move(body)});
+}
+
+constexpr absl::string_view Name = "envoy.extensions.http.cache.lru";
+
+CacheInfo LruHttpCache::cacheInfo() const {
+  CacheInfo cache_info;
+  cache_info.name_ = Name;
+  return cache_info;
+}
+
+uint64_t LruHttpCache::entrySize(const Key& key, const Entry& entry) {
+  return key.ByteSizeLong() + entry.response_headers_->byteSize() +
+         (entry.body_ ? entry.body_->size() : 0);
+}
+
+LruHttpCache::Shard& LruHttpCache::shardFor(const Key& key) {
+  return *shards_[MessageUtil::hash(key) % shards_.size()];
+}
+
+LruHttpCache::Entry LruHttpCache::find(const Key& key) {
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+  auto iter = shard.map_.find(&key);
+  if (iter == shard.map_.end()) {
+    return Entry{};
+  }
+  shard.lru_.splice(shard.lru_.begin(), shard.lru_, iter->second);
+  const Entry& entry = iter->second->entry_;
+  ASSERT(entry.response_headers_);
+  return Entry{Http::createHeaderMap<Http::ResponseHeaderMapImpl>(*entry.response_headers_),
+               entry.metadata_, entry.body_};
+}
+
+void LruHttpCache::store(const Key& key, Entry&& entry) {
+  const uint64_t size = entrySize(key, entry);
+  if (size > max_entry_size_bytes_) {
+    stats_.inserts_too_large_.inc();
+    return;
+  }
+
+  Shard& shard = shardFor(key);
+  absl::MutexLock lock(&shard.mutex_);
+  auto iter = shard.map_.find(&key);
+  if (iter != shard.map_.end()) {
+    // Replace the existing entry in place. The map key points at the node's key, which is
+    // unchanged.
+    Node& node = *iter->second;
+    shard.size_bytes_ -= node.size_bytes_;
+    stats_.bytes_resident_.sub(node.size_bytes_);
+    node.entry_ = std::move(entry);
+    node.size_bytes_ = size;
+    shard.lru_.splice(shard.lru_.begin(), shard.lru_, iter->second);
+  } else {
+    shard.lru_.push_front(Node{key, std::move(entry), size});
+    shard.map_.emplace(&shard.lru_.front().key_, shard.lru_.begin());
+    stats_.entries_.inc();
+  }
+  shard.size_bytes_ += size;
+  stats_.bytes_resident_.add(size);
+  stats_.inserts_.inc();
+  evict(shard);
+}
+
+void LruHttpCache::evict(Shard& shard) {
+  // The most recently used entry is never evicted, as store() has already checked that it fits.
+  while (shard.size_bytes_ > shard_budget_bytes_ && shard.lru_.size() > 1) {
+    Node& victim = shard.lru_.back();
+    shard.map_.erase(&victim.key_);
+    shard.size_bytes_ -= victim.size_bytes_;
+    stats_.bytes_resident_.sub(victim.size_bytes_);
+    stats_.entries_.dec();
+    stats_.evictions_.inc();
+    shard.lru_.pop_back();
+  }
+}
+
+SINGLETON_MANAGER_REGISTRATION(lru_http_cache_singleton);
+
+// Shares one cache between all the cache filter configs with the same settings, so that their
+// max_size_bytes bounds the memory of all of them together, and so that the cached responses
+// survive listener updates. Each cache holds the singleton, and is destroyed once no filter config
+// uses it.
+class LruHttpCacheSingleton : public Singleton::Instance,
+                              public std::enable_shared_from_this<LruHttpCacheSingleton> {
+public:
+  HttpCacheSharedPtr
+  get(const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config,
+      Server::Configuration::FactoryContext& context) {
+    // Forget the caches which were destroyed.
+    for (auto it = caches_.begin(); it != caches_.end();) {
+      if (it->second.expired()) {
+        caches_.erase(it++);
+      } else {
+        ++it;
+      }
+    }
+    std::weak_ptr<LruHttpCache>& weak_cache = caches_[config];
+    std::shared_ptr<LruHttpCache> cache = weak_cache.lock();
+    if (cache == nullptr) {
+      // The cache outlives the listener of the filter config creating it, hence the server scope.
+      auto holder =
+          std::make_shared<CacheHolder>(shared_from_this(), config, context.serverScope());
+      cache = {holder, &holder->cache_};
+      weak_cache = cache;
+    }
+    return cache;
+  }
+
+private:
+  struct CacheHolder {
+    CacheHolder(std::shared_ptr<LruHttpCacheSingleton> singleton,
+                const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config,
+                Stats::Scope& scope)
+        : singleton_(std::move(singleton)), cache_(config, scope) {}
+
+    const std::shared_ptr<LruHttpCacheSingleton> singleton_;
+    LruHttpCache cache_;
+  };
+
+  // ConfigHash and ConfigEqualTo allow the config proto to be used as a flat_hash_map key.
+  struct ConfigHash {
+    size_t operator()(
+        const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config) const {
+      return MessageUtil::hash(config);
+    }
+  };
+  struct ConfigEqualTo {
+    bool
+    operator()(const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& lhs,
+               const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& rhs) const {
+      return Protobuf::util::MessageDifferencer::Equals(lhs, rhs);
+    }
+  };
+
+  absl::flat_hash_map<envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig,
+                      std::weak_ptr<LruHttpCache>, ConfigHash, ConfigEqualTo>
+      caches_;
+};
+
+class LruHttpCacheFactory : public HttpCacheFactory {
+public:
+  // From UntypedFactory
+  std::string name() const override { return std::string(Name); }
+  // From TypedFactory
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override {
+    return std::make_unique<envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig>();
+  }
+  // From HttpCacheFactory
+  HttpCacheSharedPtr
+  getCache(const envoy::extensions::filters::http::cache::v3::CacheConfig& config,
+           Server::Configuration::FactoryContext& context) override {
+    envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig lru_config;
+    MessageUtil::unpackTo(config.typed_config(), lru_config);
+    MessageUtil::validate(lru_config, context.messageValidationVisitor());
+    return context.singletonManager()
+        .getTyped<LruHttpCacheSingleton>(
+            SINGLETON_MANAGER_REGISTERED_NAME(lru_http_cache_singleton),
+            [] { return std::make_shared<LruHttpCacheSingleton>(); })
+        ->get(lru_config, context);
+  }
+};
+
+static Registry::RegisterFactory<LruHttpCacheFactory, HttpCacheFactory> register_;
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "envoy/extensions/cache/lru_http_cache/v3/config.pb.h"
+#include "envoy/stats/scope.h"
+#include "envoy/stats/stats_macros.h"
+
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/filters/http/cache/http_cache.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+
+/**
+ * All stats for the LRU HTTP cache. @see stats_macros.h
+ * The hit ratio is lookup_hits / (lookup_hits + lookup_misses).
+ */
+#define ALL_LRU_HTTP_CACHE_STATS(COUNTER, GAUGE)                                                   \
+  COUNTER(evictions)                                                                               \
+  COUNTER(inserts)                                                                                 \
+  COUNTER(inserts_too_large)                                                                       \
+  COUNTER(lookup_hits)                                                                             \
+  COUNTER(lookup_misses)                                                                           \
+  GAUGE(bytes_resident, Accumulate)                                                                \
+  GAUGE(entries, Accumulate)
+
+/**
+ * Struct definition for all LRU HTTP cache stats. @see stats_macros.h
+ */
+struct LruHttpCacheStats {
+  ALL_LRU_HTTP_CACHE_STATS(GENERATE_COUNTER_STRUCT, GENERATE_GAUGE_STRUCT)
+};
+
+// Bounded in-memory cache backend. Entries are spread across N shards by key hash, each with its
+// own lock, byte budget and LRU list, so that concurrent lookups from different workers rarely
+// contend. Bodies are immutable once inserted and are shared with lookups by reference, so serving
+// a hit never copies the body.
+class LruHttpCache : public HttpCache {
+public:
+  // The body of a cached response. Shared between the cache and in-flight lookups so that an
+  // eviction while a response is being served doesn't invalidate it.
+  using BodySharedPtr = std::shared_ptr<const std::string>;
+
+  struct Entry {
+    Http::ResponseHeaderMapPtr response_headers_;
+    ResponseMetadata metadata_;
+    BodySharedPtr body_;
+  };
+
+  LruHttpCache(const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config,
+               Stats::Scope& scope);
+
+  // HttpCache
+  LookupContextPtr makeLookupContext(LookupRequest&& request) override;
+  InsertContextPtr makeInsertContext(LookupContextPtr&& lookup_context) override;
+  void updateHeaders(const LookupContext& lookup_context,
+                     const Http::ResponseHeaderMap& response_headers,
+                     const ResponseMetadata& metadata) override;
+  CacheInfo cacheInfo() const override;
+
+  Entry lookup(const LookupRequest& request);
+  void insert(const Key& key, Http::ResponseHeaderMapPtr&& response_headers,
+              ResponseMetadata&& metadata, BodySharedPtr&& body);
+
+  // Inserts a response that has been varied on certain headers.
+  void varyInsert(const Key& request_key, Http::ResponseHeaderMapPtr&& response_headers,
+                  ResponseMetadata&& metadata, BodySharedPtr&& body,
+                  const Http::RequestHeaderMap& request_headers,
+                  const VaryAllowList& vary_allow_list);
+
+  uint32_t shardCount() const { return shards_.size(); }
+  uint64_t maxEntrySizeBytes() const { return max_entry_size_bytes_; }
+  const LruHttpCacheStats& stats() const { return stats_; }
+
+private:
+  struct Node {
+    Key key_;
+    Entry entry_;
+    uint64_t size_bytes_;
+  };
+  using LruList = std::list<Node>;
+
+  // The map is keyed by a pointer into the owning list node, so that each key is only stored once.
+  struct KeyPtrHash {
+    size_t operator()(const Key* key) const { return MessageUtil::hash(*key); }
+  };
+  struct KeyPtrEq {
+    bool operator()(const Key* lhs, const Key* rhs) const { return MessageUtil()(*lhs, *rhs); }
+  };
+
+  struct Shard {
+    absl::Mutex mutex_;
+    // Most recently used entries are at the front.
+    LruList lru_ ABSL_GUARDED_BY(mutex_);
+    absl::flat_hash_map<const Key*, LruList::iterator, KeyPtrHash, KeyPtrEq>
+        map_ ABSL_GUARDED_BY(mutex_);
+    uint64_t size_bytes_ ABSL_GUARDED_BY(mutex_){};
+  };
+
+  static uint64_t entrySize(const Key& key, const Entry& entry);
+
+  Shard& shardFor(const Key& key);
+
+  // Returns a copy of the entry for key, refreshing its recency, or an empty entry on miss.
+  Entry find(const Key& key);
+
+  // Looks for a response that has been varied. Only called from lookup.
+  Entry varyLookup(const LookupRequest& request,
+                   const Http::ResponseHeaderMapPtr& response_headers);
+
+  void store(const Key& key, Entry&& entry);
+
+  // Evicts entries from the tail of the shard until it fits into its budget.
+  void evict(Shard& shard) ABSL_EXCLUSIVE_LOCKS_REQUIRED(shard.mutex_);
+
+  const uint64_t shard_budget_bytes_;
+  const uint64_t max_entry_size_bytes_;
+  LruHttpCacheStats stats_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
+
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
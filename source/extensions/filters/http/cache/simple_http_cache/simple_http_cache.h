@@ -28,12 +28,6 @@ private:
   Entry varyLookup(const LookupRequest& request,
                    const Http::ResponseHeaderMapPtr& response_headers);
 
-  // A list of headers that we do not want to update upon validation
-  // We skip these headers because either it's updated by other application logic
-  // or they are fall into categories defined in the IETF doc below
-  // https://www.ietf.org/archive/id/draft-ietf-httpbis-cache-18.html s3.2
-  static const absl::flat_hash_set<Http::LowerCaseString> headersNotToUpdate();
-
 public:
   // HttpCache
   LookupContextPtr makeLookupContext(LookupRequest&& request) override;
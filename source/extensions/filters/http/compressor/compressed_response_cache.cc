@@ -0,0 +1,73 @@
+#include "source/extensions/filters/http/compressor/compressed_response_cache.h"
+
+#include "source/common/buffer/buffer_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Compressor {
+
+CompressedResponseCache::CompressedResponseCache(uint64_t max_size_bytes,
+                                                 uint64_t max_entry_size_bytes)
+    : max_size_bytes_(max_size_bytes), max_entry_size_bytes_(max_entry_size_bytes) {}
+
+void CompressedResponseCache::addBody(const EntryConstSharedPtr& entry, Buffer::Instance& buffer) {
+  // The fragment holds a reference to the entry, so that the body stays valid until it was written
+  // out even if the entry is evicted meanwhile.
+  auto fragment = new Buffer::BufferFragmentImpl(
+      entry->body_.data(), entry->body_.size(),
+      [entry](const void*, size_t, const Buffer::BufferFragmentImpl* fragment) {
+        delete fragment;
+      });
+  buffer.addBufferFragment(*fragment);
+}
+
+CompressedResponseCache::EntryConstSharedPtr
+CompressedResponseCache::lookup(const std::string& key) {
+  absl::MutexLock lock(&mutex_);
+  auto iter = map_.find(key);
+  if (iter == map_.end()) {
+    return nullptr;
+  }
+  lru_.splice(lru_.begin(), lru_, iter->second);
+  return iter->second->entry_;
+}
+
+uint32_t CompressedResponseCache::insert(const std::string& key, EntryConstSharedPtr&& entry) {
+  ASSERT(entry != nullptr);
+  absl::MutexLock lock(&mutex_);
+  auto iter = map_.find(key);
+  if (iter != map_.end()) {
+    // Replace the existing entry in place. The map key points at the node's key, which is
+    // unchanged.
+    Node& node = *iter->second;
+    size_bytes_ -= nodeSize(node);
+    node.entry_ = std::move(entry);
+    lru_.splice(lru_.begin(), lru_, iter->second);
+  } else {
+    lru_.push_front(Node{key, std::move(entry)});
+    map_.emplace(lru_.front().key_, lru_.begin());
+  }
+  size_bytes_ += nodeSize(lru_.front());
+
+  // The most recently used entry is never evicted, its size is bounded by max_entry_size_bytes_.
+  uint32_t evicted = 0;
+  while (size_bytes_ > max_size_bytes_ && lru_.size() > 1) {
+    const Node& victim = lru_.back();
+    map_.erase(victim.key_);
+    size_bytes_ -= nodeSize(victim);
+    lru_.pop_back();
+    ++evicted;
+  }
+  return evicted;
+}
+
+uint64_t CompressedResponseCache::sizeBytes() const {
+  absl::MutexLock lock(&mutex_);
+  return size_bytes_;
+}
+
+} // namespace Compressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <string>
+
+#include "envoy/buffer/buffer.h"
+
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/synchronization/mutex.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Compressor {
+
+/**
+ * Bounded LRU cache of compressed response bodies, shared by all workers of a compressor filter
+ * config. Entries are immutable once inserted and are shared with the streams serving them, so that
+ * a hit never copies the body and an eviction doesn't invalidate a body being served.
+ */
+class CompressedResponseCache {
+public:
+  struct Entry {
+    Entry(std::string&& body, uint64_t uncompressed_length)
+        : body_(std::move(body)), uncompressed_length_(uncompressed_length) {}
+
+    const std::string body_;
+    // The length of the upstream response body the entry was compressed from.
+    const uint64_t uncompressed_length_;
+  };
+  using EntryConstSharedPtr = std::shared_ptr<const Entry>;
+
+  CompressedResponseCache(uint64_t max_size_bytes, uint64_t max_entry_size_bytes);
+
+  /**
+   * Adds the compressed body of an entry to a buffer without copying it.
+   */
+  static void addBody(const EntryConstSharedPtr& entry, Buffer::Instance& buffer);
+
+  /**
+   * @return the entry for the key, or nullptr on miss.
+   */
+  EntryConstSharedPtr lookup(const std::string& key);
+
+  /**
+   * Inserts or replaces the entry for the key, evicting the least recently used entries to stay
+   * within the size limit.
+   * @return the number of evicted entries.
+   */
+  uint32_t insert(const std::string& key, EntryConstSharedPtr&& entry);
+
+  uint64_t maxEntrySizeBytes() const { return max_entry_size_bytes_; }
+  uint64_t sizeBytes() const;
+
+private:
+  struct Node {
+    std::string key_;
+    EntryConstSharedPtr entry_;
+  };
+  using LruList = std::list<Node>;
+
+  static uint64_t nodeSize(const Node& node) {
+    return node.key_.size() + node.entry_->body_.size();
+  }
+
+  const uint64_t max_size_bytes_;
+  const uint64_t max_entry_size_bytes_;
+  mutable absl::Mutex mutex_;
+  // Most recently used entries are at the front.
+  LruList lru_ ABSL_GUARDED_BY(mutex_);
+  absl::flat_hash_map<absl::string_view, LruList::iterator> map_ ABSL_GUARDED_BY(mutex_);
+  uint64_t size_bytes_ ABSL_GUARDED_BY(mutex_){};
+};
+using CompressedResponseCachePtr = std::unique_ptr<CompressedResponseCache>;
+
+} // namespace Compressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
@@ -1,9 +1,15 @@
 #include "source/extensions/filters/http/compressor/compressor_filter.h"
 
+#include "envoy/http/codes.h"
+
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/enum_to_int.h"
 #include "source/common/http/header_map_impl.h"
 #include "source/common/http/utility.h"
 
+#include "absl/strings/match.h"
+#include "absl/strings/str_join.h"
+
 namespace Envoy {
 namespace Extensions {
 namespace HttpFilters {
@@ -28,6 +34,9 @@ Http::RegisterCustomInlineHeader<Http::CustomInlineHeaderRegistry::Type::Respons
 // Default minimum length of an upstream response that allows compression.
 const uint64_t DefaultMinimumContentLength = 30;
 
+// Default maximum size of a compressed response body in the compressed response cache.
+const uint64_t DefaultMaxCompressedResponseSize = 1024 * 1024;
+
 // Default content types will be used if any is provided by the user.
 const std::vector<std::string>& defaultContentEncoding() {
   CONSTRUCT_ON_FIRST_USE(
@@ -113,7 +122,23 @@ CompressorFilterConfig::ResponseDirectionConfig::ResponseDirectionConfig(
           proto_config.has_response_direction_config()
               ? proto_config.response_direction_config().remove_accept_encoding_header()
               : proto_config.remove_accept_encoding_header()),
-      response_stats_{generateResponseStats(stats_prefix, scope)} {}
+      allow_precompressed_upstream_response_(
+          remove_accept_encoding_header_ &&
+          proto_config.response_direction_config().allow_precompressed_upstream_response()),
+      response_stats_{generateResponseStats(stats_prefix, scope)},
+      compressed_response_cache_(compressedResponseCache(proto_config)) {}
+
+CompressedResponseCachePtr CompressorFilterConfig::ResponseDirectionConfig::compressedResponseCache(
+    const envoy::extensions::filters::http::compressor::v3::Compressor& proto_config) {
+  if (!proto_config.response_direction_config().has_compressed_response_cache()) {
+    return nullptr;
+  }
+  const auto& cache_config = proto_config.response_direction_config().compressed_response_cache();
+  return std::make_unique<CompressedResponseCache>(
+      cache_config.max_size_bytes(),
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(cache_config, max_entry_size_bytes,
+                                      DefaultMaxCompressedResponseSize));
+}
 
 const envoy::extensions::filters::http::compressor::v3::Compressor::CommonDirectionConfig
 CompressorFilterConfig::ResponseDirectionConfig::commonConfig(
@@ -160,7 +185,19 @@ Http::FilterHeadersStatus CompressorFilter::decodeHeaders(Http::RequestHeaderMap
 
   const auto& response_config = config_->responseDirectionConfig();
   if (response_config.compressionEnabled() && response_config.removeAcceptEncodingHeader()) {
-    headers.removeInline(accept_encoding_handle.handle());
+    if (response_config.allowPrecompressedUpstreamResponse() && accept_encoding_ != nullptr) {
+      restrictAcceptEncodingHeader(headers);
+    } else {
+      headers.removeInline(accept_encoding_handle.handle());
+    }
+  }
+
+  // Only the responses to GET requests are cached, as the responses to other methods may depend
+  // on the request body.
+  if (response_config.compressedResponseCache() != nullptr && headers.Host() != nullptr &&
+      headers.Path() != nullptr &&
+      headers.getMethodValue() == Http::Headers::get().MethodValues.Get) {
+    cache_key_ = absl::StrCat(headers.getHostValue(), "\n", headers.getPathValue());
   }
 
   const auto& request_config = config_->requestDirectionConfig();
@@ -237,16 +274,24 @@ Http::FilterHeadersStatus CompressorFilter::encodeHeaders(Http::ResponseHeaderMa
       isEtagAllowed(headers) && !headers.getInline(response_content_encoding_handle.handle());
   if (!end_stream && isEnabledAndContentLengthBigEnough && isAcceptEncodingAllowed(headers) &&
       isCompressible && isTransferEncodingAllowed(headers)) {
+    lookupCompressedResponse(headers);
     sanitizeEtagHeader(headers);
     headers.removeContentLength();
     headers.setInline(response_content_encoding_handle.handle(), config_->contentEncoding());
     config.stats().compressed_.inc();
-    // Finally instantiate the compressor.
-    response_compressor_ = config_->makeCompressor();
+    // Finally instantiate the compressor, unless the compressed body is served from the cache.
+    if (cached_response_ == nullptr) {
+      response_compressor_ = config_->makeCompressor();
+    }
   } else {
     config.stats().not_compressed_.inc();
   }
 
+  if (isPrecompressedResponse(headers)) {
+    config.responseStats().precompressed_upstream_response_.inc();
+    insertVaryHeader(headers);
+  }
+
   // Even if we decided not to compress due to incompatible Accept-Encoding value,
   // the Vary header would need to be inserted to let a caching proxy in front of Envoy
   // know that the requested resource still can be served with compression applied.
@@ -258,26 +303,103 @@ Http::FilterHeadersStatus CompressorFilter::encodeHeaders(Http::ResponseHeaderMa
 }
 
 Http::FilterDataStatus CompressorFilter::encodeData(Buffer::Instance& data, bool end_stream) {
-  if (response_compressor_ != nullptr) {
+  if (cached_response_ != nullptr) {
+    serveCompressedResponse(data);
+  } else if (response_compressor_ != nullptr) {
+    const uint64_t uncompressed_length = data.length();
     compressAndUpdateStats(response_compressor_, config_->responseDirectionConfig().stats(), data,
                            end_stream);
+    if (cache_insert_buffer_ != nullptr) {
+      recordCompressedResponse(data, uncompressed_length, end_stream);
+    }
   }
   return Http::FilterDataStatus::Continue;
 }
 
 Http::FilterTrailersStatus CompressorFilter::encodeTrailers(Http::ResponseTrailerMap&) {
-  if (response_compressor_ != nullptr) {
+  if (cached_response_ != nullptr) {
+    if (!cached_response_added_) {
+      Buffer::OwnedImpl buffer;
+      serveCompressedResponse(buffer);
+      encoder_callbacks_->addEncodedData(buffer, true);
+    }
+  } else if (response_compressor_ != nullptr) {
     Buffer::OwnedImpl empty_buffer;
     // The presence of trailers means the stream is ended, but encodeData()
     // is never called with end_stream=true, thus let the compression library know
     // that the stream is ended.
     compressAndUpdateStats(response_compressor_, config_->responseDirectionConfig().stats(),
                            empty_buffer, true);
+    if (cache_insert_buffer_ != nullptr) {
+      recordCompressedResponse(empty_buffer, 0, true);
+    }
     encoder_callbacks_->addEncodedData(empty_buffer, true);
   }
   return Http::FilterTrailersStatus::Continue;
 }
 
+void CompressorFilter::lookupCompressedResponse(const Http::ResponseHeaderMap& headers) {
+  CompressedResponseCache* cache = config_->responseDirectionConfig().compressedResponseCache();
+  if (cache == nullptr || cache_key_.empty()) {
+    return;
+  }
+  // Only complete responses with a strong etag are guaranteed to have byte-identical bodies.
+  const Http::HeaderEntry* etag = headers.getInline(etag_handle.handle());
+  if (etag == nullptr || absl::StartsWithIgnoreCase(etag->value().getStringView(), "W/") ||
+      Http::Utility::getResponseStatusNoThrow(headers) != enumToInt(Http::Code::OK)) {
+    cache_key_.clear();
+    return;
+  }
+  absl::StrAppend(&cache_key_, "\n", etag->value().getStringView());
+
+  const ResponseCompressorStats& stats = config_->responseDirectionConfig().responseStats();
+  CompressedResponseCache::EntryConstSharedPtr entry = cache->lookup(cache_key_);
+  uint64_t content_length;
+  if (entry != nullptr &&
+      (headers.ContentLength() == nullptr ||
+       (absl::SimpleAtoi(headers.getContentLengthValue(), &content_length) &&
+        content_length == entry->uncompressed_length_))) {
+    stats.compressed_response_cache_hit_.inc();
+    cached_response_ = std::move(entry);
+    return;
+  }
+  stats.compressed_response_cache_miss_.inc();
+  cache_insert_buffer_ = std::make_unique<Buffer::OwnedImpl>();
+}
+
+void CompressorFilter::serveCompressedResponse(Buffer::Instance& data) {
+  // The upstream response body is replaced by the cached compressed body, which is sent along with
+  // the first data frame.
+  const CompressorStats& stats = config_->responseDirectionConfig().stats();
+  stats.total_uncompressed_bytes_.add(data.length());
+  data.drain(data.length());
+  if (!cached_response_added_) {
+    cached_response_added_ = true;
+    CompressedResponseCache::addBody(cached_response_, data);
+    stats.total_compressed_bytes_.add(data.length());
+  }
+}
+
+void CompressorFilter::recordCompressedResponse(const Buffer::Instance& data,
+                                                uint64_t uncompressed_length, bool end_stream) {
+  CompressedResponseCache& cache = *config_->responseDirectionConfig().compressedResponseCache();
+  cache_insert_uncompressed_length_ += uncompressed_length;
+  if (cache_insert_buffer_->length() + data.length() > cache.maxEntrySizeBytes()) {
+    cache_insert_buffer_.reset();
+    return;
+  }
+  cache_insert_buffer_->add(data);
+  if (end_stream) {
+    const uint32_t evicted =
+        cache.insert(cache_key_, std::make_shared<const CompressedResponseCache::Entry>(
+                                     cache_insert_buffer_->toString(),
+                                     cache_insert_uncompressed_length_));
+    config_->responseDirectionConfig().responseStats().compressed_response_cache_evicted_.add(
+        evicted);
+    cache_insert_buffer_.reset();
+  }
+}
+
 bool CompressorFilter::hasCacheControlNoTransform(Http::ResponseHeaderMap& headers) const {
   const Http::HeaderEntry* cache_control = headers.getInline(cache_control_handle.handle());
   if (cache_control) {
@@ -541,6 +663,44 @@ bool CompressorFilter::isTransferEncodingAllowed(Http::RequestOrResponseHeaderMa
   return true;
 }
 
+// Keeps the tokens of the request's Accept-Encoding header whose encoding is provided by any of the
+// compressor filters in the chain, so that the upstream may respond with a pre-compressed variant
+// of the resource the filters could have produced as well, but not with any other encoding.
+void CompressorFilter::restrictAcceptEncodingHeader(Http::RequestHeaderMap& headers) const {
+  const auto& filter_configs = decoder_callbacks_->streamInfo()
+                                   .filterState()
+                                   ->getDataReadOnly<CompressorRegistry>(compressorRegistryKey())
+                                   .filter_configs_;
+  std::vector<absl::string_view> tokens;
+  for (const auto& token : StringUtil::splitToken(*accept_encoding_, ",", false /* keep_empty */)) {
+    const absl::string_view encoding = StringUtil::trim(StringUtil::cropRight(token, ";"));
+    for (const auto& filter_config : filter_configs) {
+      if (absl::EqualsIgnoreCase(encoding, filter_config->contentEncoding())) {
+        tokens.push_back(StringUtil::trim(token));
+        break;
+      }
+    }
+  }
+
+  if (tokens.empty()) {
+    headers.removeInline(accept_encoding_handle.handle());
+  } else {
+    headers.setInline(accept_encoding_handle.handle(), absl::StrJoin(tokens, ", "));
+  }
+}
+
+bool CompressorFilter::isPrecompressedResponse(const Http::ResponseHeaderMap& headers) const {
+  if (!config_->responseDirectionConfig().allowPrecompressedUpstreamResponse() ||
+      response_compressor_ != nullptr || cached_response_ != nullptr) {
+    return false;
+  }
+  const Http::HeaderEntry* content_encoding =
+      headers.getInline(response_content_encoding_handle.handle());
+  return content_encoding != nullptr &&
+         absl::EqualsIgnoreCase(StringUtil::trim(content_encoding->value().getStringView()),
+                                config_->contentEncoding());
+}
+
 void CompressorFilter::insertVaryHeader(Http::ResponseHeaderMap& headers) {
   const Http::HeaderEntry* vary = headers.getInline(vary_handle.handle());
   if (vary != nullptr) {
@@ -7,6 +7,7 @@
 #include "source/common/protobuf/protobuf.h"
 #include "source/common/runtime/runtime_protos.h"
 #include "source/extensions/filters/http/common/pass_through_filter.h"
+#include "source/extensions/filters/http/compressor/compressed_response_cache.h"
 
 namespace Envoy {
 namespace Extensions {
@@ -37,6 +38,12 @@ namespace Compressor {
  *
  * "header_gzip" is specific to the gzip filter and is deprecated since it duplicates
  * "header_compressor_used".
+ *
+ * "compressed_response_cache_hit" and "compressed_response_cache_miss" count the compressed
+ * responses that were, respectively were not, served from the compressed response cache.
+ *
+ * "precompressed_upstream_response" is a number of responses the upstream already encoded with the
+ * encoding provided by this filter instance.
  */
 #define RESPONSE_COMPRESSOR_STATS(COUNTER)                                                         \
   COUNTER(no_accept_header)                                                                        \
@@ -45,7 +52,11 @@ namespace Compressor {
   COUNTER(header_compressor_overshadowed)                                                          \
   COUNTER(header_wildcard)                                                                         \
   COUNTER(header_not_valid)                                                                        \
-  COUNTER(not_compressed_etag)
+  COUNTER(not_compressed_etag)                                                                     \
+  COUNTER(compressed_response_cache_hit)                                                           \
+  COUNTER(compressed_response_cache_miss)                                                          \
+  COUNTER(compressed_response_cache_evicted)                                                       \
+  COUNTER(precompressed_upstream_response)
 
 /**
  * Struct definitions for compressor stats. @see stats_macros.h
@@ -119,6 +130,13 @@ public:
     const ResponseCompressorStats& responseStats() const { return response_stats_; }
     bool disableOnEtagHeader() const { return disable_on_etag_header_; }
     bool removeAcceptEncodingHeader() const { return remove_accept_encoding_header_; }
+    bool allowPrecompressedUpstreamResponse() const {
+      return allow_precompressed_upstream_response_;
+    }
+    // Returns nullptr if no compressed response cache is configured.
+    CompressedResponseCache* compressedResponseCache() const {
+      return compressed_response_cache_.get();
+    }
 
   private:
     static ResponseCompressorStats generateResponseStats(const std::string& prefix,
@@ -131,9 +149,14 @@ public:
     static const envoy::extensions::filters::http::compressor::v3::Compressor::CommonDirectionConfig
     commonConfig(const envoy::extensions::filters::http::compressor::v3::Compressor&);
 
+    static CompressedResponseCachePtr compressedResponseCache(
+        const envoy::extensions::filters::http::compressor::v3::Compressor& proto_config);
+
     const bool disable_on_etag_header_;
     const bool remove_accept_encoding_header_;
+    const bool allow_precompressed_upstream_response_;
     const ResponseCompressorStats response_stats_;
+    const CompressedResponseCachePtr compressed_response_cache_;
   };
 
   CompressorFilterConfig() = delete;
@@ -186,6 +209,13 @@ private:
 
   void sanitizeEtagHeader(Http::ResponseHeaderMap& headers);
   void insertVaryHeader(Http::ResponseHeaderMap& headers);
+  void restrictAcceptEncodingHeader(Http::RequestHeaderMap& headers) const;
+  bool isPrecompressedResponse(const Http::ResponseHeaderMap& headers) const;
+
+  void lookupCompressedResponse(const Http::ResponseHeaderMap& headers);
+  void serveCompressedResponse(Buffer::Instance& data);
+  void recordCompressedResponse(const Buffer::Instance& data, uint64_t uncompressed_length,
+                                bool end_stream);
 
   class EncodingDecision : public StreamInfo::FilterState::Object {
   public:
@@ -207,6 +237,16 @@ private:
   Envoy::Compression::Compressor::CompressorPtr request_compressor_;
   const CompressorFilterConfigSharedPtr config_;
   std::unique_ptr<std::string> accept_encoding_;
+
+  // The key of the response in the compressed response cache. Empty if the response isn't
+  // cacheable.
+  std::string cache_key_;
+  // The cached compressed response served instead of the upstream response body on a hit.
+  CompressedResponseCache::EntryConstSharedPtr cached_response_;
+  bool cached_response_added_{};
+  // The compressed response body recorded on a miss for insertion into the cache.
+  std::unique_ptr<Buffer::OwnedImpl> cache_insert_buffer_;
+  uint64_t cache_insert_uncompressed_length_{};
 };
 
 } // namespace Compressor
@@ -125,6 +125,7 @@ public:
 
   // Http::FilterChainFactory
   void createFilterChain(Http::FilterChainFactoryCallbacks& callbacks) override;
+  uint32_t filterChainLengthHint() const override { return filter_factories_.size(); }
   using FilterFactoriesList = std::list<Filter::FilterConfigProviderPtr>;
   struct FilterConfig {
     std::unique_ptr<FilterFactoriesList> filter_factories;
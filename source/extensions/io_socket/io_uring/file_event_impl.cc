@@ -0,0 +1,62 @@
+#include "source/extensions/io_socket/io_uring/file_event_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+FileEventImpl::FileEventImpl(Event::Dispatcher& dispatcher, Event::FileReadyCb cb, uint32_t events,
+                             const ReadinessSource& source)
+    : schedulable_(dispatcher.createSchedulableCallback([this, cb]() {
+        const uint32_t ephemeral_events = std::exchange(ephemeral_events_, 0);
+        ENVOY_LOG(trace, "io_uring event {} invokes callbacks on events = {}",
+                  static_cast<void*>(this), ephemeral_events);
+        cb(ephemeral_events);
+      })),
+      source_(source) {
+  setEnabled(events);
+}
+
+void FileEventImpl::activate(uint32_t events) {
+  // Only supported event types are set.
+  ASSERT((events & (Event::FileReadyType::Read | Event::FileReadyType::Write |
+                    Event::FileReadyType::Closed)) == events);
+  ephemeral_events_ |= events;
+  schedulable_->scheduleCallbackNextIteration();
+}
+
+void FileEventImpl::setEnabled(uint32_t events) {
+  ASSERT((events & (Event::FileReadyType::Read | Event::FileReadyType::Write |
+                    Event::FileReadyType::Closed)) == events);
+  // Align with Event::FileEventImpl. Clear pending events on updates to the fd event mask to avoid
+  // delivering events that are no longer relevant.
+  ephemeral_events_ = 0;
+  enabled_events_ = events;
+  uint32_t events_to_notify = 0;
+  if ((events & Event::FileReadyType::Read) && source_.isReadable()) {
+    events_to_notify |= Event::FileReadyType::Read;
+  }
+  if ((events & Event::FileReadyType::Write) && source_.isWritable()) {
+    events_to_notify |= Event::FileReadyType::Write;
+  }
+  if ((events & Event::FileReadyType::Closed) && source_.isPeerShutDownWrite()) {
+    events_to_notify |= Event::FileReadyType::Closed;
+  }
+  if (events_to_notify != 0) {
+    activate(events_to_notify);
+  } else {
+    schedulable_->cancel();
+  }
+}
+
+void FileEventImpl::activateIfEnabled(uint32_t events) {
+  const uint32_t filtered_events = events & enabled_events_;
+  if (filtered_events != 0) {
+    activate(filtered_events);
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
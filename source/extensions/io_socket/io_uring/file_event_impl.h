@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+
+#include "source/common/common/assert.h"
+#include "source/common/common/logger.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Supplies the readiness of a socket driven by io_uring completions.
+ */
+class ReadinessSource {
+public:
+  virtual ~ReadinessSource() = default;
+
+  // Whether data, an accepted connection or an error is waiting to be consumed.
+  virtual bool isReadable() const PURE;
+  // Whether a write would be accepted.
+  virtual bool isWritable() const PURE;
+  // Whether the peer closed its write side.
+  virtual bool isPeerShutDownWrite() const PURE;
+};
+
+// A FileEvent implementation which delivers the events of an io_uring driven socket. The socket
+// doesn't become ready in the kernel's eyes since the data was already received by the ring, so
+// events are activated by the socket as completions arrive rather than by polling the fd.
+// Declare the class final to safely call virtual function setEnabled in constructor.
+class FileEventImpl final : public Event::FileEvent, Logger::Loggable<Logger::Id::io> {
+public:
+  FileEventImpl(Event::Dispatcher& dispatcher, Event::FileReadyCb cb, uint32_t events,
+                const ReadinessSource& source);
+
+  // Event::FileEvent
+  void activate(uint32_t events) override;
+  void setEnabled(uint32_t events) override;
+
+  // This event always acts as edge triggered.
+  void unregisterEventIfEmulatedEdge(uint32_t) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
+  void registerEventIfEmulatedEdge(uint32_t) override { NOT_IMPLEMENTED_GCOVR_EXCL_LINE; }
+
+  // Activates the given events only if they are enabled.
+  void activateIfEnabled(uint32_t events);
+
+private:
+  // The events set by activate() and cleared before the callback is invoked.
+  uint32_t ephemeral_events_{};
+  // The events set by setEnabled().
+  uint32_t enabled_events_{};
+  Event::SchedulableCallbackPtr schedulable_;
+  const ReadinessSource& source_;
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,274 @@
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+IoUringImplPtr IoUringImpl::create(uint32_t entries) {
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (ring_fd < 0) {
+    return nullptr;
+  }
+
+  IoUringImplPtr ring(new IoUringImpl());
+  ring->ring_fd_ = ring_fd;
+  ring->sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring->cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    ring->sq_ring_size_ = ring->cq_ring_size_ = std::max(ring->sq_ring_size_, ring->cq_ring_size_);
+  }
+
+  ring->sq_ring_ = mmap(nullptr, ring->sq_ring_size_, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (ring->sq_ring_ == MAP_FAILED) {
+    ring->sq_ring_ = nullptr;
+    return nullptr;
+  }
+  if (single_mmap) {
+    ring->cq_ring_ = ring->sq_ring_;
+  } else {
+    ring->cq_ring_ = mmap(nullptr, ring->cq_ring_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (ring->cq_ring_ == MAP_FAILED) {
+      ring->cq_ring_ = nullptr;
+      return nullptr;
+    }
+  }
+  ring->sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  void* sqes = mmap(nullptr, ring->sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return nullptr;
+  }
+  ring->sqes_ = static_cast<struct io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(ring->sq_ring_);
+  ring->sq_head_ = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  ring->sq_tail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  ring->sq_mask_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  ring->sq_entries_ = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_entries);
+  ring->sq_flags_ = reinterpret_cast<unsigned*>(sq + params.sq_off.flags);
+  ring->sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  ring->sqe_head_ = ring->sqe_tail_ = *ring->sq_tail_;
+
+  char* cq = static_cast<char*>(ring->cq_ring_);
+  ring->cq_head_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  ring->cq_tail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  ring->cq_mask_ = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  ring->cqes_ = reinterpret_cast<struct io_uring_cqe*>(cq + params.cq_off.cqes);
+  return ring;
+}
+
+IoUringImpl::~IoUringImpl() {
+  if (sqes_ != nullptr) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ring_ != nullptr && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  if (sq_ring_ != nullptr) {
+    munmap(sq_ring_, sq_ring_size_);
+  }
+  if (ring_fd_ != -1) {
+    // The kernel tears the ring down asynchronously, so the owner must have reaped the last
+    // completion of every request before the memory they refer to is released.
+    close(ring_fd_);
+  }
+}
+
+bool IoUringImpl::registerEventfd(int event_fd) {
+  return syscall(__NR_io_uring_register, ring_fd_, IORING_REGISTER_EVENTFD, &event_fd, 1) == 0;
+}
+
+struct io_uring_sqe* IoUringImpl::getSqe() {
+  if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= *sq_entries_) {
+    // The queue is full. Hand what we have to the kernel, which consumes the entries before
+    // io_uring_enter() returns.
+    submit();
+    if (sqe_tail_ - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) >= *sq_entries_) {
+      return nullptr;
+    }
+  }
+  struct io_uring_sqe* sqe = &sqes_[sqe_tail_ & *sq_mask_];
+  ++sqe_tail_;
+  memset(sqe, 0, sizeof(*sqe));
+  return sqe;
+}
+
+bool IoUringImpl::prepareAccept(int fd, bool multishot, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_ACCEPT;
+  sqe->fd = fd;
+  sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+#ifdef IORING_ACCEPT_MULTISHOT
+  if (multishot) {
+    sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+  }
+#else
+  (void)multishot;
+#endif
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareRecv(int fd, uint16_t buffer_group, bool multishot, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_RECV;
+  sqe->fd = fd;
+  sqe->flags = IOSQE_BUFFER_SELECT;
+  sqe->buf_group = buffer_group;
+#ifdef IORING_RECV_MULTISHOT
+  if (multishot) {
+    sqe->ioprio |= IORING_RECV_MULTISHOT;
+  }
+#else
+  (void)multishot;
+#endif
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareWritev(int fd, const struct iovec* iovecs, uint32_t num_iovecs,
+                                uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_WRITEV;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(iovecs);
+  sqe->len = num_iovecs;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::preparePollAdd(int fd, uint32_t events, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = events;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareCancel(uint64_t target_user_data, uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->addr = target_user_data;
+  sqe->user_data = user_data;
+  return true;
+}
+
+bool IoUringImpl::prepareCancelAll(uint64_t user_data) {
+#ifdef IORING_ASYNC_CANCEL_ANY
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_ASYNC_CANCEL;
+  sqe->fd = -1;
+  sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+  sqe->user_data = user_data;
+  return true;
+#else
+  (void)user_data;
+  return false;
+#endif
+}
+
+bool IoUringImpl::prepareProvideBuffers(void* addr, uint32_t length, uint32_t count,
+                                        uint16_t buffer_group, uint16_t buffer_id,
+                                        uint64_t user_data) {
+  struct io_uring_sqe* sqe = getSqe();
+  if (sqe == nullptr) {
+    return false;
+  }
+  sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+  sqe->fd = count;
+  sqe->addr = reinterpret_cast<uint64_t>(addr);
+  sqe->len = length;
+  sqe->off = buffer_id;
+  sqe->buf_group = buffer_group;
+  sqe->user_data = user_data;
+  return true;
+}
+
+int IoUringImpl::submit() { return enter(false); }
+
+int IoUringImpl::submitAndWait() { return enter(true); }
+
+int IoUringImpl::enter(bool wait) {
+  // Publish the prepared entries. They are placed in the ring in the order they were prepared, so
+  // the submission ring tail always advances in step with sqe_head_.
+  unsigned tail = *sq_tail_;
+  for (; sqe_head_ != sqe_tail_; ++sqe_head_, ++tail) {
+    sq_array_[tail & *sq_mask_] = sqe_head_ & *sq_mask_;
+  }
+  __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+
+  // This also covers entries left over from a previous submit() that failed.
+  const unsigned to_submit = tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE);
+  if (to_submit == 0 && !wait) {
+    return 0;
+  }
+  int rc;
+  do {
+    rc = syscall(__NR_io_uring_enter, ring_fd_, to_submit, wait ? 1 : 0,
+                 wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+  } while (rc < 0 && errno == EINTR);
+  return rc < 0 ? -errno : rc;
+}
+
+uint32_t IoUringImpl::forEveryCompletion(const CompletionCb& cb) {
+  uint32_t count = 0;
+  while (true) {
+    unsigned head = *cq_head_;
+    const unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head, ++count) {
+      const struct io_uring_cqe& cqe = cqes_[head & *cq_mask_];
+      cb(cqe.user_data, cqe.res, cqe.flags);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+
+    // Completions that didn't fit into the completion queue are held back by the kernel until
+    // they are explicitly flushed into the now drained queue.
+    if (!(__atomic_load_n(sq_flags_, __ATOMIC_ACQUIRE) & IORING_SQ_CQ_OVERFLOW)) {
+      return count;
+    }
+    if (syscall(__NR_io_uring_enter, ring_fd_, 0, 0, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+        errno != EINTR) {
+      return count;
+    }
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "source/common/common/non_copyable.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Invoked for every completion reaped from the ring.
+ * @param user_data supplies the user data of the completed submission.
+ * @param result supplies the result of the operation, or -errno on failure.
+ * @param flags supplies the completion flags, e.g. IORING_CQE_F_MORE.
+ */
+using CompletionCb = std::function<void(uint64_t user_data, int32_t result, uint32_t flags)>;
+
+class IoUringImpl;
+using IoUringImplPtr = std::unique_ptr<IoUringImpl>;
+
+/**
+ * A minimal io_uring instance, driven through the raw io_uring syscalls so that no userspace
+ * library is required. Submissions are only queued by the prepare*() calls and are handed to the
+ * kernel in a single batch by submit(). Not thread safe; each instance must be used from a single
+ * thread.
+ */
+class IoUringImpl : NonCopyable {
+public:
+  /**
+   * @param entries supplies the size of the submission queue. Rounded up to a power of two by the
+   *        kernel.
+   * @return a new ring, or nullptr if io_uring isn't supported or is disabled on this host.
+   */
+  static IoUringImplPtr create(uint32_t entries);
+
+  ~IoUringImpl();
+
+  /**
+   * Registers an eventfd that the kernel signals whenever a completion is posted.
+   * @return true on success.
+   */
+  bool registerEventfd(int event_fd);
+
+  /**
+   * Queues an accept on a listening socket. Accepted sockets are non-blocking and close-on-exec.
+   * With multishot, a completion is posted for every accepted connection until the request is
+   * cancelled or fails.
+   */
+  bool prepareAccept(int fd, bool multishot, uint64_t user_data);
+
+  /**
+   * Queues a receive into a buffer selected by the kernel from buffer_group. With multishot, a
+   * completion is posted for every received chunk until the request is cancelled or fails.
+   */
+  bool prepareRecv(int fd, uint16_t buffer_group, bool multishot, uint64_t user_data);
+
+  /**
+   * Queues a writev. iovecs and the memory they refer to must remain valid until the completion
+   * is reaped.
+   */
+  bool prepareWritev(int fd, const struct iovec* iovecs, uint32_t num_iovecs, uint64_t user_data);
+
+  /**
+   * Queues a one-shot poll for events on fd.
+   */
+  bool preparePollAdd(int fd, uint32_t events, uint64_t user_data);
+
+  /**
+   * Queues the cancellation of all requests submitted with target_user_data.
+   */
+  bool prepareCancel(uint64_t target_user_data, uint64_t user_data);
+
+  /**
+   * Queues the cancellation of all requests in flight. The cancellation completes with -EINVAL on
+   * kernels older than 5.19, which only cancel requests by user data.
+   * @return false if the submission couldn't be queued, or cancelling all requests isn't supported
+   *         by the kernel headers Envoy was built with.
+   */
+  bool prepareCancelAll(uint64_t user_data);
+
+  /**
+   * Queues handing count buffers of length bytes each, starting at addr, to buffer_group. The
+   * buffers are numbered from buffer_id.
+   */
+  bool prepareProvideBuffers(void* addr, uint32_t length, uint32_t count, uint16_t buffer_group,
+                             uint16_t buffer_id, uint64_t user_data);
+
+  /**
+   * Hands all queued submissions to the kernel with a single io_uring_enter().
+   * @return the number of submissions consumed, or -errno on failure.
+   */
+  int submit();
+
+  /**
+   * As submit(), but also blocks until at least one completion is available.
+   * @return the number of submissions consumed, or -errno on failure.
+   */
+  int submitAndWait();
+
+  /**
+   * @return the number of queued submissions that haven't been handed to the kernel yet.
+   */
+  uint32_t pendingSubmissions() const { return sqe_tail_ - sqe_head_; }
+
+  /**
+   * Invokes cb for every available completion, including any the kernel held back because the
+   * completion queue overflowed, then marks them consumed.
+   * @return the number of completions reaped.
+   */
+  uint32_t forEveryCompletion(const CompletionCb& cb);
+
+private:
+  IoUringImpl() = default;
+
+  // Returns a zeroed submission queue entry, submitting queued entries first if the queue is full.
+  // Returns nullptr if no entry could be made available.
+  struct io_uring_sqe* getSqe();
+  // Publishes the queued entries and enters the kernel, waiting for a completion if wait is true.
+  int enter(bool wait);
+
+  int ring_fd_{-1};
+
+  void* sq_ring_{};
+  size_t sq_ring_size_{};
+  void* cq_ring_{};
+  size_t cq_ring_size_{};
+  struct io_uring_sqe* sqes_{};
+  size_t sqes_size_{};
+
+  unsigned* sq_head_{};
+  unsigned* sq_tail_{};
+  unsigned* sq_mask_{};
+  unsigned* sq_entries_{};
+  unsigned* sq_flags_{};
+  unsigned* sq_array_{};
+  // Entries in [sqe_head_, sqe_tail_) have been prepared but not handed to the kernel yet.
+  unsigned sqe_head_{};
+  unsigned sqe_tail_{};
+
+  unsigned* cq_head_{};
+  unsigned* cq_tail_{};
+  unsigned* cq_mask_{};
+  struct io_uring_cqe* cqes_{};
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
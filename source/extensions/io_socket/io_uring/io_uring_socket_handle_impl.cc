@@ -0,0 +1,408 @@
+#include "source/extensions/io_socket/io_uring/io_uring_socket_handle_impl.h"
+
+#include <poll.h>
+
+#include <algorithm>
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+#include "source/common/common/utility.h"
+#include "source/common/network/io_socket_error_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+namespace {
+// Receiving is paused once this many bytes are buffered and not yet read by the connection, e.g.
+// while the connection has reads disabled, and resumed once half of them were consumed.
+constexpr uint64_t MaxBufferedReadBytes = 1024 * 1024;
+
+Api::IoCallUint64Result eagainResult() {
+  return {0, Api::IoErrorPtr(Network::IoSocketError::getIoSocketEagainInstance(),
+                             Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result errorResult(int error) {
+  return {0, Api::IoErrorPtr(new Network::IoSocketError(error),
+                             Network::IoSocketError::deleteIoError)};
+}
+} // namespace
+
+IoUringSocketHandleImpl::IoUringSocketHandleImpl(const IoUringWorkerFactory& factory, os_fd_t fd,
+                                                 bool socket_v6only, absl::optional<int> domain)
+    : IoSocketHandleImpl(fd, socket_v6only, domain), factory_(factory) {}
+
+IoUringSocketHandleImpl::~IoUringSocketHandleImpl() {
+  if (SOCKET_VALID(fd_)) {
+    IoUringSocketHandleImpl::close();
+  }
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::close() {
+  if (worker_ != nullptr) {
+    for (Request** request : {&accept_request_, &recv_request_, &write_request_, &poll_request_}) {
+      if (*request != nullptr) {
+        worker_->cancel(**request);
+        *request = nullptr;
+      }
+    }
+    for (const int fd : accepted_fds_) {
+      Api::OsSysCallsSingleton::get().close(fd);
+    }
+    accepted_fds_.clear();
+    // Cancel before closing, so that the requests release the socket right away and the close
+    // takes effect.
+    worker_->submit();
+    io_uring_file_event_ = nullptr;
+  }
+  return IoSocketHandleImpl::close();
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::readv(uint64_t max_length,
+                                                       Buffer::RawSlice* slices,
+                                                       uint64_t num_slice) {
+  if (worker_ == nullptr || !connected_) {
+    return IoSocketHandleImpl::readv(max_length, slices, num_slice);
+  }
+  if (read_buffer_.length() == 0) {
+    return emptyReadResult();
+  }
+  uint64_t bytes_read = 0;
+  for (uint64_t i = 0; i < num_slice && bytes_read < max_length && read_buffer_.length() > 0;
+       i++) {
+    const uint64_t length =
+        std::min({slices[i].len_, max_length - bytes_read, read_buffer_.length()});
+    read_buffer_.copyOut(0, length, slices[i].mem_);
+    read_buffer_.drain(length);
+    bytes_read += length;
+  }
+  maybeResumeRecv();
+  return {bytes_read, Api::IoErrorPtr(nullptr, Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::read(Buffer::Instance& buffer,
+                                                      absl::optional<uint64_t> max_length_opt) {
+  if (worker_ == nullptr || !connected_) {
+    return IoSocketHandleImpl::read(buffer, max_length_opt);
+  }
+  const uint64_t max_length = max_length_opt.value_or(UINT64_MAX);
+  if (max_length == 0) {
+    return Api::ioCallUint64ResultNoError();
+  }
+  if (read_buffer_.length() == 0) {
+    return emptyReadResult();
+  }
+  const uint64_t length = std::min(max_length, read_buffer_.length());
+  buffer.move(read_buffer_, length);
+  maybeResumeRecv();
+  return {length, Api::IoErrorPtr(nullptr, Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::writev(const Buffer::RawSlice* slices,
+                                                        uint64_t num_slice) {
+  if (worker_ == nullptr || !connected_) {
+    return IoSocketHandleImpl::writev(slices, num_slice);
+  }
+  Buffer::OwnedImpl buffer;
+  for (uint64_t i = 0; i < num_slice; i++) {
+    if (slices[i].mem_ != nullptr && slices[i].len_ != 0) {
+      buffer.add(slices[i].mem_, slices[i].len_);
+    }
+  }
+  return write(buffer);
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::write(Buffer::Instance& buffer) {
+  if (worker_ == nullptr || !connected_) {
+    return IoSocketHandleImpl::write(buffer);
+  }
+  // The failure of the previous write, which was already reported as written.
+  if (write_error_ != 0) {
+    return errorResult(write_error_);
+  }
+  // Only one write is in flight at a time, so that writes complete in order. The connection
+  // buffers further data meanwhile, which keeps its watermarks meaningful.
+  if (write_request_ != nullptr) {
+    return eagainResult();
+  }
+  const uint64_t length = buffer.length();
+  if (length == 0) {
+    return Api::ioCallUint64ResultNoError();
+  }
+  write_request_ = worker_->submitWrite(fd_, buffer, *this);
+  if (write_request_ == nullptr) {
+    // The submission queue is full. Retry on the next loop iteration.
+    activateIfEnabled(Event::FileReadyType::Write);
+    return eagainResult();
+  }
+  return {length, Api::IoErrorPtr(nullptr, Network::IoSocketError::deleteIoError)};
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::recv(void* buffer, size_t length, int flags) {
+  if (worker_ == nullptr || !connected_) {
+    return IoSocketHandleImpl::recv(buffer, length, flags);
+  }
+  if (read_buffer_.length() == 0) {
+    return emptyReadResult();
+  }
+  const uint64_t bytes_read = std::min<uint64_t>(length, read_buffer_.length());
+  read_buffer_.copyOut(0, bytes_read, buffer);
+  if (!(flags & MSG_PEEK)) {
+    read_buffer_.drain(bytes_read);
+    maybeResumeRecv();
+  }
+  return {bytes_read, Api::IoErrorPtr(nullptr, Network::IoSocketError::deleteIoError)};
+}
+
+Network::IoHandlePtr IoUringSocketHandleImpl::accept(struct sockaddr* addr, socklen_t* addrlen) {
+  if (worker_ == nullptr) {
+    return IoSocketHandleImpl::accept(addr, addrlen);
+  }
+  auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+  while (!accepted_fds_.empty()) {
+    const int fd = accepted_fds_.front();
+    accepted_fds_.pop_front();
+    socklen_t length = *addrlen;
+    if (os_sys_calls.getpeername(fd, addr, &length).return_value_ != 0) {
+      // The connection was reset before it was handed to the listener.
+      os_sys_calls.close(fd);
+      continue;
+    }
+    *addrlen = length;
+    return std::make_unique<IoUringSocketHandleImpl>(factory_, fd, socket_v6only_, domain_);
+  }
+  return nullptr;
+}
+
+Api::SysCallIntResult
+IoUringSocketHandleImpl::connect(Network::Address::InstanceConstSharedPtr address) {
+  const Api::SysCallIntResult result = IoSocketHandleImpl::connect(address);
+  if (result.return_value_ == 0) {
+    if (worker_ != nullptr) {
+      onConnected();
+    }
+  } else if (result.errno_ == SOCKET_ERROR_IN_PROGRESS) {
+    connect_in_progress_ = true;
+    if (worker_ != nullptr) {
+      poll_request_ = worker_->submitPoll(fd_, POLLOUT, *this);
+    }
+  }
+  return result;
+}
+
+void IoUringSocketHandleImpl::initializeFileEvent(Event::Dispatcher& dispatcher,
+                                                  Event::FileReadyCb cb,
+                                                  Event::FileTriggerType trigger,
+                                                  uint32_t events) {
+  ASSERT(file_event_ == nullptr, "Attempting to initialize two `file_event_` for the same "
+                                 "file descriptor. This is not allowed.");
+  if (worker_ == nullptr) {
+    OptRef<IoUringWorker> worker = factory_.getIoUringWorker();
+    if (!worker.has_value() || &worker->dispatcher() != &dispatcher || !isStreamSocket()) {
+      IoSocketHandleImpl::initializeFileEvent(dispatcher, cb, trigger, events);
+      return;
+    }
+    worker_ = &worker.ref();
+
+    auto& os_sys_calls = Api::OsSysCallsSingleton::get();
+    int accept_conn = 0;
+    socklen_t length = sizeof(accept_conn);
+    sockaddr_storage peer;
+    socklen_t peer_length = sizeof(peer);
+    if (os_sys_calls.getsockopt(fd_, SOL_SOCKET, SO_ACCEPTCONN, &accept_conn, &length)
+                .return_value_ == 0 &&
+        accept_conn != 0) {
+      listening_ = true;
+      accept_request_ = worker_->submitAccept(fd_, *this);
+    } else if (connect_in_progress_) {
+      poll_request_ = worker_->submitPoll(fd_, POLLOUT, *this);
+    } else if (os_sys_calls.getpeername(fd_, reinterpret_cast<sockaddr*>(&peer), &peer_length)
+                   .return_value_ == 0) {
+      onConnected();
+    }
+  }
+
+  // The file event may be reset and initialized again, e.g. after listener filters ran, while the
+  // requests of the socket stay in flight.
+  ENVOY_LOG(trace, "io_uring socket {} initializes file event", fd_);
+  auto file_event = std::make_unique<FileEventImpl>(dispatcher, cb, events, *this);
+  io_uring_file_event_ = file_event.get();
+  file_event_ = std::move(file_event);
+}
+
+Network::IoHandlePtr IoUringSocketHandleImpl::duplicate() {
+  auto result = Api::OsSysCallsSingleton::get().duplicate(fd_);
+  RELEASE_ASSERT(result.return_value_ != -1,
+                 fmt::format("duplicate failed for '{}': ({}) {}", fd_, result.errno_,
+                             errorDetails(result.errno_)));
+  return std::make_unique<IoUringSocketHandleImpl>(factory_, result.return_value_, socket_v6only_,
+                                                   domain_);
+}
+
+void IoUringSocketHandleImpl::resetFileEvents() {
+  io_uring_file_event_ = nullptr;
+  file_event_.reset();
+}
+
+Api::SysCallIntResult IoUringSocketHandleImpl::shutdown(int how) {
+  if (worker_ != nullptr && write_request_ != nullptr && how == ENVOY_SHUT_WR) {
+    // Shut down once the data in flight was written.
+    shutdown_pending_ = true;
+    return {0, 0};
+  }
+  return IoSocketHandleImpl::shutdown(how);
+}
+
+void IoUringSocketHandleImpl::onAccept(int32_t result) {
+  if (result < 0) {
+    ENVOY_LOG(debug, "io_uring accept on {} failed: {}", fd_, errorDetails(-result));
+    return;
+  }
+  accepted_fds_.push_back(result);
+  activateIfEnabled(Event::FileReadyType::Read);
+}
+
+void IoUringSocketHandleImpl::onRecv(int32_t result, absl::string_view data) {
+  if (result > 0) {
+    read_buffer_.add(data);
+    if (read_buffer_.length() >= MaxBufferedReadBytes && recv_request_ != nullptr &&
+        !recv_stopping_) {
+      // The kernel may already have posted more data, which is buffered as well until the last
+      // completion of the receive.
+      recv_paused_ = true;
+      recv_stopping_ = true;
+      worker_->stopRecv(*recv_request_);
+    }
+    activateIfEnabled(Event::FileReadyType::Read);
+    return;
+  }
+  if (result == -ECANCELED) {
+    // The receive was stopped by a full read buffer.
+    return;
+  }
+  if (result == 0) {
+    read_eof_ = true;
+  } else {
+    read_error_ = -result;
+  }
+  activateIfEnabled(Event::FileReadyType::Read | Event::FileReadyType::Closed);
+}
+
+void IoUringSocketHandleImpl::onWrite(int32_t result) {
+  write_request_ = nullptr;
+  if (result < 0) {
+    write_error_ = -result;
+  }
+  if (shutdown_pending_) {
+    shutdown_pending_ = false;
+    IoSocketHandleImpl::shutdown(ENVOY_SHUT_WR);
+  }
+  activateIfEnabled(Event::FileReadyType::Write);
+}
+
+void IoUringSocketHandleImpl::onPoll(int32_t) {
+  poll_request_ = nullptr;
+  connect_in_progress_ = false;
+  sockaddr_storage peer;
+  socklen_t peer_length = sizeof(peer);
+  if (Api::OsSysCallsSingleton::get()
+          .getpeername(fd_, reinterpret_cast<sockaddr*>(&peer), &peer_length)
+          .return_value_ == 0) {
+    onConnected();
+  } else {
+    // The connection reads the failure from SO_ERROR.
+    connect_failed_ = true;
+    activateIfEnabled(Event::FileReadyType::Write);
+  }
+}
+
+void IoUringSocketHandleImpl::onRequestDone(RequestType type) {
+  switch (type) {
+  case RequestType::Accept:
+    ENVOY_LOG(warn, "io_uring accept on {} stopped", fd_);
+    accept_request_ = nullptr;
+    break;
+  case RequestType::Recv:
+    recv_request_ = nullptr;
+    if (recv_stopping_) {
+      recv_stopping_ = false;
+      // Enough data may have been consumed meanwhile.
+      if (!recv_paused_) {
+        startRecv();
+      }
+    }
+    break;
+  case RequestType::Write:
+    write_request_ = nullptr;
+    break;
+  case RequestType::Poll:
+    poll_request_ = nullptr;
+    break;
+  }
+}
+
+bool IoUringSocketHandleImpl::isReadable() const {
+  if (listening_) {
+    return !accepted_fds_.empty();
+  }
+  return read_buffer_.length() > 0 || read_eof_ || read_error_ != 0;
+}
+
+bool IoUringSocketHandleImpl::isWritable() const {
+  return (connected_ && write_request_ == nullptr) || connect_failed_;
+}
+
+bool IoUringSocketHandleImpl::isStreamSocket() {
+  int type = 0;
+  socklen_t length = sizeof(type);
+  return Api::OsSysCallsSingleton::get()
+                 .getsockopt(fd_, SOL_SOCKET, SO_TYPE, &type, &length)
+                 .return_value_ == 0 &&
+         type == SOCK_STREAM;
+}
+
+void IoUringSocketHandleImpl::onConnected() {
+  connected_ = true;
+  startRecv();
+  activateIfEnabled(Event::FileReadyType::Write);
+}
+
+void IoUringSocketHandleImpl::startRecv() {
+  recv_paused_ = false;
+  if (recv_request_ == nullptr && !read_eof_ && read_error_ == 0) {
+    recv_request_ = worker_->submitRecv(fd_, *this);
+    if (recv_request_ == nullptr) {
+      read_error_ = ENOBUFS;
+      activateIfEnabled(Event::FileReadyType::Read);
+    }
+  }
+}
+
+void IoUringSocketHandleImpl::maybeResumeRecv() {
+  if (recv_paused_ && read_buffer_.length() < MaxBufferedReadBytes / 2) {
+    startRecv();
+  }
+}
+
+void IoUringSocketHandleImpl::activateIfEnabled(uint32_t events) {
+  if (io_uring_file_event_ != nullptr) {
+    io_uring_file_event_->activateIfEnabled(events);
+  }
+}
+
+Api::IoCallUint64Result IoUringSocketHandleImpl::emptyReadResult() const {
+  if (read_error_ != 0) {
+    return errorResult(read_error_);
+  }
+  if (read_eof_) {
+    return Api::ioCallUint64ResultNoError();
+  }
+  return eagainResult();
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
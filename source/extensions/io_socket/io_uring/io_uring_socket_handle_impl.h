@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "envoy/common/optref.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/file_event_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Supplies the io_uring worker of the calling thread.
+ */
+class IoUringWorkerFactory {
+public:
+  virtual ~IoUringWorkerFactory() = default;
+
+  /**
+   * @return the worker of the calling thread, or an empty reference if the thread has none.
+   */
+  virtual OptRef<IoUringWorker> getIoUringWorker() const PURE;
+};
+
+/**
+ * IoHandle for sockets whose I/O is driven by the io_uring worker of the thread that initializes
+ * the file event. Listening sockets accept with a multishot accept, connected sockets receive
+ * with a multishot receive into a user space buffer and write with asynchronous writev. Sockets
+ * which aren't TCP, or which are initialized on a thread without worker, behave like
+ * Network::IoSocketHandleImpl.
+ *
+ * Writes are asynchronous: write() takes all of the data and reports it as written once the writev
+ * is submitted, and returns EAGAIN while it is in flight. The worker resubmits short writes until
+ * all data is written, so they are never visible to the caller. A failed write is reported by the
+ * next call to write(), and by a write event so that the connection makes that call. The failure
+ * usually also ends the stream, which the connection sees when reading.
+ */
+class IoUringSocketHandleImpl final : public Network::IoSocketHandleImpl,
+                                      public IoUringSocketCallbacks,
+                                      public ReadinessSource {
+public:
+  IoUringSocketHandleImpl(const IoUringWorkerFactory& factory, os_fd_t fd = INVALID_SOCKET,
+                          bool socket_v6only = false, absl::optional<int> domain = absl::nullopt);
+  ~IoUringSocketHandleImpl() override;
+
+  // Network::IoHandle
+  Api::IoCallUint64Result close() override;
+  Api::IoCallUint64Result readv(uint64_t max_length, Buffer::RawSlice* slices,
+                                uint64_t num_slice) override;
+  Api::IoCallUint64Result read(Buffer::Instance& buffer,
+                               absl::optional<uint64_t> max_length) override;
+  Api::IoCallUint64Result writev(const Buffer::RawSlice* slices, uint64_t num_slice) override;
+  Api::IoCallUint64Result write(Buffer::Instance& buffer) override;
+  Api::IoCallUint64Result recv(void* buffer, size_t length, int flags) override;
+  Network::IoHandlePtr accept(struct sockaddr* addr, socklen_t* addrlen) override;
+  Api::SysCallIntResult connect(Network::Address::InstanceConstSharedPtr address) override;
+  void initializeFileEvent(Event::Dispatcher& dispatcher, Event::FileReadyCb cb,
+                           Event::FileTriggerType trigger, uint32_t events) override;
+  Network::IoHandlePtr duplicate() override;
+  void resetFileEvents() override;
+  Api::SysCallIntResult shutdown(int how) override;
+
+  // IoUringSocketCallbacks
+  void onAccept(int32_t result) override;
+  void onRecv(int32_t result, absl::string_view data) override;
+  void onWrite(int32_t result) override;
+  void onPoll(int32_t result) override;
+  void onRequestDone(RequestType type) override;
+
+  // ReadinessSource
+  bool isReadable() const override;
+  bool isWritable() const override;
+  bool isPeerShutDownWrite() const override { return read_eof_; }
+
+private:
+  bool isStreamSocket();
+  void onConnected();
+  void startRecv();
+  // Resumes the receive paused by a full read buffer once enough data was consumed.
+  void maybeResumeRecv();
+  void activateIfEnabled(uint32_t events);
+  // The result of a read while no data is buffered.
+  Api::IoCallUint64Result emptyReadResult() const;
+
+  const IoUringWorkerFactory& factory_;
+  // Set once the file event was initialized on a thread with a worker. Null while the socket
+  // behaves like Network::IoSocketHandleImpl.
+  IoUringWorker* worker_{};
+  FileEventImpl* io_uring_file_event_{};
+
+  bool listening_{};
+  bool connect_in_progress_{};
+  bool connected_{};
+  bool connect_failed_{};
+  bool recv_paused_{};
+  // Set while the receive stopped by a full read buffer still posts completions.
+  bool recv_stopping_{};
+  bool read_eof_{};
+  bool shutdown_pending_{};
+  int read_error_{};
+  int write_error_{};
+
+  Request* accept_request_{};
+  Request* recv_request_{};
+  Request* write_request_{};
+  Request* poll_request_{};
+
+  Buffer::OwnedImpl read_buffer_;
+  std::deque<int> accepted_fds_;
+};
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
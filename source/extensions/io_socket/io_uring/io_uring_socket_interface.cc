@@ -0,0 +1,105 @@
+#include "source/extensions/io_socket/io_uring/io_uring_socket_interface.h"
+
+#include "envoy/common/exception.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/common/logger.h"
+#include "source/common/network/address_impl.h"
+#include "source/common/network/utility.h"
+#include "source/common/protobuf/utility.h"
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+Server::BootstrapExtensionPtr IoUringSocketInterface::createBootstrapExtension(
+    const Protobuf::Message& config, Server::Configuration::ServerFactoryContext& context) {
+  const auto& typed_config = MessageUtil::downcastAndValidate<
+      const envoy::extensions::network::socket_interface::v3::IoUringSocketInterface&>(
+      config, context.messageValidationVisitor());
+  return std::make_unique<IoUringSocketInterfaceExtension>(*this, context.threadLocal(),
+                                                           typed_config);
+}
+
+ProtobufTypes::MessagePtr IoUringSocketInterface::createEmptyConfigProto() {
+  return std::make_unique<
+      envoy::extensions::network::socket_interface::v3::IoUringSocketInterface>();
+}
+
+OptRef<IoUringWorker> IoUringSocketInterface::getIoUringWorker() const {
+  if (slot_ == nullptr || !slot_->currentThreadRegistered()) {
+    return {};
+  }
+  return slot_->get();
+}
+
+Network::IoHandlePtr IoUringSocketInterface::makeSocket(int socket_fd, bool socket_v6only,
+                                                        absl::optional<int> domain) const {
+  return std::make_unique<IoUringSocketHandleImpl>(*this, socket_fd, socket_v6only, domain);
+}
+
+REGISTER_FACTORY(IoUringSocketInterface, Server::Configuration::BootstrapExtensionFactory);
+
+IoUringSocketInterfaceExtension::IoUringSocketInterfaceExtension(
+    IoUringSocketInterface& sock_interface, ThreadLocal::SlotAllocator& tls,
+    const envoy::extensions::network::socket_interface::v3::IoUringSocketInterface& config)
+    : Network::SocketInterfaceExtension(sock_interface), io_uring_sock_interface_(sock_interface),
+      slot_(ThreadLocal::TypedSlot<IoUringWorker>::makeUnique(tls)) {
+  const uint32_t io_uring_size = PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, io_uring_size, 1024);
+  const uint32_t read_buffer_size =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, read_buffer_size, 16384);
+  const uint32_t read_buffer_count =
+      PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, read_buffer_count, 256);
+
+  if (IoUringImpl::create(io_uring_size) == nullptr) {
+    ENVOY_LOG_MISC(warn, "io_uring is not supported on this host, sockets of {} use the default "
+                         "socket interface",
+                   sock_interface.name());
+    return;
+  }
+  slot_->set([io_uring_size, read_buffer_size, read_buffer_count](Event::Dispatcher& dispatcher) {
+    // A null worker makes the sockets of this thread fall back to readiness based I/O.
+    return IoUringWorker::create(io_uring_size, read_buffer_size, read_buffer_count, dispatcher);
+  });
+  io_uring_sock_interface_.setWorkerSlot(slot_.get());
+}
+
+IoUringSocketInterfaceExtension::~IoUringSocketInterfaceExtension() {
+  io_uring_sock_interface_.setWorkerSlot(nullptr);
+}
+
+Network::Address::InstanceConstSharedPtr
+IoUringResolver::resolve(const envoy::config::core::v3::SocketAddress& socket_address) {
+  switch (socket_address.port_specifier_case()) {
+  case envoy::config::core::v3::SocketAddress::PortSpecifierCase::kPortValue:
+  // Default to port 0 if no port value is specified.
+  case envoy::config::core::v3::SocketAddress::PortSpecifierCase::PORT_SPECIFIER_NOT_SET:
+    break;
+  default:
+    throw EnvoyException(fmt::format("io_uring resolver can't handle port specifier type {}",
+                                     socket_address.port_specifier_case()));
+  }
+
+  const Network::SocketInterface* sock_interface =
+      Network::socketInterface("envoy.extensions.network.socket_interface.io_uring");
+  ASSERT(sock_interface != nullptr);
+  const Network::Address::InstanceConstSharedPtr address =
+      Network::Utility::parseInternetAddress(socket_address.address(), socket_address.port_value(),
+                                             !socket_address.ipv4_compat());
+  if (address->ip()->version() == Network::Address::IpVersion::v4) {
+    return std::make_shared<Network::Address::Ipv4Instance>(
+        reinterpret_cast<const sockaddr_in*>(address->sockAddr()), sock_interface);
+  }
+  return std::make_shared<Network::Address::Ipv6Instance>(
+      *reinterpret_cast<const sockaddr_in6*>(address->sockAddr()), address->ip()->ipv6()->v6only(),
+      sock_interface);
+}
+
+REGISTER_FACTORY(IoUringResolver, Network::Address::Resolver);
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
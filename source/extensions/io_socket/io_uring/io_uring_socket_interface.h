@@ -0,0 +1,82 @@
+#pragma once
+
+#include "envoy/extensions/network/socket_interface/v3/io_uring_socket_interface.pb.h"
+#include "envoy/network/resolver.h"
+#include "envoy/thread_local/thread_local.h"
+
+#include "source/common/network/socket_interface.h"
+#include "source/common/network/socket_interface_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_socket_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+/**
+ * Socket interface whose TCP sockets are driven by the io_uring worker of the thread that uses
+ * them. The workers only exist once the interface was configured as a bootstrap extension; until
+ * then, and on hosts without io_uring, the sockets behave like those of the default interface.
+ */
+class IoUringSocketInterface : public Network::SocketInterfaceImpl, public IoUringWorkerFactory {
+public:
+  // Server::Configuration::BootstrapExtensionFactory
+  Server::BootstrapExtensionPtr
+  createBootstrapExtension(const Protobuf::Message& config,
+                           Server::Configuration::ServerFactoryContext& context) override;
+  ProtobufTypes::MessagePtr createEmptyConfigProto() override;
+  std::string name() const override {
+    return "envoy.extensions.network.socket_interface.io_uring";
+  };
+
+  // IoUringWorkerFactory
+  OptRef<IoUringWorker> getIoUringWorker() const override;
+
+  void setWorkerSlot(ThreadLocal::TypedSlot<IoUringWorker>* slot) { slot_ = slot; }
+
+protected:
+  // Network::SocketInterfaceImpl
+  Network::IoHandlePtr makeSocket(int socket_fd, bool socket_v6only,
+                                  absl::optional<int> domain) const override;
+
+private:
+  ThreadLocal::TypedSlot<IoUringWorker>* slot_{};
+};
+
+DECLARE_FACTORY(IoUringSocketInterface);
+
+/**
+ * Owns the per thread io_uring workers of an IoUringSocketInterface.
+ */
+class IoUringSocketInterfaceExtension : public Network::SocketInterfaceExtension {
+public:
+  IoUringSocketInterfaceExtension(
+      IoUringSocketInterface& sock_interface, ThreadLocal::SlotAllocator& tls,
+      const envoy::extensions::network::socket_interface::v3::IoUringSocketInterface& config);
+  ~IoUringSocketInterfaceExtension() override;
+
+private:
+  IoUringSocketInterface& io_uring_sock_interface_;
+  ThreadLocal::TypedSlotPtr<IoUringWorker> slot_;
+};
+
+/**
+ * Resolves IP addresses like the default IP resolver, but creates the sockets of the addresses
+ * with the io_uring socket interface. This allows enabling io_uring for individual listeners and
+ * clusters.
+ */
+class IoUringResolver : public Network::Address::Resolver {
+public:
+  // Network::Address::Resolver
+  Network::Address::InstanceConstSharedPtr
+  resolve(const envoy::config::core::v3::SocketAddress& socket_address) override;
+  std::string name() const override { return "envoy.resolvers.io_uring"; }
+};
+
+DECLARE_FACTORY(IoUringResolver);
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
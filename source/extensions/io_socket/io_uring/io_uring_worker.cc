@@ -0,0 +1,373 @@
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+
+#include "source/common/common/assert.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+namespace {
+// The buffer group of the receive buffers. Each worker owns its ring, so a single group suffices.
+constexpr uint16_t ReadBufferGroup = 0;
+// User data of the submissions whose completions are of no interest, i.e. cancellations and the
+// recycling of receive buffers.
+constexpr uint64_t IgnoredUserData = 0;
+// User data of the cancellation of all requests when the worker is destroyed. Requests are
+// aligned, so their addresses never collide with it.
+constexpr uint64_t CancelAllUserData = 1;
+} // namespace
+
+IoUringWorkerSharedPtr IoUringWorker::create(uint32_t io_uring_size, uint32_t read_buffer_size,
+                                             uint32_t read_buffer_count,
+                                             Event::Dispatcher& dispatcher) {
+  IoUringImplPtr ring = IoUringImpl::create(io_uring_size);
+  if (ring == nullptr) {
+    return nullptr;
+  }
+  auto worker = std::shared_ptr<IoUringWorker>(
+      new IoUringWorker(std::move(ring), read_buffer_size, read_buffer_count, dispatcher));
+  if (worker->event_fd_ == -1) {
+    return nullptr;
+  }
+  return worker;
+}
+
+IoUringWorker::IoUringWorker(IoUringImplPtr&& ring, uint32_t read_buffer_size,
+                             uint32_t read_buffer_count, Event::Dispatcher& dispatcher)
+    : ring_(std::move(ring)), dispatcher_(dispatcher),
+      submit_cb_(dispatcher.createSchedulableCallback([this]() { ring_->submit(); })),
+      read_buffer_size_(read_buffer_size), read_buffer_count_(read_buffer_count),
+      read_buffers_(static_cast<size_t>(read_buffer_size) * read_buffer_count) {
+  const int event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd == -1) {
+    return;
+  }
+  if (!ring_->registerEventfd(event_fd) ||
+      !ring_->prepareProvideBuffers(read_buffers_.data(), read_buffer_size_, read_buffer_count_,
+                                    ReadBufferGroup, 0, IgnoredUserData)) {
+    ::close(event_fd);
+    return;
+  }
+  available_read_buffers_ = read_buffer_count_;
+  event_fd_ = event_fd;
+  event_fd_event_ = dispatcher.createFileEvent(
+      event_fd_, [this](uint32_t) { onEventfdReady(); }, Event::PlatformDefaultTriggerType,
+      Event::FileReadyType::Read);
+  scheduleSubmit();
+}
+
+IoUringWorker::~IoUringWorker() {
+  event_fd_event_.reset();
+  // The kernel may complete the requests in flight into the requests and the receive buffers until
+  // their last completion, even once the ring is closed.
+  cancelAllRequests();
+  ring_.reset();
+  if (event_fd_ != -1) {
+    ::close(event_fd_);
+  }
+}
+
+Request* IoUringWorker::submitAccept(int fd, IoUringSocketCallbacks& callbacks) {
+  return addRequest(std::make_unique<Request>(RequestType::Accept, fd, &callbacks));
+}
+
+Request* IoUringWorker::submitRecv(int fd, IoUringSocketCallbacks& callbacks) {
+  return addRequest(std::make_unique<Request>(RequestType::Recv, fd, &callbacks));
+}
+
+Request* IoUringWorker::submitWrite(int fd, Buffer::Instance& data,
+                                    IoUringSocketCallbacks& callbacks) {
+  auto request = std::make_unique<Request>(RequestType::Write, fd, &callbacks);
+  request->write_buffer_.move(data);
+  Request* raw = request.get();
+  requests_.emplace(raw, std::move(request));
+  if (!prepare(*raw)) {
+    // Hand the data back so that the caller can retry.
+    data.move(raw->write_buffer_);
+    requests_.erase(raw);
+    return nullptr;
+  }
+  return raw;
+}
+
+Request* IoUringWorker::submitPoll(int fd, uint32_t events, IoUringSocketCallbacks& callbacks) {
+  auto request = std::make_unique<Request>(RequestType::Poll, fd, &callbacks);
+  request->poll_events_ = events;
+  return addRequest(std::move(request));
+}
+
+Request* IoUringWorker::addRequest(RequestPtr&& request) {
+  Request* raw = request.get();
+  requests_.emplace(raw, std::move(request));
+  if (!prepare(*raw)) {
+    requests_.erase(raw);
+    return nullptr;
+  }
+  return raw;
+}
+
+void IoUringWorker::cancel(Request& request) {
+  ASSERT(requests_.contains(&request));
+  request.callbacks_ = nullptr;
+  if (releaseIfWaitingForBuffers(request)) {
+    return;
+  }
+  if (request.type_ != RequestType::Write) {
+    ring_->prepareCancel(reinterpret_cast<uint64_t>(&request), IgnoredUserData);
+    scheduleSubmit();
+  }
+}
+
+void IoUringWorker::stopRecv(Request& request) {
+  ASSERT(requests_.contains(&request) && request.type_ == RequestType::Recv);
+  request.stopped_ = true;
+  if (releaseIfWaitingForBuffers(request)) {
+    return;
+  }
+  // A single shot receive ends with its next completion, which isn't followed by another
+  // submission.
+  if (request.multishot_) {
+    ring_->prepareCancel(reinterpret_cast<uint64_t>(&request), IgnoredUserData);
+    scheduleSubmit();
+  }
+}
+
+void IoUringWorker::submit() { ring_->submit(); }
+
+bool IoUringWorker::prepare(Request& request) {
+  const uint64_t user_data = reinterpret_cast<uint64_t>(&request);
+  bool prepared = false;
+  switch (request.type_) {
+  case RequestType::Accept:
+    request.multishot_ = multishot_accept_supported_;
+    prepared = ring_->prepareAccept(request.fd_, request.multishot_, user_data);
+    break;
+  case RequestType::Recv:
+    request.multishot_ = multishot_recv_supported_;
+    prepared = ring_->prepareRecv(request.fd_, ReadBufferGroup, request.multishot_, user_data);
+    break;
+  case RequestType::Write: {
+    const Buffer::RawSliceVector slices = request.write_buffer_.getRawSlices(IOV_MAX);
+    request.iovecs_.resize(slices.size());
+    for (size_t i = 0; i < slices.size(); ++i) {
+      request.iovecs_[i] = {slices[i].mem_, slices[i].len_};
+    }
+    prepared = ring_->prepareWritev(request.fd_, request.iovecs_.data(), request.iovecs_.size(),
+                                    user_data);
+    break;
+  }
+  case RequestType::Poll:
+    prepared = ring_->preparePollAdd(request.fd_, request.poll_events_, user_data);
+    break;
+  }
+  if (prepared) {
+    scheduleSubmit();
+  }
+  return prepared;
+}
+
+void IoUringWorker::scheduleSubmit() {
+  if (!submit_cb_->enabled()) {
+    submit_cb_->scheduleCallbackCurrentIteration();
+  }
+}
+
+void IoUringWorker::onEventfdReady() {
+  uint64_t value;
+  while (::read(event_fd_, &value, sizeof(value)) > 0) {
+  }
+  const uint32_t count =
+      ring_->forEveryCompletion([this](uint64_t user_data, int32_t result, uint32_t flags) {
+        if (user_data == IgnoredUserData) {
+          if (result < 0 && result != -ENOENT && result != -EALREADY) {
+            ENVOY_LOG(debug, "io_uring housekeeping submission failed: {}", -result);
+          }
+          return;
+        }
+        onCompletion(*reinterpret_cast<Request*>(user_data), result, flags);
+      });
+  ENVOY_LOG(trace, "io_uring worker reaped {} completions", count);
+}
+
+void IoUringWorker::onCompletion(Request& request, int32_t result, uint32_t flags) {
+  const bool more = flags & IORING_CQE_F_MORE;
+  bool rearm = false;
+  switch (request.type_) {
+  case RequestType::Accept:
+    if (result == -EINVAL && request.multishot_) {
+      // The kernel doesn't support multishot accept. Fall back to one accept per submission.
+      multishot_accept_supported_ = false;
+      rearm = request.callbacks_ != nullptr;
+      break;
+    }
+    if (request.callbacks_ != nullptr) {
+      request.callbacks_->onAccept(result);
+    } else if (result >= 0) {
+      ::close(result);
+    }
+    // A connection reset before it was accepted doesn't stop accepting.
+    rearm = !more && request.callbacks_ != nullptr &&
+            (result >= 0 || result == -ECONNABORTED || result == -EINTR || result == -EAGAIN);
+    break;
+  case RequestType::Recv:
+    if (flags & IORING_CQE_F_BUFFER) {
+      const uint16_t buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+      --available_read_buffers_;
+      if (request.callbacks_ != nullptr) {
+        request.callbacks_->onRecv(
+            result, absl::string_view(reinterpret_cast<const char*>(read_buffers_.data()) +
+                                          static_cast<size_t>(buffer_id) * read_buffer_size_,
+                                      result));
+      }
+      recycleBuffer(buffer_id);
+    } else if (result == -EINVAL && request.multishot_) {
+      // The kernel doesn't support multishot receive.
+      multishot_recv_supported_ = false;
+      rearm = request.callbacks_ != nullptr;
+      break;
+    } else if (result == -ENOBUFS) {
+      // All receive buffers are in use. Submitting the receive again right away would fail the
+      // same way until a buffer is returned, so it waits for one unless a buffer was already
+      // returned since the kernel failed the receive.
+      if (request.callbacks_ != nullptr && !request.stopped_ && available_read_buffers_ == 0) {
+        recvs_waiting_for_buffers_.push_back(&request);
+        return;
+      }
+      rearm = request.callbacks_ != nullptr;
+      break;
+    } else if (request.callbacks_ != nullptr) {
+      request.callbacks_->onRecv(result, {});
+    }
+    rearm = !more && request.callbacks_ != nullptr && result > 0;
+    break;
+  case RequestType::Write:
+    if (result > 0 && static_cast<uint64_t>(result) < request.write_buffer_.length() &&
+        request.callbacks_ != nullptr) {
+      request.write_buffer_.drain(result);
+      rearm = true;
+      break;
+    }
+    if (request.callbacks_ != nullptr) {
+      request.callbacks_->onWrite(result);
+    }
+    break;
+  case RequestType::Poll:
+    if (request.callbacks_ != nullptr) {
+      request.callbacks_->onPoll(result);
+    }
+    break;
+  }
+
+  if (more) {
+    return;
+  }
+  if (rearm && !request.stopped_ && prepare(request)) {
+    return;
+  }
+  releaseRequest(request);
+}
+
+void IoUringWorker::recycleBuffer(uint16_t buffer_id) {
+  ring_->prepareProvideBuffers(read_buffers_.data() +
+                                   static_cast<size_t>(buffer_id) * read_buffer_size_,
+                               read_buffer_size_, 1, ReadBufferGroup, buffer_id, IgnoredUserData);
+  ++available_read_buffers_;
+  scheduleSubmit();
+  // The receives are queued after the buffer, so the kernel has it when it runs them.
+  std::vector<Request*> waiting;
+  waiting.swap(recvs_waiting_for_buffers_);
+  for (Request* request : waiting) {
+    if (!prepare(*request)) {
+      releaseRequest(*request);
+    }
+  }
+}
+
+bool IoUringWorker::releaseIfWaitingForBuffers(Request& request) {
+  auto waiting = std::find(recvs_waiting_for_buffers_.begin(), recvs_waiting_for_buffers_.end(),
+                           &request);
+  if (waiting == recvs_waiting_for_buffers_.end()) {
+    return false;
+  }
+  // The receive isn't in flight, so there is nothing to cancel.
+  recvs_waiting_for_buffers_.erase(waiting);
+  releaseRequest(request);
+  return true;
+}
+
+void IoUringWorker::releaseRequest(Request& request) {
+  const RequestType type = request.type_;
+  IoUringSocketCallbacks* callbacks = request.callbacks_;
+  requests_.erase(&request);
+  if (callbacks != nullptr) {
+    callbacks->onRequestDone(type);
+  }
+}
+
+void IoUringWorker::cancelAllRequests() {
+  // The waiting receives aren't in flight.
+  for (Request* request : recvs_waiting_for_buffers_) {
+    requests_.erase(request);
+  }
+  recvs_waiting_for_buffers_.clear();
+  if (requests_.empty()) {
+    return;
+  }
+
+  const auto cancel_each_request = [this]() {
+    for (const auto& entry : requests_) {
+      ring_->prepareCancel(reinterpret_cast<uint64_t>(entry.first), IgnoredUserData);
+    }
+  };
+  for (const auto& entry : requests_) {
+    entry.first->callbacks_ = nullptr;
+  }
+  if (!ring_->prepareCancelAll(CancelAllUserData)) {
+    cancel_each_request();
+  }
+  while (!requests_.empty()) {
+    const int result = ring_->submitAndWait();
+    if (result < 0) {
+      ENVOY_LOG(error, "io_uring worker failed to wait for {} cancelled requests: {}",
+                requests_.size(), -result);
+      // Leak what the kernel may still write into rather than release it.
+      new absl::flat_hash_map<Request*, RequestPtr>(std::move(requests_));
+      new std::vector<uint8_t>(std::move(read_buffers_));
+      requests_.clear();
+      return;
+    }
+    ring_->forEveryCompletion(
+        [this, &cancel_each_request](uint64_t user_data, int32_t result, uint32_t flags) {
+          if (user_data == CancelAllUserData) {
+            if (result == -EINVAL) {
+              // The kernel only cancels requests by user data.
+              cancel_each_request();
+            }
+            return;
+          }
+          if (user_data == IgnoredUserData) {
+            return;
+          }
+          auto* request = reinterpret_cast<Request*>(user_data);
+          if (request->type_ == RequestType::Accept && result >= 0) {
+            ::close(result);
+          }
+          if (!(flags & IORING_CQE_F_MORE)) {
+            requests_.erase(request);
+          }
+        });
+  }
+}
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
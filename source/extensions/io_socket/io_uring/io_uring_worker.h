@@ -0,0 +1,195 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+#include "envoy/event/file_event.h"
+#include "envoy/event/schedulable_cb.h"
+#include "envoy/thread_local/thread_local_object.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/logger.h"
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+
+enum class RequestType { Accept, Recv, Write, Poll };
+
+/**
+ * Callbacks invoked by IoUringWorker when a request of a socket completes. All callbacks are
+ * invoked on the thread of the worker.
+ */
+class IoUringSocketCallbacks {
+public:
+  virtual ~IoUringSocketCallbacks() = default;
+
+  /**
+   * Called for every completion of an accept request.
+   * @param result supplies the accepted fd, or -errno on failure.
+   */
+  virtual void onAccept(int32_t result) PURE;
+
+  /**
+   * Called for every completion of a receive request.
+   * @param result supplies the number of bytes received, 0 on end of stream or -errno on failure.
+   * @param data supplies the received bytes. Only valid during the callback.
+   */
+  virtual void onRecv(int32_t result, absl::string_view data) PURE;
+
+  /**
+   * Called when a write request completes. Short writes are resubmitted by the worker, so this is
+   * only called once all data was written or the write failed.
+   * @param result supplies the number of bytes written by the last writev, or -errno on failure.
+   */
+  virtual void onWrite(int32_t result) PURE;
+
+  /**
+   * Called when a poll request completes.
+   * @param result supplies the returned events, or -errno on failure.
+   */
+  virtual void onPoll(int32_t result) PURE;
+
+  /**
+   * Called once a request will not post any more completions and has been released.
+   */
+  virtual void onRequestDone(RequestType type) PURE;
+};
+
+/**
+ * A request in flight on the ring. Its address is used as the submission's user data.
+ */
+struct Request {
+  Request(RequestType type, int fd, IoUringSocketCallbacks* callbacks)
+      : type_(type), fd_(fd), callbacks_(callbacks) {}
+
+  const RequestType type_;
+  const int fd_;
+  // Cleared once the owner of the request is no longer interested in its completions.
+  IoUringSocketCallbacks* callbacks_;
+  bool multishot_{};
+  // Set once a receive was stopped. Its completions are still delivered, but it isn't submitted
+  // again.
+  bool stopped_{};
+  // The events of a poll request.
+  uint32_t poll_events_{};
+  // The data of a write request, which must remain valid until the write completes.
+  Buffer::OwnedImpl write_buffer_;
+  std::vector<struct iovec> iovecs_;
+};
+
+using RequestPtr = std::unique_ptr<Request>;
+
+/**
+ * Drives the io_uring instance of one worker thread. Submissions made while the event loop runs
+ * are handed to the kernel in a single batch at the end of the loop iteration, and completions are
+ * reaped when the kernel signals the eventfd registered with the ring.
+ *
+ * Receives use a pool of buffers shared by all sockets of the worker. The kernel picks a buffer
+ * per completion; the data is copied out and the buffer returned to the pool immediately. A
+ * receive which found the pool empty is submitted again once a buffer was returned.
+ */
+class IoUringWorker : public ThreadLocal::ThreadLocalObject,
+                      protected Logger::Loggable<Logger::Id::io> {
+public:
+  /**
+   * @return a new worker for dispatcher, or nullptr if io_uring is unavailable on this host.
+   */
+  static std::shared_ptr<IoUringWorker> create(uint32_t io_uring_size, uint32_t read_buffer_size,
+                                               uint32_t read_buffer_count,
+                                               Event::Dispatcher& dispatcher);
+
+  ~IoUringWorker() override;
+
+  Event::Dispatcher& dispatcher() { return dispatcher_; }
+
+  /**
+   * Submits a multishot accept on the listening socket fd.
+   */
+  Request* submitAccept(int fd, IoUringSocketCallbacks& callbacks);
+
+  /**
+   * Submits a multishot receive on the connected socket fd.
+   */
+  Request* submitRecv(int fd, IoUringSocketCallbacks& callbacks);
+
+  /**
+   * Submits a write of all of data, which is moved into the request. data is left untouched if the
+   * write couldn't be submitted.
+   */
+  Request* submitWrite(int fd, Buffer::Instance& data, IoUringSocketCallbacks& callbacks);
+
+  /**
+   * Submits a one-shot poll for events on fd.
+   */
+  Request* submitPoll(int fd, uint32_t events, IoUringSocketCallbacks& callbacks);
+
+  /**
+   * Detaches a request from its owner, and cancels it unless it is a write. Writes are left to
+   * complete since their data may already be partially sent.
+   */
+  void cancel(Request& request);
+
+  /**
+   * Stops a receive without detaching it from its owner, which is handed the data of the
+   * completions the kernel posts until the last one, and then notified by onRequestDone().
+   */
+  void stopRecv(Request& request);
+
+  /**
+   * Hands queued submissions to the kernel right away rather than at the end of the loop
+   * iteration.
+   */
+  void submit();
+
+private:
+  IoUringWorker(IoUringImplPtr&& ring, uint32_t read_buffer_size, uint32_t read_buffer_count,
+                Event::Dispatcher& dispatcher);
+
+  Request* addRequest(RequestPtr&& request);
+  // Queues the submission for request. Returns false if the submission queue is full.
+  bool prepare(Request& request);
+  void scheduleSubmit();
+  void onEventfdReady();
+  void onCompletion(Request& request, int32_t result, uint32_t flags);
+  // Returns the provided buffer buffer_id to the kernel.
+  void recycleBuffer(uint16_t buffer_id);
+  // Releases request if it is a receive waiting for buffers. Returns whether it was.
+  bool releaseIfWaitingForBuffers(Request& request);
+  void releaseRequest(Request& request);
+  // Cancels all requests in flight and waits for their last completion, so that the kernel no
+  // longer refers to the requests nor the receive buffers.
+  void cancelAllRequests();
+
+  IoUringImplPtr ring_;
+  Event::Dispatcher& dispatcher_;
+  int event_fd_{-1};
+  Event::FileEventPtr event_fd_event_;
+  Event::SchedulableCallbackPtr submit_cb_;
+
+  const uint32_t read_buffer_size_;
+  const uint32_t read_buffer_count_;
+  std::vector<uint8_t> read_buffers_;
+  // The receive buffers handed to the kernel which weren't seen in a completion yet.
+  uint32_t available_read_buffers_{};
+  // The receives which completed with -ENOBUFS, submitted again once a buffer is returned.
+  std::vector<Request*> recvs_waiting_for_buffers_;
+
+  bool multishot_accept_supported_{true};
+  bool multishot_recv_supported_{true};
+  absl::flat_hash_map<Request*, RequestPtr> requests_;
+};
+
+using IoUringWorkerSharedPtr = std::shared_ptr<IoUringWorker>;
+
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
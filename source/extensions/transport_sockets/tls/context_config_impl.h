@@ -56,6 +56,7 @@ public:
   Ssl::HandshakerFactoryCb createHandshaker() const override;
   Ssl::HandshakerCapabilities capabilities() const override { return capabilities_; }
   Ssl::SslCtxCb sslctxCb() const override { return sslctx_cb_; }
+  bool kernelTlsOffload() const override { return kernel_tls_offload_; }
 
   Ssl::CertificateValidationContextConfigPtr getCombinedValidationContextConfig(
       const envoy::extensions::transport_sockets::tls::v3::CertificateValidationContext&
@@ -96,6 +97,7 @@ private:
   Envoy::Common::CallbackHandlePtr cvc_validation_callback_handle_;
   const unsigned min_protocol_version_;
   const unsigned max_protocol_version_;
+  const bool kernel_tls_offload_;
 
   Ssl::HandshakerFactoryCb handshaker_factory_cb_;
   Ssl::HandshakerCapabilities capabilities_;
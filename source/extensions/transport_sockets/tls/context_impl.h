@@ -66,6 +66,12 @@ public:
 
   SslStats& stats() { return stats_; }
 
+  /**
+   * @return true if sockets using this context should try to offload record encryption of sent
+   * application data to the kernel once the handshake has completed.
+   */
+  bool kernelTlsOffload() const { return kernel_tls_offload_; }
+
   /**
    * The global SSL-library index used for storing a pointer to the SslExtendedSocketInfo
    * class in the SSL instance, for retrieval in callbacks.
@@ -124,6 +130,7 @@ protected:
   const Stats::StatName ssl_curves_;
   const Stats::StatName ssl_sigalgs_;
   const Ssl::HandshakerCapabilities capabilities_;
+  bool kernel_tls_offload_;
 };
 
 using ContextImplSharedPtr = std::shared_ptr<ContextImpl>;
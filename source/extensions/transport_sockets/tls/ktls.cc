@@ -0,0 +1,149 @@
+#include "source/extensions/transport_sockets/tls/ktls.h"
+
+#include <cstring>
+#include <vector>
+
+#include "envoy/common/platform.h"
+
+#include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/common/assert.h"
+
+#if defined(__linux__) && __has_include(<linux/tls.h>)
+#include <netinet/tcp.h>
+
+#include <linux/tls.h>
+#define ENVOY_KERNEL_TLS 1
+#endif
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+#ifdef ENVOY_KERNEL_TLS
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+namespace {
+
+// TLS 1.2 AES-GCM key block layout (RFC 5246, section 6.3): the MAC keys are empty for AEAD
+// ciphers, followed by the client and server write keys and the client and server implicit
+// nonces (salts).
+template <class CryptoInfo, uint16_t CipherType>
+bool installTransmitKeys(SSL* ssl, Network::IoHandle& io_handle) {
+  CryptoInfo crypto_info{};
+  constexpr size_t key_size = sizeof(crypto_info.key);
+  constexpr size_t salt_size = sizeof(crypto_info.salt);
+  static_assert(sizeof(crypto_info.rec_seq) == sizeof(uint64_t));
+  static_assert(sizeof(crypto_info.iv) == sizeof(uint64_t));
+
+  std::vector<uint8_t> key_block(SSL_get_key_block_len(ssl));
+  if (key_block.size() != 2 * (key_size + salt_size) ||
+      SSL_generate_key_block(ssl, key_block.data(), key_block.size()) != 1) {
+    return false;
+  }
+  const bool is_server = SSL_is_server(ssl);
+  const uint8_t* key = key_block.data() + (is_server ? key_size : 0);
+  const uint8_t* salt = key_block.data() + 2 * key_size + (is_server ? salt_size : 0);
+
+  crypto_info.info.version = TLS_1_2_VERSION;
+  crypto_info.info.cipher_type = CipherType;
+  memcpy(crypto_info.key, key, key_size);
+  memcpy(crypto_info.salt, salt, salt_size);
+  // The record sequence number continues where BoringSSL stopped. BoringSSL uses the sequence
+  // number as the explicit nonce as well, so starting the kernel's nonce counter from it keeps
+  // nonces unique for this key.
+  uint64_t sequence = SSL_get_write_sequence(ssl);
+  for (int i = sizeof(crypto_info.rec_seq) - 1; i >= 0; --i) {
+    crypto_info.rec_seq[i] = sequence & 0xff;
+    sequence >>= 8;
+  }
+  memcpy(crypto_info.iv, crypto_info.rec_seq, sizeof(crypto_info.iv));
+
+  const bool installed =
+      io_handle.setOption(SOL_TLS, TLS_TX, &crypto_info, sizeof(crypto_info)).return_value_ == 0;
+  OPENSSL_cleanse(&crypto_info, sizeof(crypto_info));
+  OPENSSL_cleanse(key_block.data(), key_block.size());
+  return installed;
+}
+
+} // namespace
+
+bool enableKernelTlsTransmit(SSL* ssl, Network::IoHandle& io_handle) {
+  if (SSL_version(ssl) != TLS1_2_VERSION) {
+    return false;
+  }
+  const SSL_CIPHER* cipher = SSL_get_current_cipher(ssl);
+  if (cipher == nullptr) {
+    return false;
+  }
+  const int cipher_nid = SSL_CIPHER_get_cipher_nid(cipher);
+  if (cipher_nid != NID_aes_128_gcm && cipher_nid != NID_aes_256_gcm) {
+    return false;
+  }
+
+  // Attaching the ULP fails if the kernel has no TLS support or the socket isn't TCP. Until
+  // transmit keys are set, the ULP passes writes through unchanged, so failing after this point
+  // leaves the socket usable by BoringSSL.
+  static constexpr char ulp_name[] = "tls";
+  if (io_handle.setOption(IPPROTO_TCP, TCP_ULP, ulp_name, sizeof(ulp_name) - 1).return_value_ !=
+      0) {
+    return false;
+  }
+  const bool installed =
+      cipher_nid == NID_aes_128_gcm
+          ? installTransmitKeys<tls12_crypto_info_aes_gcm_128, TLS_CIPHER_AES_GCM_128>(ssl,
+                                                                                     io_handle)
+          : installTransmitKeys<tls12_crypto_info_aes_gcm_256, TLS_CIPHER_AES_GCM_256>(ssl,
+                                                                                     io_handle);
+  if (installed) {
+    // The records BoringSSL would still write, e.g. the alert it sends when a received record
+    // fails to decrypt, would be framed again by the kernel as application data. BoringSSL writes
+    // to a read-only BIO instead, so that these writes fail without reaching the socket.
+    BIO* write_bio = BIO_new_mem_buf("", 0);
+    RELEASE_ASSERT(write_bio != nullptr, "");
+    SSL_set0_wbio(ssl, write_bio);
+  }
+  return installed;
+}
+
+Api::SysCallSizeResult sendKernelTlsCloseNotify(Network::IoHandle& io_handle) {
+  // Alert level warning(1), description close_notify(0), sent as a record of content type
+  // alert(21).
+  uint8_t alert[] = {1, 0};
+  iovec iov;
+  iov.iov_base = alert;
+  iov.iov_len = sizeof(alert);
+  char control[CMSG_SPACE(sizeof(uint8_t))]{};
+  msghdr message{};
+  message.msg_iov = &iov;
+  message.msg_iovlen = 1;
+  message.msg_control = control;
+  message.msg_controllen = sizeof(control);
+  cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+  cmsg->cmsg_level = SOL_TLS;
+  cmsg->cmsg_type = TLS_SET_RECORD_TYPE;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint8_t));
+  *CMSG_DATA(cmsg) = 21;
+  return Api::OsSysCallsSingleton::get().sendmsg(io_handle.fdDoNotUse(), &message, 0);
+}
+
+#else
+
+bool enableKernelTlsTransmit(SSL*, Network::IoHandle&) { return false; }
+
+Api::SysCallSizeResult sendKernelTlsCloseNotify(Network::IoHandle&) {
+  return {-1, SOCKET_ERROR_NOT_SUP};
+}
+
+#endif
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "envoy/api/os_sys_calls_common.h"
+#include "envoy/network/io_handle.h"
+
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+
+/**
+ * Hands the transmit keys negotiated on a completed TLS session over to the kernel TLS module of
+ * the underlying socket. From then on application data must be written to the socket in
+ * plaintext and the kernel frames and encrypts the records, while received records are still
+ * read and decrypted by BoringSSL, which can't write to the socket anymore: the alerts it would
+ * send are dropped. Only TLS 1.2 with an AES-GCM cipher suite is supported.
+ * @param ssl the session whose handshake has completed and whose write buffer is flushed.
+ * @param io_handle the socket the session writes to.
+ * @return true if the kernel encrypts sent records from now on. If false, BoringSSL must keep
+ *         encrypting sent records.
+ */
+bool enableKernelTlsTransmit(SSL* ssl, Network::IoHandle& io_handle);
+
+/**
+ * Sends a close_notify alert on a socket for which enableKernelTlsTransmit() succeeded.
+ * @param io_handle the socket to send the alert on.
+ * @return the result of the underlying sendmsg call.
+ */
+Api::SysCallSizeResult sendKernelTlsCloseNotify(Network::IoHandle& io_handle);
+
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
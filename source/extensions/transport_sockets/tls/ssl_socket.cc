@@ -8,6 +8,7 @@
 #include "source/common/http/headers.h"
 #include "source/common/runtime/runtime_features.h"
 #include "source/extensions/transport_sockets/tls/io_handle_bio.h"
+#include "source/extensions/transport_sockets/tls/ktls.h"
 #include "source/extensions/transport_sockets/tls/ssl_handshaker.h"
 #include "source/extensions/transport_sockets/tls/utility.h"
 
@@ -179,9 +180,25 @@ Network::Connection& SslSocket::connection() const { return callbacks_->connecti
 
 void SslSocket::onSuccess(SSL* ssl) {
   ctx_->logHandshake(ssl);
+  if (ctx_->kernelTlsOffload()) {
+    enableKernelTls(ssl);
+  }
   callbacks_->raiseEvent(Network::ConnectionEvent::Connected);
 }
 
+void SslSocket::enableKernelTls(SSL* ssl) {
+  if (enableKernelTlsTransmit(ssl, callbacks_->ioHandle())) {
+    ENVOY_CONN_LOG(debug, "TLS record encryption offloaded to the kernel",
+                   callbacks_->connection());
+    kernel_tls_transmit_ = true;
+    ctx_->stats().ktls_tx_offloaded_.inc();
+  } else {
+    ENVOY_CONN_LOG(debug, "TLS record encryption not offloaded to the kernel, version {} cipher {}",
+                   callbacks_->connection(), SSL_get_version(ssl), SSL_get_cipher_name(ssl));
+    ctx_->stats().ktls_tx_fallback_.inc();
+  }
+}
+
 void SslSocket::onFailure() { drainErrorQueue(); }
 
 PostIoAction SslSocket::doHandshake() { return info_->doHandshake(); }
@@ -231,6 +248,10 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
     }
   }
 
+  if (kernel_tls_transmit_) {
+    return doKernelTlsWrite(write_buffer, end_stream);
+  }
+
   uint64_t bytes_to_write;
   if (bytes_to_retry_) {
     bytes_to_write = bytes_to_retry_;
@@ -281,6 +302,31 @@ Network::IoResult SslSocket::doWrite(Buffer::Instance& write_buffer, bool end_st
   return {PostIoAction::KeepOpen, total_bytes_written, false};
 }
 
+Network::IoResult SslSocket::doKernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream) {
+  // The kernel splits the plaintext into records, so the buffer is written without linearizing.
+  uint64_t total_bytes_written = 0;
+  while (write_buffer.length() > 0) {
+    Api::IoCallUint64Result result = callbacks_->ioHandle().write(write_buffer);
+    if (!result.ok()) {
+      ENVOY_CONN_LOG(trace, "kernel tls write error: {}", callbacks_->connection(),
+                     result.err_->getErrorDetails());
+      if (result.err_->getErrorCode() == Api::IoError::IoErrorCode::Again) {
+        break;
+      }
+      return {PostIoAction::Close, total_bytes_written, false};
+    }
+    ENVOY_CONN_LOG(trace, "kernel tls write returns: {}", callbacks_->connection(),
+                   result.return_value_);
+    total_bytes_written += result.return_value_;
+  }
+
+  if (write_buffer.length() == 0 && end_stream) {
+    shutdownSsl();
+  }
+
+  return {PostIoAction::KeepOpen, total_bytes_written, false};
+}
+
 void SslSocket::onConnected() { ASSERT(info_->state() == Ssl::SocketState::PreHandshake); }
 
 Ssl::ConnectionInfoConstSharedPtr SslSocket::ssl() const { return info_; }
@@ -289,6 +335,14 @@ void SslSocket::shutdownSsl() {
   ASSERT(info_->state() != Ssl::SocketState::PreHandshake);
   if (info_->state() != Ssl::SocketState::ShutdownSent &&
       callbacks_->connection().state() != Network::Connection::State::Closed) {
+    if (kernel_tls_transmit_) {
+      // BoringSSL can't write to the socket anymore, so the kernel sends the close_notify alert.
+      const Api::SysCallSizeResult result = sendKernelTlsCloseNotify(callbacks_->ioHandle());
+      ENVOY_CONN_LOG(debug, "kernel TLS shutdown: rc={}", callbacks_->connection(),
+                     result.return_value_);
+      info_->setState(Ssl::SocketState::ShutdownSent);
+      return;
+    }
     int rc = SSL_shutdown(rawSsl());
     if constexpr (Event::PlatformDefaultTriggerType == Event::FileTriggerType::EmulatedEdge) {
       // Windows operate under `EmulatedEdge`. These are level events that are artificially
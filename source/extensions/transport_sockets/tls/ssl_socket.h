@@ -83,6 +83,8 @@ private:
   ReadResult sslReadIntoSlice(Buffer::RawSlice& slice);
 
   Network::PostIoAction doHandshake();
+  void enableKernelTls(SSL* ssl);
+  Network::IoResult doKernelTlsWrite(Buffer::Instance& write_buffer, bool end_stream);
   void drainErrorQueue();
   void shutdownSsl();
   void shutdownBasic();
@@ -92,6 +94,9 @@ private:
   ContextImplSharedPtr ctx_;
   uint64_t bytes_to_retry_{};
   std::string failure_reason_;
+  // Set once the kernel encrypts sent records. Received records are still decrypted by
+  // BoringSSL, which must not write to the socket anymore.
+  bool kernel_tls_transmit_{};
 
   SslHandshakerImplSharedPtr info_;
 };
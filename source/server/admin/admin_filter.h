@@ -51,6 +51,7 @@ public:
   Http::Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override {
     return encoder_callbacks_->http1StreamEncoderOptions();
   }
+  bool canStreamResponse() const override { return decoder_callbacks_ != nullptr; }
 
 private:
   /**
@@ -1,5 +1,8 @@
 #include "source/server/admin/prometheus_stats.h"
 
+#include <algorithm>
+#include <limits>
+
 #include "source/common/common/empty_string.h"
 #include "source/common/common/macros.h"
 #include "source/common/common/regex.h"
@@ -48,113 +51,22 @@ struct MetricLessThan {
   }
 };
 
-/**
- * Processes a stat type (counter, gauge, histogram) by generating all output lines, sorting
- * them by tag-extracted metric name, and then outputting them in the correct sorted order into
- * response.
- *
- * @param response The buffer to put the output into.
- * @param used_only Whether to only output stats that are used.
- * @param regex A filter on which stats to output.
- * @param metrics The metrics to output stats for. This must contain all stats of the given type
- *        to be included in the same output.
- * @param generate_output A function which returns the output text for this metric.
- * @param type The name of the prometheus metric type for used in TYPE annotations.
- */
-template <class StatType>
-uint64_t outputStatType(
-    Buffer::Instance& response, const bool used_only, const absl::optional<std::regex>& regex,
-    const std::vector<Stats::RefcountPtr<StatType>>& metrics,
-    const std::function<std::string(
-        const StatType& metric, const std::string& prefixed_tag_extracted_name)>& generate_output,
-    absl::string_view type, const Stats::CustomStatNamespaces& custom_namespaces) {
-
-  /*
-   * From
-   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
-   *
-   * All lines for a given metric must be provided as one single group, with the optional HELP and
-   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
-   * expositions is preferred but not required, i.e. do not sort if the computational cost is
-   * prohibitive.
-   */
-
-  // This is an unsorted collection of dumb-pointers (no need to increment then decrement every
-  // refcount; ownership is held throughout by `metrics`). It is unsorted for efficiency, but will
-  // be sorted before producing the final output to satisfy the "preferred" ordering from the
-  // prometheus spec: metrics will be sorted by their tags' textual representation, which will be
-  // consistent across calls.
-  using StatTypeUnsortedCollection = std::vector<const StatType*>;
-
-  // Return early to avoid crashing when getting the symbol table from the first metric.
-  if (metrics.empty()) {
-    return 0;
-  }
-
-  // There should only be one symbol table for all of the stats in the admin
-  // interface. If this assumption changes, the name comparisons in this function
-  // will have to change to compare to convert all StatNames to strings before
-  // comparison.
-  const Stats::SymbolTable& global_symbol_table = metrics.front()->constSymbolTable();
-
-  // Sorted collection of metrics sorted by their tagExtractedName, to satisfy the requirements
-  // of the exposition format.
-  std::map<Stats::StatName, StatTypeUnsortedCollection, Stats::StatNameLessThan> groups(
-      global_symbol_table);
-
-  for (const auto& metric : metrics) {
-    ASSERT(&global_symbol_table == &metric->constSymbolTable());
-
-    if (!shouldShowMetric(*metric, used_only, regex)) {
-      continue;
-    }
-
-    groups[metric->tagExtractedStatName()].push_back(metric.get());
-  }
-
-  auto result = groups.size();
-  for (auto& group : groups) {
-    const absl::optional<std::string> prefixed_tag_extracted_name =
-        PrometheusStatsFormatter::metricName(global_symbol_table.toString(group.first),
-                                             custom_namespaces);
-    if (!prefixed_tag_extracted_name.has_value()) {
-      --result;
-      continue;
-    }
-    response.add(fmt::format("# TYPE {0} {1}\n", prefixed_tag_extracted_name.value(), type));
-
-    // Sort before producing the final output to satisfy the "preferred" ordering from the
-    // prometheus spec: metrics will be sorted by their tags' textual representation, which will
-    // be consistent across calls.
-    std::sort(group.second.begin(), group.second.end(), MetricLessThan());
-
-    for (const auto& metric : group.second) {
-      response.add(generate_output(*metric, prefixed_tag_extracted_name.value()));
-    }
-    response.add("\n");
-  }
-  return result;
-}
-
 /*
- * Return the prometheus output for a numeric Stat (Counter or Gauge).
+ * Adds the prometheus output for a numeric Stat (Counter or Gauge).
  */
 template <class StatType>
-std::string generateNumericOutput(const StatType& metric,
-                                  const std::string& prefixed_tag_extracted_name) {
-  const std::string tags = PrometheusStatsFormatter::formattedTags(metric.tags());
-  return fmt::format("{0}{{{1}}} {2}\n", prefixed_tag_extracted_name, tags, metric.value());
+void addMetricOutput(Buffer::Instance& response, const StatType& metric,
+                     const std::string& prefixed_tag_extracted_name, const std::string& tags) {
+  response.add(fmt::format("{0}{{{1}}} {2}\n", prefixed_tag_extracted_name, tags, metric.value()));
 }
 
 /*
- * Returns the prometheus output for a histogram. The output is a multi-line string (with embedded
- * newlines) that contains all the individual bucket counts and sum/count for a single histogram
- * (metric_name plus all tags).
+ * Adds the prometheus output for a histogram. The output is multiple lines that contain all the
+ * individual bucket counts and sum/count for a single histogram (metric_name plus all tags).
  */
-std::string generateHistogramOutput(const Stats::ParentHistogram& histogram,
-                                    const std::string& prefixed_tag_extracted_name) {
-  const std::string tags = PrometheusStatsFormatter::formattedTags(histogram.tags());
-  const std::string hist_tags = histogram.tags().empty() ? EMPTY_STRING : (tags + ",");
+void addMetricOutput(Buffer::Instance& response, const Stats::ParentHistogram& histogram,
+                     const std::string& prefixed_tag_extracted_name, const std::string& tags) {
+  const std::string hist_tags = tags.empty() ? EMPTY_STRING : (tags + ",");
 
   const Stats::HistogramStatistics& stats = histogram.cumulativeStatistics();
   Stats::ConstSupportedBuckets& supported_buckets = stats.supportedBuckets();
@@ -178,9 +90,8 @@ std::string generateHistogramOutput(const Stats::ParentHistogram& histogram,
                             stats.sampleSum()));
   output.append(fmt::format("{0}_count{{{1}}} {2}\n", prefixed_tag_extracted_name, tags,
                             stats.sampleCount()));
-
-  return output;
-};
+  response.add(output);
+}
 
 } // namespace
 
@@ -219,28 +130,179 @@ PrometheusStatsFormatter::metricName(const std::string& extracted_name,
   return absl::StrCat("envoy_", sanitizeName(extracted_name));
 }
 
+PrometheusTagsCache::~PrometheusTagsCache() {
+  for (auto& entry : entries_) {
+    entry.second.name_.free(symbol_table_);
+  }
+}
+
+const std::string& PrometheusTagsCache::formattedTags(const Stats::Metric& metric) {
+  ASSERT(&metric.constSymbolTable() == &symbol_table_);
+  auto iter = entries_.find(metric.statName());
+  if (iter == entries_.end()) {
+    Stats::StatNameStorage name(metric.statName(), symbol_table_);
+    const Stats::StatName key = name.statName();
+    iter = entries_
+               .emplace(key, Entry{std::move(name),
+                                   PrometheusStatsFormatter::formattedTags(metric.tags()),
+                                   generation_})
+               .first;
+  }
+  iter->second.used_generation_ = generation_;
+  return iter->second.tags_;
+}
+
+void PrometheusTagsCache::evictUnusedSince(uint64_t generation) {
+  for (auto iter = entries_.begin(); iter != entries_.end();) {
+    Entry& entry = iter->second;
+    if (entry.used_generation_ >= generation) {
+      ++iter;
+    } else {
+      entry.name_.free(symbol_table_);
+      entries_.erase(iter++);
+    }
+  }
+  ++generation_;
+}
+
+PrometheusStatsRenderer::PrometheusStatsRenderer(
+    std::vector<Stats::CounterSharedPtr>&& counters, std::vector<Stats::GaugeSharedPtr>&& gauges,
+    std::vector<Stats::ParentHistogramSharedPtr>&& histograms, const bool used_only,
+    const absl::optional<std::regex>& regex, const Stats::CustomStatNamespaces& custom_namespaces,
+    PrometheusTagsCache* tags_cache)
+    : counters_(std::move(counters), "counter"), gauges_(std::move(gauges), "gauge"),
+      histograms_(std::move(histograms), "histogram"), used_only_(used_only), regex_(regex),
+      custom_namespaces_(custom_namespaces), tags_cache_(tags_cache),
+      tags_cache_generation_(tags_cache != nullptr ? tags_cache->generation() : 0) {}
+
 // TODO(efimki): Add support of text readouts stats.
+bool PrometheusStatsRenderer::nextChunk(Buffer::Instance& response, uint64_t chunk_size_bytes) {
+  const bool done = renderStatType(counters_, response, chunk_size_bytes) &&
+                    renderStatType(gauges_, response, chunk_size_bytes) &&
+                    renderStatType(histograms_, response, chunk_size_bytes);
+  // Only the scrapes rendering all the stats know which entries are unused.
+  if (done && tags_cache_ != nullptr && !used_only_ && !regex_.has_value()) {
+    tags_cache_->evictUnusedSince(tags_cache_generation_);
+  }
+  return !done;
+}
+
+template <class StatType>
+void PrometheusStatsRenderer::groupMetrics(StatTypeGroups<StatType>& stat_type) {
+  stat_type.grouped_ = true;
+  // Return early to avoid crashing when getting the symbol table from the first metric.
+  if (stat_type.metrics_.empty()) {
+    return;
+  }
+
+  // There should only be one symbol table for all of the stats in the admin
+  // interface. If this assumption changes, the name comparisons in this function
+  // will have to change to compare to convert all StatNames to strings before
+  // comparison.
+  const Stats::SymbolTable& global_symbol_table = stat_type.metrics_.front()->constSymbolTable();
+
+  // Grouping by the encoded name avoids taking the symbol table lock for every metric, only the
+  // groups are sorted by their name.
+  Stats::StatNameHashMap<std::vector<const StatType*>> groups;
+  for (const auto& metric : stat_type.metrics_) {
+    ASSERT(&global_symbol_table == &metric->constSymbolTable());
+
+    if (!shouldShowMetric(*metric, used_only_, regex_)) {
+      continue;
+    }
+
+    groups[metric->tagExtractedStatName()].push_back(metric.get());
+  }
+
+  stat_type.groups_.reserve(groups.size());
+  for (auto& group : groups) {
+    stat_type.groups_.emplace_back(group.first, std::move(group.second));
+  }
+  const Stats::StatNameLessThan less_than(global_symbol_table);
+  std::sort(stat_type.groups_.begin(), stat_type.groups_.end(),
+            [&less_than](const auto& a, const auto& b) { return less_than(a.first, b.first); });
+}
+
+/**
+ * Renders a stat type (counter, gauge, histogram) group by group, sorted by tag-extracted metric
+ * name, until the response reaches chunk_size_bytes.
+ *
+ * @return bool whether all metrics of the stat type were rendered.
+ */
+template <class StatType>
+bool PrometheusStatsRenderer::renderStatType(StatTypeGroups<StatType>& stat_type,
+                                             Buffer::Instance& response,
+                                             uint64_t chunk_size_bytes) {
+  /*
+   * From
+   * https:*github.com/prometheus/docs/blob/master/content/docs/instrumenting/exposition_formats.md#grouping-and-sorting:
+   *
+   * All lines for a given metric must be provided as one single group, with the optional HELP and
+   * TYPE lines first (in no particular order). Beyond that, reproducible sorting in repeated
+   * expositions is preferred but not required, i.e. do not sort if the computational cost is
+   * prohibitive.
+   */
+  if (!stat_type.grouped_) {
+    groupMetrics(stat_type);
+  }
+
+  while (stat_type.group_index_ < stat_type.groups_.size()) {
+    auto& group = stat_type.groups_[stat_type.group_index_];
+    if (!stat_type.group_name_.has_value()) {
+      stat_type.group_name_ = PrometheusStatsFormatter::metricName(
+          group.second.front()->constSymbolTable().toString(group.first), custom_namespaces_);
+      if (!stat_type.group_name_.has_value()) {
+        ++stat_type.group_index_;
+        continue;
+      }
+      ++metric_name_count_;
+      response.add(fmt::format("# TYPE {0} {1}\n", stat_type.group_name_.value(), stat_type.type_));
+
+      // Sort before producing the final output to satisfy the "preferred" ordering from the
+      // prometheus spec: metrics will be sorted by their tags' textual representation, which will
+      // be consistent across calls.
+      std::sort(group.second.begin(), group.second.end(), MetricLessThan());
+    }
+
+    while (stat_type.metric_index_ < group.second.size()) {
+      const StatType& metric = *group.second[stat_type.metric_index_++];
+      addMetricOutput(response, metric, stat_type.group_name_.value(), formattedTags(metric));
+      if (response.length() >= chunk_size_bytes) {
+        return false;
+      }
+    }
+    response.add("\n");
+
+    // The group won't be looked at again.
+    group.second = {};
+    stat_type.group_name_.reset();
+    stat_type.metric_index_ = 0;
+    ++stat_type.group_index_;
+  }
+  return true;
+}
+
+const std::string& PrometheusStatsRenderer::formattedTags(const Stats::Metric& metric) {
+  if (tags_cache_ != nullptr) {
+    return tags_cache_->formattedTags(metric);
+  }
+  tags_ = PrometheusStatsFormatter::formattedTags(metric.tags());
+  return tags_;
+}
+
 uint64_t PrometheusStatsFormatter::statsAsPrometheus(
     const std::vector<Stats::CounterSharedPtr>& counters,
     const std::vector<Stats::GaugeSharedPtr>& gauges,
     const std::vector<Stats::ParentHistogramSharedPtr>& histograms, Buffer::Instance& response,
     const bool used_only, const absl::optional<std::regex>& regex,
     const Stats::CustomStatNamespaces& custom_namespaces) {
-
-  uint64_t metric_name_count = 0;
-  metric_name_count += outputStatType<Stats::Counter>(response, used_only, regex, counters,
-                                                      generateNumericOutput<Stats::Counter>,
-                                                      "counter", custom_namespaces);
-
-  metric_name_count +=
-      outputStatType<Stats::Gauge>(response, used_only, regex, gauges,
-                                   generateNumericOutput<Stats::Gauge>, "gauge", custom_namespaces);
-
-  metric_name_count += outputStatType<Stats::ParentHistogram>(response, used_only, regex,
-                                                              histograms, generateHistogramOutput,
-                                                              "histogram", custom_namespaces);
-
-  return metric_name_count;
+  PrometheusStatsRenderer renderer(std::vector<Stats::CounterSharedPtr>(counters),
+                                   std::vector<Stats::GaugeSharedPtr>(gauges),
+                                   std::vector<Stats::ParentHistogramSharedPtr>(histograms),
+                                   used_only, regex, custom_namespaces, nullptr);
+  while (renderer.nextChunk(response, std::numeric_limits<uint64_t>::max())) {
+  }
+  return renderer.metricNameCount();
 }
 
 } // namespace Server
@@ -2,12 +2,18 @@
 
 #include <regex>
 #include <string>
+#include <vector>
 
 #include "envoy/buffer/buffer.h"
 #include "envoy/stats/custom_stat_namespaces.h"
 #include "envoy/stats/histogram.h"
 #include "envoy/stats/stats.h"
 
+#include "source/common/common/non_copyable.h"
+#include "source/common/stats/symbol_table_impl.h"
+
+#include "absl/types/optional.h"
+
 namespace Envoy {
 namespace Server {
 /**
@@ -45,5 +51,119 @@ public:
              const Stats::CustomStatNamespaces& custom_namespace_factory);
 };
 
+/**
+ * Cache of the formatted tags of the stats rendered to Prometheus, so that repeated scrapes don't
+ * decode and format the tags of every stat again. Entries keep a reference on the symbols of
+ * their stat's name, so an entry can't be matched by a different stat reusing the symbols. Must
+ * only be used from the main thread.
+ */
+class PrometheusTagsCache : NonCopyable {
+public:
+  explicit PrometheusTagsCache(Stats::SymbolTable& symbol_table) : symbol_table_(symbol_table) {}
+  ~PrometheusTagsCache();
+
+  /**
+   * @return the tags of the metric as formatted by PrometheusStatsFormatter::formattedTags().
+   */
+  const std::string& formattedTags(const Stats::Metric& metric);
+
+  /**
+   * @return the current generation of the cache, which scrapes record when they start.
+   */
+  uint64_t generation() const { return generation_; }
+
+  /**
+   * Drops the entries that were not used since the given generation, and starts a new generation,
+   * so that the cache doesn't retain the entries of deleted stats. Called at the end of the
+   * scrapes rendering all the stats, with the generation at their start: any entry not used since
+   * then belongs to a deleted stat, even when other scrapes ran meanwhile. Scrapes rendering a
+   * subset of the stats don't evict, as they don't use the entries of the other stats.
+   */
+  void evictUnusedSince(uint64_t generation);
+
+  uint64_t size() const { return entries_.size(); }
+
+private:
+  struct Entry {
+    Stats::StatNameStorage name_;
+    std::string tags_;
+    // Generation of the last use of the entry.
+    uint64_t used_generation_;
+  };
+
+  Stats::SymbolTable& symbol_table_;
+  // Keyed by the name held by the entry.
+  Stats::StatNameHashMap<Entry> entries_;
+  uint64_t generation_{};
+};
+
+/**
+ * Renders the Prometheus exposition of a set of stats incrementally, so that the output of a large
+ * number of stats can be written out in chunks across dispatcher iterations rather than in one
+ * buffer. The renderer holds a reference to the stats until it is destroyed.
+ */
+class PrometheusStatsRenderer {
+public:
+  /**
+   * @param tags_cache optional cache of the formatted tags, which must outlive the renderer.
+   */
+  PrometheusStatsRenderer(std::vector<Stats::CounterSharedPtr>&& counters,
+                          std::vector<Stats::GaugeSharedPtr>&& gauges,
+                          std::vector<Stats::ParentHistogramSharedPtr>&& histograms,
+                          const bool used_only, const absl::optional<std::regex>& regex,
+                          const Stats::CustomStatNamespaces& custom_namespaces,
+                          PrometheusTagsCache* tags_cache);
+
+  /**
+   * Appends the output of the next metrics to the response. Rendering stops after the first
+   * metric which makes the response reach chunk_size_bytes, so the response may exceed it by the
+   * output of one metric.
+   * @return bool whether there is more output to render.
+   */
+  bool nextChunk(Buffer::Instance& response, uint64_t chunk_size_bytes);
+
+  /**
+   * @return uint64_t total number of metric types rendered so far.
+   */
+  uint64_t metricNameCount() const { return metric_name_count_; }
+
+private:
+  // The metrics of one stat type, grouped by their tag-extracted name, and the position of the
+  // rendering within them.
+  template <class StatType> struct StatTypeGroups {
+    StatTypeGroups(std::vector<Stats::RefcountPtr<StatType>>&& metrics, absl::string_view type)
+        : metrics_(std::move(metrics)), type_(type) {}
+
+    std::vector<Stats::RefcountPtr<StatType>> metrics_;
+    const absl::string_view type_;
+    // Sorted by the tag-extracted name, built on the first call to nextChunk().
+    std::vector<std::pair<Stats::StatName, std::vector<const StatType*>>> groups_;
+    bool grouped_{};
+    size_t group_index_{};
+    size_t metric_index_{};
+    // The prefixed tag-extracted name of groups_[group_index_], if it was started.
+    absl::optional<std::string> group_name_;
+  };
+
+  template <class StatType>
+  bool renderStatType(StatTypeGroups<StatType>& stat_type, Buffer::Instance& response,
+                      uint64_t chunk_size_bytes);
+  template <class StatType> void groupMetrics(StatTypeGroups<StatType>& stat_type);
+  const std::string& formattedTags(const Stats::Metric& metric);
+
+  StatTypeGroups<Stats::Counter> counters_;
+  StatTypeGroups<Stats::Gauge> gauges_;
+  StatTypeGroups<Stats::ParentHistogram> histograms_;
+  const bool used_only_;
+  const absl::optional<std::regex> regex_;
+  const Stats::CustomStatNamespaces& custom_namespaces_;
+  PrometheusTagsCache* const tags_cache_;
+  // Generation of tags_cache_ when the rendering started.
+  const uint64_t tags_cache_generation_;
+  // Holds the formatted tags of the current metric when there is no tags_cache_.
+  std::string tags_;
+  uint64_t metric_name_count_{};
+};
+
 } // namespace Server
 } // namespace Envoy
@@ -1,5 +1,7 @@
 #include "source/server/admin/stats_handler.h"
 
+#include <limits>
+
 #include "envoy/admin/v3/mutex_stats.pb.h"
 
 #include "source/common/common/empty_string.h"
@@ -14,6 +16,79 @@ namespace Server {
 
 const uint64_t RecentLookupsCapacity = 100;
 
+namespace {
+
+// The size of the chunks large Prometheus scrapes are written out in.
+constexpr uint64_t PrometheusChunkSizeBytes = 64 * 1024;
+
+/**
+ * Writes out the remainder of a Prometheus scrape which didn't fit into the initial response, one
+ * chunk per dispatcher iteration, so that a large scrape doesn't block the main thread and isn't
+ * buffered in full. Rendering pauses while the downstream is above its write buffer high
+ * watermark.
+ */
+class PrometheusStatsStream : public Http::DownstreamWatermarkCallbacks,
+                              public std::enable_shared_from_this<PrometheusStatsStream> {
+public:
+  PrometheusStatsStream(std::unique_ptr<PrometheusStatsRenderer>&& renderer,
+                        std::shared_ptr<PrometheusTagsCache> tags_cache,
+                        Event::Dispatcher& dispatcher,
+                        Http::StreamDecoderFilterCallbacks& callbacks)
+      : renderer_(std::move(renderer)), tags_cache_(std::move(tags_cache)),
+        dispatcher_(dispatcher), callbacks_(callbacks) {}
+
+  void start(AdminStream& admin_stream) {
+    admin_stream.setEndStreamOnComplete(false);
+    // The admin stream holds a reference until it is destroyed, the callbacks can't outlive it.
+    admin_stream.addOnDestroyCallback([self = shared_from_this()]() { self->destroyed_ = true; });
+    callbacks_.addDownstreamWatermarkCallbacks(*this);
+    scheduleNextChunk();
+  }
+
+  // Http::DownstreamWatermarkCallbacks
+  void onAboveWriteBufferHighWatermark() override { ++high_watermark_count_; }
+  void onBelowWriteBufferLowWatermark() override {
+    ASSERT(high_watermark_count_ > 0);
+    --high_watermark_count_;
+    scheduleNextChunk();
+  }
+
+private:
+  void scheduleNextChunk() {
+    if (scheduled_ || destroyed_ || renderer_ == nullptr || high_watermark_count_ > 0) {
+      return;
+    }
+    scheduled_ = true;
+    dispatcher_.post([self = shared_from_this()]() { self->writeNextChunk(); });
+  }
+
+  void writeNextChunk() {
+    scheduled_ = false;
+    if (destroyed_ || high_watermark_count_ > 0) {
+      return;
+    }
+    Buffer::OwnedImpl chunk;
+    const bool end_stream = !renderer_->nextChunk(chunk, PrometheusChunkSizeBytes);
+    if (end_stream) {
+      renderer_.reset();
+      callbacks_.removeDownstreamWatermarkCallbacks(*this);
+    }
+    callbacks_.encodeData(chunk, end_stream);
+    scheduleNextChunk();
+  }
+
+  std::unique_ptr<PrometheusStatsRenderer> renderer_;
+  // Keeps the cache used by renderer_ alive.
+  const std::shared_ptr<PrometheusTagsCache> tags_cache_;
+  Event::Dispatcher& dispatcher_;
+  Http::StreamDecoderFilterCallbacks& callbacks_;
+  uint32_t high_watermark_count_{};
+  bool scheduled_{};
+  bool destroyed_{};
+};
+
+} // namespace
+
 StatsHandler::StatsHandler(Server::Instance& server) : HandlerContextBase(server) {}
 
 Http::Code StatsHandler::handlerResetCounters(absl::string_view, Http::ResponseHeaderMap&,
@@ -128,7 +203,8 @@ Http::Code StatsHandler::handlerStats(absl::string_view url,
 
 Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query,
                                                 Http::ResponseHeaderMap&,
-                                                Buffer::Instance& response, AdminStream&) {
+                                                Buffer::Instance& response,
+                                                AdminStream& admin_stream) {
   const Http::Utility::QueryParams params =
       Http::Utility::parseAndDecodeQueryString(path_and_query);
   const bool used_only = params.find("usedonly") != params.end();
@@ -136,9 +212,23 @@ Http::Code StatsHandler::handlerPrometheusStats(absl::string_view path_and_query
   if (!Utility::filterParam(params, response, regex)) {
     return Http::Code::BadRequest;
   }
-  PrometheusStatsFormatter::statsAsPrometheus(server_.stats().counters(), server_.stats().gauges(),
-                                              server_.stats().histograms(), response, used_only,
-                                              regex, server_.api().customStatNamespaces());
+  if (prometheus_tags_cache_ == nullptr) {
+    prometheus_tags_cache_ = std::make_shared<PrometheusTagsCache>(server_.stats().symbolTable());
+  }
+  auto renderer = std::make_unique<PrometheusStatsRenderer>(
+      server_.stats().counters(), server_.stats().gauges(), server_.stats().histograms(),
+      used_only, regex, server_.api().customStatNamespaces(), prometheus_tags_cache_.get());
+  // Scrapes which fit into the first chunk are answered right away, the others are streamed if
+  // possible.
+  const uint64_t chunk_size_bytes = admin_stream.canStreamResponse()
+                                        ? PrometheusChunkSizeBytes
+                                        : std::numeric_limits<uint64_t>::max();
+  if (renderer->nextChunk(response, chunk_size_bytes)) {
+    std::make_shared<PrometheusStatsStream>(std::move(renderer), prometheus_tags_cache_,
+                                            server_.dispatcher(),
+                                            admin_stream.getDecoderFilterCallbacks())
+        ->start(admin_stream);
+  }
   return Http::Code::OK;
 }
 
@@ -11,6 +11,7 @@
 
 #include "source/common/stats/histogram_impl.h"
 #include "source/server/admin/handler_ctx.h"
+#include "source/server/admin/prometheus_stats.h"
 
 #include "absl/strings/string_view.h"
 
@@ -68,6 +69,9 @@ private:
                    const std::vector<Stats::ParentHistogramSharedPtr>& all_histograms,
                    bool used_only, const absl::optional<std::regex>& regex,
                    Buffer::Instance& response);
+
+  // Created on the first Prometheus scrape and shared with the scrapes being streamed.
+  std::shared_ptr<PrometheusTagsCache> prometheus_tags_cache_;
 };
 
 } // namespace Server
@@ -25,6 +25,7 @@
 
 #include "source/common/api/api_impl.h"
 #include "source/common/api/os_sys_calls_impl.h"
+#include "source/common/buffer/slice_allocator.h"
 #include "source/common/common/enum_to_int.h"
 #include "source/common/common/mutex_tracer_impl.h"
 #include "source/common/common/utility.h"
@@ -252,6 +253,15 @@ void InstanceImpl::updateServerStats() {
                                        parent_stats.parent_memory_allocated_);
   server_stats_->memory_heap_size_.set(Memory::Stats::totalCurrentlyReserved());
   server_stats_->memory_physical_size_.set(Memory::Stats::totalPhysicalBytes());
+  const Buffer::SliceAllocator::Stats slab_stats = Buffer::SliceAllocator::stats();
+  server_stats_->memory_buffer_slab_allocated_.set(slab_stats.bytes_in_use_);
+  server_stats_->memory_buffer_slab_thread_cached_.set(slab_stats.bytes_thread_cached_);
+  server_stats_->memory_buffer_slab_committed_.set(slab_stats.bytes_committed_);
+  server_stats_->memory_buffer_slab_heap_fallbacks_.add(slab_stats.heap_fallbacks_ -
+                                                        slab_heap_fallbacks_);
+  slab_heap_fallbacks_ = slab_stats.heap_fallbacks_;
+  server_stats_->memory_buffer_slab_released_.add(slab_stats.slabs_released_ - slabs_released_);
+  slabs_released_ = slab_stats.slabs_released_;
   server_stats_->parent_connections_.set(parent_stats.parent_connections_);
   server_stats_->total_connections_.set(listener_manager_->numConnections() +
                                         parent_stats.parent_connections_);
@@ -333,6 +343,20 @@ void registerCustomInlineHeadersFromBootstrap(
   }
 }
 
+void configureBufferSliceAllocator(const envoy::config::bootstrap::v3::Bootstrap& bootstrap) {
+  if (!bootstrap.has_buffer_slice_allocator()) {
+    return;
+  }
+  const auto& config = bootstrap.buffer_slice_allocator();
+  if (!Buffer::SliceAllocator::configure(
+          {PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_bytes, 1024 * 1024 * 1024),
+           config.use_hugepages(),
+           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, per_thread_cache_slices, 64),
+           PROTOBUF_GET_WRAPPED_OR_DEFAULT(config, max_free_slabs, 4)})) {
+    throw EnvoyException("Unable to reserve the address space of the buffer slice allocator.");
+  }
+}
+
 } // namespace
 
 void InstanceUtil::loadBootstrapConfig(envoy::config::bootstrap::v3::Bootstrap& bootstrap,
@@ -389,6 +413,9 @@ void InstanceImpl::initialize(Network::Address::InstanceConstSharedPtr local_add
   // Register Custom O(1) headers from bootstrap.
   registerCustomInlineHeadersFromBootstrap(bootstrap_);
 
+  // The workers allocate their buffer slices from the slabs from the start.
+  configureBufferSliceAllocator(bootstrap_);
+
   ENVOY_LOG(info, "HTTP header map info:");
   for (const auto& info : Http::HeaderMapImplUtility::getAllHeaderMapImplInfo()) {
     ENVOY_LOG(info, "  {}: {} bytes: {}", info.name_, info.size_,
@@ -408,6 +435,10 @@ void InstanceImpl::initialize(Network::Address::InstanceConstSharedPtr local_add
       ServerStats{ALL_SERVER_STATS(POOL_COUNTER_PREFIX(stats_store_, server_stats_prefix),
                                    POOL_GAUGE_PREFIX(stats_store_, server_stats_prefix),
                                    POOL_HISTOGRAM_PREFIX(stats_store_, server_stats_prefix))});
+  // The buffer slice allocator outlives the server, only count what happens during its lifetime.
+  const Buffer::SliceAllocator::Stats slab_stats = Buffer::SliceAllocator::stats();
+  slab_heap_fallbacks_ = slab_stats.heap_fallbacks_;
+  slabs_released_ = slab_stats.slabs_released_;
   server_compilation_settings_stats_ =
       std::make_unique<CompilationSettings::ServerCompilationSettingsStats>(
           CompilationSettings::ServerCompilationSettingsStats{ALL_SERVER_COMPILATION_SETTINGS_STATS(
@@ -73,6 +73,8 @@ struct ServerCompilationSettingsStats {
   COUNTER(static_unknown_fields)                                                                   \
   COUNTER(wip_protos)                                                                              \
   COUNTER(dropped_stat_flushes)                                                                    \
+  COUNTER(memory_buffer_slab_heap_fallbacks)                                                       \
+  COUNTER(memory_buffer_slab_released)                                                             \
   GAUGE(concurrency, NeverImport)                                                                  \
   GAUGE(days_until_first_cert_expiring, NeverImport)                                               \
   GAUGE(seconds_until_first_ocsp_response_expiring, NeverImport)                                   \
@@ -80,6 +82,9 @@ struct ServerCompilationSettingsStats {
   /* hot_restart_generation is an Accumulate gauge; we omit it here for testing dynamics. */       \
   GAUGE(live, NeverImport)                                                                         \
   GAUGE(memory_allocated, Accumulate)                                                              \
+  GAUGE(memory_buffer_slab_allocated, NeverImport)                                                 \
+  GAUGE(memory_buffer_slab_committed, NeverImport)                                                 \
+  GAUGE(memory_buffer_slab_thread_cached, NeverImport)                                             \
   GAUGE(memory_heap_size, Accumulate)                                                              \
   GAUGE(memory_physical_size, Accumulate)                                                          \
   GAUGE(parent_connections, Accumulate)                                                            \
@@ -341,6 +346,9 @@ private:
   time_t original_start_time_;
   Stats::StoreRoot& stats_store_;
   std::unique_ptr<ServerStats> server_stats_;
+  // Totals of the process wide buffer slice allocator already added to the server counters.
+  uint64_t slab_heap_fallbacks_{};
+  uint64_t slabs_released_{};
   std::unique_ptr<CompilationSettings::ServerCompilationSettingsStats>
       server_compilation_settings_stats_;
   Assert::ActionRegistrationPtr assert_action_registration_;
@@ -0,0 +1,70 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <vector>
+
+#include "source/common/access_log/access_log_manager_impl.h"
+#include "source/common/common/thread.h"
+#include "source/common/stats/isolated_store_impl.h"
+
+#include "test/test_common/environment.h"
+#include "test/test_common/utility.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace AccessLog {
+
+// Writes access log lines from state.range(0) threads, the way workers log requests, to
+// state.range(1) files. Each thread writes to all files in turn.
+static void bmAccessLogWrite(benchmark::State& state) {
+  const uint32_t num_threads = state.range(0);
+  const uint32_t num_files = state.range(1);
+  const uint32_t lines_per_thread = 20000;
+
+  Api::ApiPtr api = Api::createApiForTest();
+  Event::DispatcherPtr dispatcher = api->allocateDispatcher("test");
+  Thread::MutexBasicLockable lock;
+  Stats::IsolatedStoreImpl store;
+  AccessLogManagerImpl access_log_manager(std::chrono::milliseconds(1000), *api, *dispatcher, lock,
+                                          store);
+  std::vector<AccessLogFileSharedPtr> files;
+  for (uint32_t i = 0; i < num_files; ++i) {
+    const std::string path = TestEnvironment::temporaryPath(absl::StrCat("access_log_", i));
+    TestEnvironment::removePath(path);
+    files.push_back(access_log_manager.createAccessLog(
+        Filesystem::FilePathAndType{Filesystem::DestinationType::File, path}));
+  }
+  const std::string line(200, 'a');
+
+  for (auto _ : state) {
+    std::vector<Thread::ThreadPtr> threads;
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      threads.push_back(api->threadFactory().createThread([&]() {
+        for (uint32_t j = 0; j < lines_per_thread; ++j) {
+          files[j % num_files]->write(line);
+        }
+      }));
+    }
+    for (Thread::ThreadPtr& thread : threads) {
+      thread->join();
+    }
+    for (AccessLogFileSharedPtr& file : files) {
+      file->flush();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads * lines_per_thread);
+  state.SetBytesProcessed(state.iterations() * num_threads * lines_per_thread * line.size());
+}
+BENCHMARK(bmAccessLogWrite)
+    ->Args({1, 1})
+    ->Args({4, 1})
+    ->Args({16, 1})
+    ->Args({4, 16})
+    ->Args({16, 16})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace AccessLog
+} // namespace Envoy
@@ -1,4 +1,6 @@
 #include <memory>
+#include <string>
+#include <vector>
 
 #include "source/common/access_log/access_log_manager_impl.h"
 #include "source/common/filesystem/file_shared_impl.h"
@@ -8,12 +10,16 @@
 #include "test/mocks/api/mocks.h"
 #include "test/mocks/event/mocks.h"
 #include "test/mocks/filesystem/mocks.h"
+#include "test/test_common/environment.h"
 #include "test/test_common/test_time.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_split.h"
+
 using testing::_;
 using testing::ByMove;
 using testing::Invoke;
@@ -547,6 +553,191 @@ TEST_F(AccessLogManagerImplTest, ReopenAllFiles) {
       .WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
 }
 
+TEST_F(AccessLogManagerImplTest, FilesShareFlushTimer) {
+  NiceMock<Event::MockTimer>* timer = new NiceMock<Event::MockTimer>(&dispatcher_);
+
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"});
+
+  NiceMock<Filesystem::MockFile>* file2 = new NiceMock<Filesystem::MockFile>;
+  EXPECT_CALL(*file2, path()).WillRepeatedly(Return("bar"));
+  EXPECT_CALL(file_system_,
+              createFile(testing::Matcher<const Envoy::Filesystem::FilePathAndType&>(
+                  Filesystem::FilePathAndType{Filesystem::DestinationType::File, "bar"})))
+      .WillOnce(Return(ByMove(std::unique_ptr<NiceMock<Filesystem::MockFile>>(file2))));
+  EXPECT_CALL(*file2, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  // The second file reuses the flush timer of the first one.
+  EXPECT_CALL(dispatcher_, createTimer_(_)).Times(0);
+  AccessLogFileSharedPtr log2 = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "bar"});
+
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+  EXPECT_CALL(*file2, write_(_))
+      .WillRepeatedly(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  // The first write to each file is flushed right away.
+  log->write("a");
+  log2->write("a");
+  waitForCounterEq("filesystem.write_completed", 2);
+
+  // A single timer tick flushes both files.
+  log->write("b");
+  log2->write("b");
+  timer->invokeCallback();
+  waitForCounterEq("filesystem.write_completed", 4);
+  EXPECT_EQ(1UL, store_.counter("filesystem.flushed_by_timer").value());
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  EXPECT_CALL(*file2, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(AccessLogManagerImplTest, ConcurrentWritesAreCoalesced) {
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillOnce(ReturnNew<NiceMock<Event::MockTimer>>());
+  EXPECT_CALL(*file_, open_(_)).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+  AccessLogFileSharedPtr log_file = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"});
+
+  // Writes to a file are serialized by the flush, so the output doesn't need a lock.
+  std::string output;
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([&output](absl::string_view data) -> Api::IoCallSizeResult {
+        output.append(data.data(), data.size());
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+
+  constexpr uint32_t num_threads = 4;
+  constexpr uint32_t num_lines = 5000;
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < num_threads; i++) {
+    threads.push_back(thread_factory_.createThread([&log_file, i]() {
+      for (uint32_t line = 0; line < num_lines; line++) {
+        log_file->write(absl::StrCat(i, " ", line, "\n"));
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread->join();
+  }
+  log_file->flush();
+
+  EXPECT_EQ(num_threads * num_lines, store_.counter("filesystem.write_buffered").value());
+  EXPECT_LT(store_.counter("filesystem.write_completed").value(), num_threads * num_lines);
+  EXPECT_EQ(0, store_.gauge("filesystem.write_total_buffered", Stats::Gauge::ImportMode::Accumulate)
+                   .value());
+
+  // Every line is written exactly once, and the lines of each thread are in order.
+  std::vector<uint32_t> next_line(num_threads, 0);
+  for (absl::string_view line : absl::StrSplit(output, '\n', absl::SkipEmpty())) {
+    std::vector<absl::string_view> fields = absl::StrSplit(line, ' ');
+    ASSERT_EQ(2U, fields.size());
+    uint32_t thread;
+    uint32_t line_number;
+    ASSERT_TRUE(absl::SimpleAtoi(fields[0], &thread));
+    ASSERT_TRUE(absl::SimpleAtoi(fields[1], &line_number));
+    ASSERT_LT(thread, num_threads);
+    EXPECT_EQ(next_line[thread]++, line_number);
+  }
+  for (uint32_t i = 0; i < num_threads; i++) {
+    EXPECT_EQ(num_lines, next_line[i]);
+  }
+
+  EXPECT_CALL(*file_, close_()).WillOnce(Return(ByMove(Filesystem::resultSuccess<bool>(true))));
+}
+
+TEST_F(AccessLogManagerImplTest, RotateMovesFileThroughFileSystem) {
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillOnce(ReturnNew<NiceMock<Event::MockTimer>>());
+  EXPECT_CALL(*file_, destinationType()).WillRepeatedly(Return(Filesystem::DestinationType::File));
+  EXPECT_CALL(file_system_, fileSize("foo")).WillOnce(Return(-1));
+  EXPECT_CALL(*file_, open_(_)).Times(2).WillRepeatedly(Invoke([](const Filesystem::FlagSet&) {
+    return Filesystem::resultSuccess<bool>(true);
+  }));
+  AccessLogFileSharedPtr log_file = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"}, 4);
+
+  EXPECT_CALL(*file_, write_(_))
+      .WillOnce(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+  EXPECT_CALL(*file_, close_()).Times(2).WillRepeatedly(Invoke([]() {
+    return Filesystem::resultSuccess<bool>(true);
+  }));
+  EXPECT_CALL(file_system_, moveFile("foo", "foo.1")).WillOnce(Return(true));
+  log_file->write("abcd");
+  log_file->flush();
+  EXPECT_EQ(1UL, store_.counter("filesystem.rotated").value());
+}
+
+// Test that the size of the file is read again after a reopen, as it may have been rotated
+// externally.
+TEST_F(AccessLogManagerImplTest, ReopenResetsSizeForRotation) {
+  EXPECT_CALL(dispatcher_, createTimer_(_)).WillOnce(ReturnNew<NiceMock<Event::MockTimer>>());
+  EXPECT_CALL(*file_, destinationType()).WillRepeatedly(Return(Filesystem::DestinationType::File));
+  EXPECT_CALL(file_system_, fileSize("foo")).WillOnce(Return(-1)).WillOnce(Return(2));
+  EXPECT_CALL(*file_, open_(_)).Times(3).WillRepeatedly(Invoke([](const Filesystem::FlagSet&) {
+    return Filesystem::resultSuccess<bool>(true);
+  }));
+  EXPECT_CALL(*file_, close_()).Times(3).WillRepeatedly(Invoke([]() {
+    return Filesystem::resultSuccess<bool>(true);
+  }));
+  EXPECT_CALL(*file_, write_(_))
+      .WillRepeatedly(Invoke([](absl::string_view data) -> Api::IoCallSizeResult {
+        return Filesystem::resultSuccess<ssize_t>(static_cast<ssize_t>(data.length()));
+      }));
+  AccessLogFileSharedPtr log_file = access_log_manager_.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, "foo"}, 8);
+
+  log_file->write("abcdef");
+  log_file->flush();
+
+  // The reopened file holds 2 bytes, so 6 more bytes rotate it rather than the 2 left before.
+  log_file->reopen();
+  log_file->write("ab");
+  log_file->flush();
+  EXPECT_EQ(0UL, store_.counter("filesystem.rotated").value());
+
+  EXPECT_CALL(file_system_, moveFile("foo", "foo.1")).WillOnce(Return(true));
+  log_file->write("cdef");
+  log_file->flush();
+  EXPECT_EQ(1UL, store_.counter("filesystem.rotated").value());
+}
+
+TEST(AccessLogManagerRotationTest, RotateAtMaxSize) {
+  Api::ApiPtr api = Api::createApiForTest();
+  NiceMock<Event::MockDispatcher> dispatcher;
+  Thread::MutexBasicLockable lock;
+  Stats::TestUtil::TestStore store;
+  AccessLogManagerImpl access_log_manager(std::chrono::milliseconds(40), *api, dispatcher, lock,
+                                          store);
+
+  const std::string path =
+      TestEnvironment::writeStringToFileForTest("rotated_access_log", "0123456789");
+  const std::string rotated_path = absl::StrCat(path, ".1");
+  TestEnvironment::removePath(rotated_path);
+
+  AccessLogFileSharedPtr log_file = access_log_manager.createAccessLog(
+      Filesystem::FilePathAndType{Filesystem::DestinationType::File, path}, 30);
+
+  // The existing content counts towards the size.
+  log_file->write("abcdefghij");
+  log_file->write("klmnopqrst");
+  log_file->flush();
+  EXPECT_EQ(1UL, store.counter("filesystem.rotated").value());
+  EXPECT_EQ("0123456789abcdefghijklmnopqrst",
+            TestEnvironment::readFileToStringForTest(rotated_path));
+  EXPECT_EQ("", TestEnvironment::readFileToStringForTest(path));
+
+  log_file->write("uvwxyz");
+  log_file->flush();
+  EXPECT_EQ(1UL, store.counter("filesystem.rotated").value());
+  EXPECT_EQ("uvwxyz", TestEnvironment::readFileToStringForTest(path));
+}
+
 } // namespace
 } // namespace AccessLog
 } // namespace Envoy
@@ -1,6 +1,9 @@
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_allocator.h"
 #include "source/common/common/assert.h"
 
+#include "test/benchmark/main.h"
+
 #include "absl/strings/string_view.h"
 #include "benchmark/benchmark.h"
 
@@ -388,4 +391,40 @@ BENCHMARK(bufferStartsWithMatch)
     ->Args({16384, 256})
     ->Args({65536, 4096});
 
+// Test the allocation of the storage of 16KiB slices, by filling buffers and draining them, as done
+// when reading from sockets. The storage comes from the heap with state.range(0) == 0, or from the
+// hugepage backed slabs of Buffer::SliceAllocator with state.range(0) == 1.
+static void bufferSliceAllocation(benchmark::State& state) {
+  if (benchmark::skipExpensiveBenchmarks() && state.threads > 2) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  if (state.thread_index == 0) {
+    if (state.range(0) == 0) {
+      Buffer::SliceAllocator::disable();
+    } else {
+      RELEASE_ASSERT(Buffer::SliceAllocator::configure({1024 * 1024 * 1024, true, 64, 4}), "");
+    }
+  }
+  // Every thread reaches the benchmark loop once the setup above is done.
+  const std::string data(Buffer::Slice::default_slice_size_, 'a');
+  const uint64_t num_slices = state.range(1);
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    Buffer::OwnedImpl buffer;
+    for (uint64_t i = 0; i < num_slices; i++) {
+      buffer.add(data);
+    }
+    buffer.drain(buffer.length());
+  }
+
+  if (state.thread_index == 0) {
+    // Storage freed by the other threads once the allocator is disabled still goes to the slabs.
+    Buffer::SliceAllocator::disable();
+    Buffer::SliceAllocator::releaseFreeMemory();
+  }
+}
+BENCHMARK(bufferSliceAllocation)->Ranges({{0, 1}, {1, 64}})->ThreadRange(1, 8)->UseRealTime();
+
 } // namespace Envoy
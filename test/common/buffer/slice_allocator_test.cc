@@ -0,0 +1,217 @@
+#include <vector>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_allocator.h"
+
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Buffer {
+namespace {
+
+constexpr uint32_t NumSlabs = 4;
+constexpr uint32_t ThreadCacheBlocks = 8;
+
+// The allocator is process wide: every test starts and ends with all its slabs returned to the OS.
+class SliceAllocatorTest : public testing::Test {
+protected:
+  void SetUp() override {
+#if defined(WIN32)
+    EXPECT_FALSE(SliceAllocator::configure(config_));
+    GTEST_SKIP() << "The slice allocator is not supported on Windows.";
+#else
+    ASSERT_TRUE(SliceAllocator::configure(config_));
+    initial_stats_ = SliceAllocator::stats();
+#endif
+  }
+
+  void TearDown() override {
+    SliceAllocator::releaseFreeMemory();
+    SliceAllocator::disable();
+    const SliceAllocator::Stats stats = SliceAllocator::stats();
+    EXPECT_EQ(0, stats.bytes_in_use_);
+    EXPECT_EQ(0, stats.bytes_thread_cached_);
+    EXPECT_EQ(0, stats.bytes_committed_);
+  }
+
+  std::vector<uint8_t*> allocate(uint32_t count) {
+    std::vector<uint8_t*> blocks;
+    for (uint32_t i = 0; i < count; i++) {
+      uint8_t* block = SliceAllocator::allocate();
+      EXPECT_NE(nullptr, block);
+      EXPECT_TRUE(SliceAllocator::owns(block));
+      // Blocks are aligned on their size.
+      EXPECT_EQ(0, reinterpret_cast<uintptr_t>(block) % SliceAllocator::BlockSize);
+      blocks.push_back(block);
+    }
+    return blocks;
+  }
+
+  void deallocate(const std::vector<uint8_t*>& blocks) {
+    for (uint8_t* block : blocks) {
+      SliceAllocator::deallocate(block);
+    }
+  }
+
+  const SliceAllocator::Config config_{NumSlabs * SliceAllocator::SlabSize, false,
+                                       ThreadCacheBlocks, 1};
+  SliceAllocator::Stats initial_stats_{};
+};
+
+TEST_F(SliceAllocatorTest, Disabled) {
+  SliceAllocator::disable();
+  EXPECT_EQ(nullptr, SliceAllocator::allocate());
+
+  // Slices use the heap.
+  OwnedImpl buffer(std::string(Slice::default_slice_size_, 'a'));
+  EXPECT_EQ(0, SliceAllocator::stats().bytes_in_use_);
+}
+
+TEST_F(SliceAllocatorTest, AllocateAndDeallocate) {
+  std::vector<uint8_t*> blocks = allocate(3);
+  SliceAllocator::Stats stats = SliceAllocator::stats();
+  EXPECT_EQ(3 * SliceAllocator::BlockSize, stats.bytes_in_use_);
+  // The thread cache took half of its capacity from the slab.
+  EXPECT_EQ(1 * SliceAllocator::BlockSize, stats.bytes_thread_cached_);
+  EXPECT_EQ(SliceAllocator::SlabSize, stats.bytes_committed_);
+
+  deallocate(blocks);
+  stats = SliceAllocator::stats();
+  EXPECT_EQ(0, stats.bytes_in_use_);
+  EXPECT_EQ(4 * SliceAllocator::BlockSize, stats.bytes_thread_cached_);
+  // The storage freed last is reused first.
+  EXPECT_EQ(blocks.back(), SliceAllocator::allocate());
+  SliceAllocator::deallocate(blocks.back());
+}
+
+TEST_F(SliceAllocatorTest, ThreadCacheBound) {
+  std::vector<uint8_t*> blocks = allocate(3 * ThreadCacheBlocks);
+  deallocate(blocks);
+  SliceAllocator::Stats stats = SliceAllocator::stats();
+  EXPECT_EQ(0, stats.bytes_in_use_);
+  EXPECT_LE(stats.bytes_thread_cached_, ThreadCacheBlocks * SliceAllocator::BlockSize);
+  EXPECT_EQ(SliceAllocator::SlabSize, stats.bytes_committed_);
+}
+
+TEST_F(SliceAllocatorTest, FreeSlabsReturnedPastBound) {
+  // Fill all the slabs.
+  std::vector<uint8_t*> blocks = allocate(NumSlabs * SliceAllocator::BlocksPerSlab);
+  EXPECT_EQ(NumSlabs * SliceAllocator::SlabSize, SliceAllocator::stats().bytes_committed_);
+
+  deallocate(blocks);
+  // One free slab is kept, in addition to the one holding the storage cached by the thread.
+  const SliceAllocator::Stats stats = SliceAllocator::stats();
+  EXPECT_EQ(2 * SliceAllocator::SlabSize, stats.bytes_committed_);
+  EXPECT_EQ(initial_stats_.slabs_released_ + NumSlabs - 2, stats.slabs_released_);
+}
+
+TEST_F(SliceAllocatorTest, ReleaseFreeMemory) {
+  std::vector<uint8_t*> blocks = allocate(SliceAllocator::BlocksPerSlab + 1);
+  deallocate(blocks);
+  EXPECT_NE(0, SliceAllocator::stats().bytes_committed_);
+
+  SliceAllocator::releaseFreeMemory();
+  const SliceAllocator::Stats stats = SliceAllocator::stats();
+  EXPECT_EQ(0, stats.bytes_thread_cached_);
+  EXPECT_EQ(0, stats.bytes_committed_);
+}
+
+TEST_F(SliceAllocatorTest, Exhausted) {
+  std::vector<uint8_t*> blocks = allocate(NumSlabs * SliceAllocator::BlocksPerSlab);
+  EXPECT_EQ(nullptr, SliceAllocator::allocate());
+  EXPECT_EQ(initial_stats_.heap_fallbacks_ + 1, SliceAllocator::stats().heap_fallbacks_);
+
+  // Slices use the heap.
+  {
+    OwnedImpl buffer(std::string(Slice::default_slice_size_, 'a'));
+    EXPECT_EQ(initial_stats_.heap_fallbacks_ + 2, SliceAllocator::stats().heap_fallbacks_);
+  }
+  // Each allocation which used the heap is counted.
+  EXPECT_EQ(nullptr, SliceAllocator::allocate());
+  EXPECT_EQ(nullptr, SliceAllocator::allocate());
+  EXPECT_EQ(initial_stats_.heap_fallbacks_ + 4, SliceAllocator::stats().heap_fallbacks_);
+
+  // The slabs are used again once blocks were returned to them.
+  deallocate(blocks);
+  blocks = allocate(ThreadCacheBlocks + 1);
+  EXPECT_EQ(initial_stats_.heap_fallbacks_ + 4, SliceAllocator::stats().heap_fallbacks_);
+  deallocate(blocks);
+}
+
+// Storage freed on another thread makes exhausted slabs usable again.
+TEST_F(SliceAllocatorTest, ExhaustedDeallocateOnOtherThread) {
+  std::vector<uint8_t*> blocks = allocate(NumSlabs * SliceAllocator::BlocksPerSlab);
+  EXPECT_EQ(nullptr, SliceAllocator::allocate());
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread(
+      [this, &blocks]() -> void { deallocate(blocks); });
+  thread->join();
+  blocks = allocate(1);
+  deallocate(blocks);
+}
+
+TEST_F(SliceAllocatorTest, Slices) {
+  {
+    OwnedImpl buffer(std::string(Slice::default_slice_size_, 'a'));
+    EXPECT_EQ(SliceAllocator::BlockSize, SliceAllocator::stats().bytes_in_use_);
+    // Only the slices of the default size use the allocator.
+    buffer.add(std::string(100, 'b'));
+    EXPECT_EQ(2, buffer.getRawSlices().size());
+    EXPECT_EQ(SliceAllocator::BlockSize, SliceAllocator::stats().bytes_in_use_);
+
+    OwnedImpl other;
+    other.move(buffer);
+    EXPECT_EQ(Slice::default_slice_size_ + 100, other.length());
+    EXPECT_EQ(SliceAllocator::BlockSize, SliceAllocator::stats().bytes_in_use_);
+  }
+  EXPECT_EQ(0, SliceAllocator::stats().bytes_in_use_);
+}
+
+// Storage freed after the allocator was disabled still goes back to the slabs.
+TEST_F(SliceAllocatorTest, DeallocateAfterDisable) {
+  std::vector<uint8_t*> blocks = allocate(2);
+  SliceAllocator::disable();
+  deallocate(blocks);
+  EXPECT_EQ(0, SliceAllocator::stats().bytes_in_use_);
+}
+
+// Storage may be freed on another thread than the one which allocated it.
+TEST_F(SliceAllocatorTest, DeallocateOnOtherThread) {
+  std::vector<uint8_t*> blocks = allocate(ThreadCacheBlocks);
+  Thread::ThreadPtr thread =
+      Thread::threadFactoryForTest().createThread([this, &blocks]() -> void {
+        deallocate(blocks);
+        EXPECT_EQ(0, SliceAllocator::stats().bytes_in_use_);
+      });
+  thread->join();
+  // The thread returned its cache when exiting.
+  const SliceAllocator::Stats stats = SliceAllocator::stats();
+  EXPECT_EQ(0, stats.bytes_in_use_);
+  EXPECT_EQ(0, stats.bytes_thread_cached_);
+}
+
+// Threads return their cache on their next operation once releaseFreeMemory() was called.
+TEST_F(SliceAllocatorTest, ReleaseFreeMemoryOtherThread) {
+  absl::Notification cached;
+  absl::Notification released;
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread([&]() -> void {
+    std::vector<uint8_t*> blocks = allocate(2);
+    SliceAllocator::deallocate(blocks[0]);
+    cached.Notify();
+    released.WaitForNotification();
+    // The cache is returned before the block is added to it.
+    SliceAllocator::deallocate(blocks[1]);
+    EXPECT_EQ(SliceAllocator::BlockSize, SliceAllocator::stats().bytes_thread_cached_);
+  });
+  cached.WaitForNotification();
+  EXPECT_EQ(3 * SliceAllocator::BlockSize, SliceAllocator::stats().bytes_thread_cached_);
+  SliceAllocator::releaseFreeMemory();
+  released.Notify();
+  thread->join();
+}
+
+} // namespace
+} // namespace Buffer
+} // namespace Envoy
@@ -0,0 +1,128 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "source/common/common/arena.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+TEST(ArenaTest, NoBlockUntilFirstAllocation) {
+  Arena arena;
+  EXPECT_EQ(0, arena.blocks());
+  EXPECT_EQ(0, arena.allocations());
+  EXPECT_EQ(0, arena.bytesReserved());
+}
+
+TEST(ArenaTest, AllocationsAreAlignedAndDisjoint) {
+  Arena arena(256);
+  std::vector<std::pair<uintptr_t, size_t>> ranges;
+  for (size_t i = 0; i < 200; ++i) {
+    const size_t size = 1 + (i * 7) % 61;
+    const size_t alignment = size_t(1) << (i % 5);
+    void* memory = arena.allocate(size, alignment);
+    ASSERT_NE(nullptr, memory);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(memory) % alignment);
+    memset(memory, static_cast<int>(i), size);
+    ranges.emplace_back(reinterpret_cast<uintptr_t>(memory), size);
+  }
+  std::sort(ranges.begin(), ranges.end());
+  for (size_t i = 1; i < ranges.size(); ++i) {
+    EXPECT_LE(ranges[i - 1].first + ranges[i - 1].second, ranges[i].first);
+  }
+  EXPECT_EQ(200, arena.allocations());
+  // The blocks double in size, so a few of them hold all the allocations.
+  EXPECT_LE(arena.blocks(), 6);
+}
+
+TEST(ArenaTest, LargeAllocationGetsItsOwnBlock) {
+  Arena arena(256);
+  char* small = static_cast<char*>(arena.allocate(16));
+  EXPECT_EQ(1, arena.blocks());
+  char* large = static_cast<char*>(arena.allocate(10000));
+  memset(large, 0, 10000);
+  EXPECT_EQ(2, arena.blocks());
+  EXPECT_GE(arena.bytesReserved(), 10000 + 256);
+  // The first block is still used for the following small allocations.
+  char* next = static_cast<char*>(arena.allocate(16));
+  EXPECT_EQ(small + 16, next);
+  EXPECT_EQ(2, arena.blocks());
+}
+
+TEST(ArenaTest, BlockSizeIsCapped) {
+  Arena arena(Arena::MaxBlockSize);
+  arena.allocate(Arena::MaxBlockSize - 64, 1);
+  arena.allocate(Arena::MaxBlockSize - 64, 1);
+  EXPECT_EQ(2, arena.blocks());
+  EXPECT_EQ(2 * Arena::MaxBlockSize, arena.bytesReserved());
+}
+
+struct Tracked {
+  Tracked(std::vector<int>& destroyed, int id) : destroyed_(destroyed), id_(id) {}
+  ~Tracked() { destroyed_.push_back(id_); }
+
+  std::vector<int>& destroyed_;
+  const int id_;
+};
+
+TEST(ArenaTest, CreateRunsDestructorsInReverseOrder) {
+  std::vector<int> destroyed;
+  {
+    Arena arena;
+    for (int i = 0; i < 3; ++i) {
+      Tracked* tracked = arena.create<Tracked>(destroyed, i);
+      EXPECT_EQ(i, tracked->id_);
+    }
+    std::string* str = arena.create<std::string>(100, 'a');
+    EXPECT_EQ(100, str->size());
+    uint64_t* value = arena.create<uint64_t>(42);
+    EXPECT_EQ(42, *value);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(value) % alignof(uint64_t));
+    EXPECT_TRUE(destroyed.empty());
+  }
+  EXPECT_EQ((std::vector<int>{2, 1, 0}), destroyed);
+}
+
+class Allocatable {
+public:
+  Allocatable(int& destroyed, bool from_arena) : destroyed_(destroyed), from_arena_(from_arena) {}
+  virtual ~Allocatable() { ++destroyed_; }
+
+  bool allocatedFromArena() const { return from_arena_; }
+
+  int& destroyed_;
+  const bool from_arena_;
+};
+
+class DerivedAllocatable : public Allocatable {
+public:
+  using Allocatable::Allocatable;
+
+  std::string value_{"value"};
+};
+
+TEST(ArenaPtrTest, HeapAndArenaInstances) {
+  int destroyed = 0;
+  Arena arena;
+  {
+    ArenaPtr<Allocatable> from_heap(newInArena<DerivedAllocatable>(nullptr, destroyed, false));
+    ArenaPtr<Allocatable> from_arena(newInArena<DerivedAllocatable>(&arena, destroyed, true));
+    ArenaPtr<DerivedAllocatable> derived(newInArena<DerivedAllocatable>(&arena, destroyed, true));
+    ArenaPtr<Allocatable> base = std::move(derived);
+    EXPECT_EQ(2, arena.allocations());
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(from_arena.get()) % alignof(DerivedAllocatable));
+    // The deleter is stateless, the pointers cost no more than a std::unique_ptr.
+    EXPECT_EQ(sizeof(std::unique_ptr<Allocatable>), sizeof(ArenaPtr<Allocatable>));
+  }
+  // All the destructors ran, whichever the origin of the memory.
+  EXPECT_EQ(3, destroyed);
+  EXPECT_EQ(2, arena.allocations());
+}
+
+} // namespace
+} // namespace Envoy
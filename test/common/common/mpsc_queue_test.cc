@@ -0,0 +1,98 @@
+#include <thread>
+#include <vector>
+
+#include "source/common/common/mpsc_queue.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace {
+
+struct TestElement : public MpscQueueNode {
+  TestElement(uint32_t producer, uint32_t sequence) : producer_(producer), sequence_(sequence) {}
+
+  const uint32_t producer_;
+  const uint32_t sequence_;
+};
+
+TEST(MpscQueueTest, Empty) {
+  MpscQueue<TestElement> queue;
+  EXPECT_EQ(nullptr, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+TEST(MpscQueueTest, Fifo) {
+  MpscQueue<TestElement> queue;
+  for (uint32_t round = 0; round < 3; ++round) {
+    for (uint32_t i = 0; i < 10; ++i) {
+      queue.push(std::make_unique<TestElement>(0, i));
+    }
+    for (uint32_t i = 0; i < 10; ++i) {
+      std::unique_ptr<TestElement> element = queue.pop();
+      ASSERT_NE(nullptr, element);
+      EXPECT_EQ(i, element->sequence_);
+      // Interleave pushes and pops.
+      if (i == 4) {
+        queue.push(std::make_unique<TestElement>(0, 10));
+      }
+    }
+    std::unique_ptr<TestElement> element = queue.pop();
+    ASSERT_NE(nullptr, element);
+    EXPECT_EQ(10, element->sequence_);
+    EXPECT_EQ(nullptr, queue.pop());
+  }
+}
+
+TEST(MpscQueueTest, DestroysQueuedElements) {
+  struct CountedElement : public MpscQueueNode {
+    explicit CountedElement(uint32_t& destroyed) : destroyed_(destroyed) {}
+    ~CountedElement() { ++destroyed_; }
+    uint32_t& destroyed_;
+  };
+
+  uint32_t destroyed = 0;
+  {
+    MpscQueue<CountedElement> queue;
+    for (uint32_t i = 0; i < 5; ++i) {
+      queue.push(std::make_unique<CountedElement>(destroyed));
+    }
+    queue.pop();
+    EXPECT_EQ(1, destroyed);
+  }
+  EXPECT_EQ(5, destroyed);
+}
+
+// All elements pushed concurrently by many producers are popped, in order per producer.
+TEST(MpscQueueTest, ConcurrentProducers) {
+  constexpr uint32_t num_producers = 8;
+  constexpr uint32_t elements_per_producer = 100000;
+  MpscQueue<TestElement> queue;
+
+  std::vector<std::thread> producers;
+  for (uint32_t producer = 0; producer < num_producers; ++producer) {
+    producers.emplace_back([&queue, producer]() {
+      for (uint32_t i = 0; i < elements_per_producer; ++i) {
+        queue.push(std::make_unique<TestElement>(producer, i));
+      }
+    });
+  }
+
+  std::vector<uint32_t> next_sequence(num_producers);
+  uint32_t popped = 0;
+  while (popped < num_producers * elements_per_producer) {
+    std::unique_ptr<TestElement> element = queue.pop();
+    if (element == nullptr) {
+      std::this_thread::yield();
+      continue;
+    }
+    ASSERT_EQ(next_sequence[element->producer_]++, element->sequence_);
+    ++popped;
+  }
+  for (std::thread& producer : producers) {
+    producer.join();
+  }
+  EXPECT_EQ(nullptr, queue.pop());
+}
+
+} // namespace
+} // namespace Envoy
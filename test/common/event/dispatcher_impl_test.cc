@@ -468,7 +468,7 @@ TEST_F(DispatcherImplTest, RunPostCallbacksLocking) {
     // Block dispatcher first to ensure that both posted events below are handled
     // by a single call to runPostCallbacks().
     //
-    // This also ensures that the post_lock_ is not held while callbacks are called,
+    // This also ensures that posting doesn't block while callbacks are called,
     // or else this would deadlock.
     Thread::LockGuard lock(mu_);
     dispatcher_->post([this]() { Thread::LockGuard lock(mu_); });
@@ -491,6 +491,42 @@ TEST_F(DispatcherImplTest, RunPostCallbacksLocking) {
   }
 }
 
+// Callbacks posted concurrently from many threads all run, in the order they were posted by each
+// thread.
+TEST_F(DispatcherImplTest, PostFromManyThreads) {
+  constexpr uint32_t num_threads = 8;
+  constexpr uint32_t posts_per_thread = 10000;
+  // Only accessed on the dispatcher thread.
+  std::vector<uint32_t> next_post(num_threads);
+  uint32_t posts_run = 0;
+
+  std::vector<Thread::ThreadPtr> threads;
+  for (uint32_t i = 0; i < num_threads; ++i) {
+    threads.push_back(api_->threadFactory().createThread([this, i, &next_post, &posts_run]() {
+      for (uint32_t j = 0; j < posts_per_thread; ++j) {
+        dispatcher_->post([this, i, j, &next_post, &posts_run]() {
+          EXPECT_EQ(next_post[i]++, j);
+          if (++posts_run == num_threads * posts_per_thread) {
+            {
+              Thread::LockGuard lock(mu_);
+              work_finished_ = true;
+            }
+            cv_.notifyOne();
+          }
+        });
+      }
+    }));
+  }
+  for (Thread::ThreadPtr& thread : threads) {
+    thread->join();
+  }
+
+  Thread::LockGuard lock(mu_);
+  while (!work_finished_) {
+    cv_.wait(mu_);
+  }
+}
+
 TEST_F(DispatcherImplTest, DispatcherThreadDeleted) {
   dispatcher_->deleteInDispatcherThread(std::make_unique<TestDispatcherThreadDeletable>(
       [this, id = api_->threadFactory().currentThreadId()]() {
@@ -0,0 +1,78 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <atomic>
+#include <vector>
+
+#include "envoy/event/dispatcher.h"
+
+#include "source/common/common/thread.h"
+
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Event {
+
+// Posts callbacks from state.range(0) threads to a single dispatcher running on its own thread, the
+// way the main thread fans out to workers and workers post back to the main thread. Each callback
+// captures state.range(1) bytes.
+static void bmDispatcherPost(benchmark::State& state) {
+  const uint32_t num_threads = state.range(0);
+  const uint32_t capture_size = state.range(1);
+  const uint32_t posts_per_thread = 20000;
+
+  Api::ApiPtr api = Api::createApiForTest();
+  DispatcherPtr dispatcher = api->allocateDispatcher("test");
+  Thread::ThreadPtr dispatcher_thread = api->threadFactory().createThread(
+      [&dispatcher]() { dispatcher->run(Dispatcher::RunType::RunUntilExit); });
+  const std::string capture(capture_size, 'a');
+
+  for (auto _ : state) {
+    // Only accessed on the dispatcher thread.
+    uint64_t posts_run = 0;
+    absl::Notification done;
+    std::vector<Thread::ThreadPtr> threads;
+    for (uint32_t i = 0; i < num_threads; ++i) {
+      threads.push_back(api->threadFactory().createThread([&]() {
+        for (uint32_t j = 0; j < posts_per_thread; ++j) {
+          auto callback = [&posts_run, &done, num_threads, posts_per_thread]() {
+            if (++posts_run == static_cast<uint64_t>(num_threads) * posts_per_thread) {
+              done.Notify();
+            }
+          };
+          if (capture_size == 0) {
+            dispatcher->post(callback);
+          } else {
+            dispatcher->post([callback, capture]() {
+              benchmark::DoNotOptimize(capture.data());
+              callback();
+            });
+          }
+        }
+      }));
+    }
+    for (Thread::ThreadPtr& thread : threads) {
+      thread->join();
+    }
+    done.WaitForNotification();
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads * posts_per_thread);
+
+  dispatcher->exit();
+  dispatcher_thread->join();
+}
+BENCHMARK(bmDispatcherPost)
+    ->Args({1, 0})
+    ->Args({4, 0})
+    ->Args({16, 0})
+    ->Args({1, 64})
+    ->Args({4, 64})
+    ->Args({16, 64})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace Event
+} // namespace Envoy
@@ -65,6 +65,16 @@ TEST_F(FileSystemImplTest, FileSize) {
   EXPECT_EQ(data.length(), file_system_.fileSize(file_path));
 }
 
+TEST_F(FileSystemImplTest, MoveFile) {
+  const std::string from_path = TestEnvironment::writeStringToFileForTest("move_from", "from");
+  const std::string to_path = TestEnvironment::writeStringToFileForTest("move_to", "to");
+  // An existing file at the destination is replaced.
+  EXPECT_TRUE(file_system_.moveFile(from_path, to_path));
+  EXPECT_FALSE(file_system_.fileExists(from_path));
+  EXPECT_EQ("from", file_system_.fileReadToEnd(to_path));
+  EXPECT_FALSE(file_system_.moveFile(from_path, to_path));
+}
+
 TEST_F(FileSystemImplTest, FileReadToEndSuccess) {
   const std::string data = "test string\ntest";
   const std::string file_path = TestEnvironment::writeStringToFileForTest("test_envoy", data);
@@ -8,6 +8,8 @@
 // drain operations on the connection buffers between client and server.
 
 #include <functional>
+#include <string>
+#include <vector>
 
 #include "source/common/common/assert.h"
 #include "source/common/common/logger.h"
@@ -23,7 +25,10 @@
 #include "test/fuzz/utility.h"
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/network/mocks.h"
+#include "test/test_common/test_runtime.h"
 
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "gmock/gmock.h"
 
 using testing::_;
@@ -426,6 +431,7 @@ public:
         status = connection_.dispatch(buf);
         if (!status.ok()) {
           ENVOY_LOG_MISC(trace, "Error status: {}", status.message());
+          dispatch_errors_.emplace_back(status.message());
           return status;
         }
       }
@@ -465,6 +471,8 @@ public:
 
   Connection& connection_;
   std::deque<Buffer::OwnedImpl> bufs_;
+  // The errors returned by dispatch, compared across the HTTP/1 parsers.
+  std::vector<std::string> dispatch_errors_;
   // A reference to a flag indicating whether the reorder buffer is allowed to dispatch data to
   // the connection (reference to should_close_connection).
   const bool& should_close_connection_;
@@ -476,7 +484,10 @@ namespace {
 
 enum class HttpVersion { Http1, Http2 };
 
-void codecFuzz(const test::common::http::CodecImplFuzzTestCase& input, HttpVersion http_version) {
+// Runs the actions of the input, and returns a summary of the outcome of the dispatches and the
+// state of the streams.
+std::string codecFuzz(const test::common::http::CodecImplFuzzTestCase& input,
+                      HttpVersion http_version) {
   Stats::IsolatedStoreImpl stats_store;
   NiceMock<Network::MockConnection> client_connection;
   const envoy::config::core::v3::Http2ProtocolOptions client_http2_options{
@@ -683,6 +694,18 @@ void codecFuzz(const test::common::http::CodecImplFuzzTestCase& input, HttpVersi
     dynamic_cast<Http2::ClientConnectionImpl&>(*client).goAway();
     dynamic_cast<Http2::ServerConnectionImpl&>(*server).goAway();
   }
+
+  std::string outcome =
+      absl::StrCat("client errors: ", absl::StrJoin(server_write_buf.dispatch_errors_, ", "),
+                   "\nserver errors: ", absl::StrJoin(client_write_buf.dispatch_errors_, ", "),
+                   "\nclose: ", should_close_connection, "\npending: ", pending_streams.size());
+  for (const HttpStreamPtr& stream : streams) {
+    absl::StrAppend(&outcome, "\nstream: ", static_cast<int>(stream->request_.stream_state_), " ",
+                    stream->request_.remote_closed_, " ",
+                    static_cast<int>(stream->response_.stream_state_), " ",
+                    stream->response_.remote_closed_);
+  }
+  return outcome;
 }
 
 } // namespace
@@ -692,7 +715,19 @@ DEFINE_PROTO_FUZZER(const test::common::http::CodecImplFuzzTestCase& input) {
   try {
     // Validate input early.
     TestUtility::validate(input);
-    codecFuzz(input, HttpVersion::Http1);
+    const std::string http1_outcome = codecFuzz(input, HttpVersion::Http1);
+    {
+      // The vectorized HTTP/1 parser must behave as http_parser.
+      TestScopedRuntime scoped_runtime;
+      Runtime::LoaderSingleton::getExisting()->mergeValues(
+          {{"envoy.reloadable_features.http1_use_vectorized_parser", "true"}});
+      const std::string vectorized_outcome = codecFuzz(input, HttpVersion::Http1);
+      if (vectorized_outcome != http1_outcome) {
+        ENVOY_LOG_MISC(critical, "http_parser:\n{}\nvectorized parser:\n{}", http1_outcome,
+                       vectorized_outcome);
+      }
+      FUZZ_ASSERT(vectorized_outcome == http1_outcome);
+    }
     codecFuzz(input, HttpVersion::Http2);
   } catch (const EnvoyException& e) {
     ENVOY_LOG_MISC(debug, "EnvoyException: {}", e.what());
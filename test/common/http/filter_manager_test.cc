@@ -15,6 +15,7 @@
 #include "test/mocks/http/mocks.h"
 #include "test/mocks/local_reply/mocks.h"
 #include "test/mocks/network/mocks.h"
+#include "test/test_common/test_runtime.h"
 
 #include "gtest/gtest.h"
 
@@ -148,6 +149,63 @@ TEST_F(FilterManagerTest, SendLocalReplyDuringEncodingGrpcClassiciation) {
   filter_manager_->destroyFilters();
 }
 
+// Verifies that the filter wrappers are allocated from the stream arena when it is enabled, and
+// that the filter chain runs as usual.
+TEST_F(FilterManagerTest, FilterWrappersAllocatedFromArena) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.http_stream_arena", "true"}});
+  initialize();
+
+  std::shared_ptr<MockStreamFilter> stream_filter(new NiceMock<MockStreamFilter>());
+  EXPECT_CALL(*stream_filter, decodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::Continue));
+  EXPECT_CALL(*stream_filter, encodeHeaders(_, true))
+      .WillOnce(Return(FilterHeadersStatus::Continue));
+
+  std::shared_ptr<MockStreamDecoderFilter> decoder_filter(new NiceMock<MockStreamDecoderFilter>());
+  EXPECT_CALL(*decoder_filter, decodeHeaders(_, true))
+      .WillOnce(Invoke([&](RequestHeaderMap&, bool) -> FilterHeadersStatus {
+        ResponseHeaderMapPtr response_headers{new TestResponseHeaderMapImpl{{":status", "200"}}};
+        decoder_filter->callbacks_->encodeHeaders(std::move(response_headers), true, "test");
+        return FilterHeadersStatus::StopIteration;
+      }));
+
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamFilter(stream_filter);
+        callbacks.addStreamDecoderFilter(decoder_filter);
+      }));
+
+  RequestHeaderMapPtr headers{new TestRequestHeaderMapImpl{
+      {":authority", "host"}, {":path", "/"}, {":method", "GET"}}};
+  ON_CALL(filter_manager_callbacks_, requestHeaders()).WillByDefault(Return(makeOptRef(*headers)));
+  filter_manager_->createFilterChain();
+  // Two wrappers for the dual filter and one for the decoder filter.
+  EXPECT_EQ(3, filter_manager_->arena().allocations());
+
+  filter_manager_->requestHeadersInitialized();
+  EXPECT_CALL(filter_manager_callbacks_, encodeHeaders(_, true));
+  EXPECT_CALL(filter_manager_callbacks_, endStream());
+  filter_manager_->decodeHeaders(*headers, true);
+  filter_manager_->destroyFilters();
+}
+
+// Verifies that the stream arena is not used by default.
+TEST_F(FilterManagerTest, FilterWrappersAllocatedFromHeapByDefault) {
+  initialize();
+
+  std::shared_ptr<MockStreamFilter> stream_filter(new NiceMock<MockStreamFilter>());
+  EXPECT_CALL(filter_factory_, createFilterChain(_))
+      .WillOnce(Invoke([&](FilterChainFactoryCallbacks& callbacks) -> void {
+        callbacks.addStreamFilter(stream_filter);
+      }));
+  filter_manager_->createFilterChain();
+  EXPECT_EQ(0, filter_manager_->arena().allocations());
+  EXPECT_EQ(0, filter_manager_->arena().blocks());
+  filter_manager_->destroyFilters();
+}
+
 struct TestAction : Matcher::ActionBase<ProtobufWkt::StringValue> {};
 
 template <class InputType, class ActionType>
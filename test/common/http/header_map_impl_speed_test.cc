@@ -1,6 +1,8 @@
 #include "source/common/http/header_map_impl.h"
 #include "source/common/http/headers.h"
 
+#include "test/test_common/test_runtime.h"
+
 #include "benchmark/benchmark.h"
 
 namespace Envoy {
@@ -17,8 +19,41 @@ static void addDummyHeaders(HeaderMap& headers, size_t num_headers,
   }
 }
 
+/**
+ * Select the storage layout of the header maps created afterwards. A TestScopedRuntime must be
+ * in scope.
+ * @param contiguous whether to use the contiguous layout rather than the list layout.
+ */
+static void setLayout(bool contiguous) {
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.header_map_contiguous_storage", contiguous ? "true" : "false"}});
+}
+
+/** Run a benchmark with both storage layouts. The layout is the first argument. */
+static void layouts(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"contiguous"});
+  for (int64_t contiguous : {0, 1}) {
+    b->Arg(contiguous);
+  }
+}
+
+/**
+ * Run a benchmark with both storage layouts and a varying number of dummy headers. The number of
+ * headers is the first argument and the layout the second.
+ */
+static void headerCountsAndLayouts(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"headers", "contiguous"});
+  for (int64_t contiguous : {0, 1}) {
+    for (int64_t num_headers : {0, 1, 5, 10, 50}) {
+      b->Args({num_headers, contiguous});
+    }
+  }
+}
+
 /** Measure the construction/destruction speed of RequestHeaderMapImpl.*/
 static void headerMapImplCreate(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(0));
   // Make sure first time construction is not counted.
   Http::ResponseHeaderMapImpl::create();
   for (auto _ : state) { // NOLINT
@@ -26,7 +61,7 @@ static void headerMapImplCreate(benchmark::State& state) {
     benchmark::DoNotOptimize(headers->size());
   }
 }
-BENCHMARK(headerMapImplCreate);
+BENCHMARK(headerMapImplCreate)->Apply(layouts);
 
 /**
  * Measure the speed of setting/overwriting a header value. The numeric Arg passed
@@ -36,6 +71,8 @@ BENCHMARK(headerMapImplCreate);
  * headers in the HeaderMapImpl.
  */
 static void headerMapImplSetReference(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const LowerCaseString key("example-key");
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
@@ -45,7 +82,7 @@ static void headerMapImplSetReference(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplSetReference)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplSetReference)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of retrieving a header value. The numeric Arg passed by the
@@ -56,6 +93,8 @@ BENCHMARK(headerMapImplSetReference)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
  * HeaderMapImpl.
  */
 static void headerMapImplGet(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const LowerCaseString key("example-key");
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
@@ -67,13 +106,15 @@ static void headerMapImplGet(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(successes);
 }
-BENCHMARK(headerMapImplGet)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplGet)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the retrieval speed of a header for which HeaderMapImpl is expected to
  * provide special optimizations.
  */
 static void headerMapImplGetInline(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
@@ -84,13 +125,15 @@ static void headerMapImplGetInline(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(size);
 }
-BENCHMARK(headerMapImplGetInline)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplGetInline)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of writing to a header for which HeaderMapImpl is expected to
  * provide special optimizations.
  */
 static void headerMapImplSetInlineMacro(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
@@ -99,13 +142,15 @@ static void headerMapImplSetInlineMacro(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplSetInlineMacro)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplSetInlineMacro)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of writing to a header for which HeaderMapImpl is expected to
  * provide special optimizations.
  */
 static void headerMapImplSetInlineInteger(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   uint64_t value = 12345;
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
@@ -114,10 +159,12 @@ static void headerMapImplSetInlineInteger(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplSetInlineInteger)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplSetInlineInteger)->Apply(headerCountsAndLayouts);
 
 /** Measure the speed of the byteSize() estimation method. */
 static void headerMapImplGetByteSize(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
   uint64_t size = 0;
@@ -126,10 +173,12 @@ static void headerMapImplGetByteSize(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(size);
 }
-BENCHMARK(headerMapImplGetByteSize)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplGetByteSize)->Apply(headerCountsAndLayouts);
 
 /** Measure the speed of iteration with a lightweight callback. */
 static void headerMapImplIterate(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   auto headers = Http::ResponseHeaderMapImpl::create();
   size_t num_callbacks = 0;
   addDummyHeaders(*headers, state.range(0));
@@ -142,7 +191,7 @@ static void headerMapImplIterate(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(num_callbacks);
 }
-BENCHMARK(headerMapImplIterate)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplIterate)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of removing a header by key name.
@@ -150,6 +199,8 @@ BENCHMARK(headerMapImplIterate)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
  *       one copy of the header.
  */
 static void headerMapImplRemove(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const LowerCaseString key("example-key");
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
@@ -160,7 +211,7 @@ static void headerMapImplRemove(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplRemove)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplRemove)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of removing a header by key name, for the special case of
@@ -169,6 +220,8 @@ BENCHMARK(headerMapImplRemove)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
  *       one copy of the header.
  */
 static void headerMapImplRemoveInline(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const LowerCaseString key("connection");
   const std::string value("01234567890123456789");
   auto headers = Http::ResponseHeaderMapImpl::create();
@@ -179,7 +232,7 @@ static void headerMapImplRemoveInline(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplRemoveInline)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplRemoveInline)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of creating a HeaderMapImpl and populating it with a realistic
@@ -198,6 +251,8 @@ static void headerMapImplPopulate(benchmark::State& state) {
       {LowerCaseString("set-cookie"), "_cookie1=12345678; path = /; secure"},
       {LowerCaseString("set-cookie"), "_cookie2=12345678; path = /; secure"},
   };
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(0));
   for (auto _ : state) { // NOLINT
     auto headers = Http::ResponseHeaderMapImpl::create();
     for (const auto& key_value : headers_to_add) {
@@ -206,7 +261,41 @@ static void headerMapImplPopulate(benchmark::State& state) {
     benchmark::DoNotOptimize(headers->size());
   }
 }
-BENCHMARK(headerMapImplPopulate);
+BENCHMARK(headerMapImplPopulate)->Apply(layouts);
+
+/**
+ * Measure the speed of copying a request header map, as done for retries, shadowing or external
+ * authorization requests. The first argument is the number of headers added to a realistic set of
+ * request headers, the second the layout.
+ */
+static void headerMapImplCopy(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
+  auto headers = Http::RequestHeaderMapImpl::create();
+  headers->setReferenceMethod(Http::Headers::get().MethodValues.Get);
+  headers->setReferenceScheme(Http::Headers::get().SchemeValues.Https);
+  headers->setHost("www.example.com");
+  headers->setPath("/index.html?query=value");
+  headers->setUserAgent("Mozilla/5.0 (X11; Linux x86_64; rv:109.0) Gecko/20100101 Firefox/115.0");
+  headers->setReferenceKey(LowerCaseString("accept"), "text/html,application/xhtml+xml");
+  headers->setReferenceKey(LowerCaseString("accept-encoding"), "gzip, deflate, br");
+  headers->setReferenceKey(LowerCaseString("accept-language"), "en-US,en;q=0.5");
+  headers->setReferenceKey(LowerCaseString("cookie"), "session=0123456789abcdef");
+  headers->setRequestId("4bd3a2c1-75f3-4a3e-9d7b-04f1b2c36a8e");
+  addDummyHeaders(*headers, state.range(0));
+  for (auto _ : state) { // NOLINT
+    Http::RequestHeaderMapPtr copy = createHeaderMap<RequestHeaderMapImpl>(*headers);
+    benchmark::DoNotOptimize(copy->size());
+  }
+}
+BENCHMARK(headerMapImplCopy)
+    ->ArgNames({"headers", "contiguous"})
+    ->Args({5, 0})
+    ->Args({15, 0})
+    ->Args({25, 0})
+    ->Args({5, 1})
+    ->Args({15, 1})
+    ->Args({25, 1});
 
 /**
  * Measure the speed of encoding headers as part of upgraded requests (HTTP/1 to HTTP/2)
@@ -214,6 +303,8 @@ BENCHMARK(headerMapImplPopulate);
  *       a varying number of headers (set by the benchmark's argument).
  */
 static void headerMapImplEmulateH1toH2Upgrade(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   uint32_t total_len = 0; // Accumulates the length of all header keys and values.
   auto headers = Http::RequestHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
@@ -244,7 +335,7 @@ static void headerMapImplEmulateH1toH2Upgrade(benchmark::State& state) {
   benchmark::DoNotOptimize(headers->size());
   benchmark::DoNotOptimize(total_len);
 }
-BENCHMARK(headerMapImplEmulateH1toH2Upgrade)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplEmulateH1toH2Upgrade)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of decoding headers as part of upgraded responses (HTTP/2 to HTTP/1)
@@ -252,6 +343,8 @@ BENCHMARK(headerMapImplEmulateH1toH2Upgrade)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->A
  *       a varying number of headers (set by the benchmark's argument).
  */
 static void headerMapImplEmulateH2toH1Upgrade(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   uint32_t total_len = 0; // Accumulates the length of all header keys and values.
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, state.range(0));
@@ -274,13 +367,15 @@ static void headerMapImplEmulateH2toH1Upgrade(benchmark::State& state) {
   benchmark::DoNotOptimize(headers->size());
   benchmark::DoNotOptimize(total_len);
 }
-BENCHMARK(headerMapImplEmulateH2toH1Upgrade)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplEmulateH2toH1Upgrade)->Apply(headerCountsAndLayouts);
 
 /**
  * Measure the speed of removing a varying number of headers by key name prefix from
  * a header-map that contains 80 headers that do not have that prefix.
  */
 static void headerMapImplRemovePrefix(benchmark::State& state) {
+  TestScopedRuntime scoped_runtime;
+  setLayout(state.range(1));
   const LowerCaseString prefix("X-prefix");
   auto headers = Http::ResponseHeaderMapImpl::create();
   addDummyHeaders(*headers, 80);
@@ -293,7 +388,7 @@ static void headerMapImplRemovePrefix(benchmark::State& state) {
   }
   benchmark::DoNotOptimize(headers->size());
 }
-BENCHMARK(headerMapImplRemovePrefix)->Arg(0)->Arg(1)->Arg(5)->Arg(10)->Arg(50);
+BENCHMARK(headerMapImplRemovePrefix)->Apply(headerCountsAndLayouts);
 
 } // namespace Http
 } // namespace Envoy
@@ -2,6 +2,7 @@
 #include <cstddef>
 #include <memory>
 #include <string>
+#include <tuple>
 
 #include "source/common/http/header_list_view.h"
 #include "source/common/http/header_map_impl.h"
@@ -368,23 +369,29 @@ Http::RegisterCustomInlineHeader<Http::CustomInlineHeaderRegistry::Type::Request
 Http::RegisterCustomInlineHeader<Http::CustomInlineHeaderRegistry::Type::RequestHeaders>
     custom_header_1_copy(Http::LowerCaseString{"foo_custom_header"});
 
-class HeaderMapImplTest : public testing::TestWithParam<uint32_t> {
+class HeaderMapImplTest : public testing::TestWithParam<std::tuple<uint32_t, bool>> {
 public:
   HeaderMapImplTest() {
-    // Set the lazy map threshold using the test parameter.
+    // Set the lazy map threshold and the storage layout using the test parameters.
     Runtime::LoaderSingleton::getExisting()->mergeValues(
-        {{"envoy.http.headermap.lazy_map_min_size", absl::StrCat(GetParam())}});
+        {{"envoy.http.headermap.lazy_map_min_size", absl::StrCat(std::get<0>(GetParam()))},
+         {"envoy.reloadable_features.header_map_contiguous_storage",
+          std::get<1>(GetParam()) ? "true" : "false"}});
   }
 
-  static std::string testParamsToString(const ::testing::TestParamInfo<uint32_t>& params) {
-    return absl::StrCat(params.param);
+  static std::string
+  testParamsToString(const ::testing::TestParamInfo<std::tuple<uint32_t, bool>>& params) {
+    return absl::StrCat(std::get<0>(params.param),
+                        std::get<1>(params.param) ? "_Contiguous" : "_List");
   }
 
   TestScopedRuntime runtime;
 };
 
 INSTANTIATE_TEST_SUITE_P(HeaderMapThreshold, HeaderMapImplTest,
-                         testing::Values(0, 1, std::numeric_limits<uint32_t>::max()),
+                         testing::Combine(testing::Values(0, 1,
+                                                          std::numeric_limits<uint32_t>::max()),
+                                          testing::Bool()),
                          HeaderMapImplTest::testParamsToString);
 
 // Make sure that the same header registered twice points to the same location.
@@ -1270,6 +1277,45 @@ TEST_P(HeaderMapImplTest, TestInlineHeaderAdd) {
   EXPECT_TRUE(foo.Path() != nullptr);
 }
 
+// Make sure that repeatedly removing and adding headers, which leaves removed entries behind and
+// reuses their storage with the contiguous layout, preserves the order of the headers and the
+// O(1) header entries.
+TEST_P(HeaderMapImplTest, RepeatedRemoveAndAdd) {
+  TestRequestHeaderMapImpl headers;
+  headers.addCopy(LowerCaseString("first"), "1");
+  headers.setPath("/");
+  headers.addCopy(LowerCaseString("second"), "2");
+  const HeaderEntry* path = headers.Path();
+
+  for (uint32_t i = 0; i < 99; ++i) {
+    const LowerCaseString key(absl::StrCat("key-", i));
+    headers.addCopy(key, "value");
+    headers.addCopy(LowerCaseString("repeated"), absl::StrCat(i));
+    EXPECT_EQ(1UL, headers.remove(key));
+    if (i % 3 == 0) {
+      EXPECT_EQ(1UL, headers.remove(LowerCaseString("repeated")));
+    }
+  }
+
+  EXPECT_EQ(path, headers.Path());
+  TestRequestHeaderMapImpl expected{
+      {":path", "/"}, {"first", "1"}, {"second", "2"}, {"repeated", "97"}, {"repeated", "98"}};
+  EXPECT_EQ(expected, headers);
+
+  std::vector<absl::string_view> reverse_keys;
+  headers.iterateReverse([&reverse_keys](const HeaderEntry& header) -> HeaderMap::Iterate {
+    reverse_keys.push_back(header.key().getStringView());
+    return HeaderMap::Iterate::Continue;
+  });
+  EXPECT_THAT(reverse_keys, ElementsAre("repeated", "repeated", "second", "first", ":path"));
+
+  headers.removePath();
+  EXPECT_EQ(nullptr, headers.Path());
+  headers.setPath("/foo");
+  EXPECT_EQ("/foo", headers.getPathValue());
+  EXPECT_EQ(5UL, headers.size());
+}
+
 TEST_P(HeaderMapImplTest, ClearHeaderMap) {
   TestRequestHeaderMapImpl headers;
   LowerCaseString static_key("hello");
@@ -0,0 +1,295 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "source/common/common/macros.h"
+#include "source/common/http/http1/legacy_parser_impl.h"
+#include "source/common/http/http1/vectorized_parser_impl.h"
+
+#include "absl/strings/str_cat.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Http {
+namespace Http1 {
+namespace {
+
+// Records the callbacks of a parser, and pauses it at the end of each message as the server codec
+// does.
+class RecordingCallbacks : public ParserCallbacks {
+public:
+  void setParser(Parser& parser) { parser_ = &parser; }
+  void setHeadResponse() { head_response_ = true; }
+  const std::string& trace() const { return trace_; }
+
+  void event(absl::string_view event) {
+    data_kind_ = 0;
+    absl::StrAppend(&trace_, event);
+  }
+
+  // ParserCallbacks
+  Status onMessageBegin() override {
+    event("<begin>");
+    return okStatus();
+  }
+  Status onUrl(const char* data, size_t length) override {
+    onData('U', data, length);
+    return okStatus();
+  }
+  Status onHeaderField(const char* data, size_t length) override {
+    onData('F', data, length);
+    return okStatus();
+  }
+  Status onHeaderValue(const char* data, size_t length) override {
+    onData('V', data, length);
+    return okStatus();
+  }
+  Envoy::StatusOr<ParserStatus> onHeadersComplete() override {
+    event(absl::StrCat("<headers ", parser_->httpMajor(), ".", parser_->httpMinor(), " ",
+                       parser_->statusCode(), " ", parser_->isChunked(), " ",
+                       parser_->hasTransferEncoding(), " ",
+                       parser_->contentLength().value_or(UINT64_MAX), ">"));
+    if (parser_->statusCode() == 0) {
+      absl::StrAppend(&trace_, parser_->methodName());
+    }
+    return head_response_ ? ParserStatus::NoBody : ParserStatus::Success;
+  }
+  void bufferBody(const char* data, size_t length) override { onData('B', data, length); }
+  StatusOr<ParserStatus> onMessageComplete() override {
+    event("<complete>");
+    return parser_->pause();
+  }
+  void onChunkHeader(bool is_final_chunk) override {
+    event(is_final_chunk ? "<last chunk>" : "<chunk>");
+  }
+  int setAndCheckCallbackStatus(Status&& status) override {
+    return parser_->statusToInt(status.ok() ? ParserStatus::Success : ParserStatus::Error);
+  }
+  int setAndCheckCallbackStatusOr(Envoy::StatusOr<ParserStatus>&& statusor) override {
+    return parser_->statusToInt(statusor.ok() ? statusor.value() : ParserStatus::Error);
+  }
+
+private:
+  // Data split across buffers is passed in fragments, which are merged.
+  void onData(char kind, const char* data, size_t length) {
+    if (data_kind_ != kind) {
+      absl::StrAppend(&trace_, "|", absl::string_view(&kind, 1), ":");
+      data_kind_ = kind;
+    }
+    trace_.append(data, length);
+  }
+
+  Parser* parser_{};
+  bool head_response_{};
+  std::string trace_;
+  char data_kind_{};
+};
+
+// Parses the input split at the given offsets, resuming the parser after each message as the codec
+// does, and returns the trace of the callbacks.
+template <class ParserImpl>
+std::string parse(MessageType type, absl::string_view input, std::vector<size_t> splits,
+                  bool head_response = false) {
+  RecordingCallbacks callbacks;
+  ParserImpl parser(type, &callbacks);
+  callbacks.setParser(parser);
+  if (head_response) {
+    callbacks.setHeadResponse();
+  }
+  splits.push_back(input.size());
+  size_t begin = 0;
+  for (const size_t split : splits) {
+    // Each slice is copied to its own allocation for sanitizers to catch reads past it.
+    const std::string slice(input.substr(begin, split - begin));
+    size_t parsed = 0;
+    do {
+      parser.resume();
+      const Parser::RcVal rc = parser.execute(slice.data() + parsed, slice.size() - parsed);
+      parsed += rc.nread;
+      if (rc.rc != parser.statusToInt(ParserStatus::Success) &&
+          rc.rc != parser.statusToInt(ParserStatus::Paused)) {
+        // The data passed since the last event depends on where the input was split.
+        std::string trace = callbacks.trace();
+        trace.resize(std::min(trace.size(), trace.find('|', trace.rfind('>'))));
+        return absl::StrCat(trace, "<error ", parser.errnoName(rc.rc), ">");
+      }
+    } while (parsed < slice.size());
+    begin = split;
+  }
+  parser.resume();
+  const Parser::RcVal rc = parser.execute(nullptr, 0);
+  callbacks.event(absl::StrCat("<eof ", parser.errnoName(rc.rc), ">"));
+  return callbacks.trace();
+}
+
+struct ParserTestCase {
+  MessageType type_;
+  std::string input_;
+  bool head_response_{};
+};
+
+const std::vector<ParserTestCase>& testCases() {
+  CONSTRUCT_ON_FIRST_USE(
+      std::vector<ParserTestCase>,
+      {
+          {MessageType::Request, "GET / HTTP/1.1\r\nHost: host\r\n\r\n"},
+          {MessageType::Request, "POST /path?query#fragment HTTP/1.1\r\nContent-Length: 5\r\n\r\n"
+                                 "hello"},
+          {MessageType::Request, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                 "5\r\nhello\r\n3;name=value\r\nabc\r\n0\r\nTrailer: value\r\n\r\n"},
+          {MessageType::Request, "GET /a HTTP/1.0\r\nConnection: keep-alive\r\n\r\n"
+                                 "GET /b HTTP/1.0\r\n\r\nGET /c HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nConnection: close\r\n\r\nGET / HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nEmpty:\r\nSpace: \r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\nHost: host\n\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nFolded: a\r\n b\r\n\r\n"},
+          {MessageType::Request, "GET http://user@host:80/path?query HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "CONNECT host:443 HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nConnection: Upgrade, keep-alive\r\n"
+                                 "Upgrade: websocket\r\n\r\n"},
+          {MessageType::Request, "M-SEARCH * HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "SOURCE /stream ICE/1.0\r\n\r\n"},
+          {MessageType::Request, "GET /http09\r\n\r\n"},
+          {MessageType::Request, "\r\nPUT / HTTP/1.1\r\nContent-Length: 0\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nTransfer-Encoding: gzip, chunked\r\n"
+                                 "Content-Length: 3\r\n\r\n0\r\n\r\n"},
+          {MessageType::Request, absl::StrCat("GET /", std::string(100, 'p'), "?",
+                                              std::string(50, 'q'), " HTTP/1.1\r\n",
+                                              std::string(70, 'n'), ": ", std::string(100, 'v'),
+                                              "\r\n\r\n")},
+          // Invalid requests.
+          {MessageType::Request, "GETX / HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "get / HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "GET /\x01 HTTP/1.1\r\n\r\n"},
+          {MessageType::Request, "GET /stream ICE/1.0\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nContent-Length:\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 1\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nContent-Length: 1\r\n 2\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nTransfer-Encoding: gzip\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nTransfer-Encodingx: chunked\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nHost: a\x7f\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nHo st: a\r\n\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\nHost: a\rb\r\n\r\n"},
+          {MessageType::Request, "POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\nz\r\n"},
+          {MessageType::Request, "GET / HTTP/1.1\r\n"},
+          // Responses.
+          {MessageType::Response, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\nabc"},
+          {MessageType::Response, "HTTP/1.1 200 OK\r\n\r\nuntil the connection is closed"},
+          {MessageType::Response, "HTTP/1.1 204 No Content\r\n\r\nHTTP/1.1 100 Continue\r\n\r\n"},
+          {MessageType::Response, "HTTP/1.1 200 OK\r\nContent-Length: 3\r\n\r\n", true},
+          {MessageType::Response, "HTTP/1.1 101 Switching Protocols\r\nConnection: upgrade\r\n"
+                                  "Upgrade: h2c\r\n\r\n"},
+          {MessageType::Response, "HTTP/1.1 200 OK\r\nTransfer-Encoding: gzip\r\n\r\nabc"},
+          {MessageType::Response, "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                                  "10\r\n0123456789abcdef\r\n0\r\n\r\n"},
+          {MessageType::Response, "HTTP/1.0 200 OK\r\nContent-Length: 1\r\n\r\na"
+                                  "HTTP/1.1 200 OK\r\n\r\n"},
+          {MessageType::Response, "HTTP/1.1 200\nContent-Length: 0\n\n"},
+          // Invalid responses.
+          {MessageType::Response, "HTTP/1.1 1000 OK\r\n\r\n"},
+          {MessageType::Response, "XTTP/1.1 200 OK\r\n\r\n"},
+          {MessageType::Response, "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\na"},
+      });
+}
+
+class VectorizedParserImplTest
+    : public testing::TestWithParam<VectorizedHttpParserImpl::ScanKernel> {
+protected:
+  void SetUp() override { VectorizedHttpParserImpl::setScanKernelForTest(GetParam()); }
+  void TearDown() override {
+    VectorizedHttpParserImpl::setScanKernelForTest(
+        VectorizedHttpParserImpl::supportedScanKernels().back());
+  }
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    ScanKernels, VectorizedParserImplTest,
+    testing::ValuesIn(VectorizedHttpParserImpl::supportedScanKernels()),
+    [](const testing::TestParamInfo<VectorizedHttpParserImpl::ScanKernel>& info) -> std::string {
+      switch (info.param) {
+      case VectorizedHttpParserImpl::ScanKernel::Scalar:
+        return "Scalar";
+      case VectorizedHttpParserImpl::ScanKernel::Sse2:
+        return "Sse2";
+      case VectorizedHttpParserImpl::ScanKernel::Avx2:
+        return "Avx2";
+      }
+      return "";
+    });
+
+// The parser makes the same callbacks as http_parser, and reports the same errors, wherever the
+// input is split.
+TEST_P(VectorizedParserImplTest, SameAsLegacyParser) {
+  for (const ParserTestCase& test_case : testCases()) {
+    SCOPED_TRACE(test_case.input_);
+    const std::string expected = parse<LegacyHttpParserImpl>(test_case.type_, test_case.input_, {},
+                                                             test_case.head_response_);
+    EXPECT_EQ(expected, parse<VectorizedHttpParserImpl>(test_case.type_, test_case.input_, {},
+                                                        test_case.head_response_));
+    std::vector<size_t> every_byte;
+    for (size_t split = 1; split < test_case.input_.size(); split++) {
+      EXPECT_EQ(expected, parse<VectorizedHttpParserImpl>(test_case.type_, test_case.input_,
+                                                          {split}, test_case.head_response_))
+          << "split at " << split;
+      every_byte.push_back(split);
+    }
+    EXPECT_EQ(expected, parse<VectorizedHttpParserImpl>(test_case.type_, test_case.input_,
+                                                        every_byte, test_case.head_response_));
+  }
+}
+
+// Every byte value ends the scans of the URL, header name and header value at the same position as
+// http_parser, on both sides of the boundaries of the vectors.
+TEST_P(VectorizedParserImplTest, ScanBoundaries) {
+  const std::string request = absl::StrCat("GET /", std::string(80, 'p'), " HTTP/1.1\r\n",
+                                           std::string(80, 'n'), ": ", std::string(80, 'v'),
+                                           "\r\n\r\n");
+  const size_t url = request.find('p');
+  const size_t name = request.find('n');
+  const size_t value = request.find('v');
+  for (uint32_t byte = 0; byte < 256; byte++) {
+    for (const size_t offset : {0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 79}) {
+      for (const size_t position : {url, name, value}) {
+        std::string input = request;
+        input[position + offset] = static_cast<char>(byte);
+        EXPECT_EQ(parse<LegacyHttpParserImpl>(MessageType::Request, input, {}),
+                  parse<VectorizedHttpParserImpl>(MessageType::Request, input, {}))
+            << "byte " << byte << " at " << position + offset;
+      }
+    }
+  }
+}
+
+TEST(VectorizedParserImplKernelsTest, Supported) {
+  const std::vector<VectorizedHttpParserImpl::ScanKernel> kernels =
+      VectorizedHttpParserImpl::supportedScanKernels();
+  EXPECT_EQ(VectorizedHttpParserImpl::ScanKernel::Scalar, kernels.front());
+#if defined(__x86_64__)
+  EXPECT_NE(VectorizedHttpParserImpl::ScanKernel::Scalar, kernels.back());
+#endif
+}
+
+TEST(VectorizedParserImplStatusTest, SameAsLegacyParser) {
+  RecordingCallbacks callbacks;
+  LegacyHttpParserImpl legacy(MessageType::Request, &callbacks);
+  VectorizedHttpParserImpl vectorized(MessageType::Request, &callbacks);
+  for (const ParserStatus status : {ParserStatus::Error, ParserStatus::Success,
+                                    ParserStatus::NoBody, ParserStatus::NoBodyData,
+                                    ParserStatus::Paused}) {
+    EXPECT_EQ(legacy.statusToInt(status), vectorized.statusToInt(status));
+  }
+  for (int rc = 0; rc <= 33; rc++) {
+    EXPECT_EQ(legacy.errnoName(rc), vectorized.errnoName(rc));
+  }
+  EXPECT_EQ(legacy.methodName(), vectorized.methodName());
+  EXPECT_EQ(legacy.getStatus(), vectorized.getStatus());
+  legacy.pause();
+  vectorized.pause();
+  EXPECT_EQ(legacy.getStatus(), vectorized.getStatus());
+}
+
+} // namespace
+} // namespace Http1
+} // namespace Http
+} // namespace Envoy
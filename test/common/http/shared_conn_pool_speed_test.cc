@@ -0,0 +1,278 @@
+// Usage: bazel run //test/common/http:shared_conn_pool_speed_test
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "source/common/common/linked_object.h"
+#include "source/common/http/codec_helper.h"
+#include "source/common/http/header_map_impl.h"
+#include "source/common/http/shared_conn_pool.h"
+#include "source/common/network/socket_impl.h"
+#include "source/common/stream_info/stream_info_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/utility.h"
+
+#include "benchmark/benchmark.h"
+
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+// A single upstream connection, answering every request as soon as its headers are encoded, as
+// would an upstream without any latency, so that the benchmarks measure the overhead of the pools.
+class FakeConnection : public ConnectionPool::Instance {
+public:
+  FakeConnection(Event::Dispatcher& dispatcher, Upstream::HostConstSharedPtr host)
+      : dispatcher_(dispatcher), host_(std::move(host)),
+        stream_info_(dispatcher.timeSource(),
+                     std::make_shared<Network::ConnectionInfoSetterImpl>(nullptr, nullptr)) {}
+
+  // ConnectionPool::Instance
+  void addIdleCallback(IdleCb) override {}
+  bool isIdle() const override { return false; }
+  void drainConnections(Envoy::ConnectionPool::DrainBehavior) override {}
+  Upstream::HostDescriptionConstSharedPtr host() const override { return host_; }
+  bool maybePreconnect(float) override { return false; }
+  bool hasActiveConnections() const override { return true; }
+  ConnectionPool::Cancellable* newStream(ResponseDecoder& response_decoder,
+                                         ConnectionPool::Callbacks& callbacks) override {
+    used_ = true;
+    auto stream = std::make_unique<FakeStream>(*this, response_decoder);
+    FakeStream& ready = *stream;
+    LinkedList::moveIntoList(std::move(stream), streams_);
+    callbacks.onPoolReady(ready, host_, stream_info_, Protocol::Http2);
+    return nullptr;
+  }
+  absl::string_view protocolDescription() const override { return "fake"; }
+
+  bool used() const { return used_; }
+
+private:
+  class FakeStream : public RequestEncoder,
+                     public Stream,
+                     public StreamCallbackHelper,
+                     public LinkedObject<FakeStream>,
+                     public Event::DeferredDeletable {
+  public:
+    FakeStream(FakeConnection& parent, ResponseDecoder& response_decoder)
+        : parent_(parent), response_decoder_(response_decoder) {}
+
+    // Http::RequestEncoder
+    Status encodeHeaders(const RequestHeaderMap&, bool end_stream) override {
+      if (end_stream) {
+        response_decoder_.decodeHeaders(
+            createHeaderMap<ResponseHeaderMapImpl>({{Headers::get().Status, "200"}}), true);
+        parent_.dispatcher_.deferredDelete(removeFromList(parent_.streams_));
+      }
+      return okStatus();
+    }
+    void encodeTrailers(const RequestTrailerMap&) override {}
+    void enableTcpTunneling() override {}
+
+    // Http::StreamEncoder
+    void encodeData(Buffer::Instance&, bool) override {}
+    Stream& getStream() override { return *this; }
+    void encodeMetadata(const MetadataMapVector&) override {}
+    Http1StreamEncoderOptionsOptRef http1StreamEncoderOptions() override { return absl::nullopt; }
+
+    // Http::Stream
+    void addCallbacks(StreamCallbacks& callbacks) override { addCallbacksHelper(callbacks); }
+    void removeCallbacks(StreamCallbacks& callbacks) override { removeCallbacksHelper(callbacks); }
+    void resetStream(StreamResetReason) override {}
+    void readDisable(bool) override {}
+    uint32_t bufferLimit() override { return 0; }
+    const Network::Address::InstanceConstSharedPtr& connectionLocalAddress() override {
+      return connection_local_address_;
+    }
+    void setFlushTimeout(std::chrono::milliseconds) override {}
+    void setAccount(Buffer::BufferMemoryAccountSharedPtr) override {}
+    const StreamInfo::BytesMeterSharedPtr& bytesMeter() override { return bytes_meter_; }
+
+  private:
+    FakeConnection& parent_;
+    ResponseDecoder& response_decoder_;
+    Network::Address::InstanceConstSharedPtr connection_local_address_;
+    StreamInfo::BytesMeterSharedPtr bytes_meter_{std::make_shared<StreamInfo::BytesMeter>()};
+  };
+
+  Event::Dispatcher& dispatcher_;
+  const Upstream::HostConstSharedPtr host_;
+  StreamInfo::StreamInfoImpl stream_info_;
+  std::list<std::unique_ptr<FakeStream>> streams_;
+  bool used_{};
+};
+
+// Sends requests one at a time through a pool, waiting for each response.
+class Client : public ResponseDecoder, public ConnectionPool::Callbacks {
+public:
+  Client(Event::Dispatcher& dispatcher, ConnectionPool::Instance& pool)
+      : dispatcher_(dispatcher), pool_(pool) {}
+
+  void request() {
+    done_ = false;
+    pool_.newStream(*this, *this);
+    if (!done_) {
+      waiting_ = true;
+      dispatcher_.run(Event::Dispatcher::RunType::RunUntilExit);
+      waiting_ = false;
+    }
+    dispatcher_.clearDeferredDeleteList();
+  }
+
+  // ConnectionPool::Callbacks
+  void onPoolFailure(ConnectionPool::PoolFailureReason, absl::string_view,
+                     Upstream::HostDescriptionConstSharedPtr) override {
+    onDone();
+  }
+  void onPoolReady(RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                   const StreamInfo::StreamInfo&, absl::optional<Protocol>) override {
+    encoder.encodeHeaders(request_headers_, true).IgnoreError();
+  }
+
+  // Http::ResponseDecoder
+  void decode100ContinueHeaders(ResponseHeaderMapPtr&&) override {}
+  void decodeHeaders(ResponseHeaderMapPtr&&, bool end_stream) override {
+    if (end_stream) {
+      onDone();
+    }
+  }
+  void decodeData(Buffer::Instance&, bool) override {}
+  void decodeTrailers(ResponseTrailerMapPtr&&) override {}
+  void decodeMetadata(MetadataMapPtr&&) override {}
+  void dumpState(std::ostream&, int) const override {}
+
+private:
+  void onDone() {
+    done_ = true;
+    if (waiting_) {
+      dispatcher_.exit();
+    }
+  }
+
+  Event::Dispatcher& dispatcher_;
+  ConnectionPool::Instance& pool_;
+  const RequestHeaderMapPtr request_headers_{createHeaderMap<RequestHeaderMapImpl>(
+      {{Headers::get().Method, "GET"},
+       {Headers::get().Path, "/"},
+       {Headers::get().Host, "host"},
+       {Headers::get().Scheme, "http"}})};
+  bool done_{};
+  bool waiting_{};
+};
+
+// Workers owning the shared connections, each running its dispatcher on its own thread.
+class Owners {
+public:
+  Owners(Api::Api& api, uint32_t num_owners, const Upstream::HostConstSharedPtr& host) {
+    for (uint32_t i = 0; i < num_owners; i++) {
+      dispatchers_.push_back(api.allocateDispatcher("owner"));
+      connections_.push_back(std::make_unique<FakeConnection>(*dispatchers_.back(), host));
+    }
+    for (auto& dispatcher : dispatchers_) {
+      threads_.push_back(api.threadFactory().createThread([&dispatcher]() -> void {
+        dispatcher->run(Event::Dispatcher::RunType::RunUntilExit);
+      }));
+    }
+  }
+
+  ~Owners() {
+    for (uint32_t i = 0; i < threads_.size(); i++) {
+      Event::Dispatcher* dispatcher = dispatchers_[i].get();
+      dispatcher->post([dispatcher]() -> void { dispatcher->exit(); });
+      threads_[i]->join();
+    }
+  }
+
+  std::vector<Event::DispatcherPtr> dispatchers_;
+  std::vector<std::unique_ptr<FakeConnection>> connections_;
+  std::vector<Thread::ThreadPtr> threads_;
+};
+
+Api::ApiPtr api;
+Upstream::HostConstSharedPtr host;
+std::unique_ptr<Owners> owners;
+std::atomic<uint32_t> used_connections;
+
+// Measures the latency of a request from each of the benchmark threads, acting as workers, and
+// the number of upstream connections they use. With 0 owners, every worker uses a connection of
+// its own. Otherwise, the workers hand off their streams to one of the owners, sharing their
+// connections. Owners don't send requests of their own, so that the latency reported is the one of
+// the requests handed off.
+void benchmarkSharedConnPool(::benchmark::State& state) {
+  const uint32_t num_owners = state.range(0);
+
+  if (benchmark::skipExpensiveBenchmarks() && state.threads > 4) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  if (state.thread_index == 0) {
+    if (api == nullptr) {
+      api = Api::createApiForTest();
+      host = std::make_shared<NiceMock<Upstream::MockHost>>();
+    }
+    owners = std::make_unique<Owners>(*api, num_owners, host);
+    used_connections = 0;
+  }
+  // Every thread reaches the benchmark loop once the setup above is done.
+  Event::DispatcherPtr dispatcher;
+  std::unique_ptr<FakeConnection> connection;
+  std::unique_ptr<ConnectionPool::Instance> pool;
+  std::unique_ptr<Client> client;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    if (client == nullptr) {
+      state.PauseTiming();
+      dispatcher = api->allocateDispatcher("worker");
+      if (num_owners == 0) {
+        connection = std::make_unique<FakeConnection>(*dispatcher, host);
+        client = std::make_unique<Client>(*dispatcher, *connection);
+        used_connections++;
+      } else {
+        const uint32_t owner = state.thread_index % num_owners;
+        FakeConnection* owner_connection = owners->connections_[owner].get();
+        pool = std::make_unique<SharedConnPool>(
+            *dispatcher, *owners->dispatchers_[owner], host,
+            [owner_connection]() -> ConnectionPool::Instance* { return owner_connection; });
+        client = std::make_unique<Client>(*dispatcher, *pool);
+      }
+      state.ResumeTiming();
+    }
+    client->request();
+  }
+
+  client.reset();
+  pool.reset();
+  connection.reset();
+  if (dispatcher != nullptr) {
+    dispatcher->clearDeferredDeleteList();
+  }
+
+  if (state.thread_index == 0) {
+    // The other threads are done with the owners once they are out of the benchmark loop.
+    for (const auto& owner_connection : owners->connections_) {
+      if (owner_connection->used()) {
+        used_connections++;
+      }
+    }
+    state.counters["upstream_cx"] = used_connections.load();
+    owners.reset();
+  }
+}
+
+BENCHMARK(benchmarkSharedConnPool)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(2)
+    ->ThreadRange(1, 16)
+    ->UseRealTime()
+    ->Unit(::benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
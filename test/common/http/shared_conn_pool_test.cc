@@ -0,0 +1,256 @@
+#include <list>
+#include <memory>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/http/shared_conn_pool.h"
+#include "source/common/network/address_impl.h"
+
+#include "test/mocks/buffer/mocks.h"
+#include "test/mocks/common.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/http/conn_pool.h"
+#include "test/mocks/http/mocks.h"
+#include "test/mocks/http/stream_decoder.h"
+#include "test/mocks/http/stream_encoder.h"
+#include "test/mocks/stream_info/mocks.h"
+#include "test/mocks/upstream/host.h"
+#include "test/test_common/printers.h"
+#include "test/test_common/utility.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+using testing::Return;
+using testing::StrictMock;
+
+namespace Envoy {
+namespace Http {
+namespace {
+
+class SharedConnPoolTest : public testing::Test {
+public:
+  SharedConnPoolTest() {
+    // Posted events are queued, so that the order in which each worker runs them is explicit.
+    ON_CALL(dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      local_posted_.push_back(std::move(cb));
+    }));
+    ON_CALL(owner_dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      owner_posted_.push_back(std::move(cb));
+    }));
+    owner_encoder_.stream_.connection_local_address_ =
+        std::make_shared<Network::Address::Ipv4Instance>("10.0.0.1", 40000);
+    ON_CALL(owner_encoder_.stream_, bufferLimit()).WillByDefault(Return(1024));
+    owner_info_.downstream_connection_info_provider_->setConnectionID(42);
+    pool_ = std::make_unique<SharedConnPool>(
+        dispatcher_, owner_dispatcher_, host_, [this]() -> ConnectionPool::Instance* {
+          return owner_pool_available_ ? &owner_pool_ : nullptr;
+        });
+    pool_->addIdleCallback([this]() -> void { idle_++; });
+  }
+
+  void runPosted(std::list<Event::PostCb>& posted) {
+    while (!posted.empty()) {
+      Event::PostCb cb = std::move(posted.front());
+      posted.pop_front();
+      cb();
+    }
+  }
+  void runOwner() { runPosted(owner_posted_); }
+  void runLocal() { runPosted(local_posted_); }
+
+  // Creates a stream, which is pending on the owner's pool.
+  void newPendingStream() {
+    EXPECT_CALL(owner_pool_, newStream(_, _))
+        .WillOnce(Invoke([this](ResponseDecoder& decoder, ConnectionPool::Callbacks& callbacks)
+                             -> ConnectionPool::Cancellable* {
+          owner_decoder_ = &decoder;
+          owner_callbacks_ = &callbacks;
+          return &owner_cancellable_;
+        }));
+    handle_ = pool_->newStream(response_decoder_, callbacks_);
+    ASSERT_NE(nullptr, handle_);
+    EXPECT_FALSE(pool_->isIdle());
+    runOwner();
+  }
+
+  // Creates a stream, and makes it ready on both workers.
+  void newReadyStream() {
+    newPendingStream();
+    owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_info_, Protocol::Http2);
+    EXPECT_CALL(callbacks_, onPoolReady(_, _, _, _))
+        .WillOnce(Invoke([this](RequestEncoder& encoder, Upstream::HostDescriptionConstSharedPtr,
+                                const StreamInfo::StreamInfo& info,
+                                absl::optional<Protocol> protocol) -> void {
+          encoder_ = &encoder;
+          EXPECT_EQ(42, info.downstreamAddressProvider().connectionID().value());
+          EXPECT_EQ(Protocol::Http2, protocol.value());
+        }));
+    runLocal();
+    ASSERT_NE(nullptr, encoder_);
+    encoder_->getStream().addCallbacks(stream_callbacks_);
+  }
+
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Event::MockDispatcher> owner_dispatcher_;
+  std::list<Event::PostCb> local_posted_;
+  std::list<Event::PostCb> owner_posted_;
+  std::shared_ptr<Upstream::MockHost> host_{std::make_shared<NiceMock<Upstream::MockHost>>()};
+  NiceMock<ConnectionPool::MockInstance> owner_pool_;
+  bool owner_pool_available_{true};
+  NiceMock<Envoy::ConnectionPool::MockCancellable> owner_cancellable_;
+  NiceMock<MockRequestEncoder> owner_encoder_;
+  NiceMock<StreamInfo::MockStreamInfo> owner_info_;
+  ResponseDecoder* owner_decoder_{};
+  ConnectionPool::Callbacks* owner_callbacks_{};
+  NiceMock<MockResponseDecoder> response_decoder_;
+  StrictMock<ConnectionPool::MockCallbacks> callbacks_;
+  NiceMock<MockStreamCallbacks> stream_callbacks_;
+  ConnectionPool::Cancellable* handle_{};
+  RequestEncoder* encoder_{};
+  uint32_t idle_{};
+  std::unique_ptr<SharedConnPool> pool_;
+};
+
+TEST_F(SharedConnPoolTest, RequestAndResponse) {
+  newReadyStream();
+  EXPECT_EQ(1024, encoder_->getStream().bufferLimit());
+  EXPECT_EQ("10.0.0.1:40000", encoder_->getStream().connectionLocalAddress()->asString());
+
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "POST"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+  EXPECT_TRUE(encoder_->encodeHeaders(request_headers, false).ok());
+  Buffer::OwnedImpl request_body("hello");
+  encoder_->encodeData(request_body, true);
+  EXPECT_EQ(0, request_body.length());
+
+  EXPECT_CALL(owner_encoder_, encodeHeaders(HeaderMapEqualRef(&request_headers), false));
+  EXPECT_CALL(owner_encoder_, encodeData(BufferStringEqual("hello"), true));
+  runOwner();
+
+  owner_decoder_->decodeHeaders(
+      ResponseHeaderMapPtr{new TestResponseHeaderMapImpl{{":status", "200"}}}, false);
+  Buffer::OwnedImpl response_body("world");
+  owner_decoder_->decodeData(response_body, false);
+  owner_decoder_->decodeTrailers(ResponseTrailerMapPtr{new TestResponseTrailerMapImpl{{"a", "b"}}});
+  // The owner is done with the stream, and detached from it.
+  EXPECT_TRUE(owner_encoder_.stream_.callbacks_.empty());
+
+  EXPECT_CALL(response_decoder_, decodeHeaders_(_, false));
+  EXPECT_CALL(response_decoder_, decodeData(BufferStringEqual("world"), false));
+  EXPECT_CALL(response_decoder_, decodeTrailers_(_));
+  runLocal();
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_EQ(1, idle_);
+}
+
+TEST_F(SharedConnPoolTest, MissingRequiredHeaders) {
+  newReadyStream();
+  TestRequestHeaderMapImpl request_headers{{":path", "/"}};
+  EXPECT_FALSE(encoder_->encodeHeaders(request_headers, true).ok());
+  EXPECT_TRUE(owner_posted_.empty());
+}
+
+TEST_F(SharedConnPoolTest, PoolFailure) {
+  newPendingStream();
+  owner_callbacks_->onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                  "connection refused", host_);
+  EXPECT_CALL(callbacks_, onPoolFailure(ConnectionPool::PoolFailureReason::RemoteConnectionFailure,
+                                        "connection refused", _));
+  runLocal();
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_EQ(1, idle_);
+}
+
+TEST_F(SharedConnPoolTest, OwnerPoolUnavailable) {
+  owner_pool_available_ = false;
+  handle_ = pool_->newStream(response_decoder_, callbacks_);
+  runOwner();
+  EXPECT_CALL(callbacks_, onPoolFailure(ConnectionPool::PoolFailureReason::LocalConnectionFailure,
+                                        "shared connection pool owner unavailable", _));
+  runLocal();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(SharedConnPoolTest, CancelPending) {
+  newPendingStream();
+  handle_->cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess);
+  EXPECT_TRUE(pool_->isIdle());
+  EXPECT_CALL(owner_cancellable_, cancel(Envoy::ConnectionPool::CancelPolicy::CloseExcess));
+  runOwner();
+}
+
+// The owner's stream may be ready before the cancellation gets to the owner.
+TEST_F(SharedConnPoolTest, CancelRacingReady) {
+  newPendingStream();
+  handle_->cancel(Envoy::ConnectionPool::CancelPolicy::Default);
+  owner_callbacks_->onPoolReady(owner_encoder_, host_, owner_info_, Protocol::Http2);
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+  // The ready event is dropped.
+  runLocal();
+  EXPECT_TRUE(pool_->isIdle());
+}
+
+TEST_F(SharedConnPoolTest, LocalReset) {
+  newReadyStream();
+  EXPECT_CALL(stream_callbacks_, onResetStream(StreamResetReason::LocalReset, _));
+  encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_TRUE(pool_->isIdle());
+
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::LocalReset));
+  runOwner();
+  EXPECT_TRUE(owner_encoder_.stream_.callbacks_.empty());
+}
+
+TEST_F(SharedConnPoolTest, RemoteReset) {
+  newReadyStream();
+  owner_encoder_.stream_.resetStream(StreamResetReason::RemoteReset);
+  EXPECT_CALL(stream_callbacks_, onResetStream(StreamResetReason::RemoteReset, _));
+  runLocal();
+  EXPECT_TRUE(pool_->isIdle());
+
+  // Requests encoded concurrently with the reset are dropped.
+  TestRequestHeaderMapImpl request_headers{
+      {":method", "GET"}, {":path", "/"}, {":authority", "host"}, {":scheme", "http"}};
+  EXPECT_CALL(owner_encoder_, encodeHeaders(_, _)).Times(0);
+  encoder_->encodeHeaders(request_headers, true).IgnoreError();
+  runOwner();
+}
+
+TEST_F(SharedConnPoolTest, Watermarks) {
+  newReadyStream();
+  owner_encoder_.stream_.runHighWatermarkCallbacks();
+  owner_encoder_.stream_.runLowWatermarkCallbacks();
+  EXPECT_CALL(stream_callbacks_, onAboveWriteBufferHighWatermark());
+  EXPECT_CALL(stream_callbacks_, onBelowWriteBufferLowWatermark());
+  runLocal();
+
+  EXPECT_CALL(owner_encoder_.stream_, readDisable(true));
+  encoder_->getStream().readDisable(true);
+  runOwner();
+}
+
+TEST_F(SharedConnPoolTest, DrainAndDelete) {
+  newReadyStream();
+  pool_->drainConnections(Envoy::ConnectionPool::DrainBehavior::DrainAndDelete);
+  EXPECT_EQ(0, idle_);
+
+  EXPECT_CALL(stream_callbacks_, onResetStream(StreamResetReason::LocalReset, _));
+  encoder_->getStream().resetStream(StreamResetReason::LocalReset);
+  EXPECT_EQ(1, idle_);
+}
+
+TEST_F(SharedConnPoolTest, DestroyWithStreamInFlight) {
+  newReadyStream();
+  EXPECT_CALL(stream_callbacks_, onResetStream(StreamResetReason::ConnectionTermination, _));
+  pool_.reset();
+  EXPECT_CALL(owner_encoder_.stream_, resetStream(StreamResetReason::ConnectionTermination));
+  runOwner();
+}
+
+} // namespace
+} // namespace Http
+} // namespace Envoy
@@ -6,6 +6,7 @@
 
 #include "test/mocks/server/instance.h"
 #include "test/mocks/stream_info/mocks.h"
+#include "test/test_common/test_runtime.h"
 #include "test/test_common/utility.h"
 
 #include "benchmark/benchmark.h"
@@ -59,7 +60,7 @@ static RouteConfiguration genRouteConfig(benchmark::State& state,
       break;
     }
     case RouteMatch::PathSpecifierCase::kPath: {
-      match->set_prefix(absl::StrCat("/shelves/shelf_", i, "/route_", i));
+      match->set_path(absl::StrCat("/shelves/shelf_", i, "/route_", i));
       break;
     }
     case RouteMatch::PathSpecifierCase::kSafeRegex: {
@@ -85,7 +86,12 @@ static RouteConfiguration genRouteConfig(benchmark::State& state,
  * We then time how long it takes for the request to be matched against the
  * last route.
  */
-static void bmRouteTableSize(benchmark::State& state, RouteMatch::PathSpecifierCase match_type) {
+static void bmRouteTableSize(benchmark::State& state, RouteMatch::PathSpecifierCase match_type,
+                             bool compiled = false) {
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.compiled_route_matching", compiled ? "true" : "false"}});
+
   // Setup router for benchmarking.
   Api::ApiPtr api = Api::createApiForTest();
   NiceMock<Server::Configuration::MockServerFactoryContext> factory_context;
@@ -136,10 +142,33 @@ static void bmRouteTableSizeWithRegexMatch(benchmark::State& state) {
   bmRouteTableSize(state, RouteMatch::PathSpecifierCase::kSafeRegex);
 }
 
+/**
+ * Same as the benchmarks above, but with the route table compiled into a RouteMatchIndex.
+ */
+static void bmCompiledRouteTableSizeWithPathPrefixMatch(benchmark::State& state) {
+  bmRouteTableSize(state, RouteMatch::PathSpecifierCase::kPrefix, true);
+}
+
+static void bmCompiledRouteTableSizeWithExactPathMatch(benchmark::State& state) {
+  bmRouteTableSize(state, RouteMatch::PathSpecifierCase::kPath, true);
+}
+
+static void bmCompiledRouteTableSizeWithRegexMatch(benchmark::State& state) {
+  bmRouteTableSize(state, RouteMatch::PathSpecifierCase::kSafeRegex, true);
+}
+
 BENCHMARK(bmRouteTableSizeWithPathPrefixMatch)->RangeMultiplier(2)->Ranges({{1, 2 << 13}});
 BENCHMARK(bmRouteTableSizeWithExactPathMatch)->RangeMultiplier(2)->Ranges({{1, 2 << 13}});
 BENCHMARK(bmRouteTableSizeWithRegexMatch)->RangeMultiplier(2)->Ranges({{1, 2 << 13}});
 
+// Linear vs. compiled matching at 10, 1k and 10k routes.
+BENCHMARK(bmRouteTableSizeWithPathPrefixMatch)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(bmCompiledRouteTableSizeWithPathPrefixMatch)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(bmRouteTableSizeWithExactPathMatch)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(bmCompiledRouteTableSizeWithExactPathMatch)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(bmRouteTableSizeWithRegexMatch)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(bmCompiledRouteTableSizeWithRegexMatch)->Arg(10)->Arg(1000)->Arg(10000);
+
 } // namespace
 } // namespace Router
 } // namespace Envoy
@@ -1155,6 +1155,81 @@ virtual_hosts:
             config.route(genHeaders("example.com", "/", "GET"), 0)->routeEntry()->clusterName());
 }
 
+// Verify that the compiled route index returns the same route as the linear walk, including when
+// an earlier path candidate is rejected by non-path criteria.
+TEST_F(RouteMatcherTest, CompiledRouteMatchingPreservesFirstMatch) {
+  const std::string yaml = R"EOF(
+virtual_hosts:
+- name: default
+  domains: ["*"]
+  routes:
+  - match:
+      prefix: "/api"
+      headers:
+      - name: x-canary
+        string_match:
+          exact: "true"
+    route: { cluster: canary }
+  - match:
+      path: "/api/exact"
+    route: { cluster: exact }
+  - match:
+      safe_regex:
+        google_re2: {}
+        regex: "/api/[0-9]+"
+    route: { cluster: regex }
+  - match:
+      prefix: "/API/IGNORE"
+      case_sensitive: false
+    route: { cluster: ignore_case }
+  - match:
+      connect_matcher: {}
+    route: { cluster: connect }
+  - match:
+      prefix: "/api"
+    route: { cluster: api }
+  - match:
+      path: "/api/exact"
+    route: { cluster: shadowed }
+  )EOF";
+
+  factory_context_.cluster_manager_.initializeClusters(
+      {"canary", "exact", "regex", "ignore_case", "connect", "api", "shadowed"}, {});
+  const auto proto_config = parseRouteConfigurationFromYaml(yaml);
+
+  for (const std::string compiled : {"false", "true"}) {
+    TestScopedRuntime scoped_runtime;
+    Runtime::LoaderSingleton::getExisting()->mergeValues(
+        {{"envoy.reloadable_features.compiled_route_matching", compiled}});
+    TestConfigImpl config(proto_config, factory_context_, true);
+
+    {
+      Http::TestRequestHeaderMapImpl headers = genHeaders("www.lyft.com", "/api/exact", "GET");
+      headers.addCopy("x-canary", "true");
+      EXPECT_EQ("canary", config.route(headers, 0)->routeEntry()->clusterName());
+    }
+    EXPECT_EQ("exact", config.route(genHeaders("www.lyft.com", "/api/exact?foo=bar", "GET"), 0)
+                             ->routeEntry()
+                             ->clusterName());
+    EXPECT_EQ("regex", config.route(genHeaders("www.lyft.com", "/api/123", "GET"), 0)
+                             ->routeEntry()
+                             ->clusterName());
+    EXPECT_EQ("ignore_case", config.route(genHeaders("www.lyft.com", "/api/ignore/me", "GET"), 0)
+                                 ->routeEntry()
+                                 ->clusterName());
+    EXPECT_EQ("connect", config.route(genHeaders("www.lyft.com", "/connect", "CONNECT"), 0)
+                             ->routeEntry()
+                             ->clusterName());
+    EXPECT_EQ("connect", config.route(genPathlessHeaders("www.lyft.com", "CONNECT"), 0)
+                             ->routeEntry()
+                             ->clusterName());
+    EXPECT_EQ("api", config.route(genHeaders("www.lyft.com", "/api/abc", "GET"), 0)
+                         ->routeEntry()
+                         ->clusterName());
+    EXPECT_EQ(nullptr, config.route(genHeaders("www.lyft.com", "/other", "GET"), 0));
+  }
+}
+
 TEST_F(RouteMatcherTest, TestRoutesWithInvalidRegex) {
   std::string invalid_route = R"EOF(
 virtual_hosts:
@@ -0,0 +1,98 @@
+#include "source/common/router/route_match_index.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Router {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+class RouteMatchIndexTest : public testing::Test {
+protected:
+  RouteMatchIndex::Candidates candidates(absl::string_view path) {
+    RouteMatchIndex::Candidates result;
+    index_.candidates(path, result);
+    return result;
+  }
+
+  RouteMatchIndex index_;
+};
+
+TEST_F(RouteMatchIndexTest, Empty) {
+  index_.compile();
+  EXPECT_EQ(0, index_.size());
+  EXPECT_THAT(candidates("/foo"), IsEmpty());
+}
+
+TEST_F(RouteMatchIndexTest, Prefix) {
+  index_.addRoute(PathMatchType::Prefix, "/foo/bar", true);
+  index_.addRoute(PathMatchType::Prefix, "/foo", true);
+  index_.addRoute(PathMatchType::Prefix, "/baz", true);
+  index_.addRoute(PathMatchType::Prefix, "/", true);
+  index_.addRoute(PathMatchType::Prefix, "/foo", true);
+  index_.compile();
+
+  EXPECT_THAT(candidates("/foo/bar/baz"), ElementsAre(0, 1, 3, 4));
+  EXPECT_THAT(candidates("/foo"), ElementsAre(1, 3, 4));
+  EXPECT_THAT(candidates("/fo"), ElementsAre(3));
+  EXPECT_THAT(candidates("/FOO"), ElementsAre(3));
+  EXPECT_THAT(candidates("other"), IsEmpty());
+  // The query string is not part of the matched path.
+  EXPECT_THAT(candidates("/fo?o/bar"), ElementsAre(3));
+}
+
+TEST_F(RouteMatchIndexTest, Exact) {
+  index_.addRoute(PathMatchType::Exact, "/foo", true);
+  index_.addRoute(PathMatchType::Exact, "/bar", true);
+  index_.addRoute(PathMatchType::Exact, "/foo", true);
+  index_.compile();
+
+  EXPECT_THAT(candidates("/foo"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/foo?bar"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/foo#bar"), ElementsAre(0, 2));
+  EXPECT_THAT(candidates("/bar"), ElementsAre(1));
+  EXPECT_THAT(candidates("/foo/"), IsEmpty());
+}
+
+TEST_F(RouteMatchIndexTest, IgnoreCase) {
+  index_.addRoute(PathMatchType::Prefix, "/Foo", false);
+  index_.addRoute(PathMatchType::Exact, "/BAR", false);
+  index_.addRoute(PathMatchType::Exact, "/BAR", true);
+  index_.compile();
+
+  EXPECT_THAT(candidates("/fOO/baz"), ElementsAre(0));
+  EXPECT_THAT(candidates("/bar"), ElementsAre(1));
+  EXPECT_THAT(candidates("/BAR"), ElementsAre(1, 2));
+}
+
+TEST_F(RouteMatchIndexTest, Regex) {
+  index_.addRoute(PathMatchType::Regex, "/shelves/[^/]+/books", true);
+  index_.addRoute(PathMatchType::Prefix, "/shelves", true);
+  index_.addRoute(PathMatchType::Regex, "/shelves/.*", true);
+  index_.compile();
+
+  EXPECT_THAT(candidates("/shelves/1/books"), ElementsAre(0, 1, 2));
+  EXPECT_THAT(candidates("/shelves/1/books?a=b"), ElementsAre(0, 1, 2));
+  // Regexes are anchored at both ends, matching RE2::FullMatch().
+  EXPECT_THAT(candidates("/shelves/1/books/2"), ElementsAre(1, 2));
+  EXPECT_THAT(candidates("/x/shelves/1/books"), IsEmpty());
+}
+
+TEST_F(RouteMatchIndexTest, Unindexed) {
+  index_.addRoute(PathMatchType::Prefix, "/foo", true);
+  index_.addRoute(PathMatchType::None, "", true);
+  index_.addRoute(PathMatchType::Exact, "/bar", true);
+  index_.compile();
+
+  EXPECT_EQ(3, index_.size());
+  EXPECT_THAT(candidates("/foo"), ElementsAre(0, 1));
+  EXPECT_THAT(candidates("/bar"), ElementsAre(1, 2));
+  EXPECT_THAT(candidates("/baz"), ElementsAre(1));
+}
+
+} // namespace
+} // namespace Router
+} // namespace Envoy
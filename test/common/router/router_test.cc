@@ -1247,6 +1247,9 @@ TEST_F(RouterTest, ResetDuringEncodeHeaders) {
                         absl::optional<uint64_t>(absl::nullopt)));
   EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
               putResult(Upstream::Outlier::Result::LocalOriginConnectFailed, _));
+  // The reset before the response feeds the latency estimate with the timeout of the request.
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->latency_estimator_,
+              putRoundTripTime(std::chrono::microseconds(10000)));
   router_.decodeHeaders(headers, true);
   EXPECT_EQ(1U,
             callbacks_.route_->route_entry_.virtual_cluster_.stats().upstream_rq_total_.value());
@@ -1290,6 +1293,8 @@ TEST_F(RouterTest, UpstreamTimeout) {
   EXPECT_CALL(*router_.retry_state_, shouldRetryReset(_, _)).Times(0);
   EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
               putResult(Upstream::Outlier::Result::LocalOriginTimeout, _));
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->latency_estimator_,
+              putRoundTripTime(std::chrono::microseconds(10000)));
   response_timeout_->invokeCallback();
 
   EXPECT_EQ(1U,
@@ -1812,6 +1817,9 @@ TEST_F(RouterTest, GrpcReset) {
   EXPECT_TRUE(verifyHostUpstreamStats(0, 0));
   EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->outlier_detector_,
               putResult(Upstream::Outlier::Result::LocalOriginConnectFailed, _));
+  // The first response byte was received, the latency of the host is not penalized.
+  EXPECT_CALL(cm_.thread_local_cluster_.conn_pool_.host_->latency_estimator_, putRoundTripTime(_))
+      .Times(0);
   encoder1.stream_.resetStream(Http::StreamResetReason::RemoteReset);
   EXPECT_TRUE(verifyHostUpstreamStats(0, 1));
   EXPECT_EQ(1UL, stats_store_.counter("test.rq_reset_after_downstream_response_started").value());
@@ -107,5 +107,50 @@ TEST_F(HistogramSettingsImplTest, ScaledPercent) {
   EXPECT_EQ(settings_->buckets("abcd"), ConstSupportedBuckets({0.1, 2}));
 }
 
+// Test that the histogram mode is taken from the config.
+TEST_F(HistogramSettingsImplTest, FixedBuckets) {
+  initialize();
+  EXPECT_FALSE(settings_->fixedBuckets());
+  EXPECT_FALSE(HistogramSettingsImpl().fixedBuckets());
+
+  envoy::config::metrics::v3::StatsConfig config;
+  config.set_histogram_mode(envoy::config::metrics::v3::StatsConfig::FIXED_BUCKETS);
+  EXPECT_TRUE(HistogramSettingsImpl(config).fixedBuckets());
+}
+
+// Test the statistics computed from bucket counts, with quantiles interpolated within the buckets.
+TEST(HistogramStatisticsImplTest, BucketCounts) {
+  const ConstSupportedBuckets buckets{1, 2, 4, 8};
+  HistogramStatisticsImpl statistics(Histogram::Unit::Unspecified, buckets);
+  EXPECT_EQ(0, statistics.sampleCount());
+  EXPECT_EQ("B1: 0, B2: 0, B4: 0, B8: 0", statistics.bucketSummary());
+  EXPECT_EQ("P0: 0, P25: 0, P50: 0, P75: 0, P90: 0, P95: 0, P99: 0, P99.5: 0, P99.9: 0, P100: 0",
+            statistics.quantileSummary());
+
+  statistics.refresh({1, 1, 1, 1, 0}, 10);
+  EXPECT_EQ(4, statistics.sampleCount());
+  EXPECT_EQ(10, statistics.sampleSum());
+  EXPECT_EQ("B1: 1, B2: 2, B4: 3, B8: 4", statistics.bucketSummary());
+  EXPECT_EQ("P0: 0, P25: 1, P50: 2, P75: 4, P90: 6.4, P95: 7.2, P99: 7.84, P99.5: 7.92, "
+            "P99.9: 7.984, P100: 8",
+            statistics.quantileSummary());
+
+  // Values above the last bucket are reported as the last bucket's bound.
+  statistics.refresh({0, 0, 0, 1, 3}, 100);
+  EXPECT_EQ(4, statistics.sampleCount());
+  EXPECT_EQ("B1: 0, B2: 0, B4: 0, B8: 1", statistics.bucketSummary());
+  EXPECT_EQ("P0: 4, P25: 8, P50: 8, P75: 8, P90: 8, P95: 8, P99: 8, P99.5: 8, P99.9: 8, P100: 8",
+            statistics.quantileSummary());
+}
+
+TEST(HistogramStatisticsImplTest, BucketCountsScaledPercent) {
+  const ConstSupportedBuckets buckets{0.5, 1};
+  HistogramStatisticsImpl statistics(Histogram::Unit::Percent, buckets);
+  statistics.refresh({1, 1, 0}, Histogram::PercentScale);
+  EXPECT_EQ(2, statistics.sampleCount());
+  EXPECT_DOUBLE_EQ(1.0, statistics.sampleSum());
+  EXPECT_EQ("B0.5: 1, B1: 2", statistics.bucketSummary());
+}
+
 } // namespace Stats
 } // namespace Envoy
@@ -3,6 +3,9 @@
 //
 // NOLINT(namespace-envoy)
 
+#include <string>
+#include <vector>
+
 #include "source/common/common/logger.h"
 #include "source/common/common/thread.h"
 #include "source/common/stats/isolated_store_impl.h"
@@ -12,6 +15,7 @@
 #include "test/common/stats/make_elements_helper.h"
 #include "test/test_common/utility.h"
 
+#include "absl/strings/str_cat.h"
 #include "absl/synchronization/blocking_counter.h"
 #include "benchmark/benchmark.h"
 
@@ -94,3 +98,86 @@ static void bmJoinElements(benchmark::State& state) {
   }
 }
 BENCHMARK(bmJoinElements);
+
+// Encodes and frees names on state.range(0) threads. If state.range(1) is 0, the names' symbols
+// already exist. Otherwise each thread encodes names of its own, like the scopes created for the
+// clusters of an xDS update.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void bmEncodeMultiThreaded(benchmark::State& state) {
+  const uint32_t num_threads = state.range(0);
+  const bool new_names = state.range(1) != 0;
+  constexpr uint32_t num_names = 1000;
+  Envoy::Thread::ThreadFactory& thread_factory = Envoy::Thread::threadFactoryForTest();
+  Envoy::Stats::SymbolTableImpl table;
+  Envoy::Stats::StatNamePool existing(table);
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < num_names; ++i) {
+    names.push_back(absl::StrCat("cluster.cluster_", i, ".upstream_rq_total"));
+    existing.add(names.back());
+  }
+
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    std::vector<Envoy::Thread::ThreadPtr> threads;
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      threads.push_back(thread_factory.createThread([&table, &names, new_names, t]() {
+        for (uint32_t i = 0; i < num_names; ++i) {
+          Envoy::Stats::StatNameStorage storage(
+              new_names ? absl::StrCat("cluster.thread_", t, "_cluster_", i, ".upstream_rq_total")
+                        : names[i],
+              table);
+          storage.free(table);
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads * num_names);
+}
+BENCHMARK(bmEncodeMultiThreaded)
+    ->Args({1, 0})
+    ->Args({4, 0})
+    ->Args({16, 0})
+    ->Args({1, 1})
+    ->Args({4, 1})
+    ->Args({16, 1})
+    ->UseRealTime()
+    ->Unit(::benchmark::kMillisecond);
+
+// Decodes existing names on state.range(0) threads, as admin handlers and sinks do.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void bmDecodeMultiThreaded(benchmark::State& state) {
+  const uint32_t num_threads = state.range(0);
+  constexpr uint32_t num_names = 1000;
+  Envoy::Thread::ThreadFactory& thread_factory = Envoy::Thread::threadFactoryForTest();
+  Envoy::Stats::SymbolTableImpl table;
+  Envoy::Stats::StatNamePool pool(table);
+  std::vector<Envoy::Stats::StatName> stat_names;
+  for (uint32_t i = 0; i < num_names; ++i) {
+    stat_names.push_back(pool.add(absl::StrCat("cluster.cluster_", i, ".upstream_rq_total")));
+  }
+
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    std::vector<Envoy::Thread::ThreadPtr> threads;
+    for (uint32_t t = 0; t < num_threads; ++t) {
+      threads.push_back(thread_factory.createThread([&table, &stat_names]() {
+        for (Envoy::Stats::StatName stat_name : stat_names) {
+          benchmark::DoNotOptimize(table.toString(stat_name));
+        }
+      }));
+    }
+    for (auto& thread : threads) {
+      thread->join();
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads * num_names);
+}
+BENCHMARK(bmDecodeMultiThreaded)
+    ->Arg(1)
+    ->Arg(4)
+    ->Arg(16)
+    ->UseRealTime()
+    ->Unit(::benchmark::kMillisecond);
@@ -66,5 +66,44 @@ TEST(TagProducerTest, CheckConstructor) {
       "No regex specified for tag specifier and no default regex for name: 'test_extractor'");
 }
 
+// Test that compiled tag extraction produces the same tags, in the same order, as evaluating each
+// regex.
+TEST(TagProducerTest, CompiledTagExtraction) {
+  envoy::config::metrics::v3::StatsConfig stats_config;
+  auto add_tag = [&stats_config](const std::string& name, const std::string& regex) {
+    auto& tag_specifier = *stats_config.mutable_stats_tags()->Add();
+    tag_specifier.set_tag_name(name);
+    tag_specifier.set_regex(regex);
+  };
+  add_tag("custom_a", R"(\.(a_(\w+?)\.))");
+  add_tag("custom_b", R"(\.(b_(\w+?)\.))");
+  // RE2 doesn't support lookahead, so this one is still evaluated with std::regex.
+  add_tag("custom_c", R"(\.(c_(\w+?)\.)(?=\w))");
+  // Starts with a prefix token, so it is only evaluated for stats starting with "x.".
+  add_tag("custom_d", R"(^x\.(d_(\w+?)\.))");
+  const TagProducerImpl producer(stats_config);
+  stats_config.set_compiled_tag_extraction(true);
+  const TagProducerImpl compiled_producer(stats_config);
+
+  auto expect_tags = [&](const std::string& stat_name, const std::string& expected_name,
+                         const TagVector& expected_tags) {
+    TagVector tags;
+    EXPECT_EQ(expected_name, producer.produceTags(stat_name, tags));
+    EXPECT_EQ(expected_tags, tags);
+    TagVector compiled_tags;
+    EXPECT_EQ(expected_name, compiled_producer.produceTags(stat_name, compiled_tags));
+    EXPECT_EQ(expected_tags, compiled_tags);
+  };
+
+  expect_tags("x.d_4.b_2.a_1.c_3.y", "x.y",
+              {{"custom_a", "1"}, {"custom_b", "2"}, {"custom_c", "3"}, {"custom_d", "4"}});
+  expect_tags("z.a_1.d_4.y", "z.d_4.y", {{"custom_a", "1"}});
+  expect_tags("x.y", "x.y", {});
+  expect_tags("cluster.foo.c_3.upstream_rq_200", "cluster.upstream_rq",
+              {{Config::TagNames::get().RESPONSE_CODE, "200"},
+               {"custom_c", "3"},
+               {Config::TagNames::get().CLUSTER_NAME, "foo"}});
+}
+
 } // namespace Stats
 } // namespace Envoy
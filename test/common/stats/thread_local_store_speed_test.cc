@@ -7,6 +7,7 @@
 #include "source/common/common/thread.h"
 #include "source/common/event/dispatcher_impl.h"
 #include "source/common/stats/allocator_impl.h"
+#include "source/common/stats/histogram_impl.h"
 #include "source/common/stats/stats_matcher_impl.h"
 #include "source/common/stats/symbol_table_impl.h"
 #include "source/common/stats/tag_producer_impl.h"
@@ -53,6 +54,32 @@ public:
     }
   }
 
+  void initHistograms(bool fixed_buckets) {
+    if (fixed_buckets) {
+      stats_config_.set_histogram_mode(envoy::config::metrics::v3::StatsConfig::FIXED_BUCKETS);
+    }
+    store_.setHistogramSettings(std::make_unique<Stats::HistogramSettingsImpl>(stats_config_));
+    for (auto& stat_name_storage : stat_names_) {
+      histograms_.push_back(&store_.histogramFromStatName(stat_name_storage->statName(),
+                                                          Stats::Histogram::Unit::Milliseconds));
+    }
+  }
+
+  // Records a value into every stride-th histogram.
+  void recordHistograms(uint64_t value, size_t stride) {
+    for (size_t i = 0; i < histograms_.size(); i += stride) {
+      histograms_[i]->recordValue(value);
+    }
+  }
+
+  void mergeHistograms() {
+    bool merged = false;
+    store_.mergeHistograms([&merged]() { merged = true; });
+    while (!merged) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    }
+  }
+
   void initThreading() {
     if (!Envoy::Event::Libevent::Global::initialized()) {
       Envoy::Event::Libevent::Global::initialize();
@@ -79,6 +106,7 @@ private:
   Api::ApiPtr api_;
   envoy::config::metrics::v3::StatsConfig stats_config_;
   std::vector<std::unique_ptr<Stats::StatNameManagedStorage>> stat_names_;
+  std::vector<Stats::Histogram*> histograms_;
 };
 
 } // namespace Envoy
@@ -133,5 +161,37 @@ static void BM_StatsWithTlsAndRejectionsWithoutDot(benchmark::State& state) {
 }
 BENCHMARK(BM_StatsWithTlsAndRejectionsWithoutDot);
 
+// Tests recording values into histograms, for log-linear histograms (mode 0) and histograms
+// with fixed buckets (mode 1).
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_HistogramRecord(benchmark::State& state) {
+  Envoy::ThreadLocalStorePerf context;
+  context.initThreading();
+  context.initHistograms(state.range(0) == 1);
+  uint64_t value = 0;
+
+  for (auto _ : state) { // NOLINT
+    context.recordHistograms(++value % 5000, 1);
+  }
+}
+BENCHMARK(BM_HistogramRecord)->Arg(0)->Arg(1);
+
+// Tests merging the histograms when only every stride-th histogram was recorded into since the
+// previous merge, for both histogram modes.
+// NOLINTNEXTLINE(readability-identifier-naming)
+static void BM_HistogramMerge(benchmark::State& state) {
+  Envoy::ThreadLocalStorePerf context;
+  context.initThreading();
+  context.initHistograms(state.range(0) == 1);
+  const size_t stride = state.range(1);
+  uint64_t value = 0;
+
+  for (auto _ : state) { // NOLINT
+    context.recordHistograms(++value % 5000, stride);
+    context.mergeHistograms();
+  }
+}
+BENCHMARK(BM_HistogramMerge)->Args({0, 1})->Args({0, 100})->Args({1, 1})->Args({1, 100});
+
 // TODO(jmarantz): add multi-threaded variant of this test, that aggressively
 // looks up stats in multiple threads to try to trigger contention issues.
@@ -1564,6 +1564,70 @@ TEST_F(HistogramTest, ParentHistogramBucketSummary) {
             "B3.6e+06(1,1)",
             parent_histogram->bucketSummary());
 }
+class FixedBucketsHistogramTest : public HistogramTest {
+public:
+  void SetUp() override {
+    HistogramTest::SetUp();
+    envoy::config::metrics::v3::StatsConfig config;
+    config.set_histogram_mode(envoy::config::metrics::v3::StatsConfig::FIXED_BUCKETS);
+    auto& setting = *config.add_histogram_bucket_settings();
+    setting.mutable_match()->set_prefix("h");
+    for (double bucket : {1, 2, 4, 8}) {
+      setting.add_buckets(bucket);
+    }
+    store_->setHistogramSettings(std::make_unique<HistogramSettingsImpl>(config));
+  }
+
+  void record(Histogram& histogram, uint64_t value) {
+    EXPECT_CALL(sink_, onHistogramComplete(Ref(histogram), value));
+    histogram.recordValue(value);
+  }
+};
+
+TEST_F(FixedBucketsHistogramTest, MultipleMerges) {
+  Histogram& h1 = store_->histogramFromString("h1", Stats::Histogram::Unit::Unspecified);
+  store_->mergeHistograms([]() -> void {});
+  ParentHistogramSharedPtr parent_histogram = store_->histograms()[0];
+  EXPECT_FALSE(parent_histogram->used());
+  EXPECT_EQ("No recorded values", parent_histogram->bucketSummary());
+
+  record(h1, 1);
+  record(h1, 2);
+  record(h1, 3);
+  record(h1, 8);
+  record(h1, 100);
+  store_->mergeHistograms([]() -> void {});
+  EXPECT_TRUE(parent_histogram->used());
+  EXPECT_EQ("B1(1,1) B2(2,2) B4(3,3) B8(4,4)", parent_histogram->bucketSummary());
+  EXPECT_EQ(5, parent_histogram->intervalStatistics().sampleCount());
+  EXPECT_EQ(114, parent_histogram->intervalStatistics().sampleSum());
+  EXPECT_EQ("P0(0.0,0.0) P25(1.25,1.25) P50(3.0,3.0) P75(7.0,7.0) P90(8.0,8.0) P95(8.0,8.0) "
+            "P99(8.0,8.0) P99.5(8.0,8.0) P99.9(8.0,8.0) P100(8.0,8.0)",
+            parent_histogram->quantileSummary());
+
+  // The interval statistics are cleared when nothing was recorded since the previous merge.
+  store_->mergeHistograms([]() -> void {});
+  EXPECT_EQ("B1(0,1) B2(0,2) B4(0,3) B8(0,4)", parent_histogram->bucketSummary());
+  EXPECT_EQ(0, parent_histogram->intervalStatistics().sampleCount());
+  EXPECT_EQ(5, parent_histogram->cumulativeStatistics().sampleCount());
+
+  record(h1, 5);
+  store_->mergeHistograms([]() -> void {});
+  EXPECT_EQ("B1(0,1) B2(0,2) B4(0,3) B8(1,5)", parent_histogram->bucketSummary());
+  EXPECT_EQ(5, parent_histogram->intervalStatistics().sampleSum());
+  EXPECT_EQ(119, parent_histogram->cumulativeStatistics().sampleSum());
+}
+
+TEST_F(FixedBucketsHistogramTest, ScaledPercent) {
+  Histogram& h1 = store_->histogramFromString("h1", Stats::Histogram::Unit::Percent);
+  record(h1, Histogram::PercentScale);
+  record(h1, 3 * Histogram::PercentScale);
+  store_->mergeHistograms([]() -> void {});
+  ParentHistogramSharedPtr parent_histogram = store_->histograms()[0];
+  EXPECT_EQ("B1(1,1) B2(1,1) B4(2,2) B8(2,2)", parent_histogram->bucketSummary());
+  EXPECT_DOUBLE_EQ(4.0, parent_histogram->cumulativeStatistics().sampleSum());
+}
+
 class ThreadLocalRealThreadsTestBase : public Thread::RealThreadsTestHelper,
                                        public ThreadLocalStoreNoMocksTestBase {
 protected:
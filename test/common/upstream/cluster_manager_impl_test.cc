@@ -587,7 +587,8 @@ TEST_P(ClusterManagerSubsetInitializationTest, SubsetLoadBalancerInitialization)
   const std::string yaml = fmt::format(yamlPattern, cluster_type, policy_name);
 
   if (GetParam() == envoy::config::cluster::v3::Cluster::CLUSTER_PROVIDED ||
-      GetParam() == envoy::config::cluster::v3::Cluster::LOAD_BALANCING_POLICY_CONFIG) {
+      GetParam() == envoy::config::cluster::v3::Cluster::LOAD_BALANCING_POLICY_CONFIG ||
+      GetParam() == envoy::config::cluster::v3::Cluster::PEAK_EWMA) {
     EXPECT_THROW_WITH_MESSAGE(
         create(parseBootstrapFromV3Yaml(yaml)), EnvoyException,
         fmt::format("cluster: LB policy {} cannot be combined with lb_subset_config",
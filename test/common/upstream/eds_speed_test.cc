@@ -1,6 +1,8 @@
 // Note: this should be run with --compilation_mode=opt, and would benefit from a
 // quiescent system with disabled cstate power management.
 
+#include <chrono>
+
 #include "envoy/config/cluster/v3/cluster.pb.h"
 #include "envoy/config/core/v3/health_check.pb.h"
 #include "envoy/config/endpoint/v3/endpoint.pb.h"
@@ -40,11 +42,15 @@ namespace Upstream {
 
 class EdsSpeedTest {
 public:
-  EdsSpeedTest(State& state, bool use_unified_mux)
+  EdsSpeedTest(State& state, bool use_unified_mux, bool incremental_host_updates = false)
       : state_(state), use_unified_mux_(use_unified_mux),
         type_url_("type.googleapis.com/envoy.config.endpoint.v3.ClusterLoadAssignment"),
         subscription_stats_(Config::Utility::generateStats(stats_)),
         api_(Api::createApiForTest(stats_)), async_client_(new Grpc::MockAsyncClient()) {
+    if (incremental_host_updates) {
+      Runtime::LoaderSingleton::getExisting()->mergeValues(
+          {{"envoy.reloadable_features.eds_incremental_host_updates", "true"}});
+    }
     if (use_unified_mux_) {
       grpc_mux_.reset(new Config::XdsMux::GrpcMuxSotw(
           std::unique_ptr<Grpc::MockAsyncClient>(async_client_), dispatcher_,
@@ -97,9 +103,10 @@ public:
   }
 
   // Set up an EDS config with multiple priorities, localities, weights and make sure
-  // they are loaded as expected.
+  // they are loaded as expected. The health status of the first flipped_hosts hosts is the
+  // opposite of the others.
   void priorityAndLocalityWeightedHelper(bool ignore_unknown_dynamic_fields, size_t num_hosts,
-                                         bool healthy) {
+                                         bool healthy, size_t flipped_hosts = 0) {
     state_.PauseTiming();
 
     envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
@@ -117,7 +124,7 @@ public:
     uint32_t port = 1000;
     for (size_t i = 0; i < num_hosts; ++i) {
       auto* lb_endpoint = endpoints->add_lb_endpoints();
-      if (healthy) {
+      if (healthy != (i < flipped_hosts)) {
         lb_endpoint->set_health_status(envoy::config::core::v3::HEALTHY);
       } else {
         lb_endpoint->set_health_status(envoy::config::core::v3::UNHEALTHY);
@@ -137,6 +144,7 @@ public:
     auto* resource = response->mutable_resources()->Add();
     resource->PackFrom(cluster_load_assignment);
     state_.ResumeTiming();
+    const auto start = std::chrono::steady_clock::now();
     if (use_unified_mux_) {
       dynamic_cast<Config::XdsMux::GrpcMuxSotw&>(*grpc_mux_)
           .grpcStreamForTest()
@@ -146,15 +154,19 @@ public:
           .grpcStreamForTest()
           .onReceiveMessage(std::move(response));
     }
+    last_update_duration_ = std::chrono::steady_clock::now() - start;
     ASSERT(cluster_->prioritySet().hostSetsPerPriority()[1]->hostsPerLocality().get()[0].size() ==
            num_hosts);
   }
 
+  // The TestScopedRuntime of the fixture, which the runtime guards are merged into. It is the first
+  // member so that it outlives everything that reads the runtime.
   TestDeprecatedV2Api _deprecated_v2_api_;
   State& state_;
   bool use_unified_mux_;
   const std::string type_url_;
   uint64_t version_{};
+  std::chrono::steady_clock::duration last_update_duration_{};
   bool initialized_{};
   Stats::TestUtil::TestStore stats_;
   Config::SubscriptionStats subscription_stats_;
@@ -231,3 +243,27 @@ static void healthOnlyUpdate(State& state) {
 }
 
 BENCHMARK(healthOnlyUpdate)->Ranges({{1, 100000}, {false, true}})->Unit(benchmark::kMillisecond);
+
+// Measures the cost of an update which only flips the health of a single endpoint, as a function
+// of the cluster size, with and without incremental host updates.
+static void singleEndpointHealthUpdate(State& state) {
+  Envoy::Thread::MutexBasicLockable lock;
+  Envoy::Logger::Context logging_state(spdlog::level::warn,
+                                       Envoy::Logger::Logger::DEFAULT_LOG_FORMAT, lock, false);
+  double update_us = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    Envoy::Upstream::EdsSpeedTest speed_test(state, false, state.range(1));
+    uint32_t endpoints = skipExpensiveBenchmarks() ? 1 : state.range(0);
+
+    speed_test.priorityAndLocalityWeightedHelper(true, endpoints, true);
+    speed_test.priorityAndLocalityWeightedHelper(true, endpoints, true, 1);
+    // Only the second update is counted, the first one populates the cluster.
+    update_us +=
+        std::chrono::duration<double, std::micro>(speed_test.last_update_duration_).count();
+  }
+  state.counters["update_us"] = benchmark::Counter(update_us, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(singleEndpointHealthUpdate)
+    ->Ranges({{1, 100000}, {false, true}})
+    ->Unit(benchmark::kMillisecond);
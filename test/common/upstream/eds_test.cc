@@ -34,9 +34,15 @@ namespace Envoy {
 namespace Upstream {
 namespace {
 
-class EdsTest : public testing::Test {
+// Tests run with and without incremental host updates.
+class EdsTest : public testing::TestWithParam<bool> {
 public:
-  EdsTest() : api_(Api::createApiForTest(stats_)) { resetCluster(); }
+  EdsTest() : api_(Api::createApiForTest(stats_)) {
+    Runtime::LoaderSingleton::getExisting()->mergeValues(
+        {{"envoy.reloadable_features.eds_incremental_host_updates",
+          GetParam() ? "true" : "false"}});
+    resetCluster();
+  }
 
   void resetCluster() {
     resetCluster(R"EOF(
@@ -145,6 +151,7 @@ public:
     VERBOSE_EXPECT_NO_THROW(eds_callbacks_->onConfigUpdate(decoded_resources.refvec_, ""));
   }
 
+  TestScopedRuntime scoped_runtime_;
   bool initialized_{};
   Stats::TestUtil::TestStore stats_;
   NiceMock<Ssl::MockContextManager> ssl_context_manager_;
@@ -164,6 +171,8 @@ public:
   Server::MockOptions options_;
 };
 
+INSTANTIATE_TEST_SUITE_P(IncrementalHostUpdates, EdsTest, testing::Bool());
+
 class EdsWithHealthCheckUpdateTest : public EdsTest {
 protected:
   EdsWithHealthCheckUpdateTest() = default;
@@ -251,8 +260,10 @@ protected:
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment_;
 };
 
+INSTANTIATE_TEST_SUITE_P(IncrementalHostUpdates, EdsWithHealthCheckUpdateTest, testing::Bool());
+
 // Validate that onConfigUpdate() with unexpected cluster names rejects config.
-TEST_F(EdsTest, OnConfigUpdateWrongName) {
+TEST_P(EdsTest, OnConfigUpdateWrongName) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("wrong name");
   const auto decoded_resources =
@@ -268,7 +279,7 @@ TEST_F(EdsTest, OnConfigUpdateWrongName) {
 }
 
 // Validate that onConfigUpdate() with empty cluster vector size ignores config.
-TEST_F(EdsTest, OnConfigUpdateEmpty) {
+TEST_P(EdsTest, OnConfigUpdateEmpty) {
   initialize();
   eds_callbacks_->onConfigUpdate({}, "");
   Protobuf::RepeatedPtrField<std::string> removed_resources;
@@ -278,7 +289,7 @@ TEST_F(EdsTest, OnConfigUpdateEmpty) {
 }
 
 // Validate that onConfigUpdate() with unexpected cluster vector size rejects config.
-TEST_F(EdsTest, OnConfigUpdateWrongSize) {
+TEST_P(EdsTest, OnConfigUpdateWrongSize) {
   initialize();
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
@@ -294,7 +305,7 @@ TEST_F(EdsTest, OnConfigUpdateWrongSize) {
 }
 
 // Validate that onConfigUpdate() with the expected cluster accepts config.
-TEST_F(EdsTest, OnConfigUpdateSuccess) {
+TEST_P(EdsTest, OnConfigUpdateSuccess) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   initialize();
@@ -304,7 +315,7 @@ TEST_F(EdsTest, OnConfigUpdateSuccess) {
 }
 
 // Validate that delta-style onConfigUpdate() with the expected cluster accepts config.
-TEST_F(EdsTest, DeltaOnConfigUpdateSuccess) {
+TEST_P(EdsTest, DeltaOnConfigUpdateSuccess) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   initialize();
@@ -323,7 +334,7 @@ TEST_F(EdsTest, DeltaOnConfigUpdateSuccess) {
 }
 
 // Validate that onConfigUpdate() with no service name accepts config.
-TEST_F(EdsTest, NoServiceNameOnSuccessConfigUpdate) {
+TEST_P(EdsTest, NoServiceNameOnSuccessConfigUpdate) {
   resetCluster(R"EOF(
       name: name
       connect_timeout: 0.25s
@@ -346,7 +357,7 @@ TEST_F(EdsTest, NoServiceNameOnSuccessConfigUpdate) {
 }
 
 // Validate that EDS cluster loaded from file as primary cluster
-TEST_F(EdsTest, EdsClusterFromFileIsPrimaryCluster) {
+TEST_P(EdsTest, EdsClusterFromFileIsPrimaryCluster) {
   resetClusterLoadedFromFile();
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("name");
@@ -356,7 +367,7 @@ TEST_F(EdsTest, EdsClusterFromFileIsPrimaryCluster) {
 }
 
 // Verify that host weight changes cause a full rebuild.
-TEST_F(EdsTest, EndpointWeightChangeCausesRebuild) {
+TEST_P(EdsTest, EndpointWeightChangeCausesRebuild) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -388,7 +399,7 @@ TEST_F(EdsTest, EndpointWeightChangeCausesRebuild) {
 }
 
 // Validate that onConfigUpdate() updates the endpoint metadata.
-TEST_F(EdsTest, EndpointMetadata) {
+TEST_P(EdsTest, EndpointMetadata) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -468,7 +479,7 @@ TEST_F(EdsTest, EndpointMetadata) {
 // data members dependent on metadata values.
 // Specifically, it transport socket matcher has changed,
 // the transport socket factory should also be updated.
-TEST_F(EdsTest, EndpointMetadataWithTransportSocket) {
+TEST_P(EdsTest, EndpointMetadataWithTransportSocket) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetClusterWithTransportSockets();
@@ -510,7 +521,7 @@ TEST_F(EdsTest, EndpointMetadataWithTransportSocket) {
 }
 
 // Validate that onConfigUpdate() updates endpoint health status.
-TEST_F(EdsTest, EndpointHealthStatus) {
+TEST_P(EdsTest, EndpointHealthStatus) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -635,8 +646,55 @@ TEST_F(EdsTest, EndpointHealthStatus) {
   EXPECT_EQ(rebuild_container + 1, stats_.counter("cluster.name.update_no_rebuild").value());
 }
 
+// Validate that a health only update keeps the hosts and, with incremental host updates, the
+// per-locality grouping of the priority.
+TEST_P(EdsTest, HealthOnlyUpdateKeepsHosts) {
+  envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
+  cluster_load_assignment.set_cluster_name("fare");
+  auto* endpoints = cluster_load_assignment.add_endpoints();
+  endpoints->mutable_locality()->set_zone("us-east-1a");
+  for (uint32_t port = 80; port < 83; ++port) {
+    auto* socket_address = endpoints->add_lb_endpoints()
+                               ->mutable_endpoint()
+                               ->mutable_address()
+                               ->mutable_socket_address();
+    socket_address->set_address("1.2.3.4");
+    socket_address->set_port_value(port);
+  }
+
+  initialize();
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  const HostSet& host_set = *cluster_->prioritySet().hostSetsPerPriority()[0];
+  const HostVector hosts = host_set.hosts();
+  const HostsPerLocalityConstSharedPtr hosts_per_locality = host_set.hostsPerLocalityPtr();
+  EXPECT_EQ(3, host_set.healthyHosts().size());
+
+  endpoints->mutable_lb_endpoints(1)->set_health_status(envoy::config::core::v3::UNHEALTHY);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_EQ(hosts, host_set.hosts());
+  EXPECT_EQ(GetParam(), hosts_per_locality == host_set.hostsPerLocalityPtr());
+  ASSERT_EQ(2, host_set.healthyHosts().size());
+  EXPECT_EQ(hosts[0], host_set.healthyHosts()[0]);
+  EXPECT_EQ(hosts[2], host_set.healthyHosts()[1]);
+  ASSERT_EQ(1, host_set.healthyHostsPerLocality().get().size());
+  EXPECT_EQ(2, host_set.healthyHostsPerLocality().get()[0].size());
+
+  // Adding a host regroups the hosts.
+  auto* socket_address = endpoints->add_lb_endpoints()
+                             ->mutable_endpoint()
+                             ->mutable_address()
+                             ->mutable_socket_address();
+  socket_address->set_address("1.2.3.4");
+  socket_address->set_port_value(83);
+  doOnConfigUpdateVerifyNoThrow(cluster_load_assignment);
+  EXPECT_NE(hosts_per_locality, host_set.hostsPerLocalityPtr());
+  ASSERT_EQ(4, host_set.hosts().size());
+  EXPECT_EQ(hosts[1], host_set.hosts()[1]);
+  EXPECT_EQ(3, host_set.healthyHosts().size());
+}
+
 // Validate that onConfigUpdate() updates the hostname.
-TEST_F(EdsTest, Hostname) {
+TEST_P(EdsTest, Hostname) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   auto* endpoint = cluster_load_assignment.add_endpoints()->add_lb_endpoints()->mutable_endpoint();
   auto* socket_address = endpoint->mutable_address()->mutable_socket_address();
@@ -651,7 +709,7 @@ TEST_F(EdsTest, Hostname) {
   EXPECT_EQ(hosts[0]->hostname(), "foo");
 }
 
-TEST_F(EdsTest, UseHostnameForHealthChecks) {
+TEST_P(EdsTest, UseHostnameForHealthChecks) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   auto* endpoint = cluster_load_assignment.add_endpoints()->add_lb_endpoints()->mutable_endpoint();
   auto* socket_address = endpoint->mutable_address()->mutable_socket_address();
@@ -668,7 +726,7 @@ TEST_F(EdsTest, UseHostnameForHealthChecks) {
 
 // Verify that a host is removed if it is removed from discovery, stabilized, and then later
 // fails active HC.
-TEST_F(EdsTest, EndpointRemovalAfterHcFail) {
+TEST_P(EdsTest, EndpointRemovalAfterHcFail) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
 
@@ -778,7 +836,7 @@ TEST_F(EdsTest, EndpointRemovalAfterHcFail) {
 
 // Verify that a host is removed when it is still passing active HC, but has been previously
 // told by the EDS server to fail health check.
-TEST_F(EdsTest, EndpointRemovalEdsFailButActiveHcSuccess) {
+TEST_P(EdsTest, EndpointRemovalEdsFailButActiveHcSuccess) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -841,7 +899,7 @@ TEST_F(EdsTest, EndpointRemovalEdsFailButActiveHcSuccess) {
 
 // Validate that onConfigUpdate() removes endpoints that are marked as healthy
 // when configured to drain on host removal.
-TEST_F(EdsTest, EndpointRemovalClusterDrainOnHostRemoval) {
+TEST_P(EdsTest, EndpointRemovalClusterDrainOnHostRemoval) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetClusterDrainOnHostRemoval();
@@ -894,7 +952,7 @@ TEST_F(EdsTest, EndpointRemovalClusterDrainOnHostRemoval) {
 }
 
 // Verifies that if an endpoint is moved to a new priority, the active hc status is preserved.
-TEST_F(EdsTest, EndpointMovedToNewPriorityWithDrain) {
+TEST_P(EdsTest, EndpointMovedToNewPriorityWithDrain) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetClusterDrainOnHostRemoval();
@@ -1000,7 +1058,7 @@ TEST_F(EdsTest, EndpointMovedToNewPriorityWithDrain) {
 
 // Verifies that if an endpoint is moved between priorities, the health check value
 // of the host is preserved
-TEST_F(EdsTest, EndpointMovedWithDrain) {
+TEST_P(EdsTest, EndpointMovedWithDrain) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetClusterDrainOnHostRemoval();
@@ -1090,7 +1148,7 @@ TEST_F(EdsTest, EndpointMovedWithDrain) {
 }
 
 // Verifies that if an endpoint is moved to a new priority, the active hc status is preserved.
-TEST_F(EdsTest, EndpointMovedToNewPriority) {
+TEST_P(EdsTest, EndpointMovedToNewPriority) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetCluster();
@@ -1196,7 +1254,7 @@ TEST_F(EdsTest, EndpointMovedToNewPriority) {
 
 // Verifies that if an endpoint is moved between priorities, the health check value
 // of the host is preserved
-TEST_F(EdsTest, EndpointMoved) {
+TEST_P(EdsTest, EndpointMoved) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetCluster();
@@ -1287,7 +1345,7 @@ TEST_F(EdsTest, EndpointMoved) {
 
 // Verifies that if an endpoint is moved to a new priority and has its health check address altered
 // then nothing bad happens
-TEST_F(EdsTest, EndpointMovedToNewPriorityWithHealthAddressChange) {
+TEST_P(EdsTest, EndpointMovedToNewPriorityWithHealthAddressChange) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetCluster();
@@ -1383,7 +1441,7 @@ TEST_F(EdsTest, EndpointMovedToNewPriorityWithHealthAddressChange) {
 }
 
 // Validates that we correctly update the host list when a new overprovisioning factor is set.
-TEST_F(EdsTest, EndpointAddedWithNewOverprovisioningFactor) {
+TEST_P(EdsTest, EndpointAddedWithNewOverprovisioningFactor) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   cluster_load_assignment.mutable_policy()->mutable_overprovisioning_factor()->set_value(1000);
@@ -1414,7 +1472,7 @@ TEST_F(EdsTest, EndpointAddedWithNewOverprovisioningFactor) {
 }
 
 // Validate that onConfigUpdate() updates the endpoint locality.
-TEST_F(EdsTest, EndpointLocality) {
+TEST_P(EdsTest, EndpointLocality) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -1458,7 +1516,7 @@ TEST_F(EdsTest, EndpointLocality) {
 
 // Validate that onConfigUpdate() does not propagate locality weights to the host set when
 // locality weighted balancing isn't configured and the cluster does not use LB policy extensions.
-TEST_F(EdsTest, EndpointLocalityWeightsIgnored) {
+TEST_P(EdsTest, EndpointLocalityWeightsIgnored) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
 
@@ -1552,9 +1610,11 @@ public:
   }
 };
 
+INSTANTIATE_TEST_SUITE_P(IncrementalHostUpdates, EdsLocalityWeightsTest, testing::Bool());
+
 // Validate that onConfigUpdate() propagates locality weights to the host set when locality
 // weighted balancing is configured.
-TEST_F(EdsLocalityWeightsTest, WeightsPresentWithLocalityWeightedConfig) {
+TEST_P(EdsLocalityWeightsTest, WeightsPresentWithLocalityWeightedConfig) {
   expectLocalityWeightsPresentForClusterConfig(R"EOF(
       name: name
       connect_timeout: 0.25s
@@ -1575,7 +1635,7 @@ TEST_F(EdsLocalityWeightsTest, WeightsPresentWithLocalityWeightedConfig) {
 
 // Validate that onConfigUpdate() propagates locality weights to the host set when the cluster uses
 // load balancing policy extensions.
-TEST_F(EdsLocalityWeightsTest, WeightsPresentWithLoadBalancingPolicyConfig) {
+TEST_P(EdsLocalityWeightsTest, WeightsPresentWithLoadBalancingPolicyConfig) {
   // envoy.load_balancers.custom_lb is registered by linking in
   // //test/integration/load_balancers:custom_lb_policy.
   expectLocalityWeightsPresentForClusterConfig(R"EOF(
@@ -1600,7 +1660,7 @@ TEST_F(EdsLocalityWeightsTest, WeightsPresentWithLoadBalancingPolicyConfig) {
 
 // Validate that onConfigUpdate() removes any locality not referenced in the
 // config update in each priority.
-TEST_F(EdsTest, RemoveUnreferencedLocalities) {
+TEST_P(EdsTest, RemoveUnreferencedLocalities) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   uint32_t port = 1000;
@@ -1684,7 +1744,7 @@ TEST_F(EdsTest, RemoveUnreferencedLocalities) {
 }
 
 // Validate that onConfigUpdate() updates bins hosts per locality as expected.
-TEST_F(EdsTest, EndpointHostsPerLocality) {
+TEST_P(EdsTest, EndpointHostsPerLocality) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   uint32_t port = 1000;
@@ -1750,7 +1810,7 @@ TEST_F(EdsTest, EndpointHostsPerLocality) {
 }
 
 // Validate that onConfigUpdate() updates all priorities in the prioritySet
-TEST_F(EdsTest, EndpointHostPerPriority) {
+TEST_P(EdsTest, EndpointHostPerPriority) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   uint32_t port = 1000;
@@ -1808,7 +1868,7 @@ TEST_F(EdsTest, EndpointHostPerPriority) {
 }
 
 // Validate that onConfigUpdate() updates bins hosts per priority as expected.
-TEST_F(EdsTest, EndpointHostsPerPriority) {
+TEST_P(EdsTest, EndpointHostsPerPriority) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   uint32_t port = 1000;
@@ -1864,7 +1924,7 @@ TEST_F(EdsTest, EndpointHostsPerPriority) {
 }
 
 // Make sure config updates with P!=0 are rejected for the local cluster.
-TEST_F(EdsTest, NoPriorityForLocalCluster) {
+TEST_P(EdsTest, NoPriorityForLocalCluster) {
   cm_.local_cluster_name_ = "name";
   resetCluster();
 
@@ -1904,7 +1964,7 @@ TEST_F(EdsTest, NoPriorityForLocalCluster) {
 
 // Set up an EDS config with multiple priorities and localities and make sure
 // they are loaded and reloaded as expected.
-TEST_F(EdsTest, PriorityAndLocality) {
+TEST_P(EdsTest, PriorityAndLocality) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   uint32_t port = 1000;
@@ -1995,7 +2055,7 @@ TEST_F(EdsTest, PriorityAndLocality) {
 
 // Set up an EDS config with multiple priorities, localities, weights and make sure
 // they are loaded and reloaded as expected.
-TEST_F(EdsTest, PriorityAndLocalityWeighted) {
+TEST_P(EdsTest, PriorityAndLocalityWeighted) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   resetCluster(R"EOF(
@@ -2090,7 +2150,7 @@ TEST_F(EdsTest, PriorityAndLocalityWeighted) {
   EXPECT_EQ(1UL, stats_.counter("cluster.name.update_no_rebuild").value());
 }
 
-TEST_F(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfig) {
+TEST_P(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfig) {
   const std::vector<uint32_t> endpoint_ports = {80, 81};
   const uint32_t new_health_check_port = 8000;
 
@@ -2138,7 +2198,7 @@ TEST_F(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfig) {
   }
 }
 
-TEST_F(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfigWithDrainConnectionsOnRemoval) {
+TEST_P(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfigWithDrainConnectionsOnRemoval) {
   const std::vector<uint32_t> endpoint_ports = {80, 81};
   const uint32_t new_health_check_port = 8000;
 
@@ -2169,7 +2229,7 @@ TEST_F(EdsWithHealthCheckUpdateTest, EndpointUpdateHealthCheckConfigWithDrainCon
 }
 
 // Throw on adding a new resource with an invalid endpoint (since the given address is invalid).
-TEST_F(EdsTest, MalformedIP) {
+TEST_P(EdsTest, MalformedIP) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -2207,8 +2267,10 @@ public:
   Event::TimerCb timer_cb_;
 };
 
+INSTANTIATE_TEST_SUITE_P(IncrementalHostUpdates, EdsAssignmentTimeoutTest, testing::Bool());
+
 // Test that assignment timeout is enabled and disabled correctly.
-TEST_F(EdsAssignmentTimeoutTest, AssignmentTimeoutEnableDisable) {
+TEST_P(EdsAssignmentTimeoutTest, AssignmentTimeoutEnableDisable) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   auto* endpoints = cluster_load_assignment.add_endpoints();
@@ -2245,7 +2307,7 @@ TEST_F(EdsAssignmentTimeoutTest, AssignmentTimeoutEnableDisable) {
 }
 
 // Test that assignment timeout is called and removes all the endpoints.
-TEST_F(EdsAssignmentTimeoutTest, AssignmentLeaseExpired) {
+TEST_P(EdsAssignmentTimeoutTest, AssignmentLeaseExpired) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   cluster_load_assignment.mutable_policy()->mutable_endpoint_stale_after()->MergeFrom(
@@ -2292,7 +2354,7 @@ TEST_F(EdsAssignmentTimeoutTest, AssignmentLeaseExpired) {
 
 // Validate that onConfigUpdate() with a config that contains both LEDS config
 // source and explicit list of endpoints is rejected.
-TEST_F(EdsTest, OnConfigUpdateLedsAndEndpoints) {
+TEST_P(EdsTest, OnConfigUpdateLedsAndEndpoints) {
   envoy::config::endpoint::v3::ClusterLoadAssignment cluster_load_assignment;
   cluster_load_assignment.set_cluster_name("fare");
   // Add an endpoint.
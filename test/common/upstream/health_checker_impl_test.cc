@@ -3582,7 +3582,37 @@ public:
     EXPECT_CALL(*connection_, addReadFilter(_)).WillOnce(SaveArg<0>(&read_filter_));
   }
 
+  // Sets up health_checker_ on cluster_ and another health checker on a second cluster, both with
+  // the same config sharing their sessions, and a host with the same address in each cluster.
+  void setupSharedSessions() {
+    const std::string yaml = R"EOF(
+    timeout: 1s
+    interval: 1s
+    unhealthy_threshold: 1
+    healthy_threshold: 1
+    share_sessions: true
+    tcp_health_check: {}
+    )EOF";
+
+    allocHealthChecker(yaml);
+    other_health_checker_ = std::make_shared<TcpHealthCheckerImpl>(
+        *other_cluster_, parseHealthCheckFromV3Yaml(yaml), dispatcher_, runtime_, random_,
+        nullptr);
+    health_checker_->setSharedSessions(shared_sessions_, parseHealthCheckFromV3Yaml(yaml));
+    other_health_checker_->setSharedSessions(shared_sessions_, parseHealthCheckFromV3Yaml(yaml));
+
+    cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+        makeTestHost(cluster_->info_, "tcp://127.0.0.1:80", simTime())};
+    other_cluster_->prioritySet().getMockHostSet(0)->hosts_ = {
+        makeTestHost(other_cluster_->info_, "tcp://127.0.0.1:80", simTime())};
+  }
+
   std::shared_ptr<TcpHealthCheckerImpl> health_checker_;
+  std::shared_ptr<MockClusterMockPrioritySet> other_cluster_{
+      std::make_shared<NiceMock<MockClusterMockPrioritySet>>()};
+  std::shared_ptr<TcpHealthCheckerImpl> other_health_checker_;
+  SharedHealthCheckSessionsSharedPtr shared_sessions_{
+      std::make_shared<SharedHealthCheckSessions>()};
   Network::MockClientConnection* connection_{};
   Event::MockTimer* timeout_timer_{};
   Event::MockTimer* interval_timer_{};
@@ -4062,6 +4092,102 @@ TEST_F(TcpHealthCheckerImplTest, ConnectionLocalFailure) {
   EXPECT_EQ(0UL, cluster_->info_->stats_store_.counter("health_check.passive_failure").value());
 }
 
+// Verify that health checkers with an identical config sharing their sessions probe an address
+// once and apply the result to the host in every cluster.
+TEST_F(TcpHealthCheckerImplTest, SharedSessionsFanOut) {
+  setupSharedSessions();
+  HostSharedPtr host = cluster_->prioritySet().getMockHostSet(0)->hosts_[0];
+  HostSharedPtr other_host = other_cluster_->prioritySet().getMockHostSet(0)->hosts_[0];
+  host->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
+  other_host->healthFlagSet(Host::HealthFlag::FAILED_ACTIVE_HC);
+
+  expectSessionCreate();
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer_, enableTimer(_, _));
+  health_checker_->start();
+
+  // The second session joins as a follower and neither connects nor arms its timers.
+  Event::MockTimer* other_interval_timer = new Event::MockTimer(&dispatcher_);
+  Event::MockTimer* other_timeout_timer = new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*other_interval_timer, enableTimer(_, _)).Times(0);
+  EXPECT_CALL(*other_timeout_timer, enableTimer(_, _)).Times(0);
+  other_health_checker_->start();
+
+  // Both hosts are marked healthy by a single successful check.
+  EXPECT_CALL(event_logger_, logAddHealthy(_, _, true));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_, _));
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  connection_->raiseEvent(Network::ConnectionEvent::LocalClose);
+  EXPECT_EQ(Host::Health::Healthy, host->health());
+  EXPECT_EQ(Host::Health::Healthy, other_host->health());
+
+  // Both hosts are marked unhealthy by a single failed check.
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer_, enableTimer(_, _));
+  interval_timer_->invokeCallback();
+  EXPECT_CALL(event_logger_, logEjectUnhealthy(_, _, envoy::data::core::v3::NETWORK));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_, _));
+  connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+  EXPECT_EQ(Host::Health::Unhealthy, host->health());
+  EXPECT_EQ(Host::Health::Unhealthy, other_host->health());
+
+  // Only the probing health checker counts attempts, results are counted by both.
+  EXPECT_EQ(2UL, cluster_->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(0UL, other_cluster_->info_->stats_store_.counter("health_check.attempt").value());
+  for (auto* store : {&cluster_->info_->stats_store_, &other_cluster_->info_->stats_store_}) {
+    EXPECT_EQ(1UL, store->counter("health_check.success").value());
+    EXPECT_EQ(1UL, store->counter("health_check.failure").value());
+    EXPECT_EQ(1UL, store->counter("health_check.network_failure").value());
+  }
+
+  // Removing the probing host hands the probing over to the follower.
+  EXPECT_CALL(*other_interval_timer, disableTimer());
+  expectClientCreate();
+  EXPECT_CALL(*other_timeout_timer, enableTimer(_, _));
+  HostVector old_hosts = std::move(cluster_->prioritySet().getMockHostSet(0)->hosts_);
+  cluster_->prioritySet().getMockHostSet(0)->runCallbacks({}, old_hosts);
+  EXPECT_EQ(1UL, other_cluster_->info_->stats_store_.counter("health_check.attempt").value());
+
+  EXPECT_CALL(*other_timeout_timer, disableTimer());
+  EXPECT_CALL(*other_interval_timer, enableTimer(_, _));
+  connection_->raiseEvent(Network::ConnectionEvent::Connected);
+  EXPECT_EQ(Host::Health::Healthy, other_host->health());
+}
+
+// Verify that a session joining a group after the leader completed a check picks up the result on
+// the next loop iteration rather than waiting for the next check.
+TEST_F(TcpHealthCheckerImplTest, SharedSessionsLateJoiner) {
+  setupSharedSessions();
+  HostSharedPtr other_host = other_cluster_->prioritySet().getMockHostSet(0)->hosts_[0];
+
+  expectSessionCreate();
+  expectClientCreate();
+  EXPECT_CALL(*timeout_timer_, enableTimer(_, _));
+  health_checker_->start();
+  EXPECT_CALL(event_logger_, logEjectUnhealthy(_, _, envoy::data::core::v3::NETWORK));
+  EXPECT_CALL(event_logger_, logUnhealthy(_, _, envoy::data::core::v3::NETWORK, true));
+  EXPECT_CALL(*timeout_timer_, disableTimer());
+  EXPECT_CALL(*interval_timer_, enableTimer(_, _));
+  connection_->raiseEvent(Network::ConnectionEvent::RemoteClose);
+
+  other_host->healthFlagSet(Host::HealthFlag::PENDING_ACTIVE_HC);
+  Event::MockTimer* other_interval_timer = new Event::MockTimer(&dispatcher_);
+  new Event::MockTimer(&dispatcher_);
+  EXPECT_CALL(*other_interval_timer, enableTimer(std::chrono::milliseconds(0), _));
+  other_health_checker_->start();
+  EXPECT_TRUE(other_host->healthFlagGet(Host::HealthFlag::PENDING_ACTIVE_HC));
+
+  // The replay applies the failure without probing.
+  EXPECT_CALL(dispatcher_, createClientConnection_(_, _, _, _)).Times(0);
+  other_interval_timer->invokeCallback();
+  EXPECT_FALSE(other_host->healthFlagGet(Host::HealthFlag::PENDING_ACTIVE_HC));
+  EXPECT_EQ(Host::Health::Unhealthy, other_host->health());
+  EXPECT_EQ(0UL, other_cluster_->info_->stats_store_.counter("health_check.attempt").value());
+  EXPECT_EQ(1UL, other_cluster_->info_->stats_store_.counter("health_check.failure").value());
+}
+
 class TestGrpcHealthCheckerImpl : public GrpcHealthCheckerImpl {
 public:
   using GrpcHealthCheckerImpl::GrpcHealthCheckerImpl;
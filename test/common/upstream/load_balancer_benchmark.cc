@@ -1,10 +1,12 @@
 // Usage: bazel run //test/common/upstream:load_balancer_benchmark
 
 #include <memory>
+#include <vector>
 
 #include "envoy/config/cluster/v3/cluster.pb.h"
 
 #include "source/common/common/random_generator.h"
+#include "source/common/common/utility.h"
 #include "source/common/memory/stats.h"
 #include "source/common/upstream/maglev_lb.h"
 #include "source/common/upstream/ring_hash_lb.h"
@@ -15,7 +17,11 @@
 #include "test/common/upstream/utility.h"
 #include "test/mocks/upstream/cluster_info.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/test_runtime.h"
+#include "test/test_common/thread_factory_for_test.h"
 
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
 #include "benchmark/benchmark.h"
 
 namespace Envoy {
@@ -27,7 +33,10 @@ public:
   static constexpr absl::string_view metadata_key = "key";
   // We weight the first weighted_subset_percent of hosts with weight.
   BaseTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
-             bool attach_metadata = false) {
+             bool attach_metadata = false,
+             LoadBalancerType lb_type = LoadBalancerType::RoundRobin) {
+    // Hosts only maintain a latency estimate when the cluster's LB type uses it.
+    info_->lb_type_ = lb_type;
     HostVector hosts;
     ASSERT(num_hosts < 65536);
     for (uint64_t i = 0; i < num_hosts; i++) {
@@ -102,6 +111,51 @@ public:
   std::unique_ptr<LeastRequestLoadBalancer> lb_;
 };
 
+// Hosts shared by several workers, each with its own least request load balancer. The hosts use the
+// real time source, as reading the simulated time takes a lock shared by all threads.
+class MultiWorkerLeastRequestTester : public BaseTester {
+public:
+  MultiWorkerLeastRequestTester(uint64_t num_hosts, uint32_t num_workers,
+                                bool per_worker_active_requests)
+      : BaseTester(0) {
+    info_->lb_type_ = LoadBalancerType::LeastRequest;
+    info_->lb_least_request_config_ = envoy::config::cluster::v3::Cluster::LeastRequestLbConfig();
+    info_->lb_least_request_config_->set_per_worker_active_requests(per_worker_active_requests);
+    HostVector hosts;
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      hosts.push_back(makeTestHost(info_, fmt::format("tcp://10.0.{}.{}:6379", i / 256, i % 256),
+                                   time_source_));
+    }
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    priority_set_.updateHosts(
+        0, HostSetImpl::partitionHosts(updated_hosts, makeHostsPerLocality({hosts})), {}, hosts,
+        {}, absl::nullopt);
+
+    for (uint32_t i = 0; i < num_workers; i++) {
+      lbs_.push_back(std::make_unique<LeastRequestLoadBalancer>(
+          priority_set_, nullptr, stats_, runtime_, random_, common_config_,
+          info_->lb_least_request_config_.value(), time_source_));
+    }
+  }
+
+  RealTimeSource time_source_;
+  std::vector<std::unique_ptr<LeastRequestLoadBalancer>> lbs_;
+};
+
+class PeakEwmaTester : public BaseTester {
+public:
+  PeakEwmaTester(uint64_t num_hosts, uint32_t choice_count)
+      : BaseTester(num_hosts, 0, 0, false, LoadBalancerType::PeakEwma) {
+    envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig peak_ewma_lb_config;
+    peak_ewma_lb_config.mutable_choice_count()->set_value(choice_count);
+    lb_ = std::make_unique<PeakEwmaLoadBalancer>(priority_set_, &local_priority_set_, stats_,
+                                                 runtime_, random_, common_config_,
+                                                 peak_ewma_lb_config);
+  }
+
+  std::unique_ptr<PeakEwmaLoadBalancer> lb_;
+};
+
 void benchmarkRoundRobinLoadBalancerBuild(::benchmark::State& state) {
   const uint64_t num_hosts = state.range(0);
   const uint64_t weighted_subset_percent = state.range(1);
@@ -164,8 +218,13 @@ public:
 
 class MaglevTester : public BaseTester {
 public:
-  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0)
+  MaglevTester(uint64_t num_hosts, uint32_t weighted_subset_percent = 0, uint32_t weight = 0,
+               bool incremental_table_updates = false)
       : BaseTester(num_hosts, weighted_subset_percent, weight) {
+    if (incremental_table_updates) {
+      config_ = envoy::config::cluster::v3::Cluster::MaglevLbConfig();
+      config_.value().set_incremental_table_updates(true);
+    }
     maglev_lb_ = std::make_unique<MaglevLoadBalancer>(priority_set_, stats_, stats_store_, runtime_,
                                                       random_, config_, common_config_);
   }
@@ -231,6 +290,51 @@ BENCHMARK(benchmarkMaglevLoadBalancerBuildTable)
     ->Arg(500)
     ->Unit(::benchmark::kMillisecond);
 
+// Measures the cost of a host set update on the thread delivering it, for updates alternately
+// removing and adding back hosts_to_churn hosts. With build_in_background, this only covers
+// capturing the host weights, as the table is built on the build thread.
+void benchmarkMaglevLoadBalancerRebuildOnChurn(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t hosts_to_churn = state.range(1);
+  const bool incremental_table_updates = state.range(2);
+  const bool build_in_background = state.range(3);
+  MaglevTester tester(num_hosts, 0, 0, incremental_table_updates);
+  if (build_in_background) {
+    tester.maglev_lb_->buildInBackground(Thread::threadFactoryForTest());
+  }
+  tester.maglev_lb_->initialize();
+
+  const HostVector all_hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+  const HostVector churned_hosts(all_hosts.end() - hosts_to_churn, all_hosts.end());
+  const HostVector remaining_hosts(all_hosts.begin(), all_hosts.end() - hosts_to_churn);
+  bool removed = false;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    const HostVector& hosts = removed ? all_hosts : remaining_hosts;
+    HostVectorConstSharedPtr updated_hosts = std::make_shared<HostVector>(hosts);
+    HostsPerLocalityConstSharedPtr hosts_per_locality = makeHostsPerLocality({hosts});
+    PrioritySet::UpdateHostsParams params =
+        HostSetImpl::partitionHosts(updated_hosts, hosts_per_locality);
+    const HostVector& hosts_added = removed ? churned_hosts : HostVector{};
+    const HostVector& hosts_removed = removed ? HostVector{} : churned_hosts;
+    state.ResumeTiming();
+
+    tester.priority_set_.updateHosts(0, std::move(params), {}, hosts_added, hosts_removed,
+                                     absl::nullopt);
+    removed = !removed;
+  }
+}
+BENCHMARK(benchmarkMaglevLoadBalancerRebuildOnChurn)
+    ->Args({500, 1, 0, 0})
+    ->Args({500, 1, 1, 0})
+    ->Args({5000, 1, 0, 0})
+    ->Args({5000, 1, 1, 0})
+    ->Args({5000, 50, 0, 0})
+    ->Args({5000, 50, 1, 0})
+    ->Args({5000, 1, 0, 1})
+    ->Args({5000, 1, 1, 1})
+    ->Unit(::benchmark::kMillisecond);
+
 class TestLoadBalancerContext : public LoadBalancerContextBase {
 public:
   // Upstream::LoadBalancerContext
@@ -301,6 +405,95 @@ BENCHMARK(benchmarkLeastRequestLoadBalancerChooseHost)
     ->Args({100, 100, 1000000})
     ->Unit(::benchmark::kMillisecond);
 
+// Measures the throughput of least request picks when several workers send requests to the same few
+// hosts, with the active request counts shared by all workers or kept per worker. Each worker keeps
+// a fixed number of requests outstanding, and completes the oldest one for every new pick.
+void benchmarkLeastRequestLoadBalancerMultiWorker(::benchmark::State& state) {
+  static constexpr uint64_t NumHosts = 10;
+  static constexpr uint64_t OutstandingRequests = 100;
+  static std::unique_ptr<MultiWorkerLeastRequestTester> tester;
+  const bool per_worker_active_requests = state.range(0);
+
+  if (benchmark::skipExpensiveBenchmarks() && state.threads > 4) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  // The threads of the benchmark wait for each other before running the loop, so the first thread
+  // sets up the tester for all of them.
+  if (state.thread_index == 0) {
+    tester = std::make_unique<MultiWorkerLeastRequestTester>(NumHosts, state.threads,
+                                                             per_worker_active_requests);
+  }
+
+  std::vector<const Host*> outstanding(OutstandingRequests, nullptr);
+  uint64_t next = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    const Host*& slot = outstanding[next++ % OutstandingRequests];
+    if (slot != nullptr) {
+      slot->activeRequests().dec();
+    }
+    HostConstSharedPtr host = tester->lbs_[state.thread_index]->chooseHost(nullptr);
+    host->activeRequests().inc();
+    slot = host.get();
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (state.thread_index == 0) {
+    tester.reset();
+  }
+}
+BENCHMARK(benchmarkLeastRequestLoadBalancerMultiWorker)
+    ->Arg(false)
+    ->Arg(true)
+    ->ThreadRange(1, 16)
+    ->UseRealTime();
+
+void benchmarkPeakEwmaLoadBalancerChooseHost(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t choice_count = state.range(1);
+  const uint64_t keys_to_simulate = state.range(2);
+
+  if (benchmark::skipExpensiveBenchmarks() && keys_to_simulate > 1000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    PeakEwmaTester tester(num_hosts, choice_count);
+    absl::node_hash_map<std::string, uint64_t> hit_counter;
+    // Hosts later in the list respond slower.
+    absl::flat_hash_map<const Host*, std::chrono::microseconds> response_times;
+    const HostVector& hosts = tester.priority_set_.hostSetsPerPriority()[0]->hosts();
+    for (uint64_t i = 0; i < hosts.size(); ++i) {
+      response_times[hosts[i].get()] = std::chrono::microseconds(100 * (i + 1));
+    }
+    TestLoadBalancerContext context;
+    state.ResumeTiming();
+
+    // Recording the response time is timed as well since the router does it once per request.
+    for (uint64_t i = 0; i < keys_to_simulate; ++i) {
+      HostConstSharedPtr host = tester.lb_->chooseHost(&context);
+      host->latencyEstimator().putRoundTripTime(response_times[host.get()]);
+      hit_counter[host->address()->asString()] += 1;
+    }
+
+    // Do not time computation of mean, standard deviation, and relative standard deviation.
+    state.PauseTiming();
+    computeHitStats(state, hit_counter);
+    state.ResumeTiming();
+  }
+}
+BENCHMARK(benchmarkPeakEwmaLoadBalancerChooseHost)
+    ->Args({100, 2, 1000})
+    ->Args({100, 3, 1000})
+    ->Args({100, 10, 1000})
+    ->Args({100, 2, 1000000})
+    ->Args({100, 3, 1000000})
+    ->Args({100, 10, 1000000})
+    ->Unit(::benchmark::kMillisecond);
+
 void benchmarkRingHashLoadBalancerChooseHost(::benchmark::State& state) {
   for (auto _ : state) { // NOLINT: Silences warning about dead store
     // Do not time the creation of the ring.
@@ -611,6 +804,87 @@ BENCHMARK(benchmarkSubsetLoadBalancerUpdate)
     ->Ranges({{false, true}, {50, 2500}})
     ->Unit(::benchmark::kMillisecond);
 
+// Subset load balancer with num_selectors single key selectors. Host i has the value i % (j + 2)
+// for the key of selector j, so that each selector has a few large subsets.
+class MultiSelectorSubsetLbTester : public BaseTester {
+public:
+  MultiSelectorSubsetLbTester(uint64_t num_hosts, uint64_t num_selectors) : BaseTester(num_hosts) {
+    const HostVector& hosts = priority_set_.getOrCreateHostSet(0).hosts();
+    for (uint64_t i = 0; i < hosts.size(); i++) {
+      envoy::config::core::v3::Metadata metadata;
+      ProtobufWkt::Struct& map =
+          (*metadata.mutable_filter_metadata())[Config::MetadataFilters::get().ENVOY_LB];
+      for (uint64_t j = 0; j < num_selectors; j++) {
+        (*map.mutable_fields())[absl::StrCat("key", j)].set_string_value(
+            absl::StrCat("value", i % (j + 2)));
+      }
+      hosts[i]->metadata(std::make_shared<const envoy::config::core::v3::Metadata>(metadata));
+    }
+
+    envoy::config::cluster::v3::Cluster::LbSubsetConfig subset_config;
+    subset_config.set_fallback_policy(
+        envoy::config::cluster::v3::Cluster::LbSubsetConfig::ANY_ENDPOINT);
+    for (uint64_t j = 0; j < num_selectors; j++) {
+      *subset_config.mutable_subset_selectors()->Add()->mutable_keys()->Add() =
+          absl::StrCat("key", j);
+    }
+
+    subset_info_ = std::make_unique<LoadBalancerSubsetInfoImpl>(subset_config);
+    lb_ = std::make_unique<SubsetLoadBalancer>(
+        LoadBalancerType::Random, priority_set_, &local_priority_set_, stats_, stats_store_,
+        runtime_, random_, *subset_info_, absl::nullopt, absl::nullopt, absl::nullopt,
+        absl::nullopt, common_config_, simTime());
+
+    orig_hosts_ = std::make_shared<HostVector>(hosts);
+    smaller_hosts_ = std::make_shared<HostVector>(hosts.begin() + 1, hosts.end());
+    host_moved_ = {hosts[0]};
+    orig_locality_hosts_ = makeHostsPerLocality({*orig_hosts_});
+    smaller_locality_hosts_ = makeHostsPerLocality({*smaller_hosts_});
+  }
+
+  // Remove a host and add it back.
+  void update() {
+    priority_set_.updateHosts(0,
+                              HostSetImpl::partitionHosts(smaller_hosts_, smaller_locality_hosts_),
+                              nullptr, {}, host_moved_, absl::nullopt);
+    priority_set_.updateHosts(0, HostSetImpl::partitionHosts(orig_hosts_, orig_locality_hosts_),
+                              nullptr, host_moved_, {}, absl::nullopt);
+  }
+
+  std::unique_ptr<LoadBalancerSubsetInfoImpl> subset_info_;
+  std::unique_ptr<SubsetLoadBalancer> lb_;
+  HostVectorConstSharedPtr orig_hosts_;
+  HostVectorConstSharedPtr smaller_hosts_;
+  HostsPerLocalitySharedPtr orig_locality_hosts_;
+  HostsPerLocalitySharedPtr smaller_locality_hosts_;
+  HostVector host_moved_;
+};
+
+void benchmarkSubsetLoadBalancerUpdateMultipleSelectors(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const uint64_t num_selectors = state.range(1);
+  const bool compiled_index = state.range(2);
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  TestScopedRuntime scoped_runtime;
+  Runtime::LoaderSingleton::getExisting()->mergeValues(
+      {{"envoy.reloadable_features.subset_lb_compiled_index", compiled_index ? "true" : "false"}});
+  MultiSelectorSubsetLbTester tester(num_hosts, num_selectors);
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    tester.update();
+  }
+}
+
+BENCHMARK(benchmarkSubsetLoadBalancerUpdateMultipleSelectors)
+    ->Args({100, 10, 0})
+    ->Args({100, 10, 1})
+    ->Args({3000, 10, 0})
+    ->Args({3000, 10, 1})
+    ->Unit(::benchmark::kMillisecond);
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
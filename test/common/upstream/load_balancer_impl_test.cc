@@ -21,6 +21,7 @@
 #include "test/test_common/logging.h"
 #include "test/test_common/simulated_time_system.h"
 #include "test/test_common/test_runtime.h"
+#include "test/test_common/thread_factory_for_test.h"
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -1938,6 +1939,33 @@ TEST_P(LeastRequestLoadBalancerTest, Normal) {
   EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
 }
 
+// With per worker active request counts, picks account for the requests started by the picking
+// worker right away and for the requests started by other workers once merged.
+TEST_P(LeastRequestLoadBalancerTest, PerWorkerActiveRequests) {
+  info_->lb_type_ = LoadBalancerType::LeastRequest;
+  info_->lb_least_request_config_ = envoy::config::cluster::v3::Cluster::LeastRequestLbConfig();
+  info_->lb_least_request_config_->set_per_worker_active_requests(true);
+  hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
+                              makeTestHost(info_, "tcp://127.0.0.1:81", simTime())};
+  stats_.max_host_weight_.set(1UL);
+  hostSet().hosts_ = hostSet().healthy_hosts_;
+  hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+
+  hostSet().healthy_hosts_[0]->activeRequests().inc();
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(2)).WillOnce(Return(3));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_.chooseHost(nullptr));
+
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread([this]() {
+    hostSet().healthy_hosts_[1]->activeRequests().inc();
+    hostSet().healthy_hosts_[1]->activeRequests().inc();
+  });
+  thread->join();
+  simTime().advanceTimeWait(std::chrono::milliseconds(10));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(2)).WillOnce(Return(3));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_.chooseHost(nullptr));
+  EXPECT_EQ(2, hostSet().healthy_hosts_[1]->stats().rq_active_.value());
+}
+
 TEST_P(LeastRequestLoadBalancerTest, PNC) {
   hostSet().healthy_hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:80", simTime()),
                               makeTestHost(info_, "tcp://127.0.0.1:81", simTime()),
@@ -2376,6 +2404,114 @@ TEST_P(RandomLoadBalancerTest, FailClusterOnPanic) {
 
 INSTANTIATE_TEST_SUITE_P(PrimaryOrFailover, RandomLoadBalancerTest, ::testing::Values(true, false));
 
+class PeakEwmaLoadBalancerTest : public LoadBalancerTestBase {
+public:
+  PeakEwmaLoadBalancerTest() { info_->lb_type_ = LoadBalancerType::PeakEwma; }
+
+  void init() {
+    lb_ = std::make_shared<PeakEwmaLoadBalancer>(priority_set_, nullptr, stats_, runtime_, random_,
+                                                 common_config_, peak_ewma_lb_config_);
+  }
+
+  void initHosts(uint32_t num_hosts) {
+    for (uint32_t i = 0; i < num_hosts; ++i) {
+      hostSet().healthy_hosts_.push_back(
+          makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 80 + i), simTime()));
+    }
+    hostSet().hosts_ = hostSet().healthy_hosts_;
+    hostSet().runCallbacks({}, {}); // Trigger callbacks. The added/removed lists are not relevant.
+  }
+
+  absl::optional<envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig> peak_ewma_lb_config_;
+  std::shared_ptr<LoadBalancer> lb_;
+};
+
+TEST_P(PeakEwmaLoadBalancerTest, NoHosts) {
+  init();
+
+  EXPECT_EQ(nullptr, lb_->peekAnotherHost(nullptr));
+  EXPECT_EQ(nullptr, lb_->chooseHost(nullptr));
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, SingleHost) {
+  init();
+  initHosts(1);
+
+  EXPECT_CALL(random_, random()).Times(2).WillRepeatedly(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+  EXPECT_EQ(nullptr, lb_->peekAnotherHost(nullptr));
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, PrefersLowerLatency) {
+  init();
+  initHosts(2);
+
+  hostSet().healthy_hosts_[0]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(10));
+  hostSet().healthy_hosts_[1]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(1));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(1)).WillOnce(Return(0));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, ActiveRequestsAndWeight) {
+  init();
+  initHosts(2);
+
+  // 1ms with 9 requests in flight costs more than 2ms with none.
+  hostSet().healthy_hosts_[0]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(1));
+  hostSet().healthy_hosts_[0]->stats().rq_active_.set(9);
+  hostSet().healthy_hosts_[1]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(2));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+
+  // A weight of 10 brings the first host back below the second.
+  hostSet().healthy_hosts_[0]->weight(10);
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, DefaultRtt) {
+  peak_ewma_lb_config_ = envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig();
+  peak_ewma_lb_config_->mutable_default_rtt()->set_nanos(5000000);
+  init();
+  initHosts(2);
+
+  // A host without samples is assumed to take default_rtt.
+  hostSet().healthy_hosts_[0]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(6));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[1], lb_->chooseHost(nullptr));
+
+  hostSet().healthy_hosts_[1]->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(7));
+  EXPECT_CALL(random_, random()).WillOnce(Return(0)).WillOnce(Return(0)).WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[0], lb_->chooseHost(nullptr));
+}
+
+TEST_P(PeakEwmaLoadBalancerTest, ChoiceCount) {
+  peak_ewma_lb_config_ = envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig();
+  peak_ewma_lb_config_->mutable_choice_count()->set_value(4);
+  init();
+  initHosts(4);
+
+  for (uint32_t i = 0; i < 4; ++i) {
+    hostSet().healthy_hosts_[i]->latencyEstimator().putRoundTripTime(
+        std::chrono::milliseconds(4 - i));
+  }
+
+  EXPECT_CALL(random_, random())
+      .WillOnce(Return(0))
+      .WillOnce(Return(0))
+      .WillOnce(Return(2))
+      .WillOnce(Return(3))
+      .WillOnce(Return(1));
+  EXPECT_EQ(hostSet().healthy_hosts_[3], lb_->chooseHost(nullptr));
+}
+
+INSTANTIATE_TEST_SUITE_P(PrimaryOrFailover, PeakEwmaLoadBalancerTest,
+                         ::testing::Values(true, false));
+
 TEST(LoadBalancerSubsetInfoImplTest, DefaultConfigIsDiabled) {
   auto subset_info = LoadBalancerSubsetInfoImpl(
       envoy::config::cluster::v3::Cluster::LbSubsetConfig::default_instance());
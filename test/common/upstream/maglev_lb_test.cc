@@ -12,6 +12,7 @@
 #include "test/mocks/upstream/load_balancer_context.h"
 #include "test/mocks/upstream/priority_set.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
 
 namespace Envoy {
 namespace Upstream {
@@ -506,6 +507,128 @@ TEST_F(MaglevLoadBalancerTest, LocalityWeightedLopsided) {
   EXPECT_EQ(MaglevTable::DefaultTableSize - 1023, counts[0]);
 }
 
+// Incremental table updates only move the entries of removed hosts, or the entries taken by added
+// hosts, and keep the table balanced.
+TEST_F(MaglevLoadBalancerTest, IncrementalTableUpdates) {
+  const uint64_t table_size = 1009;
+  for (uint32_t i = 0; i < 10; ++i) {
+    host_set_.hosts_.push_back(
+        makeTestHost(info_, fmt::format("tcp://127.0.0.1:{}", 90 + i), simTime()));
+  }
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  config_ = envoy::config::cluster::v3::Cluster::MaglevLbConfig();
+  config_.value().mutable_table_size()->set_value(table_size);
+  config_.value().set_incremental_table_updates(true);
+  createLb();
+  lb_->initialize();
+
+  auto table = [this, table_size]() {
+    LoadBalancerPtr lb = lb_->factory()->create();
+    std::vector<HostConstSharedPtr> entries;
+    for (uint64_t i = 0; i < table_size; ++i) {
+      TestLoadBalancerContext context(i);
+      entries.push_back(lb->chooseHost(&context));
+    }
+    return entries;
+  };
+  const std::vector<HostConstSharedPtr> initial = table();
+
+  // Remove a host. Only its entries move.
+  HostSharedPtr removed = host_set_.hosts_.back();
+  host_set_.hosts_.pop_back();
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+  const std::vector<HostConstSharedPtr> after_removal = table();
+  for (uint64_t i = 0; i < table_size; ++i) {
+    if (initial[i] != removed) {
+      EXPECT_EQ(initial[i], after_removal[i]);
+    } else {
+      EXPECT_NE(removed, after_removal[i]);
+    }
+  }
+  EXPECT_EQ(112, lb_->stats().min_entries_per_host_.value());
+  EXPECT_EQ(113, lb_->stats().max_entries_per_host_.value());
+
+  // Add a host. Entries only move to the new host.
+  HostSharedPtr added = makeTestHost(info_, "tcp://127.0.0.1:200", simTime());
+  host_set_.hosts_.push_back(added);
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({added}, {});
+  const std::vector<HostConstSharedPtr> after_addition = table();
+  for (uint64_t i = 0; i < table_size; ++i) {
+    if (after_addition[i] != added) {
+      EXPECT_EQ(after_removal[i], after_addition[i]);
+    }
+  }
+  EXPECT_EQ(100, lb_->stats().min_entries_per_host_.value());
+  EXPECT_EQ(101, lb_->stats().max_entries_per_host_.value());
+}
+
+// Tables built in the background are picked up by existing worker load balancers.
+TEST_F(MaglevLoadBalancerTest, BuildInBackground) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90", simTime()),
+                      makeTestHost(info_, "tcp://127.0.0.1:91", simTime())};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  config_ = envoy::config::cluster::v3::Cluster::MaglevLbConfig();
+  config_.value().mutable_table_size()->set_value(7);
+  createLb();
+  lb_->buildInBackground(Thread::threadFactoryForTest());
+  lb_->initialize();
+
+  // The initial table is built synchronously.
+  LoadBalancerPtr lb = lb_->factory()->create();
+  TestLoadBalancerContext context(0);
+  EXPECT_NE(nullptr, lb->chooseHost(&context));
+
+  HostSharedPtr removed = host_set_.hosts_.back();
+  host_set_.hosts_.pop_back();
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+
+  // The table without the removed host is swapped in once built.
+  ASSERT_TRUE(lb_->waitForBackgroundBuilds(TestUtility::DefaultTimeout));
+  for (uint64_t i = 0; i < 7; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(&context));
+  }
+}
+
+// A load balancer sharing the build thread can be destroyed while its build is pending, without
+// affecting the builds of the other load balancers.
+TEST_F(MaglevLoadBalancerTest, BuildInBackgroundDestroyWithPendingBuild) {
+  host_set_.hosts_ = {makeTestHost(info_, "tcp://127.0.0.1:90", simTime()),
+                      makeTestHost(info_, "tcp://127.0.0.1:91", simTime())};
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  config_ = envoy::config::cluster::v3::Cluster::MaglevLbConfig();
+  config_.value().mutable_table_size()->set_value(7);
+  NiceMock<MockPrioritySet> other_priority_set;
+  MockHostSet& other_host_set = *other_priority_set.getMockHostSet(0);
+  other_host_set.hosts_ = host_set_.hosts_;
+  other_host_set.healthy_hosts_ = host_set_.hosts_;
+  auto other_lb = std::make_unique<MaglevLoadBalancer>(other_priority_set, stats_, stats_store_,
+                                                       runtime_, random_, config_, common_config_);
+  other_lb->buildInBackground(Thread::threadFactoryForTest());
+  other_lb->initialize();
+  createLb();
+  lb_->buildInBackground(Thread::threadFactoryForTest());
+  lb_->initialize();
+
+  // Destroying a load balancer with a pending build doesn't affect the other one.
+  other_host_set.runCallbacks({}, {});
+  other_lb.reset();
+
+  HostSharedPtr removed = host_set_.hosts_.back();
+  host_set_.hosts_.pop_back();
+  host_set_.healthy_hosts_ = host_set_.hosts_;
+  host_set_.runCallbacks({}, {removed});
+  ASSERT_TRUE(lb_->waitForBackgroundBuilds(TestUtility::DefaultTimeout));
+  LoadBalancerPtr lb = lb_->factory()->create();
+  for (uint64_t i = 0; i < 7; ++i) {
+    TestLoadBalancerContext context(i);
+    EXPECT_EQ(host_set_.hosts_[0], lb->chooseHost(&context));
+  }
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -0,0 +1,152 @@
+// Usage: bazel run //test/common/upstream:outlier_detection_benchmark
+
+#include <chrono>
+#include <list>
+#include <memory>
+
+#include "envoy/config/cluster/v3/outlier_detection.pb.h"
+
+#include "source/common/upstream/outlier_detection_impl.h"
+
+#include "test/benchmark/main.h"
+#include "test/common/upstream/utility.h"
+#include "test/mocks/event/mocks.h"
+#include "test/mocks/runtime/mocks.h"
+#include "test/mocks/upstream/cluster_priority_set.h"
+#include "test/mocks/upstream/host_set.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
+
+#include "absl/synchronization/mutex.h"
+#include "benchmark/benchmark.h"
+
+using testing::_;
+using testing::Invoke;
+using testing::NiceMock;
+
+namespace Envoy {
+namespace Upstream {
+namespace Outlier {
+namespace {
+
+// Runs the interval sweeps of a detector over a single cluster. Callbacks posted to the main thread
+// by the sweep thread are queued, and run by waitForSweep().
+class SweepTester : public Event::TestUsingSimulatedTime {
+public:
+  SweepTester(uint64_t num_hosts, bool sweep_in_background) {
+    ON_CALL(dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      absl::MutexLock lock(&posted_mutex_);
+      posted_callbacks_.push_back(std::move(cb));
+    }));
+
+    HostVector& hosts = cluster_.prioritySet().getMockHostSet(0)->hosts_;
+    for (uint64_t i = 0; i < num_hosts; i++) {
+      hosts.push_back(makeTestHost(
+          cluster_.info_, fmt::format("tcp://10.{}.{}.{}:80", i / 65536, (i / 256) % 256, i % 256),
+          simTime()));
+    }
+
+    envoy::config::cluster::v3::OutlierDetection config;
+    config.mutable_success_rate_request_volume()->set_value(RequestsPerInterval);
+    config.mutable_failure_percentage_request_volume()->set_value(RequestsPerInterval);
+    config.mutable_enforcing_failure_percentage()->set_value(100);
+    if (sweep_in_background) {
+      sweep_thread_ = std::make_shared<SweepThread>(Thread::threadFactoryForTest());
+    }
+    detector_ = DetectorImpl::create(cluster_, config, dispatcher_, runtime_, simTime(), nullptr,
+                                     sweep_thread_);
+  }
+
+  // Reports a full interval worth of requests. One host in a hundred fails half of its requests,
+  // without consecutive errors, so that the sweeps have outliers to find.
+  void loadRequests() {
+    const HostVector& hosts = cluster_.prioritySet().getMockHostSet(0)->hosts_;
+    for (uint64_t i = 0; i < hosts.size(); i++) {
+      for (uint64_t j = 0; j < RequestsPerInterval; j++) {
+        hosts[i]->outlierDetector().putHttpResponseCode((i % 100 == 0 && j % 2 == 0) ? 503 : 200);
+      }
+    }
+  }
+
+  // Runs the callbacks posted by the sweep thread until the next interval is armed.
+  void waitForSweep() {
+    while (true) {
+      Event::PostCb cb;
+      {
+        absl::MutexLock lock(&posted_mutex_);
+        posted_mutex_.Await(absl::Condition(this, &SweepTester::hasPostedCallbacks));
+        cb = std::move(posted_callbacks_.front());
+        posted_callbacks_.pop_front();
+      }
+      cb();
+      if (interval_timer_->enabled_) {
+        return;
+      }
+    }
+  }
+
+  bool hasPostedCallbacks() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(posted_mutex_) {
+    return !posted_callbacks_.empty();
+  }
+
+  static constexpr uint64_t RequestsPerInterval = 10;
+
+  NiceMock<MockClusterMockPrioritySet> cluster_;
+  NiceMock<Event::MockDispatcher> dispatcher_;
+  NiceMock<Runtime::MockLoader> runtime_;
+  NiceMock<Event::MockTimer>* interval_timer_ = new NiceMock<Event::MockTimer>(&dispatcher_);
+  absl::Mutex posted_mutex_;
+  std::list<Event::PostCb> posted_callbacks_ ABSL_GUARDED_BY(posted_mutex_);
+  SweepThreadSharedPtr sweep_thread_;
+  std::shared_ptr<DetectorImpl> detector_;
+};
+
+// Measures the main thread time spent in an interval sweep as a function of the number of hosts,
+// with the success rate computations on the main thread or on the sweep thread. When sweeping in
+// the background, the time spent waiting for the sweep thread is excluded, and reported as the
+// sweep_us counter instead.
+void benchmarkIntervalSweep(::benchmark::State& state) {
+  const uint64_t num_hosts = state.range(0);
+  const bool sweep_in_background = state.range(1);
+
+  if (benchmark::skipExpensiveBenchmarks() && num_hosts > 10000) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return;
+  }
+
+  SweepTester tester(num_hosts, sweep_in_background);
+  double sweep_us = 0;
+  for (auto _ : state) { // NOLINT: Silences warning about dead store
+    state.PauseTiming();
+    tester.loadRequests();
+    const MonotonicTime start = std::chrono::steady_clock::now();
+    state.ResumeTiming();
+
+    tester.interval_timer_->invokeCallback();
+    if (sweep_in_background) {
+      state.PauseTiming();
+      {
+        absl::MutexLock lock(&tester.posted_mutex_);
+        tester.posted_mutex_.Await(absl::Condition(&tester, &SweepTester::hasPostedCallbacks));
+      }
+      state.ResumeTiming();
+      tester.waitForSweep();
+    }
+
+    state.PauseTiming();
+    sweep_us += std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    state.ResumeTiming();
+  }
+  state.counters["sweep_us"] = ::benchmark::Counter(sweep_us, ::benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(benchmarkIntervalSweep)
+    ->Ranges({{1000, 50000}, {false, true}})
+    ->Unit(::benchmark::kMicrosecond);
+
+} // namespace
+} // namespace Outlier
+} // namespace Upstream
+} // namespace Envoy
@@ -1,5 +1,6 @@
 #include <chrono>
 #include <cstdint>
+#include <list>
 #include <memory>
 #include <string>
 #include <vector>
@@ -22,13 +23,16 @@
 #include "test/mocks/upstream/host.h"
 #include "test/mocks/upstream/host_set.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
 #include "test/test_common/utility.h"
 
+#include "absl/synchronization/mutex.h"
 #include "absl/types/optional.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
 using testing::_;
+using testing::Invoke;
 using testing::NiceMock;
 using testing::Return;
 using testing::ReturnRef;
@@ -45,7 +49,7 @@ TEST(OutlierDetectorImplFactoryTest, NoDetector) {
   NiceMock<Runtime::MockLoader> runtime;
   EXPECT_EQ(nullptr,
             DetectorImplFactory::createForCluster(cluster, defaultStaticCluster("fake_cluster"),
-                                                  dispatcher, runtime, nullptr));
+                                                  dispatcher, runtime, nullptr, nullptr));
 }
 
 TEST(OutlierDetectorImplFactoryTest, Detector) {
@@ -56,7 +60,7 @@ TEST(OutlierDetectorImplFactoryTest, Detector) {
   NiceMock<Event::MockDispatcher> dispatcher;
   NiceMock<Runtime::MockLoader> runtime;
   EXPECT_NE(nullptr, DetectorImplFactory::createForCluster(cluster, fake_cluster, dispatcher,
-                                                           runtime, nullptr));
+                                                           runtime, nullptr, nullptr));
 }
 
 class CallbackChecker {
@@ -1207,6 +1211,71 @@ TEST_F(OutlierDetectorImplTest, BasicFlowFailurePercentageExternalOrigin) {
                     DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
 }
 
+// A host which is both a success rate and a failure percentage outlier is detected as both, but
+// only ejected once.
+TEST_F(OutlierDetectorImplTest, SuccessRateAndFailurePercentageOutlier) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(
+      cluster_, empty_outlier_detection_, dispatcher_, runtime_, time_system_, event_logger_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutive5xxRuntime, 100))
+      .WillByDefault(Return(false));
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutiveGatewayFailureRuntime, 100))
+      .WillByDefault(Return(false));
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingFailurePercentageRuntime, 0))
+      .WillByDefault(Return(true));
+  // Let the second ejection past the maximum ejection percent, which it would overflow otherwise.
+  ON_CALL(runtime_.snapshot_, getInteger(MaxEjectionPercentRuntime, _)).WillByDefault(Return(100));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::CONSECUTIVE_5XX, false))
+      .Times(360);
+  EXPECT_CALL(*event_logger_,
+              logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]), _,
+                       envoy::data::cluster::v3::CONSECUTIVE_GATEWAY_FAILURE, false))
+      .Times(360);
+
+  // The fifth host has a success rate of 10%, below the success rate threshold of 13.6%, and a
+  // failure percentage of 90%, above the failure percentage threshold of 85%.
+  loadRq(hosts_, 200, 200);
+  loadRq(hosts_[4], 1800, 503);
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(10000));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::SUCCESS_RATE, true));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::FAILURE_PERCENTAGE, false));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  ON_CALL(runtime_.snapshot_, getInteger(SuccessRateStdevFactorRuntime, 1900))
+      .WillByDefault(Return(1900));
+  interval_timer_->invokeCallback();
+
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, outlier_detection_ejections_active_.value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_detected_success_rate")
+                     .value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_detected_failure_percentage")
+                     .value());
+  EXPECT_EQ(1UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_enforced_success_rate")
+                     .value());
+  EXPECT_EQ(0UL, cluster_.info_->stats_store_
+                     .counter("outlier_detection.ejections_enforced_failure_percentage")
+                     .value());
+}
+
 TEST_F(OutlierDetectorImplTest, BasicFlowFailurePercentageLocalOrigin) {
   EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
   addHosts({
@@ -1894,6 +1963,229 @@ TEST_F(OutlierDetectorImplTest, MaxEjectTimeNotAlligned) {
   }
 }
 
+// Runs the success rate sweeps on a sweep thread. Once capturePosts() is called, callbacks posted
+// to the main thread are queued until runPostedCallback() runs them, as a real dispatcher would.
+class OutlierDetectorBackgroundSweepTest : public OutlierDetectorImplTest {
+public:
+  void capturePosts() {
+    ON_CALL(dispatcher_, post(_)).WillByDefault(Invoke([this](Event::PostCb cb) -> void {
+      absl::MutexLock lock(&posted_mutex_);
+      posted_callbacks_.push_back(std::move(cb));
+    }));
+  }
+
+  // Waits for a callback to be posted, e.g. the result of a sweep, and runs it.
+  void runPostedCallback() {
+    Event::PostCb cb;
+    {
+      absl::MutexLock lock(&posted_mutex_);
+      posted_mutex_.Await(
+          absl::Condition(this, &OutlierDetectorBackgroundSweepTest::hasPostedCallbacks));
+      cb = std::move(posted_callbacks_.front());
+      posted_callbacks_.pop_front();
+    }
+    cb();
+  }
+
+  bool hasPostedCallbacks() const ABSL_EXCLUSIVE_LOCKS_REQUIRED(posted_mutex_) {
+    return !posted_callbacks_.empty();
+  }
+
+  absl::Mutex posted_mutex_;
+  std::list<Event::PostCb> posted_callbacks_ ABSL_GUARDED_BY(posted_mutex_);
+  // Declared last so that the thread is joined before the posted callbacks are destroyed.
+  SweepThreadSharedPtr sweep_thread_{std::make_shared<SweepThread>(Thread::threadFactoryForTest())};
+};
+
+TEST_F(OutlierDetectorBackgroundSweepTest, SuccessRateExternalOrigin) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(cluster_, empty_outlier_detection_,
+                                                              dispatcher_, runtime_, time_system_,
+                                                              event_logger_, sweep_thread_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+
+  // Turn off 5xx detection to test SR detection in isolation.
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutive5xxRuntime, 100))
+      .WillByDefault(Return(false));
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutiveGatewayFailureRuntime, 100))
+      .WillByDefault(Return(false));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::CONSECUTIVE_5XX, false))
+      .Times(40);
+  EXPECT_CALL(*event_logger_,
+              logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]), _,
+                       envoy::data::cluster::v3::CONSECUTIVE_GATEWAY_FAILURE, false))
+      .Times(40);
+
+  // Cause a SR error on one host. First have 4 of the hosts have perfect SR.
+  loadRq(hosts_, 200, 200);
+  loadRq(hosts_[4], 200, 503);
+  capturePosts();
+
+  // The interval only hands the sweep to the sweep thread. Nothing is ejected and the timer is not
+  // re-armed until the result is applied on the main thread.
+  time_system_.setMonotonicTime(std::chrono::milliseconds(10000));
+  ON_CALL(runtime_.snapshot_, getInteger(SuccessRateStdevFactorRuntime, 1900))
+      .WillByDefault(Return(1900));
+  interval_timer_->invokeCallback();
+  EXPECT_FALSE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_, logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]),
+                                       _, envoy::data::cluster::v3::SUCCESS_RATE, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  runPostedCallback();
+  EXPECT_EQ(50, hosts_[4]->outlierDetector().successRate(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(90, detector->successRateAverage(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(52, detector->successRateEjectionThreshold(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(-1,
+            detector->successRateAverage(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin));
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, outlier_detection_ejections_active_.value());
+
+  // Unejection happens on the main thread when the interval fires.
+  time_system_.setMonotonicTime(std::chrono::milliseconds(50001));
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_,
+              logUneject(std::static_pointer_cast<const HostDescription>(hosts_[4])));
+  interval_timer_->invokeCallback();
+  EXPECT_FALSE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(0UL, outlier_detection_ejections_active_.value());
+
+  // No requests were made during the last interval, so no success rates are computed.
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  runPostedCallback();
+  EXPECT_EQ(-1, hosts_[4]->outlierDetector().successRate(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+  EXPECT_EQ(-1, detector->successRateAverage(
+                    DetectorHostMonitor::SuccessRateMonitorType::ExternalOrigin));
+}
+
+// The local origin sweep runs once the external origin ejections have been applied.
+TEST_F(OutlierDetectorBackgroundSweepTest, SuccessRateLocalOrigin) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(cluster_, outlier_detection_split_,
+                                                              dispatcher_, runtime_, time_system_,
+                                                              event_logger_, sweep_thread_));
+  detector->addChangedStateCb([&](HostSharedPtr host) -> void { checker_.check(host); });
+
+  // Turn off detecting consecutive local origin failures.
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutiveLocalOriginFailureRuntime, 100))
+      .WillByDefault(Return(false));
+  EXPECT_CALL(*event_logger_,
+              logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]), _,
+                       envoy::data::cluster::v3::CONSECUTIVE_LOCAL_ORIGIN_FAILURE, false))
+      .Times(40);
+  loadRq(hosts_, 200, Result::LocalOriginConnectSuccess);
+  loadRq(hosts_[4], 200, Result::LocalOriginConnectFailed);
+  capturePosts();
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(10000));
+  ON_CALL(runtime_.snapshot_, getInteger(SuccessRateStdevFactorRuntime, 1900))
+      .WillByDefault(Return(1900));
+  interval_timer_->invokeCallback();
+
+  // External origin sweep.
+  runPostedCallback();
+  EXPECT_FALSE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+
+  // Local origin sweep.
+  EXPECT_CALL(checker_, check(hosts_[4]));
+  EXPECT_CALL(*event_logger_,
+              logEject(std::static_pointer_cast<const HostDescription>(hosts_[4]), _,
+                       envoy::data::cluster::v3::SUCCESS_RATE_LOCAL_ORIGIN, true));
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  runPostedCallback();
+  EXPECT_EQ(50, hosts_[4]->outlierDetector().successRate(
+                    DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin));
+  EXPECT_EQ(90,
+            detector->successRateAverage(DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin));
+  EXPECT_EQ(52, detector->successRateEjectionThreshold(
+                    DetectorHostMonitor::SuccessRateMonitorType::LocalOrigin));
+  EXPECT_TRUE(hosts_[4]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(1UL, outlier_detection_ejections_active_.value());
+}
+
+// Hosts removed while a sweep is computed are not ejected.
+TEST_F(OutlierDetectorBackgroundSweepTest, RemoveDuringSweep) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({
+      "tcp://127.0.0.1:80",
+      "tcp://127.0.0.1:81",
+      "tcp://127.0.0.1:82",
+      "tcp://127.0.0.1:83",
+      "tcp://127.0.0.1:84",
+  });
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(cluster_, empty_outlier_detection_,
+                                                              dispatcher_, runtime_, time_system_,
+                                                              event_logger_, sweep_thread_));
+
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutive5xxRuntime, 100))
+      .WillByDefault(Return(false));
+  ON_CALL(runtime_.snapshot_, featureEnabled(EnforcingConsecutiveGatewayFailureRuntime, 100))
+      .WillByDefault(Return(false));
+  EXPECT_CALL(*event_logger_, logEject(_, _, envoy::data::cluster::v3::CONSECUTIVE_5XX, false))
+      .Times(40);
+  EXPECT_CALL(*event_logger_,
+              logEject(_, _, envoy::data::cluster::v3::CONSECUTIVE_GATEWAY_FAILURE, false))
+      .Times(40);
+  loadRq(hosts_, 200, 200);
+  loadRq(hosts_[4], 200, 503);
+  capturePosts();
+
+  time_system_.setMonotonicTime(std::chrono::milliseconds(10000));
+  ON_CALL(runtime_.snapshot_, getInteger(SuccessRateStdevFactorRuntime, 1900))
+      .WillByDefault(Return(1900));
+  interval_timer_->invokeCallback();
+
+  HostVector removed_hosts{hosts_[4]};
+  hosts_.pop_back();
+  cluster_.prioritySet().getMockHostSet(0)->runCallbacks({}, removed_hosts);
+
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  runPostedCallback();
+  EXPECT_FALSE(removed_hosts[0]->healthFlagGet(Host::HealthFlag::FAILED_OUTLIER_CHECK));
+  EXPECT_EQ(0UL, outlier_detection_ejections_active_.value());
+}
+
+// The result of a sweep completing after the detector is destroyed is dropped.
+TEST_F(OutlierDetectorBackgroundSweepTest, DestroyDuringSweep) {
+  EXPECT_CALL(cluster_.prioritySet(), addMemberUpdateCb(_));
+  addHosts({"tcp://127.0.0.1:80"});
+  EXPECT_CALL(*interval_timer_, enableTimer(std::chrono::milliseconds(10000), _));
+  std::shared_ptr<DetectorImpl> detector(DetectorImpl::create(cluster_, empty_outlier_detection_,
+                                                              dispatcher_, runtime_, time_system_,
+                                                              event_logger_, sweep_thread_));
+  capturePosts();
+
+  interval_timer_->invokeCallback();
+  detector.reset();
+  runPostedCallback();
+}
+
 TEST(DetectorHostMonitorNullImplTest, All) {
   DetectorHostMonitorNullImpl null_sink;
 
@@ -25,6 +25,7 @@
 #include "test/mocks/upstream/load_balancer_context.h"
 #include "test/mocks/upstream/priority_set.h"
 #include "test/test_common/simulated_time_system.h"
+#include "test/test_common/test_runtime.h"
 
 #include "absl/types/optional.h"
 #include "gmock/gmock.h"
@@ -125,16 +126,27 @@ private:
 
 enum class UpdateOrder { RemovesFirst, Simultaneous };
 
+// The update order, and whether the compiled subset index is enabled.
+using SubsetLoadBalancerTestParams = std::tuple<UpdateOrder, bool>;
+
 class SubsetLoadBalancerTest : public Event::TestUsingSimulatedTime,
-                               public testing::TestWithParam<UpdateOrder> {
+                               public testing::TestWithParam<SubsetLoadBalancerTestParams> {
 public:
   SubsetLoadBalancerTest()
       : scope_(stats_store_.createScope("testprefix")), stat_names_(stats_store_.symbolTable()),
         stats_(ClusterInfoImpl::generateStats(stats_store_, stat_names_)) {
     stats_.max_host_weight_.set(1UL);
     least_request_lb_config_.mutable_choice_count()->set_value(2);
+    // Only TEST_P tests of this fixture have a parameter.
+    if (testing::UnitTest::GetInstance()->current_test_info()->value_param() != nullptr &&
+        std::get<1>(GetParam())) {
+      Runtime::LoaderSingleton::getExisting()->mergeValues(
+          {{"envoy.reloadable_features.subset_lb_compiled_index", "true"}});
+    }
   }
 
+  UpdateOrder updateOrder() const { return std::get<0>(GetParam()); }
+
   using HostMetadata = std::map<std::string, std::string>;
   using HostListMetadata = std::map<std::string, std::vector<std::string>>;
   using HostURLMetadataMap = std::map<std::string, HostMetadata>;
@@ -339,7 +351,7 @@ public:
       host_set.healthy_hosts_per_locality_ = host_set.hosts_per_locality_;
     }
 
-    if (GetParam() == UpdateOrder::RemovesFirst && !remove.empty()) {
+    if (updateOrder() == UpdateOrder::RemovesFirst && !remove.empty()) {
       host_set.runCallbacks({}, remove);
     }
 
@@ -355,7 +367,7 @@ public:
       }
     }
 
-    if (GetParam() == UpdateOrder::RemovesFirst) {
+    if (updateOrder() == UpdateOrder::RemovesFirst) {
       if (!add.empty()) {
         host_set_.runCallbacks(add, {});
       }
@@ -381,7 +393,7 @@ public:
       local_hosts_per_locality_ = makeHostsPerLocality(std::move(locality_hosts_copy));
     }
 
-    if (GetParam() == UpdateOrder::RemovesFirst && !remove.empty()) {
+    if (updateOrder() == UpdateOrder::RemovesFirst && !remove.empty()) {
       local_priority_set_.updateHosts(
           0,
           updateHostsParams(local_hosts_, local_hosts_per_locality_,
@@ -397,7 +409,7 @@ public:
       local_hosts_per_locality_ = makeHostsPerLocality(std::move(locality_hosts_copy));
     }
 
-    if (GetParam() == UpdateOrder::RemovesFirst) {
+    if (updateOrder() == UpdateOrder::RemovesFirst) {
       if (!add.empty()) {
         local_priority_set_.updateHosts(
             0,
@@ -469,6 +481,7 @@ public:
   }
 
   LoadBalancerType lb_type_{LoadBalancerType::RoundRobin};
+  TestScopedRuntime scoped_runtime_;
   NiceMock<MockPrioritySet> priority_set_;
   MockHostSet& host_set_ = *priority_set_.getMockHostSet(0);
   NiceMock<MockLoadBalancerSubsetInfo> subset_info_;
@@ -2379,7 +2392,9 @@ TEST_P(SubsetLoadBalancerTest, KeysSubsetFallbackToNotExistingSelector) {
 }
 
 INSTANTIATE_TEST_SUITE_P(UpdateOrderings, SubsetLoadBalancerTest,
-                         testing::ValuesIn({UpdateOrder::RemovesFirst, UpdateOrder::Simultaneous}));
+                         testing::Combine(testing::ValuesIn({UpdateOrder::RemovesFirst,
+                                                             UpdateOrder::Simultaneous}),
+                                          testing::Bool()));
 
 class SubsetLoadBalancerSingleHostPerSubsetTest : public SubsetLoadBalancerTest {
 public:
@@ -2515,7 +2530,9 @@ TEST_P(SubsetLoadBalancerSingleHostPerSubsetTest, Update) {
 }
 
 INSTANTIATE_TEST_SUITE_P(UpdateOrderings, SubsetLoadBalancerSingleHostPerSubsetTest,
-                         testing::ValuesIn({UpdateOrder::RemovesFirst, UpdateOrder::Simultaneous}));
+                         testing::Combine(testing::ValuesIn({UpdateOrder::RemovesFirst,
+                                                             UpdateOrder::Simultaneous}),
+                                          testing::Values(false)));
 
 } // namespace SubsetLoadBalancerTest
 } // namespace Upstream
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cmath>
 #include <cstdint>
 #include <list>
 #include <memory>
@@ -44,6 +45,7 @@
 #include "test/test_common/environment.h"
 #include "test/test_common/registry.h"
 #include "test/test_common/test_runtime.h"
+#include "test/test_common/thread_factory_for_test.h"
 #include "test/test_common/utility.h"
 
 #include "gmock/gmock.h"
@@ -1451,6 +1453,129 @@ TEST_F(HostImplTest, HealthcheckHostname) {
   EXPECT_EQ("foo", descr.hostnameForHealthChecks());
 }
 
+// Latency estimates are only maintained for clusters using a latency aware load balancer.
+TEST_F(HostImplTest, LatencyEstimatorDisabled) {
+  MockClusterMockPrioritySet cluster;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), 1);
+  host->latencyEstimator().putRoundTripTime(std::chrono::milliseconds(10));
+  EXPECT_FALSE(host->latencyEstimator().roundTripTimeEstimate().has_value());
+}
+
+TEST_F(HostImplTest, PeakEwmaLatencyEstimator) {
+  MockClusterMockPrioritySet cluster;
+  cluster.info_->lb_type_ = LoadBalancerType::PeakEwma;
+  cluster.info_->lb_peak_ewma_config_ = envoy::config::cluster::v3::Cluster::PeakEwmaLbConfig();
+  cluster.info_->lb_peak_ewma_config_->mutable_decay_time()->set_seconds(10);
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), 1);
+  LatencyEstimator& estimator = host->latencyEstimator();
+
+  EXPECT_FALSE(estimator.roundTripTimeEstimate().has_value());
+
+  // The first sample is taken as is.
+  estimator.putRoundTripTime(std::chrono::milliseconds(10));
+  EXPECT_DOUBLE_EQ(10000, estimator.roundTripTimeEstimate().value());
+
+  // A larger sample replaces the estimate right away.
+  estimator.putRoundTripTime(std::chrono::milliseconds(20));
+  EXPECT_DOUBLE_EQ(20000, estimator.roundTripTimeEstimate().value());
+
+  // Smaller samples are averaged in, weighted by the time since the previous sample.
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  estimator.putRoundTripTime(std::chrono::milliseconds(10));
+  const double expected = 20000 * std::exp(-1.0) + 10000 * (1 - std::exp(-1.0));
+  EXPECT_DOUBLE_EQ(expected, estimator.roundTripTimeEstimate().value());
+
+  // Without new samples the estimate decays, so an idle host is eventually retried.
+  simTime().advanceTimeWait(std::chrono::seconds(10));
+  EXPECT_DOUBLE_EQ(expected * std::exp(-1.0), estimator.roundTripTimeEstimate().value());
+}
+
+// By default, active requests are counted in the rq_active gauge shared by all workers.
+TEST_F(HostImplTest, ActiveRequestCounterDefault) {
+  MockClusterMockPrioritySet cluster;
+  cluster.info_->lb_type_ = LoadBalancerType::LeastRequest;
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), 1);
+  host->activeRequests().inc();
+  host->activeRequests().inc();
+  host->activeRequests().dec();
+  EXPECT_EQ(1, host->stats().rq_active_.value());
+  EXPECT_EQ(1, host->activeRequests().estimate());
+  EXPECT_EQ(1, host->activeRequests().total());
+}
+
+TEST_F(HostImplTest, PerWorkerActiveRequestCounter) {
+  MockClusterMockPrioritySet cluster;
+  cluster.info_->lb_type_ = LoadBalancerType::LeastRequest;
+  cluster.info_->lb_least_request_config_ =
+      envoy::config::cluster::v3::Cluster::LeastRequestLbConfig();
+  cluster.info_->lb_least_request_config_->set_per_worker_active_requests(true);
+  cluster.info_->lb_least_request_config_->mutable_active_requests_merge_interval()->set_nanos(
+      5000000);
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), 1);
+  ActiveRequestCounter& active_requests = host->activeRequests();
+
+  // Requests started by the calling thread are accounted for right away, the gauge is only updated
+  // on merges.
+  active_requests.inc();
+  active_requests.inc();
+  EXPECT_EQ(2, active_requests.estimate());
+  EXPECT_EQ(0, host->stats().rq_active_.value());
+
+  // Requests started by other threads are accounted for once the merge interval elapsed.
+  Thread::ThreadPtr thread = Thread::threadFactoryForTest().createThread([&active_requests]() {
+    for (int i = 0; i < 5; i++) {
+      active_requests.inc();
+    }
+    active_requests.dec();
+  });
+  thread->join();
+  EXPECT_EQ(2, active_requests.estimate());
+  simTime().advanceTimeWait(std::chrono::milliseconds(5));
+  EXPECT_EQ(6, active_requests.estimate());
+  EXPECT_EQ(6, host->stats().rq_active_.value());
+
+  // The readers off the request path see the sum of all workers without waiting for a merge.
+  active_requests.inc();
+  EXPECT_EQ(7, active_requests.total());
+  EXPECT_EQ(7, host->stats().rq_active_.value());
+  active_requests.dec();
+  for (const auto& [name, gauge] : host->gauges()) {
+    if (name == "rq_active") {
+      EXPECT_EQ(6, gauge.get().value());
+    }
+  }
+
+  // Requests completed on a different thread than the one which started them only lower the total.
+  thread = Thread::threadFactoryForTest().createThread([&active_requests]() {
+    for (int i = 0; i < 4; i++) {
+      active_requests.dec();
+    }
+  });
+  thread->join();
+  simTime().advanceTimeWait(std::chrono::milliseconds(5));
+  EXPECT_EQ(2, active_requests.estimate());
+  EXPECT_EQ(2, host->stats().rq_active_.value());
+
+  // The estimate never goes negative, even when the calling thread completed more requests than the
+  // last merge accounted for.
+  active_requests.dec();
+  active_requests.dec();
+  active_requests.dec();
+  EXPECT_EQ(0, active_requests.estimate());
+}
+
+// Per worker counts are only kept for clusters using the least request load balancer.
+TEST_F(HostImplTest, PerWorkerActiveRequestCounterRequiresLeastRequest) {
+  MockClusterMockPrioritySet cluster;
+  cluster.info_->lb_type_ = LoadBalancerType::RoundRobin;
+  cluster.info_->lb_least_request_config_ =
+      envoy::config::cluster::v3::Cluster::LeastRequestLbConfig();
+  cluster.info_->lb_least_request_config_->set_per_worker_active_requests(true);
+  HostSharedPtr host = makeTestHost(cluster.info_, "tcp://10.0.0.1:1234", simTime(), 1);
+  host->activeRequests().inc();
+  EXPECT_EQ(1, host->stats().rq_active_.value());
+}
+
 class StaticClusterImplTest : public testing::Test, public UpstreamImplTestBase {};
 
 TEST_F(StaticClusterImplTest, InitialHosts) {
@@ -4162,6 +4287,22 @@ TEST_F(ClusterInfoImplTest, DeprecatedMaxRequestsPerConnection) {
   EXPECT_EQ(3U, cluster->info()->maxRequestsPerConnection());
 }
 
+TEST_F(ClusterInfoImplTest, SharedConnPoolOwnerWorkers) {
+  const std::string yaml = R"EOF(
+  name: cluster1
+  type: STRICT_DNS
+  lb_policy: ROUND_ROBIN
+)EOF";
+
+  EXPECT_EQ(0U, makeCluster(yaml)->info()->sharedConnPoolOwnerWorkers());
+  EXPECT_EQ(1U, makeCluster(yaml + "  shared_connection_pool: {}\n")
+                    ->info()
+                    ->sharedConnPoolOwnerWorkers());
+  EXPECT_EQ(2U, makeCluster(yaml + "  shared_connection_pool:\n    owner_workers: 2\n")
+                    ->info()
+                    ->sharedConnPoolOwnerWorkers());
+}
+
 } // namespace
 } // namespace Upstream
 } // namespace Envoy
@@ -42,6 +42,17 @@ TEST(FileAccessLogNegativeTest, InvalidNameFail) {
                             "Didn't find a registered implementation for name: 'INVALID'");
 }
 
+TEST(FileAccessLogConfigTest, MaxFileSize) {
+  NiceMock<Server::Configuration::MockServerFactoryContext> context;
+  envoy::extensions::access_loggers::file::v3::FileAccessLog fal_config;
+  fal_config.set_path("/foo");
+  fal_config.set_max_file_size_bytes(1024);
+
+  Filesystem::FilePathAndType file_info{Filesystem::DestinationType::File, "/foo"};
+  EXPECT_CALL(context.access_log_manager_, createAccessLog(file_info, 1024));
+  FileAccessLogFactory().createAccessLogInstance(fal_config, nullptr, context);
+}
+
 class FileAccessLogTest : public testing::Test {
 public:
   FileAccessLogTest() = default;
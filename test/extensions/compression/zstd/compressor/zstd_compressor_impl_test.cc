@@ -0,0 +1,132 @@
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/compression/zstd/compressor/config.h"
+#include "source/extensions/compression/zstd/decompressor/zstd_decompressor_impl.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Compressor {
+namespace {
+
+class ZstdCompressorImplTest : public testing::Test {
+protected:
+  void drainBuffer(Buffer::OwnedImpl& buffer) { buffer.drain(buffer.length()); }
+
+  void verifyWithDecompressor(Envoy::Compression::Compressor::CompressorPtr compressor,
+                              const std::vector<Decompressor::ZstdDDictSharedPtr>& dictionaries =
+                                  {}) {
+    Buffer::OwnedImpl buffer;
+    Buffer::OwnedImpl accumulation_buffer;
+    std::string original_text{};
+    for (uint64_t i = 0; i < 10; i++) {
+      TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size * i, i);
+      original_text.append(buffer.toString());
+      ASSERT_EQ(default_input_size * i, buffer.length());
+      compressor->compress(buffer, Envoy::Compression::Compressor::State::Flush);
+      accumulation_buffer.add(buffer);
+      drainBuffer(buffer);
+      ASSERT_EQ(0, buffer.length());
+    }
+
+    compressor->compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    accumulation_buffer.add(buffer);
+    drainBuffer(buffer);
+
+    Stats::IsolatedStoreImpl stats_store{};
+    Compression::Zstd::Decompressor::ZstdDecompressorImpl decompressor{
+        stats_store, "test.", dictionaries, ZSTD_WINDOWLOG_LIMIT_DEFAULT, 4096};
+
+    decompressor.decompress(accumulation_buffer, buffer);
+    std::string decompressed_text{buffer.toString()};
+
+    ASSERT_EQ(original_text.length(), decompressed_text.length());
+    EXPECT_EQ(original_text, decompressed_text);
+  }
+
+  static constexpr uint32_t default_compression_level{19};
+  static constexpr uint32_t default_window_log{22};
+  static constexpr uint32_t default_input_size{796};
+};
+
+TEST_F(ZstdCompressorImplTest, CompressorDeathTest) {
+  EXPECT_DEATH(
+      { ZstdCompressorImpl compressor(1000, default_window_log, false, nullptr, 4096); },
+      "assert failure: compression_level >= 1");
+  EXPECT_DEATH(
+      { ZstdCompressorImpl compressor(default_compression_level, 1, false, nullptr, 4096); },
+      "assert failure: window_log >= ZSTD_WINDOWLOG_MIN && window_log <= ZSTD_WINDOWLOG_MAX");
+}
+
+TEST_F(ZstdCompressorImplTest, CallingFinishOnly) {
+  Buffer::OwnedImpl buffer;
+  ZstdCompressorImpl compressor(default_compression_level, default_window_log, false, nullptr,
+                                4096);
+
+  TestUtility::feedBufferWithRandomCharacters(buffer, 4096);
+  compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+}
+
+TEST_F(ZstdCompressorImplTest, CallingFlushOnly) {
+  Buffer::OwnedImpl buffer;
+  ZstdCompressorImpl compressor(default_compression_level, default_window_log, false, nullptr,
+                                4096);
+
+  TestUtility::feedBufferWithRandomCharacters(buffer, 4096);
+  compressor.compress(buffer, Envoy::Compression::Compressor::State::Flush);
+}
+
+TEST_F(ZstdCompressorImplTest, CompressWithSmallChunkSize) {
+  auto compressor = std::make_unique<ZstdCompressorImpl>(default_compression_level,
+                                                         default_window_log, true, nullptr, 8);
+  verifyWithDecompressor(std::move(compressor));
+}
+
+TEST_F(ZstdCompressorImplTest, LoadConfig) {
+  const std::string json{R"EOF({
+  "compression_level": 19,
+  "window_log": 22,
+  "enable_checksum": true,
+  "chunk_size": 4096
+})EOF"};
+  envoy::extensions::compression::zstd::compressor::v3::Zstd zstd;
+  TestUtility::loadFromJson(json, zstd);
+
+  ZstdCompressorLibraryFactory lib_factory;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  Envoy::Compression::Compressor::CompressorFactoryPtr factory =
+      lib_factory.createCompressorFactoryFromProto(zstd, context);
+  EXPECT_EQ("zstd.", factory->statsPrefix());
+  EXPECT_EQ("zstd", factory->contentEncoding());
+
+  verifyWithDecompressor(factory->createCompressor());
+}
+
+TEST_F(ZstdCompressorImplTest, CompressWithDictionary) {
+  const std::string dictionary{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+  envoy::extensions::compression::zstd::compressor::v3::Zstd zstd;
+  zstd.mutable_dictionary()->set_inline_string(dictionary);
+
+  ZstdCompressorLibraryFactory lib_factory;
+  NiceMock<Server::Configuration::MockFactoryContext> context;
+  Envoy::Compression::Compressor::CompressorFactoryPtr factory =
+      lib_factory.createCompressorFactoryFromProto(zstd, context);
+
+  verifyWithDecompressor(factory->createCompressor(),
+                         {Decompressor::ZstdDDictSharedPtr(
+                             ZSTD_createDDict(dictionary.data(), dictionary.size()),
+                             &ZSTD_freeDDict)});
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
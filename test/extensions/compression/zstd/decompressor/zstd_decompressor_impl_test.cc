@@ -0,0 +1,188 @@
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/stats/isolated_store_impl.h"
+#include "source/extensions/compression/zstd/compressor/zstd_compressor_impl.h"
+#include "source/extensions/compression/zstd/decompressor/config.h"
+
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace Compression {
+namespace Zstd {
+namespace Decompressor {
+namespace {
+
+class ZstdDecompressorImplTest : public testing::Test {
+protected:
+  void drainBuffer(Buffer::OwnedImpl& buffer) { buffer.drain(buffer.length()); }
+
+  // Compresses random text in several flushed pieces and returns the original text.
+  std::string compress(Compressor::ZstdCompressorImpl& compressor,
+                       Buffer::OwnedImpl& accumulation_buffer) {
+    Buffer::OwnedImpl buffer;
+    std::string original_text{};
+    for (uint64_t i = 0; i < 20; ++i) {
+      TestUtility::feedBufferWithRandomCharacters(buffer, default_input_size * i, i);
+      original_text.append(buffer.toString());
+      compressor.compress(buffer, Envoy::Compression::Compressor::State::Flush);
+      accumulation_buffer.add(buffer);
+      drainBuffer(buffer);
+    }
+
+    compressor.compress(buffer, Envoy::Compression::Compressor::State::Finish);
+    accumulation_buffer.add(buffer);
+    return original_text;
+  }
+
+  Envoy::Compression::Decompressor::DecompressorFactoryPtr
+  createFactory(const envoy::extensions::compression::zstd::decompressor::v3::Zstd& zstd) {
+    ZstdDecompressorLibraryFactory lib_factory;
+    return lib_factory.createDecompressorFactoryFromProto(zstd, context_);
+  }
+
+  NiceMock<Server::Configuration::MockFactoryContext> context_;
+
+  static constexpr uint32_t default_compression_level{3};
+  static constexpr uint32_t default_window_log{22};
+  static constexpr uint32_t default_input_size{796};
+};
+
+// Exercises compression and decompression by compressing some data, decompressing it and then
+// comparing compressor's input with decompressor's output.
+TEST_F(ZstdDecompressorImplTest, CompressAndDecompress) {
+  Compressor::ZstdCompressorImpl compressor{default_compression_level, default_window_log, true,
+                                            nullptr, 4096};
+  // Content resembling the dictionary, so that the frame references it.
+  std::string original_text;
+  for (size_t i = 0; i < 20; ++i) {
+    original_text.append(dictionary.substr(i)).append(std::to_string(i));
+  }
+  Buffer::OwnedImpl accumulation_buffer(original_text);
+  compressor.compress(accumulation_buffer, Envoy::Compression::Compressor::State::Finish);
+
+  std::string json{R"EOF({
+  "chunk_size": 4096
+})EOF"};
+  envoy::extensions::compression::zstd::decompressor::v3::Zstd zstd;
+  TestUtility::loadFromJson(json, zstd);
+  Envoy::Compression::Decompressor::DecompressorFactoryPtr factory = createFactory(zstd);
+  EXPECT_EQ("zstd.", factory->statsPrefix());
+  EXPECT_EQ("zstd", factory->contentEncoding());
+
+  Buffer::OwnedImpl buffer;
+  Envoy::Compression::Decompressor::DecompressorPtr decompressor =
+      factory->createDecompressor("test.");
+  decompressor->decompress(accumulation_buffer, buffer);
+  std::string decompressed_text{buffer.toString()};
+  ASSERT_EQ(original_text.length(), decompressed_text.length());
+  EXPECT_EQ(original_text, decompressed_text);
+}
+
+// Exercises decompression with a very small output buffer.
+TEST_F(ZstdDecompressorImplTest, DecompressWithSmallOutputBuffer) {
+  Compressor::ZstdCompressorImpl compressor{default_compression_level, default_window_log, false,
+                                            nullptr, 4096};
+  // Content resembling the dictionary, so that the frame references it.
+  std::string original_text;
+  for (size_t i = 0; i < 20; ++i) {
+    original_text.append(dictionary.substr(i)).append(std::to_string(i));
+  }
+  Buffer::OwnedImpl accumulation_buffer(original_text);
+  compressor.compress(accumulation_buffer, Envoy::Compression::Compressor::State::Finish);
+
+  Stats::IsolatedStoreImpl stats_store{};
+  ZstdDecompressorImpl decompressor{stats_store, "test.", {}, ZSTD_WINDOWLOG_LIMIT_DEFAULT, 16};
+  Buffer::OwnedImpl buffer;
+  decompressor.decompress(accumulation_buffer, buffer);
+  EXPECT_EQ(original_text, buffer.toString());
+}
+
+TEST_F(ZstdDecompressorImplTest, DecompressWithDictionary) {
+  const std::string dictionary{"0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ"};
+  Compressor::ZstdCompressorImpl compressor{
+      default_compression_level, 0, false,
+      Compressor::ZstdCDictSharedPtr(ZSTD_createCDict(dictionary.data(), dictionary.size(),
+                                                      default_compression_level),
+                                     &ZSTD_freeCDict),
+      4096};
+  // Content resembling the dictionary, so that the frame references it.
+  std::string original_text;
+  for (size_t i = 0; i < 20; ++i) {
+    original_text.append(dictionary.substr(i)).append(std::to_string(i));
+  }
+  Buffer::OwnedImpl accumulation_buffer(original_text);
+  compressor.compress(accumulation_buffer, Envoy::Compression::Compressor::State::Finish);
+  Buffer::OwnedImpl copy_buffer(accumulation_buffer);
+
+  envoy::extensions::compression::zstd::decompressor::v3::Zstd zstd;
+  zstd.add_dictionaries()->set_inline_string(dictionary);
+  Buffer::OwnedImpl buffer;
+  createFactory(zstd)->createDecompressor("test.")->decompress(accumulation_buffer, buffer);
+  EXPECT_EQ(original_text, buffer.toString());
+
+  // Without the dictionary the content can't be decompressed.
+  Stats::IsolatedStoreImpl stats_store{};
+  ZstdDecompressorImpl decompressor{stats_store, "test.", {}, ZSTD_WINDOWLOG_LIMIT_DEFAULT, 4096};
+  drainBuffer(buffer);
+  decompressor.decompress(copy_buffer, buffer);
+  EXPECT_NE(original_text, buffer.toString());
+  EXPECT_EQ(1, stats_store.counterFromString("test.zstd_generic_error").value());
+}
+
+TEST_F(ZstdDecompressorImplTest, WindowTooLarge) {
+  Compressor::ZstdCompressorImpl compressor{default_compression_level, default_window_log, false,
+                                            nullptr, 4096};
+  Buffer::OwnedImpl accumulation_buffer;
+  compress(compressor, accumulation_buffer);
+
+  Stats::IsolatedStoreImpl stats_store{};
+  ZstdDecompressorImpl decompressor{stats_store, "test.", {}, 10, 4096};
+  Buffer::OwnedImpl buffer;
+  decompressor.decompress(accumulation_buffer, buffer);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(1, stats_store.counterFromString("test.zstd_memory_error").value());
+}
+
+TEST_F(ZstdDecompressorImplTest, ChecksumMismatch) {
+  Compressor::ZstdCompressorImpl compressor{default_compression_level, default_window_log, true,
+                                            nullptr, 4096};
+  Buffer::OwnedImpl accumulation_buffer;
+  compress(compressor, accumulation_buffer);
+
+  // Corrupt the checksum at the end of the frame.
+  std::string corrupted = accumulation_buffer.toString();
+  corrupted.back() ^= 0xff;
+  Buffer::OwnedImpl input_buffer(corrupted);
+
+  Stats::IsolatedStoreImpl stats_store{};
+  ZstdDecompressorImpl decompressor{stats_store, "test.", {}, ZSTD_WINDOWLOG_LIMIT_DEFAULT, 4096};
+  Buffer::OwnedImpl buffer;
+  decompressor.decompress(input_buffer, buffer);
+  EXPECT_EQ(1, stats_store.counterFromString("test.zstd_checksum_wrong_error").value());
+}
+
+TEST_F(ZstdDecompressorImplTest, DecompressGarbage) {
+  Buffer::OwnedImpl input_buffer("this is not zstd");
+  Stats::IsolatedStoreImpl stats_store{};
+  ZstdDecompressorImpl decompressor{stats_store, "test.", {}, ZSTD_WINDOWLOG_LIMIT_DEFAULT, 4096};
+  Buffer::OwnedImpl buffer;
+  decompressor.decompress(input_buffer, buffer);
+  EXPECT_EQ(0, buffer.length());
+  EXPECT_EQ(1, stats_store.counterFromString("test.zstd_generic_error").value());
+}
+
+TEST_F(ZstdDecompressorImplTest, InvalidDictionary) {
+  envoy::extensions::compression::zstd::decompressor::v3::Zstd zstd;
+  zstd.add_dictionaries()->set_filename("/does/not/exist");
+  EXPECT_THROW(createFactory(zstd), EnvoyException);
+}
+
+} // namespace
+} // namespace Decompressor
+} // namespace Zstd
+} // namespace Compression
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,428 @@
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "envoy/extensions/cache/file_system_http_cache/v3/config.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/common/random_generator.h"
+#include "source/common/filesystem/directory.h"
+#include "source/extensions/filters/http/cache/cache_headers_utils.h"
+#include "source/extensions/filters/http/cache/file_system_http_cache/file_system_http_cache.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/extensions/filters/http/cache/common.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/environment.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/thread_factory_for_test.h"
+#include "test/test_common/utility.h"
+
+#include "absl/synchronization/notification.h"
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+using testing::ReturnRef;
+
+envoy::extensions::filters::http::cache::v3::CacheConfig getConfig() {
+  // Allows 'accept' to be varied in the tests.
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  const auto& add_accept = config.mutable_allowed_vary_headers()->Add();
+  add_accept->set_exact("accept");
+  return config;
+}
+
+class FileSystemHttpCacheTest : public testing::Test {
+protected:
+  FileSystemHttpCacheTest() : vary_allow_list_(getConfig().allowed_vary_headers()) {
+    cache_path_ = TestEnvironment::temporaryPath(
+        absl::StrCat("file_system_http_cache_test_",
+                     testing::UnitTest::GetInstance()->current_test_info()->name()));
+    TestEnvironment::removePath(cache_path_);
+    TestEnvironment::createPath(cache_path_);
+    config_.set_cache_path(cache_path_);
+    config_.mutable_thread_count()->set_value(2);
+    config_.mutable_read_chunk_size_bytes()->set_value(1024);
+    request_headers_.setMethod("GET");
+    request_headers_.setHost("example.com");
+    request_headers_.setScheme("https");
+    request_headers_.setCopy(Http::CustomHeaders::get().CacheControl, "max-age=3600");
+    initialize();
+  }
+
+  ~FileSystemHttpCacheTest() override {
+    cache_.reset();
+    TestEnvironment::removePath(cache_path_);
+  }
+
+  void initialize() {
+    // Wait for queued work of the previous cache to finish before replacing it.
+    cache_.reset();
+    cache_ = std::make_unique<FileSystemHttpCache>(config_, Thread::threadFactoryForTest(), random_,
+                                                   store_);
+  }
+
+  // Performs a cache lookup, waiting for the headers.
+  LookupContextPtr lookup(absl::string_view request_path) {
+    LookupRequest request = makeLookupRequest(request_path);
+    LookupContextPtr context = cache_->makeLookupContext(std::move(request));
+    absl::Notification done;
+    context->getHeaders([this, &done](LookupResult&& result) {
+      lookup_result_ = std::move(result);
+      done.Notify();
+    });
+    done.WaitForNotification();
+    return context;
+  }
+
+  // Inserts a value into the cache, waiting for the insert to be written.
+  void insert(LookupContextPtr lookup, const Http::TestResponseHeaderMapImpl& response_headers,
+              const absl::string_view response_body) {
+    InsertContextPtr inserter = cache_->makeInsertContext(move(lookup));
+    const ResponseMetadata metadata = {time_source_.systemTime()};
+    inserter->insertHeaders(response_headers, metadata, false);
+    inserter->insertBody(Buffer::OwnedImpl(response_body), nullptr, true);
+    inserter->onDestroy();
+    waitForWrites();
+  }
+
+  void insert(absl::string_view request_path, absl::string_view response_body) {
+    insert(lookup(request_path), responseHeaders(), response_body);
+  }
+
+  // Restarts the cache, which runs any queued work.
+  void waitForWrites() { initialize(); }
+
+  Http::TestResponseHeaderMapImpl responseHeaders() {
+    return Http::TestResponseHeaderMapImpl{
+        {"date", formatter_.fromTime(time_source_.systemTime())},
+        {"cache-control", "public,max-age=3600"}};
+  }
+
+  // Reads one chunk of the body, which may be shorter than the requested range.
+  Buffer::InstancePtr getBodyChunk(LookupContext& context, uint64_t start, uint64_t end) {
+    Buffer::InstancePtr body;
+    absl::Notification done;
+    context.getBody(AdjustedByteRange(start, end), [&body, &done](Buffer::InstancePtr&& data) {
+      body = std::move(data);
+      done.Notify();
+    });
+    done.WaitForNotification();
+    return body;
+  }
+
+  std::string getBody(LookupContext& context, uint64_t start, uint64_t end) {
+    std::string body;
+    while (start < end) {
+      Buffer::InstancePtr chunk = getBodyChunk(context, start, end);
+      EXPECT_NE(chunk, nullptr);
+      if (chunk == nullptr) {
+        break;
+      }
+      start += chunk->length();
+      body += chunk->toString();
+    }
+    return body;
+  }
+
+  LookupRequest makeLookupRequest(absl::string_view request_path) {
+    request_headers_.setPath(request_path);
+    return LookupRequest(request_headers_, time_source_.systemTime(), vary_allow_list_);
+  }
+
+  AssertionResult expectLookupSuccessWithBody(LookupContext* lookup_context,
+                                              absl::string_view body) {
+    if (lookup_result_.cache_entry_status_ != CacheEntryStatus::Ok) {
+      return AssertionFailure() << "Expected: lookup_result_.cache_entry_status == "
+                                   "CacheEntryStatus::Ok\n  Actual: "
+                                << lookup_result_.cache_entry_status_;
+    }
+    if (!lookup_result_.headers_) {
+      return AssertionFailure() << "Expected nonnull lookup_result_.headers";
+    }
+    if (lookup_result_.content_length_ != body.size()) {
+      return AssertionFailure() << "Expected content length " << body.size()
+                                << "\n  Actual: " << lookup_result_.content_length_;
+    }
+    const std::string actual_body = getBody(*lookup_context, 0, body.size());
+    if (body != actual_body) {
+      return AssertionFailure() << "Expected body == " << body << "\n  Actual:  " << actual_body;
+    }
+    return AssertionSuccess();
+  }
+
+  // Returns the paths of all files in the cache directory.
+  std::vector<std::string> cacheFiles() {
+    std::vector<std::string> files;
+    for (const Filesystem::DirectoryEntry& entry : Filesystem::Directory(cache_path_)) {
+      if (entry.type_ == Filesystem::FileType::Regular) {
+        files.push_back(absl::StrCat(cache_path_, "/", entry.name_));
+      }
+    }
+    return files;
+  }
+
+  uint64_t counter(absl::string_view name) {
+    return store_.counter(absl::StrCat("http_cache.file_system.", name)).value();
+  }
+
+  std::string cache_path_;
+  envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig config_;
+  Stats::TestUtil::TestStore store_;
+  Random::RandomGeneratorImpl random_;
+  std::unique_ptr<FileSystemHttpCache> cache_;
+  LookupResult lookup_result_;
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Event::SimulatedTimeSystem time_source_;
+  DateFormatter formatter_{"%a, %d %b %Y %H:%M:%S GMT"};
+  VaryAllowList vary_allow_list_;
+};
+
+TEST_F(FileSystemHttpCacheTest, PutGet) {
+  const std::string request_path("/name");
+  LookupContextPtr name_lookup_context = lookup(request_path);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+
+  insert(move(name_lookup_context), responseHeaders(), "Value");
+  name_lookup_context = lookup(request_path);
+  EXPECT_TRUE(expectLookupSuccessWithBody(name_lookup_context.get(), "Value"));
+  EXPECT_EQ("alu", getBody(*name_lookup_context, 1, 4));
+  EXPECT_EQ("public,max-age=3600",
+            lookup_result_.headers_->get(Http::CustomHeaders::get().CacheControl)[0]
+                ->value()
+                .getStringView());
+
+  insert(move(name_lookup_context), responseHeaders(), "NewValue");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(request_path).get(), "NewValue"));
+
+  EXPECT_EQ(2, counter("lookup_hits"));
+  EXPECT_EQ(1, counter("lookup_misses"));
+  EXPECT_EQ(2, counter("inserts"));
+}
+
+TEST_F(FileSystemHttpCacheTest, LargeBodyIsReadInChunks) {
+  std::string body;
+  for (int i = 0; i < 1000; ++i) {
+    absl::StrAppend(&body, i, ",");
+  }
+  insert("/large", body);
+
+  LookupContextPtr context = lookup("/large");
+  // The read chunk size is 1024 bytes, so a single read returns only part of the body.
+  Buffer::InstancePtr chunk = getBodyChunk(*context, 0, body.size());
+  ASSERT_NE(nullptr, chunk);
+  EXPECT_EQ(body.substr(0, 1024), chunk->toString());
+  EXPECT_TRUE(expectLookupSuccessWithBody(context.get(), body));
+}
+
+TEST_F(FileSystemHttpCacheTest, RangeRequest) {
+  insert("/range", "0123456789");
+
+  request_headers_.addCopy(Http::LowerCaseString("range"), "bytes=3-5");
+  LookupContextPtr context = lookup("/range");
+  ASSERT_EQ(CacheEntryStatus::SatisfiableRange, lookup_result_.cache_entry_status_);
+  ASSERT_EQ(1, lookup_result_.response_ranges_.size());
+  const AdjustedByteRange& range = lookup_result_.response_ranges_[0];
+  EXPECT_EQ("345", getBody(*context, range.begin(), range.end()));
+}
+
+TEST_F(FileSystemHttpCacheTest, SurvivesRestart) {
+  insert("/name", "Value");
+  // Simulate a restart by creating a new cache for the same directory.
+  initialize();
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup("/name").get(), "Value"));
+}
+
+TEST_F(FileSystemHttpCacheTest, TooLarge) {
+  config_.mutable_max_entry_size_bytes()->set_value(500);
+  initialize();
+
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/large"));
+  const ResponseMetadata metadata = {time_source_.systemTime()};
+  inserter->insertHeaders(responseHeaders(), metadata, false);
+  absl::Notification first_chunk_written;
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(300, 'a')),
+      [&first_chunk_written](bool ready) {
+        EXPECT_TRUE(ready);
+        first_chunk_written.Notify();
+      },
+      false);
+  first_chunk_written.WaitForNotification();
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(300, 'a')), [](bool ready) { EXPECT_FALSE(ready); }, false);
+  // Further chunks are ignored.
+  inserter->insertBody(Buffer::OwnedImpl("a"), nullptr, true);
+  inserter->onDestroy();
+  waitForWrites();
+
+  lookup("/large");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  EXPECT_EQ(1, counter("inserts_too_large"));
+  EXPECT_EQ(0, counter("inserts"));
+}
+
+TEST_F(FileSystemHttpCacheTest, AbandonedInsertIsDiscarded) {
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/abandoned"));
+  const ResponseMetadata metadata = {time_source_.systemTime()};
+  inserter->insertHeaders(responseHeaders(), metadata, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl("partial"), [](bool) {}, false);
+  inserter->onDestroy();
+  waitForWrites();
+
+  lookup("/abandoned");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  // No temporary files are left behind.
+  EXPECT_TRUE(cacheFiles().empty());
+}
+
+TEST_F(FileSystemHttpCacheTest, StaleTempFilesAreRemoved) {
+  insert("/name", "Value");
+  const std::string entry = cacheFiles()[0];
+  // Written by an earlier process with our pid.
+  const std::string own_pid =
+      absl::StrCat(cache_path_, "/cache-0000000000000001.", ::getpid(), ".1.0.tmp");
+  // Written by a process which is no longer running.
+  const std::string exited = absl::StrCat(cache_path_, "/cache-0000000000000002.99999999.1.0.tmp");
+  // Written by a process which is still running, e.g. during a hot restart.
+  const std::string running =
+      absl::StrCat(cache_path_, "/cache-0000000000000003.", ::getppid(), ".1.0.tmp");
+  const std::string unrelated = absl::StrCat(cache_path_, "/unrelated.1.1.0.tmp");
+  for (const std::string& file : {own_pid, exited, running, unrelated}) {
+    std::ofstream(file) << "partial";
+  }
+
+  // Restarting the cache removes the stale files once its queued work has run.
+  initialize();
+  waitForWrites();
+  std::vector<std::string> files = cacheFiles();
+  std::sort(files.begin(), files.end());
+  std::vector<std::string> expected = {entry, running, unrelated};
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(expected, files);
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup("/name").get(), "Value"));
+}
+
+TEST_F(FileSystemHttpCacheTest, CorruptEntryIsAMiss) {
+  insert("/name", "Value");
+  const std::vector<std::string> files = cacheFiles();
+  ASSERT_EQ(1, files.size());
+  for (const std::string& file : files) {
+    std::ofstream(file, std::ios::trunc) << "garbage";
+  }
+  lookup("/name");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+}
+
+TEST_F(FileSystemHttpCacheTest, UpdateHeaders) {
+  insert("/name", "Value");
+  Http::TestResponseHeaderMapImpl new_headers{{"date", "Thu, 01 Jan 1970 00:00:00 GMT"},
+                                              {"cache-control", "public,max-age=3600"},
+                                              {"new-header", "new"}};
+  LookupContextPtr context = lookup("/name");
+  cache_->updateHeaders(*context, new_headers, {time_source_.systemTime()});
+  context->onDestroy();
+  context.reset();
+  waitForWrites();
+  EXPECT_EQ(1, counter("header_updates"));
+
+  context = lookup("/name");
+  ASSERT_NE(nullptr, lookup_result_.headers_);
+  EXPECT_EQ("new", lookup_result_.headers_->get(Http::LowerCaseString("new-header"))[0]
+                       ->value()
+                       .getStringView());
+  EXPECT_TRUE(expectLookupSuccessWithBody(context.get(), "Value"));
+}
+
+TEST_F(FileSystemHttpCacheTest, VaryResponses) {
+  // Responses will vary on accept.
+  const std::string RequestPath("some-resource");
+  Http::TestResponseHeaderMapImpl response_headers = responseHeaders();
+  response_headers.setCopy(Http::LowerCaseString("vary"), "accept");
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  LookupContextPtr first_value_vary = lookup(RequestPath);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  insert(move(first_value_vary), response_headers, "accept is image/*");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is image/*"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  LookupContextPtr second_value_vary = lookup(RequestPath);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  insert(move(second_value_vary), response_headers, "accept is text/html");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is text/html"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is image/*"));
+}
+
+TEST(Registration, GetFactory) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.file_system_http_cache.v3.FileSystemHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig fs_config;
+  fs_config.set_cache_path("/cache");
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(fs_config);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ON_CALL(factory_context.api_, threadFactory())
+      .WillByDefault(ReturnRef(Thread::threadFactoryForTest()));
+  EXPECT_CALL(factory_context.api_.file_system_, directoryExists(fs_config.cache_path()))
+      .WillRepeatedly(Return(true));
+  HttpCacheSharedPtr cache = factory->getCache(config, factory_context);
+  EXPECT_EQ(cache->cacheInfo().name_, "envoy.extensions.http.cache.file_system");
+  EXPECT_TRUE(cache->cacheInfo().supports_range_requests_);
+
+  // Configs with the same cache_path share the cache.
+  EXPECT_EQ(cache, factory->getCache(config, factory_context));
+
+  fs_config.set_cache_path("/does_not_exist");
+  config.mutable_typed_config()->PackFrom(fs_config);
+  EXPECT_THROW_WITH_MESSAGE(factory->getCache(config, factory_context), EnvoyException,
+                            "file system http cache: cache_path '/does_not_exist' is not a "
+                            "directory");
+}
+
+TEST(Registration, ConflictingConfigsForCachePath) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.file_system_http_cache.v3.FileSystemHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::cache::file_system_http_cache::v3::FileSystemHttpCacheConfig fs_config;
+  fs_config.set_cache_path("/cache");
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(fs_config);
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  ON_CALL(factory_context.api_, threadFactory())
+      .WillByDefault(ReturnRef(Thread::threadFactoryForTest()));
+  ON_CALL(factory_context.api_.file_system_, directoryExists(_)).WillByDefault(Return(true));
+  HttpCacheSharedPtr cache = factory->getCache(config, factory_context);
+
+  fs_config.set_cache_path("/other_cache");
+  config.mutable_typed_config()->PackFrom(fs_config);
+  EXPECT_NE(cache, factory->getCache(config, factory_context));
+
+  fs_config.set_cache_path("/cache");
+  fs_config.mutable_thread_count()->set_value(1);
+  config.mutable_typed_config()->PackFrom(fs_config);
+  EXPECT_THROW_WITH_MESSAGE(factory->getCache(config, factory_context), EnvoyException,
+                            "file system http cache: cache_path '/cache' is configured with "
+                            "different settings");
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
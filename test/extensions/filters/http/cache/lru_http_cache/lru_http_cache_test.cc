@@ -0,0 +1,312 @@
+#include "envoy/extensions/cache/lru_http_cache/v3/config.pb.h"
+#include "envoy/http/header_map.h"
+#include "envoy/registry/registry.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/http/cache/cache_headers_utils.h"
+#include "source/extensions/filters/http/cache/lru_http_cache/lru_http_cache.h"
+
+#include "test/common/stats/stat_test_utility.h"
+#include "test/extensions/filters/http/cache/common.h"
+#include "test/mocks/server/factory_context.h"
+#include "test/test_common/simulated_time_system.h"
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Cache {
+namespace {
+
+using testing::NiceMock;
+
+envoy::extensions::filters::http::cache::v3::CacheConfig getConfig() {
+  // Allows 'accept' to be varied in the tests.
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  const auto& add_accept = config.mutable_allowed_vary_headers()->Add();
+  add_accept->set_exact("accept");
+  return config;
+}
+
+envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig
+lruConfig(uint64_t max_size_bytes, uint32_t shards) {
+  envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig config;
+  config.mutable_max_size_bytes()->set_value(max_size_bytes);
+  config.mutable_shards()->set_value(shards);
+  return config;
+}
+
+class LruHttpCacheTest : public testing::Test {
+protected:
+  LruHttpCacheTest() : vary_allow_list_(getConfig().allowed_vary_headers()) {
+    request_headers_.setMethod("GET");
+    request_headers_.setHost("example.com");
+    request_headers_.setScheme("https");
+    request_headers_.setCopy(Http::CustomHeaders::get().CacheControl, "max-age=3600");
+    initialize(lruConfig(1024 * 1024, 4));
+  }
+
+  void initialize(const envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig& config) {
+    cache_ = std::make_unique<LruHttpCache>(config, store_);
+  }
+
+  // Performs a cache lookup.
+  LookupContextPtr lookup(absl::string_view request_path) {
+    LookupRequest request = makeLookupRequest(request_path);
+    LookupContextPtr context = cache_->makeLookupContext(std::move(request));
+    context->getHeaders([this](LookupResult&& result) { lookup_result_ = std::move(result); });
+    return context;
+  }
+
+  // Inserts a value into the cache.
+  void insert(LookupContextPtr lookup, const Http::TestResponseHeaderMapImpl& response_headers,
+              const absl::string_view response_body) {
+    InsertContextPtr inserter = cache_->makeInsertContext(move(lookup));
+    const ResponseMetadata metadata = {time_source_.systemTime()};
+    inserter->insertHeaders(response_headers, metadata, false);
+    inserter->insertBody(Buffer::OwnedImpl(response_body), nullptr, true);
+  }
+
+  void insert(absl::string_view request_path, absl::string_view response_body) {
+    insert(lookup(request_path), responseHeaders(), response_body);
+  }
+
+  Http::TestResponseHeaderMapImpl responseHeaders() {
+    return Http::TestResponseHeaderMapImpl{
+        {"date", formatter_.fromTime(time_source_.systemTime())},
+        {"cache-control", "public,max-age=3600"}};
+  }
+
+  std::string getBody(LookupContext& context, uint64_t start, uint64_t end) {
+    AdjustedByteRange range(start, end);
+    std::string body;
+    context.getBody(range, [&body](Buffer::InstancePtr&& data) {
+      EXPECT_NE(data, nullptr);
+      if (data) {
+        body = data->toString();
+      }
+    });
+    return body;
+  }
+
+  LookupRequest makeLookupRequest(absl::string_view request_path) {
+    request_headers_.setPath(request_path);
+    return LookupRequest(request_headers_, time_source_.systemTime(), vary_allow_list_);
+  }
+
+  AssertionResult expectLookupSuccessWithBody(LookupContext* lookup_context,
+                                              absl::string_view body) {
+    if (lookup_result_.cache_entry_status_ != CacheEntryStatus::Ok) {
+      return AssertionFailure() << "Expected: lookup_result_.cache_entry_status == "
+                                   "CacheEntryStatus::Ok\n  Actual: "
+                                << lookup_result_.cache_entry_status_;
+    }
+    if (!lookup_result_.headers_) {
+      return AssertionFailure() << "Expected nonnull lookup_result_.headers";
+    }
+    if (!lookup_context) {
+      return AssertionFailure() << "Expected nonnull lookup_context";
+    }
+    const std::string actual_body = getBody(*lookup_context, 0, body.size());
+    if (body != actual_body) {
+      return AssertionFailure() << "Expected body == " << body << "\n  Actual:  " << actual_body;
+    }
+    return AssertionSuccess();
+  }
+
+  uint64_t entries() {
+    return store_.gauge("http_cache.lru.entries", Stats::Gauge::ImportMode::Accumulate).value();
+  }
+
+  Stats::TestUtil::TestStore store_;
+  std::unique_ptr<LruHttpCache> cache_;
+  LookupResult lookup_result_;
+  Http::TestRequestHeaderMapImpl request_headers_;
+  Event::SimulatedTimeSystem time_source_;
+  DateFormatter formatter_{"%a, %d %b %Y %H:%M:%S GMT"};
+  VaryAllowList vary_allow_list_;
+};
+
+TEST_F(LruHttpCacheTest, PutGet) {
+  const std::string request_path("/name");
+  LookupContextPtr name_lookup_context = lookup(request_path);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+
+  insert(move(name_lookup_context), responseHeaders(), "Value");
+  name_lookup_context = lookup(request_path);
+  EXPECT_TRUE(expectLookupSuccessWithBody(name_lookup_context.get(), "Value"));
+  EXPECT_EQ("alu", getBody(*name_lookup_context, 1, 4));
+
+  insert(move(name_lookup_context), responseHeaders(), "NewValue");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(request_path).get(), "NewValue"));
+
+  EXPECT_EQ(2, store_.counter("http_cache.lru.lookup_hits").value());
+  EXPECT_EQ(1, store_.counter("http_cache.lru.lookup_misses").value());
+  EXPECT_EQ(2, store_.counter("http_cache.lru.inserts").value());
+  EXPECT_EQ(1, entries());
+  EXPECT_LT(8, store_.gauge("http_cache.lru.bytes_resident", Stats::Gauge::ImportMode::Accumulate)
+                   .value());
+}
+
+TEST_F(LruHttpCacheTest, EvictsLeastRecentlyUsed) {
+  // A single shard with room for roughly two entries.
+  initialize(lruConfig(2500, 1));
+  const std::string body(1000, 'a');
+
+  insert("/a", body);
+  insert("/b", body);
+  // Touch /a so that /b is the least recently used entry.
+  lookup("/a");
+  insert("/c", body);
+
+  EXPECT_EQ(1, store_.counter("http_cache.lru.evictions").value());
+  EXPECT_EQ(2, entries());
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup("/a").get(), body));
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup("/c").get(), body));
+  lookup("/b");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+}
+
+TEST_F(LruHttpCacheTest, BodyOutlivesEviction) {
+  initialize(lruConfig(2500, 1));
+  const std::string body(1000, 'a');
+
+  insert("/a", body);
+  LookupContextPtr a_context = lookup("/a");
+  EXPECT_EQ(CacheEntryStatus::Ok, lookup_result_.cache_entry_status_);
+
+  // Evict /a while its lookup is still in flight.
+  insert("/b", body);
+  insert("/c", body);
+  EXPECT_LE(1, store_.counter("http_cache.lru.evictions").value());
+
+  Buffer::InstancePtr buffer;
+  a_context->getBody(AdjustedByteRange(0, body.size()),
+                     [&buffer](Buffer::InstancePtr&& data) { buffer = std::move(data); });
+  // Evict everything, then check the previously returned buffer is still intact.
+  insert("/d", body);
+  insert("/e", body);
+  ASSERT_NE(nullptr, buffer);
+  EXPECT_EQ(body, buffer->toString());
+}
+
+TEST_F(LruHttpCacheTest, TooLarge) {
+  envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig config = lruConfig(10000, 1);
+  config.mutable_max_entry_size_bytes()->set_value(500);
+  initialize(config);
+
+  InsertContextPtr inserter = cache_->makeInsertContext(lookup("/large"));
+  const ResponseMetadata metadata = {time_source_.systemTime()};
+  inserter->insertHeaders(responseHeaders(), metadata, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(300, 'a')), [](bool ready) { EXPECT_TRUE(ready); }, false);
+  inserter->insertBody(
+      Buffer::OwnedImpl(std::string(300, 'a')), [](bool ready) { EXPECT_FALSE(ready); }, false);
+  // Further chunks are ignored.
+  inserter->insertBody(Buffer::OwnedImpl("a"), nullptr, true);
+
+  lookup("/large");
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  EXPECT_EQ(1, store_.counter("http_cache.lru.inserts_too_large").value());
+  EXPECT_EQ(0, store_.counter("http_cache.lru.inserts").value());
+}
+
+TEST_F(LruHttpCacheTest, StatPrefix) {
+  envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig config = lruConfig(4096, 1);
+  config.set_stat_prefix("small");
+  initialize(config);
+  insert("/a", "body");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup("/a").get(), "body"));
+
+  EXPECT_EQ(1, store_.counter("http_cache.lru.small.inserts").value());
+  EXPECT_EQ(1, store_.counter("http_cache.lru.small.lookup_hits").value());
+  EXPECT_EQ(0, store_.counter("http_cache.lru.inserts").value());
+  EXPECT_EQ(0, store_.counter("http_cache.lru.lookup_hits").value());
+}
+
+TEST_F(LruHttpCacheTest, Sharded) {
+  initialize(lruConfig(1024 * 1024, 8));
+  EXPECT_EQ(8, cache_->shardCount());
+  for (int i = 0; i < 100; ++i) {
+    insert(absl::StrCat("/", i), absl::StrCat("body", i));
+  }
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_TRUE(
+        expectLookupSuccessWithBody(lookup(absl::StrCat("/", i)).get(), absl::StrCat("body", i)));
+  }
+  EXPECT_EQ(100, entries());
+}
+
+TEST_F(LruHttpCacheTest, UpdateHeaders) {
+  insert("/name", "Value");
+  Http::TestResponseHeaderMapImpl new_headers{{"date", "Thu, 01 Jan 1970 00:00:00 GMT"},
+                                              {"cache-control", "public,max-age=3600"},
+                                              {"new-header", "new"}};
+  LookupContextPtr context = lookup("/name");
+  cache_->updateHeaders(*context, new_headers, {time_source_.systemTime()});
+
+  lookup("/name");
+  ASSERT_NE(nullptr, lookup_result_.headers_);
+  EXPECT_EQ("new", lookup_result_.headers_->get(Http::LowerCaseString("new-header"))[0]
+                       ->value()
+                       .getStringView());
+}
+
+TEST_F(LruHttpCacheTest, VaryResponses) {
+  // Responses will vary on accept.
+  const std::string RequestPath("some-resource");
+  Http::TestResponseHeaderMapImpl response_headers = responseHeaders();
+  response_headers.setCopy(Http::LowerCaseString("vary"), "accept");
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  LookupContextPtr first_value_vary = lookup(RequestPath);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  insert(move(first_value_vary), response_headers, "accept is image/*");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is image/*"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "text/html");
+  LookupContextPtr second_value_vary = lookup(RequestPath);
+  EXPECT_EQ(CacheEntryStatus::Unusable, lookup_result_.cache_entry_status_);
+  insert(move(second_value_vary), response_headers, "accept is text/html");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is text/html"));
+
+  request_headers_.setCopy(Http::LowerCaseString("accept"), "image/*");
+  EXPECT_TRUE(expectLookupSuccessWithBody(lookup(RequestPath).get(), "accept is image/*"));
+}
+
+TEST(Registration, GetFactory) {
+  HttpCacheFactory* factory = Registry::FactoryRegistry<HttpCacheFactory>::getFactoryByType(
+      "envoy.extensions.cache.lru_http_cache.v3.LruHttpCacheConfig");
+  ASSERT_NE(factory, nullptr);
+  envoy::extensions::filters::http::cache::v3::CacheConfig config;
+  config.mutable_typed_config()->PackFrom(lruConfig(4096, 2));
+  NiceMock<Server::Configuration::MockFactoryContext> factory_context;
+  HttpCacheSharedPtr cache = factory->getCache(config, factory_context);
+  EXPECT_EQ(cache->cacheInfo().name_, "envoy.extensions.http.cache.lru");
+  EXPECT_EQ(2, dynamic_cast<LruHttpCache&>(*cache).shardCount());
+
+  // Filter configs with the same settings share the cache, as long as one of them uses it.
+  EXPECT_EQ(cache, factory->getCache(config, factory_context));
+  config.mutable_typed_config()->PackFrom(lruConfig(4096, 4));
+  HttpCacheSharedPtr other_cache = factory->getCache(config, factory_context);
+  EXPECT_NE(cache, other_cache);
+  EXPECT_EQ(4, dynamic_cast<LruHttpCache&>(*other_cache).shardCount());
+  std::weak_ptr<HttpCache> weak_other_cache = other_cache;
+  other_cache.reset();
+  EXPECT_TRUE(weak_other_cache.expired());
+
+  // The stat prefix is part of the settings.
+  envoy::extensions::cache::lru_http_cache::v3::LruHttpCacheConfig prefixed_config =
+      lruConfig(4096, 2);
+  prefixed_config.set_stat_prefix("prefixed");
+  config.mutable_typed_config()->PackFrom(prefixed_config);
+  EXPECT_NE(cache, factory->getCache(config, factory_context));
+}
+
+} // namespace
+} // namespace Cache
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
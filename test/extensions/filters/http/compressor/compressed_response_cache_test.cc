@@ -0,0 +1,69 @@
+#include "source/common/buffer/buffer_impl.h"
+#include "source/extensions/filters/http/compressor/compressed_response_cache.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace HttpFilters {
+namespace Compressor {
+namespace {
+
+CompressedResponseCache::EntryConstSharedPtr makeEntry(const std::string& body) {
+  return std::make_shared<const CompressedResponseCache::Entry>(std::string(body),
+                                                                body.size() * 2);
+}
+
+TEST(CompressedResponseCacheTest, InsertAndLookup) {
+  CompressedResponseCache cache(1024, 512);
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  EXPECT_EQ(0, cache.insert("a", makeEntry("body")));
+  auto entry = cache.lookup("a");
+  ASSERT_NE(nullptr, entry);
+  EXPECT_EQ("body", entry->body_);
+  EXPECT_EQ(8, entry->uncompressed_length_);
+  EXPECT_EQ(5, cache.sizeBytes());
+
+  // Inserting the same key replaces the entry.
+  EXPECT_EQ(0, cache.insert("a", makeEntry("other body")));
+  EXPECT_EQ("other body", cache.lookup("a")->body_);
+  EXPECT_EQ(11, cache.sizeBytes());
+  // The replaced entry stays valid for its users.
+  EXPECT_EQ("body", entry->body_);
+}
+
+TEST(CompressedResponseCacheTest, EvictsLeastRecentlyUsed) {
+  CompressedResponseCache cache(30, 30);
+  EXPECT_EQ(0, cache.insert("a", makeEntry(std::string(9, 'a'))));
+  EXPECT_EQ(0, cache.insert("b", makeEntry(std::string(9, 'b'))));
+  EXPECT_EQ(0, cache.insert("c", makeEntry(std::string(9, 'c'))));
+  // Refresh "a", so that "b" is the least recently used entry.
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_EQ(1, cache.insert("d", makeEntry(std::string(9, 'd'))));
+  EXPECT_EQ(nullptr, cache.lookup("b"));
+  EXPECT_NE(nullptr, cache.lookup("a"));
+  EXPECT_NE(nullptr, cache.lookup("c"));
+  EXPECT_NE(nullptr, cache.lookup("d"));
+  EXPECT_EQ(30, cache.sizeBytes());
+
+  // A large entry evicts all the others, but is kept itself.
+  EXPECT_EQ(3, cache.insert("e", makeEntry(std::string(29, 'e'))));
+  EXPECT_NE(nullptr, cache.lookup("e"));
+  EXPECT_EQ(30, cache.sizeBytes());
+}
+
+TEST(CompressedResponseCacheTest, AddBodyOutlivesEviction) {
+  CompressedResponseCache cache(10, 10);
+  cache.insert("a", makeEntry("body"));
+  Buffer::OwnedImpl buffer;
+  CompressedResponseCache::addBody(cache.lookup("a"), buffer);
+  EXPECT_EQ(1, cache.insert("b", makeEntry("other body")));
+  EXPECT_EQ(nullptr, cache.lookup("a"));
+  EXPECT_EQ("body", buffer.toString());
+}
+
+} // namespace
+} // namespace Compressor
+} // namespace HttpFilters
+} // namespace Extensions
+} // namespace Envoy
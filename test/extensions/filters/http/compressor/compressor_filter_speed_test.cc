@@ -1,7 +1,9 @@
 #include "envoy/compression/compressor/factory.h"
 #include "envoy/extensions/filters/http/compressor/v3/compressor.pb.h"
 
+#include "source/extensions/compression/brotli/compressor/brotli_compressor_impl.h"
 #include "source/extensions/compression/gzip/compressor/zlib_compressor_impl.h"
+#include "source/extensions/compression/zstd/compressor/zstd_compressor_impl.h"
 #include "source/extensions/filters/http/compressor/compressor_filter.h"
 
 #include "test/mocks/http/mocks.h"
@@ -45,6 +47,26 @@ private:
   const uint64_t memory_level_;
 };
 
+// Creates compressors of any codec, so that the codecs can be compared with each other.
+class CodecCompressorFactory : public Envoy::Compression::Compressor::CompressorFactory {
+public:
+  using CreateCompressorCb = std::function<Envoy::Compression::Compressor::CompressorPtr()>;
+
+  CodecCompressorFactory(const std::string& content_encoding, CreateCompressorCb create_compressor)
+      : content_encoding_(content_encoding), create_compressor_(create_compressor) {}
+
+  Envoy::Compression::Compressor::CompressorPtr createCompressor() override {
+    return create_compressor_();
+  }
+
+  const std::string& statsPrefix() const override { CONSTRUCT_ON_FIRST_USE(std::string, "test."); }
+  const std::string& contentEncoding() const override { return content_encoding_; }
+
+private:
+  const std::string content_encoding_;
+  const CreateCompressorCb create_compressor_;
+};
+
 using CompressionParams =
     std::tuple<Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel,
                Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy, int64_t,
@@ -89,20 +111,17 @@ struct Result {
   uint64_t total_compressed_bytes = 0;
 };
 
-static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionParams params,
-                           NiceMock<Http::MockStreamDecoderFilterCallbacks>& decoder_callbacks,
-                           benchmark::State& state) {
+static Result
+compressWith(std::vector<Buffer::OwnedImpl>&& chunks,
+             Envoy::Compression::Compressor::CompressorFactoryPtr compressor_factory,
+             NiceMock<Http::MockStreamDecoderFilterCallbacks>& decoder_callbacks,
+             benchmark::State& state) {
   auto start = std::chrono::high_resolution_clock::now();
   Stats::IsolatedStoreImpl stats;
   testing::NiceMock<Runtime::MockLoader> runtime;
   envoy::extensions::filters::http::compressor::v3::Compressor compressor;
 
-  const auto level = std::get<0>(params);
-  const auto strategy = std::get<1>(params);
-  const auto window_bits = std::get<2>(params);
-  const auto memory_level = std::get<3>(params);
-  Envoy::Compression::Compressor::CompressorFactoryPtr compressor_factory =
-      std::make_unique<MockCompressorFactory>(level, strategy, window_bits, memory_level);
+  const std::string accept_encoding = compressor_factory->contentEncoding();
   CompressorFilterConfigSharedPtr config = std::make_shared<CompressorFilterConfig>(
       compressor, "test.", stats, runtime, std::move(compressor_factory));
 
@@ -112,7 +131,8 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
   auto filter = std::make_unique<CompressorFilter>(config);
   filter->setDecoderFilterCallbacks(decoder_callbacks);
 
-  Http::TestRequestHeaderMapImpl headers = {{":method", "get"}, {"accept-encoding", "gzip"}};
+  Http::TestRequestHeaderMapImpl headers = {{":method", "get"},
+                                            {"accept-encoding", accept_encoding}};
   filter->decodeHeaders(headers, false);
 
   Http::TestResponseHeaderMapImpl response_headers = {
@@ -149,6 +169,19 @@ static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionP
   return res;
 }
 
+static Result compressWith(std::vector<Buffer::OwnedImpl>&& chunks, CompressionParams params,
+                           NiceMock<Http::MockStreamDecoderFilterCallbacks>& decoder_callbacks,
+                           benchmark::State& state) {
+  const auto level = std::get<0>(params);
+  const auto strategy = std::get<1>(params);
+  const auto window_bits = std::get<2>(params);
+  const auto memory_level = std::get<3>(params);
+  return compressWith(
+      std::move(chunks),
+      std::make_unique<MockCompressorFactory>(level, strategy, window_bits, memory_level),
+      decoder_callbacks, state);
+}
+
 // SPELLCHECKER(off)
 /*
 Running ./bazel-bin/test/extensions/filters/http/common/compressor/compressor_filter_speed_test
@@ -289,6 +322,67 @@ static void compressChunks1024(benchmark::State& state) {
 }
 BENCHMARK(compressChunks1024)->DenseRange(0, 8, 1)->UseManualTime()->Unit(benchmark::kMillisecond);
 
+// Each codec with the defaults of its compressor extension.
+static Envoy::Compression::Compressor::CompressorFactoryPtr codecCompressorFactory(int64_t codec) {
+  switch (codec) {
+  case 0:
+    return std::make_unique<CodecCompressorFactory>(
+        Http::CustomHeaders::get().ContentEncodingValues.Gzip, []() {
+          auto compressor = std::make_unique<Compression::Gzip::Compressor::ZlibCompressorImpl>();
+          compressor->init(
+              Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionLevel::Standard,
+              Compression::Gzip::Compressor::ZlibCompressorImpl::CompressionStrategy::Standard, 28,
+              5);
+          return compressor;
+        });
+  case 1:
+    return std::make_unique<CodecCompressorFactory>(
+        Http::CustomHeaders::get().ContentEncodingValues.Brotli, []() {
+          return std::make_unique<Compression::Brotli::Compressor::BrotliCompressorImpl>(
+              3, 18, 24, false,
+              Compression::Brotli::Compressor::BrotliCompressorImpl::EncoderMode::Default, 4096);
+        });
+  case 2:
+    return std::make_unique<CodecCompressorFactory>(
+        Http::CustomHeaders::get().ContentEncodingValues.Zstd, []() {
+          return std::make_unique<Compression::Zstd::Compressor::ZstdCompressorImpl>(
+              ZSTD_CLEVEL_DEFAULT, 0, false, nullptr, 4096);
+        });
+  }
+  NOT_REACHED_GCOVR_EXCL_LINE;
+}
+
+static void compressCodecFull(benchmark::State& state) {
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  const auto codec = state.range(0);
+
+  for (auto _ : state) {
+    std::vector<Buffer::OwnedImpl> chunks = generateChunks(1, 122880);
+    const Result res =
+        compressWith(std::move(chunks), codecCompressorFactory(codec), decoder_callbacks, state);
+    state.counters["ratio"] =
+        static_cast<double>(res.total_uncompressed_bytes) / res.total_compressed_bytes;
+  }
+}
+BENCHMARK(compressCodecFull)->DenseRange(0, 2, 1)->UseManualTime()->Unit(benchmark::kMillisecond);
+
+static void compressCodecChunks4096(benchmark::State& state) {
+  NiceMock<Http::MockStreamDecoderFilterCallbacks> decoder_callbacks;
+  const auto codec = state.range(0);
+
+  for (auto _ : state) {
+    std::vector<Buffer::OwnedImpl> chunks = generateChunks(30, 4096);
+    const Result res =
+        compressWith(std::move(chunks), codecCompressorFactory(codec), decoder_callbacks, state);
+    state.counters["ratio"] =
+        static_cast<double>(res.total_uncompressed_bytes) / res.total_compressed_bytes;
+  }
+}
+BENCHMARK(compressCodecChunks4096)
+    ->DenseRange(0, 2, 1)
+    ->UseManualTime()
+    ->Unit(benchmark::kMillisecond);
+
 } // namespace Compressor
 } // namespace HttpFilters
 } // namespace Extensions
@@ -379,6 +379,166 @@ TEST_F(CompressorFilterTest, RemoveAcceptEncodingHeader) {
   }
 }
 
+// Verify that the accept-encoding header is restricted to the encodings of the filter chain when
+// pre-compressed upstream responses are allowed.
+TEST_F(CompressorFilterTest, RestrictAcceptEncodingHeader) {
+  const std::string config = R"EOF(
+{
+  "response_direction_config": {
+    "remove_accept_encoding_header": true,
+    "allow_precompressed_upstream_response": true
+  },
+  "compressor_library": {
+     "typed_config": {
+       "@type": "type.googleapis.com/envoy.extensions.compression.gzip.compressor.v3.Gzip"
+     }
+  }
+}
+)EOF";
+  {
+    Http::TestRequestHeaderMapImpl headers = {{"accept-encoding", "deflate, Test;q=0.5 , gzip, *"}};
+    setUpFilter(std::string(config));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+    EXPECT_EQ("Test;q=0.5", headers.get_("accept-encoding"));
+  }
+  {
+    Http::TestRequestHeaderMapImpl headers = {{"accept-encoding", "deflate, gzip, br"}};
+    setUpFilter(std::string(config));
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(headers, true));
+    EXPECT_FALSE(headers.has("accept-encoding"));
+  }
+}
+
+// Verify that responses pre-compressed by the upstream are passed through.
+TEST_F(CompressorFilterTest, PrecompressedUpstreamResponse) {
+  setUpFilter(R"EOF(
+{
+  "response_direction_config": {
+    "remove_accept_encoding_header": true,
+    "allow_precompressed_upstream_response": true
+  },
+  "compressor_library": {
+     "typed_config": {
+       "@type": "type.googleapis.com/envoy.extensions.compression.gzip.compressor.v3.Gzip"
+     }
+  }
+}
+)EOF");
+  response_stats_prefix_ = "response.";
+  Http::TestRequestHeaderMapImpl request_headers{{":method", "get"}, {"accept-encoding", "test"}};
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+  EXPECT_EQ("test", request_headers.get_("accept-encoding"));
+
+  Http::TestResponseHeaderMapImpl headers{{":status", "200"},
+                                          {"content-length", "256"},
+                                          {"content-encoding", "test"},
+                                          {"etag", "\"abc\""}};
+  populateBuffer(256);
+  EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+  EXPECT_EQ("256", headers.get_("content-length"));
+  EXPECT_EQ("\"abc\"", headers.get_("etag"));
+  EXPECT_EQ("Accept-Encoding", headers.get_("vary"));
+  EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data_, true));
+  EXPECT_EQ(expected_str_, data_.toString());
+  EXPECT_EQ(1, stats_.counter("test.compressor.test.test.precompressed_upstream_response").value());
+  EXPECT_EQ(1, stats_.counter("test.compressor.test.test.response.not_compressed").value());
+}
+
+class CompressedResponseCacheTest : public CompressorFilterTest {
+public:
+  void SetUp() override {
+    setUpFilter(R"EOF(
+{
+  "response_direction_config": {
+    "compressed_response_cache": {
+      "max_size_bytes": 1048576
+    }
+  },
+  "compressor_library": {
+     "typed_config": {
+       "@type": "type.googleapis.com/envoy.extensions.compression.gzip.compressor.v3.Gzip"
+     }
+  }
+}
+)EOF");
+    response_stats_prefix_ = "response.";
+  }
+
+  // Sends a request and a response through a new filter instance sharing the config and returns
+  // the response body after the filter.
+  std::string doCachedResponse(const std::string& etag, uint64_t content_length,
+                               bool with_trailers = false) {
+    filter_ = std::make_unique<CompressorFilter>(config_);
+    filter_->setDecoderFilterCallbacks(decoder_callbacks_);
+    filter_->setEncoderFilterCallbacks(encoder_callbacks_);
+    Http::TestRequestHeaderMapImpl request_headers{{":method", "GET"},
+                                                   {":authority", "example.com"},
+                                                   {":path", "/app.js"},
+                                                   {"accept-encoding", "test"}};
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->decodeHeaders(request_headers, true));
+
+    Http::TestResponseHeaderMapImpl headers{{":status", "200"},
+                                            {"content-length", absl::StrCat(content_length)},
+                                            {"etag", etag}};
+    populateBuffer(content_length);
+    EXPECT_EQ(Http::FilterHeadersStatus::Continue, filter_->encodeHeaders(headers, false));
+    EXPECT_EQ("test", headers.get_("content-encoding"));
+    EXPECT_EQ(Http::FilterDataStatus::Continue, filter_->encodeData(data_, !with_trailers));
+    if (with_trailers) {
+      EXPECT_CALL(encoder_callbacks_, addEncodedData(_, true))
+          .WillOnce(Invoke([&](Buffer::Instance& data, bool) { data_.move(data); }));
+      Http::TestResponseTrailerMapImpl trailers;
+      EXPECT_EQ(Http::FilterTrailersStatus::Continue, filter_->encodeTrailers(trailers));
+    }
+    return data_.toString();
+  }
+
+  uint64_t counter(const std::string& name) {
+    return stats_.counter(absl::StrCat("test.compressor.test.test.", name)).value();
+  }
+};
+
+// A compressed response is served from the cache for the same strong etag.
+TEST_F(CompressedResponseCacheTest, Hit) {
+  // The mock compressor leaves the data as is. The response is recorded up to the trailers.
+  compressor_factory_->setExpectedCompressCalls(2);
+  const std::string body = doCachedResponse("\"v1\"", 256, true);
+  EXPECT_EQ(expected_str_, body);
+  EXPECT_EQ(1, counter("compressed_response_cache_miss"));
+
+  compressor_factory_->setExpectedCompressCalls(0);
+  EXPECT_EQ(body, doCachedResponse("\"v1\"", 256));
+  EXPECT_NE(expected_str_, body);
+  EXPECT_EQ(1, counter("compressed_response_cache_hit"));
+  EXPECT_EQ(2, counter("response.compressed"));
+  EXPECT_EQ(512, counter("response.total_uncompressed_bytes"));
+  EXPECT_EQ(512, counter("response.total_compressed_bytes"));
+}
+
+// A different etag or a content length different from the cached response is a miss.
+TEST_F(CompressedResponseCacheTest, Miss) {
+  doCachedResponse("\"v1\"", 256);
+  doCachedResponse("\"v2\"", 256);
+  const std::string body = doCachedResponse("\"v1\"", 300);
+  EXPECT_EQ(expected_str_, body);
+  EXPECT_EQ(3, counter("compressed_response_cache_miss"));
+  EXPECT_EQ(0, counter("compressed_response_cache_hit"));
+
+  // The last response replaced the cached one.
+  compressor_factory_->setExpectedCompressCalls(0);
+  EXPECT_EQ(body, doCachedResponse("\"v1\"", 300));
+  EXPECT_EQ(1, counter("compressed_response_cache_hit"));
+}
+
+// Responses with weak etags are not cached.
+TEST_F(CompressedResponseCacheTest, WeakEtag) {
+  doCachedResponse("W/\"v1\"", 256);
+  doCachedResponse("W/\"v1\"", 256);
+  EXPECT_EQ(0, counter("compressed_response_cache_miss"));
+  EXPECT_EQ(0, counter("compressed_response_cache_hit"));
+  EXPECT_EQ(2, counter("response.compressed"));
+}
+
 class IsAcceptEncodingAllowedTest
     : public CompressorFilterTest,
       public testing::WithParamInterface<std::tuple<std::string, bool, int, int, int, int>> {};
@@ -0,0 +1,182 @@
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <string>
+#include <vector>
+
+#include "source/extensions/io_socket/io_uring/io_uring_impl.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+struct Completion {
+  uint64_t user_data_;
+  int32_t result_;
+  uint32_t flags_;
+};
+
+class IoUringImplTest : public testing::Test {
+protected:
+  void SetUp() override {
+    ring_ = IoUringImpl::create(16);
+    if (ring_ == nullptr) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds_));
+  }
+
+  void TearDown() override {
+    for (const int fd : fds_) {
+      if (fd != -1) {
+        close(fd);
+      }
+    }
+  }
+
+  // Waits until at least count completions have been reaped.
+  std::vector<Completion> waitForCompletions(uint32_t count) {
+    std::vector<Completion> completions;
+    for (int i = 0; i < 1000 && completions.size() < count; ++i) {
+      ring_->forEveryCompletion([&completions](uint64_t user_data, int32_t result, uint32_t flags) {
+        completions.push_back({user_data, result, flags});
+      });
+      if (completions.size() < count) {
+        usleep(1000);
+      }
+    }
+    return completions;
+  }
+
+  IoUringImplPtr ring_;
+  int fds_[2]{-1, -1};
+};
+
+TEST_F(IoUringImplTest, WritevIsBatched) {
+  const std::string first = "hello ";
+  const std::string second = "world";
+  struct iovec iovecs[2] = {{const_cast<char*>(first.data()), first.size()},
+                            {const_cast<char*>(second.data()), second.size()}};
+  ASSERT_TRUE(ring_->prepareWritev(fds_[0], iovecs, 1, 1));
+  ASSERT_TRUE(ring_->prepareWritev(fds_[0], iovecs + 1, 1, 2));
+  EXPECT_EQ(2, ring_->pendingSubmissions());
+  // Both writes are handed to the kernel by a single io_uring_enter().
+  EXPECT_EQ(2, ring_->submit());
+  EXPECT_EQ(0, ring_->pendingSubmissions());
+
+  const std::vector<Completion> completions = waitForCompletions(2);
+  ASSERT_EQ(2, completions.size());
+  for (const Completion& completion : completions) {
+    EXPECT_EQ(completion.user_data_ == 1 ? first.size() : second.size(), completion.result_);
+  }
+  char buf[64];
+  EXPECT_EQ(11, read(fds_[1], buf, sizeof(buf)));
+  EXPECT_EQ("hello world", std::string(buf, 11));
+}
+
+TEST_F(IoUringImplTest, RecvWithProvidedBuffers) {
+  constexpr uint32_t BufferSize = 8;
+  constexpr uint32_t BufferCount = 4;
+  std::vector<char> buffers(BufferSize * BufferCount);
+  ASSERT_TRUE(ring_->prepareProvideBuffers(buffers.data(), BufferSize, BufferCount, 0, 0, 1));
+  ASSERT_TRUE(ring_->prepareRecv(fds_[1], 0, true, 2));
+  ASSERT_EQ(2, ring_->submit());
+
+  ASSERT_EQ(5, write(fds_[0], "hello", 5));
+  std::string received;
+  for (int i = 0; i < 1000 && received.size() < 5; ++i) {
+    ring_->forEveryCompletion([&](uint64_t user_data, int32_t result, uint32_t flags) {
+      if (user_data != 2) {
+        EXPECT_EQ(0, result);
+        return;
+      }
+      ASSERT_GT(result, 0);
+      ASSERT_TRUE(flags & IORING_CQE_F_BUFFER);
+      const uint16_t buffer_id = flags >> IORING_CQE_BUFFER_SHIFT;
+      received.append(buffers.data() + buffer_id * BufferSize, result);
+      if (!(flags & IORING_CQE_F_MORE)) {
+        // Not multishot on this kernel; re-arm.
+        ring_->prepareRecv(fds_[1], 0, true, 2);
+        ring_->submit();
+      }
+    });
+    usleep(1000);
+  }
+  EXPECT_EQ("hello", received);
+
+  ASSERT_TRUE(ring_->prepareCancel(2, 3));
+  ASSERT_EQ(1, ring_->submit());
+}
+
+TEST_F(IoUringImplTest, CancelAllAndWait) {
+  std::vector<char> buffer(8);
+  ASSERT_TRUE(ring_->prepareProvideBuffers(buffer.data(), buffer.size(), 1, 0, 0, 1));
+  ASSERT_TRUE(ring_->prepareRecv(fds_[1], 0, true, 2));
+  ASSERT_TRUE(ring_->preparePollAdd(fds_[1], POLLIN, 3));
+  if (!ring_->prepareCancelAll(4)) {
+    GTEST_SKIP() << "cancelling all requests is not supported";
+  }
+  bool cancelled_all = false;
+  uint32_t done = 0;
+  while (done < 2) {
+    ASSERT_LE(0, ring_->submitAndWait());
+    ring_->forEveryCompletion([&](uint64_t user_data, int32_t result, uint32_t flags) {
+      if (user_data == 4) {
+        cancelled_all = result != -EINVAL;
+        if (!cancelled_all) {
+          ring_->prepareCancel(2, 5);
+          ring_->prepareCancel(3, 5);
+        }
+      } else if (user_data == 2 || user_data == 3) {
+        EXPECT_EQ(-ECANCELED, result);
+        done += (flags & IORING_CQE_F_MORE) ? 0 : 1;
+      }
+    });
+  }
+  // Nothing is received into the buffer once the requests were cancelled.
+  ASSERT_EQ(5, write(fds_[0], "hello", 5));
+  EXPECT_EQ(0, waitForCompletions(1).size());
+}
+
+TEST_F(IoUringImplTest, PollAddAndEventfd) {
+  const int event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  ASSERT_NE(-1, event_fd);
+  ASSERT_TRUE(ring_->registerEventfd(event_fd));
+  ASSERT_TRUE(ring_->preparePollAdd(fds_[1], POLLIN, 7));
+  ASSERT_EQ(1, ring_->submit());
+  ASSERT_EQ(1, write(fds_[0], "x", 1));
+
+  const std::vector<Completion> completions = waitForCompletions(1);
+  ASSERT_EQ(1, completions.size());
+  EXPECT_EQ(7, completions[0].user_data_);
+  EXPECT_TRUE(completions[0].result_ & POLLIN);
+  // The kernel signalled the registered eventfd for the completion.
+  uint64_t value = 0;
+  EXPECT_EQ(sizeof(value), read(event_fd, &value, sizeof(value)));
+  EXPECT_LE(1, value);
+  close(event_fd);
+}
+
+TEST_F(IoUringImplTest, FullQueueIsSubmitted) {
+  const std::string data = "x";
+  struct iovec iovec = {const_cast<char*>(data.data()), data.size()};
+  // More writes than the submission queue can hold.
+  for (uint64_t i = 0; i < 40; ++i) {
+    ASSERT_TRUE(ring_->prepareWritev(fds_[0], &iovec, 1, i));
+  }
+  ring_->submit();
+  EXPECT_EQ(40, waitForCompletions(40).size());
+}
+
+} // namespace
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,237 @@
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+
+#include "envoy/config/core/v3/address.pb.h"
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/socket_interface.h"
+#include "source/extensions/io_socket/io_uring/io_uring_socket_handle_impl.h"
+#include "source/extensions/io_socket/io_uring/io_uring_socket_interface.h"
+#include "source/extensions/io_socket/io_uring/io_uring_worker.h"
+
+#include "test/test_common/utility.h"
+
+#include "gtest/gtest.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace IoSocket {
+namespace IoUring {
+namespace {
+
+class TestWorkerFactory : public IoUringWorkerFactory {
+public:
+  OptRef<IoUringWorker> getIoUringWorker() const override {
+    if (worker_ == nullptr) {
+      return {};
+    }
+    return *worker_;
+  }
+
+  IoUringWorkerSharedPtr worker_;
+};
+
+class IoUringSocketHandleImplTest : public testing::Test {
+protected:
+  IoUringSocketHandleImplTest()
+      : api_(Api::createApiForTest()), dispatcher_(api_->allocateDispatcher("test_thread")) {}
+
+  void SetUp() override {
+    factory_.worker_ = IoUringWorker::create(64, 1024, 8, *dispatcher_);
+    if (factory_.worker_ == nullptr) {
+      GTEST_SKIP() << "io_uring is not available";
+    }
+    int fds[2];
+    ASSERT_EQ(0, socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds));
+    handle_ = std::make_unique<IoUringSocketHandleImpl>(factory_, fds[0]);
+    peer_fd_ = fds[1];
+  }
+
+  void TearDown() override {
+    handle_.reset();
+    if (peer_fd_ != -1) {
+      close(peer_fd_);
+    }
+    factory_.worker_.reset();
+  }
+
+  // Runs the dispatcher until cb was invoked with one of events.
+  uint32_t waitForEvents(uint32_t events) {
+    uint32_t fired = 0;
+    for (int i = 0; i < 1000 && (fired & events) == 0; ++i) {
+      dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+      fired |= fired_events_;
+      fired_events_ = 0;
+      if ((fired & events) == 0) {
+        usleep(1000);
+      }
+    }
+    return fired;
+  }
+
+  void initializeFileEvent(uint32_t events) {
+    handle_->initializeFileEvent(
+        *dispatcher_, [this](uint32_t events) { fired_events_ |= events; },
+        Event::PlatformDefaultTriggerType, events);
+  }
+
+  Api::ApiPtr api_;
+  Event::DispatcherPtr dispatcher_;
+  TestWorkerFactory factory_;
+  std::unique_ptr<IoUringSocketHandleImpl> handle_;
+  int peer_fd_{-1};
+  uint32_t fired_events_{};
+};
+
+TEST_F(IoUringSocketHandleImplTest, ReadReceivedData) {
+  initializeFileEvent(Event::FileReadyType::Read);
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(Api::IoError::IoErrorCode::Again,
+            handle_->read(buffer, absl::nullopt).err_->getErrorCode());
+
+  // More data than fits into one receive buffer.
+  const std::string data(3000, 'a');
+  ASSERT_EQ(data.size(), write(peer_fd_, data.data(), data.size()));
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Read) & Event::FileReadyType::Read);
+  for (int i = 0; i < 100 && buffer.length() < data.size(); ++i) {
+    if (!handle_->read(buffer, absl::nullopt).ok()) {
+      waitForEvents(Event::FileReadyType::Read);
+    }
+  }
+  EXPECT_EQ(data, buffer.toString());
+
+  char peeked[4];
+  ASSERT_EQ(4, write(peer_fd_, "peek", 4));
+  waitForEvents(Event::FileReadyType::Read);
+  EXPECT_EQ(4, handle_->recv(peeked, sizeof(peeked), MSG_PEEK).return_value_);
+  EXPECT_EQ(4, handle_->recv(peeked, sizeof(peeked), 0).return_value_);
+  EXPECT_EQ("peek", std::string(peeked, 4));
+
+  // End of stream.
+  close(peer_fd_);
+  peer_fd_ = -1;
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Read) & Event::FileReadyType::Read);
+  Api::IoCallUint64Result result = handle_->read(buffer, absl::nullopt);
+  EXPECT_TRUE(result.ok());
+  EXPECT_EQ(0, result.return_value_);
+}
+
+// Receiving pauses once the read buffer is full, while the kernel may already have posted more
+// data for the receive. That data is buffered as well rather than dropped.
+TEST_F(IoUringSocketHandleImplTest, NoDataLostWhenReceivePauses) {
+  initializeFileEvent(Event::FileReadyType::Read);
+  std::string data(2 * 1024 * 1024, 0);
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<char>('a' + i % 23);
+  }
+  size_t written = 0;
+  const auto write_some = [&]() {
+    while (written < data.size()) {
+      const ssize_t rc = write(peer_fd_, data.data() + written, data.size() - written);
+      if (rc <= 0) {
+        break;
+      }
+      written += rc;
+    }
+  };
+
+  // Write without reading until receiving paused and the socket is full.
+  for (int i = 0; i < 1000 && written < data.size(); ++i) {
+    write_some();
+    dispatcher_->run(Event::Dispatcher::RunType::NonBlock);
+    usleep(100);
+  }
+  EXPECT_GT(written, 1024UL * 1024);
+
+  Buffer::OwnedImpl buffer;
+  for (int i = 0; i < 10000 && buffer.length() < data.size(); ++i) {
+    write_some();
+    if (!handle_->read(buffer, absl::nullopt).ok()) {
+      waitForEvents(Event::FileReadyType::Read);
+    }
+  }
+  ASSERT_EQ(data.size(), buffer.length());
+  EXPECT_TRUE(buffer.toString() == data);
+}
+
+TEST_F(IoUringSocketHandleImplTest, WriteCompletesAsynchronously) {
+  initializeFileEvent(Event::FileReadyType::Read | Event::FileReadyType::Write);
+  // The connected socket is writable right away.
+  EXPECT_TRUE(waitForEvents(Event::FileReadyType::Write) & Event::FileReadyType::Write);
+
+  Buffer::OwnedImpl first("hello ");
+  EXPECT_EQ(6, handle_->write(first).return_value_);
+  EXPECT_EQ(0, first.length());
+  // Only one write is in flight at a time.
+  Buffer::OwnedImpl second("world");
+  EXPECT_EQ(Api::IoError::IoErrorCode::Again, handle_->write(second).err_->getErrorCode());
+  EXPECT_EQ(5, second.length());
+
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Write) & Event::FileReadyType::Write);
+  EXPECT_EQ(5, handle_->write(second).return_value_);
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Write) & Event::FileReadyType::Write);
+
+  char buf[32];
+  EXPECT_EQ(11, read(peer_fd_, buf, sizeof(buf)));
+  EXPECT_EQ("hello world", std::string(buf, 11));
+}
+
+// A write is reported as written once submitted, so its failure is reported by the next write.
+TEST_F(IoUringSocketHandleImplTest, WriteFailureReportedByNextWrite) {
+  initializeFileEvent(Event::FileReadyType::Write);
+  EXPECT_TRUE(waitForEvents(Event::FileReadyType::Write) & Event::FileReadyType::Write);
+  close(peer_fd_);
+  peer_fd_ = -1;
+
+  Buffer::OwnedImpl first("hello");
+  EXPECT_EQ(5, handle_->write(first).return_value_);
+  EXPECT_EQ(0, first.length());
+
+  // The failed write raises a write event.
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Write) & Event::FileReadyType::Write);
+  Buffer::OwnedImpl second("world");
+  Api::IoCallUint64Result result = handle_->write(second);
+  ASSERT_FALSE(result.ok());
+  EXPECT_EQ(EPIPE, result.err_->getSystemErrorCode());
+  EXPECT_EQ(5, second.length());
+  // The failure is sticky.
+  EXPECT_FALSE(handle_->write(second).ok());
+}
+
+TEST_F(IoUringSocketHandleImplTest, FallBackWithoutWorker) {
+  factory_.worker_.reset();
+  initializeFileEvent(Event::FileReadyType::Read);
+  ASSERT_EQ(2, write(peer_fd_, "hi", 2));
+  ASSERT_TRUE(waitForEvents(Event::FileReadyType::Read) & Event::FileReadyType::Read);
+  Buffer::OwnedImpl buffer;
+  EXPECT_EQ(2, handle_->read(buffer, absl::nullopt).return_value_);
+  EXPECT_EQ("hi", buffer.toString());
+}
+
+TEST(IoUringResolverTest, AttachesSocketInterface) {
+  IoUringResolver resolver;
+  envoy::config::core::v3::SocketAddress socket_address;
+  socket_address.set_address("127.0.0.1");
+  socket_address.set_port_value(10000);
+  Network::Address::InstanceConstSharedPtr address = resolver.resolve(socket_address);
+  EXPECT_EQ("127.0.0.1:10000", address->asString());
+  EXPECT_EQ(Network::socketInterface("envoy.extensions.network.socket_interface.io_uring"),
+            &address->socketInterface());
+
+  socket_address.set_address("::1");
+  address = resolver.resolve(socket_address);
+  EXPECT_EQ("[::1]:10000", address->asString());
+  EXPECT_EQ(Network::socketInterface("envoy.extensions.network.socket_interface.io_uring"),
+            &address->socketInterface());
+
+  socket_address.set_named_port("http");
+  EXPECT_THROW(resolver.resolve(socket_address), EnvoyException);
+}
+
+} // namespace
+} // namespace IoUring
+} // namespace IoSocket
+} // namespace Extensions
+} // namespace Envoy
@@ -0,0 +1,192 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/transport_sockets/tls/ktls.h"
+
+#include "test/test_common/environment.h"
+
+#include "gtest/gtest.h"
+#include "openssl/ssl.h"
+
+namespace Envoy {
+namespace Extensions {
+namespace TransportSockets {
+namespace Tls {
+namespace {
+
+class KernelTlsTest : public testing::Test {
+protected:
+  KernelTlsTest()
+      : server_ctx_(SSL_CTX_new(TLS_method())), client_ctx_(SSL_CTX_new(TLS_method())) {}
+
+  void SetUp() override {
+    const std::string cert_path = TestEnvironment::substitute(
+        "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/san_dns_cert.pem");
+    const std::string key_path = TestEnvironment::substitute(
+        "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/san_dns_key.pem");
+    ASSERT_EQ(1, SSL_CTX_use_certificate_file(server_ctx_.get(), cert_path.c_str(),
+                                              SSL_FILETYPE_PEM));
+    ASSERT_EQ(1,
+              SSL_CTX_use_PrivateKey_file(server_ctx_.get(), key_path.c_str(), SSL_FILETYPE_PEM));
+
+    // Kernel TLS only works on TCP sockets.
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(listener, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addr_len = sizeof(addr);
+    ASSERT_EQ(0, bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len));
+    ASSERT_EQ(0, listen(listener, 1));
+    ASSERT_EQ(0, getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len));
+    client_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_EQ(0, connect(client_fd_, reinterpret_cast<sockaddr*>(&addr), addr_len));
+    server_fd_ = accept(listener, nullptr, nullptr);
+    ASSERT_GE(server_fd_, 0);
+    close(listener);
+    fcntl(client_fd_, F_SETFL, fcntl(client_fd_, F_GETFL) | O_NONBLOCK);
+    fcntl(server_fd_, F_SETFL, fcntl(server_fd_, F_GETFL) | O_NONBLOCK);
+    client_handle_ = std::make_unique<Network::IoSocketHandleImpl>(client_fd_);
+  }
+
+  void TearDown() override {
+    client_handle_.reset();
+    close(server_fd_);
+  }
+
+  void handshake(uint16_t max_version, const char* ciphers) {
+    ASSERT_EQ(1, SSL_CTX_set_max_proto_version(client_ctx_.get(), max_version));
+    ASSERT_EQ(1, SSL_CTX_set_strict_cipher_list(client_ctx_.get(), ciphers));
+    server_ssl_.reset(SSL_new(server_ctx_.get()));
+    SSL_set_fd(server_ssl_.get(), server_fd_);
+    SSL_set_accept_state(server_ssl_.get());
+    client_ssl_.reset(SSL_new(client_ctx_.get()));
+    SSL_set_fd(client_ssl_.get(), client_fd_);
+    SSL_set_connect_state(client_ssl_.get());
+
+    for (int i = 0; i < 50; i++) {
+      const int client_rc = SSL_do_handshake(client_ssl_.get());
+      const int server_rc = SSL_do_handshake(server_ssl_.get());
+      if (client_rc == 1 && server_rc == 1) {
+        return;
+      }
+    }
+    FAIL() << "handshake did not complete";
+  }
+
+  // Reads and decrypts everything the client sent so far on the server side.
+  std::string serverRead() {
+    std::string result;
+    char buf[16384];
+    for (int i = 0; i < 1000; i++) {
+      const int rc = SSL_read(server_ssl_.get(), buf, sizeof(buf));
+      if (rc > 0) {
+        result.append(buf, rc);
+        continue;
+      }
+      if (SSL_get_error(server_ssl_.get(), rc) != SSL_ERROR_WANT_READ || !result.empty()) {
+        break;
+      }
+      usleep(1000);
+    }
+    return result;
+  }
+
+  bssl::UniquePtr<SSL_CTX> server_ctx_;
+  bssl::UniquePtr<SSL_CTX> client_ctx_;
+  bssl::UniquePtr<SSL> server_ssl_;
+  bssl::UniquePtr<SSL> client_ssl_;
+  int client_fd_{-1};
+  int server_fd_{-1};
+  std::unique_ptr<Network::IoSocketHandleImpl> client_handle_;
+};
+
+TEST_F(KernelTlsTest, Tls12AesGcmIsOffloaded) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  // Records encrypted by BoringSSL before the offload continue the same sequence.
+  ASSERT_EQ(5, SSL_write(client_ssl_.get(), "hello", 5));
+  EXPECT_EQ("hello", serverRead());
+
+  if (!enableKernelTlsTransmit(client_ssl_.get(), *client_handle_)) {
+    GTEST_SKIP() << "kernel TLS is not supported";
+  }
+  const std::string data(100000, 'a');
+  Buffer::OwnedImpl buffer(data);
+  while (buffer.length() > 0) {
+    ASSERT_TRUE(client_handle_->write(buffer).ok());
+  }
+  std::string received;
+  while (received.size() < data.size()) {
+    const std::string read = serverRead();
+    ASSERT_FALSE(read.empty());
+    received.append(read);
+  }
+  EXPECT_EQ(data, received);
+
+  EXPECT_EQ(2, sendKernelTlsCloseNotify(*client_handle_).return_value_);
+  char buf[16];
+  for (int i = 0; i < 1000; i++) {
+    const int rc = SSL_read(server_ssl_.get(), buf, sizeof(buf));
+    if (SSL_get_error(server_ssl_.get(), rc) != SSL_ERROR_WANT_READ) {
+      EXPECT_EQ(SSL_ERROR_ZERO_RETURN, SSL_get_error(server_ssl_.get(), rc));
+      return;
+    }
+    usleep(1000);
+  }
+  FAIL() << "close_notify was not received";
+}
+
+// The alerts BoringSSL sends once offloaded would be framed as application data by the kernel, so
+// they are dropped.
+TEST_F(KernelTlsTest, AlertsAreNotSentOnceOffloaded) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  if (!enableKernelTlsTransmit(client_ssl_.get(), *client_handle_)) {
+    GTEST_SKIP() << "kernel TLS is not supported";
+  }
+
+  // An application data record which fails to decrypt, to which BoringSSL replies with a fatal
+  // bad_record_mac alert.
+  std::string record = {0x17, 0x03, 0x03, 0x00, 0x20};
+  record.append(32, 'x');
+  ASSERT_EQ(static_cast<ssize_t>(record.size()), write(server_fd_, record.data(), record.size()));
+  char buf[16];
+  int rc = -1;
+  for (int i = 0; i < 1000; i++) {
+    rc = SSL_read(client_ssl_.get(), buf, sizeof(buf));
+    if (SSL_get_error(client_ssl_.get(), rc) != SSL_ERROR_WANT_READ) {
+      break;
+    }
+    usleep(1000);
+  }
+  EXPECT_EQ(SSL_ERROR_SSL, SSL_get_error(client_ssl_.get(), rc));
+
+  usleep(10000);
+  EXPECT_EQ(-1, recv(server_fd_, buf, sizeof(buf), MSG_DONTWAIT));
+  EXPECT_EQ(EAGAIN, errno);
+}
+
+TEST_F(KernelTlsTest, Tls13IsNotOffloaded) {
+  handshake(TLS1_3_VERSION, "ECDHE-RSA-AES128-GCM-SHA256");
+  EXPECT_FALSE(enableKernelTlsTransmit(client_ssl_.get(), *client_handle_));
+
+  // The socket keeps working with BoringSSL.
+  ASSERT_EQ(5, SSL_write(client_ssl_.get(), "hello", 5));
+  EXPECT_EQ("hello", serverRead());
+}
+
+TEST_F(KernelTlsTest, NonAesGcmCipherIsNotOffloaded) {
+  handshake(TLS1_2_VERSION, "ECDHE-RSA-CHACHA20-POLY1305");
+  EXPECT_FALSE(enableKernelTlsTransmit(client_ssl_.get(), *client_handle_));
+
+  ASSERT_EQ(5, SSL_write(client_ssl_.get(), "hello", 5));
+  EXPECT_EQ("hello", serverRead());
+}
+
+} // namespace
+} // namespace Tls
+} // namespace TransportSockets
+} // namespace Extensions
+} // namespace Envoy
@@ -1,4 +1,10 @@
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
 #include "source/common/buffer/buffer_impl.h"
+#include "source/common/network/io_socket_handle_impl.h"
+#include "source/extensions/transport_sockets/tls/ktls.h"
 
 #include "test/test_common/environment.h"
 
@@ -64,17 +70,13 @@ static void addFullSlices(Buffer::Instance& output_buffer, unsigned num_slices,
   }
 }
 
-static void testThroughput(benchmark::State& state) {
+static bssl::UniquePtr<SSL_CTX> createServerContext() {
   std::string error;
   std::unique_ptr<bazel::tools::cpp::runfiles::Runfiles> runfiles(
       bazel::tools::cpp::runfiles::Runfiles::Create("tls_throughput_benchmark", &error));
   Envoy::TestEnvironment::setRunfiles(runfiles.get());
 
-  int sockets[2];
-  socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets);
-
   bssl::UniquePtr<SSL_CTX> server_ctx(SSL_CTX_new(TLS_method()));
-  bssl::UniquePtr<SSL_CTX> client_ctx(SSL_CTX_new(TLS_method()));
   std::string cert_path = TestEnvironment::substitute(
       "{{ test_rundir }}/test/extensions/transport_sockets/tls/test_data/san_dns_cert.pem");
   std::string key_path = TestEnvironment::substitute(
@@ -84,28 +86,41 @@ static void testThroughput(benchmark::State& state) {
   RELEASE_ASSERT(err > 0, "SSL_CTX_use_certificate_file");
   err = SSL_CTX_use_PrivateKey_file(server_ctx.get(), key_path.c_str(), SSL_FILETYPE_PEM);
   RELEASE_ASSERT(err > 0, "SSL_CTX_use_PrivateKey_file");
+  return server_ctx;
+}
 
-  bssl::UniquePtr<SSL> server_ssl(SSL_new(server_ctx.get()));
-  SSL_set_fd(server_ssl.get(), sockets[0]);
-  SSL_set_accept_state(server_ssl.get());
-
-  bssl::UniquePtr<SSL> client_ssl(SSL_new(client_ctx.get()));
-  SSL_set_fd(client_ssl.get(), sockets[1]);
-  SSL_set_connect_state(client_ssl.get());
-
+static void handshake(SSL* client_ssl, SSL* server_ssl) {
   bool handshake_success = false;
   for (int i = 0; i < 50; i++) {
-    int client_err = SSL_do_handshake(client_ssl.get());
-    int server_err = SSL_do_handshake(server_ssl.get());
+    int client_err = SSL_do_handshake(client_ssl);
+    int server_err = SSL_do_handshake(server_ssl);
     if (client_err == 1 && server_err == 1) {
       handshake_success = true;
       break;
     }
-    handleSslError(client_ssl.get(), client_err, false);
-    handleSslError(server_ssl.get(), server_err, true);
+    handleSslError(client_ssl, client_err, false);
+    handleSslError(server_ssl, server_err, true);
   }
 
   RELEASE_ASSERT(handshake_success, "handshake completed successfully");
+}
+
+static void testThroughput(benchmark::State& state) {
+  int sockets[2];
+  socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, sockets);
+
+  bssl::UniquePtr<SSL_CTX> server_ctx = createServerContext();
+  bssl::UniquePtr<SSL_CTX> client_ctx(SSL_CTX_new(TLS_method()));
+
+  bssl::UniquePtr<SSL> server_ssl(SSL_new(server_ctx.get()));
+  SSL_set_fd(server_ssl.get(), sockets[0]);
+  SSL_set_accept_state(server_ssl.get());
+
+  bssl::UniquePtr<SSL> client_ssl(SSL_new(client_ctx.get()));
+  SSL_set_fd(client_ssl.get(), sockets[1]);
+  SSL_set_connect_state(client_ssl.get());
+
+  handshake(client_ssl.get(), server_ssl.get());
 
   static uint8_t read_buf[1024 * 1024];
 
@@ -158,7 +173,7 @@ static void testThroughput(benchmark::State& state) {
         ++num_times_linearize_did_something;
       }
 
-      err = SSL_write(client_ssl.get(), mem, len);
+      int err = SSL_write(client_ssl.get(), mem, len);
       RELEASE_ASSERT(err == static_cast<int>(len),
                      absl::StrCat("SSL_write got: ", err, " expected: ", len));
       write_buf.drain(len);
@@ -192,5 +207,113 @@ static void testParams(benchmark::internal::Benchmark* b) {
 
 BENCHMARK(testThroughput)->Unit(::benchmark::kMicrosecond)->Apply(testParams);
 
+// Creates a connected pair of non-blocking loopback TCP sockets. Kernel TLS requires TCP.
+static void tcpSocketPair(int sockets[2]) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  RELEASE_ASSERT(listener >= 0, "socket");
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t addr_len = sizeof(addr);
+  RELEASE_ASSERT(bind(listener, reinterpret_cast<sockaddr*>(&addr), addr_len) == 0, "bind");
+  RELEASE_ASSERT(listen(listener, 1) == 0, "listen");
+  RELEASE_ASSERT(getsockname(listener, reinterpret_cast<sockaddr*>(&addr), &addr_len) == 0,
+                 "getsockname");
+  sockets[1] = socket(AF_INET, SOCK_STREAM, 0);
+  RELEASE_ASSERT(connect(sockets[1], reinterpret_cast<sockaddr*>(&addr), addr_len) == 0,
+                 "connect");
+  sockets[0] = accept(listener, nullptr, nullptr);
+  RELEASE_ASSERT(sockets[0] >= 0, "accept");
+  ::close(listener);
+
+  // Large socket buffers so that an iteration's writes don't have to wait for the reader.
+  const int buffer_size = 4 * 1024 * 1024;
+  for (int i = 0; i < 2; i++) {
+    setsockopt(sockets[i], SOL_SOCKET, SO_SNDBUF, &buffer_size, sizeof(buffer_size));
+    setsockopt(sockets[i], SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    fcntl(sockets[i], F_SETFL, fcntl(sockets[i], F_GETFL) | O_NONBLOCK);
+  }
+}
+
+// Compares encrypting in BoringSSL with kernel TLS offload for TLS 1.2 with AES-128-GCM over
+// loopback TCP. With offload the buffer is written in plaintext with writev, without
+// linearizing it into 16kb records first.
+static void testKernelTlsThroughput(benchmark::State& state) {
+  const bool kernel_tls = state.range(0);
+  const bool move_slices = state.range(1);
+
+  int sockets[2];
+  tcpSocketPair(sockets);
+
+  bssl::UniquePtr<SSL_CTX> server_ctx = createServerContext();
+  bssl::UniquePtr<SSL_CTX> client_ctx(SSL_CTX_new(TLS_method()));
+  SSL_CTX_set_max_proto_version(client_ctx.get(), TLS1_2_VERSION);
+  SSL_CTX_set_strict_cipher_list(client_ctx.get(), "ECDHE-RSA-AES128-GCM-SHA256");
+
+  bssl::UniquePtr<SSL> server_ssl(SSL_new(server_ctx.get()));
+  SSL_set_fd(server_ssl.get(), sockets[0]);
+  SSL_set_accept_state(server_ssl.get());
+
+  bssl::UniquePtr<SSL> client_ssl(SSL_new(client_ctx.get()));
+  SSL_set_fd(client_ssl.get(), sockets[1]);
+  SSL_set_connect_state(client_ssl.get());
+
+  handshake(client_ssl.get(), server_ssl.get());
+
+  // Owns sockets[1] from here on.
+  Network::IoSocketHandleImpl client_handle(sockets[1]);
+  if (kernel_tls && !enableKernelTlsTransmit(client_ssl.get(), client_handle)) {
+    ::close(sockets[0]);
+    state.SkipWithError("kernel TLS is not supported");
+    return;
+  }
+
+  static uint8_t read_buf[1024 * 1024];
+  uint64_t bytes_written = 0;
+  for (auto _ : state) {
+    UNREFERENCED_PARAMETER(_);
+    state.PauseTiming();
+
+    // Empty out the read side to make space for the writes.
+    while (SSL_read(server_ssl.get(), read_buf, sizeof(read_buf)) > 0) {
+    }
+
+    Buffer::OwnedImpl write_buf;
+    addFullSlices(write_buf, 10, move_slices);
+    bytes_written += write_buf.length();
+
+    state.ResumeTiming();
+    uint32_t num_writes = 0;
+    while (write_buf.length() > 0) {
+      if (kernel_tls) {
+        Api::IoCallUint64Result result = client_handle.write(write_buf);
+        RELEASE_ASSERT(result.ok(), "kernel TLS write failed");
+      } else {
+        const size_t len = std::min<uint64_t>(write_buf.length(), 16384);
+        int err = SSL_write(client_ssl.get(), write_buf.linearize(len), len);
+        RELEASE_ASSERT(err == static_cast<int>(len),
+                       absl::StrCat("SSL_write got: ", err, " expected: ", len));
+        write_buf.drain(len);
+      }
+      num_writes++;
+    }
+
+    state.counters["writes_per_iteration"] = num_writes;
+  }
+  state.counters["throughput"] = benchmark::Counter(bytes_written, benchmark::Counter::kIsRate);
+
+  ::close(sockets[0]);
+}
+
+static void kernelTlsParams(benchmark::internal::Benchmark* b) {
+  for (auto kernel_tls : {false, true}) {
+    for (auto move_slices : {false, true}) {
+      b->Args({kernel_tls, move_slices});
+    }
+  }
+}
+
+BENCHMARK(testKernelTlsThroughput)->Unit(::benchmark::kMicrosecond)->Apply(kernelTlsParams);
+
 } // namespace Extensions::TransportSockets::Tls
 } // namespace Envoy
@@ -43,6 +43,8 @@ public:
   MOCK_METHOD(void, reopen, ());
   MOCK_METHOD(AccessLogFileSharedPtr, createAccessLog,
               (const Envoy::Filesystem::FilePathAndType& file_info));
+  MOCK_METHOD(AccessLogFileSharedPtr, createAccessLog,
+              (const Envoy::Filesystem::FilePathAndType& file_info, uint64_t max_size_bytes));
 
   std::shared_ptr<MockAccessLogFile> file_{new testing::NiceMock<MockAccessLogFile>()};
 };
@@ -52,6 +52,7 @@ public:
   MOCK_METHOD(bool, fileExists, (const std::string&));
   MOCK_METHOD(bool, directoryExists, (const std::string&));
   MOCK_METHOD(ssize_t, fileSize, (const std::string&));
+  MOCK_METHOD(bool, moveFile, (const std::string&, const std::string&));
   MOCK_METHOD(std::string, fileReadToEnd, (const std::string&));
   MOCK_METHOD(PathSplitResult, splitPathFromFilename, (absl::string_view));
   MOCK_METHOD(bool, illegalPath, (const std::string&));
@@ -20,6 +20,7 @@ public:
   MOCK_METHOD(NiceMock<Http::MockStreamDecoderFilterCallbacks>&, getDecoderFilterCallbacks, (),
               (const));
   MOCK_METHOD(Http::Http1StreamEncoderOptionsOptRef, http1StreamEncoderOptions, ());
+  MOCK_METHOD(bool, canStreamResponse, (), (const));
 };
 } // namespace Server
 } // namespace Envoy
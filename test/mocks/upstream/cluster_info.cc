@@ -77,6 +77,8 @@ MockClusterInfo::MockClusterInfo()
       .WillByDefault(ReturnPointee(&max_response_headers_count_));
   ON_CALL(*this, maxRequestsPerConnection())
       .WillByDefault(ReturnPointee(&max_requests_per_connection_));
+  ON_CALL(*this, sharedConnPoolOwnerWorkers())
+      .WillByDefault(ReturnPointee(&shared_conn_pool_owner_workers_));
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, statsScope()).WillByDefault(ReturnRef(stats_store_));
   // TODO(incfly): The following is a hack because it's not possible to directly embed
@@ -100,6 +102,8 @@ MockClusterInfo::MockClusterInfo()
   ON_CALL(*this, sourceAddress()).WillByDefault(ReturnRef(source_address_));
   ON_CALL(*this, lbSubsetInfo()).WillByDefault(ReturnRef(lb_subset_));
   ON_CALL(*this, lbRoundRobinConfig()).WillByDefault(ReturnRef(lb_round_robin_config_));
+  ON_CALL(*this, lbLeastRequestConfig()).WillByDefault(ReturnRef(lb_least_request_config_));
+  ON_CALL(*this, lbPeakEwmaConfig()).WillByDefault(ReturnRef(lb_peak_ewma_config_));
   ON_CALL(*this, lbRingHashConfig()).WillByDefault(ReturnRef(lb_ring_hash_config_));
   ON_CALL(*this, lbMaglevConfig()).WillByDefault(ReturnRef(lb_maglev_config_));
   ON_CALL(*this, lbOriginalDstConfig()).WillByDefault(ReturnRef(lb_original_dst_config_));
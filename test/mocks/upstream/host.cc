@@ -27,6 +27,21 @@ MockDetector::~MockDetector() = default;
 
 } // namespace Outlier
 
+MockLatencyEstimator::MockLatencyEstimator() = default;
+MockLatencyEstimator::~MockLatencyEstimator() = default;
+
+MockActiveRequestCounter::MockActiveRequestCounter(Stats::PrimitiveGauge& rq_active) {
+  ON_CALL(*this, inc()).WillByDefault(Invoke([&rq_active]() -> void { rq_active.inc(); }));
+  ON_CALL(*this, dec()).WillByDefault(Invoke([&rq_active]() -> void { rq_active.dec(); }));
+  ON_CALL(*this, estimate()).WillByDefault(Invoke([&rq_active]() -> uint64_t {
+    return rq_active.value();
+  }));
+  ON_CALL(*this, total()).WillByDefault(Invoke([&rq_active]() -> uint64_t {
+    return rq_active.value();
+  }));
+}
+MockActiveRequestCounter::~MockActiveRequestCounter() = default;
+
 MockHealthCheckHostMonitor::MockHealthCheckHostMonitor() = default;
 MockHealthCheckHostMonitor::~MockHealthCheckHostMonitor() = default;
 
@@ -36,6 +51,8 @@ MockHostDescription::MockHostDescription()
   ON_CALL(*this, hostname()).WillByDefault(ReturnRef(hostname_));
   ON_CALL(*this, address()).WillByDefault(Return(address_));
   ON_CALL(*this, outlierDetector()).WillByDefault(ReturnRef(outlier_detector_));
+  ON_CALL(*this, latencyEstimator()).WillByDefault(ReturnRef(latency_estimator_));
+  ON_CALL(*this, activeRequests()).WillByDefault(ReturnRef(active_requests_));
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, locality()).WillByDefault(ReturnRef(locality_));
   ON_CALL(*this, cluster()).WillByDefault(ReturnRef(cluster_));
@@ -48,6 +65,8 @@ MockHostDescription::~MockHostDescription() = default;
 MockHost::MockHost() : socket_factory_(new testing::NiceMock<Network::MockTransportSocketFactory>) {
   ON_CALL(*this, cluster()).WillByDefault(ReturnRef(cluster_));
   ON_CALL(*this, outlierDetector()).WillByDefault(ReturnRef(outlier_detector_));
+  ON_CALL(*this, latencyEstimator()).WillByDefault(ReturnRef(latency_estimator_));
+  ON_CALL(*this, activeRequests()).WillByDefault(ReturnRef(active_requests_));
   ON_CALL(*this, stats()).WillByDefault(ReturnRef(stats_));
   ON_CALL(*this, warmed()).WillByDefault(Return(true));
   ON_CALL(*this, transportSocketFactory()).WillByDefault(ReturnRef(*socket_factory_));
@@ -77,6 +77,27 @@ public:
   MOCK_METHOD(void, setUnhealthy, (UnhealthyType));
 };
 
+class MockLatencyEstimator : public LatencyEstimator {
+public:
+  MockLatencyEstimator();
+  ~MockLatencyEstimator() override;
+
+  MOCK_METHOD(void, putRoundTripTime, (std::chrono::microseconds rtt));
+  MOCK_METHOD(absl::optional<double>, roundTripTimeEstimate, (), (const));
+};
+
+class MockActiveRequestCounter : public ActiveRequestCounter {
+public:
+  // By default, updates and reads the given gauge like the counter of a real host.
+  MockActiveRequestCounter(Stats::PrimitiveGauge& rq_active);
+  ~MockActiveRequestCounter() override;
+
+  MOCK_METHOD(void, inc, ());
+  MOCK_METHOD(void, dec, ());
+  MOCK_METHOD(uint64_t, estimate, ());
+  MOCK_METHOD(uint64_t, total, ());
+};
+
 class MockHostDescription : public HostDescription {
 public:
   MockHostDescription();
@@ -92,6 +113,8 @@ public:
   MOCK_METHOD(void, metadata, (MetadataConstSharedPtr));
   MOCK_METHOD(const ClusterInfo&, cluster, (), (const));
   MOCK_METHOD(Outlier::DetectorHostMonitor&, outlierDetector, (), (const));
+  MOCK_METHOD(LatencyEstimator&, latencyEstimator, (), (const));
+  MOCK_METHOD(ActiveRequestCounter&, activeRequests, (), (const));
   MOCK_METHOD(HealthCheckHostMonitor&, healthChecker, (), (const));
   MOCK_METHOD(const std::string&, hostnameForHealthChecks, (), (const));
   MOCK_METHOD(const std::string&, hostname, (), (const));
@@ -111,10 +134,12 @@ public:
   std::string hostname_;
   Network::Address::InstanceConstSharedPtr address_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
+  testing::NiceMock<MockLatencyEstimator> latency_estimator_;
   testing::NiceMock<MockHealthCheckHostMonitor> health_checker_;
   Network::TransportSocketFactoryPtr socket_factory_;
   testing::NiceMock<MockClusterInfo> cluster_;
   HostStats stats_;
+  testing::NiceMock<MockActiveRequestCounter> active_requests_{stats_.rq_active_};
   envoy::config::core::v3::Locality locality_;
   mutable Stats::TestUtil::TestSymbolTable symbol_table_;
   mutable std::unique_ptr<Stats::StatNameManagedStorage> locality_zone_stat_name_;
@@ -186,6 +211,8 @@ public:
   MOCK_METHOD(const std::string&, hostname, (), (const));
   MOCK_METHOD(Network::TransportSocketFactory&, transportSocketFactory, (), (const));
   MOCK_METHOD(Outlier::DetectorHostMonitor&, outlierDetector, (), (const));
+  MOCK_METHOD(LatencyEstimator&, latencyEstimator, (), (const));
+  MOCK_METHOD(ActiveRequestCounter&, activeRequests, (), (const));
   MOCK_METHOD(void, setHealthChecker_, (HealthCheckHostMonitorPtr & health_checker));
   MOCK_METHOD(void, setOutlierDetector_, (Outlier::DetectorHostMonitorPtr & outlier_detector));
   MOCK_METHOD(HostStats&, stats, (), (const));
@@ -202,7 +229,9 @@ public:
   testing::NiceMock<MockClusterInfo> cluster_;
   Network::TransportSocketFactoryPtr socket_factory_;
   testing::NiceMock<Outlier::MockDetectorHostMonitor> outlier_detector_;
+  testing::NiceMock<MockLatencyEstimator> latency_estimator_;
   HostStats stats_;
+  testing::NiceMock<MockActiveRequestCounter> active_requests_{stats_.rq_active_};
   mutable Stats::TestUtil::TestSymbolTable symbol_table_;
   mutable std::unique_ptr<Stats::StatNameManagedStorage> locality_zone_stat_name_;
 };
@@ -0,0 +1,113 @@
+// Note: this should be run with --compilation_mode=opt, and would benefit from a
+// quiescent system with disabled cstate power management.
+
+#include <algorithm>
+#include <limits>
+
+#include "source/common/stats/allocator_impl.h"
+#include "source/common/stats/custom_stat_namespaces_impl.h"
+#include "source/common/stats/symbol_table_impl.h"
+#include "source/server/admin/prometheus_stats.h"
+
+#include "test/benchmark/main.h"
+
+#include "absl/strings/str_cat.h"
+#include "benchmark/benchmark.h"
+
+namespace Envoy {
+namespace Server {
+
+// Mimics the stats of a large number of clusters: every tag-extracted name has one counter per
+// cluster, tagged with the cluster name.
+class PrometheusScrapeSpeedTest {
+public:
+  PrometheusScrapeSpeedTest(uint64_t num_stats) : alloc_(symbol_table_), pool_(symbol_table_) {
+    const Stats::StatName cluster_tag = pool_.add("envoy.cluster_name");
+    const uint64_t num_clusters = std::max<uint64_t>(1, num_stats / NumNames);
+    for (uint64_t name = 0; name < NumNames; ++name) {
+      const Stats::StatName tag_extracted_name = pool_.add(absl::StrCat("cluster.stat_", name));
+      for (uint64_t cluster = 0; cluster < num_clusters; ++cluster) {
+        const std::string cluster_name = absl::StrCat("cluster_", cluster);
+        const Stats::StatNameTagVector tags{{cluster_tag, pool_.add(cluster_name)}};
+        const Stats::StatName stat_name =
+            pool_.add(absl::StrCat("cluster.", cluster_name, ".stat_", name));
+        counters_.push_back(alloc_.makeCounter(stat_name, tag_extracted_name, tags));
+        counters_.back()->add(cluster);
+      }
+    }
+  }
+
+  // Renders a scrape in chunks of chunk_size_bytes, dropping every chunk once it is rendered as
+  // the admin stream would once it is written out.
+  void scrape(::benchmark::State& state, uint64_t chunk_size_bytes, bool cache_tags) {
+    uint64_t peak_bytes = 0;
+    uint64_t output_bytes = 0;
+    for (auto _ : state) {
+      UNREFERENCED_PARAMETER(_);
+      PrometheusStatsRenderer renderer(std::vector<Stats::CounterSharedPtr>(counters_), {}, {},
+                                       false, absl::nullopt, custom_namespaces_,
+                                       cache_tags ? &tags_cache_ : nullptr);
+      output_bytes = 0;
+      bool more = true;
+      while (more) {
+        Buffer::OwnedImpl chunk;
+        more = renderer.nextChunk(chunk, chunk_size_bytes);
+        peak_bytes = std::max<uint64_t>(peak_bytes, chunk.length());
+        output_bytes += chunk.length();
+      }
+    }
+    state.counters["peak_bytes"] = peak_bytes;
+    state.counters["output_bytes"] = output_bytes;
+  }
+
+private:
+  static constexpr uint64_t NumNames = 100;
+
+  Stats::SymbolTableImpl symbol_table_;
+  Stats::AllocatorImpl alloc_;
+  Stats::StatNamePool pool_;
+  Stats::CustomStatNamespacesImpl custom_namespaces_;
+  std::vector<Stats::CounterSharedPtr> counters_;
+  PrometheusTagsCache tags_cache_{symbol_table_};
+};
+
+static bool skipExpensive(::benchmark::State& state) {
+  // Skip expensive benchmarks for unit tests.
+  if (benchmark::skipExpensiveBenchmarks() && state.range(0) > 100) {
+    state.SkipWithError("Skipping expensive benchmark");
+    return true;
+  }
+  return false;
+}
+
+// The whole scrape rendered into one buffer.
+static void bmPrometheusScrapeSingleBuffer(::benchmark::State& state) {
+  if (skipExpensive(state)) {
+    return;
+  }
+  PrometheusScrapeSpeedTest speed_test(state.range(0));
+  speed_test.scrape(state, std::numeric_limits<uint64_t>::max(), false);
+}
+BENCHMARK(bmPrometheusScrapeSingleBuffer)
+    ->Unit(::benchmark::kMillisecond)
+    ->Arg(100)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+// The scrape streamed in the chunks of the admin handler, reusing the formatted tags of the
+// previous scrape.
+static void bmPrometheusScrapeStreamed(::benchmark::State& state) {
+  if (skipExpensive(state)) {
+    return;
+  }
+  PrometheusScrapeSpeedTest speed_test(state.range(0));
+  speed_test.scrape(state, 64 * 1024, true);
+}
+BENCHMARK(bmPrometheusScrapeStreamed)
+    ->Unit(::benchmark::kMillisecond)
+    ->Arg(100)
+    ->Arg(100000)
+    ->Arg(1000000);
+
+} // namespace Server
+} // namespace Envoy
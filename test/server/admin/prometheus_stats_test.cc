@@ -1,3 +1,4 @@
+#include <limits>
 #include <regex>
 
 #include "source/common/stats/custom_stat_namespaces_impl.h"
@@ -773,5 +774,111 @@ envoy_cluster_test_1_upstream_cx_total{a_tag_name="a.tag-value"} 0
   EXPECT_EQ(expected_output, response.toString());
 }
 
+TEST_F(PrometheusStatsFormatterTest, ChunkedOutput) {
+  Stats::CustomStatNamespacesImpl custom_namespaces;
+  for (const char* cluster : {"ccc", "aaa", "bbb"}) {
+    const Stats::StatNameTagVector tags{{makeStat("cluster"), makeStat(cluster)}};
+    addCounter("cluster.upstream_cx_total", tags);
+    addCounter("cluster.upstream_cx_connect_fail", tags);
+    addGauge("cluster.upstream_cx_active", tags);
+  }
+
+  Buffer::OwnedImpl expected_response;
+  const uint64_t size = PrometheusStatsFormatter::statsAsPrometheus(
+      counters_, gauges_, histograms_, expected_response, false, absl::nullopt, custom_namespaces);
+  EXPECT_EQ(3UL, size);
+
+  // Every chunk ends after the first metric which reaches the chunk size.
+  PrometheusStatsRenderer renderer(std::vector<Stats::CounterSharedPtr>(counters_),
+                                   std::vector<Stats::GaugeSharedPtr>(gauges_),
+                                   std::vector<Stats::ParentHistogramSharedPtr>(histograms_),
+                                   false, absl::nullopt, custom_namespaces, nullptr);
+  std::string response;
+  uint32_t chunks = 0;
+  bool more = true;
+  while (more) {
+    Buffer::OwnedImpl chunk;
+    more = renderer.nextChunk(chunk, 1);
+    EXPECT_NE(0, chunk.length());
+    response += chunk.toString();
+    ++chunks;
+  }
+  EXPECT_EQ(10, chunks);
+  EXPECT_EQ(expected_response.toString(), response);
+  EXPECT_EQ(size, renderer.metricNameCount());
+}
+
+TEST_F(PrometheusStatsFormatterTest, TagsCache) {
+  Stats::CustomStatNamespacesImpl custom_namespaces;
+  addCounter("cluster.upstream_cx_total", {{makeStat("cluster"), makeStat("aaa")}});
+  addCounter("cluster.upstream_cx_total", {{makeStat("cluster"), makeStat("bbb")}});
+  addGauge("cluster.upstream_cx_active", {{makeStat("cluster"), makeStat("aaa")}});
+
+  PrometheusTagsCache tags_cache(*symbol_table_);
+  auto render = [&]() {
+    PrometheusStatsRenderer renderer(std::vector<Stats::CounterSharedPtr>(counters_),
+                                     std::vector<Stats::GaugeSharedPtr>(gauges_),
+                                     std::vector<Stats::ParentHistogramSharedPtr>(histograms_),
+                                     false, absl::nullopt, custom_namespaces, &tags_cache);
+    Buffer::OwnedImpl response;
+    EXPECT_FALSE(renderer.nextChunk(response, std::numeric_limits<uint64_t>::max()));
+    return response.toString();
+  };
+
+  const std::string expected_output = R"EOF(# TYPE envoy_cluster_upstream_cx_total counter
+envoy_cluster_upstream_cx_total{cluster="aaa"} 0
+envoy_cluster_upstream_cx_total{cluster="bbb"} 0
+
+# TYPE envoy_cluster_upstream_cx_active gauge
+envoy_cluster_upstream_cx_active{cluster="aaa"} 0
+
+)EOF";
+  EXPECT_EQ(expected_output, render());
+  EXPECT_EQ(3, tags_cache.size());
+  EXPECT_EQ(expected_output, render());
+  EXPECT_EQ(3, tags_cache.size());
+
+  // The entry of a deleted stat is dropped at the end of the next scrape.
+  counters_.pop_back();
+  render();
+  EXPECT_EQ(2, tags_cache.size());
+}
+
+TEST_F(PrometheusStatsFormatterTest, TagsCacheFilteredAndConcurrentScrapes) {
+  Stats::CustomStatNamespacesImpl custom_namespaces;
+  addCounter("cluster.upstream_cx_total", {{makeStat("cluster"), makeStat("aaa")}});
+  addCounter("cluster.upstream_cx_total", {{makeStat("cluster"), makeStat("bbb")}});
+  addGauge("cluster.upstream_cx_active", {{makeStat("cluster"), makeStat("aaa")}});
+
+  PrometheusTagsCache tags_cache(*symbol_table_);
+  auto make_renderer = [&](const absl::optional<std::regex>& regex) {
+    return std::make_unique<PrometheusStatsRenderer>(
+        std::vector<Stats::CounterSharedPtr>(counters_),
+        std::vector<Stats::GaugeSharedPtr>(gauges_),
+        std::vector<Stats::ParentHistogramSharedPtr>(histograms_), false, regex, custom_namespaces,
+        &tags_cache);
+  };
+  auto render = [](PrometheusStatsRenderer& renderer, uint64_t chunk_size_bytes) {
+    Buffer::OwnedImpl response;
+    return renderer.nextChunk(response, chunk_size_bytes);
+  };
+
+  EXPECT_FALSE(render(*make_renderer(absl::nullopt), std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(3, tags_cache.size());
+
+  // A filtered scrape doesn't evict the entries of the stats it filtered out.
+  EXPECT_FALSE(render(*make_renderer(std::regex("upstream_cx_active")),
+                      std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(3, tags_cache.size());
+
+  // A scrape completing while another one is in progress doesn't evict the entries the other one
+  // used before.
+  auto first = make_renderer(absl::nullopt);
+  EXPECT_TRUE(render(*first, 1));
+  EXPECT_FALSE(render(*make_renderer(absl::nullopt), std::numeric_limits<uint64_t>::max()));
+  EXPECT_FALSE(render(*first, std::numeric_limits<uint64_t>::max()));
+  EXPECT_EQ(3, tags_cache.size());
+}
+
 } // namespace Server
 } // namespace Envoy
@@ -9,9 +9,11 @@
 #include "test/test_common/logging.h"
 #include "test/test_common/utility.h"
 
+using testing::_;
 using testing::EndsWith;
 using testing::HasSubstr;
 using testing::InSequence;
+using testing::Invoke;
 using testing::Ref;
 using testing::StartsWith;
 
@@ -729,6 +731,46 @@ TEST_P(AdminInstanceTest, PrometheusStatsInvalidRegex) {
   EXPECT_THAT(data.toString(), EndsWith("\"\n"));
 }
 
+TEST_P(AdminInstanceTest, PrometheusStatsStreamed) {
+  for (uint32_t i = 0; i < 2000; ++i) {
+    server_.stats().counterFromString(absl::StrCat("ptest.counter_", i));
+  }
+
+  // Requests made through Admin::request() are answered in one response.
+  Http::TestResponseHeaderMapImpl request_headers;
+  std::string expected_body;
+  EXPECT_EQ(Http::Code::OK,
+            admin_.request("/stats?format=prometheus", "GET", request_headers, expected_body));
+  EXPECT_THAT(expected_body, HasSubstr("envoy_ptest_counter_1999{} 0\n"));
+
+  std::string body;
+  bool end_stream = false;
+  uint32_t chunks = 0;
+  EXPECT_CALL(callbacks_, encodeData(_, _))
+      .WillRepeatedly(Invoke([&](Buffer::Instance& data, bool end) {
+        body += data.toString();
+        end_stream = end;
+        // Pause the stream after the first chunk.
+        if (++chunks == 1) {
+          ASSERT_EQ(1, callbacks_.callbacks_.size());
+          callbacks_.callbacks_.front()->onAboveWriteBufferHighWatermark();
+        }
+      }));
+
+  Http::TestResponseHeaderMapImpl header_map;
+  Buffer::OwnedImpl data;
+  EXPECT_EQ(Http::Code::OK, getCallback("/stats?format=prometheus", header_map, data));
+  EXPECT_LT(data.length(), expected_body.size());
+  EXPECT_EQ(1, chunks);
+  EXPECT_FALSE(end_stream);
+
+  callbacks_.callbacks_.front()->onBelowWriteBufferLowWatermark();
+  EXPECT_GT(chunks, 1);
+  EXPECT_TRUE(end_stream);
+  EXPECT_TRUE(callbacks_.callbacks_.empty());
+  EXPECT_EQ(expected_body, data.toString() + body);
+}
+
 TEST_P(AdminInstanceTest, TracingStatsDisabled) {
   const std::string& name = admin_.tracingStats().service_forced_.name();
   for (const Stats::CounterSharedPtr& counter : server_.stats().counters()) {
@@ -6,6 +6,8 @@
 #include "envoy/server/bootstrap_extension_config.h"
 #include "envoy/server/fatal_action_config.h"
 
+#include "source/common/buffer/buffer_impl.h"
+#include "source/common/buffer/slice_allocator.h"
 #include "source/common/common/assert.h"
 #include "source/common/network/address_impl.h"
 #include "source/common/network/listen_socket_impl.h"
@@ -752,6 +754,33 @@ INSTANTIATE_TEST_SUITE_P(
     testing::Combine(testing::ValuesIn(TestEnvironment::getIpVersionsForTest()), testing::Bool()),
     ipFlushingModeTestParamsToString);
 
+// The buffer slices of the default size are allocated from the slabs once the server is
+// initialized.
+TEST_P(ServerStatsTest, BufferSliceAllocator) {
+#if !defined(WIN32)
+  initialize("test/server/test_data/server/bootstrap_buffer_slice_allocator.yaml");
+  {
+    Buffer::OwnedImpl buffer(std::string(Buffer::Slice::default_slice_size_, 'a'));
+    EXPECT_LE(Buffer::Slice::default_slice_size_, Buffer::SliceAllocator::stats().bytes_in_use_);
+    flushStats();
+    EXPECT_LE(Buffer::Slice::default_slice_size_,
+              TestUtility::findGauge(stats_store_, "server.memory_buffer_slab_allocated")->value());
+    EXPECT_LE(Buffer::SliceAllocator::SlabSize,
+              TestUtility::findGauge(stats_store_, "server.memory_buffer_slab_committed")->value());
+  }
+  // The slabs released are counted once, however many times the stats are flushed.
+  Buffer::SliceAllocator::releaseFreeMemory();
+  flushStats();
+  const uint64_t released =
+      TestUtility::findCounter(stats_store_, "server.memory_buffer_slab_released")->value();
+  EXPECT_LE(1, released);
+  flushStats();
+  EXPECT_EQ(released,
+            TestUtility::findCounter(stats_store_, "server.memory_buffer_slab_released")->value());
+  Buffer::SliceAllocator::disable();
+#endif
+}
+
 TEST_P(ServerStatsTest, FlushStats) {
   initialize("test/server/test_data/server/empty_bootstrap.yaml");
   Stats::Gauge& recent_lookups = stats_store_.gaugeFromString(
@@ -92,6 +92,21 @@ public:
     return file_system_->fileSize(path);
   }
 
+  bool moveFile(const std::string& from_path, const std::string& to_path) override {
+    {
+      absl::MutexLock m(&lock_);
+      auto it = files_.find(from_path);
+      if (it != files_.end()) {
+        ASSERT(use_memfiles_);
+        std::shared_ptr<MemFileInfo> info = std::move(it->second);
+        files_.erase(it);
+        files_[to_path] = std::move(info);
+        return true;
+      }
+    }
+    return file_system_->moveFile(from_path, to_path);
+  }
+
   std::string fileReadToEnd(const std::string& path) override {
     {
       absl::MutexLock m(&lock_);